@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2012 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __CONTENT_PROTECT_BATCH_H__
+#define __CONTENT_PROTECT_BATCH_H__
+
+#include "content_protect.h"
+
+#define CP_PROTECT_MASK(ip)	(1U << (ip))
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Set the protection of every IP in owned_mask at once; unchanged IPs and
+ * IPs outside owned_mask are not touched
+ */
+cpResult_t CP_Set_Path_Protection_Mask(uint32_t protect_mask, uint32_t owned_mask);
+
+/*
+ * Unprotect every IP in owned_mask unconditionally, e.g. at init when a
+ * previous instance of the caller may have left IPs protected
+ */
+cpResult_t CP_Reset_Path_Protection(uint32_t owned_mask);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
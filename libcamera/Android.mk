@@ -58,6 +58,7 @@ LOCAL_C_INCLUDES += \
 
 LOCAL_SRC_FILES:= \
 	ExynosCameraSensorInfo.cpp \
+	ExynosCameraSizeSolver.cpp \
 	../../exynos/libcamera/common/ExynosCameraFrame.cpp \
 	../../exynos/libcamera/common/ExynosCameraMemory.cpp \
 	../../exynos/libcamera/common/ExynosCameraUtils.cpp \
@@ -137,4 +138,6 @@ LOCAL_MODULE_TAGS := optional
 
 include $(BUILD_SHARED_LIBRARY)
 
+include $(LOCAL_PATH)/tests/Android.mk
+
 endif
@@ -84,6 +84,7 @@
 #endif
 
 /* #define USE_DVFS_LOCK */
+/* Off until SENSOR_NAME_PATH_* below are filled in for a board */
 /* #define SENSOR_NAME_GET_FROM_FILE */
 /* #define RESERVED_MEMORY_ENABLE */
 #define RESERVED_BUFFER_COUNT_MAX       (5)
@@ -136,6 +137,10 @@ enum REPROCESSING_BAYER_MODE {
 #ifdef SENSOR_NAME_GET_FROM_FILE
 #define SENSOR_NAME_PATH_BACK "vendor specifics"
 #define SSENSOR_NAME_PATH_BACK "vendor specifics"
+/* Sensor IDs resolved by a previous cameraserver instance */
+#ifndef SENSOR_ID_CACHE_PATH
+#define SENSOR_ID_CACHE_PATH "/data/misc/camera/sensor_id_cache"
+#endif
 #endif
 
 #define EXYNOS_CAMERA_NAME_STR_SIZE (256)
@@ -18,6 +18,20 @@
 /*#define LOG_NDEBUG 0 */
 #define LOG_TAG "ExynosCameraUtils"
 #include <cutils/log.h>
+#include <utils/Mutex.h>
+#include <utils/Timers.h>
+
+#ifdef SENSOR_NAME_GET_FROM_FILE
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/utsname.h>
+#include <cutils/properties.h>
+#include <utils/Errors.h>
+#endif
 
 #include "ExynosCameraSensorInfo.h"
 
@@ -28,57 +42,427 @@ int g_rearSensorId = -1;
 int g_frontSensorId = -1;
 #endif
 
-struct ExynosSensorInfo *createSensorInfo(int camId)
+#define SENSOR_EFFECT_LIST_BASIC \
+    (EFFECT_NONE | EFFECT_MONO | EFFECT_NEGATIVE | EFFECT_SEPIA | EFFECT_POSTERIZE | EFFECT_AQUA)
+#define SENSOR_FLASH_MODE_LIST_BASIC \
+    (FLASH_MODE_OFF | FLASH_MODE_AUTO | FLASH_MODE_ON | FLASH_MODE_TORCH)
+#define SENSOR_FOCUS_MODE_LIST_AF \
+    (FOCUS_MODE_AUTO | FOCUS_MODE_MACRO | FOCUS_MODE_CONTINUOUS_VIDEO \
+     | FOCUS_MODE_CONTINUOUS_PICTURE | FOCUS_MODE_TOUCH)
+#define SENSOR_WHITE_BALANCE_LIST_BASIC \
+    (WHITE_BALANCE_AUTO | WHITE_BALANCE_INCANDESCENT | WHITE_BALANCE_FLUORESCENT \
+     | WHITE_BALANCE_DAYLIGHT | WHITE_BALANCE_CLOUDY_DAYLIGHT)
+
+#define SENSOR_SIZE_LUT(lut)    lut, (int)(sizeof(lut) / (sizeof(int) * SIZE_OF_LUT))
+
+/*
+ * Size LUTs, interned: sensor rows refer to a set by index, so sensors
+ * sharing the same tables share one entry.
+ */
+enum SENSOR_SIZE_LUT_SET {
+    SENSOR_SIZE_LUT_NONE = 0,
+    SENSOR_SIZE_LUT_3L2,
+    SENSOR_SIZE_LUT_2P2_BNS,
+    SENSOR_SIZE_LUT_3H7,
+    SENSOR_SIZE_LUT_4H5,
+    SENSOR_SIZE_LUT_IMX175,
+    SENSOR_SIZE_LUT_MAX,
+};
+
+struct sensor_size_lut_set {
+    int     (*previewSizeLut)[SIZE_OF_LUT];
+    int     previewSizeLutMax;
+    int     (*pictureSizeLut)[SIZE_OF_LUT];
+    int     pictureSizeLutMax;
+    int     (*videoSizeLut)[SIZE_OF_LUT];
+    int     videoSizeLutMax;
+    int     (*videoSizeLutHighSpeed)[SIZE_OF_LUT];
+    int     videoSizeLutHighSpeedMax;
+};
+
+static const struct sensor_size_lut_set SENSOR_SIZE_LUT_SETS[SENSOR_SIZE_LUT_MAX] =
+{
+    /* SENSOR_SIZE_LUT_NONE */
+    { NULL, 0, NULL, 0, NULL, 0, NULL, 0 },
+    /* SENSOR_SIZE_LUT_3L2 */
+    {
+        SENSOR_SIZE_LUT(PREVIEW_SIZE_LUT_3L2),
+        SENSOR_SIZE_LUT(PICTURE_SIZE_LUT_3L2),
+        SENSOR_SIZE_LUT(VIDEO_SIZE_LUT_3L2),
+        SENSOR_SIZE_LUT(VIDEO_SIZE_LUT_HIGH_SPEED_3L2) },
+    /* SENSOR_SIZE_LUT_2P2_BNS */
+    {
+        SENSOR_SIZE_LUT(PREVIEW_SIZE_LUT_2P2_BNS),
+        SENSOR_SIZE_LUT(PICTURE_SIZE_LUT_2P2),
+        SENSOR_SIZE_LUT(VIDEO_SIZE_LUT_2P2_BNS),
+        SENSOR_SIZE_LUT(VIDEO_SIZE_LUT_HIGH_SPEED_2P2_BNS) },
+    /* SENSOR_SIZE_LUT_3H7 */
+    {
+        SENSOR_SIZE_LUT(PREVIEW_SIZE_LUT_3H7),
+        SENSOR_SIZE_LUT(PICTURE_SIZE_LUT_3H7),
+        SENSOR_SIZE_LUT(VIDEO_SIZE_LUT_3H7),
+        SENSOR_SIZE_LUT(VIDEO_SIZE_LUT_HIGH_SPEED_3H7) },
+    /* SENSOR_SIZE_LUT_4H5 */
+    {
+        SENSOR_SIZE_LUT(PREVIEW_SIZE_LUT_4H5),
+        SENSOR_SIZE_LUT(PICTURE_SIZE_LUT_4H5),
+        SENSOR_SIZE_LUT(VIDEO_SIZE_LUT_4H5),
+        SENSOR_SIZE_LUT(VIDEO_SIZE_LUT_HIGH_SPEED_4H5) },
+    /* SENSOR_SIZE_LUT_IMX175 */
+    {
+        SENSOR_SIZE_LUT(PREVIEW_SIZE_LUT_IMX175),
+        SENSOR_SIZE_LUT(PICTURE_SIZE_LUT_IMX175),
+        SENSOR_SIZE_LUT(VIDEO_SIZE_LUT_IMX175),
+        SENSOR_SIZE_LUT(VIDEO_SIZE_LUT_HIGH_SPEED_IMX175) },
+};
+
+enum {
+    SENSOR_CAP_VIDEO_STABILIZATION = (1 << 0),
+    SENSOR_CAP_AWB_LOCK            = (1 << 1),
+    SENSOR_CAP_BNS                 = (1 << 2),
+};
+
+/*
+ * Per-sensor differences from the ExynosSensorInfo defaults.
+ * Adding a sensor is adding a row here.
+ */
+struct sensor_info_desc {
+    int         sensorName;
+    uint16_t    maxPreviewW, maxPreviewH;
+    uint16_t    maxPictureW, maxPictureH;
+    uint16_t    maxVideoW, maxVideoH;
+    uint16_t    maxSensorW, maxSensorH;
+    uint16_t    fNumberNum, focalLengthNum, apertureNum;
+    uint8_t     maxNumFocusAreas;
+    uint8_t     maxNumMeteringAreas;
+    uint8_t     caps;
+    uint8_t     sizeLutSet;
+    int         effectList;
+    int         flashModeList;
+    int         focusModeList;
+    int         whiteBalanceList;
+    uint16_t    highSpeedRecording60W, highSpeedRecording60H;
+    uint16_t    highSpeedRecording120W, highSpeedRecording120H;
+};
+
+static const struct sensor_info_desc SENSOR_INFO_TABLE[] =
+{
+    /* name, preview, picture, video, sensor, fnum/focal/aperture, areas, caps, LUT,
+       effect, flash, focus, white balance, 60fps and 120fps recording */
+    { SENSOR_NAME_IMX135,
+      1920, 1080, 4128, 3096, 1920, 1080, 4128, 3096, 22, 420, 227, 2, 32,
+      SENSOR_CAP_VIDEO_STABILIZATION | SENSOR_CAP_AWB_LOCK, SENSOR_SIZE_LUT_NONE,
+      SENSOR_EFFECT_LIST_BASIC, SENSOR_FLASH_MODE_LIST_BASIC,
+      SENSOR_FOCUS_MODE_LIST_AF, SENSOR_WHITE_BALANCE_LIST_BASIC,
+      1008, 566, 1008, 566 },
+    { SENSOR_NAME_IMX134,
+      1920, 1080, 3264, 2448, 1920, 1080, 3264, 2448, 22, 420, 227, 2, 32,
+      0, SENSOR_SIZE_LUT_NONE,
+      SENSOR_EFFECT_LIST_BASIC, SENSOR_FLASH_MODE_LIST_BASIC,
+      SENSOR_FOCUS_MODE_LIST_AF, SENSOR_WHITE_BALANCE_LIST_BASIC,
+      1008, 566, 1008, 566 },
+    { SENSOR_NAME_S5K3L2,
+      1920, 1080, 4128, 3096, 1920, 1080, 4128, 3096, 22, 420, 227, 2, 32,
+      SENSOR_CAP_VIDEO_STABILIZATION | SENSOR_CAP_AWB_LOCK, SENSOR_SIZE_LUT_3L2,
+      SENSOR_EFFECT_LIST_BASIC, SENSOR_FLASH_MODE_LIST_BASIC,
+      SENSOR_FOCUS_MODE_LIST_AF, SENSOR_WHITE_BALANCE_LIST_BASIC,
+      2056, 1152, 1024, 574 },
+    { SENSOR_NAME_S5K2P2,
+      3840, 2160, 5312, 2988, 3840, 2160, 5312, 2990, 22, 420, 227, 2, 32,
+      SENSOR_CAP_VIDEO_STABILIZATION | SENSOR_CAP_AWB_LOCK | SENSOR_CAP_BNS, SENSOR_SIZE_LUT_2P2_BNS,
+      SENSOR_EFFECT_LIST_BASIC, SENSOR_FLASH_MODE_LIST_BASIC,
+      SENSOR_FOCUS_MODE_LIST_AF, SENSOR_WHITE_BALANCE_LIST_BASIC,
+      1008, 566, 1008, 566 },
+    { SENSOR_NAME_S5K6B2,
+      1920, 1080, 1920, 1080, 1920, 1080, 1920, 1080, 22, 420, 227, 1, 32,
+      SENSOR_CAP_VIDEO_STABILIZATION | SENSOR_CAP_AWB_LOCK, SENSOR_SIZE_LUT_NONE,
+      SENSOR_EFFECT_LIST_BASIC, FLASH_MODE_OFF,
+      FOCUS_MODE_INFINITY, SENSOR_WHITE_BALANCE_LIST_BASIC,
+      1008, 566, 1008, 566 },
+    { SENSOR_NAME_S5K3H7,
+      1920, 1080, 3248, 2438, 1920, 1080, 3248, 2438, 22, 420, 227, 2, 32,
+      SENSOR_CAP_AWB_LOCK, SENSOR_SIZE_LUT_3H7,
+      SENSOR_EFFECT_LIST_BASIC, SENSOR_FLASH_MODE_LIST_BASIC,
+      SENSOR_FOCUS_MODE_LIST_AF, SENSOR_WHITE_BALANCE_LIST_BASIC,
+      1008, 566, 1008, 566 },
+    { SENSOR_NAME_S5K3H7_SUNNY,
+      1920, 1080, 3248, 2438, 1920, 1080, 3248, 2438, 22, 420, 227, 2, 32,
+      SENSOR_CAP_AWB_LOCK, SENSOR_SIZE_LUT_3H7,
+      SENSOR_EFFECT_LIST_BASIC, SENSOR_FLASH_MODE_LIST_BASIC,
+      SENSOR_FOCUS_MODE_LIST_AF, SENSOR_WHITE_BALANCE_LIST_BASIC,
+      1008, 566, 1008, 566 },
+    { SENSOR_NAME_S5K3H5,
+      1920, 1080, 3248, 2438, 1920, 1080, 3248, 2438, 22, 420, 227, 2, 32,
+      SENSOR_CAP_AWB_LOCK, SENSOR_SIZE_LUT_NONE,
+      SENSOR_EFFECT_LIST_BASIC, SENSOR_FLASH_MODE_LIST_BASIC,
+      SENSOR_FOCUS_MODE_LIST_AF, SENSOR_WHITE_BALANCE_LIST_BASIC,
+      1008, 566, 1008, 566 },
+    { SENSOR_NAME_S5K4H5,
+      1920, 1080, 3264, 2448, 1920, 1080, 3264, 2448, 22, 420, 227, 2, 32,
+      0, SENSOR_SIZE_LUT_4H5,
+      SENSOR_EFFECT_LIST_BASIC, SENSOR_FLASH_MODE_LIST_BASIC,
+      SENSOR_FOCUS_MODE_LIST_AF, SENSOR_WHITE_BALANCE_LIST_BASIC,
+      1008, 566, 1008, 566 },
+    { SENSOR_NAME_S5K6A3,
+      1280,  720, 1392, 1402, 1920, 1080, 1392, 1402, 22, 420, 227, 2, 32,
+      0, SENSOR_SIZE_LUT_NONE,
+      SENSOR_EFFECT_LIST_BASIC, FLASH_MODE_OFF,
+      FOCUS_MODE_INFINITY, SENSOR_WHITE_BALANCE_LIST_BASIC,
+      1008, 566, 1008, 566 },
+    { SENSOR_NAME_IMX175,
+      1920, 1080, 3264, 2448, 1920, 1080, 3264, 2448, 26, 370, 276, 2, 32,
+      SENSOR_CAP_AWB_LOCK, SENSOR_SIZE_LUT_IMX175,
+      SENSOR_EFFECT_LIST_BASIC, SENSOR_FLASH_MODE_LIST_BASIC,
+      SENSOR_FOCUS_MODE_LIST_AF, SENSOR_WHITE_BALANCE_LIST_BASIC,
+      1008, 566, 1008, 566 },
+    { SENSOR_NAME_S5K8B1,
+      1920, 1080, 1920, 1080, 1920, 1080, 1920, 1080, 22, 420, 227, 1, 32,
+      SENSOR_CAP_VIDEO_STABILIZATION | SENSOR_CAP_AWB_LOCK, SENSOR_SIZE_LUT_NONE,
+      SENSOR_EFFECT_LIST_BASIC, FLASH_MODE_OFF,
+      FOCUS_MODE_INFINITY, SENSOR_WHITE_BALANCE_LIST_BASIC,
+      1008, 566, 1008, 566 },
+};
+
+#define SENSOR_INFO_TABLE_SIZE  (sizeof(SENSOR_INFO_TABLE) / sizeof(SENSOR_INFO_TABLE[0]))
+
+/* Built once per table row (plus the default at the end) and never freed */
+static ExynosSensorInfo *g_sensorInfo[SENSOR_INFO_TABLE_SIZE + 1];
+static Mutex g_sensorInfoLock;
+
+static void initSensorInfo(const struct sensor_info_desc *desc, struct ExynosSensorInfo *info)
+{
+    const struct sensor_size_lut_set *lut = &SENSOR_SIZE_LUT_SETS[desc->sizeLutSet];
+
+    info->maxPreviewW = desc->maxPreviewW;
+    info->maxPreviewH = desc->maxPreviewH;
+    info->maxPictureW = desc->maxPictureW;
+    info->maxPictureH = desc->maxPictureH;
+    info->maxVideoW = desc->maxVideoW;
+    info->maxVideoH = desc->maxVideoH;
+    info->maxSensorW = desc->maxSensorW;
+    info->maxSensorH = desc->maxSensorH;
+
+    info->fNumberNum = desc->fNumberNum;
+    info->focalLengthNum = desc->focalLengthNum;
+    info->apertureNum = desc->apertureNum;
+
+    info->minFps = 1;
+    info->maxNumFocusAreas = desc->maxNumFocusAreas;
+    info->maxNumMeteringAreas = desc->maxNumMeteringAreas;
+    info->videoStabilizationSupport = !!(desc->caps & SENSOR_CAP_VIDEO_STABILIZATION);
+    info->autoWhiteBalanceLockSupport = !!(desc->caps & SENSOR_CAP_AWB_LOCK);
+    info->bnsSupport = !!(desc->caps & SENSOR_CAP_BNS);
+
+    info->effectList = desc->effectList;
+    info->flashModeList = desc->flashModeList;
+    info->focusModeList = desc->focusModeList;
+    info->whiteBalanceList = desc->whiteBalanceList;
+
+    info->previewSizeLutMax     = lut->previewSizeLutMax;
+    info->pictureSizeLutMax     = lut->pictureSizeLutMax;
+    info->videoSizeLutMax       = lut->videoSizeLutMax;
+    info->videoSizeLutHighSpeedMax = lut->videoSizeLutHighSpeedMax;
+    info->previewSizeLut        = lut->previewSizeLut;
+    info->pictureSizeLut        = lut->pictureSizeLut;
+    info->videoSizeLut          = lut->videoSizeLut;
+    info->videoSizeLutHighSpeed = lut->videoSizeLutHighSpeed;
+    info->sizeTableSupport      = (desc->sizeLutSet != SENSOR_SIZE_LUT_NONE);
+
+    info->highSpeedRecording60W = desc->highSpeedRecording60W;
+    info->highSpeedRecording60H = desc->highSpeedRecording60H;
+    info->highSpeedRecording120W = desc->highSpeedRecording120W;
+    info->highSpeedRecording120H = desc->highSpeedRecording120H;
+}
+
+#ifdef SENSOR_NAME_GET_FROM_FILE
+#define SENSOR_ID_CACHE_MAGIC   (0x53494443) /* "SIDC" */
+#define SENSOR_ID_CACHE_VERSION (2)
+
+/*
+ * Persisted result of getSensorIdFromFile(). It is only trusted on the same
+ * device, board revision, build and kernel it was written on, and only if
+ * the capability row stored with each ID still matches the sensor table.
+ */
+struct sensor_id_cache {
+    uint32_t    magic;
+    uint32_t    version;
+    char        serialno[PROPERTY_VALUE_MAX];
+    char        revision[PROPERTY_VALUE_MAX];
+    char        fingerprint[PROPERTY_VALUE_MAX];
+    char        kernel[sizeof(((struct utsname *)0)->release)];
+    int32_t     sensorId[CAMERA_ID_MAX];
+    struct sensor_info_desc caps[CAMERA_ID_MAX];
+    uint32_t    checksum;
+};
+
+static uint32_t sensorIdCacheChecksum(const struct sensor_id_cache *cache)
+{
+    const uint8_t *data = (const uint8_t *)cache;
+    uint32_t sum = 2166136261u;
+
+    for (size_t i = 0; i < offsetof(struct sensor_id_cache, checksum); i++) {
+        sum ^= data[i];
+        sum *= 16777619u;
+    }
+
+    return sum;
+}
+
+static void initSensorIdCache(struct sensor_id_cache *cache)
+{
+    struct utsname uts;
+
+    memset(cache, 0, sizeof(*cache));
+    cache->magic = SENSOR_ID_CACHE_MAGIC;
+    cache->version = SENSOR_ID_CACHE_VERSION;
+    property_get("ro.serialno", cache->serialno, "");
+    property_get("ro.revision", cache->revision, "");
+    property_get("ro.build.fingerprint", cache->fingerprint, "");
+    if (uname(&uts) == 0)
+        strncpy(cache->kernel, uts.release, sizeof(cache->kernel) - 1);
+    for (int i = 0; i < CAMERA_ID_MAX; i++)
+        cache->sensorId[i] = -1;
+}
+
+static status_t readSensorIdCache(struct sensor_id_cache *cache)
+{
+    struct sensor_id_cache current;
+    int fd;
+    ssize_t len;
+
+    fd = open(SENSOR_ID_CACHE_PATH, O_RDONLY);
+    if (fd < 0)
+        return NAME_NOT_FOUND;
+
+    len = read(fd, cache, sizeof(*cache));
+    close(fd);
+
+    initSensorIdCache(&current);
+    if (len != (ssize_t)sizeof(*cache)
+        || cache->magic != SENSOR_ID_CACHE_MAGIC
+        || cache->version != SENSOR_ID_CACHE_VERSION
+        || cache->checksum != sensorIdCacheChecksum(cache)
+        || strncmp(cache->serialno, current.serialno, sizeof(current.serialno))
+        || strncmp(cache->revision, current.revision, sizeof(current.revision))
+        || strncmp(cache->fingerprint, current.fingerprint, sizeof(current.fingerprint))
+        || strncmp(cache->kernel, current.kernel, sizeof(current.kernel))) {
+        ALOGW("WRN(%s[%d]): stale sensor ID cache, probing", __FUNCTION__, __LINE__);
+        return BAD_VALUE;
+    }
+
+    return NO_ERROR;
+}
+
+static const struct sensor_info_desc *findSensorInfoDesc(int sensorId)
+{
+    for (size_t i = 0; i < SENSOR_INFO_TABLE_SIZE; i++) {
+        if (SENSOR_INFO_TABLE[i].sensorName == sensorId)
+            return &SENSOR_INFO_TABLE[i];
+    }
+
+    return NULL;
+}
+
+static status_t loadSensorIdCache(int camId, int *sensorId)
+{
+    struct sensor_id_cache cache;
+    const struct sensor_info_desc *desc;
+
+    if (readSensorIdCache(&cache) != NO_ERROR)
+        return NAME_NOT_FOUND;
+
+    /* Only accept IDs whose capability set is the one we would build now */
+    desc = findSensorInfoDesc(cache.sensorId[camId]);
+    if (desc == NULL || memcmp(desc, &cache.caps[camId], sizeof(*desc)) != 0)
+        return NAME_NOT_FOUND;
+
+    *sensorId = cache.sensorId[camId];
+    return NO_ERROR;
+}
+
+static void saveSensorIdCache(int camId, int sensorId)
+{
+    struct sensor_id_cache cache;
+    const struct sensor_info_desc *desc = findSensorInfoDesc(sensorId);
+    char tmpPath[PATH_MAX];
+    int fd;
+
+    /* A sensor without a table row would be probed again anyway */
+    if (desc == NULL)
+        return;
+
+    /* Keep the other camera's entry if the cache is still valid */
+    if (readSensorIdCache(&cache) != NO_ERROR)
+        initSensorIdCache(&cache);
+
+    cache.sensorId[camId] = sensorId;
+    memcpy(&cache.caps[camId], desc, sizeof(*desc));
+    cache.checksum = sensorIdCacheChecksum(&cache);
+
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", SENSOR_ID_CACHE_PATH);
+    fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        ALOGW("WRN(%s[%d]): cannot create %s (%s)", __FUNCTION__, __LINE__, tmpPath, strerror(errno));
+        return;
+    }
+
+    if (write(fd, &cache, sizeof(cache)) != (ssize_t)sizeof(cache)
+        || fsync(fd) < 0) {
+        close(fd);
+        unlink(tmpPath);
+        return;
+    }
+    close(fd);
+
+    if (rename(tmpPath, SENSOR_ID_CACHE_PATH) < 0)
+        unlink(tmpPath);
+}
+#endif
+
+const struct ExynosSensorInfo *getSensorInfo(int camId)
 {
-    struct ExynosSensorInfo *sensorInfo = NULL;
     int sensorName = getSensorId(camId);
     if (sensorName < 0) {
         ALOGE("ERR(%s[%d]): Inavalid camId, sensor name is nothing", __FUNCTION__, __LINE__);
         sensorName = SENSOR_NAME_NOTHING;
     }
 
-    switch (sensorName) {
-    case SENSOR_NAME_S5K6B2:
-        sensorInfo = new ExynosSensorS5K6B2();
-        break;
-    case SENSOR_NAME_S5K3L2:
-        sensorInfo = new ExynosSensorS5K3L2();
-        break;
-    case SENSOR_NAME_S5K2P2:
-        sensorInfo = new ExynosSensorS5K2P2();
-        break;
-    case SENSOR_NAME_IMX135:
-        sensorInfo = new ExynosSensorIMX135();
-        break;
-    case SENSOR_NAME_IMX134:
-        sensorInfo = new ExynosSensorIMX134();
-        break;
-    case SENSOR_NAME_S5K6A3:
-        sensorInfo = new ExynosSensorS5K6A3();
-        break;
-    case SENSOR_NAME_S5K3H5:
-        sensorInfo = new ExynosSensorS5K3H5();
-        break;
-    case SENSOR_NAME_S5K4H5:
-        sensorInfo = new ExynosSensorS5K4H5();
-        break;
-    case SENSOR_NAME_S5K3H7:
-    case SENSOR_NAME_S5K3H7_SUNNY:
-        sensorInfo = new ExynosSensorS5K3H7();
-        break;
-    case SENSOR_NAME_IMX175:
-        sensorInfo = new ExynosSensorIMX175();
-        break;
-    case SENSOR_NAME_S5K8B1:
-        sensorInfo = new ExynosSensorS5K8B1();
-        break;
-    default:
-        ALOGW("WRN(%s[%d]): Unknown sensor, create default sensor", __FUNCTION__, __LINE__);
-        sensorInfo = new ExynosSensorInfo();
-        break;
+    return getSensorInfoByName(sensorName);
+}
+
+const struct ExynosSensorInfo *getSensorInfoByName(int sensorName)
+{
+    size_t index = SENSOR_INFO_TABLE_SIZE;
+
+    for (size_t i = 0; i < SENSOR_INFO_TABLE_SIZE; i++) {
+        if (SENSOR_INFO_TABLE[i].sensorName == sensorName) {
+            index = i;
+            break;
+        }
+    }
+
+    Mutex::Autolock lock(g_sensorInfoLock);
+
+    if (g_sensorInfo[index] == NULL) {
+        ExynosSensorInfo *sensorInfo = new ExynosSensorInfo();
+        if (index < SENSOR_INFO_TABLE_SIZE)
+            initSensorInfo(&SENSOR_INFO_TABLE[index], sensorInfo);
+        else
+            ALOGW("WRN(%s[%d]): Unknown sensor, create default sensor", __FUNCTION__, __LINE__);
+        sensorInfo->sensorTableIndex = (int)index;
+        g_sensorInfo[index] = sensorInfo;
     }
 
-    return sensorInfo;
+    return g_sensorInfo[index];
+}
+
+/*
+ * Callers own (and delete) the returned object, so hand out a copy of the
+ * shared instance rather than rebuilding it.
+ */
+struct ExynosSensorInfo *createSensorInfo(int camId)
+{
+    return new ExynosSensorInfo(*getSensorInfo(camId));
 }
 
 bool needGSCForCapture(int camId)
@@ -91,13 +475,29 @@ int getSensorId(int camId)
     int sensorId = -1;
 
 #ifdef SENSOR_NAME_GET_FROM_FILE
+    if (camId != CAMERA_ID_BACK && camId != CAMERA_ID_FRONT) {
+        ALOGE("ERR(%s):Unknown camera ID(%d)", __FUNCTION__, camId);
+        return -1;
+    }
+
     int &curSensorId = (camId == CAMERA_ID_BACK) ? g_rearSensorId : g_frontSensorId;
 
     if (curSensorId < 0) {
-        curSensorId = getSensorIdFromFile(camId);
-        if (curSensorId < 0) {
-            ALOGE("ERR(%s): invalid sensor ID %d", __FUNCTION__, sensorId);
+        nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+        bool cached = (loadSensorIdCache(camId, &curSensorId) == NO_ERROR);
+
+        if (cached == false) {
+            curSensorId = getSensorIdFromFile(camId);
+            if (curSensorId < 0) {
+                ALOGE("ERR(%s): invalid sensor ID %d", __FUNCTION__, sensorId);
+            } else {
+                saveSensorIdCache(camId, curSensorId);
+            }
         }
+
+        ALOGD("DEBUG(%s):camId(%d) sensor ID %d, %s open took %lld us", __FUNCTION__,
+            camId, curSensorId, cached ? "warm" : "cold",
+            (long long)ns2us(systemTime(SYSTEM_TIME_MONOTONIC) - start));
     }
 
     sensorId = curSensorId;
@@ -220,11 +620,13 @@ ExynosSensorInfo::ExynosSensorInfo()
     previewSizeLutMax     = 0;
     pictureSizeLutMax     = 0;
     videoSizeLutMax       = 0;
+    videoSizeLutHighSpeedMax = 0;
     previewSizeLut        = NULL;
     pictureSizeLut        = NULL;
     videoSizeLut          = NULL;
     videoSizeLutHighSpeed = NULL;
     sizeTableSupport      = false;
+    sensorTableIndex      = -1;
 
     /* vendor specifics */
     highResolutionCallbackW = 3264;
@@ -241,1510 +643,4 @@ ExynosSensorInfo::ExynosSensorInfo()
     maxFps = 30;
 }
 
-ExynosSensorIMX135::ExynosSensorIMX135()
-{
-    maxPreviewW = 1920;
-    maxPreviewH = 1080;
-    maxPictureW = 4128;
-    maxPictureH = 3096;
-    maxVideoW = 1920;
-    maxVideoH = 1080;
-    maxSensorW = 4128;
-    maxSensorH = 3096;
-    maxThumbnailW = 512;
-    maxThumbnailH = 384;
-
-    fNumberNum = 22;
-    fNumberDen = 10;
-    focalLengthNum = 420;
-    focalLengthDen = 100;
-    focusDistanceNum = 0;
-    focusDistanceDen = 0;
-    apertureNum = 227;
-    apertureDen = 100;
-    horizontalViewAngle = 51.2f;
-    verticalViewAngle = 39.4f;
-    focalLengthIn35mmLength = 31;
-
-    minFps = 1;
-    maxFps = 30;
-
-    minExposureCompensation = -4;
-    maxExposureCompensation = 4;
-    exposureCompensationStep = 0.5f;
-    maxNumDetectedFaces = 16;
-    maxNumFocusAreas = 2;
-    maxNumMeteringAreas = 32;
-    maxZoomLevel = ZOOM_LEVEL_MAX;
-    maxZoomRatio = 400;
-
-    zoomSupport = true;
-    smoothZoomSupport = false;
-    videoSnapshotSupport = true;
-    videoStabilizationSupport = true;
-    autoWhiteBalanceLockSupport = true;
-    autoExposureLockSupport = true;
-
-    antiBandingList =
-          ANTIBANDING_AUTO
-        | ANTIBANDING_50HZ
-        | ANTIBANDING_60HZ
-        | ANTIBANDING_OFF
-        ;
-
-    effectList =
-          EFFECT_NONE
-        | EFFECT_MONO
-        | EFFECT_NEGATIVE
-        /*| EFFECT_SOLARIZE*/
-        | EFFECT_SEPIA
-        | EFFECT_POSTERIZE
-        /*| EFFECT_WHITEBOARD*/
-        /*| EFFECT_BLACKBOARD*/
-        | EFFECT_AQUA
-        ;
-
-    flashModeList =
-          FLASH_MODE_OFF
-        | FLASH_MODE_AUTO
-        | FLASH_MODE_ON
-        /*| FLASH_MODE_RED_EYE*/
-        | FLASH_MODE_TORCH;
-
-    focusModeList =
-          FOCUS_MODE_AUTO
-        /*| FOCUS_MODE_INFINITY*/
-        | FOCUS_MODE_MACRO
-        /*| FOCUS_MODE_FIXED*/
-        /*| FOCUS_MODE_EDOF*/
-        | FOCUS_MODE_CONTINUOUS_VIDEO
-        | FOCUS_MODE_CONTINUOUS_PICTURE
-        | FOCUS_MODE_TOUCH;
-
-    sceneModeList =
-          SCENE_MODE_AUTO
-        | SCENE_MODE_ACTION
-        | SCENE_MODE_PORTRAIT
-        | SCENE_MODE_LANDSCAPE
-        | SCENE_MODE_NIGHT
-        | SCENE_MODE_NIGHT_PORTRAIT
-        | SCENE_MODE_THEATRE
-        | SCENE_MODE_BEACH
-        | SCENE_MODE_SNOW
-        | SCENE_MODE_SUNSET
-        | SCENE_MODE_STEADYPHOTO
-        | SCENE_MODE_FIREWORKS
-        | SCENE_MODE_SPORTS
-        | SCENE_MODE_PARTY
-        | SCENE_MODE_CANDLELIGHT;
-
-    whiteBalanceList =
-          WHITE_BALANCE_AUTO
-        | WHITE_BALANCE_INCANDESCENT
-        | WHITE_BALANCE_FLUORESCENT
-        /*| WHITE_BALANCE_WARM_FLUORESCENT*/
-        | WHITE_BALANCE_DAYLIGHT
-        | WHITE_BALANCE_CLOUDY_DAYLIGHT
-        /*| WHITE_BALANCE_TWILIGHT*/
-        /*| WHITE_BALANCE_SHADE*/
-        ;
-
-    previewSizeLutMax     = 0;
-    pictureSizeLutMax     = 0;
-    videoSizeLutMax       = 0;
-    previewSizeLut        = NULL;
-    pictureSizeLut        = NULL;
-    videoSizeLut          = NULL;
-    videoSizeLutHighSpeed = NULL;
-    sizeTableSupport      = false;
-
-    /* vendor specifics */
-    highResolutionCallbackW = 3264;
-    highResolutionCallbackH = 1836;
-    highSpeedRecording60WFHD = 1920;
-    highSpeedRecording60HFHD = 1080;
-    highSpeedRecording60W = 1008;
-    highSpeedRecording60H = 566;
-    highSpeedRecording120W = 1008;
-    highSpeedRecording120H = 566;
-    scalableSensorSupport = true;
-    bnsSupport = false;
-};
-
-ExynosSensorIMX134::ExynosSensorIMX134()
-{
-    maxPreviewW = 1920;
-    maxPreviewH = 1080;
-    maxPictureW = 3264;
-    maxPictureH = 2448;
-    maxVideoW = 1920;
-    maxVideoH = 1080;
-    maxSensorW = 3264;
-    maxSensorH = 2448;
-
-    maxThumbnailW = 512;
-    maxThumbnailH = 384;
-
-    fNumberNum = 22;
-    fNumberDen = 10;
-    focalLengthNum = 420;
-    focalLengthDen = 100;
-    focusDistanceNum = 0;
-    focusDistanceDen = 0;
-    apertureNum = 227;
-    apertureDen = 100;
-    horizontalViewAngle = 51.2f;
-    verticalViewAngle = 39.4f;
-    focalLengthIn35mmLength = 31;
-
-    minFps = 1;
-    maxFps = 30;
-
-    minExposureCompensation = -4;
-    maxExposureCompensation = 4;
-    exposureCompensationStep = 0.5f;
-    maxNumDetectedFaces = 16;
-    maxNumFocusAreas = 2;
-    maxNumMeteringAreas = 32;
-    maxZoomLevel = ZOOM_LEVEL_MAX;
-    maxZoomRatio = 400;
-
-    zoomSupport = true;
-    smoothZoomSupport = false;
-    videoSnapshotSupport = true;
-    videoStabilizationSupport = false;
-    autoWhiteBalanceLockSupport = false;
-    autoExposureLockSupport = true;
-
-    antiBandingList =
-          ANTIBANDING_AUTO
-        | ANTIBANDING_50HZ
-        | ANTIBANDING_60HZ
-        | ANTIBANDING_OFF
-        ;
-
-    effectList =
-          EFFECT_NONE
-        | EFFECT_MONO
-        | EFFECT_NEGATIVE
-        /*| EFFECT_SOLARIZE*/
-        | EFFECT_SEPIA
-        | EFFECT_POSTERIZE
-        /*| EFFECT_WHITEBOARD*/
-        /*| EFFECT_BLACKBOARD*/
-        | EFFECT_AQUA
-        ;
-
-    flashModeList =
-          FLASH_MODE_OFF
-        | FLASH_MODE_AUTO
-        | FLASH_MODE_ON
-        /*| FLASH_MODE_RED_EYE*/
-        | FLASH_MODE_TORCH;
-
-    focusModeList =
-          FOCUS_MODE_AUTO
-        /*| FOCUS_MODE_INFINITY*/
-        | FOCUS_MODE_MACRO
-        /*| FOCUS_MODE_FIXED*/
-        /*| FOCUS_MODE_EDOF*/
-        | FOCUS_MODE_CONTINUOUS_VIDEO
-        | FOCUS_MODE_CONTINUOUS_PICTURE
-        | FOCUS_MODE_TOUCH;
-
-    sceneModeList =
-          SCENE_MODE_AUTO
-        | SCENE_MODE_ACTION
-        | SCENE_MODE_PORTRAIT
-        | SCENE_MODE_LANDSCAPE
-        | SCENE_MODE_NIGHT
-        | SCENE_MODE_NIGHT_PORTRAIT
-        | SCENE_MODE_THEATRE
-        | SCENE_MODE_BEACH
-        | SCENE_MODE_SNOW
-        | SCENE_MODE_SUNSET
-        | SCENE_MODE_STEADYPHOTO
-        | SCENE_MODE_FIREWORKS
-        | SCENE_MODE_SPORTS
-        | SCENE_MODE_PARTY
-        | SCENE_MODE_CANDLELIGHT;
-
-    whiteBalanceList =
-          WHITE_BALANCE_AUTO
-        | WHITE_BALANCE_INCANDESCENT
-        | WHITE_BALANCE_FLUORESCENT
-        /*| WHITE_BALANCE_WARM_FLUORESCENT*/
-        | WHITE_BALANCE_DAYLIGHT
-        | WHITE_BALANCE_CLOUDY_DAYLIGHT
-        /*| WHITE_BALANCE_TWILIGHT*/
-        /*| WHITE_BALANCE_SHADE*/
-        ;
-
-    previewSizeLutMax     = 0;
-    pictureSizeLutMax     = 0;
-    videoSizeLutMax       = 0;
-    previewSizeLut        = NULL;
-    pictureSizeLut        = NULL;
-    videoSizeLut          = NULL;
-    videoSizeLutHighSpeed = NULL;
-    sizeTableSupport      = false;
-
-    /* vendor specifics */
-    /*
-    burstPanoramaW = 3264;
-    burstPanoramaH = 1836;
-    highSpeedRecording60WFHD = 1920;
-    highSpeedRecording60HFHD = 1080;
-    highSpeedRecording60W = 1008;
-    highSpeedRecording60H = 566;
-    highSpeedRecording120W = 1008;
-    highSpeedRecording120H = 566;
-    scalableSensorSupport = true;
-    */
-    bnsSupport = false;
-};
-
-ExynosSensorS5K3L2::ExynosSensorS5K3L2()
-{
-    maxPreviewW = 1920;
-    maxPreviewH = 1080;
-    maxPictureW = 4128;
-    maxPictureH = 3096;
-    maxVideoW = 1920;
-    maxVideoH = 1080;
-    maxSensorW = 4128;
-    maxSensorH = 3096;
-    maxThumbnailW = 512;
-    maxThumbnailH = 384;
-
-    fNumberNum = 22;
-    fNumberDen = 10;
-    focalLengthNum = 420;
-    focalLengthDen = 100;
-    focusDistanceNum = 0;
-    focusDistanceDen = 0;
-    apertureNum = 227;
-    apertureDen = 100;
-    horizontalViewAngle = 51.2f;
-    verticalViewAngle = 39.4f;
-    focalLengthIn35mmLength = 31;
-
-    minFps = 1;
-    maxFps = 30;
-
-    minExposureCompensation = -4;
-    maxExposureCompensation = 4;
-    exposureCompensationStep = 0.5f;
-    maxNumDetectedFaces = 16;
-    maxNumFocusAreas = 2;
-    maxNumMeteringAreas = 32;
-    maxZoomLevel = ZOOM_LEVEL_MAX;
-    maxZoomRatio = 400;
-
-    zoomSupport = true;
-    smoothZoomSupport = false;
-    videoSnapshotSupport = true;
-    videoStabilizationSupport = true;
-    autoWhiteBalanceLockSupport = true;
-    autoExposureLockSupport = true;
-
-    antiBandingList =
-          ANTIBANDING_AUTO
-        | ANTIBANDING_50HZ
-        | ANTIBANDING_60HZ
-        | ANTIBANDING_OFF
-        ;
-
-    effectList =
-          EFFECT_NONE
-        | EFFECT_MONO
-        | EFFECT_NEGATIVE
-        /*| EFFECT_SOLARIZE*/
-        | EFFECT_SEPIA
-        | EFFECT_POSTERIZE
-        /*| EFFECT_WHITEBOARD*/
-        /*| EFFECT_BLACKBOARD*/
-        | EFFECT_AQUA
-        ;
-
-    flashModeList =
-          FLASH_MODE_OFF
-        | FLASH_MODE_AUTO
-        | FLASH_MODE_ON
-        /*| FLASH_MODE_RED_EYE*/
-        | FLASH_MODE_TORCH;
-
-    focusModeList =
-          FOCUS_MODE_AUTO
-        /*| FOCUS_MODE_INFINITY*/
-        | FOCUS_MODE_MACRO
-        /*| FOCUS_MODE_FIXED*/
-        /*| FOCUS_MODE_EDOF*/
-        | FOCUS_MODE_CONTINUOUS_VIDEO
-        | FOCUS_MODE_CONTINUOUS_PICTURE
-        | FOCUS_MODE_TOUCH;
-
-    sceneModeList =
-          SCENE_MODE_AUTO
-        | SCENE_MODE_ACTION
-        | SCENE_MODE_PORTRAIT
-        | SCENE_MODE_LANDSCAPE
-        | SCENE_MODE_NIGHT
-        | SCENE_MODE_NIGHT_PORTRAIT
-        | SCENE_MODE_THEATRE
-        | SCENE_MODE_BEACH
-        | SCENE_MODE_SNOW
-        | SCENE_MODE_SUNSET
-        | SCENE_MODE_STEADYPHOTO
-        | SCENE_MODE_FIREWORKS
-        | SCENE_MODE_SPORTS
-        | SCENE_MODE_PARTY
-        | SCENE_MODE_CANDLELIGHT;
-
-    whiteBalanceList =
-          WHITE_BALANCE_AUTO
-        | WHITE_BALANCE_INCANDESCENT
-        | WHITE_BALANCE_FLUORESCENT
-        /*| WHITE_BALANCE_WARM_FLUORESCENT*/
-        | WHITE_BALANCE_DAYLIGHT
-        | WHITE_BALANCE_CLOUDY_DAYLIGHT
-        /*| WHITE_BALANCE_TWILIGHT*/
-        /*| WHITE_BALANCE_SHADE*/
-        ;
-
-    /* vendor specifics */
-    highResolutionCallbackW = 3264;
-    highResolutionCallbackH = 1836;
-    highSpeedRecording60WFHD = 1920;
-    highSpeedRecording60HFHD = 1080;
-    highSpeedRecording60W = 2056;
-    highSpeedRecording60H = 1152;
-    highSpeedRecording120W = 1024;
-    highSpeedRecording120H = 574;
-    scalableSensorSupport = true;
-    bnsSupport = false;
-
-    if (bnsSupport == true) {
-        previewSizeLutMax = sizeof(PREVIEW_SIZE_LUT_3L2_BNS) / (sizeof(int) * SIZE_OF_LUT);
-        videoSizeLutMax   = sizeof(VIDEO_SIZE_LUT_3L2_BNS)   / (sizeof(int) * SIZE_OF_LUT);
-        previewSizeLut    = PREVIEW_SIZE_LUT_3L2_BNS;
-        videoSizeLut      = VIDEO_SIZE_LUT_3L2_BNS;
-    } else {
-        previewSizeLutMax = sizeof(PREVIEW_SIZE_LUT_3L2) / (sizeof(int) * SIZE_OF_LUT);
-        videoSizeLutMax   = sizeof(VIDEO_SIZE_LUT_3L2)   / (sizeof(int) * SIZE_OF_LUT);
-        previewSizeLut    = PREVIEW_SIZE_LUT_3L2;
-        videoSizeLut      = VIDEO_SIZE_LUT_3L2;
-    }
-    pictureSizeLutMax     = sizeof(PICTURE_SIZE_LUT_3L2) / (sizeof(int) * SIZE_OF_LUT);
-    pictureSizeLut        = PICTURE_SIZE_LUT_3L2;
-    videoSizeLutHighSpeed = VIDEO_SIZE_LUT_HIGH_SPEED_3L2;
-    sizeTableSupport = true;
-};
-
-ExynosSensorS5K2P2::ExynosSensorS5K2P2()
-{
-    maxPreviewW = 3840;
-    maxPreviewH = 2160;
-    maxPictureW = 5312;
-    maxPictureH = 2988;
-    maxVideoW = 3840;
-    maxVideoH = 2160;
-    maxSensorW = 5312;
-    maxSensorH = 2990;
-    maxThumbnailW = 512;
-    maxThumbnailH = 384;
-
-    fNumberNum = 22;
-    fNumberDen = 10;
-    focalLengthNum = 420;
-    focalLengthDen = 100;
-    focusDistanceNum = 0;
-    focusDistanceDen = 0;
-    apertureNum = 227;
-    apertureDen = 100;
-    horizontalViewAngle = 51.2f;
-    verticalViewAngle = 39.4f;
-    focalLengthIn35mmLength = 31;
-
-    minFps = 1;
-    maxFps = 30;
-
-    minExposureCompensation = -4;
-    maxExposureCompensation = 4;
-    exposureCompensationStep = 0.5f;
-    maxNumDetectedFaces = 16;
-    maxNumFocusAreas = 2;
-    maxNumMeteringAreas = 32;
-    maxZoomLevel = ZOOM_LEVEL_MAX;
-    maxZoomRatio = 400;
-
-    zoomSupport = true;
-    smoothZoomSupport = false;
-    videoSnapshotSupport = true;
-    videoStabilizationSupport = true;
-    autoWhiteBalanceLockSupport = true;
-    autoExposureLockSupport = true;
-
-    antiBandingList =
-          ANTIBANDING_AUTO
-        | ANTIBANDING_50HZ
-        | ANTIBANDING_60HZ
-        | ANTIBANDING_OFF
-        ;
-
-    effectList =
-          EFFECT_NONE
-        | EFFECT_MONO
-        | EFFECT_NEGATIVE
-        /*| EFFECT_SOLARIZE*/
-        | EFFECT_SEPIA
-        | EFFECT_POSTERIZE
-        /*| EFFECT_WHITEBOARD*/
-        /*| EFFECT_BLACKBOARD*/
-        | EFFECT_AQUA
-        ;
-
-    flashModeList =
-          FLASH_MODE_OFF
-        | FLASH_MODE_AUTO
-        | FLASH_MODE_ON
-        //| FLASH_MODE_RED_EYE
-        | FLASH_MODE_TORCH;
-
-    focusModeList =
-          FOCUS_MODE_AUTO
-        //| FOCUS_MODE_INFINITY
-        | FOCUS_MODE_MACRO
-        //| FOCUS_MODE_FIXED
-        //| FOCUS_MODE_EDOF
-        | FOCUS_MODE_CONTINUOUS_VIDEO
-        | FOCUS_MODE_CONTINUOUS_PICTURE
-        | FOCUS_MODE_TOUCH;
-
-    sceneModeList =
-          SCENE_MODE_AUTO
-        | SCENE_MODE_ACTION
-        | SCENE_MODE_PORTRAIT
-        | SCENE_MODE_LANDSCAPE
-        | SCENE_MODE_NIGHT
-        | SCENE_MODE_NIGHT_PORTRAIT
-        | SCENE_MODE_THEATRE
-        | SCENE_MODE_BEACH
-        | SCENE_MODE_SNOW
-        | SCENE_MODE_SUNSET
-        | SCENE_MODE_STEADYPHOTO
-        | SCENE_MODE_FIREWORKS
-        | SCENE_MODE_SPORTS
-        | SCENE_MODE_PARTY
-        | SCENE_MODE_CANDLELIGHT;
-
-    whiteBalanceList =
-          WHITE_BALANCE_AUTO
-        | WHITE_BALANCE_INCANDESCENT
-        | WHITE_BALANCE_FLUORESCENT
-        //| WHITE_BALANCE_WARM_FLUORESCENT
-        | WHITE_BALANCE_DAYLIGHT
-        | WHITE_BALANCE_CLOUDY_DAYLIGHT
-        //| WHITE_BALANCE_TWILIGHT
-        //| WHITE_BALANCE_SHADE
-        ;
-
-    /* vendor specifics */
-    highResolutionCallbackW = 3264;
-    highResolutionCallbackH = 1836;
-    highSpeedRecording60WFHD = 1920;
-    highSpeedRecording60HFHD = 1080;
-    highSpeedRecording60W = 1008;
-    highSpeedRecording60H = 566;
-    highSpeedRecording120W = 1008;
-    highSpeedRecording120H = 566;
-    scalableSensorSupport = true;
-    bnsSupport = true;
-
-    if (bnsSupport == true) {
-        previewSizeLutMax     = sizeof(PREVIEW_SIZE_LUT_2P2_BNS) / (sizeof(int) * SIZE_OF_LUT);
-        videoSizeLutMax       = sizeof(VIDEO_SIZE_LUT_2P2_BNS)   / (sizeof(int) * SIZE_OF_LUT);
-        pictureSizeLutMax     = sizeof(PICTURE_SIZE_LUT_2P2)     / (sizeof(int) * SIZE_OF_LUT);
-        previewSizeLut        = PREVIEW_SIZE_LUT_2P2_BNS;
-        videoSizeLut          = VIDEO_SIZE_LUT_2P2_BNS;
-        pictureSizeLut        = PICTURE_SIZE_LUT_2P2;
-        videoSizeLutHighSpeed = VIDEO_SIZE_LUT_HIGH_SPEED_2P2_BNS;
-        sizeTableSupport      = true;
-    } else {
-        previewSizeLutMax     = 0;
-        pictureSizeLutMax     = 0;
-        videoSizeLutMax       = 0;
-        previewSizeLut        = NULL;
-        pictureSizeLut        = NULL;
-        videoSizeLut          = NULL;
-        videoSizeLutHighSpeed = NULL;
-        sizeTableSupport      = false;
-    }
-};
-
-ExynosSensorS5K6B2::ExynosSensorS5K6B2()
-{
-    maxPreviewW = 1920;
-    maxPreviewH = 1080;
-    maxPictureW = 1920;
-    maxPictureH = 1080;
-    maxVideoW = 1920;
-    maxVideoH = 1080;
-    maxSensorW = 1920;
-    maxSensorH = 1080;
-    maxThumbnailW = 512;
-    maxThumbnailH = 384;
-
-    fNumberNum = 22;
-    fNumberDen = 10;
-    focalLengthNum = 420;
-    focalLengthDen = 100;
-    focusDistanceNum = 0;
-    focusDistanceDen = 0;
-    apertureNum = 227;
-    apertureDen = 100;
-    horizontalViewAngle = 51.2f;
-    verticalViewAngle = 39.4f;
-    focalLengthIn35mmLength = 31;
-
-    minFps = 1;
-    maxFps = 30;
-
-    minExposureCompensation = -4;
-    maxExposureCompensation = 4;
-    exposureCompensationStep = 0.5f;
-    maxNumDetectedFaces = 16;
-    maxNumFocusAreas = 1;
-    maxNumMeteringAreas = 32;
-    maxZoomLevel = ZOOM_LEVEL_MAX;
-    maxZoomRatio = 400;
-
-    zoomSupport = true;
-    smoothZoomSupport = false;
-    videoSnapshotSupport = true;
-    videoStabilizationSupport = true;
-    autoWhiteBalanceLockSupport = true;
-    autoExposureLockSupport = true;
-
-    antiBandingList =
-          ANTIBANDING_AUTO
-        | ANTIBANDING_50HZ
-        | ANTIBANDING_60HZ
-        | ANTIBANDING_OFF
-        ;
-
-    effectList =
-          EFFECT_NONE
-        | EFFECT_MONO
-        | EFFECT_NEGATIVE
-        /*| EFFECT_SOLARIZE*/
-        | EFFECT_SEPIA
-        | EFFECT_POSTERIZE
-        /*| EFFECT_WHITEBOARD*/
-        /*| EFFECT_BLACKBOARD*/
-        | EFFECT_AQUA
-        ;
-
-    flashModeList =
-          FLASH_MODE_OFF
-        /*| FLASH_MODE_AUTO*/
-        /*| FLASH_MODE_ON*/
-        /*| FLASH_MODE_RED_EYE*/
-        /*| FLASH_MODE_TORCH*/
-        ;
-
-    focusModeList =
-        /* FOCUS_MODE_AUTO*/
-        FOCUS_MODE_INFINITY
-        /*| FOCUS_MODE_MACRO*/
-        /*| FOCUS_MODE_FIXED*/
-        /*| FOCUS_MODE_EDOF*/
-        /*| FOCUS_MODE_CONTINUOUS_VIDEO*/
-        /*| FOCUS_MODE_CONTINUOUS_PICTURE*/
-        /*| FOCUS_MODE_TOUCH*/
-        ;
-
-    sceneModeList =
-          SCENE_MODE_AUTO
-        | SCENE_MODE_ACTION
-        | SCENE_MODE_PORTRAIT
-        | SCENE_MODE_LANDSCAPE
-        | SCENE_MODE_NIGHT
-        | SCENE_MODE_NIGHT_PORTRAIT
-        | SCENE_MODE_THEATRE
-        | SCENE_MODE_BEACH
-        | SCENE_MODE_SNOW
-        | SCENE_MODE_SUNSET
-        | SCENE_MODE_STEADYPHOTO
-        | SCENE_MODE_FIREWORKS
-        | SCENE_MODE_SPORTS
-        | SCENE_MODE_PARTY
-        | SCENE_MODE_CANDLELIGHT;
-
-    whiteBalanceList =
-          WHITE_BALANCE_AUTO
-        | WHITE_BALANCE_INCANDESCENT
-        | WHITE_BALANCE_FLUORESCENT
-        /* WHITE_BALANCE_WARM_FLUORESCENT*/
-        | WHITE_BALANCE_DAYLIGHT
-        | WHITE_BALANCE_CLOUDY_DAYLIGHT
-        /* WHITE_BALANCE_TWILIGHT*/
-        /* WHITE_BALANCE_SHADE*/
-        ;
-
-    previewSizeLutMax     = 0;
-    pictureSizeLutMax     = 0;
-    videoSizeLutMax       = 0;
-    previewSizeLut        = NULL;
-    pictureSizeLut        = NULL;
-    videoSizeLut          = NULL;
-    videoSizeLutHighSpeed = NULL;
-    sizeTableSupport      = false;
-
-    /* vendor specifics */
-    highResolutionCallbackW = 3264;
-    highResolutionCallbackH = 1836;
-    highSpeedRecording60WFHD = 1920;
-    highSpeedRecording60HFHD = 1080;
-    highSpeedRecording60W = 1008;
-    highSpeedRecording60H = 566;
-    highSpeedRecording120W = 1008;
-    highSpeedRecording120H = 566;
-    scalableSensorSupport = true;
-    bnsSupport = false;
-};
-
-
-ExynosSensorS5K3H7::ExynosSensorS5K3H7()
-{
-    maxPreviewW = 1920;
-    maxPreviewH = 1080;
-    maxPictureW = 3248;
-    maxPictureH = 2438;
-    maxVideoW = 1920;
-    maxVideoH = 1080;
-    maxSensorW = 3248;
-    maxSensorH = 2438;
-
-    maxThumbnailW = 512;
-    maxThumbnailH = 384;
-
-    fNumberNum = 22;
-    fNumberDen = 10;
-    focalLengthNum = 420;
-    focalLengthDen = 100;
-    focusDistanceNum = 0;
-    focusDistanceDen = 0;
-    apertureNum = 227;
-    apertureDen = 100;
-    horizontalViewAngle = 51.2f;
-    verticalViewAngle = 39.4f;
-    focalLengthIn35mmLength = 31;
-
-    minFps = 1;
-    maxFps = 30;
-
-    minExposureCompensation = -4;
-    maxExposureCompensation = 4;
-    exposureCompensationStep = 0.5f;
-    maxNumDetectedFaces = 16;
-    maxNumFocusAreas = 2;
-    maxNumMeteringAreas = 32;
-    maxZoomLevel = ZOOM_LEVEL_MAX;
-    maxZoomRatio = 400;
-
-    zoomSupport = true;
-    smoothZoomSupport = false;
-    videoSnapshotSupport = true;
-    videoStabilizationSupport = false;
-    autoWhiteBalanceLockSupport = true;
-    autoExposureLockSupport = true;
-
-    antiBandingList =
-          ANTIBANDING_AUTO
-        | ANTIBANDING_50HZ
-        | ANTIBANDING_60HZ
-        | ANTIBANDING_OFF
-        ;
-
-    effectList =
-          EFFECT_NONE
-        | EFFECT_MONO
-        | EFFECT_NEGATIVE
-        /*| EFFECT_SOLARIZE*/
-        | EFFECT_SEPIA
-        | EFFECT_POSTERIZE
-        /*| EFFECT_WHITEBOARD*/
-        /*| EFFECT_BLACKBOARD*/
-        | EFFECT_AQUA
-        ;
-
-    flashModeList =
-          FLASH_MODE_OFF
-        | FLASH_MODE_AUTO
-        | FLASH_MODE_ON
-        /*| FLASH_MODE_RED_EYE*/
-        | FLASH_MODE_TORCH;
-
-    focusModeList =
-          FOCUS_MODE_AUTO
-        /*| FOCUS_MODE_INFINITY*/
-        | FOCUS_MODE_MACRO
-        /*| FOCUS_MODE_FIXED*/
-        /*| FOCUS_MODE_EDOF*/
-        | FOCUS_MODE_CONTINUOUS_VIDEO
-        | FOCUS_MODE_CONTINUOUS_PICTURE
-        | FOCUS_MODE_TOUCH;
-
-    sceneModeList =
-          SCENE_MODE_AUTO
-        | SCENE_MODE_ACTION
-        | SCENE_MODE_PORTRAIT
-        | SCENE_MODE_LANDSCAPE
-        | SCENE_MODE_NIGHT
-        | SCENE_MODE_NIGHT_PORTRAIT
-        | SCENE_MODE_THEATRE
-        | SCENE_MODE_BEACH
-        | SCENE_MODE_SNOW
-        | SCENE_MODE_SUNSET
-        | SCENE_MODE_STEADYPHOTO
-        | SCENE_MODE_FIREWORKS
-        | SCENE_MODE_SPORTS
-        | SCENE_MODE_PARTY
-        | SCENE_MODE_CANDLELIGHT;
-
-    whiteBalanceList =
-          WHITE_BALANCE_AUTO
-        | WHITE_BALANCE_INCANDESCENT
-        | WHITE_BALANCE_FLUORESCENT
-        /*| WHITE_BALANCE_WARM_FLUORESCENT*/
-        | WHITE_BALANCE_DAYLIGHT
-        | WHITE_BALANCE_CLOUDY_DAYLIGHT
-        /*| WHITE_BALANCE_TWILIGHT*/
-        /*| WHITE_BALANCE_SHADE*/
-        ;
-
-    /* vendor specifics */
-    /*
-    burstPanoramaW = 3264;
-    burstPanoramaH = 1836;
-    highSpeedRecording60WFHD = 1920;
-    highSpeedRecording60HFHD = 1080;
-    highSpeedRecording60W = 1008;
-    highSpeedRecording60H = 566;
-    highSpeedRecording120W = 1008;
-    highSpeedRecording120H = 566;
-    scalableSensorSupport = true;
-    */
-    bnsSupport = false;
-
-    if (bnsSupport == true) {
-        previewSizeLutMax     = 0;
-        pictureSizeLutMax     = 0;
-        videoSizeLutMax       = 0;
-        previewSizeLut        = NULL;
-        pictureSizeLut        = NULL;
-        videoSizeLut          = NULL;
-        videoSizeLutHighSpeed = NULL;
-        sizeTableSupport      = false;
-    } else {
-        previewSizeLutMax     = sizeof(PREVIEW_SIZE_LUT_3H7) / (sizeof(int) * SIZE_OF_LUT);
-        videoSizeLutMax       = sizeof(VIDEO_SIZE_LUT_3H7)   / (sizeof(int) * SIZE_OF_LUT);
-        pictureSizeLutMax     = sizeof(PICTURE_SIZE_LUT_3H7) / (sizeof(int) * SIZE_OF_LUT);
-        previewSizeLut        = PREVIEW_SIZE_LUT_3H7;
-        videoSizeLut          = VIDEO_SIZE_LUT_3H7;
-        pictureSizeLut        = PICTURE_SIZE_LUT_3H7;
-        videoSizeLutHighSpeed = VIDEO_SIZE_LUT_HIGH_SPEED_3H7;
-        sizeTableSupport      = true;
-    }
-};
-
-ExynosSensorS5K3H5::ExynosSensorS5K3H5()
-{
-    maxPreviewW = 1920;
-    maxPreviewH = 1080;
-    maxPictureW = 3248;
-    maxPictureH = 2438;
-    maxVideoW = 1920;
-    maxVideoH = 1080;
-    maxSensorW = 3248;
-    maxSensorH = 2438;
-
-    maxThumbnailW = 512;
-    maxThumbnailH = 384;
-
-    fNumberNum = 22;
-    fNumberDen = 10;
-    focalLengthNum = 420;
-    focalLengthDen = 100;
-    focusDistanceNum = 0;
-    focusDistanceDen = 0;
-    apertureNum = 227;
-    apertureDen = 100;
-    horizontalViewAngle = 51.2f;
-    verticalViewAngle = 39.4f;
-    focalLengthIn35mmLength = 31;
-
-    minFps = 1;
-    maxFps = 30;
-
-    minExposureCompensation = -4;
-    maxExposureCompensation = 4;
-    exposureCompensationStep = 0.5f;
-    maxNumDetectedFaces = 16;
-    maxNumFocusAreas = 2;
-    maxNumMeteringAreas = 32;
-    maxZoomLevel = ZOOM_LEVEL_MAX;
-    maxZoomRatio = 400;
-
-    zoomSupport = true;
-    smoothZoomSupport = false;
-    videoSnapshotSupport = true;
-    videoStabilizationSupport = false;
-    autoWhiteBalanceLockSupport = true;
-    autoExposureLockSupport = true;
-
-    antiBandingList =
-          ANTIBANDING_AUTO
-        | ANTIBANDING_50HZ
-        | ANTIBANDING_60HZ
-        | ANTIBANDING_OFF
-        ;
-
-    effectList =
-          EFFECT_NONE
-        | EFFECT_MONO
-        | EFFECT_NEGATIVE
-        /*| EFFECT_SOLARIZE*/
-        | EFFECT_SEPIA
-        | EFFECT_POSTERIZE
-        /*| EFFECT_WHITEBOARD*/
-        /*| EFFECT_BLACKBOARD*/
-        | EFFECT_AQUA
-        ;
-
-    flashModeList =
-          FLASH_MODE_OFF
-        | FLASH_MODE_AUTO
-        | FLASH_MODE_ON
-        /*| FLASH_MODE_RED_EYE*/
-        | FLASH_MODE_TORCH;
-
-    focusModeList =
-          FOCUS_MODE_AUTO
-        /*| FOCUS_MODE_INFINITY*/
-        | FOCUS_MODE_MACRO
-        /*| FOCUS_MODE_FIXED*/
-        /*| FOCUS_MODE_EDOF*/
-        | FOCUS_MODE_CONTINUOUS_VIDEO
-        | FOCUS_MODE_CONTINUOUS_PICTURE
-        | FOCUS_MODE_TOUCH;
-
-    sceneModeList =
-          SCENE_MODE_AUTO
-        | SCENE_MODE_ACTION
-        | SCENE_MODE_PORTRAIT
-        | SCENE_MODE_LANDSCAPE
-        | SCENE_MODE_NIGHT
-        | SCENE_MODE_NIGHT_PORTRAIT
-        | SCENE_MODE_THEATRE
-        | SCENE_MODE_BEACH
-        | SCENE_MODE_SNOW
-        | SCENE_MODE_SUNSET
-        | SCENE_MODE_STEADYPHOTO
-        | SCENE_MODE_FIREWORKS
-        | SCENE_MODE_SPORTS
-        | SCENE_MODE_PARTY
-        | SCENE_MODE_CANDLELIGHT;
-
-    whiteBalanceList =
-          WHITE_BALANCE_AUTO
-        | WHITE_BALANCE_INCANDESCENT
-        | WHITE_BALANCE_FLUORESCENT
-        /*| WHITE_BALANCE_WARM_FLUORESCENT*/
-        | WHITE_BALANCE_DAYLIGHT
-        | WHITE_BALANCE_CLOUDY_DAYLIGHT
-        /*| WHITE_BALANCE_TWILIGHT*/
-        /*| WHITE_BALANCE_SHADE*/
-        ;
-
-    previewSizeLutMax     = 0;
-    pictureSizeLutMax     = 0;
-    videoSizeLutMax       = 0;
-    previewSizeLut        = NULL;
-    pictureSizeLut        = NULL;
-    videoSizeLut          = NULL;
-    videoSizeLutHighSpeed = NULL;
-    sizeTableSupport      = false;
-
-    /* vendor specifics */
-    /*
-    burstPanoramaW = 3264;
-    burstPanoramaH = 1836;
-    highSpeedRecording60WFHD = 1920;
-    highSpeedRecording60HFHD = 1080;
-    highSpeedRecording60W = 1008;
-    highSpeedRecording60H = 566;
-    highSpeedRecording120W = 1008;
-    highSpeedRecording120H = 566;
-    scalableSensorSupport = true;
-    */
-    bnsSupport = false;
-};
-
-ExynosSensorS5K4H5::ExynosSensorS5K4H5()
-{
-    maxPreviewW = 1920;
-    maxPreviewH = 1080;
-    maxPictureW = 3264;
-    maxPictureH = 2448;
-    maxVideoW = 1920;
-    maxVideoH = 1080;
-    maxSensorW = 3264;
-    maxSensorH = 2448;
-
-    maxThumbnailW = 512;
-    maxThumbnailH = 384;
-
-    fNumberNum = 22;
-    fNumberDen = 10;
-    focalLengthNum = 420;
-    focalLengthDen = 100;
-    focusDistanceNum = 0;
-    focusDistanceDen = 0;
-    apertureNum = 227;
-    apertureDen = 100;
-    horizontalViewAngle = 51.2f;
-    verticalViewAngle = 39.4f;
-    focalLengthIn35mmLength = 31;
-
-    minFps = 1;
-    maxFps = 30;
-
-    minExposureCompensation = -4;
-    maxExposureCompensation = 4;
-    exposureCompensationStep = 0.5f;
-    maxNumDetectedFaces = 16;
-    maxNumFocusAreas = 2;
-    maxNumMeteringAreas = 32;
-    maxZoomLevel = ZOOM_LEVEL_MAX;
-    maxZoomRatio = 400;
-
-    zoomSupport = true;
-    smoothZoomSupport = false;
-    videoSnapshotSupport = true;
-    videoStabilizationSupport = false;
-    autoWhiteBalanceLockSupport = false;
-    autoExposureLockSupport = true;
-
-    antiBandingList =
-          ANTIBANDING_AUTO
-        | ANTIBANDING_50HZ
-        | ANTIBANDING_60HZ
-        | ANTIBANDING_OFF
-        ;
-
-    effectList =
-          EFFECT_NONE
-        | EFFECT_MONO
-        | EFFECT_NEGATIVE
-        /*| EFFECT_SOLARIZE*/
-        | EFFECT_SEPIA
-        | EFFECT_POSTERIZE
-        /*| EFFECT_WHITEBOARD*/
-        /*| EFFECT_BLACKBOARD*/
-        | EFFECT_AQUA
-        ;
-
-    flashModeList =
-          FLASH_MODE_OFF
-        | FLASH_MODE_AUTO
-        | FLASH_MODE_ON
-        /*| FLASH_MODE_RED_EYE*/
-        | FLASH_MODE_TORCH;
-
-    focusModeList =
-          FOCUS_MODE_AUTO
-        /*| FOCUS_MODE_INFINITY*/
-        | FOCUS_MODE_MACRO
-        /*| FOCUS_MODE_FIXED*/
-        /*| FOCUS_MODE_EDOF*/
-        | FOCUS_MODE_CONTINUOUS_VIDEO
-        | FOCUS_MODE_CONTINUOUS_PICTURE
-        | FOCUS_MODE_TOUCH;
-
-    sceneModeList =
-          SCENE_MODE_AUTO
-        | SCENE_MODE_ACTION
-        | SCENE_MODE_PORTRAIT
-        | SCENE_MODE_LANDSCAPE
-        | SCENE_MODE_NIGHT
-        | SCENE_MODE_NIGHT_PORTRAIT
-        | SCENE_MODE_THEATRE
-        | SCENE_MODE_BEACH
-        | SCENE_MODE_SNOW
-        | SCENE_MODE_SUNSET
-        | SCENE_MODE_STEADYPHOTO
-        | SCENE_MODE_FIREWORKS
-        | SCENE_MODE_SPORTS
-        | SCENE_MODE_PARTY
-        | SCENE_MODE_CANDLELIGHT;
-
-    whiteBalanceList =
-          WHITE_BALANCE_AUTO
-        | WHITE_BALANCE_INCANDESCENT
-        | WHITE_BALANCE_FLUORESCENT
-        /*| WHITE_BALANCE_WARM_FLUORESCENT*/
-        | WHITE_BALANCE_DAYLIGHT
-        | WHITE_BALANCE_CLOUDY_DAYLIGHT
-        /*| WHITE_BALANCE_TWILIGHT*/
-        /*| WHITE_BALANCE_SHADE*/
-        ;
-
-    /* vendor specifics */
-    /*
-    burstPanoramaW = 3264;
-    burstPanoramaH = 1836;
-    highSpeedRecording60WFHD = 1920;
-    highSpeedRecording60HFHD = 1080;
-    highSpeedRecording60W = 1008;
-    highSpeedRecording60H = 566;
-    highSpeedRecording120W = 1008;
-    highSpeedRecording120H = 566;
-    scalableSensorSupport = true;
-    */
-    bnsSupport = false;
-
-    if (bnsSupport == true) {
-        previewSizeLutMax     = 0;
-        pictureSizeLutMax     = 0;
-        videoSizeLutMax       = 0;
-        previewSizeLut        = NULL;
-        pictureSizeLut        = NULL;
-        videoSizeLut          = NULL;
-        videoSizeLutHighSpeed = NULL;
-        sizeTableSupport      = false;
-    } else {
-        previewSizeLutMax     = sizeof(PREVIEW_SIZE_LUT_4H5) / (sizeof(int) * SIZE_OF_LUT);
-        videoSizeLutMax       = sizeof(VIDEO_SIZE_LUT_4H5)   / (sizeof(int) * SIZE_OF_LUT);
-        pictureSizeLutMax     = sizeof(PICTURE_SIZE_LUT_4H5) / (sizeof(int) * SIZE_OF_LUT);
-        previewSizeLut        = PREVIEW_SIZE_LUT_4H5;
-        videoSizeLut          = VIDEO_SIZE_LUT_4H5;
-        pictureSizeLut        = PICTURE_SIZE_LUT_4H5;
-        videoSizeLutHighSpeed = VIDEO_SIZE_LUT_HIGH_SPEED_4H5;
-        sizeTableSupport      = true;
-    }
-};
-
-ExynosSensorS5K6A3::ExynosSensorS5K6A3()
-{
-    maxPreviewW = 1280;
-    maxPreviewH = 720;
-    maxPictureW = 1392;
-    maxPictureH = 1402;
-    maxVideoW = 1920;
-    maxVideoH = 1080;
-    maxSensorW = 1392;
-    maxSensorH = 1402;
-
-    maxThumbnailW = 512;
-    maxThumbnailH = 384;
-
-    fNumberNum = 22;
-    fNumberDen = 10;
-    focalLengthNum = 420;
-    focalLengthDen = 100;
-    focusDistanceNum = 0;
-    focusDistanceDen = 0;
-    apertureNum = 227;
-    apertureDen = 100;
-    horizontalViewAngle = 51.2f;
-    verticalViewAngle = 39.4f;
-    focalLengthIn35mmLength = 31;
-
-    minFps = 1;
-    maxFps = 30;
-
-    minExposureCompensation = -4;
-    maxExposureCompensation = 4;
-    exposureCompensationStep = 0.5f;
-    maxNumDetectedFaces = 16;
-    maxNumFocusAreas = 2;
-    maxNumMeteringAreas = 32;
-    maxZoomLevel = ZOOM_LEVEL_MAX;
-    maxZoomRatio = 400;
-
-    zoomSupport = true;
-    smoothZoomSupport = false;
-    videoSnapshotSupport = true;
-    videoStabilizationSupport = false;
-    autoWhiteBalanceLockSupport = false;
-    autoExposureLockSupport = true;
-
-    antiBandingList =
-          ANTIBANDING_AUTO
-        | ANTIBANDING_50HZ
-        | ANTIBANDING_60HZ
-        | ANTIBANDING_OFF
-        ;
-
-    effectList =
-          EFFECT_NONE
-        | EFFECT_MONO
-        | EFFECT_NEGATIVE
-        /*| EFFECT_SOLARIZE*/
-        | EFFECT_SEPIA
-        | EFFECT_POSTERIZE
-        /*| EFFECT_WHITEBOARD*/
-        /*| EFFECT_BLACKBOARD*/
-        | EFFECT_AQUA
-        ;
-
-    flashModeList =
-          FLASH_MODE_OFF;
-        /*| FLASH_MODE_AUTO*/
-        /*| FLASH_MODE_ON*/
-        /*| FLASH_MODE_RED_EYE*/
-        /*| FLASH_MODE_TORCH;*/
-
-    focusModeList =
-        /*FOCUS_MODE_AUTO*/
-        FOCUS_MODE_INFINITY;
-        /*| FOCUS_MODE_INFINITY*/
-        /*| FOCUS_MODE_MACRO*/
-        /*| FOCUS_MODE_FIXED*/
-        /*| FOCUS_MODE_EDOF*/
-        /*| FOCUS_MODE_CONTINUOUS_VIDEO*/
-        /*| FOCUS_MODE_CONTINUOUS_PICTURE*/
-        /*| FOCUS_MODE_TOUCH*/
-        ;
-
-    sceneModeList =
-          SCENE_MODE_AUTO
-        | SCENE_MODE_ACTION
-        | SCENE_MODE_PORTRAIT
-        | SCENE_MODE_LANDSCAPE
-        | SCENE_MODE_NIGHT
-        | SCENE_MODE_NIGHT_PORTRAIT
-        | SCENE_MODE_THEATRE
-        | SCENE_MODE_BEACH
-        | SCENE_MODE_SNOW
-        | SCENE_MODE_SUNSET
-        | SCENE_MODE_STEADYPHOTO
-        | SCENE_MODE_FIREWORKS
-        | SCENE_MODE_SPORTS
-        | SCENE_MODE_PARTY
-        | SCENE_MODE_CANDLELIGHT;
-
-    whiteBalanceList =
-          WHITE_BALANCE_AUTO
-        | WHITE_BALANCE_INCANDESCENT
-        | WHITE_BALANCE_FLUORESCENT
-        /*| WHITE_BALANCE_WARM_FLUORESCENT*/
-        | WHITE_BALANCE_DAYLIGHT
-        | WHITE_BALANCE_CLOUDY_DAYLIGHT
-        /*| WHITE_BALANCE_TWILIGHT*/
-        /*| WHITE_BALANCE_SHADE*/
-        ;
-
-    previewSizeLutMax     = 0;
-    pictureSizeLutMax     = 0;
-    videoSizeLutMax       = 0;
-    previewSizeLut        = NULL;
-    pictureSizeLut        = NULL;
-    videoSizeLut          = NULL;
-    videoSizeLutHighSpeed = NULL;
-    sizeTableSupport      = false;
-
-    /* vendor specifics */
-    /*
-    burstPanoramaW = 3264;
-    burstPanoramaH = 1836;
-    highSpeedRecording60WFHD = 1920;
-    highSpeedRecording60HFHD = 1080;
-    highSpeedRecording60W = 1008;
-    highSpeedRecording60H = 566;
-    highSpeedRecording120W = 1008;
-    highSpeedRecording120H = 566;
-    scalableSensorSupport = true;
-    */
-    bnsSupport = false;
-};
-
-ExynosSensorIMX175::ExynosSensorIMX175()
-{
-    maxPreviewW = 1920;
-    maxPreviewH = 1080;
-    maxPictureW = 3264;
-    maxPictureH = 2448;
-    maxVideoW = 1920;
-    maxVideoH = 1080;
-    maxSensorW = 3264;
-    maxSensorH = 2448;
-
-    maxThumbnailW = 512;
-    maxThumbnailH = 384;
-
-    fNumberNum = 26;
-    fNumberDen = 10;
-    focalLengthNum = 370;
-    focalLengthDen = 100;
-    focusDistanceNum = 0;
-    focusDistanceDen = 0;
-    apertureNum = 276;
-    apertureDen = 100;
-    horizontalViewAngle = 51.2f;
-    verticalViewAngle = 39.4f;
-    focalLengthIn35mmLength = 31;
-
-    minFps = 1;
-    maxFps = 30;
-
-    minExposureCompensation = -4;
-    maxExposureCompensation = 4;
-    exposureCompensationStep = 0.5f;
-    maxNumDetectedFaces = 16;
-    maxNumFocusAreas = 2;
-    maxNumMeteringAreas = 32;
-    maxZoomLevel = ZOOM_LEVEL_MAX;
-    maxZoomRatio = 400;
-
-    zoomSupport = true;
-    smoothZoomSupport = false;
-    videoSnapshotSupport = true;
-    videoStabilizationSupport = false;
-    autoWhiteBalanceLockSupport = true;
-    autoExposureLockSupport = true;
-
-    antiBandingList =
-        ANTIBANDING_AUTO
-        | ANTIBANDING_50HZ
-        | ANTIBANDING_60HZ
-        | ANTIBANDING_OFF
-        ;
-
-    effectList =
-        EFFECT_NONE
-        | EFFECT_MONO
-        | EFFECT_NEGATIVE
-        /*| EFFECT_SOLARIZE*/
-        | EFFECT_SEPIA
-        | EFFECT_POSTERIZE
-        /*| EFFECT_WHITEBOARD*/
-        /*| EFFECT_BLACKBOARD*/
-        | EFFECT_AQUA
-        ;
-
-    flashModeList =
-        FLASH_MODE_OFF
-        | FLASH_MODE_AUTO
-        | FLASH_MODE_ON
-        /*| FLASH_MODE_RED_EYE*/
-        | FLASH_MODE_TORCH;
-
-    focusModeList =
-        FOCUS_MODE_AUTO
-        /*| FOCUS_MODE_INFINITY*/
-        | FOCUS_MODE_MACRO
-        /*| FOCUS_MODE_FIXED*/
-        /*| FOCUS_MODE_EDOF*/
-        | FOCUS_MODE_CONTINUOUS_VIDEO
-        | FOCUS_MODE_CONTINUOUS_PICTURE
-        | FOCUS_MODE_TOUCH;
-
-    sceneModeList =
-        SCENE_MODE_AUTO
-        | SCENE_MODE_ACTION
-        | SCENE_MODE_PORTRAIT
-        | SCENE_MODE_LANDSCAPE
-        | SCENE_MODE_NIGHT
-        | SCENE_MODE_NIGHT_PORTRAIT
-        | SCENE_MODE_THEATRE
-        | SCENE_MODE_BEACH
-        | SCENE_MODE_SNOW
-        | SCENE_MODE_SUNSET
-        | SCENE_MODE_STEADYPHOTO
-        | SCENE_MODE_FIREWORKS
-        | SCENE_MODE_SPORTS
-        | SCENE_MODE_PARTY
-        | SCENE_MODE_CANDLELIGHT;
-
-    whiteBalanceList =
-        WHITE_BALANCE_AUTO
-        | WHITE_BALANCE_INCANDESCENT
-        | WHITE_BALANCE_FLUORESCENT
-        /*| WHITE_BALANCE_WARM_FLUORESCENT*/
-        | WHITE_BALANCE_DAYLIGHT
-        | WHITE_BALANCE_CLOUDY_DAYLIGHT
-        /*| WHITE_BALANCE_TWILIGHT*/
-        /*| WHITE_BALANCE_SHADE*/
-        ;
-
-    /* vendor specifics */
-    /*
-       burstPanoramaW = 3264;
-       burstPanoramaH = 1836;
-       highSpeedRecording60WFHD = 1920;
-       highSpeedRecording60HFHD = 1080;
-       highSpeedRecording60W = 1008;
-       highSpeedRecording60H = 566;
-       highSpeedRecording120W = 1008;
-       highSpeedRecording120H = 566;
-       scalableSensorSupport = true;
-     */
-    bnsSupport = false;
-
-    if (bnsSupport == true) {
-        previewSizeLutMax     = 0;
-        pictureSizeLutMax     = 0;
-        videoSizeLutMax       = 0;
-        previewSizeLut        = NULL;
-        pictureSizeLut        = NULL;
-        videoSizeLut          = NULL;
-        videoSizeLutHighSpeed = NULL;
-        sizeTableSupport      = false;
-    } else {
-        previewSizeLutMax     = sizeof(PREVIEW_SIZE_LUT_IMX175) / (sizeof(int) * SIZE_OF_LUT);
-        videoSizeLutMax       = sizeof(VIDEO_SIZE_LUT_IMX175)   / (sizeof(int) * SIZE_OF_LUT);
-        pictureSizeLutMax     = sizeof(PICTURE_SIZE_LUT_IMX175) / (sizeof(int) * SIZE_OF_LUT);
-        previewSizeLut        = PREVIEW_SIZE_LUT_IMX175;
-        videoSizeLut          = VIDEO_SIZE_LUT_IMX175;
-        pictureSizeLut        = PICTURE_SIZE_LUT_IMX175;
-        videoSizeLutHighSpeed = VIDEO_SIZE_LUT_HIGH_SPEED_IMX175;
-        sizeTableSupport      = true;
-    }
-};
-
-ExynosSensorS5K8B1::ExynosSensorS5K8B1()
-{
-    maxPreviewW = 1920;
-    maxPreviewH = 1080;
-    maxPictureW = 1920;
-    maxPictureH = 1080;
-    maxVideoW = 1920;
-    maxVideoH = 1080;
-    maxSensorW = 1920;
-    maxSensorH = 1080;
-    maxThumbnailW = 512;
-    maxThumbnailH = 384;
-
-    fNumberNum = 22;
-    fNumberDen = 10;
-    focalLengthNum = 420;
-    focalLengthDen = 100;
-    focusDistanceNum = 0;
-    focusDistanceDen = 0;
-    apertureNum = 227;
-    apertureDen = 100;
-    horizontalViewAngle = 51.2f;
-    verticalViewAngle = 39.4f;
-    focalLengthIn35mmLength = 31;
-
-    minFps = 1;
-    maxFps = 30;
-
-    minExposureCompensation = -4;
-    maxExposureCompensation = 4;
-    exposureCompensationStep = 0.5f;
-    maxNumDetectedFaces = 16;
-    maxNumFocusAreas = 1;
-    maxNumMeteringAreas = 32;
-    maxZoomLevel = ZOOM_LEVEL_MAX;
-    maxZoomRatio = 400;
-
-    zoomSupport = true;
-    smoothZoomSupport = false;
-    videoSnapshotSupport = true;
-    videoStabilizationSupport = true;
-    autoWhiteBalanceLockSupport = true;
-    autoExposureLockSupport = true;
-
-    antiBandingList =
-          ANTIBANDING_AUTO
-        | ANTIBANDING_50HZ
-        | ANTIBANDING_60HZ
-        | ANTIBANDING_OFF
-        ;
-
-    effectList =
-          EFFECT_NONE
-        | EFFECT_MONO
-        | EFFECT_NEGATIVE
-        /*| EFFECT_SOLARIZE*/
-        | EFFECT_SEPIA
-        | EFFECT_POSTERIZE
-        /*| EFFECT_WHITEBOARD*/
-        /*| EFFECT_BLACKBOARD*/
-        | EFFECT_AQUA
-        ;
-
-    flashModeList =
-          FLASH_MODE_OFF
-        /*| FLASH_MODE_AUTO*/
-        /*| FLASH_MODE_ON*/
-        /*| FLASH_MODE_RED_EYE*/
-        /*| FLASH_MODE_TORCH*/
-        ;
-
-    focusModeList =
-        /* FOCUS_MODE_AUTO*/
-        FOCUS_MODE_INFINITY
-        /*| FOCUS_MODE_MACRO*/
-        /*| FOCUS_MODE_FIXED*/
-        /*| FOCUS_MODE_EDOF*/
-        /*| FOCUS_MODE_CONTINUOUS_VIDEO*/
-        /*| FOCUS_MODE_CONTINUOUS_PICTURE*/
-        /*| FOCUS_MODE_TOUCH*/
-        ;
-
-    sceneModeList =
-          SCENE_MODE_AUTO
-        | SCENE_MODE_ACTION
-        | SCENE_MODE_PORTRAIT
-        | SCENE_MODE_LANDSCAPE
-        | SCENE_MODE_NIGHT
-        | SCENE_MODE_NIGHT_PORTRAIT
-        | SCENE_MODE_THEATRE
-        | SCENE_MODE_BEACH
-        | SCENE_MODE_SNOW
-        | SCENE_MODE_SUNSET
-        | SCENE_MODE_STEADYPHOTO
-        | SCENE_MODE_FIREWORKS
-        | SCENE_MODE_SPORTS
-        | SCENE_MODE_PARTY
-        | SCENE_MODE_CANDLELIGHT;
-
-    whiteBalanceList =
-          WHITE_BALANCE_AUTO
-        | WHITE_BALANCE_INCANDESCENT
-        | WHITE_BALANCE_FLUORESCENT
-        /* WHITE_BALANCE_WARM_FLUORESCENT*/
-        | WHITE_BALANCE_DAYLIGHT
-        | WHITE_BALANCE_CLOUDY_DAYLIGHT
-        /* WHITE_BALANCE_TWILIGHT*/
-        /* WHITE_BALANCE_SHADE*/
-        ;
-
-    previewSizeLutMax     = 0;
-    pictureSizeLutMax     = 0;
-    videoSizeLutMax       = 0;
-    previewSizeLut        = NULL;
-    pictureSizeLut        = NULL;
-    videoSizeLut          = NULL;
-    videoSizeLutHighSpeed = NULL;
-    sizeTableSupport      = false;
-
-    /* vendor specifics */
-    highResolutionCallbackW = 3264;
-    highResolutionCallbackH = 1836;
-    highSpeedRecording60WFHD = 1920;
-    highSpeedRecording60HFHD = 1080;
-    highSpeedRecording60W = 1008;
-    highSpeedRecording60H = 566;
-    highSpeedRecording120W = 1008;
-    highSpeedRecording120H = 566;
-    scalableSensorSupport = true;
-    bnsSupport = false;
-};
-
 }; /* namespace android */
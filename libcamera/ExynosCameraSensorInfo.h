@@ -206,11 +206,14 @@ public:
     int     previewSizeLutMax;
     int     pictureSizeLutMax;
     int     videoSizeLutMax;
+    int     videoSizeLutHighSpeedMax;
     int     (*previewSizeLut)[SIZE_OF_LUT];
     int     (*pictureSizeLut)[SIZE_OF_LUT];
     int     (*videoSizeLut)[SIZE_OF_LUT];
     int     (*videoSizeLutHighSpeed)[SIZE_OF_LUT];
     bool    sizeTableSupport;
+    /* Sensor table row this instance was built from, -1 if none */
+    int     sensorTableIndex;
 
     /* vendor specifics */
     int     highResolutionCallbackW;
@@ -227,63 +230,10 @@ public:
     ExynosSensorInfo();
 };
 
-struct ExynosSensorIMX135 : public ExynosSensorInfo {
-public:
-    ExynosSensorIMX135();
-};
-
-struct ExynosSensorIMX134 : public ExynosSensorInfo {
-public:
-    ExynosSensorIMX134();
-};
-
-struct ExynosSensorS5K3L2 : public ExynosSensorInfo {
-public:
-    ExynosSensorS5K3L2();
-};
-
-struct ExynosSensorS5K2P2 : public ExynosSensorInfo {
-public:
-    ExynosSensorS5K2P2();
-};
-
-struct ExynosSensorS5K6B2 : public ExynosSensorInfo {
-public:
-    ExynosSensorS5K6B2();
-};
-
-struct ExynosSensorS5K3H7 : public ExynosSensorInfo {
-public:
-    ExynosSensorS5K3H7();
-};
-
-struct ExynosSensorS5K3H5 : public ExynosSensorInfo {
-public:
-    ExynosSensorS5K3H5();
-};
-
-struct ExynosSensorS5K4H5 : public ExynosSensorInfo {
-public:
-    ExynosSensorS5K4H5();
-};
-
-struct ExynosSensorS5K6A3 : public ExynosSensorInfo {
-public:
-    ExynosSensorS5K6A3();
-};
-
-struct ExynosSensorIMX175 : public ExynosSensorInfo {
-public:
-    ExynosSensorIMX175();
-};
-
-struct ExynosSensorS5K8B1 : public ExynosSensorInfo {
-public:
-    ExynosSensorS5K8B1();
-};
-
 /* Helpper functions */
-struct ExynosSensorInfo *createSensorInfo(int sensorName);
+const struct ExynosSensorInfo *getSensorInfo(int camId);
+const struct ExynosSensorInfo *getSensorInfoByName(int sensorName);
+struct ExynosSensorInfo *createSensorInfo(int camId);
 int getSensorId(int camId);
 
 bool needGSCForCapture(int camId);
@@ -0,0 +1,246 @@
+/*
+**
+** Copyright 2013, Samsung Electronics Co. LTD
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/*#define LOG_NDEBUG 0 */
+#define LOG_TAG "ExynosCameraSizeSolver"
+#include <cutils/log.h>
+#include <utils/KeyedVector.h>
+#include <utils/Mutex.h>
+
+#include "ExynosCameraSizeSolver.h"
+
+namespace android {
+
+#define SIZE_SOLVER_CACHE_MAX   (256)
+
+static const int SIZE_RATIO_LIST[][3] =
+{
+    { SIZE_RATIO_16_9, 16, 9 },
+    { SIZE_RATIO_4_3,   4, 3 },
+    { SIZE_RATIO_1_1,   1, 1 },
+    { SIZE_RATIO_3_2,   3, 2 },
+    { SIZE_RATIO_5_3,   5, 3 },
+    { SIZE_RATIO_11_9, 11, 9 },
+};
+
+/* Memoised getSizeConfig() results */
+static KeyedVector<uint64_t, ExynosCameraSizeConfig> g_sizeConfigCache;
+static Mutex g_sizeConfigLock;
+
+int getSizeRatioId(int w, int h)
+{
+    int bestId = -1;
+    float bestDiff = 0.0f;
+
+    if (w <= 0 || h <= 0)
+        return -1;
+
+    /* Tolerate sizes like 2592x1936 that are not exactly on the ratio */
+    for (size_t i = 0; i < sizeof(SIZE_RATIO_LIST) / sizeof(SIZE_RATIO_LIST[0]); i++) {
+        float diff = (float)w / h - (float)SIZE_RATIO_LIST[i][1] / SIZE_RATIO_LIST[i][2];
+        if (diff < 0)
+            diff = -diff;
+        if (bestId < 0 || diff < bestDiff) {
+            bestId = SIZE_RATIO_LIST[i][0];
+            bestDiff = diff;
+        }
+    }
+
+    return (bestDiff < 0.02f) ? bestId : -1;
+}
+
+static int (*getSizeLut(const struct ExynosSensorInfo *info, int mode, bool highSpeed, int *lutMax))[SIZE_OF_LUT]
+{
+    switch (mode) {
+    case MODE_PREVIEW:
+        *lutMax = info->previewSizeLutMax;
+        return info->previewSizeLut;
+    case MODE_PICTURE:
+        *lutMax = info->pictureSizeLutMax;
+        return info->pictureSizeLut;
+    case MODE_VIDEO:
+        if (highSpeed) {
+            *lutMax = info->videoSizeLutHighSpeedMax;
+            return info->videoSizeLutHighSpeed;
+        }
+        *lutMax = info->videoSizeLutMax;
+        return info->videoSizeLut;
+    default:
+        *lutMax = 0;
+        return NULL;
+    }
+}
+
+/*
+ * Exact cache key: sensor table index, mode, high speed flag and the target
+ * size packed into disjoint bit fields. Returns false for requests that do
+ * not fit, those are solved without the cache.
+ */
+static bool sizeConfigKey(const struct ExynosSensorInfo *info, int mode, bool highSpeed,
+                          int w, int h, uint64_t *key)
+{
+    int sensorIndex = info->sensorTableIndex;
+
+    if (sensorIndex < 0 || sensorIndex > 0xffff
+        || mode < 0 || mode > 0x7f
+        || w < 0 || w > 0xffff || h < 0 || h > 0xffff)
+        return false;
+
+    *key = ((uint64_t)sensorIndex << 40)
+         | ((uint64_t)mode << 33)
+         | ((uint64_t)(highSpeed ? 1 : 0) << 32)
+         | ((uint64_t)w << 16)
+         | (uint64_t)h;
+
+    return true;
+}
+
+status_t getSizeConfig(const struct ExynosSensorInfo *info, int mode, bool highSpeed,
+                       int w, int h, struct ExynosCameraSizeConfig *config)
+{
+    int (*lut)[SIZE_OF_LUT];
+    int lutMax = 0;
+    int ratioId;
+    int best = -1;
+    uint64_t key = 0;
+    bool cacheable;
+
+    if (info == NULL || config == NULL)
+        return BAD_VALUE;
+
+    cacheable = sizeConfigKey(info, mode, highSpeed, w, h, &key);
+
+    if (cacheable) {
+        Mutex::Autolock lock(g_sizeConfigLock);
+        ssize_t index = g_sizeConfigCache.indexOfKey(key);
+        if (index >= 0) {
+            *config = g_sizeConfigCache.valueAt(index);
+            return NO_ERROR;
+        }
+    }
+
+    lut = getSizeLut(info, mode, highSpeed, &lutMax);
+    if (info->sizeTableSupport == false || lut == NULL || lutMax <= 0) {
+        ALOGV("DEBUG(%s[%d]): no size LUT for mode %d", __FUNCTION__, __LINE__, mode);
+        return NAME_NOT_FOUND;
+    }
+
+    ratioId = getSizeRatioId(w, h);
+    if (ratioId < 0) {
+        ALOGE("ERR(%s[%d]): no ratio for %dx%d", __FUNCTION__, __LINE__, w, h);
+        return BAD_VALUE;
+    }
+
+    /*
+     * Among the rows of this ratio take the smallest target that still
+     * covers the request, or the largest one if none does.
+     */
+    for (int i = 0; i < lutMax; i++) {
+        if (lut[i][RATIO_ID] != ratioId)
+            continue;
+
+        if (best < 0) {
+            best = i;
+            continue;
+        }
+
+        bool covers = (lut[i][TARGET_W] >= w && lut[i][TARGET_H] >= h);
+        bool bestCovers = (lut[best][TARGET_W] >= w && lut[best][TARGET_H] >= h);
+        int area = lut[i][TARGET_W] * lut[i][TARGET_H];
+        int bestArea = lut[best][TARGET_W] * lut[best][TARGET_H];
+
+        if ((covers && (!bestCovers || area < bestArea))
+            || (!covers && !bestCovers && area > bestArea))
+            best = i;
+    }
+
+    if (best < 0) {
+        ALOGE("ERR(%s[%d]): ratio %d not in mode %d LUT", __FUNCTION__, __LINE__, ratioId, mode);
+        return NAME_NOT_FOUND;
+    }
+
+    config->ratioId    = ratioId;
+    config->sensorW    = lut[best][SENSOR_W];
+    config->sensorH    = lut[best][SENSOR_H];
+    config->bnsW       = lut[best][BNS_W];
+    config->bnsH       = lut[best][BNS_H];
+    config->bayerCropW = lut[best][BCROP_W];
+    config->bayerCropH = lut[best][BCROP_H];
+    config->bayerCropX = ROUND_UP((config->bnsW - config->bayerCropW) / 2, 2);
+    config->bayerCropY = ROUND_UP((config->bnsH - config->bayerCropH) / 2, 2);
+    config->bdsW       = lut[best][BDS_W];
+    config->bdsH       = lut[best][BDS_H];
+    config->targetW    = lut[best][TARGET_W];
+    config->targetH    = lut[best][TARGET_H];
+
+    if (cacheable == false)
+        return NO_ERROR;
+
+    Mutex::Autolock lock(g_sizeConfigLock);
+    if (g_sizeConfigCache.size() >= SIZE_SOLVER_CACHE_MAX)
+        g_sizeConfigCache.clear();
+    g_sizeConfigCache.add(key, *config);
+
+    return NO_ERROR;
+}
+
+status_t solveSizeConfig(const struct ExynosSensorInfo *info, struct exynos_camera_info *cameraInfo)
+{
+    struct ExynosCameraSizeConfig previewConfig;
+    struct ExynosCameraSizeConfig pictureConfig;
+    struct ExynosCameraSizeConfig videoConfig;
+    struct ExynosCameraSizeConfig *sensorConfig;
+    bool recording = cameraInfo->recordingHint;
+    bool highSpeed = cameraInfo->highSpeedRecording;
+    status_t ret;
+
+    ret = getSizeConfig(info, MODE_PREVIEW, false,
+                        cameraInfo->previewW, cameraInfo->previewH, &previewConfig);
+    if (ret != NO_ERROR)
+        return ret;
+
+    ret = getSizeConfig(info, MODE_PICTURE, false,
+                        cameraInfo->pictureW, cameraInfo->pictureH, &pictureConfig);
+    if (ret != NO_ERROR)
+        return ret;
+
+    sensorConfig = &previewConfig;
+    if (recording) {
+        ret = getSizeConfig(info, MODE_VIDEO, highSpeed,
+                            cameraInfo->videoW, cameraInfo->videoH, &videoConfig);
+        if (ret != NO_ERROR)
+            return ret;
+        cameraInfo->videoSizeRatioId = videoConfig.ratioId;
+        sensorConfig = &videoConfig;
+    }
+
+    cameraInfo->previewSizeRatioId = previewConfig.ratioId;
+    cameraInfo->pictureSizeRatioId = pictureConfig.ratioId;
+
+    cameraInfo->hwSensorW    = sensorConfig->sensorW;
+    cameraInfo->hwSensorH    = sensorConfig->sensorH;
+    cameraInfo->bnsW         = sensorConfig->bnsW;
+    cameraInfo->bnsH         = sensorConfig->bnsH;
+    cameraInfo->hwBayerCropW = sensorConfig->bayerCropW;
+    cameraInfo->hwBayerCropH = sensorConfig->bayerCropH;
+    cameraInfo->hwBayerCropX = sensorConfig->bayerCropX;
+    cameraInfo->hwBayerCropY = sensorConfig->bayerCropY;
+
+    return NO_ERROR;
+}
+
+}; /* namespace android */
@@ -0,0 +1,64 @@
+/*
+**
+** Copyright 2013, Samsung Electronics Co. LTD
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef EXYNOS_CAMERA_SIZE_SOLVER_H
+#define EXYNOS_CAMERA_SIZE_SOLVER_H
+
+#include <utils/Errors.h>
+#include "ExynosCameraSensorInfo.h"
+
+namespace android {
+
+/* One size LUT row, resolved for a (sensor, mode, target size) */
+struct ExynosCameraSizeConfig {
+    int     ratioId;
+    int     sensorW;
+    int     sensorH;
+    int     bnsW;
+    int     bnsH;
+    int     bayerCropW;
+    int     bayerCropH;
+    int     bayerCropX;
+    int     bayerCropY;
+    int     bdsW;
+    int     bdsH;
+    int     targetW;
+    int     targetH;
+};
+
+/* Returns the SIZE_RATIO_* id matching w:h, or -1 */
+int getSizeRatioId(int w, int h);
+
+/*
+ * Picks the size LUT row of the given mode (MODE_PREVIEW, MODE_PICTURE or
+ * MODE_VIDEO; highSpeed selects videoSizeLutHighSpeed) for a target size.
+ * Results are memoised per (sensor table row, mode, size), so shared
+ * instances and createSensorInfo() copies of a sensor share cache entries.
+ */
+status_t getSizeConfig(const struct ExynosSensorInfo *info, int mode, bool highSpeed,
+                       int w, int h, struct ExynosCameraSizeConfig *config);
+
+/*
+ * Resolves the whole preview + picture + video configuration of cameraInfo
+ * in one call: fills the *SizeRatioId, hwSensor, bns and hwBayerCrop fields.
+ * The sensor side follows the video LUT while recording, the preview LUT
+ * otherwise.
+ */
+status_t solveSizeConfig(const struct ExynosSensorInfo *info, struct exynos_camera_info *cameraInfo);
+
+}; /* namespace android */
+#endif
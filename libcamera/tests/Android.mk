@@ -0,0 +1,80 @@
+# Copyright (C) 2012 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+
+LOCAL_PATH:= $(call my-dir)
+
+#################
+# libexynoscamera host tests
+
+include $(CLEAR_VARS)
+
+LOCAL_SHARED_LIBRARIES:= libutils libcutils liblog
+
+LOCAL_CFLAGS += -DMAIN_CAMERA_SENSOR_NAME=$(BOARD_BACK_CAMERA_SENSOR)
+LOCAL_CFLAGS += -DFRONT_CAMERA_SENSOR_NAME=$(BOARD_FRONT_CAMERA_SENSOR)
+
+LOCAL_C_INCLUDES += \
+	$(LOCAL_PATH) \
+	$(LOCAL_PATH)/.. \
+	$(LOCAL_PATH)/../Vendor \
+	$(LOCAL_PATH)/../../include \
+	$(TOP)/hardware/samsung_slsi-cm/exynos/libcamera/54xx \
+	$(TOP)/hardware/samsung_slsi-cm/exynos/libcamera/common \
+	$(TOP)/hardware/samsung_slsi-cm/exynos/include \
+	$(TOP)/hardware/samsung_slsi-cm/$(TARGET_SOC)/include \
+	$(TOP)/hardware/samsung_slsi-cm/$(TARGET_BOARD_PLATFORM)/include
+
+LOCAL_SRC_FILES:= \
+	../ExynosCameraSensorInfo.cpp \
+	../ExynosCameraSizeSolver.cpp \
+	ExynosCameraSensorInfo_test.cpp \
+	ExynosCameraSizeSolver_test.cpp
+
+LOCAL_MODULE_TAGS := tests
+LOCAL_MODULE := libexynoscamera_tests
+
+include $(BUILD_HOST_NATIVE_TEST)
+
+#################
+# sensor ID cache host test, probes through a fake getSensorIdFromFile()
+
+include $(CLEAR_VARS)
+
+LOCAL_SHARED_LIBRARIES:= libutils libcutils liblog
+
+LOCAL_CFLAGS += -DMAIN_CAMERA_SENSOR_NAME=$(BOARD_BACK_CAMERA_SENSOR)
+LOCAL_CFLAGS += -DFRONT_CAMERA_SENSOR_NAME=$(BOARD_FRONT_CAMERA_SENSOR)
+LOCAL_CFLAGS += -DSENSOR_NAME_GET_FROM_FILE
+LOCAL_CFLAGS += -DSENSOR_ID_CACHE_PATH=\"/tmp/exynoscamera_sensor_id_cache\"
+
+LOCAL_C_INCLUDES += \
+	$(LOCAL_PATH) \
+	$(LOCAL_PATH)/.. \
+	$(LOCAL_PATH)/../Vendor \
+	$(LOCAL_PATH)/../../include \
+	$(TOP)/hardware/samsung_slsi-cm/exynos/libcamera/54xx \
+	$(TOP)/hardware/samsung_slsi-cm/exynos/libcamera/common \
+	$(TOP)/hardware/samsung_slsi-cm/exynos/include \
+	$(TOP)/hardware/samsung_slsi-cm/$(TARGET_SOC)/include \
+	$(TOP)/hardware/samsung_slsi-cm/$(TARGET_BOARD_PLATFORM)/include
+
+LOCAL_SRC_FILES:= \
+	../ExynosCameraSensorInfo.cpp \
+	ExynosCameraSensorId_test.cpp
+
+LOCAL_MODULE_TAGS := tests
+LOCAL_MODULE := libexynoscamera_sensorid_tests
+
+include $(BUILD_HOST_NATIVE_TEST)
@@ -0,0 +1,149 @@
+/*
+**
+** Copyright 2013, Samsung Electronics Co. LTD
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <gtest/gtest.h>
+
+#include "ExynosCameraSensorInfo.h"
+
+namespace android {
+
+extern int g_rearSensorId;
+extern int g_frontSensorId;
+
+static int g_probeCount;
+static int g_probeResult[CAMERA_ID_MAX];
+
+/* Stands in for the board specific sysfs probe */
+int getSensorIdFromFile(int camId)
+{
+    g_probeCount++;
+    return g_probeResult[camId];
+}
+
+}; /* namespace android */
+
+using namespace android;
+
+class ExynosCameraSensorIdCache : public testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        unlink(SENSOR_ID_CACHE_PATH);
+        g_probeResult[CAMERA_ID_BACK] = SENSOR_NAME_S5K2P2;
+        g_probeResult[CAMERA_ID_FRONT] = SENSOR_NAME_S5K6B2;
+        restart();
+    }
+
+    virtual void TearDown()
+    {
+        unlink(SENSOR_ID_CACHE_PATH);
+    }
+
+    /* What a new cameraserver process starts with */
+    void restart()
+    {
+        g_rearSensorId = -1;
+        g_frontSensorId = -1;
+        g_probeCount = 0;
+    }
+
+    void flipCacheByte(off_t offset)
+    {
+        int fd = open(SENSOR_ID_CACHE_PATH, O_RDWR);
+        unsigned char byte;
+
+        ASSERT_GE(fd, 0);
+        ASSERT_EQ(1, pread(fd, &byte, 1, offset));
+        byte ^= 0x01;
+        ASSERT_EQ(1, pwrite(fd, &byte, 1, offset));
+        close(fd);
+    }
+};
+
+TEST_F(ExynosCameraSensorIdCache, ColdOpenProbesAndWarmOpenDoesNot)
+{
+    EXPECT_EQ(SENSOR_NAME_S5K2P2, getSensorId(CAMERA_ID_BACK));
+    EXPECT_EQ(SENSOR_NAME_S5K6B2, getSensorId(CAMERA_ID_FRONT));
+    EXPECT_EQ(2, g_probeCount);
+    ASSERT_EQ(0, access(SENSOR_ID_CACHE_PATH, F_OK));
+
+    restart();
+    EXPECT_EQ(SENSOR_NAME_S5K2P2, getSensorId(CAMERA_ID_BACK));
+    EXPECT_EQ(SENSOR_NAME_S5K6B2, getSensorId(CAMERA_ID_FRONT));
+    EXPECT_EQ(0, g_probeCount);
+}
+
+TEST_F(ExynosCameraSensorIdCache, CorruptCacheIsProbedAgain)
+{
+    EXPECT_EQ(SENSOR_NAME_S5K2P2, getSensorId(CAMERA_ID_BACK));
+
+    restart();
+    flipCacheByte(sizeof(uint32_t) * 2);
+    EXPECT_EQ(SENSOR_NAME_S5K2P2, getSensorId(CAMERA_ID_BACK));
+    EXPECT_EQ(1, g_probeCount);
+
+    /* The probe rewrote a valid cache */
+    restart();
+    EXPECT_EQ(SENSOR_NAME_S5K2P2, getSensorId(CAMERA_ID_BACK));
+    EXPECT_EQ(0, g_probeCount);
+}
+
+TEST_F(ExynosCameraSensorIdCache, TruncatedCacheIsProbedAgain)
+{
+    EXPECT_EQ(SENSOR_NAME_S5K2P2, getSensorId(CAMERA_ID_BACK));
+    ASSERT_EQ(0, truncate(SENSOR_ID_CACHE_PATH, 16));
+
+    restart();
+    EXPECT_EQ(SENSOR_NAME_S5K2P2, getSensorId(CAMERA_ID_BACK));
+    EXPECT_EQ(1, g_probeCount);
+}
+
+TEST_F(ExynosCameraSensorIdCache, SensorsWithoutCapabilitiesAreNotCached)
+{
+    /* S5K1P2 has no sensor table row */
+    g_probeResult[CAMERA_ID_BACK] = SENSOR_NAME_S5K1P2;
+    EXPECT_EQ(SENSOR_NAME_S5K1P2, getSensorId(CAMERA_ID_BACK));
+
+    restart();
+    EXPECT_EQ(SENSOR_NAME_S5K1P2, getSensorId(CAMERA_ID_BACK));
+    EXPECT_EQ(1, g_probeCount);
+}
+
+TEST_F(ExynosCameraSensorIdCache, FailedProbeIsNotCached)
+{
+    g_probeResult[CAMERA_ID_BACK] = -1;
+    EXPECT_GT(0, getSensorId(CAMERA_ID_BACK));
+
+    restart();
+    g_probeResult[CAMERA_ID_BACK] = SENSOR_NAME_S5K3L2;
+    EXPECT_EQ(SENSOR_NAME_S5K3L2, getSensorId(CAMERA_ID_BACK));
+    EXPECT_EQ(1, g_probeCount);
+}
+
+/* A cached camera entry survives the other camera being probed */
+TEST_F(ExynosCameraSensorIdCache, CamerasAreCachedIndependently)
+{
+    EXPECT_EQ(SENSOR_NAME_S5K2P2, getSensorId(CAMERA_ID_BACK));
+
+    restart();
+    EXPECT_EQ(SENSOR_NAME_S5K6B2, getSensorId(CAMERA_ID_FRONT));
+    EXPECT_EQ(SENSOR_NAME_S5K2P2, getSensorId(CAMERA_ID_BACK));
+    EXPECT_EQ(1, g_probeCount);
+}
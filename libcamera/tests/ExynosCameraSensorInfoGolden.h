@@ -0,0 +1,815 @@
+/*
+**
+** Copyright 2013, Samsung Electronics Co. LTD
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/*
+ * Every ExynosSensorInfo field as the per-sensor ExynosSensorInfo subclasses
+ * set it, before they were replaced by SENSOR_INFO_TABLE. The size LUTs
+ * are listed apart and compared by content, since every user of
+ * ExynosCameraSizeTable.h gets its own copy of the tables.
+ */
+
+#ifndef EXYNOS_CAMERA_SENSOR_INFO_GOLDEN_H
+#define EXYNOS_CAMERA_SENSOR_INFO_GOLDEN_H
+
+#define GOLDEN_SIZE_LUT(lut)    lut, (int)(sizeof(lut) / (sizeof(int) * SIZE_OF_LUT))
+
+struct sensor_info_golden {
+    int         sensorName;
+    int         (*previewSizeLut)[SIZE_OF_LUT];
+    int         previewSizeLutMax;
+    int         (*pictureSizeLut)[SIZE_OF_LUT];
+    int         pictureSizeLutMax;
+    int         (*videoSizeLut)[SIZE_OF_LUT];
+    int         videoSizeLutMax;
+    int         (*videoSizeLutHighSpeed)[SIZE_OF_LUT];
+    int         videoSizeLutHighSpeedMax;
+    /* Every other field, one "name=value" line each */
+    const char  *dump;
+};
+
+static const struct sensor_info_golden SENSOR_INFO_GOLDEN[] =
+{
+    { SENSOR_NAME_IMX135,
+      NULL, 0,
+      NULL, 0,
+      NULL, 0,
+      NULL, 0,
+      "maxPreviewW=1920\n"
+      "maxPreviewH=1080\n"
+      "maxPictureW=4128\n"
+      "maxPictureH=3096\n"
+      "maxVideoW=1920\n"
+      "maxVideoH=1080\n"
+      "maxSensorW=4128\n"
+      "maxSensorH=3096\n"
+      "maxThumbnailW=512\n"
+      "maxThumbnailH=384\n"
+      "fNumberNum=22\n"
+      "fNumberDen=10\n"
+      "focalLengthNum=420\n"
+      "focalLengthDen=100\n"
+      "focusDistanceNum=0\n"
+      "focusDistanceDen=0\n"
+      "apertureNum=227\n"
+      "apertureDen=100\n"
+      "horizontalViewAngle=51.2\n"
+      "verticalViewAngle=39.4\n"
+      "focalLengthIn35mmLength=31\n"
+      "minFps=1\n"
+      "maxFps=30\n"
+      "minExposureCompensation=-4\n"
+      "maxExposureCompensation=4\n"
+      "exposureCompensationStep=0.5\n"
+      "maxNumDetectedFaces=16\n"
+      "maxNumFocusAreas=2\n"
+      "maxNumMeteringAreas=32\n"
+      "maxZoomLevel=31\n"
+      "maxZoomRatio=400\n"
+      "zoomSupport=1\n"
+      "smoothZoomSupport=0\n"
+      "videoSnapshotSupport=1\n"
+      "videoStabilizationSupport=1\n"
+      "autoWhiteBalanceLockSupport=1\n"
+      "autoExposureLockSupport=1\n"
+      "antiBandingList=15\n"
+      "effectList=311\n"
+      "flashModeList=23\n"
+      "focusModeList=229\n"
+      "sceneModeList=32767\n"
+      "whiteBalanceList=55\n"
+      "sizeTableSupport=0\n"
+      "highResolutionCallbackW=3264\n"
+      "highResolutionCallbackH=1836\n"
+      "highSpeedRecording60WFHD=1920\n"
+      "highSpeedRecording60HFHD=1080\n"
+      "highSpeedRecording60W=1008\n"
+      "highSpeedRecording60H=566\n"
+      "highSpeedRecording120W=1008\n"
+      "highSpeedRecording120H=566\n"
+      "scalableSensorSupport=1\n"
+      "bnsSupport=0\n" },
+    { SENSOR_NAME_IMX134,
+      NULL, 0,
+      NULL, 0,
+      NULL, 0,
+      NULL, 0,
+      "maxPreviewW=1920\n"
+      "maxPreviewH=1080\n"
+      "maxPictureW=3264\n"
+      "maxPictureH=2448\n"
+      "maxVideoW=1920\n"
+      "maxVideoH=1080\n"
+      "maxSensorW=3264\n"
+      "maxSensorH=2448\n"
+      "maxThumbnailW=512\n"
+      "maxThumbnailH=384\n"
+      "fNumberNum=22\n"
+      "fNumberDen=10\n"
+      "focalLengthNum=420\n"
+      "focalLengthDen=100\n"
+      "focusDistanceNum=0\n"
+      "focusDistanceDen=0\n"
+      "apertureNum=227\n"
+      "apertureDen=100\n"
+      "horizontalViewAngle=51.2\n"
+      "verticalViewAngle=39.4\n"
+      "focalLengthIn35mmLength=31\n"
+      "minFps=1\n"
+      "maxFps=30\n"
+      "minExposureCompensation=-4\n"
+      "maxExposureCompensation=4\n"
+      "exposureCompensationStep=0.5\n"
+      "maxNumDetectedFaces=16\n"
+      "maxNumFocusAreas=2\n"
+      "maxNumMeteringAreas=32\n"
+      "maxZoomLevel=31\n"
+      "maxZoomRatio=400\n"
+      "zoomSupport=1\n"
+      "smoothZoomSupport=0\n"
+      "videoSnapshotSupport=1\n"
+      "videoStabilizationSupport=0\n"
+      "autoWhiteBalanceLockSupport=0\n"
+      "autoExposureLockSupport=1\n"
+      "antiBandingList=15\n"
+      "effectList=311\n"
+      "flashModeList=23\n"
+      "focusModeList=229\n"
+      "sceneModeList=32767\n"
+      "whiteBalanceList=55\n"
+      "sizeTableSupport=0\n"
+      "highResolutionCallbackW=3264\n"
+      "highResolutionCallbackH=1836\n"
+      "highSpeedRecording60WFHD=1920\n"
+      "highSpeedRecording60HFHD=1080\n"
+      "highSpeedRecording60W=1008\n"
+      "highSpeedRecording60H=566\n"
+      "highSpeedRecording120W=1008\n"
+      "highSpeedRecording120H=566\n"
+      "scalableSensorSupport=1\n"
+      "bnsSupport=0\n" },
+    { SENSOR_NAME_S5K3L2,
+      GOLDEN_SIZE_LUT(PREVIEW_SIZE_LUT_3L2),
+      GOLDEN_SIZE_LUT(PICTURE_SIZE_LUT_3L2),
+      GOLDEN_SIZE_LUT(VIDEO_SIZE_LUT_3L2),
+      GOLDEN_SIZE_LUT(VIDEO_SIZE_LUT_HIGH_SPEED_3L2),
+      "maxPreviewW=1920\n"
+      "maxPreviewH=1080\n"
+      "maxPictureW=4128\n"
+      "maxPictureH=3096\n"
+      "maxVideoW=1920\n"
+      "maxVideoH=1080\n"
+      "maxSensorW=4128\n"
+      "maxSensorH=3096\n"
+      "maxThumbnailW=512\n"
+      "maxThumbnailH=384\n"
+      "fNumberNum=22\n"
+      "fNumberDen=10\n"
+      "focalLengthNum=420\n"
+      "focalLengthDen=100\n"
+      "focusDistanceNum=0\n"
+      "focusDistanceDen=0\n"
+      "apertureNum=227\n"
+      "apertureDen=100\n"
+      "horizontalViewAngle=51.2\n"
+      "verticalViewAngle=39.4\n"
+      "focalLengthIn35mmLength=31\n"
+      "minFps=1\n"
+      "maxFps=30\n"
+      "minExposureCompensation=-4\n"
+      "maxExposureCompensation=4\n"
+      "exposureCompensationStep=0.5\n"
+      "maxNumDetectedFaces=16\n"
+      "maxNumFocusAreas=2\n"
+      "maxNumMeteringAreas=32\n"
+      "maxZoomLevel=31\n"
+      "maxZoomRatio=400\n"
+      "zoomSupport=1\n"
+      "smoothZoomSupport=0\n"
+      "videoSnapshotSupport=1\n"
+      "videoStabilizationSupport=1\n"
+      "autoWhiteBalanceLockSupport=1\n"
+      "autoExposureLockSupport=1\n"
+      "antiBandingList=15\n"
+      "effectList=311\n"
+      "flashModeList=23\n"
+      "focusModeList=229\n"
+      "sceneModeList=32767\n"
+      "whiteBalanceList=55\n"
+      "sizeTableSupport=1\n"
+      "highResolutionCallbackW=3264\n"
+      "highResolutionCallbackH=1836\n"
+      "highSpeedRecording60WFHD=1920\n"
+      "highSpeedRecording60HFHD=1080\n"
+      "highSpeedRecording60W=2056\n"
+      "highSpeedRecording60H=1152\n"
+      "highSpeedRecording120W=1024\n"
+      "highSpeedRecording120H=574\n"
+      "scalableSensorSupport=1\n"
+      "bnsSupport=0\n" },
+    { SENSOR_NAME_S5K2P2,
+      GOLDEN_SIZE_LUT(PREVIEW_SIZE_LUT_2P2_BNS),
+      GOLDEN_SIZE_LUT(PICTURE_SIZE_LUT_2P2),
+      GOLDEN_SIZE_LUT(VIDEO_SIZE_LUT_2P2_BNS),
+      GOLDEN_SIZE_LUT(VIDEO_SIZE_LUT_HIGH_SPEED_2P2_BNS),
+      "maxPreviewW=3840\n"
+      "maxPreviewH=2160\n"
+      "maxPictureW=5312\n"
+      "maxPictureH=2988\n"
+      "maxVideoW=3840\n"
+      "maxVideoH=2160\n"
+      "maxSensorW=5312\n"
+      "maxSensorH=2990\n"
+      "maxThumbnailW=512\n"
+      "maxThumbnailH=384\n"
+      "fNumberNum=22\n"
+      "fNumberDen=10\n"
+      "focalLengthNum=420\n"
+      "focalLengthDen=100\n"
+      "focusDistanceNum=0\n"
+      "focusDistanceDen=0\n"
+      "apertureNum=227\n"
+      "apertureDen=100\n"
+      "horizontalViewAngle=51.2\n"
+      "verticalViewAngle=39.4\n"
+      "focalLengthIn35mmLength=31\n"
+      "minFps=1\n"
+      "maxFps=30\n"
+      "minExposureCompensation=-4\n"
+      "maxExposureCompensation=4\n"
+      "exposureCompensationStep=0.5\n"
+      "maxNumDetectedFaces=16\n"
+      "maxNumFocusAreas=2\n"
+      "maxNumMeteringAreas=32\n"
+      "maxZoomLevel=31\n"
+      "maxZoomRatio=400\n"
+      "zoomSupport=1\n"
+      "smoothZoomSupport=0\n"
+      "videoSnapshotSupport=1\n"
+      "videoStabilizationSupport=1\n"
+      "autoWhiteBalanceLockSupport=1\n"
+      "autoExposureLockSupport=1\n"
+      "antiBandingList=15\n"
+      "effectList=311\n"
+      "flashModeList=23\n"
+      "focusModeList=229\n"
+      "sceneModeList=32767\n"
+      "whiteBalanceList=55\n"
+      "sizeTableSupport=1\n"
+      "highResolutionCallbackW=3264\n"
+      "highResolutionCallbackH=1836\n"
+      "highSpeedRecording60WFHD=1920\n"
+      "highSpeedRecording60HFHD=1080\n"
+      "highSpeedRecording60W=1008\n"
+      "highSpeedRecording60H=566\n"
+      "highSpeedRecording120W=1008\n"
+      "highSpeedRecording120H=566\n"
+      "scalableSensorSupport=1\n"
+      "bnsSupport=1\n" },
+    { SENSOR_NAME_S5K6B2,
+      NULL, 0,
+      NULL, 0,
+      NULL, 0,
+      NULL, 0,
+      "maxPreviewW=1920\n"
+      "maxPreviewH=1080\n"
+      "maxPictureW=1920\n"
+      "maxPictureH=1080\n"
+      "maxVideoW=1920\n"
+      "maxVideoH=1080\n"
+      "maxSensorW=1920\n"
+      "maxSensorH=1080\n"
+      "maxThumbnailW=512\n"
+      "maxThumbnailH=384\n"
+      "fNumberNum=22\n"
+      "fNumberDen=10\n"
+      "focalLengthNum=420\n"
+      "focalLengthDen=100\n"
+      "focusDistanceNum=0\n"
+      "focusDistanceDen=0\n"
+      "apertureNum=227\n"
+      "apertureDen=100\n"
+      "horizontalViewAngle=51.2\n"
+      "verticalViewAngle=39.4\n"
+      "focalLengthIn35mmLength=31\n"
+      "minFps=1\n"
+      "maxFps=30\n"
+      "minExposureCompensation=-4\n"
+      "maxExposureCompensation=4\n"
+      "exposureCompensationStep=0.5\n"
+      "maxNumDetectedFaces=16\n"
+      "maxNumFocusAreas=1\n"
+      "maxNumMeteringAreas=32\n"
+      "maxZoomLevel=31\n"
+      "maxZoomRatio=400\n"
+      "zoomSupport=1\n"
+      "smoothZoomSupport=0\n"
+      "videoSnapshotSupport=1\n"
+      "videoStabilizationSupport=1\n"
+      "autoWhiteBalanceLockSupport=1\n"
+      "autoExposureLockSupport=1\n"
+      "antiBandingList=15\n"
+      "effectList=311\n"
+      "flashModeList=1\n"
+      "focusModeList=2\n"
+      "sceneModeList=32767\n"
+      "whiteBalanceList=55\n"
+      "sizeTableSupport=0\n"
+      "highResolutionCallbackW=3264\n"
+      "highResolutionCallbackH=1836\n"
+      "highSpeedRecording60WFHD=1920\n"
+      "highSpeedRecording60HFHD=1080\n"
+      "highSpeedRecording60W=1008\n"
+      "highSpeedRecording60H=566\n"
+      "highSpeedRecording120W=1008\n"
+      "highSpeedRecording120H=566\n"
+      "scalableSensorSupport=1\n"
+      "bnsSupport=0\n" },
+    { SENSOR_NAME_S5K3H7,
+      GOLDEN_SIZE_LUT(PREVIEW_SIZE_LUT_3H7),
+      GOLDEN_SIZE_LUT(PICTURE_SIZE_LUT_3H7),
+      GOLDEN_SIZE_LUT(VIDEO_SIZE_LUT_3H7),
+      GOLDEN_SIZE_LUT(VIDEO_SIZE_LUT_HIGH_SPEED_3H7),
+      "maxPreviewW=1920\n"
+      "maxPreviewH=1080\n"
+      "maxPictureW=3248\n"
+      "maxPictureH=2438\n"
+      "maxVideoW=1920\n"
+      "maxVideoH=1080\n"
+      "maxSensorW=3248\n"
+      "maxSensorH=2438\n"
+      "maxThumbnailW=512\n"
+      "maxThumbnailH=384\n"
+      "fNumberNum=22\n"
+      "fNumberDen=10\n"
+      "focalLengthNum=420\n"
+      "focalLengthDen=100\n"
+      "focusDistanceNum=0\n"
+      "focusDistanceDen=0\n"
+      "apertureNum=227\n"
+      "apertureDen=100\n"
+      "horizontalViewAngle=51.2\n"
+      "verticalViewAngle=39.4\n"
+      "focalLengthIn35mmLength=31\n"
+      "minFps=1\n"
+      "maxFps=30\n"
+      "minExposureCompensation=-4\n"
+      "maxExposureCompensation=4\n"
+      "exposureCompensationStep=0.5\n"
+      "maxNumDetectedFaces=16\n"
+      "maxNumFocusAreas=2\n"
+      "maxNumMeteringAreas=32\n"
+      "maxZoomLevel=31\n"
+      "maxZoomRatio=400\n"
+      "zoomSupport=1\n"
+      "smoothZoomSupport=0\n"
+      "videoSnapshotSupport=1\n"
+      "videoStabilizationSupport=0\n"
+      "autoWhiteBalanceLockSupport=1\n"
+      "autoExposureLockSupport=1\n"
+      "antiBandingList=15\n"
+      "effectList=311\n"
+      "flashModeList=23\n"
+      "focusModeList=229\n"
+      "sceneModeList=32767\n"
+      "whiteBalanceList=55\n"
+      "sizeTableSupport=1\n"
+      "highResolutionCallbackW=3264\n"
+      "highResolutionCallbackH=1836\n"
+      "highSpeedRecording60WFHD=1920\n"
+      "highSpeedRecording60HFHD=1080\n"
+      "highSpeedRecording60W=1008\n"
+      "highSpeedRecording60H=566\n"
+      "highSpeedRecording120W=1008\n"
+      "highSpeedRecording120H=566\n"
+      "scalableSensorSupport=1\n"
+      "bnsSupport=0\n" },
+    { SENSOR_NAME_S5K3H7_SUNNY,
+      GOLDEN_SIZE_LUT(PREVIEW_SIZE_LUT_3H7),
+      GOLDEN_SIZE_LUT(PICTURE_SIZE_LUT_3H7),
+      GOLDEN_SIZE_LUT(VIDEO_SIZE_LUT_3H7),
+      GOLDEN_SIZE_LUT(VIDEO_SIZE_LUT_HIGH_SPEED_3H7),
+      "maxPreviewW=1920\n"
+      "maxPreviewH=1080\n"
+      "maxPictureW=3248\n"
+      "maxPictureH=2438\n"
+      "maxVideoW=1920\n"
+      "maxVideoH=1080\n"
+      "maxSensorW=3248\n"
+      "maxSensorH=2438\n"
+      "maxThumbnailW=512\n"
+      "maxThumbnailH=384\n"
+      "fNumberNum=22\n"
+      "fNumberDen=10\n"
+      "focalLengthNum=420\n"
+      "focalLengthDen=100\n"
+      "focusDistanceNum=0\n"
+      "focusDistanceDen=0\n"
+      "apertureNum=227\n"
+      "apertureDen=100\n"
+      "horizontalViewAngle=51.2\n"
+      "verticalViewAngle=39.4\n"
+      "focalLengthIn35mmLength=31\n"
+      "minFps=1\n"
+      "maxFps=30\n"
+      "minExposureCompensation=-4\n"
+      "maxExposureCompensation=4\n"
+      "exposureCompensationStep=0.5\n"
+      "maxNumDetectedFaces=16\n"
+      "maxNumFocusAreas=2\n"
+      "maxNumMeteringAreas=32\n"
+      "maxZoomLevel=31\n"
+      "maxZoomRatio=400\n"
+      "zoomSupport=1\n"
+      "smoothZoomSupport=0\n"
+      "videoSnapshotSupport=1\n"
+      "videoStabilizationSupport=0\n"
+      "autoWhiteBalanceLockSupport=1\n"
+      "autoExposureLockSupport=1\n"
+      "antiBandingList=15\n"
+      "effectList=311\n"
+      "flashModeList=23\n"
+      "focusModeList=229\n"
+      "sceneModeList=32767\n"
+      "whiteBalanceList=55\n"
+      "sizeTableSupport=1\n"
+      "highResolutionCallbackW=3264\n"
+      "highResolutionCallbackH=1836\n"
+      "highSpeedRecording60WFHD=1920\n"
+      "highSpeedRecording60HFHD=1080\n"
+      "highSpeedRecording60W=1008\n"
+      "highSpeedRecording60H=566\n"
+      "highSpeedRecording120W=1008\n"
+      "highSpeedRecording120H=566\n"
+      "scalableSensorSupport=1\n"
+      "bnsSupport=0\n" },
+    { SENSOR_NAME_S5K3H5,
+      NULL, 0,
+      NULL, 0,
+      NULL, 0,
+      NULL, 0,
+      "maxPreviewW=1920\n"
+      "maxPreviewH=1080\n"
+      "maxPictureW=3248\n"
+      "maxPictureH=2438\n"
+      "maxVideoW=1920\n"
+      "maxVideoH=1080\n"
+      "maxSensorW=3248\n"
+      "maxSensorH=2438\n"
+      "maxThumbnailW=512\n"
+      "maxThumbnailH=384\n"
+      "fNumberNum=22\n"
+      "fNumberDen=10\n"
+      "focalLengthNum=420\n"
+      "focalLengthDen=100\n"
+      "focusDistanceNum=0\n"
+      "focusDistanceDen=0\n"
+      "apertureNum=227\n"
+      "apertureDen=100\n"
+      "horizontalViewAngle=51.2\n"
+      "verticalViewAngle=39.4\n"
+      "focalLengthIn35mmLength=31\n"
+      "minFps=1\n"
+      "maxFps=30\n"
+      "minExposureCompensation=-4\n"
+      "maxExposureCompensation=4\n"
+      "exposureCompensationStep=0.5\n"
+      "maxNumDetectedFaces=16\n"
+      "maxNumFocusAreas=2\n"
+      "maxNumMeteringAreas=32\n"
+      "maxZoomLevel=31\n"
+      "maxZoomRatio=400\n"
+      "zoomSupport=1\n"
+      "smoothZoomSupport=0\n"
+      "videoSnapshotSupport=1\n"
+      "videoStabilizationSupport=0\n"
+      "autoWhiteBalanceLockSupport=1\n"
+      "autoExposureLockSupport=1\n"
+      "antiBandingList=15\n"
+      "effectList=311\n"
+      "flashModeList=23\n"
+      "focusModeList=229\n"
+      "sceneModeList=32767\n"
+      "whiteBalanceList=55\n"
+      "sizeTableSupport=0\n"
+      "highResolutionCallbackW=3264\n"
+      "highResolutionCallbackH=1836\n"
+      "highSpeedRecording60WFHD=1920\n"
+      "highSpeedRecording60HFHD=1080\n"
+      "highSpeedRecording60W=1008\n"
+      "highSpeedRecording60H=566\n"
+      "highSpeedRecording120W=1008\n"
+      "highSpeedRecording120H=566\n"
+      "scalableSensorSupport=1\n"
+      "bnsSupport=0\n" },
+    { SENSOR_NAME_S5K4H5,
+      GOLDEN_SIZE_LUT(PREVIEW_SIZE_LUT_4H5),
+      GOLDEN_SIZE_LUT(PICTURE_SIZE_LUT_4H5),
+      GOLDEN_SIZE_LUT(VIDEO_SIZE_LUT_4H5),
+      GOLDEN_SIZE_LUT(VIDEO_SIZE_LUT_HIGH_SPEED_4H5),
+      "maxPreviewW=1920\n"
+      "maxPreviewH=1080\n"
+      "maxPictureW=3264\n"
+      "maxPictureH=2448\n"
+      "maxVideoW=1920\n"
+      "maxVideoH=1080\n"
+      "maxSensorW=3264\n"
+      "maxSensorH=2448\n"
+      "maxThumbnailW=512\n"
+      "maxThumbnailH=384\n"
+      "fNumberNum=22\n"
+      "fNumberDen=10\n"
+      "focalLengthNum=420\n"
+      "focalLengthDen=100\n"
+      "focusDistanceNum=0\n"
+      "focusDistanceDen=0\n"
+      "apertureNum=227\n"
+      "apertureDen=100\n"
+      "horizontalViewAngle=51.2\n"
+      "verticalViewAngle=39.4\n"
+      "focalLengthIn35mmLength=31\n"
+      "minFps=1\n"
+      "maxFps=30\n"
+      "minExposureCompensation=-4\n"
+      "maxExposureCompensation=4\n"
+      "exposureCompensationStep=0.5\n"
+      "maxNumDetectedFaces=16\n"
+      "maxNumFocusAreas=2\n"
+      "maxNumMeteringAreas=32\n"
+      "maxZoomLevel=31\n"
+      "maxZoomRatio=400\n"
+      "zoomSupport=1\n"
+      "smoothZoomSupport=0\n"
+      "videoSnapshotSupport=1\n"
+      "videoStabilizationSupport=0\n"
+      "autoWhiteBalanceLockSupport=0\n"
+      "autoExposureLockSupport=1\n"
+      "antiBandingList=15\n"
+      "effectList=311\n"
+      "flashModeList=23\n"
+      "focusModeList=229\n"
+      "sceneModeList=32767\n"
+      "whiteBalanceList=55\n"
+      "sizeTableSupport=1\n"
+      "highResolutionCallbackW=3264\n"
+      "highResolutionCallbackH=1836\n"
+      "highSpeedRecording60WFHD=1920\n"
+      "highSpeedRecording60HFHD=1080\n"
+      "highSpeedRecording60W=1008\n"
+      "highSpeedRecording60H=566\n"
+      "highSpeedRecording120W=1008\n"
+      "highSpeedRecording120H=566\n"
+      "scalableSensorSupport=1\n"
+      "bnsSupport=0\n" },
+    { SENSOR_NAME_S5K6A3,
+      NULL, 0,
+      NULL, 0,
+      NULL, 0,
+      NULL, 0,
+      "maxPreviewW=1280\n"
+      "maxPreviewH=720\n"
+      "maxPictureW=1392\n"
+      "maxPictureH=1402\n"
+      "maxVideoW=1920\n"
+      "maxVideoH=1080\n"
+      "maxSensorW=1392\n"
+      "maxSensorH=1402\n"
+      "maxThumbnailW=512\n"
+      "maxThumbnailH=384\n"
+      "fNumberNum=22\n"
+      "fNumberDen=10\n"
+      "focalLengthNum=420\n"
+      "focalLengthDen=100\n"
+      "focusDistanceNum=0\n"
+      "focusDistanceDen=0\n"
+      "apertureNum=227\n"
+      "apertureDen=100\n"
+      "horizontalViewAngle=51.2\n"
+      "verticalViewAngle=39.4\n"
+      "focalLengthIn35mmLength=31\n"
+      "minFps=1\n"
+      "maxFps=30\n"
+      "minExposureCompensation=-4\n"
+      "maxExposureCompensation=4\n"
+      "exposureCompensationStep=0.5\n"
+      "maxNumDetectedFaces=16\n"
+      "maxNumFocusAreas=2\n"
+      "maxNumMeteringAreas=32\n"
+      "maxZoomLevel=31\n"
+      "maxZoomRatio=400\n"
+      "zoomSupport=1\n"
+      "smoothZoomSupport=0\n"
+      "videoSnapshotSupport=1\n"
+      "videoStabilizationSupport=0\n"
+      "autoWhiteBalanceLockSupport=0\n"
+      "autoExposureLockSupport=1\n"
+      "antiBandingList=15\n"
+      "effectList=311\n"
+      "flashModeList=1\n"
+      "focusModeList=2\n"
+      "sceneModeList=32767\n"
+      "whiteBalanceList=55\n"
+      "sizeTableSupport=0\n"
+      "highResolutionCallbackW=3264\n"
+      "highResolutionCallbackH=1836\n"
+      "highSpeedRecording60WFHD=1920\n"
+      "highSpeedRecording60HFHD=1080\n"
+      "highSpeedRecording60W=1008\n"
+      "highSpeedRecording60H=566\n"
+      "highSpeedRecording120W=1008\n"
+      "highSpeedRecording120H=566\n"
+      "scalableSensorSupport=1\n"
+      "bnsSupport=0\n" },
+    { SENSOR_NAME_IMX175,
+      GOLDEN_SIZE_LUT(PREVIEW_SIZE_LUT_IMX175),
+      GOLDEN_SIZE_LUT(PICTURE_SIZE_LUT_IMX175),
+      GOLDEN_SIZE_LUT(VIDEO_SIZE_LUT_IMX175),
+      GOLDEN_SIZE_LUT(VIDEO_SIZE_LUT_HIGH_SPEED_IMX175),
+      "maxPreviewW=1920\n"
+      "maxPreviewH=1080\n"
+      "maxPictureW=3264\n"
+      "maxPictureH=2448\n"
+      "maxVideoW=1920\n"
+      "maxVideoH=1080\n"
+      "maxSensorW=3264\n"
+      "maxSensorH=2448\n"
+      "maxThumbnailW=512\n"
+      "maxThumbnailH=384\n"
+      "fNumberNum=26\n"
+      "fNumberDen=10\n"
+      "focalLengthNum=370\n"
+      "focalLengthDen=100\n"
+      "focusDistanceNum=0\n"
+      "focusDistanceDen=0\n"
+      "apertureNum=276\n"
+      "apertureDen=100\n"
+      "horizontalViewAngle=51.2\n"
+      "verticalViewAngle=39.4\n"
+      "focalLengthIn35mmLength=31\n"
+      "minFps=1\n"
+      "maxFps=30\n"
+      "minExposureCompensation=-4\n"
+      "maxExposureCompensation=4\n"
+      "exposureCompensationStep=0.5\n"
+      "maxNumDetectedFaces=16\n"
+      "maxNumFocusAreas=2\n"
+      "maxNumMeteringAreas=32\n"
+      "maxZoomLevel=31\n"
+      "maxZoomRatio=400\n"
+      "zoomSupport=1\n"
+      "smoothZoomSupport=0\n"
+      "videoSnapshotSupport=1\n"
+      "videoStabilizationSupport=0\n"
+      "autoWhiteBalanceLockSupport=1\n"
+      "autoExposureLockSupport=1\n"
+      "antiBandingList=15\n"
+      "effectList=311\n"
+      "flashModeList=23\n"
+      "focusModeList=229\n"
+      "sceneModeList=32767\n"
+      "whiteBalanceList=55\n"
+      "sizeTableSupport=1\n"
+      "highResolutionCallbackW=3264\n"
+      "highResolutionCallbackH=1836\n"
+      "highSpeedRecording60WFHD=1920\n"
+      "highSpeedRecording60HFHD=1080\n"
+      "highSpeedRecording60W=1008\n"
+      "highSpeedRecording60H=566\n"
+      "highSpeedRecording120W=1008\n"
+      "highSpeedRecording120H=566\n"
+      "scalableSensorSupport=1\n"
+      "bnsSupport=0\n" },
+    { SENSOR_NAME_S5K8B1,
+      NULL, 0,
+      NULL, 0,
+      NULL, 0,
+      NULL, 0,
+      "maxPreviewW=1920\n"
+      "maxPreviewH=1080\n"
+      "maxPictureW=1920\n"
+      "maxPictureH=1080\n"
+      "maxVideoW=1920\n"
+      "maxVideoH=1080\n"
+      "maxSensorW=1920\n"
+      "maxSensorH=1080\n"
+      "maxThumbnailW=512\n"
+      "maxThumbnailH=384\n"
+      "fNumberNum=22\n"
+      "fNumberDen=10\n"
+      "focalLengthNum=420\n"
+      "focalLengthDen=100\n"
+      "focusDistanceNum=0\n"
+      "focusDistanceDen=0\n"
+      "apertureNum=227\n"
+      "apertureDen=100\n"
+      "horizontalViewAngle=51.2\n"
+      "verticalViewAngle=39.4\n"
+      "focalLengthIn35mmLength=31\n"
+      "minFps=1\n"
+      "maxFps=30\n"
+      "minExposureCompensation=-4\n"
+      "maxExposureCompensation=4\n"
+      "exposureCompensationStep=0.5\n"
+      "maxNumDetectedFaces=16\n"
+      "maxNumFocusAreas=1\n"
+      "maxNumMeteringAreas=32\n"
+      "maxZoomLevel=31\n"
+      "maxZoomRatio=400\n"
+      "zoomSupport=1\n"
+      "smoothZoomSupport=0\n"
+      "videoSnapshotSupport=1\n"
+      "videoStabilizationSupport=1\n"
+      "autoWhiteBalanceLockSupport=1\n"
+      "autoExposureLockSupport=1\n"
+      "antiBandingList=15\n"
+      "effectList=311\n"
+      "flashModeList=1\n"
+      "focusModeList=2\n"
+      "sceneModeList=32767\n"
+      "whiteBalanceList=55\n"
+      "sizeTableSupport=0\n"
+      "highResolutionCallbackW=3264\n"
+      "highResolutionCallbackH=1836\n"
+      "highSpeedRecording60WFHD=1920\n"
+      "highSpeedRecording60HFHD=1080\n"
+      "highSpeedRecording60W=1008\n"
+      "highSpeedRecording60H=566\n"
+      "highSpeedRecording120W=1008\n"
+      "highSpeedRecording120H=566\n"
+      "scalableSensorSupport=1\n"
+      "bnsSupport=0\n" },
+    { SENSOR_NAME_S5K1P2,
+      NULL, 0,
+      NULL, 0,
+      NULL, 0,
+      NULL, 0,
+      "maxPreviewW=1920\n"
+      "maxPreviewH=1080\n"
+      "maxPictureW=4128\n"
+      "maxPictureH=3096\n"
+      "maxVideoW=1920\n"
+      "maxVideoH=1080\n"
+      "maxSensorW=4128\n"
+      "maxSensorH=3096\n"
+      "maxThumbnailW=512\n"
+      "maxThumbnailH=384\n"
+      "fNumberNum=22\n"
+      "fNumberDen=10\n"
+      "focalLengthNum=420\n"
+      "focalLengthDen=100\n"
+      "focusDistanceNum=0\n"
+      "focusDistanceDen=0\n"
+      "apertureNum=227\n"
+      "apertureDen=100\n"
+      "horizontalViewAngle=51.2\n"
+      "verticalViewAngle=39.4\n"
+      "focalLengthIn35mmLength=31\n"
+      "minFps=0\n"
+      "maxFps=30\n"
+      "minExposureCompensation=-4\n"
+      "maxExposureCompensation=4\n"
+      "exposureCompensationStep=0.5\n"
+      "maxNumDetectedFaces=16\n"
+      "maxNumFocusAreas=1\n"
+      "maxNumMeteringAreas=1\n"
+      "maxZoomLevel=31\n"
+      "maxZoomRatio=400\n"
+      "zoomSupport=1\n"
+      "smoothZoomSupport=0\n"
+      "videoSnapshotSupport=1\n"
+      "videoStabilizationSupport=1\n"
+      "autoWhiteBalanceLockSupport=1\n"
+      "autoExposureLockSupport=1\n"
+      "antiBandingList=15\n"
+      "effectList=511\n"
+      "flashModeList=31\n"
+      "focusModeList=255\n"
+      "sceneModeList=32767\n"
+      "whiteBalanceList=255\n"
+      "sizeTableSupport=0\n"
+      "highResolutionCallbackW=3264\n"
+      "highResolutionCallbackH=1836\n"
+      "highSpeedRecording60WFHD=1920\n"
+      "highSpeedRecording60HFHD=1080\n"
+      "highSpeedRecording60W=1008\n"
+      "highSpeedRecording60H=566\n"
+      "highSpeedRecording120W=1008\n"
+      "highSpeedRecording120H=566\n"
+      "scalableSensorSupport=1\n"
+      "bnsSupport=0\n" },
+};
+
+#endif
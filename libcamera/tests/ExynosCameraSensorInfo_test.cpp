@@ -0,0 +1,123 @@
+/*
+**
+** Copyright 2013, Samsung Electronics Co. LTD
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <gtest/gtest.h>
+
+#include "ExynosCameraSensorInfo.h"
+#include "ExynosCameraSensorInfoGolden.h"
+
+using namespace android;
+
+static bool sameSizeLut(int (*lut)[SIZE_OF_LUT], int lutMax,
+        int (*expected)[SIZE_OF_LUT], int expectedMax)
+{
+    if (expected == NULL)
+        return lut == NULL && lutMax == 0;
+
+    return lut != NULL && lutMax == expectedMax
+        && memcmp(lut, expected, sizeof(int) * SIZE_OF_LUT * expectedMax) == 0;
+}
+
+/* Same format the golden dump was taken with, size LUTs left out */
+static std::string dumpSensorInfo(const struct ExynosSensorInfo *s)
+{
+    std::string out;
+    char line[128];
+
+#define DUMP(f) \
+    snprintf(line, sizeof(line), #f "=%g\n", (double)s->f); out += line
+
+    DUMP(maxPreviewW); DUMP(maxPreviewH); DUMP(maxPictureW); DUMP(maxPictureH);
+    DUMP(maxVideoW); DUMP(maxVideoH); DUMP(maxSensorW); DUMP(maxSensorH);
+    DUMP(maxThumbnailW); DUMP(maxThumbnailH);
+    DUMP(fNumberNum); DUMP(fNumberDen); DUMP(focalLengthNum); DUMP(focalLengthDen);
+    DUMP(focusDistanceNum); DUMP(focusDistanceDen); DUMP(apertureNum); DUMP(apertureDen);
+    DUMP(horizontalViewAngle); DUMP(verticalViewAngle); DUMP(focalLengthIn35mmLength);
+    DUMP(minFps); DUMP(maxFps);
+    DUMP(minExposureCompensation); DUMP(maxExposureCompensation); DUMP(exposureCompensationStep);
+    DUMP(maxNumDetectedFaces); DUMP(maxNumFocusAreas); DUMP(maxNumMeteringAreas);
+    DUMP(maxZoomLevel); DUMP(maxZoomRatio);
+    DUMP(zoomSupport); DUMP(smoothZoomSupport); DUMP(videoSnapshotSupport);
+    DUMP(videoStabilizationSupport); DUMP(autoWhiteBalanceLockSupport); DUMP(autoExposureLockSupport);
+    DUMP(antiBandingList); DUMP(effectList); DUMP(flashModeList); DUMP(focusModeList);
+    DUMP(sceneModeList); DUMP(whiteBalanceList);
+    DUMP(sizeTableSupport);
+    DUMP(highResolutionCallbackW); DUMP(highResolutionCallbackH);
+    DUMP(highSpeedRecording60WFHD); DUMP(highSpeedRecording60HFHD);
+    DUMP(highSpeedRecording60W); DUMP(highSpeedRecording60H);
+    DUMP(highSpeedRecording120W); DUMP(highSpeedRecording120H);
+    DUMP(scalableSensorSupport); DUMP(bnsSupport);
+
+#undef DUMP
+
+    return out;
+}
+
+#define GOLDEN_SIZE (sizeof(SENSOR_INFO_GOLDEN) / sizeof(SENSOR_INFO_GOLDEN[0]))
+
+TEST(ExynosCameraSensorInfo, MatchesPerSensorClasses)
+{
+    for (size_t i = 0; i < GOLDEN_SIZE; i++) {
+        const struct ExynosSensorInfo *info = getSensorInfoByName(SENSOR_INFO_GOLDEN[i].sensorName);
+
+        const struct sensor_info_golden *golden = &SENSOR_INFO_GOLDEN[i];
+
+        ASSERT_TRUE(info != NULL);
+        EXPECT_EQ(std::string(golden->dump), dumpSensorInfo(info))
+            << "sensor " << golden->sensorName;
+
+        EXPECT_TRUE(sameSizeLut(info->previewSizeLut, info->previewSizeLutMax,
+                golden->previewSizeLut, golden->previewSizeLutMax))
+            << "sensor " << golden->sensorName;
+        EXPECT_TRUE(sameSizeLut(info->pictureSizeLut, info->pictureSizeLutMax,
+                golden->pictureSizeLut, golden->pictureSizeLutMax))
+            << "sensor " << golden->sensorName;
+        EXPECT_TRUE(sameSizeLut(info->videoSizeLut, info->videoSizeLutMax,
+                golden->videoSizeLut, golden->videoSizeLutMax))
+            << "sensor " << golden->sensorName;
+        EXPECT_TRUE(sameSizeLut(info->videoSizeLutHighSpeed, info->videoSizeLutHighSpeedMax,
+                golden->videoSizeLutHighSpeed, golden->videoSizeLutHighSpeedMax))
+            << "sensor " << golden->sensorName;
+    }
+}
+
+TEST(ExynosCameraSensorInfo, SharesOneInstancePerSensor)
+{
+    for (size_t i = 0; i < GOLDEN_SIZE; i++) {
+        int sensorName = SENSOR_INFO_GOLDEN[i].sensorName;
+
+        EXPECT_EQ(getSensorInfoByName(sensorName), getSensorInfoByName(sensorName));
+    }
+
+    /* Unknown sensors all get the one default instance */
+    EXPECT_EQ(getSensorInfoByName(SENSOR_NAME_S5K1P2), getSensorInfoByName(SENSOR_NAME_NOTHING));
+}
+
+TEST(ExynosCameraSensorInfo, CreateReturnsOwnedCopy)
+{
+    const struct ExynosSensorInfo *shared = getSensorInfo(CAMERA_ID_BACK);
+    struct ExynosSensorInfo *info = createSensorInfo(CAMERA_ID_BACK);
+
+    ASSERT_TRUE(info != NULL);
+    EXPECT_NE(shared, info);
+    EXPECT_EQ(dumpSensorInfo(shared), dumpSensorInfo(info));
+
+    delete info;
+}
@@ -0,0 +1,208 @@
+/*
+**
+** Copyright 2013, Samsung Electronics Co. LTD
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#include <string.h>
+#include <gtest/gtest.h>
+
+#include "ExynosCameraSizeSolver.h"
+#include "ExynosCameraSensorInfoGolden.h"
+
+using namespace android;
+
+#define GOLDEN_SIZE (sizeof(SENSOR_INFO_GOLDEN) / sizeof(SENSOR_INFO_GOLDEN[0]))
+
+static const int SWEEP_RATIOS[][2] =
+{
+    { 16, 9 }, { 4, 3 }, { 1, 1 }, { 3, 2 }, { 5, 3 }, { 11, 9 },
+};
+
+static int (*sweepLut(const struct ExynosSensorInfo *info, int mode, bool highSpeed, int *lutMax))[SIZE_OF_LUT]
+{
+    if (mode == MODE_PREVIEW) {
+        *lutMax = info->previewSizeLutMax;
+        return info->previewSizeLut;
+    } else if (mode == MODE_PICTURE) {
+        *lutMax = info->pictureSizeLutMax;
+        return info->pictureSizeLut;
+    } else if (highSpeed) {
+        *lutMax = info->videoSizeLutHighSpeedMax;
+        return info->videoSizeLutHighSpeed;
+    }
+
+    *lutMax = info->videoSizeLutMax;
+    return info->videoSizeLut;
+}
+
+static bool sameConfig(const struct ExynosCameraSizeConfig &a, const struct ExynosCameraSizeConfig &b)
+{
+    return memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+/*
+ * The row picked for w x h must be of the requested ratio, and be the
+ * smallest target covering w x h, or the largest target if none does.
+ */
+static void checkRow(const struct ExynosSensorInfo *info, int mode, bool highSpeed,
+                     int w, int h, const struct ExynosCameraSizeConfig &config)
+{
+    int lutMax = 0;
+    int (*lut)[SIZE_OF_LUT] = sweepLut(info, mode, highSpeed, &lutMax);
+    int area = config.targetW * config.targetH;
+    bool covers = (config.targetW >= w && config.targetH >= h);
+
+    ASSERT_EQ(getSizeRatioId(w, h), config.ratioId);
+
+    for (int i = 0; i < lutMax; i++) {
+        if (lut[i][RATIO_ID] != config.ratioId)
+            continue;
+
+        bool rowCovers = (lut[i][TARGET_W] >= w && lut[i][TARGET_H] >= h);
+        int rowArea = lut[i][TARGET_W] * lut[i][TARGET_H];
+
+        if (covers)
+            EXPECT_FALSE(rowCovers && rowArea < area) << w << "x" << h << " mode " << mode;
+        else
+            EXPECT_FALSE(rowCovers || rowArea > area) << w << "x" << h << " mode " << mode;
+    }
+}
+
+/*
+ * Sweep every sensor with size LUTs, every mode and sizes of every ratio.
+ * Each result is checked against the LUT and against an uncached solve, a
+ * second time once it is in the memo cache.
+ */
+TEST(ExynosCameraSizeSolver, SizeSweep)
+{
+    for (size_t i = 0; i < GOLDEN_SIZE; i++) {
+        const struct ExynosSensorInfo *info = getSensorInfoByName(SENSOR_INFO_GOLDEN[i].sensorName);
+        struct ExynosSensorInfo uncached = *info;
+
+        if (info->sizeTableSupport == false)
+            continue;
+        uncached.sensorTableIndex = -1;
+
+        for (int mode = MODE_PREVIEW; mode <= MODE_VIDEO; mode++) {
+            for (int highSpeed = 0; highSpeed <= (mode == MODE_VIDEO ? 1 : 0); highSpeed++) {
+                for (size_t r = 0; r < sizeof(SWEEP_RATIOS) / sizeof(SWEEP_RATIOS[0]); r++) {
+                    for (int w = 32; w <= info->maxSensorW + 64; w += 14) {
+                        int h = w * SWEEP_RATIOS[r][1] / SWEEP_RATIOS[r][0];
+                        struct ExynosCameraSizeConfig expected, config;
+                        status_t ret;
+
+                        ret = getSizeConfig(&uncached, mode, highSpeed, w, h, &expected);
+                        if (getSizeRatioId(w, h) < 0) {
+                            EXPECT_NE(NO_ERROR, ret);
+                            continue;
+                        }
+                        if (ret != NO_ERROR)
+                            continue; /* ratio not in this LUT */
+
+                        checkRow(info, mode, highSpeed, w, h, expected);
+
+                        for (int pass = 0; pass < 2; pass++) {
+                            ASSERT_EQ(NO_ERROR, getSizeConfig(info, mode, highSpeed, w, h, &config));
+                            EXPECT_TRUE(sameConfig(expected, config))
+                                << "sensor " << SENSOR_INFO_GOLDEN[i].sensorName
+                                << " mode " << mode << " " << w << "x" << h << " pass " << pass;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+/* (w, h) and (w + 1, h - 31) shared a cache slot with the old *31 hash */
+TEST(ExynosCameraSizeSolver, NeighbourSizesDoNotShareEntries)
+{
+    for (size_t i = 0; i < GOLDEN_SIZE; i++) {
+        const struct ExynosSensorInfo *info = getSensorInfoByName(SENSOR_INFO_GOLDEN[i].sensorName);
+        struct ExynosSensorInfo uncached = *info;
+        struct ExynosCameraSizeConfig first, second, expected;
+
+        if (info->sizeTableSupport == false)
+            continue;
+        uncached.sensorTableIndex = -1;
+
+        for (int w = 64; w <= info->maxPreviewW; w += 64) {
+            int h = w * 3 / 4;
+
+            if (getSizeConfig(info, MODE_PREVIEW, false, w, h, &first) != NO_ERROR)
+                continue;
+            if (getSizeConfig(info, MODE_PREVIEW, false, w + 1, h - 31, &second) != NO_ERROR)
+                continue;
+            ASSERT_EQ(NO_ERROR, getSizeConfig(&uncached, MODE_PREVIEW, false, w + 1, h - 31, &expected));
+            EXPECT_TRUE(sameConfig(expected, second)) << w + 1 << "x" << h - 31;
+        }
+    }
+}
+
+/* A createSensorInfo() copy hits the cache entries of its sensor */
+TEST(ExynosCameraSizeSolver, CopiesShareTheirSensorEntries)
+{
+    for (size_t i = 0; i < GOLDEN_SIZE; i++) {
+        const struct ExynosSensorInfo *info = getSensorInfoByName(SENSOR_INFO_GOLDEN[i].sensorName);
+        struct ExynosCameraSizeConfig shared, copied;
+        struct ExynosSensorInfo copy = *info;
+
+        if (info->sizeTableSupport == false)
+            continue;
+
+        EXPECT_EQ(info->sensorTableIndex, copy.sensorTableIndex);
+        ASSERT_EQ(NO_ERROR, getSizeConfig(info, MODE_PICTURE, false,
+                                          info->maxPictureW, info->maxPictureH, &shared));
+        ASSERT_EQ(NO_ERROR, getSizeConfig(&copy, MODE_PICTURE, false,
+                                          info->maxPictureW, info->maxPictureH, &copied));
+        EXPECT_TRUE(sameConfig(shared, copied));
+    }
+}
+
+TEST(ExynosCameraSizeSolver, SolveFollowsVideoLutWhileRecording)
+{
+    for (size_t i = 0; i < GOLDEN_SIZE; i++) {
+        const struct ExynosSensorInfo *info = getSensorInfoByName(SENSOR_INFO_GOLDEN[i].sensorName);
+        struct ExynosCameraSizeConfig preview, video;
+        struct exynos_camera_info cameraInfo;
+
+        if (info->sizeTableSupport == false)
+            continue;
+
+        memset(&cameraInfo, 0, sizeof(cameraInfo));
+        cameraInfo.previewW = 1920;
+        cameraInfo.previewH = 1080;
+        cameraInfo.pictureW = info->maxPictureW;
+        cameraInfo.pictureH = info->maxPictureH;
+        cameraInfo.videoW = 1280;
+        cameraInfo.videoH = 720;
+        if (getSizeConfig(info, MODE_PREVIEW, false, 1920, 1080, &preview) != NO_ERROR
+            || getSizeConfig(info, MODE_VIDEO, false, 1280, 720, &video) != NO_ERROR)
+            continue;
+
+        ASSERT_EQ(NO_ERROR, solveSizeConfig(info, &cameraInfo));
+        EXPECT_EQ(preview.ratioId, cameraInfo.previewSizeRatioId);
+        EXPECT_EQ(preview.sensorW, cameraInfo.hwSensorW);
+        EXPECT_EQ(preview.bayerCropX, cameraInfo.hwBayerCropX);
+
+        cameraInfo.recordingHint = true;
+        ASSERT_EQ(NO_ERROR, solveSizeConfig(info, &cameraInfo));
+        EXPECT_EQ(video.ratioId, cameraInfo.videoSizeRatioId);
+        EXPECT_EQ(video.sensorW, cameraInfo.hwSensorW);
+        EXPECT_EQ(video.bnsW, cameraInfo.bnsW);
+        EXPECT_EQ(video.bayerCropW, cameraInfo.hwBayerCropW);
+        EXPECT_EQ(video.bayerCropY, cameraInfo.hwBayerCropY);
+    }
+}
@@ -1,11 +1,274 @@
+#include <unistd.h>
+#include <sync/sync.h>
 #include "ExynosPrimaryDisplay.h"
 #include "ExynosHWCModule.h"
+#include "content_protect_batch.h"
+
+/*
+ * IPs whose protection this display drives through the mask API: the
+ * scalers behind FIMD_GSC_USAGE_IDX
+ */
+#define PRIMARY_PROTECT_OWNED_MASK  (CP_PROTECT_MASK(CP_PROTECT_GSC0) | \
+                                     CP_PROTECT_MASK(CP_PROTECT_GSC1))
+
+/* CP_PROTECT_MASK() of the scaler unit behind a gsc_map index, 0 if none */
+static uint32_t gscProtectMask(int gscIdx)
+{
+    if (gscIdx < 0 || (size_t)gscIdx >= sizeof(AVAILABLE_GSC_UNITS) / sizeof(AVAILABLE_GSC_UNITS[0]))
+        return 0;
+
+    switch (AVAILABLE_GSC_UNITS[gscIdx]) {
+    case 0:
+        return CP_PROTECT_MASK(CP_PROTECT_GSC0);
+    case 1:
+        return CP_PROTECT_MASK(CP_PROTECT_GSC1);
+    case 2:
+        return CP_PROTECT_MASK(CP_PROTECT_GSC2);
+    default:
+        return 0;
+    }
+}
+
+static bool isProtectedLayer(hwc_layer_1_t &layer)
+{
+    private_handle_t *handle;
+
+    if (!layer.handle)
+        return false;
+
+    handle = private_handle_t::dynamicCast(layer.handle);
+    return handle && (handle->flags & GRALLOC_USAGE_PROTECTED);
+}
+
+/* Scaled layers and formats DECON cannot fetch directly need a VPP DMA */
+static bool layerNeedsVpp(hwc_layer_1_t &layer)
+{
+    private_handle_t *handle;
+    int srcW = (int)(layer.sourceCropf.right - layer.sourceCropf.left);
+    int srcH = (int)(layer.sourceCropf.bottom - layer.sourceCropf.top);
+    int dstW = layer.displayFrame.right - layer.displayFrame.left;
+    int dstH = layer.displayFrame.bottom - layer.displayFrame.top;
+
+    if (layer.transform & HAL_TRANSFORM_ROT_90) {
+        int tmp = dstW;
+        dstW = dstH;
+        dstH = tmp;
+    }
+    if (srcW != dstW || srcH != dstH)
+        return true;
+
+    if (!layer.handle)
+        return false;
+    handle = private_handle_t::dynamicCast(layer.handle);
+    return handle && halFormatToSocFormat(handle->format) == DECON_PIXEL_FORMAT_MAX;
+}
 
 ExynosPrimaryDisplay::ExynosPrimaryDisplay(int numGSCs, struct exynos5_hwc_composer_device_1_t *pdev) :
-    ExynosOverlayDisplay(numGSCs, pdev)
+    ExynosOverlayDisplay(numGSCs, pdev),
+    mFrameProtectMask(0),
+    mPendingProtectMask(0),
+    mProtectReleaseFence(-1),
+    mSetContents(NULL),
+    mSecureFrames(0),
+    mSecureVgrLayers(0),
+    mSecureGlesFallbacks(0),
+    mSecureScalerLayers(0)
 {
+    memset(mIdmaOverridden, 0, sizeof(mIdmaOverridden));
+
+    /* A previous HWC instance may have died with scalers protected */
+    if (CP_Reset_Path_Protection(PRIMARY_PROTECT_OWNED_MASK) != CP_SUCCESS)
+        ALOGE("%s: failed to reset path protection", __func__);
 }
 
 ExynosPrimaryDisplay::~ExynosPrimaryDisplay()
 {
+    if (mProtectReleaseFence >= 0)
+        close(mProtectReleaseFence);
+    if (mFrameProtectMask || mPendingProtectMask)
+        CP_Set_Path_Protection_Mask(0, PRIMARY_PROTECT_OWNED_MASK);
+}
+
+int ExynosPrimaryDisplay::prepare(hwc_display_contents_1_t *contents)
+{
+    bool secureFrame = false;
+    int ret = ExynosOverlayDisplay::prepare(contents);
+
+    mFrameProtectMask = 0;
+    if (!contents)
+        return ret;
+
+    for (size_t i = 0; i < contents->numHwLayers; i++) {
+        hwc_layer_1_t &layer = contents->hwLayers[i];
+
+        if (layer.compositionType == HWC_FRAMEBUFFER_TARGET ||
+                !isProtectedLayer(layer))
+            continue;
+
+        secureFrame = true;
+        if (layer.compositionType == HWC_FRAMEBUFFER) {
+            /* GLES cannot read the secure heap, the layer goes out black */
+            mSecureGlesFallbacks++;
+            ALOGV("%s: protected layer %zu fell back to GLES", __func__, i);
+        }
+    }
+
+    /* Protect the scalers the base class routed protected layers through */
+    for (size_t i = 0; i < SOC_NUM_HW_WINDOWS; i++) {
+        int layerIdx = mPostData.overlay_map[i];
+
+        if (layerIdx < 0 || (size_t)layerIdx >= contents->numHwLayers ||
+                !isProtectedLayer(contents->hwLayers[layerIdx]) ||
+                mPostData.gsc_map[i].mode != exynos5_gsc_map_t::GSC_M2M)
+            continue;
+
+        mFrameProtectMask |= gscProtectMask(mPostData.gsc_map[i].idx);
+    }
+
+    if (secureFrame)
+        mSecureFrames++;
+
+    return ret;
+}
+
+int ExynosPrimaryDisplay::set(hwc_display_contents_1_t *contents)
+{
+    uint32_t protectMask;
+    int ret;
+
+    /*
+     * The scaler jobs of the last protected frame may still be reading the
+     * secure buffers; keep their IPs protected until those layers' release
+     * fences have signalled.
+     */
+    if (mProtectReleaseFence >= 0 && sync_wait(mProtectReleaseFence, 0) == 0) {
+        close(mProtectReleaseFence);
+        mProtectReleaseFence = -1;
+        mPendingProtectMask = 0;
+    }
+    protectMask = mFrameProtectMask | mPendingProtectMask;
+    /* Without a fence to wait on, the hold only covers this one frame */
+    if (mProtectReleaseFence < 0)
+        mPendingProtectMask = 0;
+
+    /*
+     * Apply the whole frame's TZPC requirement before the scaler touches any
+     * protected buffer; this is a no-op while protection stays unchanged.
+     */
+    if (CP_Set_Path_Protection_Mask(protectMask, PRIMARY_PROTECT_OWNED_MASK) != CP_SUCCESS)
+        ALOGE("%s: failed to set path protection 0x%x", __func__, protectMask);
+
+    memset(mIdmaOverridden, 0, sizeof(mIdmaOverridden));
+
+    mSetContents = contents;
+    ret = ExynosOverlayDisplay::set(contents);
+    mSetContents = NULL;
+
+    if (contents && mFrameProtectMask)
+        trackProtectedRelease(contents);
+
+    return ret;
+}
+
+void ExynosPrimaryDisplay::trackProtectedRelease(hwc_display_contents_1_t *contents)
+{
+    for (size_t i = 0; i < contents->numHwLayers; i++) {
+        hwc_layer_1_t &layer = contents->hwLayers[i];
+        int fence;
+
+        if (layer.compositionType != HWC_OVERLAY || layer.releaseFenceFd < 0 ||
+                !isProtectedLayer(layer))
+            continue;
+
+        if (mProtectReleaseFence < 0) {
+            fence = dup(layer.releaseFenceFd);
+        } else {
+            fence = sync_merge("hwc_protect", mProtectReleaseFence, layer.releaseFenceFd);
+            close(mProtectReleaseFence);
+        }
+        mProtectReleaseFence = fence;
+        if (fence < 0)
+            ALOGE("%s: failed to track release fence of layer %zu", __func__, i);
+    }
+
+    mPendingProtectMask |= mFrameProtectMask;
+}
+
+/*
+ * A window can hand its VGR DMA to a protected layer if it is unused this
+ * frame, if its own layer needs no VPP, or if the DMA it gets back is a VPP
+ * one as well.
+ */
+bool ExynosPrimaryDisplay::canTakeIdma(size_t window, decon_idma_type idma)
+{
+    int layerIdx;
+
+    if (isVppType(idma))
+        return true;
+    if (!mSetContents)
+        return false;
+
+    layerIdx = mPostData.overlay_map[window];
+    if (layerIdx < 0 || (size_t)layerIdx >= mSetContents->numHwLayers)
+        return true;
+
+    return !layerNeedsVpp(mSetContents->hwLayers[layerIdx]);
+}
+
+void ExynosPrimaryDisplay::configureHandle(private_handle_t *handle, size_t index,
+        hwc_layer_1_t &layer, int fence_fd, decon_win_config &cfg)
+{
+    ExynosOverlayDisplay::configureHandle(handle, index, layer, fence_fd, cfg);
+
+    /* This window gave its VGR DMA to a protected layer below it */
+    if (mIdmaOverridden[index])
+        cfg.idma_type = mIdmaOverride[index];
+
+    if (!isProtectedLayer(layer))
+        return;
+
+    cfg.protection = 1;
+    if (handle != private_handle_t::dynamicCast(layer.handle))
+        mSecureScalerLayers++;
+
+    if (isVgrType(cfg.idma_type)) {
+        mSecureVgrLayers++;
+        return;
+    }
+
+    /* IDMA_G0 is hard-wired to WIN7 and cannot be handed to another window */
+    if (cfg.idma_type == IDMA_G0) {
+        ALOGW("%s: protected layer on window %zu cannot use a VGR DMA", __func__, index);
+        return;
+    }
+
+    /*
+     * Windows are configured in ascending order, so swap DMAs with a VGR
+     * window that has not been configured yet this frame and can live
+     * with the DMA it gets in exchange.
+     */
+    for (size_t i = index + 1; i < SOC_NUM_HW_WINDOWS; i++) {
+        decon_idma_type idma = getIdmaType(i);
+
+        if (!isVgrType(idma) || mIdmaOverridden[i] || !canTakeIdma(i, cfg.idma_type))
+            continue;
+
+        mIdmaOverridden[i] = true;
+        mIdmaOverride[i] = cfg.idma_type;
+        cfg.idma_type = idma;
+        mSecureVgrLayers++;
+        return;
+    }
+
+    ALOGW("%s: no VGR DMA left for protected layer on window %zu", __func__, index);
+}
+
+void ExynosPrimaryDisplay::dump(android::String8& result)
+{
+    ExynosOverlayDisplay::dump(result);
+
+    result.appendFormat("secure video: %u frames, %u VGR layers, %u scaler layers, "
+            "%u GLES/black fallbacks, protect mask 0x%x (pending release 0x%x)\n",
+            mSecureFrames, mSecureVgrLayers, mSecureScalerLayers,
+            mSecureGlesFallbacks, mFrameProtectMask, mPendingProtectMask);
 }
@@ -7,6 +7,32 @@ class ExynosPrimaryDisplay : public ExynosOverlayDisplay {
     public:
         ExynosPrimaryDisplay(int numGSCs, struct exynos5_hwc_composer_device_1_t *pdev);
         ~ExynosPrimaryDisplay();
+
+        virtual int prepare(hwc_display_contents_1_t *contents);
+        virtual int set(hwc_display_contents_1_t *contents);
+        virtual void configureHandle(private_handle_t *handle, size_t index,
+                hwc_layer_1_t &layer, int fence_fd, decon_win_config &cfg);
+        virtual void dump(android::String8& result);
+
+    private:
+        void trackProtectedRelease(hwc_display_contents_1_t *contents);
+        bool canTakeIdma(size_t window, decon_idma_type idma);
+
+        /* DMA a window was handed by a protected layer swap, per frame */
+        bool                mIdmaOverridden[SOC_NUM_HW_WINDOWS];
+        decon_idma_type     mIdmaOverride[SOC_NUM_HW_WINDOWS];
+        /* CP_PROTECT_MASK() of scalers protected layers need this frame */
+        uint32_t            mFrameProtectMask;
+        /* Protection held until mProtectReleaseFence (previous frames) signals */
+        uint32_t            mPendingProtectMask;
+        int                 mProtectReleaseFence;
+        /* Contents of the set() in progress, for configureHandle() */
+        hwc_display_contents_1_t *mSetContents;
+
+        uint32_t            mSecureFrames;
+        uint32_t            mSecureVgrLayers;
+        uint32_t            mSecureGlesFallbacks;
+        uint32_t            mSecureScalerLayers;
 };
 
 #endif
@@ -44,10 +44,13 @@ endif
 endif
 
 LOCAL_SRC_FILES := \
-	ExynosExternalDisplayModule.cpp
+	ExynosExternalDisplayModule.cpp \
+	ExternalModeCache.cpp
 
 LOCAL_MODULE_TAGS := eng
 LOCAL_MODULE := libhdmimodule
 include $(BUILD_SHARED_LIBRARY)
 
+include $(LOCAL_PATH)/tests/Android.mk
+
 endif
@@ -0,0 +1,79 @@
+#include "ExternalModeCache.h"
+
+using namespace android;
+
+ExternalModeCache::ExternalModeCache(size_t maxSinks)
+    : mMaxSinks(maxSinks),
+    mSink(0),
+    mHits(0),
+    mMisses(0)
+{
+}
+
+bool ExternalModeCache::plug(uint32_t hash, nsecs_t now, int *activeConfig)
+{
+    Mutex::Autolock lock(mLock);
+
+    mSink = hash;
+    ssize_t index = hash ? mEntries.indexOfKey(hash) : -1;
+    if (index < 0)
+        return false;
+
+    external_mode_cache_entry &entry = mEntries.editValueAt(index);
+    entry.lastUsed = now;
+    *activeConfig = entry.activeConfig;
+
+    return true;
+}
+
+void ExternalModeCache::store(int activeConfig, nsecs_t now)
+{
+    Mutex::Autolock lock(mLock);
+    external_mode_cache_entry entry;
+
+    if (mSink == 0)
+        return;
+
+    entry.activeConfig = activeConfig;
+    entry.lastUsed = now;
+
+    if (mEntries.indexOfKey(mSink) < 0 && mEntries.size() >= mMaxSinks) {
+        /* Evict the least recently plugged sink */
+        size_t oldest = 0;
+        for (size_t i = 1; i < mEntries.size(); i++) {
+            if (mEntries.valueAt(i).lastUsed < mEntries.valueAt(oldest).lastUsed)
+                oldest = i;
+        }
+        mEntries.removeItemsAt(oldest);
+    }
+    mEntries.add(mSink, entry);
+}
+
+void ExternalModeCache::configChanged(int activeConfig)
+{
+    Mutex::Autolock lock(mLock);
+
+    ssize_t index = mSink ? mEntries.indexOfKey(mSink) : -1;
+    if (index >= 0)
+        mEntries.editValueAt(index).activeConfig = activeConfig;
+}
+
+void ExternalModeCache::countHit()
+{
+    Mutex::Autolock lock(mLock);
+    mHits++;
+}
+
+void ExternalModeCache::countMiss()
+{
+    Mutex::Autolock lock(mLock);
+    mMisses++;
+}
+
+void ExternalModeCache::dump(String8& result)
+{
+    Mutex::Autolock lock(mLock);
+
+    result.appendFormat("  mode cache: %zu sinks, %u hits, %u misses, sink %08x\n",
+            mEntries.size(), mHits, mMisses, mSink);
+}
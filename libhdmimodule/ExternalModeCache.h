@@ -0,0 +1,53 @@
+#ifndef EXTERNAL_MODE_CACHE_H
+#define EXTERNAL_MODE_CACHE_H
+
+#include <utils/KeyedVector.h>
+#include <utils/Mutex.h>
+#include <utils/String8.h>
+#include <utils/Timers.h>
+
+/*
+ * Last chosen mode of one sink, keyed by its EDID hash. The mode list itself
+ * is owned by the base class, which keeps it until another sink is enumerated.
+ */
+struct external_mode_cache_entry {
+    int         activeConfig;
+    nsecs_t     lastUsed;
+};
+
+/*
+ * Modes of the last plugged sinks. Hotplug plugs sinks and stores their
+ * modes, SurfaceFlinger changes the mode of the connected one and dump reads
+ * it all, so every method takes the cache lock.
+ */
+class ExternalModeCache {
+    public:
+        ExternalModeCache(size_t maxSinks);
+
+        /*
+         * Makes hash the connected sink, 0 for an unknown one. Returns true
+         * and the sink's last mode if it is cached.
+         */
+        bool plug(uint32_t hash, nsecs_t now, int *activeConfig);
+        /* Stores the mode of the connected sink, evicting the least recently plugged sink if full */
+        void store(int activeConfig, nsecs_t now);
+        /* Updates the mode of the connected sink if it is cached */
+        void configChanged(int activeConfig);
+
+        /* Hotplug without enumeration, the cached mode was applied as is */
+        void countHit();
+        /* Hotplug that went through the base class enumeration and negotiation */
+        void countMiss();
+        void dump(android::String8& result);
+
+    private:
+        android::Mutex mLock;
+        android::KeyedVector<uint32_t, external_mode_cache_entry> mEntries;
+        size_t      mMaxSinks;
+        /* EDID hash of the connected sink, 0 if unknown */
+        uint32_t    mSink;
+        uint32_t    mHits;
+        uint32_t    mMisses;
+};
+
+#endif
@@ -1,10 +1,134 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
 #include "ExynosExternalDisplayModule.h"
+#include "ExynosHWCModule.h"
 
 ExynosExternalDisplayModule::ExynosExternalDisplayModule(struct exynos5_hwc_composer_device_1_t *pdev)
-    : ExynosExternalDisplay(pdev)
+    : ExynosExternalDisplay(pdev),
+    mModeCache(EXTERNAL_MODE_CACHE_MAX_SINKS),
+    mEnumeratedEdidHash(0),
+    mEdidReadFailed(false),
+    mHotplugTime(0),
+    mFirstFramePending(false),
+    mLastTimeToFirstFrame(0)
 {
 }
 
 ExynosExternalDisplayModule::~ExynosExternalDisplayModule()
 {
 }
+
+/* FNV-1a over the raw EDID blob; 0 is reserved for "unknown sink" */
+int ExynosExternalDisplayModule::readEdidHash(uint32_t *hash)
+{
+    uint8_t edid[EXTERNAL_EDID_MAX_SIZE];
+    uint32_t h = 2166136261u;
+
+    int fd = open(HDMI_EDID_PATH, O_RDONLY);
+    ssize_t len = -1;
+    if (fd >= 0) {
+        len = read(fd, edid, sizeof(edid));
+        close(fd);
+    }
+    if (len <= 0) {
+        /* Without an EDID every sink is unknown and the mode cache never hits */
+        if (!mEdidReadFailed)
+            ALOGW("%s: cannot read %s: %s, mode cache disabled", __func__,
+                    HDMI_EDID_PATH, len < 0 ? strerror(errno) : "empty");
+        mEdidReadFailed = true;
+        return -EIO;
+    }
+
+    for (ssize_t i = 0; i < len; i++) {
+        h ^= edid[i];
+        h *= 16777619u;
+    }
+    *hash = h ? h : 1;
+
+    return 0;
+}
+
+int ExynosExternalDisplayModule::getConfig()
+{
+    uint32_t hash = 0;
+    int cachedConfig;
+    int ret;
+
+    mHotplugTime = systemTime(SYSTEM_TIME_MONOTONIC);
+    mFirstFramePending = true;
+
+    if (readEdidHash(&hash) < 0)
+        hash = 0;
+
+    if (!mModeCache.plug(hash, mHotplugTime, &cachedConfig)) {
+        mModeCache.countMiss();
+        ret = ExynosExternalDisplay::getConfig();
+        mEnumeratedEdidHash = (ret == 0) ? hash : 0;
+        if (ret == 0)
+            mModeCache.store(ExynosExternalDisplay::getActiveConfig(), mHotplugTime);
+        return ret;
+    }
+
+    /*
+     * Same sink as the one the base class last enumerated: its mode list is
+     * still valid, so skip both enumeration and mode negotiation.
+     */
+    if (mEnumeratedEdidHash == hash &&
+            ExynosExternalDisplay::setActiveConfig(cachedConfig) == 0) {
+        mModeCache.countHit();
+        ALOGV("%s: sink %08x cached, config %d", __func__, hash, cachedConfig);
+        return 0;
+    }
+
+    /*
+     * Known sink, but another one was enumerated since. The base class does
+     * enumeration and negotiation in one go, so this costs as much as a miss;
+     * only the mode chosen last time is restored over the negotiated one.
+     */
+    mModeCache.countMiss();
+    ret = ExynosExternalDisplay::getConfig();
+    if (ret < 0) {
+        mEnumeratedEdidHash = 0;
+        return ret;
+    }
+    mEnumeratedEdidHash = hash;
+
+    if (ExynosExternalDisplay::setActiveConfig(cachedConfig) < 0)
+        mModeCache.store(ExynosExternalDisplay::getActiveConfig(), mHotplugTime);
+
+    return 0;
+}
+
+int ExynosExternalDisplayModule::setActiveConfig(int index)
+{
+    int ret = ExynosExternalDisplay::setActiveConfig(index);
+    if (ret == 0)
+        mModeCache.configChanged(index);
+
+    return ret;
+}
+
+int ExynosExternalDisplayModule::set(hwc_display_contents_1_t* contents)
+{
+    int ret = ExynosExternalDisplay::set(contents);
+
+    if (mFirstFramePending && ret == 0 && contents && contents->numHwLayers > 0) {
+        mFirstFramePending = false;
+        mLastTimeToFirstFrame = systemTime(SYSTEM_TIME_MONOTONIC) - mHotplugTime;
+        ALOGI("external display: first frame %lld ms after hotplug",
+                (long long)ns2ms(mLastTimeToFirstFrame));
+    }
+
+    return ret;
+}
+
+void ExynosExternalDisplayModule::dump(android::String8& result)
+{
+    ExynosExternalDisplay::dump(result);
+
+    mModeCache.dump(result);
+    result.appendFormat("  last hotplug to first frame: %lld ms\n",
+            (long long)ns2ms(mLastTimeToFirstFrame));
+}
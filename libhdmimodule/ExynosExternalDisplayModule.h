@@ -1,12 +1,35 @@
 #ifndef EXYNOS_EXTERNAL_DISPLAY_MODULE_H
 #define EXYNOS_EXTERNAL_DISPLAY_MODULE_H
 
+#include <utils/Timers.h>
 #include "ExynosExternalDisplay.h"
+#include "ExternalModeCache.h"
+
+#define EXTERNAL_EDID_MAX_SIZE          512
+#define EXTERNAL_MODE_CACHE_MAX_SINKS   8
 
 class ExynosExternalDisplayModule : public ExynosExternalDisplay {
     public:
         ExynosExternalDisplayModule(struct exynos5_hwc_composer_device_1_t *pdev);
         ~ExynosExternalDisplayModule();
+
+        virtual int getConfig();
+        virtual int setActiveConfig(int index);
+        virtual int set(hwc_display_contents_1_t* contents);
+        virtual void dump(android::String8& result);
+
+    private:
+        int readEdidHash(uint32_t *hash);
+
+        ExternalModeCache mModeCache;
+        /* EDID hash of the sink the base class last enumerated modes for */
+        uint32_t    mEnumeratedEdidHash;
+        /* Reading the EDID failed once, do not log it on every hotplug */
+        bool        mEdidReadFailed;
+
+        nsecs_t     mHotplugTime;
+        bool        mFirstFramePending;
+        nsecs_t     mLastTimeToFirstFrame;
 };
 
 #endif
@@ -0,0 +1,11 @@
+# Host tests of the external display mode cache
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := libhdmimodule_tests
+LOCAL_MODULE_TAGS := tests
+LOCAL_C_INCLUDES := $(LOCAL_PATH)
+LOCAL_SRC_FILES := \
+	ExternalModeCache.cpp \
+	tests/ExternalModeCache_test.cpp
+LOCAL_SHARED_LIBRARIES := libutils liblog
+include $(BUILD_HOST_NATIVE_TEST)
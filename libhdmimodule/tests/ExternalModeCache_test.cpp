@@ -0,0 +1,120 @@
+/*
+ * Host tests for the external display mode cache: lookups per sink, mode
+ * changes of the connected sink and eviction of the least recently plugged
+ * sink.
+ */
+#include <gtest/gtest.h>
+
+#include "ExternalModeCache.h"
+
+#define SINK_A  0x1111
+#define SINK_B  0x2222
+#define SINK_C  0x3333
+
+TEST(ExternalModeCache, StoresModePerSink)
+{
+    ExternalModeCache cache(4);
+    int config = -1;
+
+    EXPECT_FALSE(cache.plug(SINK_A, 1, &config));
+    cache.store(3, 1);
+    EXPECT_FALSE(cache.plug(SINK_B, 2, &config));
+    cache.store(5, 2);
+
+    EXPECT_TRUE(cache.plug(SINK_A, 3, &config));
+    EXPECT_EQ(3, config);
+    EXPECT_TRUE(cache.plug(SINK_B, 4, &config));
+    EXPECT_EQ(5, config);
+}
+
+TEST(ExternalModeCache, UnknownSinksAreNotCached)
+{
+    ExternalModeCache cache(4);
+    int config = -1;
+
+    EXPECT_FALSE(cache.plug(0, 1, &config));
+    cache.store(3, 1);
+    cache.configChanged(4);
+    EXPECT_FALSE(cache.plug(0, 2, &config));
+    EXPECT_EQ(-1, config);
+}
+
+/* SurfaceFlinger changing the mode updates the connected sink only */
+TEST(ExternalModeCache, ConfigChangeFollowsTheConnectedSink)
+{
+    ExternalModeCache cache(4);
+    int config = -1;
+
+    cache.plug(SINK_A, 1, &config);
+    cache.store(3, 1);
+    cache.plug(SINK_B, 2, &config);
+    cache.store(5, 2);
+    cache.configChanged(6);
+
+    EXPECT_TRUE(cache.plug(SINK_A, 3, &config));
+    EXPECT_EQ(3, config);
+    EXPECT_TRUE(cache.plug(SINK_B, 4, &config));
+    EXPECT_EQ(6, config);
+
+    /* A sink not stored yet is not added by a mode change */
+    cache.plug(SINK_C, 5, &config);
+    cache.configChanged(7);
+    EXPECT_FALSE(cache.plug(SINK_C, 6, &config));
+}
+
+TEST(ExternalModeCache, EvictsTheLeastRecentlyPluggedSink)
+{
+    ExternalModeCache cache(2);
+    int config = -1;
+
+    cache.plug(SINK_A, 1, &config);
+    cache.store(1, 1);
+    cache.plug(SINK_B, 2, &config);
+    cache.store(2, 2);
+    /* Plugging A again makes B the oldest */
+    EXPECT_TRUE(cache.plug(SINK_A, 3, &config));
+
+    cache.plug(SINK_C, 4, &config);
+    cache.store(3, 4);
+    EXPECT_FALSE(cache.plug(SINK_B, 5, &config));
+    EXPECT_TRUE(cache.plug(SINK_A, 6, &config));
+    EXPECT_EQ(1, config);
+    EXPECT_TRUE(cache.plug(SINK_C, 7, &config));
+    EXPECT_EQ(3, config);
+}
+
+/* Storing a cached sink again replaces its mode without evicting another */
+TEST(ExternalModeCache, RestoringASinkDoesNotEvict)
+{
+    ExternalModeCache cache(2);
+    int config = -1;
+
+    cache.plug(SINK_A, 1, &config);
+    cache.store(1, 1);
+    cache.plug(SINK_B, 2, &config);
+    cache.store(2, 2);
+    cache.plug(SINK_A, 3, &config);
+    cache.store(4, 3);
+
+    EXPECT_TRUE(cache.plug(SINK_B, 4, &config));
+    EXPECT_EQ(2, config);
+    EXPECT_TRUE(cache.plug(SINK_A, 5, &config));
+    EXPECT_EQ(4, config);
+}
+
+TEST(ExternalModeCache, DumpShowsCounters)
+{
+    ExternalModeCache cache(4);
+    android::String8 result;
+    int config;
+
+    cache.plug(SINK_A, 1, &config);
+    cache.store(1, 1);
+    cache.countMiss();
+    cache.countHit();
+    cache.countHit();
+    cache.dump(result);
+
+    EXPECT_STREQ("  mode cache: 1 sinks, 2 hits, 1 misses, sink 00001111\n",
+            result.string());
+}
@@ -24,6 +24,8 @@
 #define VSYNC_DEV_MIDDLE ""
 #define VSYNC_DEV_NAME  "13960000.decon_f/vsync"
 
+#define HDMI_EDID_PATH  "/sys/class/hdmi/hdmi/edid"
+
 #define FIMD_WORD_SIZE_BYTES   16
 #define FIMD_BURSTLEN   8
 #define FIMD_ADDED_BURSTLEN_BYTES     4
@@ -129,6 +131,18 @@ static bool isVppType(enum decon_idma_type idma_type)
     }
 }
 
+/* Only the VGR DMAs can fetch from the secure (protected) ION heap */
+static bool isVgrType(enum decon_idma_type idma_type)
+{
+    switch (idma_type) {
+    case IDMA_VGR0:
+    case IDMA_VGR1:
+        return true;
+    default:
+        return false;
+    }
+}
+
 #ifdef FIMD_BW_OVERLAP_CHECK
 const size_t MAX_NUM_FIMD_DMA_CH = 2;
 const uint32_t FIMD_DMA_CH_IDX[] = {0, 1, 1, 1, 0};
@@ -32,3 +32,6 @@ LOCAL_MODULE_TAGS := optional
 LOCAL_MODULE_CLASS := SHARED_LIBRARIES
 
 include $(BUILD_SHARED_LIBRARY)
+
+# Host tests
+include $(LOCAL_PATH)/tests/Android.mk
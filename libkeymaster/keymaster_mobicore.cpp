@@ -18,6 +18,7 @@
 #include <errno.h>
 #include <string.h>
 #include <stdint.h>
+#include <pthread.h>
 
 #include <hardware/hardware.h>
 #include <hardware/keymaster0.h>
@@ -27,6 +28,7 @@
 #include <openssl/rsa.h>
 #include <openssl/err.h>
 #include <openssl/x509.h>
+#include <openssl/sha.h>
 
 #include <UniquePtr.h>
 
@@ -37,6 +39,7 @@
 
 #define RSA_KEY_BUFFER_SIZE   1536
 #define RSA_KEY_MAX_SIZE      (2048 >> 3)
+#define PUBKEY_CACHE_SIZE     16
 
 struct BIGNUM_Delete {
     void operator()(BIGNUM* p) const {
@@ -92,6 +95,140 @@ static void logOpenSSLError(const char* location) {
     ERR_remove_state(0);
 }
 
+/*
+ * Public keys of recently used key blobs, so signatures can be verified
+ * in the normal world without a round trip to the trustlet.
+ */
+struct pubkey_cache_entry {
+    uint8_t digest[SHA256_DIGEST_LENGTH];   /* SHA-256 of the key blob */
+    RSA* rsa;
+    uint64_t last_use;
+};
+
+static pubkey_cache_entry pubkey_cache[PUBKEY_CACHE_SIZE];
+static uint64_t pubkey_cache_clock;
+static pthread_mutex_t pubkey_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Retrieves the public key of a key blob from the trustlet.
+ */
+static RSA* exynos_km_load_rsa_public(const uint8_t* key_blob, const size_t key_blob_length) {
+    uint32_t bin_mod_len;
+    uint32_t bin_exp_len;
+    teeResult_t ret = TEE_ERR_NONE;
+
+    UniquePtr<uint8_t> binModPtr(reinterpret_cast<uint8_t*>(malloc(RSA_KEY_MAX_SIZE)));
+    if (binModPtr.get() == NULL) {
+        ALOGE("memory allocation is failed");
+        return NULL;
+    }
+
+    UniquePtr<uint8_t> binExpPtr(reinterpret_cast<uint8_t*>(malloc(sizeof(uint32_t))));
+    if (binExpPtr.get() == NULL) {
+        ALOGE("memory allocation is failed");
+        return NULL;
+    }
+
+    bin_mod_len = RSA_KEY_MAX_SIZE;
+    bin_exp_len = sizeof(uint32_t);
+
+    ret = TEE_GetPubKey(key_blob, key_blob_length, binModPtr.get(), &bin_mod_len, binExpPtr.get(),
+			&bin_exp_len);
+    if (ret != TEE_ERR_NONE) {
+        ALOGE("TEE_GetPubKey() is failed: %d", ret);
+        return NULL;
+    }
+
+    Unique_BIGNUM bn_mod(BN_new());
+    if (bn_mod.get() == NULL) {
+        ALOGE("memory allocation is failed");
+        return NULL;
+    }
+
+    Unique_BIGNUM bn_exp(BN_new());
+    if (bn_exp.get() == NULL) {
+        ALOGE("memory allocation is failed");
+        return NULL;
+    }
+
+    BN_bin2bn(binModPtr.get(), bin_mod_len, bn_mod.get());
+    BN_bin2bn(binExpPtr.get(), bin_exp_len, bn_exp.get());
+
+    /* assign to RSA */
+    Unique_RSA rsa(RSA_new());
+    if (rsa.get() == NULL) {
+        logOpenSSLError("rsa.get");
+        return NULL;
+    }
+
+    RSA* rsa_tmp = rsa.get();
+
+    rsa_tmp->n = bn_mod.release();
+    rsa_tmp->e = bn_exp.release();
+
+    return rsa.release();
+}
+
+/*
+ * Returns a reference to the public key of a key blob, from the cache if
+ * possible. The caller must RSA_free() it.
+ */
+static RSA* exynos_km_get_rsa_public(const uint8_t* key_blob, const size_t key_blob_length) {
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+    pubkey_cache_entry* entry = NULL;
+    RSA* rsa = NULL;
+
+    SHA256(key_blob, key_blob_length, digest);
+
+    pthread_mutex_lock(&pubkey_cache_lock);
+    for (size_t i = 0; i < PUBKEY_CACHE_SIZE; i++) {
+        if (pubkey_cache[i].rsa != NULL &&
+                memcmp(pubkey_cache[i].digest, digest, sizeof(digest)) == 0) {
+            pubkey_cache[i].last_use = ++pubkey_cache_clock;
+            rsa = pubkey_cache[i].rsa;
+            RSA_up_ref(rsa);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&pubkey_cache_lock);
+
+    if (rsa != NULL) {
+        return rsa;
+    }
+
+    /* cache miss, ask the trustlet */
+    rsa = exynos_km_load_rsa_public(key_blob, key_blob_length);
+    if (rsa == NULL) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&pubkey_cache_lock);
+    for (size_t i = 0; i < PUBKEY_CACHE_SIZE; i++) {
+        if (pubkey_cache[i].rsa != NULL &&
+                memcmp(pubkey_cache[i].digest, digest, sizeof(digest)) == 0) {
+            /* loaded by another thread in the meantime */
+            entry = NULL;
+            break;
+        }
+        if (entry == NULL || pubkey_cache[i].rsa == NULL ||
+                (entry->rsa != NULL && pubkey_cache[i].last_use < entry->last_use)) {
+            entry = &pubkey_cache[i];
+        }
+    }
+    if (entry != NULL) {
+        if (entry->rsa != NULL) {
+            RSA_free(entry->rsa);
+        }
+        memcpy(entry->digest, digest, sizeof(digest));
+        entry->rsa = rsa;
+        entry->last_use = ++pubkey_cache_clock;
+        RSA_up_ref(rsa);
+    }
+    pthread_mutex_unlock(&pubkey_cache_lock);
+
+    return rsa;
+}
+
 static int exynos_km_generate_keypair(const keymaster0_device_t* dev,
         const keymaster_keypair_t key_type, const void* key_params,
         uint8_t** keyBlob, size_t* keyBlobLength) {
@@ -236,64 +373,16 @@ static int exynos_km_import_keypair(const keymaster0_device_t* dev,
 static int exynos_km_get_keypair_public(const keymaster0_device_t* dev,
         const uint8_t* key_blob, const size_t key_blob_length,
         uint8_t** x509_data, size_t* x509_data_length) {
-    uint32_t bin_mod_len;
-    uint32_t bin_exp_len;
-    teeResult_t ret = TEE_ERR_NONE;
-
     if (x509_data == NULL || x509_data_length == NULL) {
         ALOGE("output public key buffer == NULL");
         return -1;
     }
 
-    UniquePtr<uint8_t> binModPtr(reinterpret_cast<uint8_t*>(malloc(RSA_KEY_MAX_SIZE)));
-    if (binModPtr.get() == NULL) {
-        ALOGE("memory allocation is failed");
-        return -1;
-    }
-
-    UniquePtr<uint8_t> binExpPtr(reinterpret_cast<uint8_t*>(malloc(sizeof(uint32_t))));
-    if (binExpPtr.get() == NULL) {
-        ALOGE("memory allocation is failed");
-        return -1;
-    }
-
-    bin_mod_len = RSA_KEY_MAX_SIZE;
-    bin_exp_len = sizeof(uint32_t);
-
-    ret = TEE_GetPubKey(key_blob, key_blob_length, binModPtr.get(), &bin_mod_len, binExpPtr.get(),
-			&bin_exp_len);
-    if (ret != TEE_ERR_NONE) {
-        ALOGE("TEE_GetPubKey() is failed: %d", ret);
-        return -1;
-    }
-
-    Unique_BIGNUM bn_mod(BN_new());
-    if (bn_mod.get() == NULL) {
-        ALOGE("memory allocation is failed");
-        return -1;
-    }
-
-    Unique_BIGNUM bn_exp(BN_new());
-    if (bn_exp.get() == NULL) {
-        ALOGE("memory allocation is failed");
-        return -1;
-    }
-
-    BN_bin2bn(binModPtr.get(), bin_mod_len, bn_mod.get());
-    BN_bin2bn(binExpPtr.get(), bin_exp_len, bn_exp.get());
-
-    /* assign to RSA */
-    Unique_RSA rsa(RSA_new());
+    Unique_RSA rsa(exynos_km_get_rsa_public(key_blob, key_blob_length));
     if (rsa.get() == NULL) {
-        logOpenSSLError("rsa.get");
         return -1;
     }
 
-    RSA* rsa_tmp = rsa.get();
-
-    rsa_tmp->n = bn_mod.release();
-    rsa_tmp->e = bn_exp.release();
-
     /* assign to EVP */
     Unique_EVP_PKEY pkey(EVP_PKEY_new());
     if (pkey.get() == NULL) {
@@ -405,6 +494,26 @@ static int exynos_km_verify_data(const keymaster0_device_t* dev,
         return -1;
     }
 
+    /* raw RSA needs only the public key, verify in the normal world */
+    Unique_RSA rsa(exynos_km_get_rsa_public(keyBlob, keyBlobLength));
+    if (rsa.get() != NULL && signatureLength == (size_t) RSA_size(rsa.get())) {
+        UniquePtr<uint8_t> decrypted(reinterpret_cast<uint8_t*>(malloc(signatureLength)));
+        if (decrypted.get() == NULL) {
+            ALOGE("memory allocation is failed");
+            return -1;
+        }
+
+        int len = RSA_public_decrypt(signatureLength, signature, decrypted.get(), rsa.get(),
+                RSA_NO_PADDING);
+        if (len < 0) {
+            logOpenSSLError("RSA_public_decrypt");
+            return -1;
+        }
+
+        return ((size_t) len == signedDataLength &&
+                memcmp(decrypted.get(), signedData, signedDataLength) == 0) ? 0 : -1;
+    }
+
     void *tmpSignedData = malloc(signedDataLength);
     memcpy(tmpSignedData, signedData, signedDataLength);
     void *tmpSig = malloc(signatureLength);
@@ -0,0 +1,38 @@
+# Host tests of the keymaster TLC, run against a simulated MobiCore client
+# library instead of libMcClient.
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := keystore_exynos5_tlc_tests
+LOCAL_MODULE_TAGS := tests
+LOCAL_SRC_FILES := \
+	tlcTeeKeymaster_if.c \
+	tests/McClientStub.cpp \
+	tests/tlcTeeKeymaster_test.cpp
+LOCAL_C_INCLUDES := \
+	$(LOCAL_PATH) \
+	$(MOBICORE_PATH)/daemon/ClientLib/public \
+	$(MOBICORE_PATH)/common/MobiCore/inc/
+LOCAL_CFLAGS := -Wall -Wno-pointer-to-int-cast
+LOCAL_SHARED_LIBRARIES := liblog
+
+include $(BUILD_HOST_NATIVE_TEST)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := keystore_exynos5_hal_tests
+LOCAL_MODULE_TAGS := tests
+LOCAL_SRC_FILES := \
+	keymaster_mobicore.cpp \
+	tlcTeeKeymaster_if.c \
+	tests/McClientStub.cpp \
+	tests/keymaster_mobicore_test.cpp
+LOCAL_C_INCLUDES := \
+	$(LOCAL_PATH) \
+	external/openssl/include \
+	$(MOBICORE_PATH)/daemon/ClientLib/public \
+	$(MOBICORE_PATH)/common/MobiCore/inc/
+LOCAL_CFLAGS := -Wall -Wno-pointer-to-int-cast
+LOCAL_SHARED_LIBRARIES := libcrypto-host liblog
+
+include $(BUILD_HOST_NATIVE_TEST)
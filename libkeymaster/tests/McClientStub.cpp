@@ -0,0 +1,329 @@
+/**
+ * @file
+ *
+ * Simulated MobiCore client library for the keymaster TLC host tests.
+ *
+ * Copyright (c) 2013 TRUSTONIC LIMITED
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the TRUSTONIC LIMITED nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <map>
+#include <vector>
+
+#include "MobiCoreDriverApi.h"
+#include "tlTeeKeymaster_Api.h"
+#include "McClientStub.h"
+
+/* Secure world address of the n-th mapping of a session */
+#define SVA_SLOT_SIZE   0x100000
+
+#define SIGNATURE_SIZE  256
+
+struct bulkMapping {
+    uint8_t     *buffer;
+    uint32_t    len;
+};
+
+struct stubSession {
+    tciMessage_t *tci;
+    std::map<uint32_t, bulkMapping> mappings;   // by secure world address
+    uint32_t    nextSva;
+};
+
+mcStub_t mcStub;
+
+static pthread_mutex_t stubMutex = PTHREAD_MUTEX_INITIALIZER;
+static std::map<uint32_t, stubSession> sessions;
+static uint32_t nextSessionId = 1;
+static bool deviceOpen = false;
+
+void mcStubReset(uint32_t waitUs)
+{
+    pthread_mutex_lock(&stubMutex);
+    long liveSessions = mcStub.liveSessions;
+    long liveMaps = mcStub.liveMaps;
+    memset(&mcStub, 0, sizeof(mcStub));
+    mcStub.openSessionUs = waitUs * 10;
+    mcStub.mapUs = waitUs / 10;
+    mcStub.waitUs = waitUs;
+    mcStub.liveSessions = liveSessions;
+    mcStub.maxLiveSessions = liveSessions;
+    mcStub.liveMaps = liveMaps;
+    pthread_mutex_unlock(&stubMutex);
+}
+
+long mcStubMappedNonZero(void)
+{
+    long nonZero = 0;
+    pthread_mutex_lock(&stubMutex);
+    for (std::map<uint32_t, stubSession>::iterator it = sessions.begin();
+         it != sessions.end(); ++it) {
+        std::map<uint32_t, bulkMapping> &mappings = it->second.mappings;
+        for (std::map<uint32_t, bulkMapping>::iterator m = mappings.begin();
+             m != mappings.end(); ++m) {
+            for (uint32_t i = 0; i < m->second.len; i++) {
+                nonZero += (m->second.buffer[i] != 0);
+            }
+        }
+    }
+    pthread_mutex_unlock(&stubMutex);
+    return nonZero;
+}
+
+static void cost(uint32_t us)
+{
+    if (us != 0) {
+        usleep(us);
+    }
+}
+
+/* Host address of a secure world buffer, the trustlet aborts on a buffer
+ * which is not inside one mapping */
+static uint8_t *translate(stubSession &session, uint32_t sva, uint32_t len)
+{
+    uint32_t base = sva - (sva % SVA_SLOT_SIZE);
+    std::map<uint32_t, bulkMapping>::iterator it = session.mappings.find(base);
+    if ((it == session.mappings.end()) || (sva - base + len > it->second.len)) {
+        fprintf(stderr, "trustlet: buffer 0x%x+%u is not mapped\n", sva, len);
+        abort();
+    }
+    return it->second.buffer + (sva - base);
+}
+
+static void sign(stubSession &session, rsasign_t *cmd)
+{
+    uint8_t *key = translate(session, cmd->keydata, cmd->keydatalen);
+    uint8_t *plain = translate(session, cmd->plaindata, cmd->plaindatalen);
+    if (cmd->signaturedatalen >= SIGNATURE_SIZE) {
+        uint8_t *signature = translate(session, cmd->signaturedata, SIGNATURE_SIZE);
+        for (uint32_t i = 0; i < SIGNATURE_SIZE; i++) {
+            signature[i] = plain[i % cmd->plaindatalen] ^ key[0];
+        }
+    }
+    cmd->signaturedatalen = SIGNATURE_SIZE;
+}
+
+static void verify(stubSession &session, rsaverify_t *cmd)
+{
+    uint8_t *key = translate(session, cmd->keydata, cmd->keydatalen);
+    uint8_t *plain = translate(session, cmd->plaindata, cmd->plaindatalen);
+    uint8_t *signature = translate(session, cmd->signaturedata, cmd->signaturedatalen);
+    cmd->validity = (cmd->signaturedatalen == SIGNATURE_SIZE);
+    for (uint32_t i = 0; cmd->validity && (i < SIGNATURE_SIZE); i++) {
+        cmd->validity = (signature[i] == (uint8_t) (plain[i % cmd->plaindatalen] ^ key[0]));
+    }
+}
+
+static uint32_t getPubKey(stubSession &session, getpubkey_t *cmd)
+{
+    mcStub.pubKeyReads++;
+    if (mcStub.getPubKey == NULL) {
+        return RET_ERR_NOT_SUPPORTED;
+    }
+    return mcStub.getPubKey(translate(session, cmd->keydata, cmd->keydatalen), cmd->keydatalen,
+                            translate(session, cmd->modulus, cmd->moduluslen), &cmd->moduluslen,
+                            translate(session, cmd->exponent, cmd->exponentlen),
+                            &cmd->exponentlen);
+}
+
+static void runCommand(stubSession &session)
+{
+    tciMessage_t *tci = session.tci;
+    uint32_t returnCode = RET_OK;
+
+    switch (tci->command.header.commandId) {
+    case CMD_ID_TEE_RSA_SIGN:
+        sign(session, &tci->rsasign);
+        break;
+    case CMD_ID_TEE_RSA_VERIFY:
+        verify(session, &tci->rsaverify);
+        break;
+    case CMD_ID_TEE_GET_PUB_KEY:
+        returnCode = getPubKey(session, &tci->getpubkey);
+        break;
+    default:
+        break;
+    }
+    if (mcStub.trustletReturnCode != RET_OK) {
+        returnCode = mcStub.trustletReturnCode;
+    }
+    tci->response.header.responseId = RSP_ID(tci->command.header.commandId);
+    tci->response.header.returnCode = returnCode;
+}
+
+//------------------------------------------------------------------------------
+__MC_CLIENT_LIB_API mcResult_t mcOpenDevice(uint32_t deviceId)
+{
+    (void) deviceId;
+    pthread_mutex_lock(&stubMutex);
+    bool wasOpen = deviceOpen;
+    deviceOpen = true;
+    pthread_mutex_unlock(&stubMutex);
+    return wasOpen ? MC_DRV_ERR_DEVICE_ALREADY_OPEN : MC_DRV_OK;
+}
+
+__MC_CLIENT_LIB_API mcResult_t mcCloseDevice(uint32_t deviceId)
+{
+    (void) deviceId;
+    pthread_mutex_lock(&stubMutex);
+    deviceOpen = false;
+    pthread_mutex_unlock(&stubMutex);
+    return MC_DRV_OK;
+}
+
+__MC_CLIENT_LIB_API mcResult_t mcMallocWsm(uint32_t deviceId, uint32_t align,
+                                           uint32_t len, uint8_t **wsm, uint32_t wsmFlags)
+{
+    (void) deviceId;
+    (void) align;
+    (void) wsmFlags;
+    *wsm = (uint8_t *) calloc(1, len);
+    return (*wsm != NULL) ? MC_DRV_OK : MC_DRV_ERR_NO_FREE_MEMORY;
+}
+
+__MC_CLIENT_LIB_API mcResult_t mcFreeWsm(uint32_t deviceId, uint8_t *wsm)
+{
+    (void) deviceId;
+    free(wsm);
+    return MC_DRV_OK;
+}
+
+__MC_CLIENT_LIB_API mcResult_t mcOpenSession(mcSessionHandle_t *session,
+                                             const mcUuid_t *uuid, uint8_t *tci, uint32_t tciLen)
+{
+    (void) uuid;
+    (void) tciLen;
+    cost(mcStub.openSessionUs);
+
+    pthread_mutex_lock(&stubMutex);
+    session->sessionId = nextSessionId++;
+    stubSession &s = sessions[session->sessionId];
+    s.tci = (tciMessage_t *) tci;
+    s.nextSva = SVA_SLOT_SIZE;
+    mcStub.sessionsOpened++;
+    mcStub.liveSessions++;
+    if (mcStub.liveSessions > mcStub.maxLiveSessions) {
+        mcStub.maxLiveSessions = mcStub.liveSessions;
+    }
+    pthread_mutex_unlock(&stubMutex);
+    return MC_DRV_OK;
+}
+
+__MC_CLIENT_LIB_API mcResult_t mcCloseSession(mcSessionHandle_t *session)
+{
+    pthread_mutex_lock(&stubMutex);
+    std::map<uint32_t, stubSession>::iterator it = sessions.find(session->sessionId);
+    if (it == sessions.end()) {
+        pthread_mutex_unlock(&stubMutex);
+        return MC_DRV_ERR_UNKNOWN_SESSION;
+    }
+    // Closing a session drops its mappings
+    mcStub.liveMaps -= it->second.mappings.size();
+    sessions.erase(it);
+    mcStub.sessionsClosed++;
+    mcStub.liveSessions--;
+    pthread_mutex_unlock(&stubMutex);
+    return MC_DRV_OK;
+}
+
+__MC_CLIENT_LIB_API mcResult_t mcMap(mcSessionHandle_t *session, void *buf,
+                                     uint32_t len, mcBulkMap_t *mapInfo)
+{
+    cost(mcStub.mapUs);
+
+    pthread_mutex_lock(&stubMutex);
+    std::map<uint32_t, stubSession>::iterator it = sessions.find(session->sessionId);
+    if (it == sessions.end()) {
+        pthread_mutex_unlock(&stubMutex);
+        return MC_DRV_ERR_UNKNOWN_SESSION;
+    }
+    uint32_t sva = it->second.nextSva;
+    it->second.nextSva += SVA_SLOT_SIZE;
+    bulkMapping mapping = {(uint8_t *) buf, len};
+    it->second.mappings[sva] = mapping;
+    mcStub.maps++;
+    mcStub.liveMaps++;
+    pthread_mutex_unlock(&stubMutex);
+
+    mapInfo->sVirtualAddr = (void *) (uintptr_t) sva;
+    mapInfo->sVirtualLen = len;
+    return MC_DRV_OK;
+}
+
+__MC_CLIENT_LIB_API mcResult_t mcUnmap(mcSessionHandle_t *session, void *buf,
+                                       mcBulkMap_t *mapInfo)
+{
+    (void) buf;
+    pthread_mutex_lock(&stubMutex);
+    std::map<uint32_t, stubSession>::iterator it = sessions.find(session->sessionId);
+    if ((it == sessions.end()) ||
+        (it->second.mappings.erase((uint32_t) (uintptr_t) mapInfo->sVirtualAddr) == 0)) {
+        pthread_mutex_unlock(&stubMutex);
+        return MC_DRV_ERR_BULK_UNMAPPING;
+    }
+    mcStub.liveMaps--;
+    pthread_mutex_unlock(&stubMutex);
+    return MC_DRV_OK;
+}
+
+__MC_CLIENT_LIB_API mcResult_t mcNotify(mcSessionHandle_t *session)
+{
+    pthread_mutex_lock(&stubMutex);
+    mcStub.notifies++;
+    bool fail = (mcStub.failNotifyEvery != 0) &&
+                (mcStub.notifies % mcStub.failNotifyEvery == 0);
+    bool known = (sessions.find(session->sessionId) != sessions.end());
+    pthread_mutex_unlock(&stubMutex);
+
+    if (!known) {
+        return MC_DRV_ERR_UNKNOWN_SESSION;
+    }
+    return fail ? MC_DRV_ERR_NOTIFICATION : MC_DRV_OK;
+}
+
+__MC_CLIENT_LIB_API mcResult_t mcWaitNotification(mcSessionHandle_t *session, int32_t timeout)
+{
+    (void) timeout;
+    cost(mcStub.waitUs);
+
+    pthread_mutex_lock(&stubMutex);
+    std::map<uint32_t, stubSession>::iterator it = sessions.find(session->sessionId);
+    if (it == sessions.end()) {
+        pthread_mutex_unlock(&stubMutex);
+        return MC_DRV_ERR_UNKNOWN_SESSION;
+    }
+    runCommand(it->second);
+    mcStub.commands++;
+    pthread_mutex_unlock(&stubMutex);
+    return MC_DRV_OK;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file
+ *
+ * Simulated MobiCore client library for the keymaster TLC host tests.
+ * 
+ * Implements the mc* calls used by tlcTeeKeymaster_if.c on top of a fake
+ * keymaster trustlet and counts what the TLC asks of the driver.
+ *
+ * Copyright (c) 2013 TRUSTONIC LIMITED
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the TRUSTONIC LIMITED nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef MCCLIENTSTUB_H_
+#define MCCLIENTSTUB_H_
+
+#include <stdint.h>
+
+/** Costs, failures and counters of the simulated driver. The trustlet signs
+ * by writing signature[i] = plain[i % plainlen] ^ key[0] for 256 bytes,
+ * verify checks the same relation. */
+typedef struct {
+    /* Simulated cost of the driver calls in microseconds */
+    uint32_t openSessionUs;
+    uint32_t mapUs;
+    uint32_t waitUs;
+
+    /* Every failNotifyEvery-th notification fails, 0 for never */
+    uint32_t failNotifyEvery;
+
+    /* Return code of the trustlet for every command, RET_OK by default */
+    uint32_t trustletReturnCode;
+
+    /* Public key of a key blob for CMD_ID_TEE_GET_PUB_KEY, returns the
+     * trustlet return code. Without it the command is not supported. */
+    uint32_t (*getPubKey)(const uint8_t *keyData, uint32_t keyDataLength,
+                          uint8_t *modulus, uint32_t *modulusLength,
+                          uint8_t *exponent, uint32_t *exponentLength);
+
+    long     sessionsOpened;
+    long     sessionsClosed;
+    long     liveSessions;
+    long     maxLiveSessions;
+    long     maps;
+    long     liveMaps;
+    long     notifies;
+    long     commands;
+    long     pubKeyReads;
+} mcStub_t;
+
+extern mcStub_t mcStub;
+
+/** Resets counters and failures, costs are set to the given wait time and
+ * to a tenth of it for the other calls. Sessions still open stay open. */
+void mcStubReset(uint32_t waitUs);
+
+/** Number of non-zero bytes in the buffers still mapped to any session */
+long mcStubMappedNonZero(void);
+
+#endif /* MCCLIENTSTUB_H_ */
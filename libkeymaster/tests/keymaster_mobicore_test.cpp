@@ -0,0 +1,223 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host tests for the public key cache of the Exynos keymaster HAL. The HAL
+ * runs on the simulated MobiCore client library, whose trustlet hands out
+ * the public key of one RSA-2048 key pair for every key blob.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <gtest/gtest.h>
+
+#include <hardware/keymaster0.h>
+
+#include <openssl/bn.h>
+#include <openssl/rsa.h>
+#include <openssl/x509.h>
+
+#include "tlTeeKeymaster_Api.h"
+#include "tlcTeeKeymaster_if.h"
+#include "McClientStub.h"
+
+#define KEY_BLOB_SIZE   1280
+#define KEY_SIZE        256
+
+extern struct keystore_module HAL_MODULE_INFO_SYM;
+
+static RSA* gKey;
+
+static double nowSec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Trustlet side of TEE_GetPubKey(), every blob holds gKey */
+static uint32_t getPubKey(const uint8_t*, uint32_t, uint8_t* modulus, uint32_t* modulusLength,
+        uint8_t* exponent, uint32_t* exponentLength) {
+    if (*modulusLength < (uint32_t) BN_num_bytes(gKey->n) ||
+            *exponentLength < (uint32_t) BN_num_bytes(gKey->e)) {
+        return RET_ERR_INVALID_LENGTH;
+    }
+    *modulusLength = BN_bn2bin(gKey->n, modulus);
+    *exponentLength = BN_bn2bin(gKey->e, exponent);
+    return RET_OK;
+}
+
+class KeymasterPubkeyCache : public testing::Test {
+protected:
+    static void SetUpTestCase() {
+        BIGNUM* e = BN_new();
+        BN_set_word(e, RSA_F4);
+        gKey = RSA_new();
+        ASSERT_EQ(1, RSA_generate_key_ex(gKey, KEY_SIZE * 8, e, NULL));
+        BN_free(e);
+    }
+
+    static void TearDownTestCase() {
+        RSA_free(gKey);
+    }
+
+    virtual void SetUp() {
+        mcStubReset(20);
+        mcStub.getPubKey = getPubKey;
+        ASSERT_EQ(0, keymaster0_open(&HAL_MODULE_INFO_SYM.common, &dev));
+
+        params.digest_type = DIGEST_NONE;
+        params.padding_type = PADDING_NONE;
+        for (int i = 0; i < KEY_SIZE; i++) {
+            data[i] = (uint8_t) i;
+        }
+        data[0] = 0;    // below the modulus
+        ASSERT_EQ(KEY_SIZE, RSA_private_encrypt(KEY_SIZE, data, signature, gKey,
+                                                RSA_NO_PADDING));
+    }
+
+    virtual void TearDown() {
+        keymaster0_close(dev);
+    }
+
+    /** Key blob number id, each one has its own cache entry */
+    static void makeBlob(uint8_t* blob, int id) {
+        memset(blob, 0, KEY_BLOB_SIZE);
+        memcpy(blob, &id, sizeof(id));
+        blob[KEY_BLOB_SIZE - 1] = 0xb1;
+    }
+
+    int verify(int id) {
+        uint8_t blob[KEY_BLOB_SIZE];
+        makeBlob(blob, id);
+        return dev->verify_data(dev, &params, blob, sizeof(blob), data, sizeof(data),
+                                signature, sizeof(signature));
+    }
+
+    keymaster0_device_t* dev;
+    keymaster_rsa_sign_params_t params;
+    uint8_t data[KEY_SIZE];
+    uint8_t signature[KEY_SIZE];
+};
+
+TEST_F(KeymasterPubkeyCache, VerifiesInTheNormalWorld) {
+    EXPECT_EQ(0, verify(1000));
+    EXPECT_EQ(1, mcStub.pubKeyReads);
+
+    for (int i = 0; i < 100; i++) {
+        ASSERT_EQ(0, verify(1000));
+    }
+    EXPECT_EQ(1, mcStub.commands);
+}
+
+TEST_F(KeymasterPubkeyCache, RejectsCorruptedSignature) {
+    signature[KEY_SIZE / 2] ^= 1;
+    EXPECT_EQ(-1, verify(1001));
+
+    signature[KEY_SIZE / 2] ^= 1;
+    data[7] ^= 1;
+    EXPECT_EQ(-1, verify(1001));
+}
+
+/* Without a public key the trustlet verifies, as before */
+TEST_F(KeymasterPubkeyCache, FallsBackToTheTrustlet) {
+    mcStub.getPubKey = NULL;
+    uint8_t blob[KEY_BLOB_SIZE];
+    makeBlob(blob, 1002);
+
+    // Signature of the simulated trustlet
+    for (int i = 0; i < KEY_SIZE; i++) {
+        signature[i] = data[i] ^ blob[0];
+    }
+    EXPECT_EQ(0, verify(1002));
+    EXPECT_EQ(2, mcStub.commands);
+
+    signature[3] ^= 1;
+    EXPECT_EQ(-1, verify(1002));
+}
+
+/* The least recently used of 16 keys makes room for a new one */
+TEST_F(KeymasterPubkeyCache, EvictsLeastRecentlyUsed) {
+    for (int id = 0; id < 16; id++) {
+        ASSERT_EQ(0, verify(id));
+    }
+    ASSERT_EQ(0, verify(0));
+    EXPECT_EQ(16, mcStub.pubKeyReads);
+
+    // Evicts key 1, key 0 was used last
+    ASSERT_EQ(0, verify(16));
+    ASSERT_EQ(0, verify(0));
+    EXPECT_EQ(17, mcStub.pubKeyReads);
+    ASSERT_EQ(0, verify(1));
+    EXPECT_EQ(18, mcStub.pubKeyReads);
+}
+
+TEST_F(KeymasterPubkeyCache, PublicKeyExportSharesTheCache) {
+    uint8_t blob[KEY_BLOB_SIZE];
+    makeBlob(blob, 1003);
+    ASSERT_EQ(0, verify(1003));
+
+    uint8_t* x509 = NULL;
+    size_t x509Length = 0;
+    ASSERT_EQ(0, dev->get_keypair_public(dev, blob, sizeof(blob), &x509, &x509Length));
+    EXPECT_EQ(1, mcStub.pubKeyReads);
+
+    const unsigned char* p = x509;
+    EVP_PKEY* pkey = d2i_PUBKEY(NULL, &p, x509Length);
+    ASSERT_TRUE(pkey != NULL);
+    RSA* rsa = EVP_PKEY_get1_RSA(pkey);
+    ASSERT_TRUE(rsa != NULL);
+    EXPECT_EQ(0, BN_cmp(rsa->n, gKey->n));
+    RSA_free(rsa);
+    EVP_PKEY_free(pkey);
+    free(x509);
+}
+
+/* Cost of a verify in the trustlet and in the normal world, with hot keys
+ * and with more keys than the cache holds */
+TEST_F(KeymasterPubkeyCache, VerifyCost) {
+    const int verifies = 1000;
+    const int keys[] = {8, 20};
+    uint8_t blob[KEY_BLOB_SIZE];
+    bool validity;
+
+    mcStubReset(400);
+    makeBlob(blob, 2000);
+    for (int i = 0; i < KEY_SIZE; i++) {
+        signature[i] = data[i] ^ blob[0];
+    }
+    double start = nowSec();
+    for (int i = 0; i < verifies / 4; i++) {
+        ASSERT_EQ(TEE_ERR_NONE, TEE_RSAVerify(blob, sizeof(blob), data, sizeof(data), signature,
+                                              sizeof(signature), TEE_RSA_NODIGEST_NOPADDING,
+                                              &validity));
+    }
+    printf("trustlet verify:            %6.1f us\n", (nowSec() - start) / (verifies / 4) * 1e6);
+
+    RSA_private_encrypt(KEY_SIZE, data, signature, gKey, RSA_NO_PADDING);
+    for (size_t k = 0; k < sizeof(keys) / sizeof(keys[0]); k++) {
+        mcStubReset(400);
+        mcStub.getPubKey = getPubKey;
+        start = nowSec();
+        for (int i = 0; i < verifies; i++) {
+            ASSERT_EQ(0, verify(3000 + k * 100 + i % keys[k]));
+        }
+        printf("normal world, %2d keys:      %6.1f us, %ld public key reads\n", keys[k],
+               (nowSec() - start) / verifies * 1e6, mcStub.pubKeyReads);
+    }
+}
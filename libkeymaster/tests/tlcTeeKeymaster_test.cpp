@@ -0,0 +1,487 @@
+/**
+ * @file
+ *
+ * Host tests for the keymaster TLC on a simulated MobiCore driver.
+ * 
+ * The TLC keeps its session pool for the lifetime of the process, so the
+ * tests check counter deltas rather than absolute session counts.
+ *
+ * Copyright (c) 2013 TRUSTONIC LIMITED
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the TRUSTONIC LIMITED nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <gtest/gtest.h>
+
+#include "tlcTeeKeymaster_if.h"
+#include "tlTeeKeymaster_Api.h"
+#include "McClientStub.h"
+
+/* Size of the session pool in tlcTeeKeymaster_if.c */
+#define POOL_SIZE       4
+
+#define SIGNATURE_SIZE  256
+
+static double nowSec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+//------------------------------------------------------------------------------
+class KeymasterTlc: public testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        mcStubReset(20);
+        memset(key, 0, sizeof(key));
+        key[0] = 0x5a;
+        for (size_t i = 0; i < sizeof(plain); i++) {
+            plain[i] = (uint8_t) (i * 7);
+        }
+    }
+
+    uint8_t key[1024];
+    uint8_t plain[64];
+
+    /** Signs plain and checks the signature of the simulated trustlet */
+    static teeResult_t signAndCheck(const uint8_t *key, size_t keyLength,
+                                    const uint8_t *plain, uint32_t plainLength)
+    {
+        uint8_t signature[SIGNATURE_SIZE];
+        size_t signatureLength = sizeof(signature);
+
+        memset(signature, 0, sizeof(signature));
+        teeResult_t ret = TEE_RSASign(key, keyLength, plain, plainLength, signature,
+                                      &signatureLength, TEE_RSA_NODIGEST_NOPADDING);
+        if (ret != TEE_ERR_NONE) {
+            return ret;
+        }
+        EXPECT_EQ((size_t) SIGNATURE_SIZE, signatureLength);
+        for (size_t i = 0; i < SIGNATURE_SIZE; i++) {
+            if (signature[i] != (uint8_t) (plain[i % plainLength] ^ key[0])) {
+                ADD_FAILURE() << "bad signature byte " << i;
+                break;
+            }
+        }
+        return ret;
+    }
+};
+
+/* Parallel signers, each counting its failures by result */
+struct signer {
+    const uint8_t   *key;
+    const uint8_t   *plain;
+    int             signs;
+    int             ok;
+    int             notificationErrors;
+    int             otherErrors;
+};
+
+static void *runSigner(void *arg)
+{
+    signer *s = (signer *) arg;
+    uint8_t signature[SIGNATURE_SIZE];
+
+    for (int i = 0; i < s->signs; i++) {
+        size_t signatureLength = sizeof(signature);
+        teeResult_t ret = TEE_RSASign(s->key, 1024, s->plain, 64, signature,
+                                      &signatureLength, TEE_RSA_NODIGEST_NOPADDING);
+        if (ret == TEE_ERR_NONE) {
+            s->ok++;
+        } else if (ret == TEE_ERR_NOTIFICATION) {
+            s->notificationErrors++;
+        } else {
+            s->otherErrors++;
+        }
+    }
+    return NULL;
+}
+
+static void runSigners(signer *signers, int count)
+{
+    pthread_t threads[count];
+    for (int i = 0; i < count; i++) {
+        ASSERT_EQ(0, pthread_create(&threads[i], NULL, runSigner, &signers[i]));
+    }
+    for (int i = 0; i < count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST_F(KeymasterTlc, PoolReusesOpenSessions)
+{
+    long liveMaps = mcStub.liveMaps;
+
+    for (int i = 0; i < 200; i++) {
+        ASSERT_EQ(TEE_ERR_NONE, signAndCheck(key, sizeof(key), plain, sizeof(plain)));
+    }
+    EXPECT_LE(mcStub.sessionsOpened, 1);
+    EXPECT_EQ(0, mcStub.sessionsClosed);
+    EXPECT_EQ(200, mcStub.commands);
+    EXPECT_EQ(liveMaps + mcStub.sessionsOpened, mcStub.liveMaps);
+}
+
+TEST_F(KeymasterTlc, PoolBoundsConcurrentSessions)
+{
+    signer signers[8];
+    memset(signers, 0, sizeof(signers));
+    for (int i = 0; i < 8; i++) {
+        signers[i].key = key;
+        signers[i].plain = plain;
+        signers[i].signs = 50;
+    }
+    mcStub.waitUs = 200;
+
+    runSigners(signers, 8);
+    for (int i = 0; i < 8; i++) {
+        EXPECT_EQ(50, signers[i].ok);
+    }
+    EXPECT_LE(mcStub.maxLiveSessions, POOL_SIZE);
+    EXPECT_EQ(0, mcStub.sessionsClosed);
+}
+
+/* A failed notification closes the session, the next user reopens it and
+ * the other callers are not affected */
+TEST_F(KeymasterTlc, CommunicationErrorReopensSession)
+{
+    signer signers[8];
+    memset(signers, 0, sizeof(signers));
+    for (int i = 0; i < 8; i++) {
+        signers[i].key = key;
+        signers[i].plain = plain;
+        signers[i].signs = 50;
+    }
+    mcStub.failNotifyEvery = 10;
+
+    runSigners(signers, 8);
+    int failures = 0;
+    for (int i = 0; i < 8; i++) {
+        EXPECT_EQ(0, signers[i].otherErrors);
+        EXPECT_EQ(50, signers[i].ok + signers[i].notificationErrors);
+        failures += signers[i].notificationErrors;
+    }
+    EXPECT_EQ(mcStub.notifies / 10, failures);
+    EXPECT_EQ(failures, mcStub.sessionsClosed);
+    EXPECT_LE(mcStub.sessionsOpened, failures + POOL_SIZE);
+    EXPECT_LE(mcStub.maxLiveSessions, POOL_SIZE);
+
+    mcStub.failNotifyEvery = 0;
+    EXPECT_EQ(TEE_ERR_NONE, signAndCheck(key, sizeof(key), plain, sizeof(plain)));
+}
+
+/* An error of the trustlet leaves the session in the pool */
+TEST_F(KeymasterTlc, TrustletErrorKeepsSession)
+{
+    uint8_t signature[SIGNATURE_SIZE];
+    size_t signatureLength = sizeof(signature);
+
+    mcStub.trustletReturnCode = RET_ERR_SIGN;
+    EXPECT_EQ(TEE_ERR_FAIL, TEE_RSASign(key, sizeof(key), plain, sizeof(plain), signature,
+                                        &signatureLength, TEE_RSA_NODIGEST_NOPADDING));
+    EXPECT_EQ(0, mcStub.sessionsClosed);
+
+    mcStub.trustletReturnCode = RET_OK;
+    EXPECT_EQ(TEE_ERR_NONE, signAndCheck(key, sizeof(key), plain, sizeof(plain)));
+    EXPECT_EQ(0, mcStub.sessionsOpened);
+}
+
+static void *runOneSign(void *arg)
+{
+    signer *s = (signer *) arg;
+    s->signs = 1;
+    return runSigner(arg);
+}
+
+/* Loading the trustlet for a new session does not stall callers which get
+ * a session that is already open */
+TEST_F(KeymasterTlc, SessionOpenDoesNotBlockPool)
+{
+    // Close every pooled session, then open exactly one again
+    mcStub.failNotifyEvery = 1;
+    for (int i = 0; i < POOL_SIZE; i++) {
+        signAndCheck(key, sizeof(key), plain, sizeof(plain));
+    }
+    mcStub.failNotifyEvery = 0;
+    ASSERT_EQ(TEE_ERR_NONE, signAndCheck(key, sizeof(key), plain, sizeof(plain)));
+    mcStubReset(20000);
+    mcStub.openSessionUs = 500000;
+
+    signer first, opener;
+    memset(&first, 0, sizeof(first));
+    memset(&opener, 0, sizeof(opener));
+    first.key = opener.key = key;
+    first.plain = opener.plain = plain;
+    pthread_t firstThread, openerThread;
+    // The first signer holds the open session, the opener has to load a new one
+    ASSERT_EQ(0, pthread_create(&firstThread, NULL, runOneSign, &first));
+    usleep(5000);
+    double start = nowSec();
+    ASSERT_EQ(0, pthread_create(&openerThread, NULL, runOneSign, &opener));
+    pthread_join(firstThread, NULL);
+    EXPECT_EQ(TEE_ERR_NONE, signAndCheck(key, sizeof(key), plain, sizeof(plain)));
+    double elapsed = nowSec() - start;
+    pthread_join(openerThread, NULL);
+
+    EXPECT_EQ(1, first.ok);
+    EXPECT_EQ(1, opener.ok);
+    EXPECT_EQ(1, mcStub.sessionsOpened);
+    EXPECT_LT(elapsed, mcStub.openSessionUs / 2 * 1e-6);
+}
+
+/* Cost of a sign with a pooled session against the session open it saves */
+TEST_F(KeymasterTlc, SignCost)
+{
+    const int signs = 1000;
+
+    mcStubReset(400);
+    mcStub.openSessionUs = 1500;
+    double start = nowSec();
+    for (int i = 0; i < signs; i++) {
+        ASSERT_EQ(TEE_ERR_NONE, signAndCheck(key, sizeof(key), plain, sizeof(plain)));
+    }
+    double elapsed = nowSec() - start;
+    printf("pooled sign: %.1f us per op, %ld sessions opened for %d signs "
+           "(a session open costs %u us)\n", elapsed / signs * 1e6,
+           mcStub.sessionsOpened, signs, mcStub.openSessionUs);
+}
+
+//------------------------------------------------------------------------------
+/* Small buffers are copied through the staging region, no mcMap() per call */
+TEST_F(KeymasterTlc, SmallBuffersAreStaged)
+{
+    // Make sure a pooled session with its staging region exists
+    ASSERT_EQ(TEE_ERR_NONE, signAndCheck(key, sizeof(key), plain, sizeof(plain)));
+    mcStubReset(20);
+    teeStats_t before;
+    ASSERT_EQ(TEE_ERR_NONE, TEE_GetStats(&before));
+
+    for (int i = 0; i < 100; i++) {
+        ASSERT_EQ(TEE_ERR_NONE, signAndCheck(key, sizeof(key), plain, sizeof(plain)));
+    }
+    teeStats_t after;
+    ASSERT_EQ(TEE_ERR_NONE, TEE_GetStats(&after));
+    EXPECT_EQ(0, mcStub.maps);
+    EXPECT_EQ(before.bulkMaps, after.bulkMaps);
+    EXPECT_EQ(before.stagedBuffers + 200, after.stagedBuffers);
+    EXPECT_EQ(before.operations + 100, after.operations);
+}
+
+/* Large buffers are still mapped, and unmapped again after the call */
+TEST_F(KeymasterTlc, LargeBuffersAreMapped)
+{
+    static uint8_t large[20000];
+    for (size_t i = 0; i < sizeof(large); i++) {
+        large[i] = (uint8_t) (i * 13);
+    }
+    ASSERT_EQ(TEE_ERR_NONE, signAndCheck(key, sizeof(key), plain, sizeof(plain)));
+    mcStubReset(20);
+    long liveMaps = mcStub.liveMaps;
+
+    for (int i = 0; i < 10; i++) {
+        ASSERT_EQ(TEE_ERR_NONE, signAndCheck(key, sizeof(key), large, sizeof(large)));
+    }
+    EXPECT_EQ(10, mcStub.maps);
+    EXPECT_EQ(liveMaps, mcStub.liveMaps);
+}
+
+/* Staged output buffers are copied back to the caller */
+TEST_F(KeymasterTlc, StagedOutputIsCopiedBack)
+{
+    uint8_t signatures[2][SIGNATURE_SIZE];
+    size_t signatureLength = SIGNATURE_SIZE;
+    uint8_t otherPlain[64];
+
+    memset(otherPlain, 0xc3, sizeof(otherPlain));
+    memset(signatures, 0, sizeof(signatures));
+    ASSERT_EQ(TEE_ERR_NONE, TEE_RSASign(key, sizeof(key), plain, sizeof(plain), signatures[0],
+                                        &signatureLength, TEE_RSA_NODIGEST_NOPADDING));
+    ASSERT_EQ(TEE_ERR_NONE, TEE_RSASign(key, sizeof(key), otherPlain, sizeof(otherPlain),
+                                        signatures[1], &signatureLength,
+                                        TEE_RSA_NODIGEST_NOPADDING));
+    EXPECT_EQ(plain[0] ^ key[0], signatures[0][0]);
+    EXPECT_EQ(0xc3 ^ key[0], signatures[1][0]);
+    EXPECT_EQ(plain[(SIGNATURE_SIZE - 1) % sizeof(plain)] ^ key[0],
+              signatures[0][SIGNATURE_SIZE - 1]);
+}
+
+/* Keys, plain texts and signatures don't stay in the staging region */
+TEST_F(KeymasterTlc, StagingIsWipedAfterUse)
+{
+    uint8_t signature[SIGNATURE_SIZE];
+    size_t signatureLength = sizeof(signature);
+
+    ASSERT_EQ(TEE_ERR_NONE, signAndCheck(key, sizeof(key), plain, sizeof(plain)));
+    EXPECT_EQ(0, mcStubMappedNonZero());
+
+    mcStub.trustletReturnCode = RET_ERR_SIGN;
+    EXPECT_EQ(TEE_ERR_FAIL, TEE_RSASign(key, sizeof(key), plain, sizeof(plain), signature,
+                                        &signatureLength, TEE_RSA_NODIGEST_NOPADDING));
+    EXPECT_EQ(0, mcStubMappedNonZero());
+    mcStub.trustletReturnCode = RET_OK;
+
+    bool validity = false;
+    ASSERT_EQ(TEE_ERR_NONE, TEE_RSASign(key, sizeof(key), plain, sizeof(plain), signature,
+                                        &signatureLength, TEE_RSA_NODIGEST_NOPADDING));
+    ASSERT_EQ(TEE_ERR_NONE, TEE_RSAVerify(key, sizeof(key), plain, sizeof(plain), signature,
+                                          signatureLength, TEE_RSA_NODIGEST_NOPADDING,
+                                          &validity));
+    EXPECT_TRUE(validity);
+    EXPECT_EQ(0, mcStubMappedNonZero());
+}
+
+/* Cost of a sign with a staged and with a mapped plain text */
+TEST_F(KeymasterTlc, StagingCost)
+{
+    static uint8_t large[20000];
+    const uint32_t lengths[] = {256, sizeof(large)};
+    const int signs = 500;
+
+    memset(large, 0x21, sizeof(large));
+    for (size_t k = 0; k < sizeof(lengths) / sizeof(lengths[0]); k++) {
+        mcStubReset(400);
+        // Map cost of the daemon: building the L2 table
+        mcStub.mapUs = 25 + (lengths[k] + 4095) / 4096;
+        double start = nowSec();
+        for (int i = 0; i < signs; i++) {
+            ASSERT_EQ(TEE_ERR_NONE, signAndCheck(key, sizeof(key), large, lengths[k]));
+        }
+        double elapsed = nowSec() - start;
+        printf("plain %5u: %.1f us per sign, %.2f mcMap per sign\n", lengths[k],
+               elapsed / signs * 1e6, (double) mcStub.maps / signs);
+    }
+}
+
+//------------------------------------------------------------------------------
+class KeymasterTlcBatch: public KeymasterTlc
+{
+protected:
+    virtual void SetUp()
+    {
+        KeymasterTlc::SetUp();
+        for (int i = 0; i < BATCH_MAX; i++) {
+            memset(plains[i], i + 1, sizeof(plains[i]));
+            memset(signatures[i], 0, sizeof(signatures[i]));
+            messages[i].plainData = plains[i];
+            messages[i].plainDataLength = sizeof(plains[i]);
+            messages[i].signatureData = signatures[i];
+            messages[i].signatureDataLength = sizeof(signatures[i]);
+            messages[i].validity = false;
+            messages[i].result = TEE_ERR_MEMORY;
+        }
+    }
+
+    enum { BATCH_MAX = 64 };
+
+    uint8_t plains[BATCH_MAX][48];
+    uint8_t signatures[BATCH_MAX][SIGNATURE_SIZE];
+    teeRsaMessage_t messages[BATCH_MAX];
+};
+
+TEST_F(KeymasterTlcBatch, SignsEveryMessageInOneOperation)
+{
+    teeStats_t before, after;
+    ASSERT_EQ(TEE_ERR_NONE, TEE_GetStats(&before));
+
+    ASSERT_EQ(TEE_ERR_NONE, TEE_RSASignBatch(key, sizeof(key), messages, 16,
+                                             TEE_RSA_NODIGEST_NOPADDING));
+    ASSERT_EQ(TEE_ERR_NONE, TEE_GetStats(&after));
+    EXPECT_EQ(before.operations + 1, after.operations);
+    EXPECT_EQ(16, mcStub.commands);
+    for (int i = 0; i < 16; i++) {
+        EXPECT_EQ(TEE_ERR_NONE, messages[i].result);
+        EXPECT_EQ((size_t) SIGNATURE_SIZE, messages[i].signatureDataLength);
+        EXPECT_EQ((uint8_t) ((i + 1) ^ key[0]), signatures[i][SIGNATURE_SIZE - 1]) << i;
+    }
+}
+
+TEST_F(KeymasterTlcBatch, VerifiesEveryMessage)
+{
+    ASSERT_EQ(TEE_ERR_NONE, TEE_RSASignBatch(key, sizeof(key), messages, 8,
+                                             TEE_RSA_NODIGEST_NOPADDING));
+    signatures[5][17] ^= 1;
+
+    ASSERT_EQ(TEE_ERR_NONE, TEE_RSAVerifyBatch(key, sizeof(key), messages, 8,
+                                               TEE_RSA_NODIGEST_NOPADDING));
+    for (int i = 0; i < 8; i++) {
+        EXPECT_EQ(TEE_ERR_NONE, messages[i].result);
+        EXPECT_EQ(i != 5, messages[i].validity) << i;
+    }
+}
+
+/* A message which fails does not fail the others */
+TEST_F(KeymasterTlcBatch, ReportsResultsPerMessage)
+{
+    messages[3].signatureDataLength = SIGNATURE_SIZE / 2;
+
+    EXPECT_EQ(TEE_ERR_FAIL, TEE_RSASignBatch(key, sizeof(key), messages, 8,
+                                             TEE_RSA_NODIGEST_NOPADDING));
+    for (int i = 0; i < 8; i++) {
+        if (i == 3) {
+            EXPECT_EQ(TEE_ERR_BUFFER_TOO_SMALL, messages[i].result);
+        } else {
+            EXPECT_EQ(TEE_ERR_NONE, messages[i].result) << i;
+            EXPECT_EQ((uint8_t) ((i + 1) ^ key[0]), signatures[i][0]) << i;
+        }
+    }
+    EXPECT_EQ(0, mcStub.sessionsClosed);
+
+    EXPECT_EQ(TEE_ERR_INVALID_BUFFER, TEE_RSASignBatch(key, sizeof(key), messages, 0,
+                                                       TEE_RSA_NODIGEST_NOPADDING));
+    EXPECT_EQ(TEE_ERR_INVALID_BUFFER, TEE_RSASignBatch(key, sizeof(key), NULL, 1,
+                                                       TEE_RSA_NODIGEST_NOPADDING));
+}
+
+/* Cost per signature for growing batches, against single TEE_RSASign() calls */
+TEST_F(KeymasterTlcBatch, BatchCost)
+{
+    const int sizes[] = {1, 4, 16, 64};
+    const int signatures = 256;
+
+    for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        mcStubReset(400);
+        mcStub.mapUs = 25;
+        double start = nowSec();
+        for (int i = 0; i < signatures / sizes[k]; i++) {
+            for (int j = 0; j < sizes[k]; j++) {
+                messages[j].signatureDataLength = SIGNATURE_SIZE;
+            }
+            ASSERT_EQ(TEE_ERR_NONE, TEE_RSASignBatch(key, sizeof(key), messages, sizes[k],
+                                                     TEE_RSA_NODIGEST_NOPADDING));
+        }
+        double elapsed = nowSec() - start;
+        printf("batch %2d: %.1f us per signature, %.3f mcMap per signature\n", sizes[k],
+               elapsed / signatures * 1e6, (double) mcStub.maps / signatures);
+    }
+}
@@ -30,6 +30,8 @@
  */
 
 #include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
 
 #include "MobiCoreDriverApi.h"
 #include "tlTeeKeymaster_Api.h"
@@ -37,110 +39,347 @@
 #include "tlcTeeKeymaster_if.h"
 
 
+/* Number of keymaster sessions kept open by the process */
+#define TEE_SESSION_POOL_SIZE   4
+
+/* Size of the staging region kept mapped by each pooled session */
+#define TEE_STAGING_SIZE        (16 * 1024)
+
+/* Buffers up to this size are copied into the staging region */
+#define TEE_STAGING_THRESHOLD   4096
+
+/* Pooled session to the TEE Keymaster trustlet */
+typedef struct {
+    mcSessionHandle_t   sessionHandle;
+    tciMessage_ptr      pTci;
+    bool                open;
+    bool                busy;
+    uint8_t             *staging;       /**< Bulk buffer mapped for the session lifetime */
+    mcBulkMap_t         stagingMapInfo;
+    uint32_t            stagingUsed;    /**< Bytes of staging used by the current operation */
+    struct timespec     start;          /**< Time the current operation borrowed the session */
+    uint32_t            bulkMaps;       /**< mcMap() calls of the current operation */
+    uint32_t            stagedBuffers;  /**< Staged buffers of the current operation */
+} teeSession_t;
+
+/* Buffer passed to the trustlet, either staged or mapped on its own */
+typedef struct {
+    void                *buffer;
+    uint32_t            len;
+    bool                output;         /**< Copy staged data back to buffer */
+    bool                staged;
+    uint32_t            offset;         /**< Offset in the staging region if staged */
+    mcBulkMap_t         mapInfo;
+} teeBulkBuffer_t;
+
 /* Global definitions */
 static const uint32_t gDeviceId = MC_DEVICE_ID_DEFAULT;
 static const mcUuid_t gUuid = TEE_KEYMASTER_TL_UUID;
 
+static teeSession_t    gSessions[TEE_SESSION_POOL_SIZE];
+static bool            gDeviceOpen = false;
+static pthread_mutex_t gDeviceMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t gPoolMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  gPoolCond = PTHREAD_COND_INITIALIZER;
+static teeStats_t      gStats;
+
 /**
- * TEE_Open
+ * TEE_OpenSession
  *
- * Open session to the TEE Keymaster trustlet
+ * Open a pooled session to the TEE Keymaster trustlet, with its own TCI
  *
- * @param  pSessionHandle  [out] Return pointer to the session handle
+ * @param  pSession  [in] Pool entry to open
  */
-static tciMessage_ptr TEE_Open(
-    mcSessionHandle_t *pSessionHandle
+static bool TEE_OpenSession(
+    teeSession_t *pSession
 ){
-    tciMessage_ptr pTci = NULL;
     mcResult_t     mcRet;
 
-    do
+    /* Open MobiCore device, it stays open for the other sessions */
+    pthread_mutex_lock(&gDeviceMutex);
+    if (!gDeviceOpen)
     {
-
-        /* Validate session handle */
-        if (!pSessionHandle)
+        mcRet = mcOpenDevice(gDeviceId);
+        if ((MC_DRV_OK != mcRet) && (MC_DRV_ERR_DEVICE_ALREADY_OPEN != mcRet))
         {
-            LOG_E("TEE_Open(): Invalid session handle\n");
-            break;
+            LOG_E("TEE_Open(): mcOpenDevice returned: %d\n", mcRet);
+            pthread_mutex_unlock(&gDeviceMutex);
+            return false;
         }
+        gDeviceOpen = true;
+    }
+    pthread_mutex_unlock(&gDeviceMutex);
 
-        /* Initialize session handle data */
-        memset(pSessionHandle, 0, sizeof(mcSessionHandle_t));
+    /* Initialize session handle data */
+    memset(&pSession->sessionHandle, 0, sizeof(mcSessionHandle_t));
 
-        /* Open MobiCore device */
-        mcRet = mcOpenDevice(gDeviceId);
+    /* Allocating WSM for TCI */
+    mcRet = mcMallocWsm(gDeviceId, 0, sizeof(tciMessage_t), (uint8_t **) &pSession->pTci, 0);
+    if (MC_DRV_OK != mcRet)
+    {
+        LOG_E("TEE_Open(): mcMallocWsm returned: %d\n", mcRet);
+        return false;
+    }
+
+    /* Open session the TEE Keymaster trustlet */
+    pSession->sessionHandle.deviceId = gDeviceId;
+    mcRet = mcOpenSession(&pSession->sessionHandle,
+                          &gUuid,
+                          (uint8_t *) pSession->pTci,
+                          (uint32_t) sizeof(tciMessage_t));
+    if (MC_DRV_OK != mcRet)
+    {
+        LOG_E("TEE_Open(): mcOpenSession returned: %d\n", mcRet);
+        mcFreeWsm(gDeviceId, (uint8_t *) pSession->pTci);
+        pSession->pTci = NULL;
+        return false;
+    }
+
+    /* Map the staging region once, small buffers are copied into it */
+    if (posix_memalign((void **) &pSession->staging, 4096, TEE_STAGING_SIZE) != 0)
+    {
+        pSession->staging = NULL;
+    }
+    else
+    {
+        /* TEE_Close() only wipes the range it used, start from a clean region */
+        memset(pSession->staging, 0, TEE_STAGING_SIZE);
+        mcRet = mcMap(&pSession->sessionHandle, pSession->staging,
+                      TEE_STAGING_SIZE, &pSession->stagingMapInfo);
         if (MC_DRV_OK != mcRet)
         {
-            LOG_E("TEE_Open(): mcOpenDevice returned: %d\n", mcRet);
-            break;
+            LOG_E("TEE_Open(): mcMap of staging region returned: %d\n", mcRet);
+            free(pSession->staging);
+            pSession->staging = NULL;
         }
+    }
 
-        /* Allocating WSM for TCI */
-        mcRet = mcMallocWsm(gDeviceId, 0, sizeof(tciMessage_t), (uint8_t **) &pTci, 0);
-        if (MC_DRV_OK != mcRet)
+    pSession->open = true;
+    return true;
+}
+
+
+/**
+ * TEE_CloseSession
+ *
+ * Close a pooled session to the TEE Keymaster trustlet and free its TCI.
+ * Closing the session also releases any buffer still mapped to it.
+ *
+ * @param  pSession  [in] Pool entry to close
+ */
+static void TEE_CloseSession(
+    teeSession_t *pSession
+){
+    mcResult_t    mcRet;
+
+    mcRet = mcCloseSession(&pSession->sessionHandle);
+    if (MC_DRV_OK != mcRet)
+    {
+        LOG_E("TEE_Close(): mcCloseSession returned: %d\n", mcRet);
+    }
+
+    /* The staging mapping went away with the session */
+    free(pSession->staging);
+    pSession->staging = NULL;
+
+    mcRet = mcFreeWsm(gDeviceId, (uint8_t *) pSession->pTci);
+    if (MC_DRV_OK != mcRet)
+    {
+        LOG_E("TEE_Close(): mcFreeWsm returned: %d\n", mcRet);
+    }
+
+    pSession->pTci = NULL;
+    pSession->open = false;
+}
+
+
+/**
+ * TEE_Open
+ *
+ * Borrow a session to the TEE Keymaster trustlet from the pool. Waits for
+ * a session to be returned if all of them are in use, sessions are opened
+ * on first use. Only the busy flag is taken under gPoolMutex, a busy entry
+ * belongs to its borrower which opens it without holding the lock.
+ *
+ * @return Session or NULL if no session could be opened
+ */
+static teeSession_t *TEE_Open(void)
+{
+    teeSession_t *pSession = NULL;
+    struct timespec start;
+    int i;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    pthread_mutex_lock(&gPoolMutex);
+    for (;;)
+    {
+        /* Prefer a session which is already open */
+        for (i = 0; i < TEE_SESSION_POOL_SIZE; i++)
         {
-            LOG_E("TEE_Open(): mcMallocWsm returned: %d\n", mcRet);
-            break;
+            if (!gSessions[i].busy && gSessions[i].open)
+            {
+                pSession = &gSessions[i];
+                break;
+            }
         }
-
-        /* Open session the TEE Keymaster trustlet */
-        pSessionHandle->deviceId = gDeviceId;
-        mcRet = mcOpenSession(pSessionHandle,
-                              &gUuid,
-                              (uint8_t *) pTci,
-                              (uint32_t) sizeof(tciMessage_t));
-        if (MC_DRV_OK != mcRet)
+        for (i = 0; (pSession == NULL) && (i < TEE_SESSION_POOL_SIZE); i++)
+        {
+            if (!gSessions[i].busy)
+            {
+                pSession = &gSessions[i];
+            }
+        }
+        if (pSession != NULL)
         {
-            LOG_E("TEE_Open(): mcOpenSession returned: %d\n", mcRet);
             break;
         }
+        pthread_cond_wait(&gPoolCond, &gPoolMutex);
+    }
+    pSession->busy = true;
+    pSession->start = start;
+    pSession->stagingUsed = 0;
+    pSession->bulkMaps = 0;
+    pSession->stagedBuffers = 0;
+    pthread_mutex_unlock(&gPoolMutex);
 
-    } while (false);
-
-    return pTci;
+    /* Loading the trustlet takes milliseconds, don't block the other users */
+    if (!pSession->open && !TEE_OpenSession(pSession))
+    {
+        pthread_mutex_lock(&gPoolMutex);
+        pSession->busy = false;
+        pthread_cond_signal(&gPoolCond);
+        pthread_mutex_unlock(&gPoolMutex);
+        return NULL;
+    }
+
+    return pSession;
 }
 
 
 /**
  * TEE_Close
  *
- * Close session to the TEE Keymaster trustlet
+ * Return a session to the pool. After a communication error the session
+ * state is unknown, it is closed and reopened by the next user.
  *
- * @param  sessionHandle  [in] Session handle
+ * @param  pSession  [in] Session returned by TEE_Open(), may be NULL
+ * @param  result    [in] Result of the operation done with the session
  */
 static void TEE_Close(
-    mcSessionHandle_t *pSessionHandle
+    teeSession_t *pSession,
+    teeResult_t  result
 ){
-    teeResult_t   ret = TEE_ERR_NONE;
-    mcResult_t    mcRet;
+    struct timespec end;
+    uint64_t latency;
 
-    do {
+    if (!pSession)
+    {
+        return;
+    }
 
-        /* Validate session handle */
-        if (!pSessionHandle)
-        {
-            LOG_E("TEE_Close(): Invalid session handle\n");
-            break;
-        }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    latency = (uint64_t) (end.tv_sec - pSession->start.tv_sec) * 1000000 +
+              (end.tv_nsec - pSession->start.tv_nsec) / 1000;
 
-        /* Close session */
-        mcRet = mcCloseSession(pSessionHandle);
-        if (MC_DRV_OK != mcRet)
-        {
-            LOG_E("TEE_Close(): mcCloseSession returned: %d\n", mcRet);
-            ret = TEE_ERR_SESSION;
-            break;
-        }
+    /* Don't leave staged keys and plain text behind for the next borrower */
+    if (pSession->staging != NULL)
+    {
+        memset(pSession->staging, 0, pSession->stagingUsed);
+    }
 
-        /* Close MobiCore device */
-        mcRet = mcCloseDevice(gDeviceId);
-        if (MC_DRV_OK != mcRet)
+    /* TEE_ERR_FAIL is returned by the trustlet, the session is still fine.
+     * The entry is still busy, close it before handing it back. */
+    if ((TEE_ERR_NONE != result) && (TEE_ERR_FAIL != result))
+    {
+        LOG_E("TEE_Close(): invalidating session after error %d\n", result);
+        TEE_CloseSession(pSession);
+    }
+
+    pthread_mutex_lock(&gPoolMutex);
+    gStats.operations++;
+    gStats.bulkMaps += pSession->bulkMaps;
+    gStats.stagedBuffers += pSession->stagedBuffers;
+    gStats.totalLatencyUs += latency;
+    if (latency > gStats.maxLatencyUs)
+    {
+        gStats.maxLatencyUs = latency;
+    }
+    pSession->busy = false;
+    pthread_cond_signal(&gPoolCond);
+    pthread_mutex_unlock(&gPoolMutex);
+}
+
+
+/**
+ * TEE_MapBuffer
+ *
+ * Make a buffer available to the trustlet. Small buffers are copied into
+ * the staging region of the session, larger ones are mapped with mcMap().
+ * The secure world address is returned in pBulk->mapInfo.sVirtualAddr.
+ *
+ * @param  pSession  [in]  Session the buffer is passed to
+ * @param  buffer    [in]  Buffer
+ * @param  len       [in]  Buffer length
+ * @param  output    [in]  The trustlet writes to the buffer
+ * @param  pBulk     [out] Buffer mapping information
+ */
+static mcResult_t TEE_MapBuffer(
+    teeSession_t    *pSession,
+    void            *buffer,
+    uint32_t        len,
+    bool            output,
+    teeBulkBuffer_t *pBulk
+){
+    uint32_t offset = pSession->stagingUsed;
+
+    pBulk->buffer = buffer;
+    pBulk->len = len;
+    pBulk->output = output;
+    pBulk->staged = false;
+
+    if ((pSession->staging != NULL) && (len <= TEE_STAGING_THRESHOLD) &&
+        (len <= TEE_STAGING_SIZE - offset))
+    {
+        memcpy(pSession->staging + offset, buffer, len);
+        pBulk->mapInfo.sVirtualAddr = (uint8_t *) pSession->stagingMapInfo.sVirtualAddr + offset;
+        pBulk->mapInfo.sVirtualLen = len;
+        pBulk->staged = true;
+        pBulk->offset = offset;
+        /* Keep the next buffer 8 byte aligned */
+        pSession->stagingUsed = offset + ((len + 7) & ~7U);
+        pSession->stagedBuffers++;
+        return MC_DRV_OK;
+    }
+
+    pSession->bulkMaps++;
+    return mcMap(&pSession->sessionHandle, buffer, len, &pBulk->mapInfo);
+}
+
+
+/**
+ * TEE_UnmapBuffer
+ *
+ * Release a buffer given to TEE_MapBuffer(), copying staged output back.
+ * The staging region is wiped by TEE_Close(), also after errors.
+ *
+ * @param  pSession  [in] Session the buffer was passed to
+ * @param  pBulk     [in] Buffer mapping information
+ */
+static mcResult_t TEE_UnmapBuffer(
+    teeSession_t    *pSession,
+    teeBulkBuffer_t *pBulk
+){
+    if (pBulk->staged)
+    {
+        if (pBulk->output)
         {
-            LOG_E("TEE_Close(): mcCloseDevice returned: %d\n", mcRet);
-            ret = TEE_ERR_MC_DEVICE;
+            memcpy(pBulk->buffer, pSession->staging + pBulk->offset, pBulk->len);
         }
+        return MC_DRV_OK;
+    }
 
-    } while (false);
+    return mcUnmap(&pSession->sessionHandle, pBulk->buffer, &pBulk->mapInfo);
 }
 
 
@@ -166,21 +405,22 @@ teeResult_t TEE_RSAGenerateKeyPair(
 ){
     teeResult_t         ret = TEE_ERR_NONE;
     tciMessage_ptr      pTci = NULL;
-    mcSessionHandle_t   sessionHandle;
-    mcBulkMap_t         mapInfo;
+    teeSession_t        *pSession = NULL;
+    teeBulkBuffer_t     mapInfo;
     mcResult_t          mcRet;
 
     do {
 
         /* Open session to the trustlet */
-        pTci = TEE_Open(&sessionHandle);
-        if (!pTci) {
+        pSession = TEE_Open();
+        if (!pSession) {
             ret = TEE_ERR_MEMORY;
             break;
         }
+        pTci = pSession->pTci;
 
         /* Map memory to the secure world */
-        mcRet = mcMap(&sessionHandle, keyData, keyDataLength, &mapInfo);
+        mcRet = TEE_MapBuffer(pSession, keyData, keyDataLength, true, &mapInfo);
         if (MC_DRV_OK != mcRet) {
             ret = TEE_ERR_MAP;
             break;
@@ -190,12 +430,12 @@ teeResult_t TEE_RSAGenerateKeyPair(
         pTci->command.header.commandId = CMD_ID_TEE_RSA_GEN_KEY_PAIR;
         pTci->rsagenkey.type        = keyType;
         pTci->rsagenkey.keysize     = keySize;
-        pTci->rsagenkey.keydata     = (uint32_t)mapInfo.sVirtualAddr;
+        pTci->rsagenkey.keydata     = (uint32_t)mapInfo.mapInfo.sVirtualAddr;
         pTci->rsagenkey.keydatalen  = keyDataLength;
         pTci->rsagenkey.exponent    = exponent;
 
         /* Notify the trustlet */
-        mcRet = mcNotify(&sessionHandle);
+        mcRet = mcNotify(&pSession->sessionHandle);
         if (MC_DRV_OK != mcRet)
         {
             ret = TEE_ERR_NOTIFICATION;
@@ -203,14 +443,14 @@ teeResult_t TEE_RSAGenerateKeyPair(
         }
 
         /* Wait for response from the trustlet */
-        if (MC_DRV_OK != mcWaitNotification(&sessionHandle, MC_INFINITE_TIMEOUT))
+        if (MC_DRV_OK != mcWaitNotification(&pSession->sessionHandle, MC_INFINITE_TIMEOUT))
         {
             ret = TEE_ERR_NOTIFICATION;
             break;
         }
 
         /* Unmap memory */
-        mcRet = mcUnmap(&sessionHandle, keyData, &mapInfo);
+        mcRet = TEE_UnmapBuffer(pSession, &mapInfo);
         if (MC_DRV_OK != mcRet)
         {
             ret = TEE_ERR_MAP;
@@ -231,139 +471,273 @@ teeResult_t TEE_RSAGenerateKeyPair(
     } while (false);
 
     /* Close session to the trustlet */
-    TEE_Close(&sessionHandle);
+    TEE_Close(pSession, ret);
 
     return ret;
 }
 
 
 /**
- * TEE_RSASign
+ * TEE_RSABatch
  *
- * Signs given plain data and returns signature data
+ * Runs RSA sign or verify commands for a batch of messages with one key.
+ * The key is passed to the trustlet once and all messages and signatures
+ * are packed into a single bulk buffer, so the whole batch costs one
+ * session borrow and at most two buffer mappings.
  *
- * @param  keyData          [in]  Pointer to key data buffer
- * @param  keyDataLength    [in]  Key data buffer length
- * @param  plainData        [in]  Pointer to plain data to be signed
- * @param  plainDataLength  [in]  Plain data length
- * @param  signatureData    [out] Pointer to signature data
- * @param  signatureDataLength  [out] Signature data length
- * @param  algorithm        [in]  RSA signature algorithm
+ * @param  commandId        [in]     CMD_ID_TEE_RSA_SIGN or CMD_ID_TEE_RSA_VERIFY
+ * @param  keyData          [in]     Pointer to key data buffer
+ * @param  keyDataLength    [in]     Key data buffer length
+ * @param  messages         [in/out] Messages to sign or verify
+ * @param  count            [in]     Number of messages
+ * @param  algorithm        [in]     RSA signature algorithm
  */
-teeResult_t TEE_RSASign(
-    const uint8_t*  keyData,
-    const uint32_t  keyDataLength,
-    const uint8_t*  plainData,
-    const uint32_t  plainDataLength,
-    uint8_t*        signatureData,
-    size_t*         signatureDataLength,
-    teeRsaSigAlg_t  algorithm
+static teeResult_t TEE_RSABatch(
+    uint32_t          commandId,
+    const uint8_t*    keyData,
+    const uint32_t    keyDataLength,
+    teeRsaMessage_t*  messages,
+    const uint32_t    count,
+    teeRsaSigAlg_t    algorithm
 ){
     teeResult_t        ret = TEE_ERR_NONE;
     tciMessage_ptr     pTci = NULL;
-    mcSessionHandle_t  sessionHandle;
-    mcBulkMap_t        keyMapInfo;
-    mcBulkMap_t        plainMapInfo;
-    mcBulkMap_t        signatureMapInfo;
+    teeSession_t       *pSession = NULL;
+    teeBulkBuffer_t    keyMapInfo;
+    teeBulkBuffer_t    batchMapInfo;
+    uint8_t            *batch = NULL;
+    uint32_t           batchLength = 0;
+    uint32_t           *signatureOffsets = NULL;
+    uint32_t           offset;
+    uint32_t           i;
+    bool               sign = (CMD_ID_TEE_RSA_SIGN == commandId);
     mcResult_t         mcRet;
 
     do {
 
-        /* Open session to the trustlet */
-        pTci = TEE_Open(&sessionHandle);
-        if (!pTci) {
-            ret = TEE_ERR_MEMORY;
+        if ((!messages) || (count == 0)) {
+            ret = TEE_ERR_INVALID_BUFFER;
             break;
         }
 
-        /* Map memory to the secure world */
-        mcRet = mcMap(&sessionHandle, (void*)keyData, keyDataLength, &keyMapInfo);
-        if (MC_DRV_OK != mcRet) {
-            ret = TEE_ERR_MAP;
+        /* Pack each message followed by its signature into one buffer, 8 byte aligned */
+        signatureOffsets = (uint32_t *) malloc(count * sizeof(uint32_t));
+        if (!signatureOffsets) {
+            ret = TEE_ERR_MEMORY;
+            break;
+        }
+        for (i = 0; i < count; i++) {
+            batchLength += (messages[i].plainDataLength + 7) & ~7U;
+            signatureOffsets[i] = batchLength;
+            batchLength += (messages[i].signatureDataLength + 7) & ~7U;
+        }
+        batch = (uint8_t *) malloc(batchLength);
+        if (!batch) {
+            ret = TEE_ERR_MEMORY;
             break;
         }
+        offset = 0;
+        for (i = 0; i < count; i++) {
+            memcpy(batch + offset, messages[i].plainData, messages[i].plainDataLength);
+            if (!sign) {
+                memcpy(batch + signatureOffsets[i], messages[i].signatureData,
+                       messages[i].signatureDataLength);
+            }
+            messages[i].result = TEE_ERR_NONE;
+            offset = signatureOffsets[i] + ((messages[i].signatureDataLength + 7) & ~7U);
+        }
 
-        mcRet = mcMap(&sessionHandle, (void*)plainData, plainDataLength, &plainMapInfo);
-        if (MC_DRV_OK != mcRet) {
-            ret = TEE_ERR_MAP;
+        /* Open session to the trustlet */
+        pSession = TEE_Open();
+        if (!pSession) {
+            ret = TEE_ERR_MEMORY;
             break;
         }
+        pTci = pSession->pTci;
 
-        mcRet = mcMap(&sessionHandle, (void*)signatureData, *signatureDataLength, &signatureMapInfo);
+        /* Map memory to the secure world */
+        mcRet = TEE_MapBuffer(pSession, (void*)keyData, keyDataLength, false, &keyMapInfo);
         if (MC_DRV_OK != mcRet) {
             ret = TEE_ERR_MAP;
             break;
         }
 
-        /* Update TCI buffer */
-        pTci->command.header.commandId = CMD_ID_TEE_RSA_SIGN;
-        pTci->rsasign.keydata = (uint32_t)keyMapInfo.sVirtualAddr;
-        pTci->rsasign.keydatalen = keyDataLength;
-
-        pTci->rsasign.plaindata = (uint32_t)plainMapInfo.sVirtualAddr;
-        pTci->rsasign.plaindatalen = plainDataLength;
-
-        pTci->rsasign.signaturedata = (uint32_t)signatureMapInfo.sVirtualAddr;
-        pTci->rsasign.signaturedatalen = *signatureDataLength;
-
-        pTci->rsasign.algorithm = algorithm;
-
-        /* Notify the trustlet */
-        mcRet = mcNotify(&sessionHandle);
-        if (MC_DRV_OK != mcRet)
-        {
-            ret = TEE_ERR_NOTIFICATION;
+        mcRet = TEE_MapBuffer(pSession, batch, batchLength, sign, &batchMapInfo);
+        if (MC_DRV_OK != mcRet) {
+            ret = TEE_ERR_MAP;
             break;
         }
 
-        /* Wait for response from the trustlet */
-        if (MC_DRV_OK != mcWaitNotification(&sessionHandle, MC_INFINITE_TIMEOUT))
-        {
-            ret = TEE_ERR_NOTIFICATION;
+        /* One command per message, the trustlet handles a single message per notification */
+        for (i = 0; i < count; i++) {
+            uint32_t signatureOffset = signatureOffsets[i];
+            uint32_t plainOffset = signatureOffset - ((messages[i].plainDataLength + 7) & ~7U);
+
+            /* Update TCI buffer, rsasign_t and rsaverify_t share the same layout */
+            pTci->command.header.commandId = commandId;
+            if (sign) {
+                pTci->rsasign.keydata = (uint32_t)keyMapInfo.mapInfo.sVirtualAddr;
+                pTci->rsasign.keydatalen = keyDataLength;
+
+                pTci->rsasign.plaindata = (uint32_t)batchMapInfo.mapInfo.sVirtualAddr + plainOffset;
+                pTci->rsasign.plaindatalen = messages[i].plainDataLength;
+
+                pTci->rsasign.signaturedata = (uint32_t)batchMapInfo.mapInfo.sVirtualAddr + signatureOffset;
+                pTci->rsasign.signaturedatalen = messages[i].signatureDataLength;
+
+                pTci->rsasign.algorithm = algorithm;
+            } else {
+                pTci->rsaverify.keydata = (uint32_t)keyMapInfo.mapInfo.sVirtualAddr;
+                pTci->rsaverify.keydatalen = keyDataLength;
+
+                pTci->rsaverify.plaindata = (uint32_t)batchMapInfo.mapInfo.sVirtualAddr + plainOffset;
+                pTci->rsaverify.plaindatalen = messages[i].plainDataLength;
+
+                pTci->rsaverify.signaturedata = (uint32_t)batchMapInfo.mapInfo.sVirtualAddr + signatureOffset;
+                pTci->rsaverify.signaturedatalen = messages[i].signatureDataLength;
+
+                pTci->rsaverify.algorithm = algorithm;
+                pTci->rsaverify.validity = false;
+            }
+
+            /* Notify the trustlet */
+            mcRet = mcNotify(&pSession->sessionHandle);
+            if (MC_DRV_OK != mcRet)
+            {
+                ret = TEE_ERR_NOTIFICATION;
+                break;
+            }
+
+            /* Wait for response from the trustlet */
+            if (MC_DRV_OK != mcWaitNotification(&pSession->sessionHandle, MC_INFINITE_TIMEOUT))
+            {
+                ret = TEE_ERR_NOTIFICATION;
+                break;
+            }
+
+            if (RET_OK != pTci->response.header.returnCode)
+            {
+                LOG_E("%s(): TEE Keymaster trustlet returned: 0x%.8x\n",
+                            sign ? "TEE_RSASign" : "TEE_RSAVerify",
+                            pTci->response.header.returnCode);
+                messages[i].result = TEE_ERR_FAIL;
+                ret = TEE_ERR_FAIL;
+                continue;
+            }
+
+            if (sign) {
+                if (pTci->rsasign.signaturedatalen > messages[i].signatureDataLength)
+                {
+                    messages[i].result = TEE_ERR_BUFFER_TOO_SMALL;
+                    ret = TEE_ERR_FAIL;
+                    continue;
+                }
+                /* Retrieve signature data length */
+                messages[i].signatureDataLength = pTci->rsasign.signaturedatalen;
+            } else {
+                messages[i].validity = pTci->rsaverify.validity;
+            }
+        }
+        if ((TEE_ERR_NONE != ret) && (TEE_ERR_FAIL != ret)) {
             break;
         }
 
         /* Unmap memory */
-        mcRet = mcUnmap(&sessionHandle, (void*)keyData, &keyMapInfo);
+        mcRet = TEE_UnmapBuffer(pSession, &keyMapInfo);
         if (MC_DRV_OK != mcRet)
         {
             ret = TEE_ERR_MAP;
             break;
         }
 
-        mcRet = mcUnmap(&sessionHandle, (void*)plainData, &plainMapInfo);
+        mcRet = TEE_UnmapBuffer(pSession, &batchMapInfo);
         if (MC_DRV_OK != mcRet)
         {
             ret = TEE_ERR_MAP;
             break;
         }
 
-        mcRet = mcUnmap(&sessionHandle, (void*)signatureData, &signatureMapInfo);
-        if (MC_DRV_OK != mcRet)
-        {
-            ret = TEE_ERR_MAP;
-            break;
+        /* Hand the signatures back to the caller */
+        for (i = 0; sign && (i < count); i++) {
+            if (TEE_ERR_NONE == messages[i].result) {
+                memcpy(messages[i].signatureData, batch + signatureOffsets[i],
+                       messages[i].signatureDataLength);
+            }
         }
 
-        if (RET_OK != pTci->response.header.returnCode)
-        {
-            LOG_E("TEE_RSASign(): TEE Keymaster trustlet returned: 0x%.8x\n",
-                        pTci->response.header.returnCode);
-            ret = TEE_ERR_FAIL;
-            break;
-        }
-
-        /* Retrieve signature data length */
-        *signatureDataLength = pTci->rsasign.signaturedatalen;
-
     } while (false);
 
     /* Close session to the trustlet */
-    TEE_Close(&sessionHandle);
+    TEE_Close(pSession, ret);
+
+    free(batch);
+    free(signatureOffsets);
 
     return ret;
 }
 
+/**
+ * TEE_RSASign
+ *
+ * Signs given plain data and returns signature data
+ *
+ * @param  keyData          [in]  Pointer to key data buffer
+ * @param  keyDataLength    [in]  Key data buffer length
+ * @param  plainData        [in]  Pointer to plain data to be signed
+ * @param  plainDataLength  [in]  Plain data length
+ * @param  signatureData    [out] Pointer to signature data
+ * @param  signatureDataLength  [out] Signature data length
+ * @param  algorithm        [in]  RSA signature algorithm
+ */
+teeResult_t TEE_RSASign(
+    const uint8_t*  keyData,
+    const uint32_t  keyDataLength,
+    const uint8_t*  plainData,
+    const uint32_t  plainDataLength,
+    uint8_t*        signatureData,
+    size_t*         signatureDataLength,
+    teeRsaSigAlg_t  algorithm
+){
+    teeRsaMessage_t    message;
+    teeResult_t        ret;
+
+    message.plainData = plainData;
+    message.plainDataLength = plainDataLength;
+    message.signatureData = signatureData;
+    message.signatureDataLength = *signatureDataLength;
+
+    ret = TEE_RSASignBatch(keyData, keyDataLength, &message, 1, algorithm);
+    if (TEE_ERR_NONE == ret)
+    {
+        *signatureDataLength = message.signatureDataLength;
+    }
+
+    return ret;
+}
+
+
+/**
+ * TEE_RSASignBatch
+ *
+ * Signs a batch of messages with the same key
+ *
+ * @param  keyData          [in]     Pointer to key data buffer
+ * @param  keyDataLength    [in]     Key data buffer length
+ * @param  messages         [in/out] Messages to sign, signatures and results
+ * @param  count            [in]     Number of messages
+ * @param  algorithm        [in]     RSA signature algorithm
+ */
+teeResult_t TEE_RSASignBatch(
+    const uint8_t*    keyData,
+    const uint32_t    keyDataLength,
+    teeRsaMessage_t*  messages,
+    const uint32_t    count,
+    teeRsaSigAlg_t    algorithm
+){
+    return TEE_RSABatch(CMD_ID_TEE_RSA_SIGN, keyData, keyDataLength,
+                        messages, count, algorithm);
+}
+
 
 /**
  * TEE_RSAVerify
@@ -389,109 +763,44 @@ teeResult_t TEE_RSAVerify(
     teeRsaSigAlg_t  algorithm,
     bool            *validity
 ){
-    teeResult_t        ret = TEE_ERR_NONE;
-    tciMessage_ptr     pTci = NULL;
-    mcSessionHandle_t  sessionHandle;
-    mcBulkMap_t        keyMapInfo;
-    mcBulkMap_t        plainMapInfo;
-    mcBulkMap_t        signatureMapInfo;
-    mcResult_t         mcRet;
+    teeRsaMessage_t    message;
+    teeResult_t        ret;
 
-    do {
+    message.plainData = plainData;
+    message.plainDataLength = plainDataLength;
+    message.signatureData = (uint8_t*)signatureData;
+    message.signatureDataLength = signatureDataLength;
 
-        /* Open session to the trustlet */
-        pTci = TEE_Open(&sessionHandle);
-        if (!pTci) {
-            ret = TEE_ERR_MEMORY;
-            break;
-        }
-
-        /* Map memory to the secure world */
-        mcRet = mcMap(&sessionHandle, (void*)keyData, keyDataLength, &keyMapInfo);
-        if (MC_DRV_OK != mcRet) {
-            ret = TEE_ERR_MAP;
-            break;
-        }
-
-        mcRet = mcMap(&sessionHandle, (void*)plainData, plainDataLength, &plainMapInfo);
-        if (MC_DRV_OK != mcRet) {
-            ret = TEE_ERR_MAP;
-            break;
-        }
-
-        mcRet = mcMap(&sessionHandle, (void*)signatureData, signatureDataLength, &signatureMapInfo);
-        if (MC_DRV_OK != mcRet) {
-            ret = TEE_ERR_MAP;
-            break;
-        }
-
-        /* Update TCI buffer */
-        pTci->command.header.commandId = CMD_ID_TEE_RSA_VERIFY;
-        pTci->rsaverify.keydata = (uint32_t)keyMapInfo.sVirtualAddr;
-        pTci->rsaverify.keydatalen = keyDataLength;
-
-        pTci->rsaverify.plaindata = (uint32_t)plainMapInfo.sVirtualAddr;
-        pTci->rsaverify.plaindatalen = plainDataLength;
-
-        pTci->rsaverify.signaturedata = (uint32_t)signatureMapInfo.sVirtualAddr;
-        pTci->rsaverify.signaturedatalen = signatureDataLength;
-
-        pTci->rsaverify.algorithm = algorithm;
-        pTci->rsaverify.validity = false;
-
-        /* Notify the trustlet */
-        mcRet = mcNotify(&sessionHandle);
-        if (MC_DRV_OK != mcRet)
-        {
-            ret = TEE_ERR_NOTIFICATION;
-            break;
-        }
-
-        /* Wait for response from the trustlet */
-        if (MC_DRV_OK != mcWaitNotification(&sessionHandle, MC_INFINITE_TIMEOUT))
-        {
-            ret = TEE_ERR_NOTIFICATION;
-            break;
-        }
-
-        /* Unmap memory */
-        mcRet = mcUnmap(&sessionHandle, (void*)keyData, &keyMapInfo);
-        if (MC_DRV_OK != mcRet)
-        {
-            ret = TEE_ERR_MAP;
-            break;
-        }
-
-        mcRet = mcUnmap(&sessionHandle, (void*)plainData, &plainMapInfo);
-        if (MC_DRV_OK != mcRet)
-        {
-            ret = TEE_ERR_MAP;
-            break;
-        }
-
-        mcRet = mcUnmap(&sessionHandle, (void*)signatureData, &signatureMapInfo);
-        if (MC_DRV_OK != mcRet)
-        {
-            ret = TEE_ERR_MAP;
-            break;
-        }
-
-        if (RET_OK != pTci->response.header.returnCode)
-        {
-            LOG_E("TEE_RSAVerify(): TEE Keymaster trustlet returned: 0x%.8x\n",
-                        pTci->response.header.returnCode);
-            ret = TEE_ERR_FAIL;
-            break;
-        }
-
-        *validity =  pTci->rsaverify.validity;
+    ret = TEE_RSAVerifyBatch(keyData, keyDataLength, &message, 1, algorithm);
+    if (TEE_ERR_NONE == ret)
+    {
+        *validity = message.validity;
+    }
 
-    } while (false);
+    return ret;
+}
 
-    /* Close session to the trustlet */
-    TEE_Close(&sessionHandle);
 
-    return ret;
+/**
+ * TEE_RSAVerifyBatch
+ *
+ * Verifies a batch of messages with the same RSA public key
+ *
+ * @param  keyData          [in]     Pointer to key data buffer
+ * @param  keyDataLength    [in]     Key data buffer length
+ * @param  messages         [in/out] Messages, signatures, validities and results
+ * @param  count            [in]     Number of messages
+ * @param  algorithm        [in]     RSA signature algorithm
+ */
+teeResult_t TEE_RSAVerifyBatch(
+    const uint8_t*    keyData,
+    const uint32_t    keyDataLength,
+    teeRsaMessage_t*  messages,
+    const uint32_t    count,
+    teeRsaSigAlg_t    algorithm
+){
+    return TEE_RSABatch(CMD_ID_TEE_RSA_VERIFY, keyData, keyDataLength,
+                        messages, count, algorithm);
 }
 
 
@@ -512,21 +821,22 @@ teeResult_t TEE_HMACKeyGenerate(
 ){
     teeResult_t        ret = TEE_ERR_NONE;
     tciMessage_ptr     pTci = NULL;
-    mcSessionHandle_t  sessionHandle;
-    mcBulkMap_t        keyMapInfo;
+    teeSession_t       *pSession = NULL;
+    teeBulkBuffer_t    keyMapInfo;
     mcResult_t         mcRet;
 
     do {
 
         /* Open session to the trustlet */
-        pTci = TEE_Open(&sessionHandle);
-        if (!pTci) {
+        pSession = TEE_Open();
+        if (!pSession) {
             ret = TEE_ERR_MEMORY;
             break;
         }
+        pTci = pSession->pTci;
 
         /* Map memory to the secure world */
-        mcRet = mcMap(&sessionHandle, (void*)keyData, keyDataLength, &keyMapInfo);
+        mcRet = TEE_MapBuffer(pSession, (void*)keyData, keyDataLength, true, &keyMapInfo);
         if (MC_DRV_OK != mcRet) {
             ret = TEE_ERR_MAP;
             break;
@@ -534,11 +844,11 @@ teeResult_t TEE_HMACKeyGenerate(
 
         /* Update TCI buffer */
         pTci->command.header.commandId = CMD_ID_TEE_HMAC_GEN_KEY;
-        pTci->hmacgenkey.keydata = (uint32_t)keyMapInfo.sVirtualAddr;
+        pTci->hmacgenkey.keydata = (uint32_t)keyMapInfo.mapInfo.sVirtualAddr;
         pTci->hmacgenkey.keydatalen = keyDataLength;
 
         /* Notify the trustlet */
-        mcRet = mcNotify(&sessionHandle);
+        mcRet = mcNotify(&pSession->sessionHandle);
         if (MC_DRV_OK != mcRet)
         {
             ret = TEE_ERR_NOTIFICATION;
@@ -546,14 +856,14 @@ teeResult_t TEE_HMACKeyGenerate(
         }
 
         /* Wait for response from the trustlet */
-        if (MC_DRV_OK != mcWaitNotification(&sessionHandle, MC_INFINITE_TIMEOUT))
+        if (MC_DRV_OK != mcWaitNotification(&pSession->sessionHandle, MC_INFINITE_TIMEOUT))
         {
             ret = TEE_ERR_NOTIFICATION;
             break;
         }
 
         /* Unmap memory */
-        mcRet = mcUnmap(&sessionHandle, (void*)keyData, &keyMapInfo);
+        mcRet = TEE_UnmapBuffer(pSession, &keyMapInfo);
         if (MC_DRV_OK != mcRet)
         {
             ret = TEE_ERR_MAP;
@@ -573,7 +883,7 @@ teeResult_t TEE_HMACKeyGenerate(
     }while (false);
 
     /* Close session to the trustlet */
-    TEE_Close(&sessionHandle);
+    TEE_Close(pSession, ret);
 
     return ret;
 }
@@ -602,35 +912,36 @@ teeResult_t TEE_HMACSign(
 ){
     teeResult_t        ret = TEE_ERR_NONE;
     tciMessage_ptr     pTci = NULL;
-    mcSessionHandle_t  sessionHandle;
-    mcBulkMap_t        keyMapInfo;
-    mcBulkMap_t        plainMapInfo;
-    mcBulkMap_t        signatureMapInfo;
+    teeSession_t       *pSession = NULL;
+    teeBulkBuffer_t    keyMapInfo;
+    teeBulkBuffer_t    plainMapInfo;
+    teeBulkBuffer_t    signatureMapInfo;
     mcResult_t         mcRet;
 
     do {
 
         /* Open session to the trustlet */
-        pTci = TEE_Open(&sessionHandle);
-        if (!pTci) {
+        pSession = TEE_Open();
+        if (!pSession) {
             ret = TEE_ERR_MEMORY;
             break;
         }
+        pTci = pSession->pTci;
 
         /* Map memory to the secure world */
-        mcRet = mcMap(&sessionHandle, (void*)keyData, keyDataLength, &keyMapInfo);
+        mcRet = TEE_MapBuffer(pSession, (void*)keyData, keyDataLength, false, &keyMapInfo);
         if (MC_DRV_OK != mcRet) {
             ret = TEE_ERR_MAP;
             break;
         }
 
-        mcRet = mcMap(&sessionHandle, (void*)plainData, plainDataLength, &plainMapInfo);
+        mcRet = TEE_MapBuffer(pSession, (void*)plainData, plainDataLength, false, &plainMapInfo);
         if (MC_DRV_OK != mcRet) {
             ret = TEE_ERR_MAP;
             break;
         }
 
-        mcRet = mcMap(&sessionHandle, (void*)signatureData, *signatureDataLength, &signatureMapInfo);
+        mcRet = TEE_MapBuffer(pSession, (void*)signatureData, *signatureDataLength, true, &signatureMapInfo);
         if (MC_DRV_OK != mcRet) {
             ret = TEE_ERR_MAP;
             break;
@@ -638,19 +949,19 @@ teeResult_t TEE_HMACSign(
 
         /* Update TCI buffer */
         pTci->command.header.commandId = CMD_ID_TEE_HMAC_SIGN;
-        pTci->hmacsign.keydata = (uint32_t)keyMapInfo.sVirtualAddr;
+        pTci->hmacsign.keydata = (uint32_t)keyMapInfo.mapInfo.sVirtualAddr;
         pTci->hmacsign.keydatalen = keyDataLength;
 
-        pTci->hmacsign.plaindata = (uint32_t)plainMapInfo.sVirtualAddr;
+        pTci->hmacsign.plaindata = (uint32_t)plainMapInfo.mapInfo.sVirtualAddr;
         pTci->hmacsign.plaindatalen = plainDataLength;
 
-        pTci->hmacsign.signaturedata = (uint32_t)signatureMapInfo.sVirtualAddr;
+        pTci->hmacsign.signaturedata = (uint32_t)signatureMapInfo.mapInfo.sVirtualAddr;
         pTci->hmacsign.signaturedatalen = *signatureDataLength;
 
         pTci->hmacsign.digest = digest;
 
         /* Notify the trustlet */
-        mcRet = mcNotify(&sessionHandle);
+        mcRet = mcNotify(&pSession->sessionHandle);
         if (MC_DRV_OK != mcRet)
         {
             ret = TEE_ERR_NOTIFICATION;
@@ -658,28 +969,28 @@ teeResult_t TEE_HMACSign(
         }
 
         /* Wait for response from the trustlet */
-        if (MC_DRV_OK != mcWaitNotification(&sessionHandle, MC_INFINITE_TIMEOUT))
+        if (MC_DRV_OK != mcWaitNotification(&pSession->sessionHandle, MC_INFINITE_TIMEOUT))
         {
             ret = TEE_ERR_NOTIFICATION;
             break;
         }
 
         /* Unmap memory */
-        mcRet = mcUnmap(&sessionHandle, (void*)keyData, &keyMapInfo);
+        mcRet = TEE_UnmapBuffer(pSession, &keyMapInfo);
         if (MC_DRV_OK != mcRet)
         {
             ret = TEE_ERR_MAP;
             break;
         }
 
-        mcRet = mcUnmap(&sessionHandle, (void*)plainData, &plainMapInfo);
+        mcRet = TEE_UnmapBuffer(pSession, &plainMapInfo);
         if (MC_DRV_OK != mcRet)
         {
             ret = TEE_ERR_MAP;
             break;
         }
 
-        mcRet = mcUnmap(&sessionHandle, (void*)signatureData, &signatureMapInfo);
+        mcRet = TEE_UnmapBuffer(pSession, &signatureMapInfo);
         if (MC_DRV_OK != mcRet)
         {
             ret = TEE_ERR_MAP;
@@ -700,7 +1011,7 @@ teeResult_t TEE_HMACSign(
     } while (false);
 
     /* Close session to the trustlet */
-    TEE_Close(&sessionHandle);
+    TEE_Close(pSession, ret);
 
     return ret;
 }
@@ -730,35 +1041,36 @@ teeResult_t TEE_HMACVerify(
 ){
     teeResult_t        ret = TEE_ERR_NONE;
     tciMessage_ptr     pTci = NULL;
-    mcSessionHandle_t  sessionHandle;
-    mcBulkMap_t        keyMapInfo;
-    mcBulkMap_t        plainMapInfo;
-    mcBulkMap_t        signatureMapInfo;
+    teeSession_t       *pSession = NULL;
+    teeBulkBuffer_t    keyMapInfo;
+    teeBulkBuffer_t    plainMapInfo;
+    teeBulkBuffer_t    signatureMapInfo;
     mcResult_t         mcRet;
 
     do {
 
         /* Open session to the trustlet */
-        pTci = TEE_Open(&sessionHandle);
-        if (!pTci) {
+        pSession = TEE_Open();
+        if (!pSession) {
             ret = TEE_ERR_MEMORY;
             break;
         }
+        pTci = pSession->pTci;
 
         /* Map memory to the secure world */
-        mcRet = mcMap(&sessionHandle, (void*)keyData, keyDataLength, &keyMapInfo);
+        mcRet = TEE_MapBuffer(pSession, (void*)keyData, keyDataLength, false, &keyMapInfo);
         if (MC_DRV_OK != mcRet) {
             ret = TEE_ERR_MAP;
             break;
         }
 
-        mcRet = mcMap(&sessionHandle, (void*)plainData, plainDataLength, &plainMapInfo);
+        mcRet = TEE_MapBuffer(pSession, (void*)plainData, plainDataLength, false, &plainMapInfo);
         if (MC_DRV_OK != mcRet) {
             ret = TEE_ERR_MAP;
             break;
         }
 
-        mcRet = mcMap(&sessionHandle, (void*)signatureData, signatureDataLength, &signatureMapInfo);
+        mcRet = TEE_MapBuffer(pSession, (void*)signatureData, signatureDataLength, false, &signatureMapInfo);
         if (MC_DRV_OK != mcRet) {
             ret = TEE_ERR_MAP;
             break;
@@ -766,20 +1078,20 @@ teeResult_t TEE_HMACVerify(
 
         /* Update TCI buffer */
         pTci->command.header.commandId = CMD_ID_TEE_HMAC_VERIFY;
-        pTci->hmacverify.keydata = (uint32_t)keyMapInfo.sVirtualAddr;
+        pTci->hmacverify.keydata = (uint32_t)keyMapInfo.mapInfo.sVirtualAddr;
         pTci->hmacverify.keydatalen = keyDataLength;
 
-        pTci->hmacverify.plaindata = (uint32_t)plainMapInfo.sVirtualAddr;
+        pTci->hmacverify.plaindata = (uint32_t)plainMapInfo.mapInfo.sVirtualAddr;
         pTci->hmacverify.plaindatalen = plainDataLength;
 
-        pTci->hmacverify.signaturedata = (uint32_t)signatureMapInfo.sVirtualAddr;
+        pTci->hmacverify.signaturedata = (uint32_t)signatureMapInfo.mapInfo.sVirtualAddr;
         pTci->hmacverify.signaturedatalen = signatureDataLength;
 
         pTci->hmacverify.digest = digest;
         pTci->hmacverify.validity = false;
 
         /* Notify the trustlet */
-        mcRet = mcNotify(&sessionHandle);
+        mcRet = mcNotify(&pSession->sessionHandle);
         if (MC_DRV_OK != mcRet)
         {
             ret = TEE_ERR_NOTIFICATION;
@@ -787,28 +1099,28 @@ teeResult_t TEE_HMACVerify(
         }
 
         /* Wait for response from the trustlet */
-        if (MC_DRV_OK != mcWaitNotification(&sessionHandle, MC_INFINITE_TIMEOUT))
+        if (MC_DRV_OK != mcWaitNotification(&pSession->sessionHandle, MC_INFINITE_TIMEOUT))
         {
             ret = TEE_ERR_NOTIFICATION;
             break;
         }
 
         /* Unmap memory */
-        mcRet = mcUnmap(&sessionHandle, (void*)keyData, &keyMapInfo);
+        mcRet = TEE_UnmapBuffer(pSession, &keyMapInfo);
         if (MC_DRV_OK != mcRet)
         {
             ret = TEE_ERR_MAP;
             break;
         }
 
-        mcRet = mcUnmap(&sessionHandle, (void*)plainData, &plainMapInfo);
+        mcRet = TEE_UnmapBuffer(pSession, &plainMapInfo);
         if (MC_DRV_OK != mcRet)
         {
             ret = TEE_ERR_MAP;
             break;
         }
 
-        mcRet = mcUnmap(&sessionHandle, (void*)signatureData, &signatureMapInfo);
+        mcRet = TEE_UnmapBuffer(pSession, &signatureMapInfo);
         if (MC_DRV_OK != mcRet)
         {
             ret = TEE_ERR_MAP;
@@ -828,7 +1140,7 @@ teeResult_t TEE_HMACVerify(
     } while (false);
 
     /* Close session to the trustlet */
-    TEE_Close(&sessionHandle);
+    TEE_Close(pSession, ret);
 
     return ret;
 }
@@ -867,28 +1179,29 @@ teeResult_t TEE_KeyImport(
 ){
     teeResult_t         ret = TEE_ERR_NONE;
     tciMessage_ptr      pTci = NULL;
-    mcSessionHandle_t   sessionHandle;
-    mcBulkMap_t         keyMapInfo;
-    mcBulkMap_t         soMapInfo;
+    teeSession_t        *pSession = NULL;
+    teeBulkBuffer_t     keyMapInfo;
+    teeBulkBuffer_t     soMapInfo;
     mcResult_t          mcRet;
 
     do {
 
         /* Open session to the trustlet */
-        pTci = TEE_Open(&sessionHandle);
-        if (!pTci) {
+        pSession = TEE_Open();
+        if (!pSession) {
             ret = TEE_ERR_MEMORY;
             break;
         }
+        pTci = pSession->pTci;
 
         /* Map memory to the secure world */
-        mcRet = mcMap(&sessionHandle, (void*)keyData, keyDataLength, &keyMapInfo);
+        mcRet = TEE_MapBuffer(pSession, (void*)keyData, keyDataLength, false, &keyMapInfo);
         if (MC_DRV_OK != mcRet) {
             ret = TEE_ERR_MAP;
             break;
         }
 
-        mcRet = mcMap(&sessionHandle, (void*)soData, *soDataLength, &soMapInfo);
+        mcRet = TEE_MapBuffer(pSession, (void*)soData, *soDataLength, true, &soMapInfo);
         if (MC_DRV_OK != mcRet) {
             ret = TEE_ERR_MAP;
             break;
@@ -896,13 +1209,13 @@ teeResult_t TEE_KeyImport(
 
         /* Update TCI buffer */
         pTci->command.header.commandId = CMD_ID_TEE_KEY_IMPORT;
-        pTci->keyimport.keydata        = (uint32_t)keyMapInfo.sVirtualAddr;
+        pTci->keyimport.keydata        = (uint32_t)keyMapInfo.mapInfo.sVirtualAddr;
         pTci->keyimport.keydatalen     = keyDataLength;
-        pTci->keyimport.sodata         = (uint32_t)soMapInfo.sVirtualAddr;
+        pTci->keyimport.sodata         = (uint32_t)soMapInfo.mapInfo.sVirtualAddr;
         pTci->keyimport.sodatalen      = *soDataLength;
 
         /* Notify the trustlet */
-        mcRet = mcNotify(&sessionHandle);
+        mcRet = mcNotify(&pSession->sessionHandle);
         if (MC_DRV_OK != mcRet)
         {
             ret = TEE_ERR_NOTIFICATION;
@@ -910,21 +1223,21 @@ teeResult_t TEE_KeyImport(
         }
 
         /* Wait for response from the trustlet */
-        if (MC_DRV_OK != mcWaitNotification(&sessionHandle, MC_INFINITE_TIMEOUT))
+        if (MC_DRV_OK != mcWaitNotification(&pSession->sessionHandle, MC_INFINITE_TIMEOUT))
         {
             ret = TEE_ERR_NOTIFICATION;
             break;
         }
 
         /* Unmap memory */
-        mcRet = mcUnmap(&sessionHandle, (void*)keyData, &keyMapInfo);
+        mcRet = TEE_UnmapBuffer(pSession, &keyMapInfo);
         if (MC_DRV_OK != mcRet)
         {
             ret = TEE_ERR_MAP;
             break;
         }
 
-        mcRet = mcUnmap(&sessionHandle, (void*)soData, &soMapInfo);
+        mcRet = TEE_UnmapBuffer(pSession, &soMapInfo);
         if (MC_DRV_OK != mcRet)
         {
             ret = TEE_ERR_MAP;
@@ -945,7 +1258,7 @@ teeResult_t TEE_KeyImport(
     } while (false);
 
     /* Close session to the trustlet */
-    TEE_Close(&sessionHandle);
+    TEE_Close(pSession, ret);
 
     return ret;
 }
@@ -972,35 +1285,36 @@ teeResult_t TEE_GetPubKey(
 ){
     teeResult_t         ret = TEE_ERR_NONE;
     tciMessage_ptr      pTci = NULL;
-    mcSessionHandle_t   sessionHandle;
-    mcBulkMap_t         keyMapInfo;
-    mcBulkMap_t         modMapInfo;
-    mcBulkMap_t         expMapInfo;
+    teeSession_t        *pSession = NULL;
+    teeBulkBuffer_t     keyMapInfo;
+    teeBulkBuffer_t     modMapInfo;
+    teeBulkBuffer_t     expMapInfo;
     mcResult_t          mcRet;
 
     do {
 
         /* Open session to the trustlet */
-        pTci = TEE_Open(&sessionHandle);
-        if (!pTci) {
+        pSession = TEE_Open();
+        if (!pSession) {
             ret = TEE_ERR_MEMORY;
             break;
         }
+        pTci = pSession->pTci;
 
         /* Map memory to the secure world */
-        mcRet = mcMap(&sessionHandle, (void*)keyData, keyDataLength, &keyMapInfo);
+        mcRet = TEE_MapBuffer(pSession, (void*)keyData, keyDataLength, false, &keyMapInfo);
         if (MC_DRV_OK != mcRet) {
             ret = TEE_ERR_MAP;
             break;
         }
 
-        mcRet = mcMap(&sessionHandle, (void*)modulus, *modulusLength, &modMapInfo);
+        mcRet = TEE_MapBuffer(pSession, (void*)modulus, *modulusLength, true, &modMapInfo);
         if (MC_DRV_OK != mcRet) {
             ret = TEE_ERR_MAP;
             break;
         }
 
-        mcRet = mcMap(&sessionHandle, (void*)exponent, *exponentLength, &expMapInfo);
+        mcRet = TEE_MapBuffer(pSession, (void*)exponent, *exponentLength, true, &expMapInfo);
         if (MC_DRV_OK != mcRet) {
             ret = TEE_ERR_MAP;
             break;
@@ -1008,15 +1322,15 @@ teeResult_t TEE_GetPubKey(
 
         /* Update TCI buffer */
         pTci->command.header.commandId = CMD_ID_TEE_GET_PUB_KEY;
-        pTci->getpubkey.keydata        = (uint32_t)keyMapInfo.sVirtualAddr;
+        pTci->getpubkey.keydata        = (uint32_t)keyMapInfo.mapInfo.sVirtualAddr;
         pTci->getpubkey.keydatalen     = keyDataLength;
-        pTci->getpubkey.modulus        = (uint32_t)modMapInfo.sVirtualAddr;
+        pTci->getpubkey.modulus        = (uint32_t)modMapInfo.mapInfo.sVirtualAddr;
         pTci->getpubkey.moduluslen     = *modulusLength;
-        pTci->getpubkey.exponent       = (uint32_t)expMapInfo.sVirtualAddr;
+        pTci->getpubkey.exponent       = (uint32_t)expMapInfo.mapInfo.sVirtualAddr;
         pTci->getpubkey.exponentlen    = *exponentLength;
 
         /* Notify the trustlet */
-        mcRet = mcNotify(&sessionHandle);
+        mcRet = mcNotify(&pSession->sessionHandle);
         if (MC_DRV_OK != mcRet)
         {
             ret = TEE_ERR_NOTIFICATION;
@@ -1024,28 +1338,28 @@ teeResult_t TEE_GetPubKey(
         }
 
         /* Wait for response from the trustlet */
-        if (MC_DRV_OK != mcWaitNotification(&sessionHandle, MC_INFINITE_TIMEOUT))
+        if (MC_DRV_OK != mcWaitNotification(&pSession->sessionHandle, MC_INFINITE_TIMEOUT))
         {
             ret = TEE_ERR_NOTIFICATION;
             break;
         }
 
         /* Unmap memory */
-        mcRet = mcUnmap(&sessionHandle, (void*)keyData, &keyMapInfo);
+        mcRet = TEE_UnmapBuffer(pSession, &keyMapInfo);
         if (MC_DRV_OK != mcRet)
         {
             ret = TEE_ERR_MAP;
             break;
         }
 
-        mcRet = mcUnmap(&sessionHandle, (void*)modulus, &modMapInfo);
+        mcRet = TEE_UnmapBuffer(pSession, &modMapInfo);
         if (MC_DRV_OK != mcRet)
         {
             ret = TEE_ERR_MAP;
             break;
         }
 
-        mcRet = mcUnmap(&sessionHandle, (void*)exponent, &expMapInfo);
+        mcRet = TEE_UnmapBuffer(pSession, &expMapInfo);
         if (MC_DRV_OK != mcRet)
         {
             ret = TEE_ERR_MAP;
@@ -1067,7 +1381,30 @@ teeResult_t TEE_GetPubKey(
     } while (false);
 
     /* Close session to the trustlet */
-    TEE_Close(&sessionHandle);
+    TEE_Close(pSession, ret);
 
     return ret;
 }
+
+
+/**
+ * TEE_GetStats
+ *
+ * Returns mapping counts and latencies of the operations done so far
+ *
+ * @param  pStats           [out] Pointer to statistics
+ */
+teeResult_t TEE_GetStats(
+    teeStats_t *pStats
+){
+    if (!pStats)
+    {
+        return TEE_ERR_INVALID_BUFFER;
+    }
+
+    pthread_mutex_lock(&gPoolMutex);
+    *pStats = gStats;
+    pthread_mutex_unlock(&gPoolMutex);
+
+    return TEE_ERR_NONE;
+}
@@ -94,6 +94,31 @@ typedef enum
 } teeDigest_t;
 
 
+/**
+ * Keymaster operation statistics
+ */
+typedef struct {
+    uint64_t     operations;     /**< Operations completed */
+    uint64_t     bulkMaps;       /**< Buffers mapped with mcMap() */
+    uint64_t     stagedBuffers;  /**< Buffers copied through the staging region */
+    uint64_t     totalLatencyUs; /**< Sum of operation latencies in microseconds */
+    uint64_t     maxLatencyUs;   /**< Highest operation latency in microseconds */
+} teeStats_t;
+
+
+/**
+ * Message of a batched RSA sign or verify operation
+ */
+typedef struct {
+    const uint8_t*  plainData;           /**< Plain data to be signed or verified */
+    uint32_t        plainDataLength;     /**< Plain data length */
+    uint8_t*        signatureData;       /**< Signature, output of sign and input of verify */
+    size_t          signatureDataLength; /**< Signature buffer length, updated by sign */
+    bool            validity;            /**< Signature validity, set by verify */
+    teeResult_t     result;              /**< Result for this message */
+} teeRsaMessage_t;
+
+
 /**
  * RSA private key metadata (Private modulus and exponent lengths)
  */
@@ -176,6 +201,26 @@ teeResult_t TEE_RSASign(
     teeRsaSigAlg_t  algorithm);
 
 
+/**
+ * TEE_RSASignBatch
+ *
+ * Signs a batch of messages with the same key in one trustlet session.
+ * Returns TEE_ERR_FAIL if any message failed, see teeRsaMessage_t.result.
+ *
+ * @param  keyData          [in]     Pointer to key data buffer
+ * @param  keyDataLength    [in]     Key data buffer length
+ * @param  messages         [in/out] Messages to sign, signatures and results
+ * @param  count            [in]     Number of messages
+ * @param  algorithm        [in]     RSA signature algorithm
+ */
+teeResult_t TEE_RSASignBatch(
+    const uint8_t*    keyData,
+    const uint32_t    keyDataLength,
+    teeRsaMessage_t*  messages,
+    const uint32_t    count,
+    teeRsaSigAlg_t    algorithm);
+
+
 /**
  * TEE_RSAVerify
  *
@@ -201,6 +246,26 @@ teeResult_t TEE_RSAVerify(
     bool            *validity);
 
 
+/**
+ * TEE_RSAVerifyBatch
+ *
+ * Verifies a batch of messages with the same key in one trustlet session.
+ * Returns TEE_ERR_FAIL if any message failed, see teeRsaMessage_t.result.
+ *
+ * @param  keyData          [in]     Pointer to key data buffer
+ * @param  keyDataLength    [in]     Key data buffer length
+ * @param  messages         [in/out] Messages, signatures, validities and results
+ * @param  count            [in]     Number of messages
+ * @param  algorithm        [in]     RSA signature algorithm
+ */
+teeResult_t TEE_RSAVerifyBatch(
+    const uint8_t*    keyData,
+    const uint32_t    keyDataLength,
+    teeRsaMessage_t*  messages,
+    const uint32_t    count,
+    teeRsaSigAlg_t    algorithm);
+
+
 /**
  * TEE_HMACKeyGenerate
  *
@@ -318,6 +383,18 @@ teeResult_t TEE_GetPubKey(
     uint32_t*       exponentLength);
 
 
+/**
+ * TEE_GetStats
+ *
+ * Returns mapping counts and latencies of the operations done so far
+ *
+ * @param  pStats           [out] Pointer to statistics
+ */
+teeResult_t TEE_GetStats(
+    teeStats_t*     pStats);
+
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -18,12 +18,14 @@
 #include <fcntl.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
+#include <pthread.h>
 
 #include "tlsecdrm_api.h"
 #define LOG_TAG "drm_content_protect"
 #include "log.h"
 #include "tlc_communication.h"
 #include "content_protect.h"
+#include "content_protect_batch.h"
 
 mc_comm_ctx cp_ctx;
 
@@ -43,6 +45,13 @@ struct protect_info {
 #define PROTECT_DEV_GSC1	4
 #define PROTECT_DEV_GSC2	5
 
+/*
+ * TZPC state of every IP, shared by the single-IP and mask APIs so that
+ * CP_Set_Path_Protection_Mask() never works from a stale view.
+ */
+static pthread_mutex_t cp_mask_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t cp_protected_mask;
+
 extern "C" cpResult_t CP_Enable_Path_Protection(uint32_t protect_ip)
 {
 	cpResult_t cp_result = CP_SUCCESS;
@@ -51,9 +60,12 @@ extern "C" cpResult_t CP_Enable_Path_Protection(uint32_t protect_ip)
 
 	LOG_I("[CONTENT_PROTECT] : CP_Enable_Path_Protection");
 
+	pthread_mutex_lock(&cp_mask_lock);
+
 	fd_secmem = open(SMEM_PATH, O_RDWR);
 	if (fd_secmem < 0) {
 		LOG_E("s5p-smem open error!!");
+		pthread_mutex_unlock(&cp_mask_lock);
 		return CP_ERROR_ENABLE_PATH_PROTECTION_FAILED;
 	}
 
@@ -77,6 +89,7 @@ extern "C" cpResult_t CP_Enable_Path_Protection(uint32_t protect_ip)
 		prot.dev = -1;
 		LOG_E("Fail to protect Content path due to wrong ID (%d)", protect_ip);
 		close(fd_secmem);
+		pthread_mutex_unlock(&cp_mask_lock);
 		return CP_ERROR_ENABLE_PATH_PROTECTION_FAILED;
 	}
 
@@ -85,10 +98,14 @@ extern "C" cpResult_t CP_Enable_Path_Protection(uint32_t protect_ip)
 	if (ret != 0) {
 		LOG_E("Fail to get SECMEM SET TZPC:SET TZPC ret(%d)", ret);
 		close(fd_secmem);
+		pthread_mutex_unlock(&cp_mask_lock);
 		return CP_ERROR_ENABLE_PATH_PROTECTION_FAILED;
 	}
 	close(fd_secmem);
 
+	cp_protected_mask |= CP_PROTECT_MASK(protect_ip);
+	pthread_mutex_unlock(&cp_mask_lock);
+
 	LOG_I("[CONTENT_PROTECT] : CP_Enable_Path_Protection. return value(%d)", cp_result);
 	return cp_result;
 }
@@ -101,9 +118,12 @@ extern "C" cpResult_t CP_Disable_Path_Protection(uint32_t protect_ip)
 
 	LOG_I("[CONTENT_PROTECT] : CP_Disable_Path_Protection");
 
+	pthread_mutex_lock(&cp_mask_lock);
+
 	fd_secmem = open(SMEM_PATH, O_RDWR);
 	if (fd_secmem < 0) {
 		LOG_E("s5p-smem open error!!");
+		pthread_mutex_unlock(&cp_mask_lock);
 		return CP_ERROR_DISABLE_PATH_PROTECTION_FAILED;
 	}
 
@@ -127,6 +147,7 @@ extern "C" cpResult_t CP_Disable_Path_Protection(uint32_t protect_ip)
 		prot.dev = -1;
 		LOG_E("Fail to protect Content path due to wrong ID (%d)", protect_ip);
 		close(fd_secmem);
+		pthread_mutex_unlock(&cp_mask_lock);
 		return CP_ERROR_ENABLE_PATH_PROTECTION_FAILED;
 	}
 
@@ -135,11 +156,154 @@ extern "C" cpResult_t CP_Disable_Path_Protection(uint32_t protect_ip)
 	if (ret != 0) {
 		LOG_E("Fail to get SECMEM SET TZPC:SET TZPC ret(%d)", ret);
 		close(fd_secmem);
+		pthread_mutex_unlock(&cp_mask_lock);
 		return CP_ERROR_DISABLE_PATH_PROTECTION_FAILED;
 	}
 	close(fd_secmem);
 
+	cp_protected_mask &= ~CP_PROTECT_MASK(protect_ip);
+	pthread_mutex_unlock(&cp_mask_lock);
+
 	LOG_I("[CONTENT_PROTECT] : CP_Disable_Path_Protection. return value(%d)", cp_result);
 	return cp_result;
 }
 
+
+static int cp_protect_dev(uint32_t protect_ip)
+{
+	switch (protect_ip) {
+	case CP_PROTECT_MFC:
+		return PROTECT_DEV_MFC0;
+	case CP_PROTECT_MFC1:
+		return PROTECT_DEV_MFC1;
+	case CP_PROTECT_GSC0:
+		return PROTECT_DEV_GSC0;
+	case CP_PROTECT_GSC1:
+		return PROTECT_DEV_GSC1;
+	case CP_PROTECT_GSC2:
+		return PROTECT_DEV_GSC2;
+	default:
+		return -1;
+	}
+}
+
+/*
+ * Unprotect every IP in owned_mask whatever the library believes its state
+ * is. TZPC protection outlives the process that set it, while
+ * cp_protected_mask starts out empty, so a restarted user would otherwise
+ * never release IPs its previous instance left protected. There is no
+ * ioctl to read the TZPC state back, hence the unconditional disable.
+ */
+extern "C" cpResult_t CP_Reset_Path_Protection(uint32_t owned_mask)
+{
+	cpResult_t cp_result = CP_SUCCESS;
+	struct protect_info prot;
+	int fd_secmem, ret;
+
+	LOG_I("[CONTENT_PROTECT] : CP_Reset_Path_Protection(0x%x)", owned_mask);
+
+	pthread_mutex_lock(&cp_mask_lock);
+
+	fd_secmem = open(SMEM_PATH, O_RDWR);
+	if (fd_secmem < 0) {
+		LOG_E("s5p-smem open error!!");
+		pthread_mutex_unlock(&cp_mask_lock);
+		return CP_ERROR_DISABLE_PATH_PROTECTION_FAILED;
+	}
+
+	for (uint32_t ip = 0; ip < 32; ip++) {
+		uint32_t bit = 1U << ip;
+		int dev;
+
+		if (!(owned_mask & bit))
+			continue;
+
+		dev = cp_protect_dev(ip);
+		if (dev < 0) {
+			LOG_E("Fail to protect Content path due to wrong ID (%d)", ip);
+			cp_result = CP_ERROR_DISABLE_PATH_PROTECTION_FAILED;
+			continue;
+		}
+
+		prot.dev = dev;
+		prot.enable = 0;
+		ret = ioctl(fd_secmem, SECMEM_IOC_SET_TZPC, &prot);
+		if (ret != 0) {
+			LOG_E("Fail to get SECMEM SET TZPC:SET TZPC ret(%d)", ret);
+			cp_result = CP_ERROR_DISABLE_PATH_PROTECTION_FAILED;
+			continue;
+		}
+		cp_protected_mask &= ~bit;
+	}
+	close(fd_secmem);
+
+	pthread_mutex_unlock(&cp_mask_lock);
+
+	return cp_result;
+}
+
+/*
+ * Bring the IPs in owned_mask to the state given by protect_mask (bit n =
+ * CP_PROTECT id n). IPs outside owned_mask, e.g. ones enabled through
+ * CP_Enable_Path_Protection() by another user, are left as they are. Only
+ * IPs whose state changes are touched, all through one s5p-smem open, so a
+ * caller can hand over the whole frame's requirement in a single call.
+ */
+extern "C" cpResult_t CP_Set_Path_Protection_Mask(uint32_t protect_mask,
+	uint32_t owned_mask)
+{
+	cpResult_t cp_result = CP_SUCCESS;
+	struct protect_info prot;
+	uint32_t changed;
+	int fd_secmem, ret;
+
+	pthread_mutex_lock(&cp_mask_lock);
+
+	protect_mask &= owned_mask;
+	changed = (cp_protected_mask ^ protect_mask) & owned_mask;
+	if (!changed) {
+		pthread_mutex_unlock(&cp_mask_lock);
+		return CP_SUCCESS;
+	}
+
+	LOG_I("[CONTENT_PROTECT] : CP_Set_Path_Protection_Mask(0x%x -> 0x%x, owned 0x%x)",
+		cp_protected_mask & owned_mask, protect_mask, owned_mask);
+
+	fd_secmem = open(SMEM_PATH, O_RDWR);
+	if (fd_secmem < 0) {
+		LOG_E("s5p-smem open error!!");
+		pthread_mutex_unlock(&cp_mask_lock);
+		return CP_ERROR_ENABLE_PATH_PROTECTION_FAILED;
+	}
+
+	for (uint32_t ip = 0; ip < 32; ip++) {
+		uint32_t bit = 1U << ip;
+		int dev;
+
+		if (!(changed & bit))
+			continue;
+
+		dev = cp_protect_dev(ip);
+		if (dev < 0) {
+			LOG_E("Fail to protect Content path due to wrong ID (%d)", ip);
+			cp_result = CP_ERROR_ENABLE_PATH_PROTECTION_FAILED;
+			continue;
+		}
+
+		prot.dev = dev;
+		prot.enable = !!(protect_mask & bit);
+		ret = ioctl(fd_secmem, SECMEM_IOC_SET_TZPC, &prot);
+		if (ret != 0) {
+			LOG_E("Fail to get SECMEM SET TZPC:SET TZPC ret(%d)", ret);
+			cp_result = prot.enable ? CP_ERROR_ENABLE_PATH_PROTECTION_FAILED :
+				CP_ERROR_DISABLE_PATH_PROTECTION_FAILED;
+			continue;
+		}
+		cp_protected_mask ^= bit;
+	}
+	close(fd_secmem);
+
+	pthread_mutex_unlock(&cp_mask_lock);
+
+	return cp_result;
+}
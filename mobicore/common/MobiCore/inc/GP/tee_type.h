@@ -15,8 +15,8 @@
 #ifndef __TEE_TYPE_H__
 #define __TEE_TYPE_H__
 
-/* C99 integer types */
-#if (!defined(__STDC_VERSION__) || __STDC_VERSION__ < 199901L) &&(!defined(ANDROID))
+/* C99 integer types, Android and Linux hosts always have <stdint.h> */
+#if (!defined(__STDC_VERSION__) || __STDC_VERSION__ < 199901L) &&(!defined(ANDROID)) &&(!defined(__linux__))
 
 #include <limits.h>
 
@@ -26,6 +26,7 @@ LOCAL_SRC_FILES += \
 	ClientLib/Session.cpp \
 	Common/CMutex.cpp \
 	Common/Connection.cpp \
+	Common/McTrace.cpp \
 	ClientLib/GP/tee_client_api.cpp
 
 LOCAL_C_INCLUDES +=\
@@ -64,7 +65,8 @@ LOCAL_SRC_FILES += Common/CMutex.cpp \
 	Common/Connection.cpp \
 	Common/NetlinkConnection.cpp \
 	Common/CSemaphore.cpp \
-	Common/CThread.cpp
+	Common/CThread.cpp \
+	Common/McTrace.cpp
 
 # Includes required for the Daemon
 LOCAL_C_INCLUDES +=\
@@ -113,3 +115,7 @@ include $(LOCAL_PATH)/Registry/Android.mk
 LOCAL_CFLAGS += -DLOG_ANDROID
 
 include $(BUILD_SHARED_LIBRARY)
+
+# Host tests
+# =============================================================================
+include $(LOCAL_PATH)/tests/Android.mk
@@ -41,6 +41,11 @@
 #ifndef WIN32
 #include <stdbool.h>
 #include <list>
+#include <pthread.h>
+#include <errno.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/epoll.h>
 #include "assert.h"
 #endif
 
@@ -51,6 +56,7 @@
 #include "Connection.h"
 #include "CMutex.h"
 #include "Device.h"
+#include "McTrace.h"
 #include "mcVersionHelper.h"
 
 #include "Daemon/public/MobiCoreDriverCmd.h"
@@ -75,7 +81,11 @@ static list<Device *> devices;
 // Forward declarations.
 uint32_t getDaemonVersion(Connection *devCon, uint32_t *version);
 
-static CMutex devMutex;
+// The device list is read by every API call and only changed when a device is
+// opened, closed or found dead. Calls hold devicesLock for reading while they
+// use a Device; commands on a device connection are serialized by the Device
+// itself and session state is guarded by the Session.
+static pthread_rwlock_t devicesLock = PTHREAD_RWLOCK_INITIALIZER;
 //------------------------------------------------------------------------------
 Device *resolveDeviceId(uint32_t deviceId)
 {
@@ -116,6 +126,16 @@ bool removeDevice(uint32_t deviceId)
     return false;
 }
 
+
+//------------------------------------------------------------------------------
+// Called without devicesLock held, after a call found the daemon connection dead
+static void removeDeadDevice(uint32_t deviceId)
+{
+    pthread_rwlock_wrlock(&devicesLock);
+    removeDevice(deviceId);
+    pthread_rwlock_unlock(&devicesLock);
+}
+
 //------------------------------------------------------------------------------
 // Parameter checking functions
 // Note that android-ndk renames __func__ to __PRETTY_FUNCTION__
@@ -158,13 +178,13 @@ bool removeDevice(uint32_t deviceId)
 
 //------------------------------------------------------------------------------
 // Socket marshaling and checking functions
-#define SEND_TO_DAEMON(CONNECTION, COMMAND, ...) \
+#define SEND_TO_DAEMON(DEVICE, CONNECTION, COMMAND, ...) \
 { \
     COMMAND ##_struct x = { \
         COMMAND, \
         __VA_ARGS__ \
     }; \
-    int ret = CONNECTION->writeData(&x, sizeof x); \
+    int ret = writeCommand(DEVICE, CONNECTION, &x, sizeof x); \
     if(ret < 0) { \
         LOG_E("sending to Daemon failed."); \
         mcResult = MC_DRV_ERR_SOCKET_WRITE; \
@@ -188,6 +208,56 @@ bool removeDevice(uint32_t deviceId)
         break; \
     } \
 }
+
+//------------------------------------------------------------------------------
+/**
+ * Send a command, optionally followed by data, to the daemon.
+ * If tracing is enabled and the daemon knows about it, the command carries a
+ * new trace ID, which becomes the current one of the calling thread.
+ * @param device Device the connection belongs to, NULL before it is opened.
+ * @return number of bytes written, -1 on failure.
+ */
+static int writeCommand(
+    Device      *device,
+    Connection  *connection,
+    void        *cmd,
+    uint32_t    len,
+    void        *data = NULL,
+    uint32_t    dataLen = 0
+)
+{
+    mcDrvCommandHeader_t header = *(mcDrvCommandHeader_t *)cmd;
+    mcDrvTraceHeader_t traceHeader;
+
+    traceHeader.traceId = 0;
+    if ((device != NULL) && mcTraceEnabled()
+            && (MC_GET_MAJOR_VERSION(device->daemonVersion) > 0
+                || MC_GET_MINOR_VERSION(device->daemonVersion) >= 5)) {
+        traceHeader.traceId = mcTraceNewId();
+        mcTraceSetCurrentId(traceHeader.traceId);
+        mcTraceRecord(MC_TRACE_CLIENT_SEND, MC_TRACE_INSTANT,
+                      traceHeader.traceId, header.commandId);
+        header.commandId = (mcDrvCmd_t)(header.commandId | MC_DRV_CMD_FLAG_TRACE);
+    } else if (data == NULL) {
+        return connection->writeData(cmd, len);
+    }
+
+    struct iovec iov[4];
+    int iovcnt = 0;
+    iov[iovcnt].iov_base = &header;
+    iov[iovcnt++].iov_len = sizeof(header);
+    if (traceHeader.traceId != 0) {
+        iov[iovcnt].iov_base = &traceHeader;
+        iov[iovcnt++].iov_len = sizeof(traceHeader);
+    }
+    iov[iovcnt].iov_base = (uint8_t *)cmd + sizeof(header);
+    iov[iovcnt++].iov_len = len - sizeof(header);
+    if (data != NULL) {
+        iov[iovcnt].iov_base = data;
+        iov[iovcnt++].iov_len = dataLen;
+    }
+    return connection->writeMessage(iov, iovcnt);
+}
 #endif /* WIN32 */
 
 //------------------------------------------------------------------------------
@@ -198,7 +268,7 @@ __MC_CLIENT_LIB_API mcResult_t mcOpenDevice(uint32_t deviceId)
 
     Connection *devCon = NULL;
 
-    devMutex.lock();
+    pthread_rwlock_wrlock(&devicesLock);
     LOG_I("===%s(%i)===", __FUNCTION__, deviceId);
 
     do {
@@ -237,7 +307,7 @@ __MC_CLIENT_LIB_API mcResult_t mcOpenDevice(uint32_t deviceId)
         LOG_I(" %s", errmsg);
 
         // Forward device open to the daemon and read result
-        SEND_TO_DAEMON(devCon, MC_DRV_CMD_OPEN_DEVICE, deviceId);
+        SEND_TO_DAEMON(NULL, devCon, MC_DRV_CMD_OPEN_DEVICE, deviceId);
 
         RECV_FROM_DAEMON(devCon, &mcResult);
 
@@ -249,6 +319,7 @@ __MC_CLIENT_LIB_API mcResult_t mcOpenDevice(uint32_t deviceId)
         // there is no payload to read
 
         device = new Device(deviceId, devCon);
+        device->daemonVersion = version;
         mcResult = device->open("/dev/" MC_USER_DEVNODE);
         if (mcResult != MC_DRV_OK) {
             delete device;
@@ -262,7 +333,7 @@ __MC_CLIENT_LIB_API mcResult_t mcOpenDevice(uint32_t deviceId)
 
     } while (false);
 
-    devMutex.unlock();
+    pthread_rwlock_unlock(&devicesLock);
     if (mcResult != MC_DRV_OK) {
         if (devCon != NULL)
             delete devCon;
@@ -284,7 +355,7 @@ __MC_CLIENT_LIB_API mcResult_t mcCloseDevice(
     mcResult_t mcResult = MC_DRV_OK;
 #ifndef WIN32
 
-	devMutex.lock();
+    pthread_rwlock_wrlock(&devicesLock);
     LOG_I("===%s(%i)===", __FUNCTION__, deviceId);
     do {
         Device *device = resolveDeviceId(deviceId);
@@ -309,7 +380,7 @@ __MC_CLIENT_LIB_API mcResult_t mcCloseDevice(
             break;
         }
 
-        SEND_TO_DAEMON(devCon, MC_DRV_CMD_CLOSE_DEVICE);
+        SEND_TO_DAEMON(device, devCon, MC_DRV_CMD_CLOSE_DEVICE);
 
         RECV_FROM_DAEMON(devCon, &mcResult);
 
@@ -322,7 +393,10 @@ __MC_CLIENT_LIB_API mcResult_t mcCloseDevice(
 
     } while (false);
 
-    devMutex.unlock();
+    pthread_rwlock_unlock(&devicesLock);
+
+    // Export the requests of the device while the TLC is still around
+    mcTraceFlush();
 
 #endif /* WIN32 */
 	return mcResult;
@@ -340,7 +414,7 @@ __MC_CLIENT_LIB_API mcResult_t mcOpenSession(
     mcResult_t mcResult = MC_DRV_OK;
 #ifndef WIN32
 
-    devMutex.lock();
+    pthread_rwlock_rdlock(&devicesLock);
     LOG_I("===%s()===", __FUNCTION__);
 
     BulkBufferDescriptor *bulkBuf = NULL;
@@ -364,6 +438,7 @@ __MC_CLIENT_LIB_API mcResult_t mcOpenSession(
 
         // First assume the TCI is a contiguous buffer
         // Get the physical address of the given TCI
+        uint32_t tciOffset = (uintptr_t)(tci) & 0xFFF;
         CWsm_ptr pWsm = device->findContiguousWsm(tci);
         if (pWsm == NULL) {
             if (tci != NULL && len != 0) {
@@ -387,17 +462,29 @@ __MC_CLIENT_LIB_API mcResult_t mcOpenSession(
                 break;
             }
             handle = pWsm->handle;
+            tciOffset = pWsm->offset;
         }
 
-        SEND_TO_DAEMON(devCon, MC_DRV_CMD_OPEN_SESSION,
-                       session->deviceId,
-                       *uuid,
-                       (uintptr_t)(tci) & 0xFFF,
-                       (uint32_t)handle,
-                       len);
+        mcDrvRspOpenSessionPayload_t rspOpenSessionPayload;
+        device->lockConnection();
+        do {
+            SEND_TO_DAEMON(device, devCon, MC_DRV_CMD_OPEN_SESSION,
+                           session->deviceId,
+                           *uuid,
+                           tciOffset,
+                           (uint32_t)handle,
+                           len);
 
-        // Read command response
-        RECV_FROM_DAEMON(devCon, &mcResult);
+            // Read command response
+            RECV_FROM_DAEMON(devCon, &mcResult);
+            if (mcResult != MC_DRV_OK) {
+                break;
+            }
+
+            // read payload
+            RECV_FROM_DAEMON(devCon, &rspOpenSessionPayload);
+        } while (false);
+        device->unlockConnection();
 
         if (mcResult != MC_DRV_OK) {
             // TODO-2012-09-06-haenellu: Remove this code once tests can handle it
@@ -443,9 +530,6 @@ __MC_CLIENT_LIB_API mcResult_t mcOpenSession(
             break; // loading of Trustlet failed, unlock mutex and return
         }
 
-        // read payload
-        mcDrvRspOpenSessionPayload_t rspOpenSessionPayload;
-        RECV_FROM_DAEMON(devCon, &rspOpenSessionPayload);
 
         // Register session with handle
         session->sessionId = rspOpenSessionPayload.sessionId;
@@ -454,6 +538,8 @@ __MC_CLIENT_LIB_API mcResult_t mcOpenSession(
 
         // Set up second channel for notifications
         Connection *sessionConnection = new Connection();
+        // Notification sets wait on the socket, keep notifications in it
+        sessionConnection->readAhead = false;
         if (!sessionConnection->connect(SOCK_PATH)) {
             LOG_E("Could not connect to %s", SOCK_PATH);
             delete sessionConnection;
@@ -464,7 +550,7 @@ __MC_CLIENT_LIB_API mcResult_t mcOpenSession(
         }
 
         do {
-            SEND_TO_DAEMON(sessionConnection, MC_DRV_CMD_NQ_CONNECT,
+            SEND_TO_DAEMON(device, sessionConnection, MC_DRV_CMD_NQ_CONNECT,
                            session->deviceId,
                            session->sessionId,
                            rspOpenSessionPayload.deviceSessionId,
@@ -492,6 +578,8 @@ __MC_CLIENT_LIB_API mcResult_t mcOpenSession(
         // If the session tci was a mapped buffer then register it
         if (bulkBuf)
             sessionObj->addBulkBuf(bulkBuf);
+        // A carved TCI must not be reused while the session is open
+        sessionObj->tciWsm = pWsm;
 
         LOG_I(" Successfully opened session %d.", session->sessionId);
 
@@ -507,7 +595,7 @@ __MC_CLIENT_LIB_API mcResult_t mcOpenSession(
 //        removeDevice(session->deviceId);
 //    }
 
-    devMutex.unlock();
+    pthread_rwlock_unlock(&devicesLock);
 
 #endif /* WIN32 */
     return mcResult;
@@ -526,7 +614,7 @@ __MC_CLIENT_LIB_API mcResult_t mcOpenTrustlet(
     mcResult_t mcResult = MC_DRV_OK;
 #ifndef WIN32
 
-    devMutex.lock();
+    pthread_rwlock_rdlock(&devicesLock);
     LOG_I("===%s()===", __FUNCTION__);
 
     BulkBufferDescriptor *bulkBuf = NULL;
@@ -551,6 +639,7 @@ __MC_CLIENT_LIB_API mcResult_t mcOpenTrustlet(
 
         // First assume the TCI is a contiguous buffer
         // Get the physical address of the given TCI
+        uint32_t tciOffset = (uintptr_t)(tci) & 0xFFF;
         CWsm_ptr pWsm = device->findContiguousWsm(tci);
         if (pWsm == NULL) {
             // Then assume it's a normal buffer that needs to be mapped
@@ -568,28 +657,41 @@ __MC_CLIENT_LIB_API mcResult_t mcOpenTrustlet(
                 break;
             }
             handle = pWsm->handle;
+            tciOffset = pWsm->offset;
         }
 
-        SEND_TO_DAEMON(devCon, MC_DRV_CMD_OPEN_TRUSTLET,
-                       session->deviceId,
-                       spid,
-                       (uint32_t)tlen,
-                       (uintptr_t)(tci) & 0xFFF,
-                       (uint32_t)handle,
-                       len);
-
-        // Send the full trustlet data
-        int ret = devCon->writeData(trustlet, tlen);
-        if (ret < 0) {
-            LOG_E("sending to Daemon failed.");
-            \
-            mcResult = MC_DRV_ERR_SOCKET_WRITE;
-            \
-            break;
-        }
+        mcDrvRspOpenSessionPayload_t rspOpenSessionPayload;
+        device->lockConnection();
+        do {
+            MC_DRV_CMD_OPEN_TRUSTLET_struct cmdOpenTrustlet = {
+                MC_DRV_CMD_OPEN_TRUSTLET,
+                session->deviceId,
+                spid,
+                (uint32_t)tlen,
+                tciOffset,
+                (uint32_t)handle,
+                len
+            };
+
+            // Send the command and the full trustlet data in one message
+            int ret = writeCommand(device, devCon, &cmdOpenTrustlet,
+                                   sizeof(cmdOpenTrustlet), trustlet, tlen);
+            if (ret < 0) {
+                LOG_E("sending to Daemon failed.");
+                mcResult = MC_DRV_ERR_SOCKET_WRITE;
+                break;
+            }
 
-        // Read command response
-        RECV_FROM_DAEMON(devCon, &mcResult);
+            // Read command response
+            RECV_FROM_DAEMON(devCon, &mcResult);
+            if (mcResult != MC_DRV_OK) {
+                break;
+            }
+
+            // read payload
+            RECV_FROM_DAEMON(devCon, &rspOpenSessionPayload);
+        } while (false);
+        device->unlockConnection();
 
         if (mcResult != MC_DRV_OK) {
             // TODO-2012-09-06-haenellu: Remove this code once tests can handle it
@@ -635,9 +737,6 @@ __MC_CLIENT_LIB_API mcResult_t mcOpenTrustlet(
             break; // loading of Trustlet failed, unlock mutex and return
         }
 
-        // read payload
-        mcDrvRspOpenSessionPayload_t rspOpenSessionPayload;
-        RECV_FROM_DAEMON(devCon, &rspOpenSessionPayload);
 
         // Register session with handle
         session->sessionId = rspOpenSessionPayload.sessionId;
@@ -646,6 +745,8 @@ __MC_CLIENT_LIB_API mcResult_t mcOpenTrustlet(
 
         // Set up second channel for notifications
         Connection *sessionConnection = new Connection();
+        // Notification sets wait on the socket, keep notifications in it
+        sessionConnection->readAhead = false;
         if (!sessionConnection->connect(SOCK_PATH)) {
             LOG_E("Could not connect to %s", SOCK_PATH);
             delete sessionConnection;
@@ -656,7 +757,7 @@ __MC_CLIENT_LIB_API mcResult_t mcOpenTrustlet(
         }
 
         do {
-            SEND_TO_DAEMON(sessionConnection, MC_DRV_CMD_NQ_CONNECT,
+            SEND_TO_DAEMON(device, sessionConnection, MC_DRV_CMD_NQ_CONNECT,
                            session->deviceId,
                            session->sessionId,
                            rspOpenSessionPayload.deviceSessionId,
@@ -685,6 +786,8 @@ __MC_CLIENT_LIB_API mcResult_t mcOpenTrustlet(
         // If the session tci was a mapped buffer then register it
         if (bulkBuf)
             sessionObj->addBulkBuf(bulkBuf);
+        // A carved TCI must not be reused while the session is open
+        sessionObj->tciWsm = pWsm;
 
         LOG_I(" Successfully opened session %d.", session->sessionId);
 
@@ -700,7 +803,7 @@ __MC_CLIENT_LIB_API mcResult_t mcOpenTrustlet(
 //        removeDevice(session->deviceId);
 //    }
 
-    devMutex.unlock();
+    pthread_rwlock_unlock(&devicesLock);
 
 #endif /* WIN32 */
     return mcResult;
@@ -717,7 +820,7 @@ __MC_CLIENT_LIB_API mcResult_t mcOpenGPTA(
     mcResult_t mcResult = MC_DRV_OK;
 
 #ifndef WIN32
-    devMutex.lock();
+    pthread_rwlock_rdlock(&devicesLock);
     LOG_I("===%s()===", __FUNCTION__);
 
     BulkBufferDescriptor *bulkBuf = NULL;
@@ -741,6 +844,7 @@ __MC_CLIENT_LIB_API mcResult_t mcOpenGPTA(
 
         // First assume the TCI is a contiguous buffer
         // Get the physical address of the given TCI
+        uint32_t tciOffset = (uintptr_t)(tci) & 0xFFF;
         CWsm_ptr pWsm = device->findContiguousWsm(tci);
         if (pWsm == NULL) {
             if (tci != NULL && len != 0) {
@@ -764,17 +868,29 @@ __MC_CLIENT_LIB_API mcResult_t mcOpenGPTA(
                 break;
             }
             handle = pWsm->handle;
+            tciOffset = pWsm->offset;
         }
 
-        SEND_TO_DAEMON(devCon, MC_DRV_CMD_OPEN_TRUSTED_APP,
-                       session->deviceId,
-                       *uuid,
-                       (uintptr_t)(tci) & 0xFFF,
-                       (uint32_t)handle,
-                       len);
+        mcDrvRspOpenSessionPayload_t rspOpenSessionPayload;
+        device->lockConnection();
+        do {
+            SEND_TO_DAEMON(device, devCon, MC_DRV_CMD_OPEN_TRUSTED_APP,
+                           session->deviceId,
+                           *uuid,
+                           tciOffset,
+                           (uint32_t)handle,
+                           len);
+
+            // Read command response
+            RECV_FROM_DAEMON(devCon, &mcResult);
+            if (mcResult != MC_DRV_OK) {
+                break;
+            }
 
-        // Read command response
-        RECV_FROM_DAEMON(devCon, &mcResult);
+            // read payload
+            RECV_FROM_DAEMON(devCon, &rspOpenSessionPayload);
+        } while (false);
+        device->unlockConnection();
 
         if (mcResult != MC_DRV_OK) {
             // TODO-2012-09-06-haenellu: Remove this code once tests can handle it
@@ -820,9 +936,6 @@ __MC_CLIENT_LIB_API mcResult_t mcOpenGPTA(
             break; // loading of Trustlet failed, unlock mutex and return
         }
 
-        // read payload
-        mcDrvRspOpenSessionPayload_t rspOpenSessionPayload;
-        RECV_FROM_DAEMON(devCon, &rspOpenSessionPayload);
 
         // Register session with handle
         session->sessionId = rspOpenSessionPayload.sessionId;
@@ -831,6 +944,8 @@ __MC_CLIENT_LIB_API mcResult_t mcOpenGPTA(
 
         // Set up second channel for notifications
         Connection *sessionConnection = new Connection();
+        // Notification sets wait on the socket, keep notifications in it
+        sessionConnection->readAhead = false;
         if (!sessionConnection->connect(SOCK_PATH)) {
             LOG_E("Could not connect to %s", SOCK_PATH);
             delete sessionConnection;
@@ -841,7 +956,7 @@ __MC_CLIENT_LIB_API mcResult_t mcOpenGPTA(
         }
 
         do {
-            SEND_TO_DAEMON(sessionConnection, MC_DRV_CMD_NQ_CONNECT,
+            SEND_TO_DAEMON(device, sessionConnection, MC_DRV_CMD_NQ_CONNECT,
                            session->deviceId,
                            session->sessionId,
                            rspOpenSessionPayload.deviceSessionId,
@@ -869,6 +984,8 @@ __MC_CLIENT_LIB_API mcResult_t mcOpenGPTA(
         // If the session tci was a mapped buffer then register it
         if (bulkBuf)
             sessionObj->addBulkBuf(bulkBuf);
+        // A carved TCI must not be reused while the session is open
+        sessionObj->tciWsm = pWsm;
 
         LOG_I(" Successfully opened session %d.", session->sessionId);
 
@@ -884,7 +1001,7 @@ __MC_CLIENT_LIB_API mcResult_t mcOpenGPTA(
 //        removeDevice(session->deviceId);
 //    }
 
-    devMutex.unlock();
+    pthread_rwlock_unlock(&devicesLock);
 
 #endif /* WIN32 */
     return mcResult;
@@ -897,7 +1014,7 @@ __MC_CLIENT_LIB_API mcResult_t mcCloseSession(mcSessionHandle_t *session)
 #ifndef WIN32
 
     LOG_I("===%s()===", __FUNCTION__);
-    devMutex.lock();
+    pthread_rwlock_rdlock(&devicesLock);
     do {
         CHECK_NOT_NULL(session);
         LOG_I(" Closing session %d.", session->sessionId);
@@ -911,9 +1028,17 @@ __MC_CLIENT_LIB_API mcResult_t mcCloseSession(mcSessionHandle_t *session)
 
         CHECK_SESSION(nqSession, session->sessionId);
 
-        SEND_TO_DAEMON(devCon, MC_DRV_CMD_CLOSE_SESSION, session->sessionId);
+        device->lockConnection();
+        do {
+            SEND_TO_DAEMON(device, devCon, MC_DRV_CMD_CLOSE_SESSION, session->sessionId);
 
-        RECV_FROM_DAEMON(devCon, &mcResult);
+            RECV_FROM_DAEMON(devCon, &mcResult);
+        } while (false);
+        device->unlockConnection();
+
+        if (mcResult == MC_DRV_ERR_SOCKET_WRITE || mcResult == MC_DRV_ERR_SOCKET_READ) {
+            break;
+        }
 
         if (mcResult != MC_DRV_OK) {
             LOG_E("CMD_CLOSE_SESSION failed, respId=%d", mcResult);
@@ -933,13 +1058,13 @@ __MC_CLIENT_LIB_API mcResult_t mcCloseSession(mcSessionHandle_t *session)
 
     } while (false);
 
+    pthread_rwlock_unlock(&devicesLock);
+
     if (mcResult == MC_DRV_ERR_SOCKET_WRITE || mcResult == MC_DRV_ERR_SOCKET_READ) {
         LOG_E("Connection is dead, removing device.");
-        removeDevice(session->deviceId);
+        removeDeadDevice(session->deviceId);
     }
 
-    devMutex.unlock();
-
 #endif /* WIN32 */
     return mcResult;
 }
@@ -953,7 +1078,7 @@ __MC_CLIENT_LIB_API mcResult_t mcNotify(
     mcResult_t mcResult = MC_DRV_OK;
 #ifndef WIN32
 
-	devMutex.lock();
+    pthread_rwlock_rdlock(&devicesLock);
     LOG_I("===%s()===", __FUNCTION__);
 
     do {
@@ -968,22 +1093,98 @@ __MC_CLIENT_LIB_API mcResult_t mcNotify(
         Session *nqsession = device->resolveSessionId(session->sessionId);
         CHECK_SESSION(nqsession, session->sessionId);
 
-        SEND_TO_DAEMON(devCon, MC_DRV_CMD_NOTIFY, session->sessionId);
-        // Daemon will not return a response
+        device->lockConnection();
+        do {
+            SEND_TO_DAEMON(device, devCon, MC_DRV_CMD_NOTIFY, session->sessionId);
+            // Daemon will not return a response
+            nqsession->traceId = mcTraceCurrentId();
+        } while (false);
+        device->unlockConnection();
     } while (false);
 
+    pthread_rwlock_unlock(&devicesLock);
+
     if (mcResult == MC_DRV_ERR_SOCKET_WRITE) {
         LOG_E("Connection is dead, removing device.");
-        removeDevice(session->deviceId);
+        removeDeadDevice(session->deviceId);
     }
 
-    devMutex.unlock();
-
 #endif /* WIN32 */
     return mcResult;
 }
 
 
+//------------------------------------------------------------------------------
+/**
+ * Drain the notification queue of a session.
+ * Must be called without devicesLock if timeout is not MC_NO_TIMEOUT.
+ */
+static mcResult_t readNotifications(
+    Session     *nqSession,
+    int32_t     timeout,
+    bool        *connectionDead
+)
+{
+    mcResult_t mcResult = MC_DRV_OK;
+    Connection *nqconnection = nqSession->notificationConnection;
+    uint32_t count = 0;
+
+    // Read notification queue till it's empty
+    for (;;) {
+        notification_t notification;
+        ssize_t numRead = nqconnection->readData(
+                              &notification,
+                              sizeof(notification_t),
+                              timeout);
+        //Exit on timeout in first run
+        //Later runs have timeout set to 0. -2 means, there is no more data.
+        if (count == 0 && numRead == -2 ) {
+            LOG_W("Timeout hit at %s", __FUNCTION__);
+            mcResult = MC_DRV_ERR_TIMEOUT;
+            break;
+        }
+        if (count == 0 && numRead == 0 ) {
+            *connectionDead = true;
+            mcResult = MC_DRV_ERR_NOTIFICATION;
+            break;
+        }
+        // After first notification the queue will be drained, Thus we set
+        // no timeout for the following reads
+        timeout = 0;
+
+        if (numRead != sizeof(notification_t)) {
+            if (count == 0) {
+                //failure in first read, notify it
+                mcResult = MC_DRV_ERR_NOTIFICATION;
+                LOG_E("read notification failed, %i bytes received", (int)numRead);
+                break;
+            } else {
+                // Read of the n-th notification failed/timeout. We don't tell the
+                // caller, as we got valid notifications before.
+                mcResult = MC_DRV_OK;
+                break;
+            }
+        }
+
+        count++;
+        LOG_I(" Received notification %d for session %d, payload=%d",
+              count, notification.sessionId, notification.payload);
+        mcTraceRecord(MC_TRACE_CLIENT_WAKE, MC_TRACE_INSTANT,
+                      nqSession->traceId, notification.sessionId);
+
+        if (notification.payload != 0) {
+            // Session end point died -> store exit code
+            nqSession->setErrorInfo(notification.payload);
+
+            mcResult = MC_DRV_INFO_NOTIFICATION;
+            break;
+        }
+    } // for(;;)
+
+    return mcResult;
+}
+
+
 //------------------------------------------------------------------------------
 __MC_CLIENT_LIB_API mcResult_t mcWaitNotification(
     mcSessionHandle_t  *session,
@@ -993,12 +1194,12 @@ __MC_CLIENT_LIB_API mcResult_t mcWaitNotification(
     mcResult_t mcResult = MC_DRV_OK;
 #ifndef WIN32
 
-    // TODO-2012-11-02-gurel: devMutex locking and unlocking had to be commented out
-    // below. Otherwise, when there are multiple threads in Nwd TLC side, we endup a
-    // deadlock situation, e.g. one thread waits for notification and another one sends
-    // notification.
+    // The device list is only held while the session is looked up. Waiting
+    // for the notification itself must not block other threads, e.g. one
+    // thread waits for notification and another one sends notification.
+    bool connectionDead = false;
 
-    //devMutex.lock();
+    pthread_rwlock_rdlock(&devicesLock);
     LOG_I("===%s()===", __FUNCTION__);
 
     do {
@@ -1011,64 +1212,239 @@ __MC_CLIENT_LIB_API mcResult_t mcWaitNotification(
         Session  *nqSession = device->resolveSessionId(session->sessionId);
         CHECK_SESSION(nqSession, session->sessionId);
 
-        Connection *nqconnection = nqSession->notificationConnection;
-        uint32_t count = 0;
-
-        // Read notification queue till it's empty
-        for (;;) {
-            notification_t notification;
-            ssize_t numRead = nqconnection->readData(
-                                  &notification,
-                                  sizeof(notification_t),
-                                  timeout);
-            //Exit on timeout in first run
-            //Later runs have timeout set to 0. -2 means, there is no more data.
-            if (count == 0 && numRead == -2 ) {
-                LOG_W("Timeout hit at %s", __FUNCTION__);
-                mcResult = MC_DRV_ERR_TIMEOUT;
-                break;
-            }
-            if (count == 0 && numRead == 0 ) {
-                LOG_E("Connection is dead, removing device.");
-                removeDevice(session->deviceId);
-                mcResult = MC_DRV_ERR_NOTIFICATION;
-                break;
+        pthread_rwlock_unlock(&devicesLock);
+
+        mcResult = readNotifications(nqSession, timeout, &connectionDead);
+
+        pthread_rwlock_rdlock(&devicesLock);
+
+    } while (false);
+
+    pthread_rwlock_unlock(&devicesLock);
+
+    if (connectionDead) {
+        LOG_E("Connection is dead, removing device.");
+        removeDeadDevice(session->deviceId);
+    }
+
+#endif /* WIN32 */
+    return mcResult;
+}
+
+
+//------------------------------------------------------------------------------
+__MC_CLIENT_LIB_API mcResult_t mcOpenNotificationSet(
+    int32_t            *setFd
+)
+{
+    mcResult_t mcResult = MC_DRV_OK;
+#ifndef WIN32
+
+    LOG_I("===%s()===", __FUNCTION__);
+
+    do {
+        CHECK_NOT_NULL(setFd);
+
+        int fd = epoll_create1(EPOLL_CLOEXEC);
+        if (fd < 0) {
+            LOG_ERRNO("epoll_create1");
+            mcResult = MC_DRV_ERR_NOTIFICATION;
+            break;
+        }
+        *setFd = fd;
+    } while (false);
+
+#endif /* WIN32 */
+    return mcResult;
+}
+
+
+//------------------------------------------------------------------------------
+__MC_CLIENT_LIB_API mcResult_t mcCloseNotificationSet(
+    int32_t            setFd
+)
+{
+    mcResult_t mcResult = MC_DRV_OK;
+#ifndef WIN32
+
+    LOG_I("===%s()===", __FUNCTION__);
+
+    if (close(setFd) != 0) {
+        LOG_ERRNO("close");
+        mcResult = MC_DRV_ERR_INVALID_PARAMETER;
+    }
+
+#endif /* WIN32 */
+    return mcResult;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * Add a session to or remove it from a notification set.
+ */
+static mcResult_t updateNotificationSet(
+    int32_t            setFd,
+    mcSessionHandle_t  *session,
+    int                op
+)
+{
+    mcResult_t mcResult = MC_DRV_OK;
+#ifndef WIN32
+
+    pthread_rwlock_rdlock(&devicesLock);
+
+    do {
+        CHECK_NOT_NULL(session);
+
+        Device *device = resolveDeviceId(session->deviceId);
+        CHECK_DEVICE(device);
+
+        Session *nqSession = device->resolveSessionId(session->sessionId);
+        CHECK_SESSION(nqSession, session->sessionId);
+
+        // The session is identified by its handle, so that a session
+        // closed in the meantime is never resolved to a stale object.
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.u64 = ((uint64_t)session->deviceId << 32) | session->sessionId;
+
+        if (epoll_ctl(setFd, op, nqSession->notificationConnection->socketDescriptor, &event) != 0) {
+            LOG_ERRNO("epoll_ctl");
+            mcResult = (errno == EEXIST || errno == ENOENT)
+                       ? MC_DRV_ERR_INVALID_PARAMETER : MC_DRV_ERR_NOTIFICATION;
+            break;
+        }
+    } while (false);
+
+    pthread_rwlock_unlock(&devicesLock);
+
+#endif /* WIN32 */
+    return mcResult;
+}
+
+
+//------------------------------------------------------------------------------
+__MC_CLIENT_LIB_API mcResult_t mcAddToNotificationSet(
+    int32_t            setFd,
+    mcSessionHandle_t  *session
+)
+{
+    LOG_I("===%s()===", __FUNCTION__);
+#ifndef WIN32
+    return updateNotificationSet(setFd, session, EPOLL_CTL_ADD);
+#else
+    return MC_DRV_OK;
+#endif /* WIN32 */
+}
+
+
+//------------------------------------------------------------------------------
+__MC_CLIENT_LIB_API mcResult_t mcRemoveFromNotificationSet(
+    int32_t            setFd,
+    mcSessionHandle_t  *session
+)
+{
+    LOG_I("===%s()===", __FUNCTION__);
+#ifndef WIN32
+    return updateNotificationSet(setFd, session, EPOLL_CTL_DEL);
+#else
+    return MC_DRV_OK;
+#endif /* WIN32 */
+}
+
+
+//------------------------------------------------------------------------------
+__MC_CLIENT_LIB_API mcResult_t mcWaitNotificationSet(
+    int32_t            setFd,
+    mcSessionHandle_t  *sessions,
+    mcResult_t         *results,
+    uint32_t           *count,
+    int32_t            timeout
+)
+{
+    mcResult_t mcResult = MC_DRV_OK;
+#ifndef WIN32
+
+    LOG_I("===%s()===", __FUNCTION__);
+
+    do {
+        CHECK_NOT_NULL(sessions);
+        CHECK_NOT_NULL(results);
+        CHECK_NOT_NULL(count);
+
+        uint32_t maxEvents = *count;
+        if (maxEvents == 0) {
+            mcResult = MC_DRV_ERR_INVALID_PARAMETER;
+            break;
+        }
+        if (maxEvents > MC_NOTIFICATION_SET_MAX_EVENTS) {
+            maxEvents = MC_NOTIFICATION_SET_MAX_EVENTS;
+        }
+        *count = 0;
+
+        struct epoll_event events[MC_NOTIFICATION_SET_MAX_EVENTS];
+        int numEvents;
+        do {
+            numEvents = epoll_wait(setFd, events, maxEvents, timeout >= 0 ? timeout : -1);
+        } while (numEvents < 0 && errno == EINTR);
+
+        if (numEvents < 0) {
+            LOG_ERRNO("epoll_wait");
+            mcResult = MC_DRV_ERR_NOTIFICATION;
+            break;
+        }
+        if (numEvents == 0) {
+            LOG_W("Timeout hit at %s", __FUNCTION__);
+            mcResult = MC_DRV_ERR_TIMEOUT;
+            break;
+        }
+
+        uint32_t deadDevices[MC_NOTIFICATION_SET_MAX_EVENTS];
+        uint32_t numDeadDevices = 0;
+
+        pthread_rwlock_rdlock(&devicesLock);
+        for (int i = 0; i < numEvents; i++) {
+            uint32_t deviceId = (uint32_t)(events[i].data.u64 >> 32);
+            uint32_t sessionId = (uint32_t)events[i].data.u64;
+
+            Device *device = resolveDeviceId(deviceId);
+            if (device == NULL) {
+                continue;
             }
-            // After first notification the queue will be drained, Thus we set
-            // no timeout for the following reads
-            timeout = 0;
-
-            if (numRead != sizeof(notification_t)) {
-                if (count == 0) {
-                    //failure in first read, notify it
-                    mcResult = MC_DRV_ERR_NOTIFICATION;
-                    LOG_E("read notification failed, %i bytes received", (int)numRead);
-                    break;
-                } else {
-                    // Read of the n-th notification failed/timeout. We don't tell the
-                    // caller, as we got valid notifications before.
-                    mcResult = MC_DRV_OK;
-                    break;
-                }
+            Session *nqSession = device->resolveSessionId(sessionId);
+            if (nqSession == NULL) {
+                continue;
             }
 
-            count++;
-            LOG_I(" Received notification %d for session %d, payload=%d",
-                  count, notification.sessionId, notification.payload);
+            // The socket is readable, so draining it does not block
+            bool connectionDead = false;
+            mcResult_t sessionResult = readNotifications(nqSession, MC_NO_TIMEOUT, &connectionDead);
+            if (sessionResult == MC_DRV_ERR_TIMEOUT) {
+                // Drained by a concurrent mcWaitNotification()
+                continue;
+            }
+            if (connectionDead) {
+                deadDevices[numDeadDevices++] = deviceId;
+            }
 
-            if (notification.payload != 0) {
-                // Session end point died -> store exit code
-                nqSession->setErrorInfo(notification.payload);
+            sessions[*count].deviceId = deviceId;
+            sessions[*count].sessionId = sessionId;
+            results[*count] = sessionResult;
+            (*count)++;
+        }
+        pthread_rwlock_unlock(&devicesLock);
 
-                mcResult = MC_DRV_INFO_NOTIFICATION;
-                break;
-            }
-        } // for(;;)
+        for (uint32_t i = 0; i < numDeadDevices; i++) {
+            LOG_E("Connection is dead, removing device.");
+            removeDeadDevice(deadDevices[i]);
+        }
 
+        if (*count == 0) {
+            mcResult = MC_DRV_ERR_TIMEOUT;
+        }
     } while (false);
 
-    //devMutex.unlock();
-
 #endif /* WIN32 */
     return mcResult;
 }
@@ -1087,7 +1463,7 @@ __MC_CLIENT_LIB_API mcResult_t mcMallocWsm(
 
     LOG_I("===%s(len=%i)===", __FUNCTION__, len);
 
-    devMutex.lock();
+    pthread_rwlock_rdlock(&devicesLock);
 
     do {
         Device *device = resolveDeviceId(deviceId);
@@ -1112,7 +1488,7 @@ __MC_CLIENT_LIB_API mcResult_t mcMallocWsm(
 
     } while (false);
 
-    devMutex.unlock();
+    pthread_rwlock_unlock(&devicesLock);
 
 #endif /* WIN32 */
     return mcResult;
@@ -1130,7 +1506,7 @@ __MC_CLIENT_LIB_API mcResult_t mcFreeWsm(
 
     Device *device;
 
-    devMutex.lock();
+    pthread_rwlock_rdlock(&devicesLock);
 
     LOG_I("===%s(%p)===", __FUNCTION__, wsm);
 
@@ -1163,7 +1539,7 @@ __MC_CLIENT_LIB_API mcResult_t mcFreeWsm(
 
     } while (false);
 
-    devMutex.unlock();
+    pthread_rwlock_unlock(&devicesLock);
 
 #endif /* WIN32 */
     return mcResult;
@@ -1184,7 +1560,7 @@ __MC_CLIENT_LIB_API mcResult_t mcMap(
 
     LOG_I("===%s()===", __FUNCTION__);
 
-    devMutex.lock();
+    pthread_rwlock_rdlock(&devicesLock);
 
     do {
         CHECK_NOT_NULL(sessionHandle);
@@ -1215,15 +1591,25 @@ __MC_CLIENT_LIB_API mcResult_t mcMap(
             break;
         }
 
-        SEND_TO_DAEMON(devCon, MC_DRV_CMD_MAP_BULK_BUF,
-                       session->sessionId,
-                       (uint32_t)bulkBuf->handle,
-                       (uint32_t)0,
-                       (uintptr_t)(bulkBuf->virtAddr) & 0xFFF,
-                       bulkBuf->len);
+        mcDrvRspMapBulkMemPayload_t rspMapBulkMemPayload;
+        device->lockConnection();
+        do {
+            SEND_TO_DAEMON(device, devCon, MC_DRV_CMD_MAP_BULK_BUF,
+                           session->sessionId,
+                           (uint32_t)bulkBuf->handle,
+                           (uint32_t)0,
+                           (uintptr_t)(bulkBuf->virtAddr) & 0xFFF,
+                           bulkBuf->len);
+
+            // Read command response
+            RECV_FROM_DAEMON(devCon, &mcResult);
+            if (mcResult != MC_DRV_OK) {
+                break;
+            }
 
-        // Read command response
-        RECV_FROM_DAEMON(devCon, &mcResult);
+            RECV_FROM_DAEMON(devCon, &rspMapBulkMemPayload);
+        } while (false);
+        device->unlockConnection();
 
         if (mcResult != MC_DRV_OK) {
             LOG_E("CMD_MAP_BULK_BUF failed, respId=%d", mcResult);
@@ -1239,9 +1625,6 @@ __MC_CLIENT_LIB_API mcResult_t mcMap(
             break;
         }
 
-        mcDrvRspMapBulkMemPayload_t rspMapBulkMemPayload;
-        RECV_FROM_DAEMON(devCon, &rspMapBulkMemPayload);
-
         // Set mapping info for internal structures
         bulkBuf->sVirtualAddr = (void *)(uintptr_t)rspMapBulkMemPayload.secureVirtualAdr;
         // Set mapping info for Trustlet
@@ -1257,7 +1640,7 @@ __MC_CLIENT_LIB_API mcResult_t mcMap(
 //        removeDevice(sessionHandle->deviceId);
 //    }
 
-    devMutex.unlock();
+    pthread_rwlock_unlock(&devicesLock);
 
 #endif /* WIN32 */
     return mcResult;
@@ -1277,7 +1660,7 @@ __MC_CLIENT_LIB_API mcResult_t mcUnmap(
 
     LOG_I("===%s()===", __FUNCTION__);
 
-    devMutex.lock();
+    pthread_rwlock_rdlock(&devicesLock);
 
     do {
         CHECK_NOT_NULL(sessionHandle);
@@ -1308,13 +1691,21 @@ __MC_CLIENT_LIB_API mcResult_t mcUnmap(
 
         LOG_I(" Unmapping %p(handle=%u) from session %d.", buf, handle, sessionHandle->sessionId);
 
-        SEND_TO_DAEMON(devCon, MC_DRV_CMD_UNMAP_BULK_BUF,
-                       session->sessionId,
-                       handle,
-                       (uintptr_t)(mapInfo->sVirtualAddr),
-                       mapInfo->sVirtualLen);
+        device->lockConnection();
+        do {
+            SEND_TO_DAEMON(device, devCon, MC_DRV_CMD_UNMAP_BULK_BUF,
+                           session->sessionId,
+                           handle,
+                           (uintptr_t)(mapInfo->sVirtualAddr),
+                           mapInfo->sVirtualLen);
 
-        RECV_FROM_DAEMON(devCon, &mcResult);
+            RECV_FROM_DAEMON(devCon, &mcResult);
+        } while (false);
+        device->unlockConnection();
+
+        if (mcResult == MC_DRV_ERR_SOCKET_WRITE || mcResult == MC_DRV_ERR_SOCKET_READ) {
+            break;
+        }
 
         if (mcResult != MC_DRV_OK) {
             LOG_E("Daemon reported failing of UNMAP BULK BUF command, responseId %d.", mcResult);
@@ -1335,12 +1726,338 @@ __MC_CLIENT_LIB_API mcResult_t mcUnmap(
 
     } while (false);
 
+    pthread_rwlock_unlock(&devicesLock);
+
     if (mcResult == MC_DRV_ERR_SOCKET_WRITE || mcResult == MC_DRV_ERR_SOCKET_READ) {
         LOG_E("Connection is dead, removing device.");
-        removeDevice(sessionHandle->deviceId);
+        removeDeadDevice(sessionHandle->deviceId);
     }
 
-    devMutex.unlock();
+#endif /* WIN32 */
+    return mcResult;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * Check if the daemon of a device knows the bulk buffer list commands.
+ */
+static bool hasBulkBufLists(uint32_t deviceId)
+{
+    bool ret = false;
+
+    pthread_rwlock_rdlock(&devicesLock);
+    Device *device = resolveDeviceId(deviceId);
+    if (device != NULL) {
+        ret = MC_GET_MAJOR_VERSION(device->daemonVersion) > 0
+              || MC_GET_MINOR_VERSION(device->daemonVersion) >= 3;
+    }
+    pthread_rwlock_unlock(&devicesLock);
+
+    return ret;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * Map up to MC_DRV_BULK_BUF_LIST_MAX buffers with one daemon command.
+ */
+static mcResult_t mapBulkBufList(
+    mcSessionHandle_t  *sessionHandle,
+    mcBulkBuf_t        *bufs,
+    uint32_t           count
+)
+{
+    mcResult_t mcResult = MC_DRV_OK;
+
+    pthread_rwlock_rdlock(&devicesLock);
+
+    do {
+        // Determine device the session belongs to
+        Device *device = resolveDeviceId(sessionHandle->deviceId);
+        // Is the device known
+        CHECK_DEVICE(device);
+
+        // Is the device opened.
+        CHECK_DEVICE_CLOSED(device, sessionHandle->deviceId)
+
+        Connection *devCon = device->connection;
+
+        // Get session
+        Session *session = device->resolveSessionId(sessionHandle->sessionId);
+        CHECK_SESSION(session, sessionHandle->sessionId);
+
+        MC_DRV_CMD_MAP_BULK_BUF_LIST_struct cmd;
+        memset(&cmd, 0, sizeof(cmd));
+        cmd.commandId = MC_DRV_CMD_MAP_BULK_BUF_LIST;
+        cmd.sessionId = session->sessionId;
+        cmd.count = count;
+
+        // Register all buffers to Kernel Module first
+        BulkBufferDescriptor *bulkBufs[MC_DRV_BULK_BUF_LIST_MAX];
+        uint32_t registered;
+        for (registered = 0; registered < count; registered++) {
+            mcBulkBuf_t *bulk = &bufs[registered];
+            CHECK_NOT_NULL(bulk->buf);
+            CHECK_NOT_NULL(bulk->mapInfo);
+
+            LOG_I(" Mapping %p to session %d.", bulk->buf, sessionHandle->sessionId);
+
+            mcResult = session->addBulkBuf(bulk->buf, bulk->len, &bulkBufs[registered]);
+            if (mcResult != MC_DRV_OK) {
+                LOG_E("Registering buffer failed. ret=%x", mcResult);
+                break;
+            }
+            cmd.entries[registered].handle = bulkBufs[registered]->handle;
+            cmd.entries[registered].offsetPayload = (uintptr_t)(bulk->buf) & 0xFFF;
+            cmd.entries[registered].lenBulkMem = bulk->len;
+        }
+
+        mcDrvRspMapBulkMemListPayload_t rspPayload;
+        if (mcResult == MC_DRV_OK) {
+            device->lockConnection();
+            do {
+                int ret = writeCommand(device, devCon, &cmd, sizeof(cmd));
+                if (ret < 0) {
+                    LOG_E("sending to Daemon failed.");
+                    mcResult = MC_DRV_ERR_SOCKET_WRITE;
+                    break;
+                }
+
+                // Read command response
+                RECV_FROM_DAEMON(devCon, &mcResult);
+                if (mcResult != MC_DRV_OK) {
+                    break;
+                }
+
+                RECV_FROM_DAEMON(devCon, &rspPayload);
+            } while (false);
+            device->unlockConnection();
+
+            if (mcResult != MC_DRV_OK) {
+                LOG_E("CMD_MAP_BULK_BUF_LIST failed, respId=%d", mcResult);
+                // Same as mcMap()
+                mcResult = MC_DRV_ERR_DAEMON_UNREACHABLE;
+            }
+        }
+
+        if (mcResult != MC_DRV_OK) {
+            // Unregister mapped bulk buffers from Kernel Module and remove
+            // them from session maintenance
+            while (registered-- > 0) {
+                if (session->removeBulkBuf(bufs[registered].buf) != MC_DRV_OK) {
+                    LOG_E("Unregistering of bulk memory from Kernel Module failed");
+                }
+            }
+            break;
+        }
+
+        for (uint32_t i = 0; i < count; i++) {
+            // Set mapping info for internal structures
+            bulkBufs[i]->sVirtualAddr = (void *)(uintptr_t)rspPayload.secureVirtualAdr[i];
+            // Set mapping info for Trustlet
+            bufs[i].mapInfo->sVirtualAddr = bulkBufs[i]->sVirtualAddr;
+            bufs[i].mapInfo->sVirtualLen = bufs[i].len;
+        }
+
+    } while (false);
+
+    pthread_rwlock_unlock(&devicesLock);
+
+    return mcResult;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * Unmap up to MC_DRV_BULK_BUF_LIST_MAX buffers with one daemon command.
+ */
+static mcResult_t unmapBulkBufList(
+    mcSessionHandle_t  *sessionHandle,
+    mcBulkBuf_t        *bufs,
+    uint32_t           count
+)
+{
+    mcResult_t mcResult = MC_DRV_OK;
+
+    pthread_rwlock_rdlock(&devicesLock);
+
+    do {
+        // Determine device the session belongs to
+        Device *device = resolveDeviceId(sessionHandle->deviceId);
+        // Is the device known
+        CHECK_DEVICE(device);
+
+        // Is the device opened.
+        CHECK_DEVICE_CLOSED(device, sessionHandle->deviceId)
+
+        Connection *devCon = device->connection;
+
+        // Get session
+        Session *session = device->resolveSessionId(sessionHandle->sessionId);
+        CHECK_SESSION(session, sessionHandle->sessionId);
+
+        MC_DRV_CMD_UNMAP_BULK_BUF_LIST_struct cmd;
+        memset(&cmd, 0, sizeof(cmd));
+        cmd.commandId = MC_DRV_CMD_UNMAP_BULK_BUF_LIST;
+        cmd.sessionId = session->sessionId;
+        cmd.count = count;
+
+        uint32_t i;
+        for (i = 0; i < count; i++) {
+            mcBulkMap_t *mapInfo = bufs[i].mapInfo;
+            CHECK_NOT_NULL(bufs[i].buf);
+            CHECK_NOT_NULL(mapInfo);
+            CHECK_NOT_NULL(mapInfo->sVirtualAddr);
+
+            uint32_t handle = session->getBufHandle(mapInfo->sVirtualAddr, mapInfo->sVirtualLen);
+            if (handle == 0) {
+                LOG_E("Unable to find internal handle for buffer %p.", mapInfo->sVirtualAddr);
+                mcResult = MC_DRV_ERR_BLK_BUFF_NOT_FOUND;
+                break;
+            }
+
+            LOG_I(" Unmapping %p(handle=%u) from session %d.", bufs[i].buf, handle, sessionHandle->sessionId);
+
+            cmd.entries[i].handle = handle;
+            cmd.entries[i].secureVirtualAdr = (uintptr_t)(mapInfo->sVirtualAddr);
+            cmd.entries[i].lenBulkMem = mapInfo->sVirtualLen;
+        }
+        if (i < count) {
+            break;
+        }
+
+        device->lockConnection();
+        do {
+            int ret = writeCommand(device, devCon, &cmd, sizeof(cmd));
+            if (ret < 0) {
+                LOG_E("sending to Daemon failed.");
+                mcResult = MC_DRV_ERR_SOCKET_WRITE;
+                break;
+            }
+
+            RECV_FROM_DAEMON(devCon, &mcResult);
+        } while (false);
+        device->unlockConnection();
+
+        if (mcResult == MC_DRV_ERR_SOCKET_WRITE || mcResult == MC_DRV_ERR_SOCKET_READ) {
+            break;
+        }
+
+        if (mcResult != MC_DRV_OK) {
+            LOG_E("Daemon reported failing of UNMAP BULK BUF LIST command, responseId %d.", mcResult);
+            // TODO-2012-09-06-haenellu: Remove once tests can handle it.
+            mcResult = MC_DRV_ERR_DAEMON_UNREACHABLE;
+            break;
+        }
+
+        // Unregister mapped bulk buffers from Kernel Module and remove mapped
+        // bulk buffers from session maintenance
+        for (i = 0; i < count; i++) {
+            if (session->removeBulkBuf(bufs[i].buf) != MC_DRV_OK) {
+                LOG_E("Unregistering of bulk memory from Kernel Module failed.");
+                mcResult = MC_DRV_ERR_BULK_UNMAPPING;
+            }
+        }
+
+    } while (false);
+
+    pthread_rwlock_unlock(&devicesLock);
+
+    if (mcResult == MC_DRV_ERR_SOCKET_WRITE || mcResult == MC_DRV_ERR_SOCKET_READ) {
+        LOG_E("Connection is dead, removing device.");
+        removeDeadDevice(sessionHandle->deviceId);
+    }
+
+    return mcResult;
+}
+
+
+//------------------------------------------------------------------------------
+__MC_CLIENT_LIB_API mcResult_t mcMapList(
+    mcSessionHandle_t  *sessionHandle,
+    mcBulkBuf_t        *bufs,
+    uint32_t           count
+)
+{
+    mcResult_t mcResult = MC_DRV_OK;
+#ifndef WIN32
+
+    LOG_I("===%s()===", __FUNCTION__);
+
+    do {
+        CHECK_NOT_NULL(sessionHandle);
+        CHECK_NOT_NULL(bufs);
+
+        bool useLists = hasBulkBufLists(sessionHandle->deviceId);
+        uint32_t done = 0;
+        while (done < count) {
+            uint32_t chunk = 1;
+            if (useLists) {
+                chunk = count - done;
+                if (chunk > MC_DRV_BULK_BUF_LIST_MAX) {
+                    chunk = MC_DRV_BULK_BUF_LIST_MAX;
+                }
+                mcResult = mapBulkBufList(sessionHandle, &bufs[done], chunk);
+            } else {
+                // Daemon predates the list commands
+                mcResult = mcMap(sessionHandle, bufs[done].buf, bufs[done].len, bufs[done].mapInfo);
+            }
+            if (mcResult != MC_DRV_OK) {
+                break;
+            }
+            done += chunk;
+        }
+
+        // All or nothing
+        if (mcResult != MC_DRV_OK && done > 0) {
+            mcUnmapList(sessionHandle, bufs, done);
+        }
+    } while (false);
+
+#endif /* WIN32 */
+    return mcResult;
+}
+
+
+//------------------------------------------------------------------------------
+__MC_CLIENT_LIB_API mcResult_t mcUnmapList(
+    mcSessionHandle_t  *sessionHandle,
+    mcBulkBuf_t        *bufs,
+    uint32_t           count
+)
+{
+    mcResult_t mcResult = MC_DRV_OK;
+#ifndef WIN32
+
+    LOG_I("===%s()===", __FUNCTION__);
+
+    do {
+        CHECK_NOT_NULL(sessionHandle);
+        CHECK_NOT_NULL(bufs);
+
+        bool useLists = hasBulkBufLists(sessionHandle->deviceId);
+        uint32_t done = 0;
+        while (done < count) {
+            uint32_t chunk = 1;
+            mcResult_t ret;
+            if (useLists) {
+                chunk = count - done;
+                if (chunk > MC_DRV_BULK_BUF_LIST_MAX) {
+                    chunk = MC_DRV_BULK_BUF_LIST_MAX;
+                }
+                ret = unmapBulkBufList(sessionHandle, &bufs[done], chunk);
+            } else {
+                // Daemon predates the list commands
+                ret = mcUnmap(sessionHandle, bufs[done].buf, bufs[done].mapInfo);
+            }
+            // Keep unmapping, report the first failure
+            if (ret != MC_DRV_OK && mcResult == MC_DRV_OK) {
+                mcResult = ret;
+            }
+            done += chunk;
+        }
+    } while (false);
 
 #endif /* WIN32 */
     return mcResult;
@@ -1356,7 +2073,7 @@ __MC_CLIENT_LIB_API mcResult_t mcGetSessionErrorCode(
     mcResult_t mcResult = MC_DRV_OK;
 #ifndef WIN32
 
-    devMutex.lock();
+    pthread_rwlock_rdlock(&devicesLock);
     LOG_I("===%s()===", __FUNCTION__);
 
     do {
@@ -1380,7 +2097,7 @@ __MC_CLIENT_LIB_API mcResult_t mcGetSessionErrorCode(
 
     } while (false);
 
-    devMutex.unlock();
+    pthread_rwlock_unlock(&devicesLock);
 
 #endif /* WIN32 */
 	return mcResult;
@@ -1410,7 +2127,7 @@ __MC_CLIENT_LIB_API mcResult_t mcGetMobiCoreVersion(
     mcResult_t mcResult = MC_DRV_OK;
 #ifndef WIN32
 
-    devMutex.lock();
+    pthread_rwlock_rdlock(&devicesLock);
     LOG_I("===%s()===", __FUNCTION__);
 
     do {
@@ -1426,28 +2143,36 @@ __MC_CLIENT_LIB_API mcResult_t mcGetMobiCoreVersion(
 
         Connection *devCon = device->connection;
 
-        SEND_TO_DAEMON(devCon, MC_DRV_CMD_GET_MOBICORE_VERSION);
+        mcVersionInfo_t versionInfo_socket;
+        device->lockConnection();
+        do {
+            SEND_TO_DAEMON(device, devCon, MC_DRV_CMD_GET_MOBICORE_VERSION);
 
-        // Read GET MOBICORE VERSION response.
+            // Read GET MOBICORE VERSION response.
 
-        RECV_FROM_DAEMON(devCon, &mcResult);
+            RECV_FROM_DAEMON(devCon, &mcResult);
+
+            if (mcResult != MC_DRV_OK) {
+                LOG_E("MC_DRV_CMD_GET_MOBICORE_VERSION bad response, respId=%d", mcResult);
+                // TODO-2012-09-06-haenellu: Remove once tests can handle it.
+                mcResult = MC_DRV_ERR_DAEMON_UNREACHABLE;
+                break;
+            }
+
+            // Read payload.
+            RECV_FROM_DAEMON(devCon, &versionInfo_socket);
+        } while (false);
+        device->unlockConnection();
 
         if (mcResult != MC_DRV_OK) {
-            LOG_E("MC_DRV_CMD_GET_MOBICORE_VERSION bad response, respId=%d", mcResult);
-            // TODO-2012-09-06-haenellu: Remove once tests can handle it.
-            mcResult = MC_DRV_ERR_DAEMON_UNREACHABLE;
             break;
         }
 
-        // Read payload.
-        mcVersionInfo_t versionInfo_socket;
-        RECV_FROM_DAEMON(devCon, &versionInfo_socket);
-
         *versionInfo = versionInfo_socket;
 
     } while (0);
 
-    devMutex.unlock();
+    pthread_rwlock_unlock(&devicesLock);
 
 #endif /* WIN32 */
     return mcResult;
@@ -1456,7 +2181,7 @@ __MC_CLIENT_LIB_API mcResult_t mcGetMobiCoreVersion(
 #ifndef WIN32
 //------------------------------------------------------------------------------
 // Only called by mcOpenDevice()
-// Must be taken with devMutex locked.
+// Must be taken with devicesLock held for writing.
 uint32_t getDaemonVersion(Connection *devCon, uint32_t *version)
 {
     assert(devCon != NULL);
@@ -1467,7 +2192,7 @@ uint32_t getDaemonVersion(Connection *devCon, uint32_t *version)
     LOG_I("===%s()===", __FUNCTION__);
 
     do {
-        SEND_TO_DAEMON(devCon, MC_DRV_CMD_GET_VERSION);
+        SEND_TO_DAEMON(NULL, devCon, MC_DRV_CMD_GET_VERSION);
 
         RECV_FROM_DAEMON(devCon, &mcResult);
 
@@ -41,9 +41,12 @@
 
 #include "mc_linux.h"
 #include "Device.h"
+#include "mcVersionHelper.h"
 
 #include "log.h"
 #include <assert.h>
+#include <errno.h>
+#include <string.h>
 
 
 //------------------------------------------------------------------------------
@@ -51,8 +54,9 @@ Device::Device(uint32_t deviceId, Connection *connection)
 {
     this->deviceId = deviceId;
     this->connection = connection;
+    this->daemonVersion = 0;
 
-    pMcKMod = new CMcKMod();
+    pMcKMod = getMcKModInstance();
 }
 
 
@@ -69,15 +73,28 @@ Device::~Device(void)
     }
 
     // Free all allocated WSM descriptors
-    wsmIterator_t  wsmIterator = wsmL2List.begin();
-    while (wsmIterator != wsmL2List.end()) {
-        CWsm_ptr pWsm = *wsmIterator;
+    wsmMapIterator_t  wsmIterator = wsmMap.begin();
+    while (wsmIterator != wsmMap.end()) {
+        CWsm_ptr pWsm = wsmIterator->second;
+
+        // ignore return code, carved allocations go with their chunk
+        if (findWsmChunk(pWsm->virtAddr) == wsmChunks.end()) {
+            pMcKMod->free(pWsm->handle, pWsm->virtAddr, pWsm->len);
+        }
+
+        delete pWsm;
+        wsmMap.erase(wsmIterator++);
+    }
+
+    wsmChunkIterator_t  chunkIterator = wsmChunks.begin();
+    while (chunkIterator != wsmChunks.end()) {
+        CWsm_ptr pWsm = chunkIterator->second.wsm;
 
         // ignore return code
         pMcKMod->free(pWsm->handle, pWsm->virtAddr, pWsm->len);
 
-        delete (*wsmIterator);
-        wsmIterator = wsmL2List.erase(wsmIterator);
+        delete pWsm;
+        wsmChunks.erase(chunkIterator++);
     }
     delete connection;
     delete pMcKMod;
@@ -98,10 +115,27 @@ void Device::close(void)
 }
 
 
+//------------------------------------------------------------------------------
+void Device::lockConnection(void)
+{
+    connectionMutex.lock();
+}
+
+
+//------------------------------------------------------------------------------
+void Device::unlockConnection(void)
+{
+    connectionMutex.unlock();
+}
+
+
 //------------------------------------------------------------------------------
 bool Device::hasSessions(void)
 {
-    return sessionList.size() > 0;
+    listMutex.lock();
+    bool ret = sessionList.size() > 0;
+    listMutex.unlock();
+    return ret;
 }
 
 
@@ -109,7 +143,9 @@ bool Device::hasSessions(void)
 Session *Device::createNewSession(uint32_t sessionId, Connection  *connection)
 {
     Session *session = new Session(sessionId, pMcKMod, connection);
+    listMutex.lock();
     sessionList.push_back(session);
+    listMutex.unlock();
     return session;
 }
 
@@ -117,20 +153,24 @@ Session *Device::createNewSession(uint32_t sessionId, Connection  *connection)
 //------------------------------------------------------------------------------
 bool Device::removeSession(uint32_t sessionId)
 {
-    bool ret = false;
+    Session *session = NULL;
 
+    listMutex.lock();
     sessionIterator_t interator = sessionList.begin();
     while (interator != sessionList.end()) {
         if ((*interator)->sessionId == sessionId) {
-            delete (*interator);
+            session = (*interator);
             interator = sessionList.erase(interator);
-            ret = true;
             break;
         } else {
             interator++;
         }
     }
-    return ret;
+    listMutex.unlock();
+
+    // Unregistering the buffers of the session is done without the list lock
+    delete session;
+    return session != NULL;
 }
 
 
@@ -139,6 +179,7 @@ Session *Device::resolveSessionId(uint32_t sessionId)
 {
     Session  *ret = NULL;
 
+    listMutex.lock();
     // Get Session for sessionId
     for ( sessionIterator_t interator = sessionList.begin();
             interator != sessionList.end();
@@ -148,10 +189,56 @@ Session *Device::resolveSessionId(uint32_t sessionId)
             break;
         }
     }
+    listMutex.unlock();
     return ret;
 }
 
 
+//------------------------------------------------------------------------------
+CWsm_ptr Device::carveContiguousWsm(uint32_t len)
+{
+    uint32_t pages = (len + WSM_PAGE_SIZE - 1) / WSM_PAGE_SIZE;
+    uint32_t mask = (1U << pages) - 1;
+
+    // First fit, allocations are a few pages and chunks are small
+    for (wsmChunkIterator_t iterator = wsmChunks.begin();
+            iterator != wsmChunks.end();
+            ++iterator) {
+        wsmChunk_t *chunk = &iterator->second;
+        for (uint32_t page = 0; page + pages <= WSM_CHUNK_PAGES; page++) {
+            if ((chunk->usedPages & (mask << page)) == 0) {
+                uint32_t offset = page * WSM_PAGE_SIZE;
+                chunk->usedPages |= (mask << page);
+
+                CWsm_ptr pWsm = new CWsm((uint8_t *)chunk->wsm->virtAddr + offset, len,
+                                         chunk->wsm->handle, chunk->wsm->physAddr + offset, offset);
+                wsmMap[pWsm->virtAddr] = pWsm;
+                return pWsm;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+
+//------------------------------------------------------------------------------
+wsmChunkIterator_t Device::findWsmChunk(addr_t virtAddr)
+{
+    // The chunk starting at or below virtAddr, if virtAddr lies inside it
+    wsmChunkIterator_t iterator = wsmChunks.upper_bound(virtAddr);
+    if (iterator == wsmChunks.begin()) {
+        return wsmChunks.end();
+    }
+    --iterator;
+
+    if ((uint8_t *)virtAddr >= (uint8_t *)iterator->first + iterator->second.wsm->len) {
+        return wsmChunks.end();
+    }
+    return iterator;
+}
+
+
 //------------------------------------------------------------------------------
 mcResult_t Device::allocateContiguousWsm(uint32_t len, CWsm **wsm)
 {
@@ -167,6 +254,36 @@ mcResult_t Device::allocateContiguousWsm(uint32_t len, CWsm **wsm)
         return MC_DRV_ERR_INVALID_LENGTH;
     }
 
+    // Older daemons ignore the TCI offset into contiguous WSM
+    bool carve = (len <= WSM_SUBALLOC_MAX_PAGES * WSM_PAGE_SIZE) &&
+                 (MC_GET_MAJOR_VERSION(daemonVersion) > 0 || MC_GET_MINOR_VERSION(daemonVersion) >= 4);
+
+    if (carve) {
+        listMutex.lock();
+        *wsm = carveContiguousWsm(len);
+        listMutex.unlock();
+
+        while (*wsm == NULL) {
+            // All chunks are full, map another one
+            ret = pMcKMod->mapWsm(WSM_CHUNK_PAGES * WSM_PAGE_SIZE, &handle, &virtAddr, &physAddr);
+            if (ret) {
+                return ret;
+            }
+
+            LOG_I(" mapped chunk handle %d to %p, phys=%#llx  ", handle, virtAddr, physAddr);
+
+            listMutex.lock();
+            wsmChunk_t chunk = {new CWsm(virtAddr, WSM_CHUNK_PAGES * WSM_PAGE_SIZE, handle, physAddr), 0};
+            wsmChunks[virtAddr] = chunk;
+            *wsm = carveContiguousWsm(len);
+            listMutex.unlock();
+        }
+
+        // Pages are reused, callers expect zeroed memory as from the kernel module
+        memset((*wsm)->virtAddr, 0, (*wsm)->len);
+        return MC_DRV_OK;
+    }
+
     ret = pMcKMod->mapWsm(len, &handle, &virtAddr, &physAddr);
     if (ret) {
         return ret;
@@ -177,7 +294,9 @@ mcResult_t Device::allocateContiguousWsm(uint32_t len, CWsm **wsm)
     // Register (vaddr,paddr) with device
     *wsm = new CWsm(virtAddr, len, handle, physAddr);
 
-    wsmL2List.push_back(*wsm);
+    listMutex.lock();
+    wsmMap[virtAddr] = *wsm;
+    listMutex.unlock();
 
     // Return pointer to the allocated memory
     return MC_DRV_OK;
@@ -188,17 +307,64 @@ mcResult_t Device::allocateContiguousWsm(uint32_t len, CWsm **wsm)
 mcResult_t Device::freeContiguousWsm(CWsm_ptr  pWsm)
 {
     mcResult_t ret = MC_DRV_ERR_WSM_NOT_FOUND;
-    wsmIterator_t iterator;
+    wsmMapIterator_t iterator;
 
-    for (iterator = wsmL2List.begin(); iterator != wsmL2List.end(); ++iterator) {
-        if (pWsm == *iterator) {
-            ret = MC_DRV_OK;
-            break;
-        }
+    listMutex.lock();
+    iterator = wsmMap.find(pWsm->virtAddr);
+    if ((iterator != wsmMap.end()) && (iterator->second == pWsm)) {
+        ret = MC_DRV_OK;
     }
     // We just looked this up using findContiguousWsm
     assert(ret == MC_DRV_OK);
 
+    wsmChunkIterator_t chunkIterator = findWsmChunk(pWsm->virtAddr);
+    if (chunkIterator != wsmChunks.end()) {
+        // The kernel module cannot refuse this for a busy TCI, so check the sessions here
+        for (sessionIterator_t sessionIterator = sessionList.begin();
+                sessionIterator != sessionList.end();
+                ++sessionIterator) {
+            if ((*sessionIterator)->tciWsm == pWsm) {
+                LOG_E(" WSM %p is still the TCI of session %d", pWsm->virtAddr, (*sessionIterator)->sessionId);
+                listMutex.unlock();
+                return MAKE_MC_DRV_KMOD_WITH_ERRNO(EBUSY);
+            }
+        }
+
+        wsmChunk_t *chunk = &chunkIterator->second;
+        uint32_t pages = (pWsm->len + WSM_PAGE_SIZE - 1) / WSM_PAGE_SIZE;
+        chunk->usedPages &= ~(((1U << pages) - 1) << (pWsm->offset / WSM_PAGE_SIZE));
+        wsmMap.erase(iterator);
+        delete pWsm;
+
+        // Keep a few empty chunks, so allocating per operation does not reach the kernel
+        CWsm_ptr pChunkWsm = NULL;
+        if (chunk->usedPages == 0) {
+            uint32_t idleChunks = 0;
+            for (wsmChunkIterator_t it = wsmChunks.begin(); it != wsmChunks.end(); ++it) {
+                if (it->second.usedPages == 0) {
+                    idleChunks++;
+                }
+            }
+            if (idleChunks > WSM_IDLE_CHUNKS_MAX) {
+                pChunkWsm = chunk->wsm;
+                wsmChunks.erase(chunkIterator);
+            }
+        }
+        listMutex.unlock();
+
+        if (pChunkWsm != NULL) {
+            LOG_I(" unmapping chunk handle %d from %p, phys=%#llx",
+                  pChunkWsm->handle, pChunkWsm->virtAddr, pChunkWsm->physAddr);
+            if (pMcKMod->free(pChunkWsm->handle, pChunkWsm->virtAddr, pChunkWsm->len) != MC_DRV_OK) {
+                // Still referenced by the daemon, nothing else can be done with it
+                LOG_E(" freeing chunk handle %d failed", pChunkWsm->handle);
+            }
+            delete pChunkWsm;
+        }
+        return MC_DRV_OK;
+    }
+    listMutex.unlock();
+
     LOG_I(" unmapping handle %d from %p, phys=%#llx",
           pWsm->handle, pWsm->virtAddr, pWsm->physAddr);
 
@@ -208,7 +374,9 @@ mcResult_t Device::freeContiguousWsm(CWsm_ptr  pWsm)
         return ret;
     }
 
-    iterator = wsmL2List.erase(iterator);
+    listMutex.lock();
+    wsmMap.erase(pWsm->virtAddr);
+    listMutex.unlock();
     delete pWsm;
 
     return ret;
@@ -224,15 +392,12 @@ CWsm_ptr Device::findContiguousWsm(addr_t  virtAddr)
         return pWsm;
     }
 
-    for ( wsmIterator_t iterator = wsmL2List.begin();
-            iterator != wsmL2List.end();
-            ++iterator) {
-        CWsm_ptr pTmpWsm = *iterator;
-        if (virtAddr == pTmpWsm->virtAddr) {
-            pWsm = pTmpWsm;
-            break;
-        }
+    listMutex.lock();
+    wsmMapIterator_t iterator = wsmMap.find(virtAddr);
+    if (iterator != wsmMap.end()) {
+        pWsm = iterator->second;
     }
+    listMutex.unlock();
 
     return pWsm;
 }
@@ -41,10 +41,29 @@
 
 #include <stdint.h>
 #include <vector>
+#include <map>
 
 #include "public/MobiCoreDriverApi.h"
 #include "Session.h"
 #include "CWsm.h"
+#include "CMutex.h"
+
+
+#define WSM_PAGE_SIZE           0x1000
+#define WSM_CHUNK_PAGES         16  /**< Pages of a chunk small contiguous WSM allocations are carved from */
+#define WSM_SUBALLOC_MAX_PAGES  4   /**< Larger contiguous WSM allocations get their own kernel mapping */
+#define WSM_IDLE_CHUNKS_MAX     1   /**< Empty chunks kept mapped for the next allocations */
+
+/** Kernel mapped contiguous WSM that small allocations are carved from, one page at least. */
+typedef struct {
+    CWsm_ptr    wsm;        /**< Kernel mapping of the chunk */
+    uint32_t    usedPages;  /**< Bitmap of the pages in use */
+} wsmChunk_t;
+
+typedef std::map<addr_t, CWsm_ptr>      wsmMap_t;
+typedef wsmMap_t::iterator              wsmMapIterator_t;
+typedef std::map<addr_t, wsmChunk_t>    wsmChunkMap_t;
+typedef wsmChunkMap_t::iterator         wsmChunkIterator_t;
 
 
 class Device
@@ -52,13 +71,37 @@ class Device
 
 private:
     sessionList_t   sessionList; /**< MobiCore Trustlet session associated with the device */
-    wsmList_t       wsmL2List; /**< WSM L2 Table  */
+    wsmMap_t        wsmMap; /**< Contiguous WSM allocations by virtual address */
+    wsmChunkMap_t   wsmChunks; /**< Chunks of small contiguous WSM allocations by virtual address */
+    CMutex          listMutex; /**< Guards sessionList, wsmMap and wsmChunks */
+    CMutex          connectionMutex; /**< Serializes command/response exchanges on connection */
+
+    /**
+     * Carve a contiguous WSM allocation out of an existing chunk.
+     * Must be called with listMutex held.
+     * @param len Length of the allocation.
+     * @return the WSM object or NULL if no chunk has enough free pages.
+     */
+    CWsm_ptr carveContiguousWsm(
+        uint32_t len
+    );
+
+    /**
+     * Find the chunk a contiguous WSM allocation has been carved from.
+     * Must be called with listMutex held.
+     * @param virtAddr Virtual address of the allocation.
+     * @return iterator of the chunk or wsmChunks.end() if it has its own kernel mapping.
+     */
+    wsmChunkIterator_t findWsmChunk(
+        addr_t virtAddr
+    );
 
 
 public:
     uint32_t     deviceId; /**< Device identifier */
     Connection   *connection; /**< The device connection */
     CMcKMod_ptr  pMcKMod;
+    uint32_t     daemonVersion; /**< Socket interface version of the daemon */
 
     Device(
         uint32_t    deviceId,
@@ -85,6 +128,22 @@ public:
         void
     );
 
+    /**
+     * Acquire exclusive use of the device connection for one command
+     * and its response. Other sessions of the device only wait for
+     * this, not for the whole API call.
+     */
+    void lockConnection(
+        void
+    );
+
+    /**
+     * Release the device connection taken by lockConnection().
+     */
+    void unlockConnection(
+        void
+    );
+
     /**
      * Check if the device has open sessions.
      * @return true if the device has one or more open sessions.
@@ -126,6 +185,8 @@ public:
 
     /**
      * Allocate a block of contiguous WSM.
+     * Small blocks are carved out of larger kernel mapped chunks if the daemon
+     * accepts TCI offsets into contiguous WSM, the others are mapped directly.
      * @param len The virtual address to be registered.
      * @param wsm The CWsm object of the allocated memory.
      * @return MC_DRV_OK if successful.
@@ -38,6 +38,10 @@
 #include "GpTci.h"
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <map>
 
 //------------------------------------------------------------------------------
 // Macros
@@ -49,6 +53,79 @@
 //Parameter number
 #define _TEEC_PARAMETER_NUMBER      4
 
+//Alignment of temporary memory references staged in an arena slot
+#define _TEEC_ARENA_ALIGNMENT       8
+
+//------------------------------------------------------------------------------
+// Shared-memory arena of a context, one slot per session
+struct _TEEC_Arena {
+    uint8_t             *base;
+    uint32_t            slotsInUse; //bitmap of the slots owned by sessions
+    pthread_mutex_t     mutex;      //mutex protecting slotsInUse
+    TEEC_ArenaStats_IMP stats;
+};
+
+// Temporary memory references of one operation staged in the session slot
+typedef struct {
+    uint32_t    params;                             //bit i set if parameter i is staged
+    uint32_t    used;                               //bytes of the slot used by the operation
+    uint32_t    offset[_TEEC_PARAMETER_NUMBER];     //offset of parameter i in the slot
+} _TEEC_ArenaStaging;
+
+// Library side state of a context, the public TEEC_Context_IMP only holds the device
+typedef struct {
+    struct _TEEC_Arena  *arena;     //shared-memory arena for temporary memory references
+    struct _TEEC_Async  *async;     //completion of asynchronous operations
+} _TEEC_ContextState;
+
+// Library side state of a session
+typedef struct {
+    struct _TEEC_Arena  *arena;     //arena of the context the session belongs to
+    uint8_t             *arenaSlot; //arena slot of the session, NULL if none
+    mcBulkMap_t         arenaMap;   //mapping of the arena slot in the Trusted Application
+    struct _TEEC_Async  *async;     //completion of asynchronous operations of the context
+    bool                pending;    //an asynchronous operation owns the tci
+    pthread_cond_t      cond_pending; //signalled when the asynchronous operation completed
+} _TEEC_SessionState;
+
+// Result of an asynchronous operation, until TEEC_GetOperationResult reports it
+typedef struct {
+    struct _TEEC_Async  *async;     //completion of the context the operation runs in
+    bool                completed;  //asynchronous operation completed, result is valid
+    TEEC_Result         result;
+    uint32_t            returnOrigin;
+} _TEEC_OperationState;
+
+// Asynchronous operation waiting for its Trusted Application
+typedef struct _TEEC_AsyncOperation {
+    mcSessionHandle_t           handle;
+    TEEC_Session                *session;
+    _TEEC_SessionState          *state;
+    TEEC_Operation              *operation;
+    TEEC_Callback               callback;
+    void                        *userData;
+    _TEEC_ArenaStaging          staging;
+    struct _TEEC_AsyncOperation *next;
+} _TEEC_AsyncOperation;
+
+// Completion of the asynchronous operations of a context
+struct _TEEC_Async {
+    int32_t                 setFd;          //notification set of the sessions with a pending operation
+    int                     wakeFd;         //eventfd to stop the completion thread
+    int                     completionFd;   //eventfd signalled for every completed operation
+    pthread_t               thread;
+    bool                    threadStarted;
+    bool                    detached;       //finalized from the completion thread, which frees the rest
+    pthread_mutex_t         mutex;          //mutex protecting pending, threadStarted and detached
+    _TEEC_AsyncOperation    *pending;
+};
+
+// State of open contexts and sessions, keyed by the structures of the client
+static pthread_rwlock_t stateLock = PTHREAD_RWLOCK_INITIALIZER;
+static std::map<const TEEC_Context *, _TEEC_ContextState *> contextStates;
+static std::map<const TEEC_Session_IMP *, _TEEC_SessionState *> sessionStates;
+static std::map<const TEEC_Operation *, _TEEC_OperationState> operationStates;
+
 
 //------------------------------------------------------------------------------
 //Local satic functions
@@ -57,23 +134,38 @@ static void _libUuidToArray(
     uint8_t         *uuid_str);
 
 
+static void _TEEC_CreateAsync(
+    _TEEC_ContextState  *context);
+
+
+static void _TEEC_DestroyAsync(
+    _TEEC_ContextState  *context);
+
+
+static void _TEEC_FreeAsync(
+    struct _TEEC_Async  *async);
+
+
 static TEEC_Result _TEEC_UnwindOperation(
-    _TEEC_TCI           *tci,
-    mcSessionHandle_t   *handle,
+    TEEC_Session_IMP    *session,
+    _TEEC_SessionState  *state,
     TEEC_Operation      *operation,
+    _TEEC_ArenaStaging  *staging,
     bool                copyValues,
     uint32_t            *returnOrigin);
 
 static TEEC_Result _TEEC_SetupOperation(
-    _TEEC_TCI           *tci,
-    mcSessionHandle_t   *handle,
+    TEEC_Session_IMP    *session,
+    _TEEC_SessionState  *state,
     TEEC_Operation      *operation,
+    _TEEC_ArenaStaging  *staging,
     uint32_t            *returnOrigin);
 
 static TEEC_Result _TEEC_CallTA(
-    TEEC_Session    *session,
-    TEEC_Operation  *operation,
-    uint32_t        *returnOrigin);
+    TEEC_Session        *session,
+    _TEEC_SessionState  *state,
+    TEEC_Operation      *operation,
+    uint32_t            *returnOrigin);
 
 //------------------------------------------------------------------------------
 static void _libUuidToArray(
@@ -101,18 +193,160 @@ static void _libUuidToArray(
     }
 }
 
+//------------------------------------------------------------------------------
+static _TEEC_ContextState *_TEEC_FindContextState(const TEEC_Context *context)
+{
+    _TEEC_ContextState  *state = NULL;
+
+    pthread_rwlock_rdlock(&stateLock);
+    std::map<const TEEC_Context *, _TEEC_ContextState *>::iterator it = contextStates.find(context);
+    if (it != contextStates.end()) state = it->second;
+    pthread_rwlock_unlock(&stateLock);
+    return state;
+}
+
+//------------------------------------------------------------------------------
+static _TEEC_SessionState *_TEEC_FindSessionState(const TEEC_Session_IMP *session)
+{
+    _TEEC_SessionState  *state = NULL;
+
+    pthread_rwlock_rdlock(&stateLock);
+    std::map<const TEEC_Session_IMP *, _TEEC_SessionState *>::iterator it = sessionStates.find(session);
+    if (it != sessionStates.end()) state = it->second;
+    pthread_rwlock_unlock(&stateLock);
+    return state;
+}
+
+//------------------------------------------------------------------------------
+static _TEEC_SessionState *_TEEC_RemoveSessionState(const TEEC_Session_IMP *session)
+{
+    _TEEC_SessionState  *state = NULL;
+
+    pthread_rwlock_wrlock(&stateLock);
+    std::map<const TEEC_Session_IMP *, _TEEC_SessionState *>::iterator it = sessionStates.find(session);
+    if (it != sessionStates.end()) {
+        state = it->second;
+        sessionStates.erase(it);
+    }
+    pthread_rwlock_unlock(&stateLock);
+    return state;
+}
+
+//------------------------------------------------------------------------------
+static void _TEEC_RemoveOperationState(const TEEC_Operation *operation)
+{
+    pthread_rwlock_wrlock(&stateLock);
+    operationStates.erase(operation);
+    pthread_rwlock_unlock(&stateLock);
+}
+
+//------------------------------------------------------------------------------
+static void _TEEC_ReleaseArenaSlot(_TEEC_SessionState *state)
+{
+    struct _TEEC_Arena *arena = state->arena;
+    uint32_t            slot;
+
+    if (state->arenaSlot == NULL) return;
+
+    // The mapping is gone together with the session, only the slot is left.
+    // Wipe what the session staged before another session can get the slot.
+    memset(state->arenaSlot, 0, TEEC_ARENA_SLOT_SIZE);
+    slot = (state->arenaSlot - arena->base) / TEEC_ARENA_SLOT_SIZE;
+    pthread_mutex_lock(&arena->mutex);
+    arena->slotsInUse &= ~(1U << slot);
+    pthread_mutex_unlock(&arena->mutex);
+    state->arenaSlot = NULL;
+}
+
+//------------------------------------------------------------------------------
+static void _TEEC_AcquireArenaSlot(TEEC_Session_IMP *session, _TEEC_SessionState *state)
+{
+    struct _TEEC_Arena *arena = state->arena;
+    uint32_t            slot;
+    mcResult_t          mcRet;
+
+    state->arenaSlot = NULL;
+    if (arena == NULL) return;
+
+    pthread_mutex_lock(&arena->mutex);
+    for (slot = 0; slot < TEEC_ARENA_SLOT_NUMBER; slot++) {
+        if ((arena->slotsInUse & (1U << slot)) == 0) {
+            arena->slotsInUse |= (1U << slot);
+            state->arenaSlot = arena->base + slot * TEEC_ARENA_SLOT_SIZE;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&arena->mutex);
+
+    if (state->arenaSlot == NULL) {
+        LOG_I(" no free arena slot, temporary memory references will be mapped");
+        __sync_fetch_and_add(&arena->stats.sessionsWithoutSlot, 1);
+        return;
+    }
+
+    // The whole slot is mapped to the Trusted Application, it must not see
+    // anything a previous session left in it
+    memset(state->arenaSlot, 0, TEEC_ARENA_SLOT_SIZE);
+
+    // Map the slot once, operations only copy into it
+    mcRet = mcMap(&session->handle, state->arenaSlot, TEEC_ARENA_SLOT_SIZE, &state->arenaMap);
+    if (mcRet != MC_DRV_OK) {
+        LOG_W("mcMap of arena slot failed (%08x), temporary memory references will be mapped", mcRet);
+        _TEEC_ReleaseArenaSlot(state);
+        __sync_fetch_and_add(&arena->stats.sessionsWithoutSlot, 1);
+        return;
+    }
+    __sync_fetch_and_add(&arena->stats.sessionsWithSlot, 1);
+}
+
+//------------------------------------------------------------------------------
+static bool _TEEC_StageInArena(
+    _TEEC_SessionState  *state,
+    _TEEC_ArenaStaging  *staging,
+    uint32_t            param,
+    const void          *buffer,
+    size_t              size,
+    bool                copyIn,
+    mcBulkMap_t         *mapInfo)
+{
+    if ((state->arenaSlot == NULL) || (size > TEEC_ARENA_MEMREF_MAX_SIZE) ||
+            (staging->used + size > TEEC_ARENA_SLOT_SIZE)) {
+        return false;
+    }
+
+    if (copyIn) {
+        memcpy(state->arenaSlot + staging->used, buffer, size);
+        __sync_fetch_and_add(&state->arena->stats.copiedBytes, size);
+    }
+    mapInfo->sVirtualAddr = (uint8_t *)state->arenaMap.sVirtualAddr + staging->used;
+    mapInfo->sVirtualLen = size;
+
+    staging->params |= (1U << param);
+    staging->offset[param] = staging->used;
+    staging->used += (size + _TEEC_ARENA_ALIGNMENT - 1) & ~(_TEEC_ARENA_ALIGNMENT - 1);
+    __sync_fetch_and_add(&state->arena->stats.copiedMemrefs, 1);
+    return true;
+}
+
 //------------------------------------------------------------------------------
 static TEEC_Result _TEEC_SetupOperation(
-    _TEEC_TCI           *tci,
-    mcSessionHandle_t   *handle,
+    TEEC_Session_IMP    *session,
+    _TEEC_SessionState  *state,
     TEEC_Operation      *operation,
+    _TEEC_ArenaStaging  *staging,
     uint32_t            *returnOrigin)
 {
+    _TEEC_TCI                   *tci = (_TEEC_TCI *)session->tci;
     uint32_t                    i;
     _TEEC_ParameterInternal     *imp;
     TEEC_Parameter              *ext;
     mcResult_t                  mcRet = MC_DRV_OK;
     TEEC_Result                 teecResult = TEEC_SUCCESS;
+    mcBulkBuf_t                 bulkBufs[_TEEC_PARAMETER_NUMBER];
+    uint32_t                    bulkBufCount = 0;
+
+    staging->params = 0;
+    staging->used = 0;
 
     //operation can be NULL
     tci->operation.isCancelled = false;
@@ -152,11 +386,18 @@ static TEEC_Result _TEEC_SetupOperation(
                 LOG_I("  cycle %d, TEEC_TEMP_IN*", i);
                 imp->memref.mapInfo.sVirtualLen = 0;
                 if ((ext->tmpref.size) && (ext->tmpref.buffer)) {
-                    mcRet = mcMap(handle, ext->tmpref.buffer, ext->tmpref.size, &imp->memref.mapInfo);
-                    if (mcRet != MC_DRV_OK) {
-                        LOG_E("mcMap failed, mcRet=0x%08X", mcRet);
-                        *returnOrigin = TEEC_ORIGIN_COMMS;
-                        i = _TEEC_PARAMETER_NUMBER;
+                    // Small ones are copied into the session arena slot, which is already mapped
+                    if (_TEEC_StageInArena(state, staging, i, ext->tmpref.buffer, ext->tmpref.size,
+                                           _TEEC_GET_PARAM_TYPE(operation->paramTypes, i) != TEEC_MEMREF_TEMP_OUTPUT,
+                                           &imp->memref.mapInfo)) {
+                        break;
+                    }
+                    bulkBufs[bulkBufCount].buf = ext->tmpref.buffer;
+                    bulkBufs[bulkBufCount].len = ext->tmpref.size;
+                    bulkBufs[bulkBufCount].mapInfo = &imp->memref.mapInfo;
+                    bulkBufCount++;
+                    if (state->arena != NULL) {
+                        __sync_fetch_and_add(&state->arena->stats.mappedMemrefs, 1);
                     }
                 } else {
                     LOG_I("  cycle %d, TEEC_TEMP_IN*  - zero pointer or size", i);
@@ -167,12 +408,10 @@ static TEEC_Result _TEEC_SetupOperation(
                 LOG_I("  cycle %d, TEEC_MEMREF_WHOLE", i);
                 imp->memref.mapInfo.sVirtualLen = 0;
                 if (ext->memref.parent->size) {
-                    mcRet = mcMap(handle, ext->memref.parent->buffer, ext->memref.parent->size, &imp->memref.mapInfo);
-                    if (mcRet != MC_DRV_OK) {
-                        LOG_E("mcMap failed, mcRet=0x%08X", mcRet);
-                        *returnOrigin = TEEC_ORIGIN_COMMS;
-                        i = _TEEC_PARAMETER_NUMBER;
-                    }
+                    bulkBufs[bulkBufCount].buf = ext->memref.parent->buffer;
+                    bulkBufs[bulkBufCount].len = ext->memref.parent->size;
+                    bulkBufs[bulkBufCount].mapInfo = &imp->memref.mapInfo;
+                    bulkBufCount++;
                 }
                 break;
             }
@@ -201,12 +440,10 @@ static TEEC_Result _TEEC_SetupOperation(
                 }
                 imp->memref.mapInfo.sVirtualLen = 0;
                 if (ext->memref.size) {
-                    mcRet = mcMap(handle, (uint8_t *)ext->memref.parent->buffer + ext->memref.offset, ext->memref.size, &imp->memref.mapInfo);
-                    if (mcRet != MC_DRV_OK) {
-                        LOG_E("mcMap failed, mcRet=0x%08X", mcRet);
-                        *returnOrigin = TEEC_ORIGIN_COMMS;
-                        i = _TEEC_PARAMETER_NUMBER;
-                    }
+                    bulkBufs[bulkBufCount].buf = (uint8_t *)ext->memref.parent->buffer + ext->memref.offset;
+                    bulkBufs[bulkBufCount].len = ext->memref.size;
+                    bulkBufs[bulkBufCount].mapInfo = &imp->memref.mapInfo;
+                    bulkBufCount++;
                 }
                 break;
             }
@@ -219,6 +456,15 @@ static TEEC_Result _TEEC_SetupOperation(
             }
         }
 
+        // Map all memory references with one daemon request
+        if ((teecResult == TEEC_SUCCESS) && (bulkBufCount > 0)) {
+            mcRet = mcMapList(&session->handle, bulkBufs, bulkBufCount);
+            if (mcRet != MC_DRV_OK) {
+                LOG_E("mcMapList failed, mcRet=0x%08X", mcRet);
+                *returnOrigin = TEEC_ORIGIN_COMMS;
+            }
+        }
+
         if (tci->operation.isCancelled) {
             LOG_E("the operation has been cancelled in COMMS");
             *returnOrigin = TEEC_ORIGIN_COMMS;
@@ -227,7 +473,7 @@ static TEEC_Result _TEEC_SetupOperation(
 
         if ((mcRet != MC_DRV_OK) || (teecResult != TEEC_SUCCESS)) {
             uint32_t retOrigIgnored;
-            _TEEC_UnwindOperation(tci, handle, operation, false, &retOrigIgnored);
+            _TEEC_UnwindOperation(session, state, operation, staging, false, &retOrigIgnored);
             //Zeroing out tci->operation
             memset(&tci->operation, 0, sizeof(TEEC_Operation));
             if (teecResult != TEEC_SUCCESS) return teecResult;
@@ -250,18 +496,22 @@ static TEEC_Result _TEEC_SetupOperation(
 
 //------------------------------------------------------------------------------
 static TEEC_Result _TEEC_UnwindOperation(
-    _TEEC_TCI           *tci,
-    mcSessionHandle_t   *handle,
+    TEEC_Session_IMP    *session,
+    _TEEC_SessionState  *state,
     TEEC_Operation      *operation,
+    _TEEC_ArenaStaging  *staging,
     bool                copyValues,
     uint32_t            *returnOrigin)
 {
+    _TEEC_TCI                   *tci = (_TEEC_TCI *)session->tci;
     uint32_t                    i;
     _TEEC_ParameterInternal     *imp;
     TEEC_Parameter              *ext;
     //mcResult_t                  mcRet = MC_DRV_OK;
     //bool                        doUnmap = false;
     uint8_t                     *buffer;
+    mcBulkBuf_t                 bulkBufs[_TEEC_PARAMETER_NUMBER];
+    uint32_t                    bulkBufCount = 0;
 
     //operation can be NULL
     if (operation == NULL) return  TEEC_SUCCESS;
@@ -305,10 +555,19 @@ static TEEC_Result _TEEC_UnwindOperation(
         case TEEC_MEMREF_TEMP_INOUT: {
             LOG_I("  cycle %d, TEEC_TEMP*", i);
             if ((copyValues) && (_TEEC_GET_PARAM_TYPE(operation->paramTypes, i) != TEEC_MEMREF_TEMP_INPUT)) {
+                if (staging->params & (1U << i)) {
+                    // Output larger than the buffer means the TA only reported the required size
+                    size_t copySize = imp->memref.outputSize;
+                    if (copySize > ext->tmpref.size) copySize = 0;
+                    memcpy(ext->tmpref.buffer, state->arenaSlot + staging->offset[i], copySize);
+                    __sync_fetch_and_add(&state->arena->stats.copiedBytes, copySize);
+                }
                 ext->tmpref.size = imp->memref.outputSize;
             }
             //doUnmap = true;
-            buffer = (uint8_t *)ext->tmpref.buffer;
+            if ((staging->params & (1U << i)) == 0) {
+                buffer = (uint8_t *)ext->tmpref.buffer;
+            }
             break;
         }
         case TEEC_MEMREF_WHOLE: {
@@ -335,14 +594,68 @@ static TEEC_Result _TEEC_UnwindOperation(
         }
 
         if ((buffer != NULL) && (imp->memref.mapInfo.sVirtualLen != 0)) {
-            // This function assumes that we cannot handle error of mcUnmap
-            mcUnmap(handle, buffer, &imp->memref.mapInfo);
+            bulkBufs[bulkBufCount].buf = buffer;
+            bulkBufs[bulkBufCount].len = imp->memref.mapInfo.sVirtualLen;
+            bulkBufs[bulkBufCount].mapInfo = &imp->memref.mapInfo;
+            bulkBufCount++;
         }
     }
 
+    if (bulkBufCount > 0) {
+        // This function assumes that we cannot handle error of mcUnmapList
+        mcUnmapList(&session->handle, bulkBufs, bulkBufCount);
+    }
+
     return tci->returnStatus;
 }
 
+//------------------------------------------------------------------------------
+static void _TEEC_CreateArena(_TEEC_ContextState *context)
+{
+    struct _TEEC_Arena *arena;
+    void               *base;
+
+    // Without an arena every temporary memory reference is mapped, so failing here is not fatal
+    base = mmap(0, TEEC_ARENA_SLOT_SIZE * TEEC_ARENA_SLOT_NUMBER, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        LOG_W("mmap failed on arena allocation");
+        return;
+    }
+
+    arena = (struct _TEEC_Arena *)calloc(1, sizeof(struct _TEEC_Arena));
+    if (arena == NULL) {
+        LOG_W("calloc failed on arena allocation");
+        munmap(base, TEEC_ARENA_SLOT_SIZE * TEEC_ARENA_SLOT_NUMBER);
+        return;
+    }
+    arena->base = (uint8_t *)base;
+    pthread_mutex_init(&arena->mutex, NULL);
+    context->arena = arena;
+}
+
+//------------------------------------------------------------------------------
+static void _TEEC_DestroyArena(_TEEC_ContextState *context)
+{
+    struct _TEEC_Arena *arena = context->arena;
+
+    if (arena == NULL) return;
+
+    LOG_I(" arena: %u sessions with slot, %u without, %u memrefs copied (%llu bytes), %u mapped",
+          arena->stats.sessionsWithSlot, arena->stats.sessionsWithoutSlot, arena->stats.copiedMemrefs,
+          (unsigned long long)arena->stats.copiedBytes, arena->stats.mappedMemrefs);
+
+    context->arena = NULL;
+    if (arena->slotsInUse != 0) {
+        // Sessions still write to their slots, better leak the arena than free it under them
+        LOG_E("arena still used by sessions (%08x)", arena->slotsInUse);
+        return;
+    }
+    pthread_mutex_destroy(&arena->mutex);
+    munmap(arena->base, TEEC_ARENA_SLOT_SIZE * TEEC_ARENA_SLOT_NUMBER);
+    free(arena);
+}
+
 //------------------------------------------------------------------------------
 //TEEC_InitializeContext: TEEC_SUCCESS, Another error code from Table 4-2.
 //MC_DRV_OK, MC_DRV_ERR_INVALID_OPERATION, MC_DRV_ERR_DAEMON_UNREACHABLE, MC_DRV_ERR_UNKNOWN_DEVICE, MC_DRV_ERR_INVALID_DEVICE_FILE
@@ -356,8 +669,20 @@ TEEC_Result TEEC_InitializeContext(
     context->imp.reserved = MC_DEVICE_ID_DEFAULT;
 
     switch (mcOpenDevice(MC_DEVICE_ID_DEFAULT)) {
-    case MC_DRV_OK:
+    case MC_DRV_OK: {
+        _TEEC_ContextState *state = (_TEEC_ContextState *)calloc(1, sizeof(_TEEC_ContextState));
+        if (state == NULL) {
+            LOG_E("calloc failed on context state allocation");
+            mcCloseDevice(MC_DEVICE_ID_DEFAULT);
+            return TEEC_ERROR_OUT_OF_MEMORY;
+        }
+        _TEEC_CreateArena(state);
+        _TEEC_CreateAsync(state);
+        pthread_rwlock_wrlock(&stateLock);
+        contextStates[context] = state;
+        pthread_rwlock_unlock(&stateLock);
         return TEEC_SUCCESS;
+    }
     case MC_DRV_ERR_INVALID_OPERATION:
         return TEEC_ERROR_BAD_STATE;
     case MC_DRV_ERR_DAEMON_UNREACHABLE:
@@ -391,6 +716,18 @@ void TEEC_FinalizeContext(TEEC_Context *context)
         return;
     }
 
+    _TEEC_ContextState *state = NULL;
+    pthread_rwlock_wrlock(&stateLock);
+    std::map<const TEEC_Context *, _TEEC_ContextState *>::iterator it = contextStates.find(context);
+    if (it != contextStates.end()) {
+        state = it->second;
+        contextStates.erase(it);
+    }
+    pthread_rwlock_unlock(&stateLock);
+
+    // The completion thread still uses the device
+    if (state != NULL) _TEEC_DestroyAsync(state);
+
     //The implementation of this function MUST NOT be able to fail: after this function returns the Client
     //Application must be able to consider that the Context has been closed.
     mcRet = mcCloseDevice(context->imp.reserved);
@@ -398,40 +735,28 @@ void TEEC_FinalizeContext(TEEC_Context *context)
         LOG_E("mcCloseDevice failed (%08x)", mcRet);
         /* continue even in case of error */;
     }
+
+    if (state != NULL) {
+        _TEEC_DestroyArena(state);
+        free(state);
+    }
 }
 
 //------------------------------------------------------------------------------
-static TEEC_Result _TEEC_CallTA(
-    TEEC_Session    *session,
-    TEEC_Operation  *operation,
-    uint32_t        *returnOrigin)
+static TEEC_Result _TEEC_CompleteCallTA(
+    TEEC_Session        *session,
+    _TEEC_SessionState  *state,
+    TEEC_Operation      *operation,
+    _TEEC_ArenaStaging  *staging,
+    mcResult_t          mcRet,
+    uint32_t            *returnOrigin)
 {
-    mcResult_t      mcRet;
     TEEC_Result     teecRes;
     TEEC_Result     teecError = TEEC_SUCCESS;
 
-    LOG_I(" %s()", __func__);
-
-    // Phase 1: start the operation and wait for the result
-    teecRes = _TEEC_SetupOperation((_TEEC_TCI *)session->imp.tci, &session->imp.handle, operation, returnOrigin);
-    if (teecRes != TEEC_SUCCESS ) {
-        LOG_E("_TEEC_SetupOperation failed (%08x)", teecRes);
-        return teecRes;
-    }
-
-    // Signal the Trusted App
-    mcRet = mcNotify(&session->imp.handle);
-    if (MC_DRV_OK != mcRet) {
-        LOG_E("Notify failed (%08x)", mcRet);
-        teecError = TEEC_ERROR_COMMUNICATION;
-        goto end;
-    }
-
-    // -------------------------------------------------------------
-    // Wait for the Trusted App response
-    mcRet = mcWaitNotification(&session->imp.handle, MC_INFINITE_TIMEOUT);
+    // mcRet is the result of notifying the Trusted App and waiting for its response
     if (mcRet != MC_DRV_OK) {
-        LOG_E("mcWaitNotification failed (%08x)", mcRet);
+        LOG_E("Notify or wait failed (%08x)", mcRet);
         teecError = TEEC_ERROR_COMMUNICATION;
         if (mcRet == MC_DRV_INFO_NOTIFICATION) {
             int32_t lastErr;
@@ -448,10 +773,10 @@ static TEEC_Result _TEEC_CallTA(
             }
         }
     }
+
     // Phase 2: Return values and cleanup
-end:
     // unmap memory and copy values if no error
-    teecRes = _TEEC_UnwindOperation((_TEEC_TCI *)session->imp.tci, &session->imp.handle, operation,
+    teecRes = _TEEC_UnwindOperation(&session->imp, state, operation, staging,
                                     (teecError == TEEC_SUCCESS), returnOrigin);
     if (teecRes != TEEC_SUCCESS ) {
         LOG_E("_TEEC_UnwindOperation (%08x)", teecRes);
@@ -467,6 +792,7 @@ end:
             /* continue even in case of error */;
         }
         session->imp.active = false;
+        _TEEC_ReleaseArenaSlot(state);
         if (teecError == TEEC_ERROR_COMMUNICATION) {
             *returnOrigin = TEEC_ORIGIN_COMMS;
         }
@@ -476,6 +802,313 @@ end:
     return teecError;
 }
 
+//------------------------------------------------------------------------------
+static TEEC_Result _TEEC_CallTA(
+    TEEC_Session        *session,
+    _TEEC_SessionState  *state,
+    TEEC_Operation      *operation,
+    uint32_t            *returnOrigin)
+{
+    mcResult_t          mcRet;
+    TEEC_Result         teecRes;
+    _TEEC_ArenaStaging  staging;
+
+    LOG_I(" %s()", __func__);
+
+    // Phase 1: start the operation and wait for the result
+    teecRes = _TEEC_SetupOperation(&session->imp, state, operation, &staging, returnOrigin);
+    if (teecRes != TEEC_SUCCESS ) {
+        LOG_E("_TEEC_SetupOperation failed (%08x)", teecRes);
+        return teecRes;
+    }
+
+    // Signal the Trusted App
+    mcRet = mcNotify(&session->imp.handle);
+    if (MC_DRV_OK == mcRet) {
+        // -------------------------------------------------------------
+        // Wait for the Trusted App response
+        mcRet = mcWaitNotification(&session->imp.handle, MC_INFINITE_TIMEOUT);
+    }
+
+    return _TEEC_CompleteCallTA(session, state, operation, &staging, mcRet, returnOrigin);
+}
+
+//------------------------------------------------------------------------------
+static _TEEC_AsyncOperation *_TEEC_DequeueAsync(
+    struct _TEEC_Async  *async,
+    mcSessionHandle_t   *handle)
+{
+    _TEEC_AsyncOperation    **prev;
+    _TEEC_AsyncOperation    *asyncOp = NULL;
+
+    pthread_mutex_lock(&async->mutex);
+    for (prev = &async->pending; *prev != NULL; prev = &(*prev)->next) {
+        if (((*prev)->handle.sessionId == handle->sessionId) && ((*prev)->handle.deviceId == handle->deviceId)) {
+            asyncOp = *prev;
+            *prev = asyncOp->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&async->mutex);
+
+    // The session may be closed while completing, so leave the set first
+    if (asyncOp != NULL) {
+        mcRemoveFromNotificationSet(async->setFd, &asyncOp->handle);
+    }
+    return asyncOp;
+}
+
+//------------------------------------------------------------------------------
+static void _TEEC_FinishAsync(
+    struct _TEEC_Async      *async,
+    _TEEC_AsyncOperation    *asyncOp,
+    mcResult_t              mcRet,
+    bool                    cancelled)
+{
+    TEEC_Session            *session = asyncOp->session;
+    _TEEC_SessionState      *state = asyncOp->state;
+    TEEC_Operation          *operation = asyncOp->operation;
+    TEEC_Result             teecRes;
+    uint32_t                returnOrigin;
+
+    pthread_mutex_lock(&session->imp.mutex_tci);
+    teecRes = _TEEC_CompleteCallTA(session, state, operation, &asyncOp->staging, mcRet, &returnOrigin);
+    if (cancelled) {
+        // The session is closed, as after a communication error
+        teecRes = TEEC_ERROR_CANCEL;
+        returnOrigin = TEEC_ORIGIN_COMMS;
+    } else if (teecRes != TEEC_SUCCESS ) {
+        LOG_E("_TEEC_CompleteCallTA failed(%08x)", teecRes);
+    } else {
+        returnOrigin = ((_TEEC_TCI *)session->imp.tci)->returnOrigin;
+        teecRes      = ((_TEEC_TCI *)session->imp.tci)->returnStatus;
+    }
+    state->pending = false;
+    pthread_cond_broadcast(&state->cond_pending);
+    pthread_mutex_unlock(&session->imp.mutex_tci);
+
+    // The callback gets the result, otherwise it is kept for TEEC_GetOperationResult.
+    // The callback may release or reuse the operation, so it comes last.
+    pthread_rwlock_wrlock(&stateLock);
+    if (asyncOp->callback != NULL) {
+        operationStates.erase(operation);
+    } else {
+        _TEEC_OperationState *opState = &operationStates[operation];
+        opState->async = async;
+        opState->completed = true;
+        opState->result = teecRes;
+        opState->returnOrigin = returnOrigin;
+    }
+    pthread_rwlock_unlock(&stateLock);
+    eventfd_write(async->completionFd, 1);
+    if (asyncOp->callback != NULL) {
+        asyncOp->callback(operation, teecRes, returnOrigin, asyncOp->userData);
+    }
+    free(asyncOp);
+}
+
+//------------------------------------------------------------------------------
+static void _TEEC_CompleteAsync(
+    struct _TEEC_Async  *async,
+    mcSessionHandle_t   *handle,
+    mcResult_t          mcRet)
+{
+    _TEEC_AsyncOperation    *asyncOp;
+
+    asyncOp = _TEEC_DequeueAsync(async, handle);
+    if (asyncOp == NULL) {
+        LOG_W("notification for session %u without pending operation", handle->sessionId);
+        return;
+    }
+    _TEEC_FinishAsync(async, asyncOp, mcRet, false);
+}
+
+//------------------------------------------------------------------------------
+// Fails the operations still pending when their context is finalized, so that
+// TEEC_CloseSession and TEEC_InvokeCommand on their sessions do not wait for
+// a completion which never comes.
+static void _TEEC_CancelPendingAsync(struct _TEEC_Async *async)
+{
+    _TEEC_AsyncOperation    *asyncOp;
+
+    for (;;) {
+        pthread_mutex_lock(&async->mutex);
+        asyncOp = async->pending;
+        if (asyncOp != NULL) {
+            async->pending = asyncOp->next;
+        }
+        pthread_mutex_unlock(&async->mutex);
+        if (asyncOp == NULL) break;
+
+        LOG_E("context finalized, cancelling operation of session %u", asyncOp->handle.sessionId);
+        mcRemoveFromNotificationSet(async->setFd, &asyncOp->handle);
+        _TEEC_FinishAsync(async, asyncOp, MC_DRV_ERR_NOTIFICATION, true);
+    }
+}
+
+//------------------------------------------------------------------------------
+static bool _TEEC_AsyncDetached(struct _TEEC_Async *async)
+{
+    bool    detached;
+
+    pthread_mutex_lock(&async->mutex);
+    detached = async->detached;
+    pthread_mutex_unlock(&async->mutex);
+    return detached;
+}
+
+//------------------------------------------------------------------------------
+static void *_TEEC_CompletionThread(void *arg)
+{
+    struct _TEEC_Async  *async = (struct _TEEC_Async *)arg;
+    struct pollfd       fds[2];
+    mcSessionHandle_t   sessions[MC_NOTIFICATION_SET_MAX_EVENTS];
+    mcResult_t          results[MC_NOTIFICATION_SET_MAX_EVENTS];
+    uint32_t            count;
+    uint32_t            i;
+
+    LOG_I(" %s() started", __func__);
+
+    fds[0].fd = async->setFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = async->wakeFd;
+    fds[1].events = POLLIN;
+
+    for (;;) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            LOG_E("poll failed (%d)", errno);
+            break;
+        }
+        if (fds[1].revents != 0) {
+            // The context is being finalized
+            break;
+        }
+
+        count = MC_NOTIFICATION_SET_MAX_EVENTS;
+        if (mcWaitNotificationSet(async->setFd, sessions, results, &count, MC_NO_TIMEOUT) != MC_DRV_OK) {
+            continue;
+        }
+        // A callback may finalize the context, the rest of the batch is cancelled then
+        for (i = 0; (i < count) && !_TEEC_AsyncDetached(async); i++) {
+            _TEEC_CompleteAsync(async, &sessions[i], results[i]);
+        }
+        if (_TEEC_AsyncDetached(async)) break;
+    }
+
+    LOG_I(" %s() exiting", __func__);
+    if (_TEEC_AsyncDetached(async)) _TEEC_FreeAsync(async);
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+static bool _TEEC_StartCompletionThread(struct _TEEC_Async *async)
+{
+    bool    started;
+
+    // Started with the first asynchronous operation, most contexts never need it
+    pthread_mutex_lock(&async->mutex);
+    if (!async->threadStarted) {
+        if (pthread_create(&async->thread, NULL, _TEEC_CompletionThread, async) == 0) {
+            async->threadStarted = true;
+        } else {
+            LOG_E("pthread_create failed on completion thread");
+        }
+    }
+    started = async->threadStarted;
+    pthread_mutex_unlock(&async->mutex);
+    return started;
+}
+
+//------------------------------------------------------------------------------
+static void _TEEC_CreateAsync(_TEEC_ContextState *context)
+{
+    struct _TEEC_Async *async;
+
+    // Without it only TEEC_InvokeCommandAsync fails, so failing here is not fatal
+    async = (struct _TEEC_Async *)calloc(1, sizeof(struct _TEEC_Async));
+    if (async == NULL) {
+        LOG_W("calloc failed on async allocation");
+        return;
+    }
+
+    if (mcOpenNotificationSet(&async->setFd) != MC_DRV_OK) {
+        LOG_W("mcOpenNotificationSet failed");
+        free(async);
+        return;
+    }
+
+    async->wakeFd = eventfd(0, EFD_CLOEXEC);
+    async->completionFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if ((async->wakeFd < 0) || (async->completionFd < 0)) {
+        LOG_W("eventfd failed (%d)", errno);
+        if (async->wakeFd >= 0) close(async->wakeFd);
+        if (async->completionFd >= 0) close(async->completionFd);
+        mcCloseNotificationSet(async->setFd);
+        free(async);
+        return;
+    }
+
+    pthread_mutex_init(&async->mutex, NULL);
+    context->async = async;
+}
+
+//------------------------------------------------------------------------------
+static void _TEEC_FreeAsync(struct _TEEC_Async *async)
+{
+    if (async->pending != NULL) {
+        // Sessions are still open with a pending operation, better leak than free under them
+        LOG_E("asynchronous operations still pending");
+        return;
+    }
+    pthread_mutex_destroy(&async->mutex);
+    close(async->wakeFd);
+    close(async->completionFd);
+    mcCloseNotificationSet(async->setFd);
+    free(async);
+}
+
+//------------------------------------------------------------------------------
+static void _TEEC_DestroyAsync(_TEEC_ContextState *context)
+{
+    struct _TEEC_Async *async = context->async;
+    bool               onCompletionThread;
+
+    if (async == NULL) return;
+
+    context->async = NULL;
+    _TEEC_CancelPendingAsync(async);
+
+    // Results nobody asked for go with the context
+    pthread_rwlock_wrlock(&stateLock);
+    std::map<const TEEC_Operation *, _TEEC_OperationState>::iterator it = operationStates.begin();
+    while (it != operationStates.end()) {
+        if (it->second.async == async) {
+            operationStates.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+    pthread_rwlock_unlock(&stateLock);
+
+    // A callback finalizing its own context runs on the completion thread,
+    // which cannot join itself. It frees the rest once the callback returned.
+    pthread_mutex_lock(&async->mutex);
+    onCompletionThread = async->threadStarted && pthread_equal(pthread_self(), async->thread);
+    async->detached = onCompletionThread;
+    pthread_mutex_unlock(&async->mutex);
+    if (onCompletionThread) {
+        pthread_detach(async->thread);
+        return;
+    }
+
+    if (async->threadStarted) {
+        eventfd_write(async->wakeFd, 1);
+        pthread_join(async->thread, NULL);
+    }
+    _TEEC_FreeAsync(async);
+}
+
 //------------------------------------------------------------------------------
 __MC_CLIENT_LIB_API mcResult_t mcOpenGPTA(
     mcSessionHandle_t  *session,
@@ -496,10 +1129,12 @@ TEEC_Result TEEC_OpenSession (
     TEEC_Operation  *operation,
     uint32_t        *returnOrigin)
 {
-    mcResult_t      mcRet;
-    TEEC_Result     teecRes;
-    uint32_t        returnOrigin_local;
-    mcUuid_t        tauuid;
+    mcResult_t          mcRet;
+    TEEC_Result         teecRes;
+    uint32_t            returnOrigin_local;
+    mcUuid_t            tauuid;
+    _TEEC_ContextState  *contextState;
+    _TEEC_SessionState  *state;
 
     LOG_I("== %s() ==============", __func__);
     // -------------------------------------------------------------
@@ -527,6 +1162,18 @@ TEEC_Result TEEC_OpenSession (
     // -------------------------------------------------------------
     session->imp.active = false;
 
+    state = (_TEEC_SessionState *)calloc(1, sizeof(_TEEC_SessionState));
+    if (state == NULL) {
+        LOG_E("calloc failed on session state allocation");
+        if (returnOrigin != NULL) *returnOrigin = TEEC_ORIGIN_API;
+        return TEEC_ERROR_OUT_OF_MEMORY;
+    }
+    contextState = _TEEC_FindContextState(context);
+    if (contextState != NULL) {
+        state->arena = contextState->arena;
+        state->async = contextState->async;
+    }
+
     _libUuidToArray((TEEC_UUID *)destination, (uint8_t *)tauuid.value);
 
     if (operation) operation->imp.session = &session->imp;
@@ -536,6 +1183,7 @@ TEEC_Result TEEC_OpenSession (
     void *bulkBuf = (void *)mmap(0, sysconf(_SC_PAGESIZE), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
     if (bulkBuf == MAP_FAILED) {
         LOG_E("mmap filed on tci buffer allocation");
+        free(state);
         if (returnOrigin != NULL) *returnOrigin = TEEC_ORIGIN_API;
         return TEEC_ERROR_OUT_OF_MEMORY;
     }
@@ -544,8 +1192,13 @@ TEEC_Result TEEC_OpenSession (
     memset(session->imp.tci, 0, sysconf(_SC_PAGESIZE));
 
     pthread_mutex_init(&session->imp.mutex_tci, NULL);
+    pthread_cond_init(&state->cond_pending, NULL);
     pthread_mutex_lock(&session->imp.mutex_tci);
 
+    pthread_rwlock_wrlock(&stateLock);
+    sessionStates[&session->imp] = state;
+    pthread_rwlock_unlock(&stateLock);
+
     //Fill the TCI buffer session.tci with the destination UUID.
     memcpy(&(((_TEEC_TCI *)session->imp.tci)->destination), destination, sizeof(TEEC_UUID));
     // -------------------------------------------------------------
@@ -569,11 +1222,12 @@ TEEC_Result TEEC_OpenSession (
     }
 
     session->imp.active = true;
+    _TEEC_AcquireArenaSlot(&session->imp, state);
 
     // Let TA go through entry points
     LOG_I(" let TA go through entry points");
     ((_TEEC_TCI *)session->imp.tci)->operation.type = _TA_OPERATION_OPEN_SESSION;
-    teecRes = _TEEC_CallTA(session, operation, &returnOrigin_local);
+    teecRes = _TEEC_CallTA(session, state, operation, &returnOrigin_local);
 
     // Check for error on communication level
     if (teecRes != TEEC_SUCCESS ) {
@@ -609,8 +1263,12 @@ error:
         }
         session->imp.active = false;
     }
+    _TEEC_ReleaseArenaSlot(state);
+    _TEEC_RemoveSessionState(&session->imp);
 
     pthread_mutex_unlock(&session->imp.mutex_tci);
+    pthread_cond_destroy(&state->cond_pending);
+    free(state);
     pthread_mutex_destroy(&session->imp.mutex_tci);
     if (session->imp.tci) {
         munmap(session->imp.tci, sysconf(_SC_PAGESIZE));
@@ -630,6 +1288,7 @@ TEEC_Result TEEC_InvokeCommand(
 {
     TEEC_Result teecRes;
     uint32_t returnOrigin_local;
+    _TEEC_SessionState *state;
 
     LOG_I("== %s() ==============", __func__);
 
@@ -640,7 +1299,8 @@ TEEC_Result TEEC_InvokeCommand(
         return TEEC_ERROR_BAD_PARAMETERS;
     }
 
-    if (!session->imp.active) {
+    state = _TEEC_FindSessionState(&session->imp);
+    if (!session->imp.active || (state == NULL)) {
         LOG_E("session is inactive");
         if (returnOrigin != NULL) *returnOrigin = TEEC_ORIGIN_API;
         return TEEC_ERROR_BAD_STATE;
@@ -650,10 +1310,21 @@ TEEC_Result TEEC_InvokeCommand(
 
     pthread_mutex_lock(&session->imp.mutex_tci);
 
+    // Wait for a pending asynchronous operation to give the tci back
+    while (state->pending) {
+        pthread_cond_wait(&state->cond_pending, &session->imp.mutex_tci);
+    }
+    if (!session->imp.active) {
+        LOG_E("session died with the asynchronous operation");
+        pthread_mutex_unlock(&session->imp.mutex_tci);
+        if (returnOrigin != NULL) *returnOrigin = TEEC_ORIGIN_API;
+        return TEEC_ERROR_BAD_STATE;
+    }
+
     // Call TA
     ((_TEEC_TCI *)session->imp.tci)->operation.commandId = commandID;
     ((_TEEC_TCI *)session->imp.tci)->operation.type = _TA_OPERATION_INVOKE_COMMAND;
-    teecRes = _TEEC_CallTA(session, operation, &returnOrigin_local);
+    teecRes = _TEEC_CallTA(session, state, operation, &returnOrigin_local);
     if (teecRes != TEEC_SUCCESS ) {
         LOG_E("_TEEC_CallTA failed(%08x)", teecRes);
         if (returnOrigin != NULL) *returnOrigin = returnOrigin_local;
@@ -667,12 +1338,209 @@ TEEC_Result TEEC_InvokeCommand(
     return teecRes;
 }
 
+//------------------------------------------------------------------------------
+TEEC_Result TEEC_InvokeCommandAsync(
+    TEEC_Session     *session,
+    uint32_t         commandID,
+    TEEC_Operation   *operation,
+    TEEC_Callback    callback,
+    void             *userData,
+    uint32_t         *returnOrigin)
+{
+    TEEC_Result             teecRes;
+    mcResult_t              mcRet;
+    uint32_t                returnOrigin_local;
+    struct _TEEC_Async      *async;
+    _TEEC_SessionState      *state;
+    _TEEC_AsyncOperation    *asyncOp;
+
+    LOG_I("== %s() ==============", __func__);
+
+    // -------------------------------------------------------------
+    if (session == NULL) {
+        LOG_E("session is NULL");
+        if (returnOrigin != NULL) *returnOrigin = TEEC_ORIGIN_API;
+        return TEEC_ERROR_BAD_PARAMETERS;
+    }
+
+    //The operation is the handle of the pending command
+    if (operation == NULL) {
+        LOG_E("operation is NULL");
+        if (returnOrigin != NULL) *returnOrigin = TEEC_ORIGIN_API;
+        return TEEC_ERROR_BAD_PARAMETERS;
+    }
+
+    state = _TEEC_FindSessionState(&session->imp);
+    if (state == NULL) {
+        LOG_E("session is not open");
+        if (returnOrigin != NULL) *returnOrigin = TEEC_ORIGIN_API;
+        return TEEC_ERROR_BAD_STATE;
+    }
+
+    async = state->async;
+    if (async == NULL) {
+        LOG_E("asynchronous operations are not available");
+        if (returnOrigin != NULL) *returnOrigin = TEEC_ORIGIN_API;
+        return TEEC_ERROR_NOT_SUPPORTED;
+    }
+
+    if (!_TEEC_StartCompletionThread(async)) {
+        if (returnOrigin != NULL) *returnOrigin = TEEC_ORIGIN_API;
+        return TEEC_ERROR_OUT_OF_MEMORY;
+    }
+
+    asyncOp = (_TEEC_AsyncOperation *)calloc(1, sizeof(_TEEC_AsyncOperation));
+    if (asyncOp == NULL) {
+        LOG_E("calloc failed");
+        if (returnOrigin != NULL) *returnOrigin = TEEC_ORIGIN_API;
+        return TEEC_ERROR_OUT_OF_MEMORY;
+    }
+    asyncOp->handle = session->imp.handle;
+    asyncOp->session = session;
+    asyncOp->state = state;
+    asyncOp->operation = operation;
+    asyncOp->callback = callback;
+    asyncOp->userData = userData;
+
+    // -------------------------------------------------------------
+    operation->imp.session = &session->imp;
+
+    pthread_rwlock_wrlock(&stateLock);
+    _TEEC_OperationState *opState = &operationStates[operation];
+    opState->async = async;
+    opState->completed = false;
+    pthread_rwlock_unlock(&stateLock);
+
+    pthread_mutex_lock(&session->imp.mutex_tci);
+
+    //There is one tci per session, so only one operation can be pending
+    if (state->pending || !session->imp.active) {
+        LOG_E("session is busy or inactive");
+        pthread_mutex_unlock(&session->imp.mutex_tci);
+        _TEEC_RemoveOperationState(operation);
+        free(asyncOp);
+        if (returnOrigin != NULL) *returnOrigin = TEEC_ORIGIN_API;
+        return session->imp.active ? TEEC_ERROR_BUSY : TEEC_ERROR_BAD_STATE;
+    }
+
+    ((_TEEC_TCI *)session->imp.tci)->operation.commandId = commandID;
+    ((_TEEC_TCI *)session->imp.tci)->operation.type = _TA_OPERATION_INVOKE_COMMAND;
+    teecRes = _TEEC_SetupOperation(&session->imp, state, operation, &asyncOp->staging, &returnOrigin_local);
+    if (teecRes != TEEC_SUCCESS ) {
+        LOG_E("_TEEC_SetupOperation failed (%08x)", teecRes);
+        pthread_mutex_unlock(&session->imp.mutex_tci);
+        _TEEC_RemoveOperationState(operation);
+        free(asyncOp);
+        if (returnOrigin != NULL) *returnOrigin = returnOrigin_local;
+        return teecRes;
+    }
+
+    // Queue the operation before the Trusted App can respond to it
+    mcRet = mcAddToNotificationSet(async->setFd, &session->imp.handle);
+    if (mcRet != MC_DRV_OK) {
+        LOG_E("mcAddToNotificationSet failed (%08x)", mcRet);
+        // The Trusted App has not been notified, so the session is still fine
+        _TEEC_UnwindOperation(&session->imp, state, operation, &asyncOp->staging, false, &returnOrigin_local);
+        pthread_mutex_unlock(&session->imp.mutex_tci);
+        _TEEC_RemoveOperationState(operation);
+        free(asyncOp);
+        if (returnOrigin != NULL) *returnOrigin = TEEC_ORIGIN_COMMS;
+        return TEEC_ERROR_COMMUNICATION;
+    }
+    pthread_mutex_lock(&async->mutex);
+    asyncOp->next = async->pending;
+    async->pending = asyncOp;
+    pthread_mutex_unlock(&async->mutex);
+    state->pending = true;
+
+    // Signal the Trusted App
+    mcRet = mcNotify(&session->imp.handle);
+    if (mcRet != MC_DRV_OK) {
+        if (_TEEC_DequeueAsync(async, &session->imp.handle) == NULL) {
+            // The completion thread already owns the operation
+            mcRet = MC_DRV_OK;
+        } else {
+            state->pending = false;
+        }
+    }
+
+    teecRes = TEEC_SUCCESS;
+    if (mcRet != MC_DRV_OK) {
+        // Nothing is pending, so complete the operation here
+        teecRes = _TEEC_CompleteCallTA(session, state, operation, &asyncOp->staging, mcRet, &returnOrigin_local);
+        LOG_E("_TEEC_CompleteCallTA failed(%08x)", teecRes);
+        _TEEC_RemoveOperationState(operation);
+        free(asyncOp);
+        if (returnOrigin != NULL) *returnOrigin = returnOrigin_local;
+    }
+
+    pthread_mutex_unlock(&session->imp.mutex_tci);
+    LOG_I(" %s() = 0x%x", __func__, teecRes);
+    return teecRes;
+}
+
+//------------------------------------------------------------------------------
+TEEC_Result TEEC_GetCompletionFd(
+    TEEC_Context     *context,
+    int              *fd)
+{
+    LOG_I("== %s() ==============", __func__);
+
+    if ((context == NULL) || (fd == NULL)) {
+        LOG_E("context or fd is NULL");
+        return TEEC_ERROR_BAD_PARAMETERS;
+    }
+
+    _TEEC_ContextState *state = _TEEC_FindContextState(context);
+    if ((state == NULL) || (state->async == NULL)) {
+        *fd = -1;
+        return TEEC_ERROR_NOT_SUPPORTED;
+    }
+
+    *fd = state->async->completionFd;
+    return TEEC_SUCCESS;
+}
+
+//------------------------------------------------------------------------------
+TEEC_Result TEEC_GetOperationResult(
+    TEEC_Operation   *operation,
+    uint32_t         *returnOrigin)
+{
+    if (operation == NULL) {
+        LOG_E("operation is NULL");
+        if (returnOrigin != NULL) *returnOrigin = TEEC_ORIGIN_API;
+        return TEEC_ERROR_BAD_PARAMETERS;
+    }
+
+    pthread_rwlock_wrlock(&stateLock);
+    std::map<const TEEC_Operation *, _TEEC_OperationState>::iterator it = operationStates.find(operation);
+    if (it == operationStates.end()) {
+        pthread_rwlock_unlock(&stateLock);
+        LOG_E("operation is not pending");
+        if (returnOrigin != NULL) *returnOrigin = TEEC_ORIGIN_API;
+        return TEEC_ERROR_BAD_STATE;
+    }
+    if (!it->second.completed) {
+        pthread_rwlock_unlock(&stateLock);
+        if (returnOrigin != NULL) *returnOrigin = TEEC_ORIGIN_API;
+        return TEEC_ERROR_BUSY;
+    }
+
+    // Reported once, the operation is free for reuse afterwards
+    TEEC_Result teecRes = it->second.result;
+    if (returnOrigin != NULL) *returnOrigin = it->second.returnOrigin;
+    operationStates.erase(it);
+    pthread_rwlock_unlock(&stateLock);
+    return teecRes;
+}
+
 //------------------------------------------------------------------------------
 void TEEC_CloseSession(TEEC_Session *session)
 {
-    mcResult_t      mcRet;
-    TEEC_Result     teecRes = TEEC_SUCCESS;
-    uint32_t        returnOrigin;
+    mcResult_t          mcRet;
+    TEEC_Result         teecRes = TEEC_SUCCESS;
+    uint32_t            returnOrigin;
+    _TEEC_SessionState  *state;
 
     LOG_I("== %s() ==============", __func__);
 
@@ -683,13 +1551,23 @@ void TEEC_CloseSession(TEEC_Session *session)
         return;
     }
 
+    state = _TEEC_FindSessionState(&session->imp);
+    if (state == NULL) {
+        LOG_E("session is not open");
+        return;
+    }
+
     // -------------------------------------------------------------
+    pthread_mutex_lock(&session->imp.mutex_tci);
+    // Let a pending asynchronous operation complete first
+    while (state->pending) {
+        pthread_cond_wait(&state->cond_pending, &session->imp.mutex_tci);
+    }
     if (session->imp.active) {
         // Let TA go through CloseSession and Destroy entry points
         LOG_I(" let TA go through close entry points");
-        pthread_mutex_lock(&session->imp.mutex_tci);
         ((_TEEC_TCI *)session->imp.tci)->operation.type = _TA_OPERATION_CLOSE_SESSION;
-        teecRes = _TEEC_CallTA(session, NULL, &returnOrigin);
+        teecRes = _TEEC_CallTA(session, state, NULL, &returnOrigin);
         if (teecRes != TEEC_SUCCESS ) {
             /* continue even in case of error */;
             LOG_E("_TEEC_CallTA failed(%08x)", teecRes);
@@ -703,9 +1581,13 @@ void TEEC_CloseSession(TEEC_Session *session)
                 /* ignore error and also there shouldn't be one */
             }
         }
-        pthread_mutex_unlock(&session->imp.mutex_tci);
+        _TEEC_ReleaseArenaSlot(state);
     }
+    _TEEC_RemoveSessionState(&session->imp);
+    pthread_mutex_unlock(&session->imp.mutex_tci);
 
+    pthread_cond_destroy(&state->cond_pending);
+    free(state);
     pthread_mutex_destroy(&session->imp.mutex_tci);
     if (session->imp.tci) {
         munmap(session->imp.tci, sysconf(_SC_PAGESIZE));
@@ -807,6 +1689,37 @@ void TEEC_RequestCancellation(
 {
     LOG_I("== %s() ==============", __func__);
 
+    if (operation == NULL) {
+        LOG_E("operation is NULL");
+        return;
+    }
+
+    // An asynchronous operation is started before TEEC_InvokeCommandAsync
+    // returns. The completion thread only hands its tci on with mutex_tci
+    // held, so with it the cancellation cannot hit a later operation.
+    pthread_rwlock_rdlock(&stateLock);
+    std::map<const TEEC_Operation *, _TEEC_OperationState>::iterator it = operationStates.find(operation);
+    bool isAsync = (it != operationStates.end());
+    bool completed = isAsync && it->second.completed;
+    pthread_rwlock_unlock(&stateLock);
+    if (isAsync) {
+        if (completed) {
+            LOG_I("The operation has finished");
+            return;
+        }
+        TEEC_Session_IMP *session = operation->imp.session;
+        pthread_mutex_lock(&session->mutex_tci);
+        if ((operation->started == 1) && session->active) {
+            ((_TEEC_TCI *)session->tci)->operation.isCancelled = true;
+            mcResult_t mcRet = mcNotify(&session->handle);
+            if (MC_DRV_OK != mcRet) {
+                LOG_E("Notify failed (%08x)", mcRet);
+            }
+        }
+        pthread_mutex_unlock(&session->mutex_tci);
+        return;
+    }
+
     while (operation->started == 0);
 
     LOG_I("while(operation->started ==0) passed");
@@ -833,3 +1746,25 @@ void TEEC_RequestCancellation(
 }
 
 //------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+TEEC_Result TEEC_GetArenaStats(
+    TEEC_Context        *context,
+    TEEC_ArenaStats_IMP *stats)
+{
+    LOG_I("== %s() ==============", __func__);
+
+    if ((context == NULL) || (stats == NULL)) {
+        LOG_E("context or stats is NULL");
+        return TEEC_ERROR_BAD_PARAMETERS;
+    }
+
+    _TEEC_ContextState *state = _TEEC_FindContextState(context);
+    if ((state == NULL) || (state->arena == NULL)) {
+        memset(stats, 0, sizeof(TEEC_ArenaStats_IMP));
+        return TEEC_ERROR_ITEM_NOT_FOUND;
+    }
+
+    memcpy(stats, &state->arena->stats, sizeof(TEEC_ArenaStats_IMP));
+    return TEEC_SUCCESS;
+}
@@ -50,6 +50,8 @@ Session::Session(
     this->sessionId = sessionId;
     this->mcKMod = mcKMod;
     this->notificationConnection = connection;
+    this->tciWsm = NULL;
+    this->traceId = 0;
 
     sessionInfo.lastErr = SESSION_ERR_NO;
     sessionInfo.state = SESSION_STATE_INITIAL;
@@ -82,8 +84,6 @@ Session::~Session(void)
 
     // Finally delete notification connection
     delete notificationConnection;
-
-    unlock();
 }
 
 
@@ -113,12 +113,15 @@ mcResult_t Session::addBulkBuf(addr_t buf, uint32_t len, BulkBufferDescriptor **
 
     assert(blkBuf != NULL);
 
+    lock();
+
     // Search bulk buffer descriptors for existing vAddr
     // At the moment a virtual address can only be added one time
     for ( bulkBufferDescrIterator_t iterator = bulkBufferDescriptors.begin();
             iterator != bulkBufferDescriptors.end();
             ++iterator) {
         if ((*iterator)->virtAddr == buf) {
+            unlock();
             LOG_E("Cannot map a buffer to multiple locations in one Trustlet.");
             return MC_DRV_ERR_BUFFER_ALREADY_MAPPED;
         }
@@ -128,6 +131,7 @@ mcResult_t Session::addBulkBuf(addr_t buf, uint32_t len, BulkBufferDescriptor **
     mcResult_t ret = mcKMod->registerWsmL2(buf, len, 0, &handle, &pPhysWsmL2);
 
     if (ret != MC_DRV_OK) {
+        unlock();
         LOG_V(" mcKMod->registerWsmL2() failed with %x", ret);
         return ret;
     }
@@ -140,15 +144,20 @@ mcResult_t Session::addBulkBuf(addr_t buf, uint32_t len, BulkBufferDescriptor **
     // Add to vector of descriptors
     bulkBufferDescriptors.push_back(*blkBuf);
 
+    unlock();
+
     return MC_DRV_OK;
 }
 
 //------------------------------------------------------------------------------
 void Session::addBulkBuf(BulkBufferDescriptor *blkBuf)
 {
-    if (blkBuf)
+    if (blkBuf) {
         // Add to vector of descriptors
+        lock();
         bulkBufferDescriptors.push_back(blkBuf);
+        unlock();
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -156,15 +165,20 @@ uint32_t Session::getBufHandle(addr_t sVirtAddr, uint32_t sVirtualLen)
 {
     LOG_V("getBufHandle(): Secure Virtual Address = 0x%X", (unsigned int) sVirtAddr);
 
-    // Search and remove bulk buffer descriptor
+    uint32_t handle = 0;
+
+    // Search bulk buffer descriptor
+    lock();
     for ( bulkBufferDescrIterator_t iterator = bulkBufferDescriptors.begin();
             iterator != bulkBufferDescriptors.end();
             ++iterator ) {
         if (((*iterator)->sVirtualAddr == sVirtAddr) && ((*iterator)->len == sVirtualLen)) {
-            return (*iterator)->handle;
+            handle = (*iterator)->handle;
+            break;
         }
     }
-    return 0;
+    unlock();
+    return handle;
 }
 
 //------------------------------------------------------------------------------
@@ -175,6 +189,7 @@ mcResult_t Session::removeBulkBuf(addr_t virtAddr)
     LOG_V("removeBulkBuf(): Virtual Address = 0x%X", (unsigned int) virtAddr);
 
     // Search and remove bulk buffer descriptor
+    lock();
     for ( bulkBufferDescrIterator_t iterator = bulkBufferDescriptors.begin();
             iterator != bulkBufferDescriptors.end();
             ++iterator
@@ -186,6 +201,7 @@ mcResult_t Session::removeBulkBuf(addr_t virtAddr)
             break;
         }
     }
+    unlock();
 
     if (pBlkBufDescr == NULL) {
         LOG_E("%p not registered in session %d.", virtAddr, sessionId);
@@ -39,6 +39,7 @@
 #include "mc_linux.h"
 #include "Connection.h"
 #include "CMcKMod.h"
+#include "CWsm.h"
 #include "CMutex.h"
 
 
@@ -93,12 +94,14 @@ class Session
 {
 private:
     CMcKMod *mcKMod;
-    CMutex workLock;
+    CMutex workLock; /**< Guards bulkBufferDescriptors */
     bulkBufferDescrList_t bulkBufferDescriptors; /**< Descriptors of additional bulk buffer of a session */
     sessionInformation_t sessionInfo; /**< Informations about session */
 public:
     uint32_t sessionId;
     Connection *notificationConnection;
+    CWsm_ptr tciWsm; /**< Contiguous WSM used as TCI, NULL if none */
+    uint32_t traceId; /**< Trace ID of the last notification sent, 0 if none */
 
     Session(uint32_t sessionId, CMcKMod *mcKMod, Connection *connection);
 
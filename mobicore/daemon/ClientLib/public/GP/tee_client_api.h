@@ -183,6 +183,45 @@ TEEC_EXPORT TEEC_Result TEEC_InvokeCommand(
 TEEC_EXPORT void  TEEC_RequestCancellation(
     TEEC_Operation *operation);
 
+/* Implementation-specific: statistics of the temporary memory reference arena */
+TEEC_EXPORT TEEC_Result TEEC_GetArenaStats(
+    TEEC_Context        *context,
+    TEEC_ArenaStats_IMP *stats);
+
+/* Implementation-specific: asynchronous operations.
+   TEEC_InvokeCommandAsync returns once the Trusted Application has been
+   notified. The operation is the handle of the pending command: it completes
+   on a thread owned by the library, which calls the callback (if any) and
+   signals the descriptor returned by TEEC_GetCompletionFd. The callback must
+   not block, but it may finalize the context. Only one operation per session
+   can be pending, and TEEC_RequestCancellation works on pending operations
+   as well. Without a callback, TEEC_GetOperationResult returns
+   TEEC_ERROR_BUSY until the operation completed and then reports its result
+   once. The result of an operation with a callback is only passed to the
+   callback. TEEC_FinalizeContext fails operations still pending with
+   TEEC_ERROR_CANCEL and closes their sessions. */
+typedef void (*TEEC_Callback)(
+    TEEC_Operation  *operation,
+    TEEC_Result     result,
+    uint32_t        returnOrigin,
+    void            *userData);
+
+TEEC_EXPORT TEEC_Result TEEC_InvokeCommandAsync(
+    TEEC_Session     *session,
+    uint32_t         commandID,
+    TEEC_Operation   *operation,
+    TEEC_Callback    callback,
+    void             *userData,
+    uint32_t         *returnOrigin);
+
+TEEC_EXPORT TEEC_Result TEEC_GetCompletionFd(
+    TEEC_Context     *context,
+    int              *fd);
+
+TEEC_EXPORT TEEC_Result TEEC_GetOperationResult(
+    TEEC_Operation   *operation,
+    uint32_t         *returnOrigin);
+
 #pragma GCC visibility pop
 
 #endif /* TBASE_API_LEVEL */
@@ -46,6 +46,22 @@
 #include "MobiCoreDriverApi.h"
 
 
+/* Small temporary memory references are copied into a per-session slot of a
+   shared-memory arena, which is mapped to the Trusted Application once when
+   the session is opened. Larger ones are still mapped on every operation. */
+#define TEEC_ARENA_SLOT_SIZE        ((size_t)0x4000)
+#define TEEC_ARENA_SLOT_NUMBER      8
+#define TEEC_ARENA_MEMREF_MAX_SIZE  ((size_t)0x1000)
+
+typedef struct {
+    uint32_t    sessionsWithSlot;   //sessions which got an arena slot
+    uint32_t    sessionsWithoutSlot;//sessions which found no free slot or could not map it
+    uint32_t    copiedMemrefs;      //temporary memory references staged in a slot
+    uint64_t    copiedBytes;        //bytes copied in and out of the slots
+    uint32_t    mappedMemrefs;      //temporary memory references mapped directly
+}
+TEEC_ArenaStats_IMP;
+
 typedef struct {
     uint32_t    reserved;
 }
@@ -175,10 +175,19 @@ typedef struct {
     uint32_t sVirtualLen;       /**< Length of the mapped Bulk buffer */
 } mcBulkMap_t;
 
+/** A bulk buffer mapped or unmapped together with others by mcMapList() and mcUnmapList().
+ */
+typedef struct {
+    void *buf;                  /**< Virtual address of the buffer (relative to CA), already includes a possible offset! */
+    uint32_t len;               /**< Length of the buffer in bytes */
+    mcBulkMap_t *mapInfo;       /**< Information structure about the mapped Bulk buffer */
+} mcBulkBuf_t;
+
 
 #define MC_DEVICE_ID_DEFAULT       0 /**< The default device ID */
 #define MC_INFINITE_TIMEOUT        ((int32_t)(-1)) /**< Wait infinite for a response of the MC. */
 #define MC_NO_TIMEOUT              0   /**< Do not wait for a response of the MC. */
+#define MC_NOTIFICATION_SET_MAX_EVENTS 64 /**< Maximum number of sessions reported by one mcWaitNotificationSet() call. */
 #define MC_MAX_TCI_LEN             0x100000 /**< TCI/DCI must not exceed 1MiB */
 
 #ifndef WIN32
@@ -345,6 +354,95 @@ __MC_CLIENT_LIB_API mcResult_t mcWaitNotification(
     int32_t            timeout
 );
 
+/** Create a notification set.
+ *
+ * A notification set waits for notifications of many sessions with one thread.
+ * The returned descriptor becomes readable when one of the sessions in the set has a
+ * notification pending, so it can also be added to an existing poll()/epoll() event loop,
+ * which then calls mcWaitNotificationSet() with MC_NO_TIMEOUT.
+ *
+ * @param [out] setFd Pollable descriptor of the new set.
+ *
+ * @return MC_DRV_OK if operation has been successfully completed.
+ * @return MC_DRV_INVALID_PARAMETER if a parameter is invalid.
+ * @return MC_DRV_ERR_NOTIFICATION if the set could not be created.
+ */
+__MC_CLIENT_LIB_API mcResult_t mcOpenNotificationSet(
+    int32_t            *setFd
+);
+
+/** Close a notification set.
+ *
+ * The sessions in the set are not affected.
+ *
+ * @param [in] setFd Descriptor returned by mcOpenNotificationSet().
+ *
+ * @return MC_DRV_OK if operation has been successfully completed.
+ * @return MC_DRV_INVALID_PARAMETER if setFd is invalid.
+ */
+__MC_CLIENT_LIB_API mcResult_t mcCloseNotificationSet(
+    int32_t            setFd
+);
+
+/** Add a session to a notification set.
+ *
+ * A session leaves all sets automatically when it is closed.
+ *
+ * @param [in] setFd Descriptor returned by mcOpenNotificationSet().
+ * @param [in] session The session to be added.
+ *
+ * @return MC_DRV_OK if operation has been successfully completed.
+ * @return MC_DRV_INVALID_PARAMETER if the session is already in the set.
+ * @return MC_DRV_ERR_UNKNOWN_SESSION when session id is invalid.
+ * @return MC_DRV_ERR_UNKNOWN_DEVICE when device id of session is invalid.
+ * @return MC_DRV_ERR_NOTIFICATION if setFd is invalid.
+ */
+__MC_CLIENT_LIB_API mcResult_t mcAddToNotificationSet(
+    int32_t            setFd,
+    mcSessionHandle_t  *session
+);
+
+/** Remove a session from a notification set.
+ *
+ * @param [in] setFd Descriptor returned by mcOpenNotificationSet().
+ * @param [in] session The session to be removed.
+ *
+ * @return MC_DRV_OK if operation has been successfully completed.
+ * @return MC_DRV_INVALID_PARAMETER if the session is not in the set.
+ * @return MC_DRV_ERR_UNKNOWN_SESSION when session id is invalid.
+ * @return MC_DRV_ERR_UNKNOWN_DEVICE when device id of session is invalid.
+ * @return MC_DRV_ERR_NOTIFICATION if setFd is invalid.
+ */
+__MC_CLIENT_LIB_API mcResult_t mcRemoveFromNotificationSet(
+    int32_t            setFd,
+    mcSessionHandle_t  *session
+);
+
+/** Wait for notifications of the sessions in a notification set.
+ *
+ * Blocks until at least one session of the set has been notified, then drains the
+ * notification queue of every notified session like mcWaitNotification() does.
+ *
+ * @param [in] setFd Descriptor returned by mcOpenNotificationSet().
+ * @param [out] sessions Sessions that received a notification.
+ * @param [out] results Per session result, as mcWaitNotification() would have returned it.
+ * @param [in,out] count Capacity of sessions and results on input, number of entries filled
+ *                 on output. At most MC_NOTIFICATION_SET_MAX_EVENTS entries are filled.
+ * @param [in] timeout Time in milliseconds to wait (MC_NO_TIMEOUT : direct return, > 0 : milliseconds, MC_INFINITE_TIMEOUT : wait infinitely)
+ *
+ * @return MC_DRV_OK if at least one session has been notified.
+ * @return MC_DRV_ERR_TIMEOUT if no notification arrived in time.
+ * @return MC_DRV_ERR_NOTIFICATION if a problem with the set occurred.
+ * @return MC_DRV_INVALID_PARAMETER if a parameter is invalid.
+ */
+__MC_CLIENT_LIB_API mcResult_t mcWaitNotificationSet(
+    int32_t            setFd,
+    mcSessionHandle_t  *sessions,
+    mcResult_t         *results,
+    uint32_t           *count,
+    int32_t            timeout
+);
+
 /**
  * Allocate a block of world shared memory (WSM).
  * The MC driver allocates a contiguous block of memory which can be used as WSM.
@@ -454,6 +552,48 @@ __MC_CLIENT_LIB_API mcResult_t mcUnmap(
     mcBulkMap_t        *mapInfo
 );
 
+/**
+ * Map several bulk buffers to a session at once.
+ *
+ * Works like calling mcMap() for every buffer, but up to 4 buffers are mapped by the daemon with a
+ * single request. Either all buffers are mapped or none.
+ *
+ * @param [in] session Session handle with information of the deviceId and the sessionId.
+ * @param [in,out] bufs Buffers to be mapped. The mapInfo of each buffer is filled in.
+ * @param [in] count Number of buffers.
+ *
+ * @return MC_DRV_OK if operation has been successfully completed.
+ * @return MC_DRV_INVALID_PARAMETER if a parameter is invalid.
+ * @return MC_DRV_ERR_UNKNOWN_SESSION when session id is invalid.
+ * @return MC_DRV_ERR_UNKNOWN_DEVICE when device id of session is invalid.
+ * @return MC_DRV_ERR_DAEMON_UNREACHABLE when problems with daemon occur.
+ * @return MC_DRV_ERR_BULK_MAPPING when a buf is already uses as bulk buffer or when registering a buffer failed.
+ */
+__MC_CLIENT_LIB_API mcResult_t mcMapList(
+    mcSessionHandle_t  *session,
+    mcBulkBuf_t        *bufs,
+    uint32_t           count
+);
+
+/**
+ * Unmap several bulk buffers from a session at once.
+ *
+ * Works like calling mcUnmap() for every buffer, but up to 4 buffers are unmapped by the daemon
+ * with a single request. All buffers are unmapped even if one of them fails.
+ *
+ * @param [in] session Session handle with information of the deviceId and the sessionId.
+ * @param [in] bufs Buffers mapped by mcMap() or mcMapList().
+ * @param [in] count Number of buffers.
+ *
+ * @return MC_DRV_OK if operation has been successfully completed.
+ * @return the first error mcUnmap() would have returned otherwise.
+ */
+__MC_CLIENT_LIB_API mcResult_t mcUnmapList(
+    mcSessionHandle_t  *session,
+    mcBulkBuf_t        *bufs,
+    uint32_t           count
+);
+
 
 /**
  * @attention: Not implemented.
@@ -41,8 +41,14 @@
 //------------------------------------------------------------------------------
 CSemaphore::CSemaphore(int size) : m_waiters_count(0), m_count(size)
 {
+    pthread_condattr_t attr;
+
     pthread_mutex_init(&m_mutex, NULL);
-    pthread_cond_init(&m_cond, NULL);
+    // Timed waits must not stretch or end early when the wall clock is set
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&m_cond, &attr);
+    pthread_condattr_destroy(&attr);
 }
 
 
@@ -73,7 +79,7 @@ bool CSemaphore::wait(int sec)
     struct timespec tm;
     if (sec < 0)
         sec = LONG_MAX;
-    clock_gettime(CLOCK_REALTIME, &tm);
+    clock_gettime(CLOCK_MONOTONIC, &tm);
     tm.tv_sec += sec;
 
     pthread_mutex_lock(&m_mutex);
@@ -91,6 +97,33 @@ bool CSemaphore::wait(int sec)
 }
 
 
+//------------------------------------------------------------------------------
+bool CSemaphore::waitUs(uint32_t usec)
+{
+    int rc = 0;
+    struct timespec tm;
+    clock_gettime(CLOCK_MONOTONIC, &tm);
+    tm.tv_sec += usec / 1000000;
+    tm.tv_nsec += (long)(usec % 1000000) * 1000;
+    if (tm.tv_nsec >= 1000000000) {
+        tm.tv_sec++;
+        tm.tv_nsec -= 1000000000;
+    }
+
+    pthread_mutex_lock(&m_mutex);
+    m_waiters_count ++;
+    while ( m_count == 0 && rc == 0 )
+        rc = pthread_cond_timedwait(&m_cond, &m_mutex, &tm);
+    m_waiters_count --;
+    // A signal may still have arrived together with the timeout
+    bool signaled = (m_count > 0);
+    if (signaled)
+        m_count --;
+    pthread_mutex_unlock(&m_mutex);
+    return signaled;
+}
+
+
 //------------------------------------------------------------------------------
 bool CSemaphore::wouldWait()
 {
@@ -36,6 +36,7 @@
 #ifndef CSEMAPHORE_H_
 #define CSEMAPHORE_H_
 
+#include <stdint.h>
 #include "pthread.h"
 
 /**
@@ -55,6 +56,7 @@ public:
 
     void wait(void);
     bool wait(int sec);
+    bool waitUs(uint32_t usec);
 
     bool wouldWait(void);
 
@@ -48,16 +48,19 @@ public:
     uint32_t len;
     uint32_t handle;
     uint64_t physAddr;
+    uint32_t offset; // of virtAddr in the memory handle refers to
 
     CWsm(addr_t virtAddr,
          uint32_t  len,
          uint32_t  handle,
          // this may be unknown, so is can be omitted.
-         uint64_t    physAddr = NULL) :
+         uint64_t    physAddr = NULL,
+         uint32_t  offset = 0) :
         virtAddr(virtAddr),
         len(len),
         handle(handle),
-        physAddr(physAddr)
+        physAddr(physAddr),
+        offset(offset)
     { };
 
 };
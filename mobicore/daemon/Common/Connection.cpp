@@ -55,6 +55,9 @@ Connection::Connection(void)
     socketDescriptor = -1;
 
     detached = false;
+    readAhead = true;
+    rxOffset = 0;
+    rxLength = 0;
 
     remote.sun_family = AF_UNIX;
     memset(remote.sun_path, 0, sizeof(remote.sun_path));
@@ -70,6 +73,10 @@ Connection::Connection(int socketDescriptor, sockaddr_un *remote)
     this->socketDescriptor = socketDescriptor;
     this->remote = *remote;
     connectionData = NULL;
+    detached = false;
+    readAhead = true;
+    rxOffset = 0;
+    rxLength = 0;
 }
 
 
@@ -127,50 +134,124 @@ size_t Connection::readData(void *buffer, uint32_t len)
 //------------------------------------------------------------------------------
 size_t Connection::readData(void *buffer, uint32_t len, int32_t timeout)
 {
-    size_t ret = 0;
-    struct timeval tv;
-    struct timeval *ptv = NULL;
-    fd_set readfds;
+    uint32_t copied = 0;
 
     assert(NULL != buffer);
     assert(socketDescriptor != -1);
 
-    if (timeout >= 0) {
-        // Calculate timeout value
-        tv.tv_sec = timeout / 1000;
-        tv.tv_usec = (timeout - (tv.tv_sec * 1000)) * 1000;
-        ptv = &tv;
+    // Serve bytes an earlier read received ahead first
+    if (rxLength > 0) {
+        copied = rxLength < len ? rxLength : len;
+        memcpy(buffer, rxBuffer + rxOffset, copied);
+        rxOffset += copied;
+        rxLength -= copied;
+        if (copied == len) {
+            return len;
+        }
     }
 
-    FD_ZERO(&readfds);
-    FD_SET(socketDescriptor, &readfds);
-    ret = select(socketDescriptor + 1, &readfds, NULL, NULL, ptv);
-
-    // check for read error
-    if ((int)ret == -1) {
-        LOG_ERRNO("select");
-        return -1;
+    size_t ret = receive((uint8_t *)buffer + copied, len - copied, timeout);
+    if (copied > 0) {
+        // Part of the data is there, report the socket state next time
+        return (int)ret > 0 ? ret + copied : copied;
     }
 
-    // Handle case of no descriptor ready
-    if (ret == 0) {
-        LOG_W(" Timeout during select() / No more notifications.");
-        return -2;
-    }
+    return ret;
+}
 
-    // one or more descriptors are ready
 
-    // finally check if fd has been selected -> must socketDescriptor
-    if (!FD_ISSET(socketDescriptor, &readfds)) {
-        LOG_ERRNO("no fd is set, select");
-        return ret;
+//------------------------------------------------------------------------------
+size_t Connection::receive(void *buffer, uint32_t len, int32_t timeout)
+{
+    ssize_t ret = 0;
+    int flags = 0;
+    struct pollfd pfd;
+
+    // poll() rather than select(), descriptors may well be above FD_SETSIZE
+    pfd.fd = socketDescriptor;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    // Waiting forever on a blocking socket needs no poll(), recvmsg() sleeps
+    if (timeout >= 0) {
+        ret = poll(&pfd, 1, timeout);
+
+        // check for read error
+        if (ret == -1) {
+            LOG_ERRNO("poll");
+            return -1;
+        }
+
+        // Handle case of no descriptor ready
+        if (ret == 0) {
+            LOG_W(" Timeout during poll() / No more notifications.");
+            return -2;
+        }
+        flags = MSG_DONTWAIT;
+    }
+
+    // Whatever else is pending goes to rxBuffer in the same call, so the
+    // payload following a command header is usually read along with it.
+    // Without read-ahead the socket keeps reporting unread bytes to
+    // poll()/epoll_wait() callers.
+    struct iovec iov[2];
+    iov[0].iov_base = buffer;
+    iov[0].iov_len = len;
+    iov[1].iov_base = rxBuffer;
+    iov[1].iov_len = sizeof(rxBuffer);
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = readAhead ? 2 : 1;
+
+    ret = recvmsg(socketDescriptor, &msg, flags);
+    if (ret == -1 && flags == 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        // The socket is non-blocking after all
+        if (poll(&pfd, 1, -1) == -1) {
+            LOG_ERRNO("poll");
+            return -1;
+        }
+        ret = recvmsg(socketDescriptor, &msg, MSG_DONTWAIT);
     }
 
-    ret = recv(socketDescriptor, buffer, len, MSG_DONTWAIT);
     if (ret == 0) {
         LOG_V(" readData(): peer orderly closed connection.");
     }
 
+    if (ret > (ssize_t)len) {
+        rxOffset = 0;
+        rxLength = ret - len;
+        ret = len;
+    }
+
+    return ret;
+}
+
+
+//------------------------------------------------------------------------------
+bool Connection::hasBufferedData(void)
+{
+    return rxLength > 0;
+}
+
+
+//------------------------------------------------------------------------------
+size_t Connection::peekData(void *buffer, uint32_t len)
+{
+    assert(NULL != buffer);
+    assert(socketDescriptor != -1);
+
+    if (rxLength > 0) {
+        uint32_t copied = rxLength < len ? rxLength : len;
+        memcpy(buffer, rxBuffer + rxOffset, copied);
+        return copied;
+    }
+
+    ssize_t ret = recv(socketDescriptor, buffer, len, MSG_PEEK | MSG_DONTWAIT);
+    if (ret <= 0) {
+        return -1;
+    }
     return ret;
 }
 
@@ -192,33 +273,57 @@ size_t Connection::writeData(void *buffer, uint32_t len)
 }
 
 
+//------------------------------------------------------------------------------
+size_t Connection::writeMessage(const struct iovec *iov, int iovcnt)
+{
+    size_t len = 0;
+
+    assert(iov != NULL);
+    assert(socketDescriptor != -1);
+
+    for (int i = 0; i < iovcnt; i++) {
+        len += iov[i].iov_len;
+    }
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = (struct iovec *)iov;
+    msg.msg_iovlen = iovcnt;
+
+    size_t ret = sendmsg(socketDescriptor, &msg, 0);
+    if (ret != len) {
+        LOG_ERRNO("could not send all data, because sendmsg");
+        LOG_E("ret = %d", ret);
+        ret = -1;
+    }
+
+    return ret;
+}
+
+
 //------------------------------------------------------------------------------
 int Connection::waitData(int32_t timeout)
 {
     size_t ret;
-    struct timeval tv;
-    struct timeval *ptv = NULL;
-    fd_set readfds;
+    struct pollfd pfd;
 
     assert(socketDescriptor != -1);
 
-    if (timeout >= 0) {
-        // Calculate timeout value
-        tv.tv_sec = timeout / 1000;
-        tv.tv_usec = (timeout - (tv.tv_sec * 1000)) * 1000;
-        ptv = &tv;
+    if (rxLength > 0) {
+        return 0;
     }
 
-    FD_ZERO(&readfds);
-    FD_SET(socketDescriptor, &readfds);
-    ret = select(socketDescriptor + 1, &readfds, NULL, NULL, ptv);
+    pfd.fd = socketDescriptor;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    ret = poll(&pfd, 1, timeout >= 0 ? timeout : -1);
 
     // check for read error
     if ((int)ret == -1) {
-        LOG_ERRNO("select");
+        LOG_ERRNO("poll");
         return ret;
     } else if (ret == 0) {
-        LOG_E("select() timed out");
+        LOG_E("poll() timed out");
         return -1;
     }
 
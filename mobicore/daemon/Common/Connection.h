@@ -43,8 +43,13 @@
 
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 
+/** Bytes received ahead of the caller's reads. Large enough for any command
+ * or response structure exchanged with the daemon. */
+#define CONNECTION_RX_BUFFER_SIZE   256
+
 
 class Connection
 {
@@ -53,6 +58,7 @@ public:
     int32_t socketDescriptor; /**< Local socket descriptor */
     void *connectionData; /**< reference to data related with the connection */
     bool detached; /**< Connection state */
+    bool readAhead; /**< Receive pending bytes beyond a read into rxBuffer */
 
     Connection(void);
 
@@ -89,6 +95,25 @@ public:
      */
     virtual size_t readData(void *buffer, uint32_t len);
 
+    /**
+     * Check if bytes have been received ahead of the last read. The
+     * socket will not report them as readable again.
+     *
+     * @return true if readData() can return data without a syscall.
+     */
+    virtual bool hasBufferedData(void);
+
+    /**
+     * Look at pending bytes without removing them from the connection.
+     * Does not block.
+     *
+     * @param buffer    Pointer to destination buffer.
+     * @param len       Number of bytes to peek.
+     * @return Number of bytes available, at most len.
+     * @return -1 if nothing is pending or the socket failed.
+     */
+    virtual size_t peekData(void *buffer, uint32_t len);
+
     /**
      * Write bytes to the connection.
      *
@@ -99,6 +124,16 @@ public:
      */
     virtual size_t writeData(void *buffer, uint32_t len);
 
+    /**
+     * Write a message made of several buffers with a single syscall.
+     *
+     * @param iov       Buffers to send, in order.
+     * @param iovcnt    Number of buffers.
+     * @return Number of bytes written.
+     * @return -1 if not all bytes could be written.
+     */
+    virtual size_t writeMessage(const struct iovec *iov, int iovcnt);
+
     /**
      * Wait for data to be available.
      *
@@ -122,6 +157,17 @@ public:
      */
     virtual bool getPeerCredentials(struct ucred &cr);
 
+private:
+    uint8_t rxBuffer[CONNECTION_RX_BUFFER_SIZE]; /**< Bytes received but not read yet */
+    uint32_t rxOffset; /**< Start of unread bytes in rxBuffer */
+    uint32_t rxLength; /**< Number of unread bytes in rxBuffer */
+
+    /**
+     * Receive from the socket into buffer, spilling whatever else is
+     * pending into rxBuffer with the same recvmsg().
+     */
+    size_t receive(void *buffer, uint32_t len, int32_t timeout);
+
 };
 
 typedef std::list<Connection *>         connectionList_t;
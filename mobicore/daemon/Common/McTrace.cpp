@@ -0,0 +1,443 @@
+/** @addtogroup MCD_MCDIMPL_DAEMON_SRV
+ * @{
+ * @file
+ *
+ * Request tracing (per-thread event rings and Chrome trace exporter).
+ *
+ * Copyright (c) 2013 TRUSTONIC LIMITED
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the TRUSTONIC LIMITED nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include "McTrace.h"
+
+#include "log.h"
+
+/** Events per thread, must be a power of two. */
+#define MC_TRACE_RING_SIZE  4096
+
+/** Period of the exporter thread. */
+#define MC_TRACE_EXPORT_INTERVAL_US  20000
+
+typedef struct {
+    uint64_t    timestamp; /**< CLOCK_MONOTONIC in ns */
+    uint32_t    traceId;
+    uint32_t    arg;
+    pid_t       tid;
+    uint16_t    event;
+    char        phase;
+} mcTraceRecord_t;
+
+/**
+ * Event ring of one thread.
+ * Only the owning thread writes records and head. The exporter reads them
+ * and owns tail, it runs with exportLock held. Rings are never freed, the
+ * ring of a terminated thread is taken over by the next new one. Records
+ * carry the thread ID, so that works before the ring has been exported.
+ */
+typedef struct mcTraceRing {
+    struct mcTraceRing  *next;
+    pid_t               tid;
+    bool                active; /**< Owning thread still running */
+    uint32_t            currentId; /**< Request of the owning thread */
+    uint32_t            head; /**< Records written */
+    uint32_t            tail; /**< Records exported */
+    mcTraceRecord_t     records[MC_TRACE_RING_SIZE];
+} mcTraceRing_t;
+
+static const char *const traceEventNames[] = {
+    "client send",
+    "daemon dequeue",
+    "mcp wait",
+    "siq received",
+    "notification forwarded",
+    "client wake",
+};
+
+static pthread_once_t traceOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t traceKey;
+static pthread_mutex_t exportLock = PTHREAD_MUTEX_INITIALIZER;
+static mcTraceRing_t *traceRings = NULL;
+static const char *traceFile = NULL;
+static uint32_t traceIdCounter = 0;
+
+
+//------------------------------------------------------------------------------
+static void releaseRing(void *data)
+{
+    mcTraceRing_t *ring = (mcTraceRing_t *)data;
+    __atomic_store_n(&ring->active, false, __ATOMIC_RELEASE);
+}
+
+
+//------------------------------------------------------------------------------
+static void *exportThread(void *arg)
+{
+    (void)arg;
+    for (;;) {
+        usleep(MC_TRACE_EXPORT_INTERVAL_US);
+        mcTraceFlush();
+    }
+    return NULL;
+}
+
+
+//------------------------------------------------------------------------------
+static void initTrace(void)
+{
+    traceFile = getenv(ENV_MC_TRACE_FILE);
+    if (traceFile == NULL || traceFile[0] == '\0') {
+        traceFile = NULL;
+        return;
+    }
+    if (pthread_key_create(&traceKey, releaseRing) != 0) {
+        LOG_E("cannot create trace key, tracing disabled");
+        traceFile = NULL;
+        return;
+    }
+    // Drain the rings in the background, recording never waits for the file
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, exportThread, NULL) == 0) {
+        pthread_detach(thread);
+    } else {
+        LOG_W("cannot start trace exporter, events are exported on close only");
+    }
+    atexit(mcTraceFlush);
+    LOG_I("Tracing requests to %s", traceFile);
+}
+
+
+//------------------------------------------------------------------------------
+static mcTraceRing_t *getRing(void)
+{
+    mcTraceRing_t *ring = (mcTraceRing_t *)pthread_getspecific(traceKey);
+    if (ring != NULL) {
+        return ring;
+    }
+
+    // Take over the ring of a terminated thread
+    pid_t tid = (pid_t)syscall(__NR_gettid);
+    for (ring = __atomic_load_n(&traceRings, __ATOMIC_ACQUIRE); ring != NULL; ring = ring->next) {
+        bool active = false;
+        if (__atomic_compare_exchange_n(&ring->active, &active, true, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            ring->tid = tid;
+            ring->currentId = 0;
+            break;
+        }
+    }
+    if (ring == NULL) {
+        ring = (mcTraceRing_t *)calloc(1, sizeof(mcTraceRing_t));
+        if (ring == NULL) {
+            return NULL;
+        }
+        ring->tid = tid;
+        ring->active = true;
+        ring->next = __atomic_load_n(&traceRings, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&traceRings, &ring->next, ring, true,
+                                            __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    }
+    pthread_setspecific(traceKey, ring);
+
+    return ring;
+}
+
+
+//------------------------------------------------------------------------------
+bool mcTraceEnabled(void)
+{
+    pthread_once(&traceOnce, initTrace);
+    return traceFile != NULL;
+}
+
+
+//------------------------------------------------------------------------------
+uint32_t mcTraceNewId(void)
+{
+    uint32_t id;
+    do {
+        id = (((uint32_t)getpid() & 0xFFFF) << 16)
+             | (__atomic_add_fetch(&traceIdCounter, 1, __ATOMIC_RELAXED) & 0xFFFF);
+    } while (id == 0);
+    return id;
+}
+
+
+//------------------------------------------------------------------------------
+void mcTraceSetCurrentId(uint32_t traceId)
+{
+    if (!mcTraceEnabled()) {
+        return;
+    }
+    mcTraceRing_t *ring = getRing();
+    if (ring != NULL) {
+        ring->currentId = traceId;
+    }
+}
+
+
+//------------------------------------------------------------------------------
+uint32_t mcTraceCurrentId(void)
+{
+    if (!mcTraceEnabled()) {
+        return 0;
+    }
+    mcTraceRing_t *ring = getRing();
+    return (ring != NULL) ? ring->currentId : 0;
+}
+
+
+//------------------------------------------------------------------------------
+void mcTraceRecord(mcTraceEvent_t event, char phase, uint32_t traceId, uint32_t arg)
+{
+    if (!mcTraceEnabled()) {
+        return;
+    }
+    mcTraceRing_t *ring = getRing();
+    if (ring == NULL) {
+        return;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    uint32_t head = ring->head;
+    mcTraceRecord_t *record = &ring->records[head & (MC_TRACE_RING_SIZE - 1)];
+    record->timestamp = (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+    record->traceId = traceId;
+    record->arg = arg;
+    record->tid = ring->tid;
+    record->event = (uint16_t)event;
+    record->phase = phase;
+    // Publish the record to the exporter
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+
+//------------------------------------------------------------------------------
+static void writeTrace(int fd, const char *buf, size_t len)
+{
+    if (write(fd, buf, len) != (ssize_t)len) {
+        LOG_ERRNO("writing trace file");
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// snprintf() is several times slower and the exporter competes with the
+// traced requests for CPU time
+static char *appendString(char *p, const char *str)
+{
+    while (*str != '\0') {
+        *p++ = *str++;
+    }
+    return p;
+}
+
+
+//------------------------------------------------------------------------------
+static char *appendDecimal(char *p, uint64_t value, int minDigits)
+{
+    char digits[20];
+    int n = 0;
+    do {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0 || n < minDigits);
+    while (n > 0) {
+        *p++ = digits[--n];
+    }
+    return p;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * Format one record as Chrome trace event.
+ * @return end of the formatted event, at most 256 bytes after p.
+ */
+static char *formatRecord(char *p, const mcTraceRecord_t *r, pid_t pid)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    p = appendString(p, "{\"name\":\"");
+    p = appendString(p, r->event < sizeof(traceEventNames) / sizeof(traceEventNames[0]) ?
+                     traceEventNames[r->event] : "unknown");
+    p = appendString(p, "\",\"cat\":\"mobicore\",\"ph\":\"");
+    *p++ = r->phase;
+    p = appendString(p, r->phase == MC_TRACE_INSTANT ? "\",\"s\":\"t\",\"ts\":" : "\",\"ts\":");
+    // Microseconds with nanosecond fraction
+    p = appendDecimal(p, r->timestamp / 1000, 1);
+    *p++ = '.';
+    p = appendDecimal(p, r->timestamp % 1000, 3);
+    p = appendString(p, ",\"pid\":");
+    p = appendDecimal(p, (uint32_t)pid, 1);
+    p = appendString(p, ",\"tid\":");
+    p = appendDecimal(p, (uint32_t)r->tid, 1);
+    p = appendString(p, ",\"args\":{\"traceId\":\"0x");
+    for (int shift = 28; shift >= 0; shift -= 4) {
+        *p++ = hex[(r->traceId >> shift) & 0xF];
+    }
+    p = appendString(p, "\",\"arg\":");
+    p = appendDecimal(p, r->arg, 1);
+    return appendString(p, "}}");
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * Append the events of one ring to buf, writing buf to fd whenever it fills.
+ * Records the owner overwrote while they were copied are dropped.
+ * @param separate Whether an event precedes the next one, updated.
+ */
+static void exportRing(int fd, mcTraceRing_t *ring, char *buf, size_t size, size_t *len,
+                       bool *separate)
+{
+    mcTraceRecord_t records[64];
+    pid_t pid = getpid();
+
+    for (;;) {
+        uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        if (head - ring->tail > MC_TRACE_RING_SIZE) {
+            LOG_W("trace ring overran, %u events lost",
+                  head - ring->tail - MC_TRACE_RING_SIZE);
+            __atomic_store_n(&ring->tail, head - MC_TRACE_RING_SIZE, __ATOMIC_RELEASE);
+        }
+        uint32_t count = head - ring->tail;
+        if (count == 0) {
+            break;
+        }
+        if (count > sizeof(records) / sizeof(records[0])) {
+            count = sizeof(records) / sizeof(records[0]);
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            records[i] = ring->records[(ring->tail + i) & (MC_TRACE_RING_SIZE - 1)];
+        }
+
+        // The owner may have wrapped around while we were copying
+        uint32_t first = 0;
+        head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        if (head - ring->tail >= MC_TRACE_RING_SIZE) {
+            first = head - ring->tail - MC_TRACE_RING_SIZE + 1;
+        }
+
+        for (uint32_t i = first; i < count; i++) {
+            const mcTraceRecord_t *r = &records[i];
+            if (*len + 2 + 256 > size) {
+                writeTrace(fd, buf, *len);
+                *len = 0;
+            }
+            char *p = buf + *len;
+            if (*separate) {
+                p = appendString(p, ",\n");
+            }
+            *len = formatRecord(p, r, pid) - buf;
+            *separate = true;
+        }
+        __atomic_store_n(&ring->tail, ring->tail + count, __ATOMIC_RELEASE);
+    }
+}
+
+
+//------------------------------------------------------------------------------
+void mcTraceFlush(void)
+{
+    if (!mcTraceEnabled()) {
+        return;
+    }
+
+    pthread_mutex_lock(&exportLock);
+    do {
+        mcTraceRing_t *ring;
+        for (ring = __atomic_load_n(&traceRings, __ATOMIC_ACQUIRE); ring != NULL; ring = ring->next) {
+            if (__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) != ring->tail) {
+                break;
+            }
+        }
+        if (ring == NULL) {
+            // Nothing new
+            break;
+        }
+
+        int fd = open(traceFile, O_RDWR | O_CREAT | O_APPEND, 0644);
+        if (fd < 0) {
+            LOG_ERRNO("opening trace file");
+            break;
+        }
+        // Other processes append to the same file
+        flock(fd, LOCK_EX);
+
+        // Every flush leaves the array closed, so the file stays valid JSON
+        // if the process is killed. The next one reopens it.
+        static const char arrayEnd[] = "\n]\n";
+        const size_t endLen = sizeof(arrayEnd) - 1;
+        char buf[16384];
+        size_t len = 0;
+        bool separate = false;
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            st.st_size = -1;
+        }
+        if (st.st_size == 0) {
+            len = appendString(buf, "[\n") - buf;
+        } else if (st.st_size >= (off_t)endLen
+                && pread(fd, buf, endLen, st.st_size - endLen) == (ssize_t)endLen
+                && memcmp(buf, arrayEnd, endLen) == 0
+                && ftruncate(fd, st.st_size - endLen) == 0) {
+            separate = st.st_size > (off_t)(endLen + 2);
+        } else {
+            LOG_W("trace file does not end with a closed array, appending anyway");
+        }
+        for (ring = __atomic_load_n(&traceRings, __ATOMIC_ACQUIRE); ring != NULL; ring = ring->next) {
+            exportRing(fd, ring, buf, sizeof(buf), &len, &separate);
+        }
+        if (len + endLen > sizeof(buf)) {
+            writeTrace(fd, buf, len);
+            len = 0;
+        }
+        len = appendString(buf + len, arrayEnd) - buf;
+        writeTrace(fd, buf, len);
+
+        flock(fd, LOCK_UN);
+        close(fd);
+    } while (false);
+    pthread_mutex_unlock(&exportLock);
+}
+
+/** @} */
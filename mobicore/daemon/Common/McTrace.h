@@ -0,0 +1,106 @@
+/** @addtogroup MCD_MCDIMPL_DAEMON_SRV
+ * @{
+ * @file
+ *
+ * Request tracing across client library, daemon and notification path.
+ *
+ * Copyright (c) 2013 TRUSTONIC LIMITED
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the TRUSTONIC LIMITED nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef MCTRACE_H_
+#define MCTRACE_H_
+
+#include <stdint.h>
+
+/** Environment variable naming the trace file. Tracing is off if unset. */
+#define ENV_MC_TRACE_FILE "MC_TRACE_FILE"
+
+/** Events recorded along the path of a request. */
+typedef enum {
+    MC_TRACE_CLIENT_SEND            = 0, /**< Command written to the daemon socket */
+    MC_TRACE_DAEMON_DEQUEUE         = 1, /**< Command read by the daemon until it is handled */
+    MC_TRACE_MCP_WAIT               = 2, /**< Daemon waits for the MCP answer of <t-base */
+    MC_TRACE_SIQ                    = 3, /**< Notification taken from the NQ after an S-SIQ */
+    MC_TRACE_NOTIFICATION_FORWARD   = 4, /**< Notification written to the client session socket */
+    MC_TRACE_CLIENT_WAKE            = 5, /**< Client read a notification of the session */
+} mcTraceEvent_t;
+
+/** Chrome trace event phases. */
+#define MC_TRACE_BEGIN      'B'
+#define MC_TRACE_END        'E'
+#define MC_TRACE_INSTANT    'i'
+
+/**
+ * Check if tracing is enabled for this process.
+ * @return true if ENV_MC_TRACE_FILE was set when first called.
+ */
+bool mcTraceEnabled(void);
+
+/**
+ * Allocate a new trace ID.
+ * The upper half is the process ID, so IDs of different clients do not
+ * collide in a shared trace file.
+ * @return trace ID, never 0.
+ */
+uint32_t mcTraceNewId(void);
+
+/**
+ * Set the trace ID of the request the calling thread works on.
+ * @param traceId Trace ID or 0 if none.
+ */
+void mcTraceSetCurrentId(uint32_t traceId);
+
+/**
+ * Get the trace ID of the request the calling thread works on.
+ * @return trace ID or 0 if none or tracing is disabled.
+ */
+uint32_t mcTraceCurrentId(void);
+
+/**
+ * Record an event in the ring of the calling thread.
+ * Does not block and does not take any lock once the thread has its ring.
+ * If the ring is full the oldest unexported events are overwritten.
+ * @param event Event type.
+ * @param phase MC_TRACE_BEGIN, MC_TRACE_END or MC_TRACE_INSTANT.
+ * @param traceId Trace ID of the request, 0 if unknown.
+ * @param arg Command ID or session ID the event refers to.
+ */
+void mcTraceRecord(mcTraceEvent_t event, char phase, uint32_t traceId, uint32_t arg);
+
+/**
+ * Append all events not exported yet to the trace file.
+ * A background thread also does this periodically while tracing is enabled.
+ * The file is in Chrome trace JSON array format, several processes may
+ * append to the same file. The array is closed after every flush.
+ */
+void mcTraceFlush(void);
+
+#endif /* MCTRACE_H_ */
+
+/** @} */
@@ -0,0 +1,210 @@
+/** @addtogroup MCD_MCDIMPL_DAEMON_DEV
+ * @{
+ * @file
+ *
+ * Copyright (c) 2013 TRUSTONIC LIMITED
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the TRUSTONIC LIMITED nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "AdaptiveScheduler.h"
+#include <string.h>
+
+
+//------------------------------------------------------------------------------
+AdaptiveScheduler::AdaptiveScheduler(
+    const schedulerTuning_t *tuning,
+    uint64_t                nowUs
+)
+{
+    if (tuning != NULL) {
+        this->tuning = *tuning;
+    } else {
+        this->tuning.timeslice = SCHED_TIMESLICE;
+        this->tuning.minTimeslice = SCHED_MIN_TIMESLICE;
+        this->tuning.maxTimeslice = SCHED_MAX_TIMESLICE;
+        this->tuning.busyYieldUs = SCHED_BUSY_YIELD_US;
+        this->tuning.minBackoffUs = SCHED_MIN_BACKOFF_US;
+        this->tuning.maxBackoffUs = SCHED_MAX_BACKOFF_US;
+        this->tuning.statsIntervalUs = SCHED_STATS_INTERVAL_US;
+    }
+    // A slice needs at least one yield
+    if (this->tuning.minTimeslice == 0) {
+        this->tuning.minTimeslice = 1;
+    }
+    if (this->tuning.maxTimeslice < this->tuning.minTimeslice) {
+        this->tuning.maxTimeslice = this->tuning.minTimeslice;
+    }
+    if (this->tuning.timeslice < this->tuning.minTimeslice) {
+        this->tuning.timeslice = this->tuning.minTimeslice;
+    }
+    if (this->tuning.timeslice > this->tuning.maxTimeslice) {
+        this->tuning.timeslice = this->tuning.maxTimeslice;
+    }
+
+    timeslice = this->tuning.timeslice;
+    remaining = timeslice;
+    sliceYields = 0;
+    sliceBusyYields = 0;
+    backoff = 0;
+    backoffDone = false;
+    memset(&current, 0, sizeof(current));
+    intervalStartUs = nowUs;
+    intervalStartCpuUs = 0;
+}
+
+
+//------------------------------------------------------------------------------
+bool AdaptiveScheduler::nsiqDue(
+    void
+)
+{
+    return (remaining == 0);
+}
+
+
+//------------------------------------------------------------------------------
+void AdaptiveScheduler::nsiqSent(
+    void
+)
+{
+    current.nsiqs++;
+
+    if ((sliceYields > 0) && (sliceBusyYields == sliceYields)) {
+        // SWd had work all the slice long, interrupt it less often
+        timeslice *= 2;
+        if (timeslice > tuning.maxTimeslice) {
+            timeslice = tuning.maxTimeslice;
+        }
+    } else if (sliceBusyYields == 0) {
+        // No work found at all, let the SWd decide sooner and pause longer
+        // before each yield
+        timeslice /= 2;
+        if (timeslice < tuning.minTimeslice) {
+            timeslice = tuning.minTimeslice;
+        }
+        if (backoff == 0) {
+            backoff = tuning.minBackoffUs;
+        } else {
+            backoff *= 2;
+        }
+        if (backoff > tuning.maxBackoffUs) {
+            backoff = tuning.maxBackoffUs;
+        }
+    }
+
+    remaining = timeslice;
+    sliceYields = 0;
+    sliceBusyYields = 0;
+}
+
+
+//------------------------------------------------------------------------------
+uint32_t AdaptiveScheduler::getBackoff(
+    void
+)
+{
+    return backoffDone ? 0 : backoff;
+}
+
+
+//------------------------------------------------------------------------------
+void AdaptiveScheduler::backedOff(
+    uint64_t us
+)
+{
+    current.backoffs++;
+    current.backoffUs += us;
+    backoffDone = true;
+}
+
+
+//------------------------------------------------------------------------------
+void AdaptiveScheduler::yielded(
+    uint64_t us
+)
+{
+    current.yields++;
+    current.swdUs += us;
+    sliceYields++;
+    if (remaining > 0) {
+        remaining--;
+    }
+    backoffDone = false;
+
+    if (us >= tuning.busyYieldUs) {
+        current.busyYields++;
+        sliceBusyYields++;
+        // Work is back, stop pausing
+        backoff = 0;
+    }
+}
+
+
+//------------------------------------------------------------------------------
+void AdaptiveScheduler::idleWaited(
+    uint64_t us
+)
+{
+    current.idleWaits++;
+    current.idleUs += us;
+    // Leaving IDLE means the SWd got new work
+    backoff = 0;
+    backoffDone = false;
+}
+
+
+//------------------------------------------------------------------------------
+bool AdaptiveScheduler::intervalElapsed(
+    uint64_t nowUs
+)
+{
+    return (nowUs - intervalStartUs >= tuning.statsIntervalUs);
+}
+
+
+//------------------------------------------------------------------------------
+void AdaptiveScheduler::closeInterval(
+    uint64_t            nowUs,
+    uint64_t            cpuUs,
+    schedulerStats_t    *stats
+)
+{
+    current.timeslice = timeslice;
+    current.intervalUs = nowUs - intervalStartUs;
+    current.cpuUs = cpuUs - intervalStartCpuUs;
+    if (stats != NULL) {
+        *stats = current;
+    }
+
+    memset(&current, 0, sizeof(current));
+    intervalStartUs = nowUs;
+    intervalStartCpuUs = cpuUs;
+}
+
+/** @} */
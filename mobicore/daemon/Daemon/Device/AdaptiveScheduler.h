@@ -0,0 +1,181 @@
+/** @addtogroup MCD_MCDIMPL_DAEMON_DEV
+ * @{
+ * @file
+ *
+ * Copyright (c) 2013 TRUSTONIC LIMITED
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the TRUSTONIC LIMITED nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef ADAPTIVESCHEDULER_H_
+#define ADAPTIVESCHEDULER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SCHED_TIMESLICE             5       /**< Yields between two N-SIQs at start */
+#define SCHED_MIN_TIMESLICE         2       /**< Least yields between two N-SIQs */
+#define SCHED_MAX_TIMESLICE         40      /**< Most yields between two N-SIQs */
+#define SCHED_BUSY_YIELD_US         20      /**< Shorter yields found no SWd work */
+#define SCHED_MIN_BACKOFF_US        50      /**< First pause of sparse SWd work */
+#define SCHED_MAX_BACKOFF_US        1000    /**< Longest pause between two yields */
+#define SCHED_STATS_INTERVAL_US     10000000 /**< Length of a statistics interval */
+
+/**
+ * Tuning of the adaptive scheduler.
+ */
+typedef struct {
+    uint32_t timeslice;         /**< Yields between two N-SIQs at start. */
+    uint32_t minTimeslice;      /**< Least yields between two N-SIQs. */
+    uint32_t maxTimeslice;      /**< Most yields between two N-SIQs. */
+    uint32_t busyYieldUs;       /**< A yield this long found the SWd busy. */
+    uint32_t minBackoffUs;      /**< First pause after a slice without SWd work. */
+    uint32_t maxBackoffUs;      /**< Longest pause between two yields. */
+    uint32_t statsIntervalUs;   /**< Length of a statistics interval. */
+} schedulerTuning_t;
+
+/**
+ * Scheduler activity of one statistics interval.
+ */
+typedef struct {
+    uint32_t yields;            /**< Yields to the SWd. */
+    uint32_t busyYields;        /**< Yields which found the SWd busy. */
+    uint32_t nsiqs;             /**< N-SIQs sent at the end of a slice. */
+    uint32_t idleWaits;         /**< Waits for the SWd to leave IDLE. */
+    uint32_t backoffs;          /**< Pauses between yields. */
+    uint32_t timeslice;         /**< Yields between N-SIQs at the end. */
+    uint64_t intervalUs;        /**< Length of the interval. */
+    uint64_t swdUs;             /**< Time spent in yields. */
+    uint64_t idleUs;            /**< Time waited for the SWd to leave IDLE. */
+    uint64_t backoffUs;         /**< Time paused between yields. */
+    uint64_t cpuUs;             /**< CPU time of the scheduler thread. */
+} schedulerStats_t;
+
+/** Decides the yield and N-SIQ cadence of the NWd scheduler thread.
+ *
+ * The scheduler thread reports how long each yield took. A yield shorter
+ * than busyYieldUs found no work in the SWd. A slice of busy yields doubles
+ * the number of yields until the next N-SIQ, a slice without any halves it
+ * and starts an exponentially growing pause before each yield, which ends
+ * with the first busy yield or when the SWd goes IDLE.
+ *
+ * The class only does the bookkeeping, all times are passed in by the
+ * caller, so it can be driven by a simulated SWd as well. It is not thread
+ * safe.
+ */
+class AdaptiveScheduler
+{
+
+public:
+
+    /** Creates the scheduler.
+     *
+     * @param tuning Tuning, NULL for the SCHED_ defaults.
+     * @param nowUs Start of the first statistics interval.
+     */
+    AdaptiveScheduler(
+        const schedulerTuning_t *tuning,
+        uint64_t                nowUs
+    );
+
+    /** Returns true if the slice is used up and an N-SIQ has to be sent. */
+    bool nsiqDue(
+        void
+    );
+
+    /** Starts the next slice after an N-SIQ and adapts its length. */
+    void nsiqSent(
+        void
+    );
+
+    /** Returns the pause before the next yield, 0 to yield right away. */
+    uint32_t getBackoff(
+        void
+    );
+
+    /** Records a pause before a yield.
+     *
+     * @param us Time paused, shorter than requested if woken up by a SIQ.
+     */
+    void backedOff(
+        uint64_t us
+    );
+
+    /** Records a yield to the SWd.
+     *
+     * @param us Time until the SWd handed back control.
+     */
+    void yielded(
+        uint64_t us
+    );
+
+    /** Records a wait for the SWd to leave IDLE.
+     *
+     * @param us Time waited.
+     */
+    void idleWaited(
+        uint64_t us
+    );
+
+    /** Returns true if the current statistics interval is over.
+     *
+     * @param nowUs Current time.
+     */
+    bool intervalElapsed(
+        uint64_t nowUs
+    );
+
+    /** Ends the current statistics interval and starts the next one.
+     *
+     * @param nowUs Current time.
+     * @param cpuUs CPU time of the scheduler thread so far.
+     * @param[out] stats Activity of the interval.
+     */
+    void closeInterval(
+        uint64_t            nowUs,
+        uint64_t            cpuUs,
+        schedulerStats_t    *stats
+    );
+
+private:
+
+    schedulerTuning_t   tuning;
+    schedulerStats_t    current;
+    uint32_t            timeslice; /**< Yields per slice. */
+    uint32_t            remaining; /**< Yields left in the slice. */
+    uint32_t            sliceYields;
+    uint32_t            sliceBusyYields;
+    uint32_t            backoff; /**< Pause before each yield, 0 for none. */
+    bool                backoffDone; /**< Paused since the last yield. */
+    uint64_t            intervalStartUs;
+    uint64_t            intervalStartCpuUs;
+
+};
+
+#endif /* ADAPTIVESCHEDULER_H_ */
+
+/** @} */
@@ -22,4 +22,7 @@ LOCAL_SRC_FILES += $(DEVICE_PATH)/DeviceIrqHandler.cpp \
 	$(DEVICE_PATH)/TAExitHandler.cpp \
 	$(DEVICE_PATH)/MobiCoreDevice.cpp \
 	$(DEVICE_PATH)/NotificationQueue.cpp \
-	$(DEVICE_PATH)/TrustletSession.cpp
+	$(DEVICE_PATH)/TrustletSession.cpp \
+	$(DEVICE_PATH)/TrustletSessionTable.cpp \
+	$(DEVICE_PATH)/ServiceWsmPins.cpp \
+	$(DEVICE_PATH)/AdaptiveScheduler.cpp
@@ -44,6 +44,7 @@
 #include "ExcDevice.h"
 #include "Connection.h"
 #include "TrustletSession.h"
+#include "McTrace.h"
 
 #include "MobiCoreDevice.h"
 #include "Mci/mci.h"
@@ -64,6 +65,7 @@ MobiCoreDevice::MobiCoreDevice()
     mcFault = false;
     mciReused = false;
     mcpMessage = NULL;
+    mcpTraceId = 0;
 }
 
 //------------------------------------------------------------------------------
@@ -81,16 +83,7 @@ MobiCoreDevice::~MobiCoreDevice()
 TrustletSession *MobiCoreDevice::getTrustletSession(
     uint32_t sessionId
 ) {
-    for (trustletSessionIterator_t iterator = trustletSessions.begin();
-         iterator != trustletSessions.end();
-         ++iterator)
-    {
-        TrustletSession *session = *iterator;
-        if (session->sessionId == sessionId) {
-            return session;
-        }
-    }
-    return NULL;
+    return trustletSessions.find(sessionId);
 }
 
 
@@ -231,39 +224,19 @@ void MobiCoreDevice::close(
     // TA, so we want to terminate the TA first and then the driver. This may
     // make this a bit easier for everbody.
 
-    trustletSessionList_t::reverse_iterator revIt = trustletSessions.rbegin();
-    while (revIt != trustletSessions.rend())
+    trustletSessionList_t sessions;
+    trustletSessions.getSessions(connection, sessions);
+
+    for (trustletSessionList_t::reverse_iterator revIt = sessions.rbegin();
+         revIt != sessions.rend();
+         ++revIt)
     {
         TrustletSession *session = *revIt;
 
-        // wiredness of reverse iterators
-        // * is is incremented to get the next lowe element
-        // * to delete something from the list, we need the "normal" iterator.
-        //   This is simpy "one off" the current revIt. So we can savely use
-        //   the increment below in both cases.
-        revIt++;
-
-        if (session->deviceConnection == connection)
-        {
-            // close session, log any error but ignore it.
-            //mcResult_t mcRet = closeSessionInternal(session);
-            mcResult_t mcRet = closeSession(connection, session->sessionId);
-            if (mcRet != MC_MCP_RET_OK) {
-                LOG_I("device closeSession failed with %d", mcRet);
-            }
-
-            // removing an element from the list it tricky. Convert the revIt
-            // to a "normal" iterator. Remember here that the revIt is one off,
-            // but we have done an increment above, so we are fine here. So
-            // after we have the normal iterator, ude it to delete and then
-            // convert the returned iterator back to a reverse iterator, which
-            // we will use for the loop.
-            //trustletSessionIterator_t it = revIt.base();
-            //it = trustletSessions.erase(it); // delete
-            //revIt =  trustletSessionList_t::reverse_iterator(it);
-
-            // free object
-            //delete session;
+        // close session, log any error but ignore it.
+        mcResult_t mcRet = closeSession(connection, session->sessionId);
+        if (mcRet != MC_MCP_RET_OK) {
+            LOG_I("device closeSession failed with %d", mcRet);
         }
     }
 
@@ -394,11 +367,18 @@ bool MobiCoreDevice::waitMcpNotification(void)
 //------------------------------------------------------------------------------
 mcResult_t MobiCoreDevice::mshNotifyAndWait()
 {
+    uint32_t traceId = mcTraceCurrentId();
+
     // Notify MC about the availability of a new command inside the MCP buffer
+    mcTraceRecord(MC_TRACE_MCP_WAIT, MC_TRACE_BEGIN, traceId, SID_MCP);
+    mcpTraceId = traceId;
     notify(SID_MCP);
 
     // Wait till response from MSH is available
-    if (!waitMcpNotification())
+    bool answered = waitMcpNotification();
+    mcpTraceId = 0;
+    mcTraceRecord(MC_TRACE_MCP_WAIT, MC_TRACE_END, traceId, SID_MCP);
+    if (!answered)
     {
         LOG_E("waiting for MCP notification failed");
         return MC_DRV_ERR_DAEMON_MCI_ERROR;
@@ -424,6 +404,13 @@ mcResult_t MobiCoreDevice::openSession(
             // Check if we have a cont WSM or normal one
             if (findContiguousWsm(tciHandle,
                                   deviceConnection->socketDescriptor, &tci, &len)) {
+                // Clients carve small TCIs out of larger contiguous WSM at page offsets
+                if (tciOffset >= len) {
+                    LOG_E("TCI offset %u outside of contiguous WSM %u", tciOffset, tciHandle);
+                    return MC_DRV_ERR_TCI_GREATER_THAN_WSM;
+                }
+                tci += tciOffset;
+                len -= tciOffset;
                 mcpMessage->cmdOpen.wsmTypeTci = WSM_CONTIGUOUS;
             mcpMessage->cmdOpen.adrTciBuffer = tci;
                 mcpMessage->cmdOpen.ofsTciBuffer = 0;
@@ -520,7 +507,7 @@ mcResult_t MobiCoreDevice::openSession(
         LOG_I(" Trusted App has gp_level %d",trustletSession->gp_level);
         trustletSession->sessionState = TrustletSession::TS_TA_RUNNING;
 
-        trustletSessions.push_back(trustletSession);
+        trustletSessions.add(trustletSession);
 
         if (tciHandle != 0 && tciLen != 0) {
             trustletSession->addBulkBuff(new CWsm((void *)(uintptr_t)pLoadDataOpenSession->offs, pLoadDataOpenSession->len, tciHandle, 0));
@@ -600,21 +587,10 @@ TrustletSession *MobiCoreDevice::registerTrustletConnection(
           cmdNqConnect->sessionId,
           cmdNqConnect->sessionMagic);
 
-    for (trustletSessionIterator_t iterator = trustletSessions.begin();
-         iterator != trustletSessions.end();
-         ++iterator)
-    {
-        TrustletSession *session = *iterator;
-
-        if (session != (TrustletSession *)(uintptr_t) (cmdNqConnect->deviceSessionId)) {
-            continue;
-        }
-
-        if ( (session->sessionMagic != cmdNqConnect->sessionMagic)
-                || (session->sessionId != cmdNqConnect->sessionId)) {
-            continue;
-        }
-
+    TrustletSession *session = trustletSessions.find(cmdNqConnect->sessionId);
+    if ((session != NULL)
+            && ((uint32_t)(uintptr_t)session == cmdNqConnect->deviceSessionId)
+            && (session->sessionMagic == cmdNqConnect->sessionMagic)) {
         session->notificationConnection = connection;
 
         LOG_I(" Found Service session, registered connection.");
@@ -646,7 +622,7 @@ mcResult_t MobiCoreDevice::closeSession(
         mutex_connection.lock();
         LOG_I(" Closing GP TA session...");
         // Disconnect client from this session
-        session->deviceConnection = NULL;
+        trustletSessions.setDeviceConnection(session, NULL);
         // Free connection, i.e. close nq socket
         delete session->notificationConnection;
         session->notificationConnection = NULL;
@@ -690,17 +666,10 @@ mcResult_t MobiCoreDevice::closeSession(
     }
 
     // remove sesson from list.
-    for (trustletSessionIterator_t iterator = trustletSessions.begin();
-         iterator != trustletSessions.end();
-         ++iterator)
-    {
-        if (session == *iterator)
-        {
-            trustletSessions.erase(iterator);
-            delete session;
-            break;
-        }
-    }
+    mutex_sessions.lock();
+    trustletSessions.remove(session);
+    delete session;
+    mutex_sessions.unlock();
 
     return MC_MCP_RET_OK;
 }
@@ -718,14 +687,20 @@ mcResult_t MobiCoreDevice::notify(
     Connection  *deviceConnection,
     uint32_t    sessionId
 ) {
+    // NOTIFY runs without mutex_mcp, keep the session alive until it is sent
+    mutex_sessions.lock();
     TrustletSession *session = findSession(deviceConnection,sessionId);
     if (session == NULL)
     {
+        mutex_sessions.unlock();
         LOG_E("cannot notify session with id=%d", sessionId);
         return MC_DRV_ERR_DAEMON_UNKNOWN_SESSION;
     }
 
+    // The answer of the TA is forwarded as part of this request
+    session->traceId = mcTraceCurrentId();
     notify(sessionId);
+    mutex_sessions.unlock();
 
     return MC_DRV_OK;
 }
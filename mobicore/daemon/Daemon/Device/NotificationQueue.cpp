@@ -50,33 +50,60 @@ NotificationQueue::NotificationQueue(
 
 
 //------------------------------------------------------------------------------
-void NotificationQueue::putNotification(
+bool NotificationQueue::putNotification(
     notification_t *notification
 )
 {
-    mutex.lock();
-    if ((out->hdr.writeCnt - out->hdr.readCnt) < out->hdr.queueSize) {
-        out->notification[out->hdr.writeCnt & (out->hdr.queueSize - 1)]
+    bool ret = false;
+    producerMutex.lock();
+    // Only this side writes writeCnt, the consumer publishes readCnt.
+    uint32_t writeCnt = out->hdr.writeCnt;
+    uint32_t readCnt = __atomic_load_n(&out->hdr.readCnt, __ATOMIC_ACQUIRE);
+    if ((writeCnt - readCnt) < out->hdr.queueSize) {
+        out->notification[writeCnt & (out->hdr.queueSize - 1)]
         = *notification;
-        out->hdr.writeCnt++;
+        // Element must be visible before the consumer sees the new count.
+        __atomic_store_n(&out->hdr.writeCnt, writeCnt + 1, __ATOMIC_RELEASE);
+        ret = true;
     }
-    mutex.unlock();
+    producerMutex.unlock();
+    return ret;
+}
+
+
+//------------------------------------------------------------------------------
+bool NotificationQueue::getNotification(
+    notification_t *notification
+)
+{
+    return getNotifications(notification, 1) == 1;
 }
 
 
 //------------------------------------------------------------------------------
-notification_t *NotificationQueue::getNotification(
-    void
+uint32_t NotificationQueue::getNotifications(
+    notification_t  *notifications,
+    uint32_t        maxCount
 )
 {
-    notification_t *ret = NULL;
-    mutex.lock();
-    if ((in->hdr.writeCnt - in->hdr.readCnt) > 0) {
-        ret = &(in->notification[in->hdr.readCnt & (in->hdr.queueSize - 1)]);
-        in->hdr.readCnt++;
+    // Only this side writes readCnt, the producer publishes writeCnt.
+    uint32_t readCnt = in->hdr.readCnt;
+    uint32_t writeCnt = __atomic_load_n(&in->hdr.writeCnt, __ATOMIC_ACQUIRE);
+    uint32_t count = writeCnt - readCnt;
+    if (count > maxCount) {
+        count = maxCount;
     }
-    mutex.unlock();
-    return ret;
+    if (count == 0) {
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        notifications[i] =
+            in->notification[(readCnt + i) & (in->hdr.queueSize - 1)];
+    }
+    // Slots are only released to the producer after they have been copied.
+    __atomic_store_n(&in->hdr.readCnt, readCnt + count, __ATOMIC_RELEASE);
+    return count;
 }
 
 /** @} */
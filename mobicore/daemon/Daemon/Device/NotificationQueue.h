@@ -61,27 +61,52 @@ public:
     );
 
     /** Places an element to the outgoing queue.
+     *
+     * The outgoing queue has a single consumer (the secure world), the
+     * producers are serialized among themselves since several daemon
+     * threads may notify concurrently.
      *
      * @param notification Data to be placed in queue.
+     * @return true if the element was queued, false if the queue is full.
+     */
+    bool putNotification(
+        notification_t *notification
+    );
+
+    /** Retrieves the first element from the incoming queue.
+     *
+     * Lock free, must only be called by the single consumer of the
+     * incoming queue. The element is copied out before the slot is handed
+     * back to the secure world.
+     *
+     * @param notification Buffer receiving the first element.
+     * @return true if an element was retrieved.
+     * @return false if the queue is empty.
      */
-    void putNotification(
+    bool getNotification(
         notification_t *notification
     );
 
-    /** Retrieves the first element from the queue.
+    /** Retrieves all pending elements from the incoming queue at once.
+     *
+     * Lock free, must only be called by the single consumer of the
+     * incoming queue. Only one acquire of the write counter and one
+     * release of the read counter are done for the whole batch.
      *
-     * @return first notification Queue element.
-     * @return NULL if the queue is empty.
+     * @param notifications Buffer receiving the elements.
+     * @param maxCount Number of elements the buffer can hold.
+     * @return number of elements retrieved, 0 if the queue is empty.
      */
-    notification_t *getNotification(
-        void
+    uint32_t getNotifications(
+        notification_t  *notifications,
+        uint32_t        maxCount
     );
 
 private:
 
     notificationQueue_t *in;
     notificationQueue_t *out;
-    CMutex mutex;
+    CMutex producerMutex; /**< Serializes the producers of the outgoing queue. */
 
 };
 
@@ -38,6 +38,7 @@
 #include <stdio.h>
 #include <inttypes.h>
 #include <list>
+#include <time.h>
 
 #include "McTypes.h"
 #include "mc_linux.h"
@@ -51,6 +52,7 @@
 #include "MobiCoreDevice.h"
 #include "TrustZoneDevice.h"
 #include "NotificationQueue.h"
+#include "McTrace.h"
 
 #include "log.h"
 
@@ -77,6 +79,7 @@ TrustZoneDevice::TrustZoneDevice(
     pMcKMod = NULL;
     pWsmMcp = NULL;
     mobicoreInDDR = NULL;
+    schedStatsValid = false;
 }
 
 //------------------------------------------------------------------------------
@@ -103,7 +106,7 @@ bool TrustZoneDevice::initDevice(
     notificationQueue_t *nqStartIn;
     addr_t mciBuffer;
 
-    pMcKMod = new CMcKMod();
+    pMcKMod = getMcKModInstance();
     mcResult_t ret = pMcKMod->open(devFile);
     if (ret != MC_DRV_OK)
     {
@@ -287,7 +290,10 @@ void TrustZoneDevice::notify(
         .payload = 0
     };
 
-    nq->putNotification(&notification);
+    if (!nq->putNotification(&notification)) {
+        LOG_E("Notification queue full, dropping notification for session %d",
+              sessionId);
+    }
     //IMPROVEMENT-2012-03-07-maneaval What happens when/if nsiq fails?
     //In the old days an exception would be thrown but it was uncertain
     //where it was handled, some server(sock or Netlink). In that case
@@ -538,44 +544,114 @@ bool TrustZoneDevice::schedulerAvailable(void)
 }
 
 //------------------------------------------------------------------------------
-//TODO Schedulerthread to be switched off if MC is idle. Will be woken up when
-//     driver is called again.
+static uint64_t getTimeUs(clockid_t clock)
+{
+    struct timespec ts;
+    if (clock_gettime(clock, &ts) != 0) {
+        return 0;
+    }
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+
+//------------------------------------------------------------------------------
+bool TrustZoneDevice::getSchedulerStats(
+    schedulerStats_t *stats
+)
+{
+    bool ret;
+
+    schedStatsLock.lock();
+    ret = schedStatsValid;
+    if (ret) {
+        *stats = schedStats;
+    }
+    schedStatsLock.unlock();
+    return ret;
+}
+
+
+//------------------------------------------------------------------------------
+// The thread parks while <t-base is IDLE. Otherwise the AdaptiveScheduler
+// decides how many yields go between two N-SIQs and how long to pause before
+// a yield when the SWd has little to do. A pause ends early on any S-SIQ or
+// N-SIQ.
 void TrustZoneDevice::schedule(void)
 {
-    uint32_t timeslice = SCHEDULING_FREQ;
+    uint64_t now = getTimeUs(CLOCK_MONOTONIC);
+    AdaptiveScheduler scheduler(NULL, now);
 
     // loop forever
     for (;;)
     {
+        if (scheduler.intervalElapsed(now))
+        {
+            schedulerStats_t stats;
+            scheduler.closeInterval(now, getTimeUs(CLOCK_THREAD_CPUTIME_ID), &stats);
+            if (stats.yields > 0)
+            {
+                LOG_V("scheduler: %u yields (%u busy), %u N-SIQs, %u idle waits, "
+                      "%u backoffs, timeslice %u",
+                      stats.yields, stats.busyYields, stats.nsiqs,
+                      stats.idleWaits, stats.backoffs, stats.timeslice);
+                LOG_V("scheduler: SWd %" PRIu64 "us, idle %" PRIu64 "us, "
+                      "backoff %" PRIu64 "us, CPU %" PRIu64 "us in %" PRIu64 "us",
+                      stats.swdUs, stats.idleUs, stats.backoffUs, stats.cpuUs,
+                      stats.intervalUs);
+            }
+            schedStatsLock.lock();
+            schedStats = stats;
+            schedStatsValid = true;
+            schedStatsLock.unlock();
+        }
+
         // Scheduling decision
         if (MC_FLAG_SCHEDULE_IDLE == mcFlags->schedule)
         {
             // <t-base is IDLE. Prevent unnecessary consumption of CPU cycles
             // and wait for S-SIQ
             schedSync.wait(); // check return code?
+            uint64_t woken = getTimeUs(CLOCK_MONOTONIC);
+            scheduler.idleWaited(woken - now);
+            now = woken;
             continue;
         }
 
         // <t-base is no longer IDLE, Check timeslice
-        if (timeslice == 0)
+        if (scheduler.nsiqDue())
         {
             // Slice expired, so force MC internal scheduling decision
-            timeslice = SCHEDULING_FREQ;
+            scheduler.nsiqSent();
             if (!nsiq())
             {
                 LOG_E("sending N-SIQ failed");
                 break;
             }
+            now = getTimeUs(CLOCK_MONOTONIC);
+            continue;
+        }
+
+        // Little work in the SWd lately, give it some time before the next
+        // yield unless a SIQ comes in
+        uint32_t backoff = scheduler.getBackoff();
+        if (backoff > 0)
+        {
+            schedSync.waitUs(backoff);
+            uint64_t woken = getTimeUs(CLOCK_MONOTONIC);
+            scheduler.backedOff(woken - now);
+            now = woken;
             continue;
         }
 
         // Slice not used up, simply hand over control to the MC
-        timeslice--;
         if (!yield())
         {
             LOG_E("yielding to SWd failed");
             break;
         }
+        uint64_t back = getTimeUs(CLOCK_MONOTONIC);
+        scheduler.yielded(back - now);
+        now = back;
     } //for (;;)
 
     LOG_E("schedule loop terminated");
@@ -596,9 +672,11 @@ void TrustZoneDevice::handleTaExit(void)
 
         // Check all sessions
         // Socket server might have closed already and removed the session we were waken up for
-        for (trustletSessionIterator_t iterator = trustletSessions.begin();
-                iterator != trustletSessions.end();
-                )
+        trustletSessionList_t sessions;
+        trustletSessions.getSessions(sessions);
+        for (trustletSessionIterator_t iterator = sessions.begin();
+                iterator != sessions.end();
+                ++iterator)
         {
             TrustletSession *ts = *iterator;
 
@@ -610,15 +688,15 @@ void TrustZoneDevice::handleTaExit(void)
 
                 // If ok, remove objects
                 if (mcRet == MC_DRV_OK) {
-                    iterator = trustletSessions.erase(iterator);
+                    mutex_sessions.lock();
+                    trustletSessions.remove(ts);
                     LOG_I("TA session %i finally closed", ts->sessionId);
                     delete ts;
-                    continue;
+                    mutex_sessions.unlock();
                 } else {
                     LOG_I("TA session %i could not be closed yet.", ts->sessionId);
                 }
             }
-            ++iterator;
         }
         mutex_mcp.unlock();
     }
@@ -647,65 +725,73 @@ void TrustZoneDevice::handleIrq(
 
         LOG_V("S-SIQ received");
 
-        // get notifications from queue
-        for (;;)
-        {
-            notification_t *notification = nq->getNotification();
-            if (NULL == notification)
+        // get notifications from queue, draining all pending ones at once
+        notification_t notifications[NQ_NUM_ELEMS];
+        uint32_t count;
+        while ((count = nq->getNotifications(notifications, NQ_NUM_ELEMS)) > 0) {
+            for (uint32_t i = 0; i < count; i++)
             {
-                break;
-            }
+                notification_t *notification = &notifications[i];
 
-            // process the notification
-            // check if the notification belongs to the MCP session
-            if (notification->sessionId == SID_MCP)
-            {
-                LOG_I(" Notification for MCP, payload=%d",
-                      notification->payload);
+                // process the notification
+                // check if the notification belongs to the MCP session
+                if (notification->sessionId == SID_MCP)
+                {
+                    LOG_I(" Notification for MCP, payload=%d",
+                          notification->payload);
+                    mcTraceRecord(MC_TRACE_SIQ, MC_TRACE_INSTANT, mcpTraceId, SID_MCP);
 
-                // Signal main thread of the driver to continue after MCP
-                // command has been processed by the MC
-                signalMcpNotification();
+                    // Signal main thread of the driver to continue after MCP
+                    // command has been processed by the MC
+                    signalMcpNotification();
 
-                continue;
-            }
+                    continue;
+                }
 
-            LOG_I(" Notification for session %d, payload=%d",
-                notification->sessionId, notification->payload);
-
-            // Get the Trustlet session for the session ID
-            TrustletSession *ts = NULL;
-
-            ts = getTrustletSession(notification->sessionId);
-            if (ts == NULL) {
-                /* Couldn't find the session for this notifications
-                 * In practice this only means one thing: there is
-                 * a race condition between RTM and the Daemon and
-                 * RTM won. But we shouldn't drop the notification
-                 * right away we should just queue it in the device
-                 */
-                LOG_W("Notification for unknown session ID");
-                queueUnknownNotification(*notification);
-            } else {
-                mutex_connection.lock();
-                // Get the NQ connection for the session ID
-                Connection *connection = ts->notificationConnection;
-                if (connection == NULL) {
-                    ts->queueNotification(notification);
-                    if (ts->deviceConnection == NULL) {
-                        LOG_I("  Notification for disconnected client, scheduling cleanup of sessions.");
-                        taExitNotification.signal();
-                    }
+                LOG_I(" Notification for session %d, payload=%d",
+                    notification->sessionId, notification->payload);
+
+                // Get the Trustlet session for the session ID
+                TrustletSession *ts = NULL;
+
+                mutex_sessions.lock();
+                ts = getTrustletSession(notification->sessionId);
+                if (ts == NULL) {
+                    /* Couldn't find the session for this notifications
+                     * In practice this only means one thing: there is
+                     * a race condition between RTM and the Daemon and
+                     * RTM won. But we shouldn't drop the notification
+                     * right away we should just queue it in the device
+                     */
+                    LOG_W("Notification for unknown session ID");
+                    mcTraceRecord(MC_TRACE_SIQ, MC_TRACE_INSTANT, 0, notification->sessionId);
+                    queueUnknownNotification(*notification);
                 } else {
-                    LOG_I(" Forward notification to McClient.");
-                    // Forward session ID and additional payload of
-                    // notification to the TLC/Application layer
-                    connection->writeData((void *)notification,
-                                          sizeof(notification_t));
+                    mcTraceRecord(MC_TRACE_SIQ, MC_TRACE_INSTANT, ts->traceId,
+                                  notification->sessionId);
+                    mutex_connection.lock();
+                    // Get the NQ connection for the session ID
+                    Connection *connection = ts->notificationConnection;
+                    if (connection == NULL) {
+                        ts->queueNotification(notification);
+                        if (ts->deviceConnection == NULL) {
+                            LOG_I("  Notification for disconnected client, scheduling cleanup of sessions.");
+                            taExitNotification.signal();
+                        }
+                    } else {
+                        LOG_I(" Forward notification to McClient.");
+                        // Forward session ID and additional payload of
+                        // notification to the TLC/Application layer
+                        connection->writeData((void *)notification,
+                                              sizeof(notification_t));
+                        mcTraceRecord(MC_TRACE_NOTIFICATION_FORWARD, MC_TRACE_INSTANT,
+                                      ts->traceId, notification->sessionId);
+                    }
+                    mutex_connection.unlock();
                 }
-                mutex_connection.unlock();
-            }
-        } // for (;;) over notifiction queue
+                mutex_sessions.unlock();
+            } // for over notifiction queue batch
+        } // while notifications pending
 
         // finished processing notifications. It does not matter if there were
         // any notification or not. S-SIQs can also be triggered by an SWd
@@ -44,15 +44,15 @@
 #include "McTypes.h"
 
 #include "CSemaphore.h"
+#include "CMutex.h"
 #include "CMcKMod.h"
 #include "CWsm.h"
 
 #include "ExcDevice.h"
 #include "MobiCoreDevice.h"
+#include "AdaptiveScheduler.h"
 
 
-#define SCHEDULING_FREQ     5   /**< N-SIQ every n-th time */
-
 class TrustZoneDevice : public MobiCoreDevice
 {
 
@@ -62,6 +62,9 @@ protected:
     CMcKMod_ptr  pMcKMod; /**< kernel module */
     CWsm_ptr     pWsmMcp; /**< WSM use for MCP */
     CWsm_ptr     mobicoreInDDR;  /**< WSM used for Mobicore binary */
+    CMutex       schedStatsLock; /**< Guards schedStats */
+    schedulerStats_t schedStats; /**< Last scheduler statistics interval */
+    bool         schedStatsValid; /**< A statistics interval has ended */
 
     /** Access functions to the MC Linux kernel module
      */
@@ -138,6 +141,14 @@ public:
 
     void schedule(void);
 
+    /** Returns the activity of the scheduler thread in the last completed
+     * statistics interval.
+     *
+     * @param[out] stats Statistics.
+     * @return false if no interval has ended yet.
+     */
+    bool getSchedulerStats(schedulerStats_t *stats);
+
     void handleIrq(void);
 
     void handleTaExit(void);
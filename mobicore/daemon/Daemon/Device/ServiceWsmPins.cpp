@@ -0,0 +1,185 @@
+/** @addtogroup MCD_MCDIMPL_DAEMON_DEV
+ * @{
+ * @file
+ *
+ * Copyright (c) 2013 TRUSTONIC LIMITED
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the TRUSTONIC LIMITED nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ServiceWsmPins.h"
+#include <string.h>
+
+#include "mcLoadFormat.h"
+#include "MobiCoreDevice.h"
+
+#include "log.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+static const mcUuid_t *getServiceUuid(regObject_t *regObj)
+{
+    mclfHeaderV2_t *pHeader = (mclfHeaderV2_t *)(regObj->value + regObj->tlStartOffset);
+    return &pHeader->uuid;
+}
+
+
+//------------------------------------------------------------------------------
+ServiceWsmPins::ServiceWsmPins(
+    MobiCoreDevice *device
+)
+{
+    this->device = device;
+    memset(&stats, 0, sizeof(stats));
+}
+
+
+//------------------------------------------------------------------------------
+ServiceWsmPins::~ServiceWsmPins(
+    void
+)
+{
+    while (!pins.empty()) {
+        unpin(pins.begin());
+    }
+}
+
+
+//------------------------------------------------------------------------------
+void ServiceWsmPins::pinUuid(
+    const mcUuid_t *uuid
+)
+{
+    if (!isPinnedUuid(uuid)) {
+        uuids.push_back(*uuid);
+    }
+}
+
+
+//------------------------------------------------------------------------------
+bool ServiceWsmPins::isPinnedUuid(
+    const mcUuid_t *uuid
+)
+{
+    for (size_t i = 0; i < uuids.size(); i++) {
+        if (memcmp(&uuids[i], uuid, sizeof(mcUuid_t)) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+//------------------------------------------------------------------------------
+void ServiceWsmPins::unpin(
+    pinnedWsmList_t::iterator it
+)
+{
+    if (!device->unregisterWsmL2(it->pWsm)) {
+        LOG_E("Unregistering pinned service blob failed");
+    }
+    stats.pinnedBlobs--;
+    stats.pinnedBytes -= it->regObj->len;
+    mcRegistryReleaseServiceBlob(it->regObj);
+    pins.erase(it);
+}
+
+
+//------------------------------------------------------------------------------
+CWsm_ptr ServiceWsmPins::registerService(
+    regObject_t *regObj
+)
+{
+    const mcUuid_t *uuid = getServiceUuid(regObj);
+    bool pinned = isPinnedUuid(uuid);
+
+    if (pinned) {
+        for (pinnedWsmList_t::iterator it = pins.begin(); it != pins.end(); ++it) {
+            if (memcmp(&it->uuid, uuid, sizeof(mcUuid_t)) != 0) {
+                continue;
+            }
+            if (it->regObj == regObj) {
+                stats.registrationsAvoided++;
+                LOG_I(" Using pinned service blob, %u registrations avoided",
+                      stats.registrationsAvoided);
+                return it->pWsm;
+            }
+            // The registry has a newer blob for this service
+            LOG_I(" Pinned service blob is outdated, unpinning it");
+            unpin(it);
+            break;
+        }
+    }
+
+    CWsm_ptr pWsm = device->registerWsmL2((addr_t)(regObj->value), regObj->len, 0);
+    if (pWsm == NULL) {
+        return NULL;
+    }
+    stats.registrations++;
+
+    // Only blobs owned by the registry cache can outlive this open
+    if (pinned && (mcRegistryRetainServiceBlob(regObj) != NULL)) {
+        pinnedWsm_t pin;
+        pin.uuid = *uuid;
+        pin.regObj = regObj;
+        pin.pWsm = pWsm;
+        pins.push_back(pin);
+        stats.pinnedBlobs++;
+        stats.pinnedBytes += regObj->len;
+        LOG_I(" Pinned service blob, %u blobs %llu bytes pinned",
+              stats.pinnedBlobs, (unsigned long long)stats.pinnedBytes);
+    }
+
+    return pWsm;
+}
+
+
+//------------------------------------------------------------------------------
+bool ServiceWsmPins::unregisterService(
+    CWsm_ptr pWsm
+)
+{
+    for (pinnedWsmList_t::iterator it = pins.begin(); it != pins.end(); ++it) {
+        if (it->pWsm == pWsm) {
+            return true;
+        }
+    }
+    return device->unregisterWsmL2(pWsm);
+}
+
+
+//------------------------------------------------------------------------------
+void ServiceWsmPins::getStats(
+    wsmPinStats_t *stats
+)
+{
+    *stats = this->stats;
+}
+
+/** @} */
@@ -0,0 +1,144 @@
+/** @addtogroup MCD_MCDIMPL_DAEMON_DEV
+ * @{
+ * @file
+ *
+ * Copyright (c) 2013 TRUSTONIC LIMITED
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the TRUSTONIC LIMITED nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SERVICEWSMPINS_H_
+#define SERVICEWSMPINS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <list>
+#include <vector>
+
+#include "mcUuid.h"
+#include "CWsm.h"
+#include "PrivateRegistry.h"
+
+class MobiCoreDevice;
+
+/**
+ * Statistics of the pinned service blob registrations.
+ */
+typedef struct {
+    uint32_t pinnedBlobs;           /**< Service blobs currently pinned. */
+    uint64_t pinnedBytes;           /**< Size of the pinned service blobs. */
+    uint32_t registrations;         /**< Service blob registrations done. */
+    uint32_t registrationsAvoided;  /**< Opens served by a pinned registration. */
+} wsmPinStats_t;
+
+/** Keeps the WSM L2 registration of hot service blobs across session opens.
+ *
+ * For the UUIDs configured with pinUuid(), the registration of the cached
+ * registry object is kept after the session open, together with a registry
+ * cache reference on the object, and handed out again as long as the
+ * registry returns the same object. All other blobs are registered and
+ * unregistered for each open as before.
+ *
+ * The caller must hold the MCP lock of the device.
+ */
+class ServiceWsmPins
+{
+
+public:
+
+    ServiceWsmPins(
+        MobiCoreDevice *device
+    );
+
+    /** Unregisters all pinned blobs and drops their registry references. */
+    ~ServiceWsmPins(
+        void
+    );
+
+    /** Keeps the registration of the service blob of a UUID across opens.
+     *
+     * @param uuid Service UUID.
+     */
+    void pinUuid(
+        const mcUuid_t *uuid
+    );
+
+    /** Returns a WSM registration of a service blob for a session open.
+     *
+     * @param regObj Service blob from the registry.
+     * @return WSM of the blob, NULL if the registration failed.
+     */
+    CWsm_ptr registerService(
+        regObject_t *regObj
+    );
+
+    /** Gives back a WSM returned by registerService(), pinned registrations
+     * are kept.
+     *
+     * @param pWsm WSM of the blob.
+     * @return false if unregistering the blob failed.
+     */
+    bool unregisterService(
+        CWsm_ptr pWsm
+    );
+
+    /** Returns the pinning statistics.
+     *
+     * @param[out] stats Statistics.
+     */
+    void getStats(
+        wsmPinStats_t *stats
+    );
+
+private:
+
+    typedef struct {
+        mcUuid_t    uuid;
+        regObject_t *regObj; /**< Holds a registry cache reference. */
+        CWsm_ptr    pWsm;
+    } pinnedWsm_t;
+
+    typedef std::list<pinnedWsm_t> pinnedWsmList_t;
+
+    MobiCoreDevice          *device;
+    std::vector<mcUuid_t>   uuids; /**< UUIDs to pin. */
+    pinnedWsmList_t         pins;
+    wsmPinStats_t           stats;
+
+    bool isPinnedUuid(
+        const mcUuid_t *uuid
+    );
+
+    void unpin(
+        pinnedWsmList_t::iterator it
+    );
+
+};
+
+#endif /* SERVICEWSMPINS_H_ */
+
+/** @} */
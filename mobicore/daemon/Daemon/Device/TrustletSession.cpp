@@ -33,6 +33,7 @@
  */
 
 #include "TrustletSession.h"
+#include "McTrace.h"
 #include <cstdlib>
 
 #include "log.h"
@@ -47,6 +48,7 @@ TrustletSession::TrustletSession(Connection *deviceConnection, uint32_t sessionI
     this->sessionId = sessionId;
     sessionMagic = rand();
     this->gp_level=0;
+    this->traceId=0;
     this->sessionState=TS_TA_RUNNING;
 }
 
@@ -102,6 +104,8 @@ void TrustletSession::processQueuedNotifications(void)
         // notification to the just established connection
         notificationConnection->writeData((void *)&notifications.front(),
                                           sizeof(notification_t));
+        mcTraceRecord(MC_TRACE_NOTIFICATION_FORWARD, MC_TRACE_INSTANT,
+                      traceId, sessionId);
         notifications.pop();
     }
 }
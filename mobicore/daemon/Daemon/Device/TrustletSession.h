@@ -53,6 +53,7 @@ public:
     Connection *deviceConnection; // Command socket for client "device"
     Connection *notificationConnection; // Notification socket for client session
     uint32_t gp_level;
+    uint32_t traceId; // Trace ID of the last notification from the client
     enum TS_STATE {
         TS_TA_RUNNING,//->dead,close_send
         TS_TA_DEAD, //->close_send, closed
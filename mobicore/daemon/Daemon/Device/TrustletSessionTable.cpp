@@ -0,0 +1,308 @@
+/** @addtogroup MCD_MCDIMPL_DAEMON_DEV
+ * @{
+ * @file
+ *
+ * Copyright (c) 2013 TRUSTONIC LIMITED
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the TRUSTONIC LIMITED nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "TrustletSessionTable.h"
+#include <cstdlib>
+
+#include "log.h"
+
+using namespace std;
+
+#define TABLE_INITIAL_CAPACITY  (32)
+
+// Marks a slot whose session was removed, lookups have to probe past it.
+#define SLOT_DELETED ((TrustletSession *)(uintptr_t)1)
+
+//------------------------------------------------------------------------------
+static inline size_t hashSessionId(uint32_t sessionId, size_t capacity)
+{
+    // Session IDs are small consecutive numbers, spread them over the table.
+    return (size_t)(sessionId * 2654435761U) & (capacity - 1);
+}
+
+
+//------------------------------------------------------------------------------
+TrustletSessionTable::TrustletSessionTable(void)
+{
+    capacity = TABLE_INITIAL_CAPACITY;
+    count = 0;
+    deleted = 0;
+    slots = (TrustletSession **)calloc(capacity, sizeof(TrustletSession *));
+}
+
+
+//------------------------------------------------------------------------------
+TrustletSessionTable::~TrustletSessionTable(void)
+{
+    free(slots);
+}
+
+
+//------------------------------------------------------------------------------
+// Returns the slot holding sessionId, or the slot where it should be inserted.
+// Must be called with the mutex held.
+size_t TrustletSessionTable::probe(
+    uint32_t sessionId,
+    bool     *found
+)
+{
+    size_t index = hashSessionId(sessionId, capacity);
+    size_t freeSlot = capacity;
+
+    for (size_t i = 0; i < capacity; i++) {
+        TrustletSession *session = slots[index];
+        if (session == NULL) {
+            break;
+        }
+        if (session == SLOT_DELETED) {
+            if (freeSlot == capacity) {
+                freeSlot = index;
+            }
+        } else if (session->sessionId == sessionId) {
+            *found = true;
+            return index;
+        }
+        index = (index + 1) & (capacity - 1);
+    }
+
+    *found = false;
+    return (freeSlot != capacity) ? freeSlot : index;
+}
+
+
+//------------------------------------------------------------------------------
+// Rehashes all sessions into a new table, dropping the tombstones.
+// Must be called with the mutex held.
+void TrustletSessionTable::resize(
+    size_t newCapacity
+)
+{
+    TrustletSession **newSlots =
+        (TrustletSession **)calloc(newCapacity, sizeof(TrustletSession *));
+    if (newSlots == NULL) {
+        LOG_E("Cannot resize session table to %zu slots", newCapacity);
+        return;
+    }
+
+    for (size_t i = 0; i < capacity; i++) {
+        TrustletSession *session = slots[i];
+        if ((session == NULL) || (session == SLOT_DELETED)) {
+            continue;
+        }
+        size_t index = hashSessionId(session->sessionId, newCapacity);
+        while (newSlots[index] != NULL) {
+            index = (index + 1) & (newCapacity - 1);
+        }
+        newSlots[index] = session;
+    }
+
+    free(slots);
+    slots = newSlots;
+    capacity = newCapacity;
+    deleted = 0;
+}
+
+
+//------------------------------------------------------------------------------
+void TrustletSessionTable::indexAdd(
+    TrustletSession *session
+)
+{
+    connectionIndex[session->deviceConnection].push_back(session);
+}
+
+
+//------------------------------------------------------------------------------
+void TrustletSessionTable::indexRemove(
+    TrustletSession *session
+)
+{
+    connectionIndex_t::iterator it =
+        connectionIndex.find(session->deviceConnection);
+    if (it == connectionIndex.end()) {
+        return;
+    }
+    it->second.remove(session);
+    if (it->second.empty()) {
+        connectionIndex.erase(it);
+    }
+}
+
+
+//------------------------------------------------------------------------------
+bool TrustletSessionTable::add(
+    TrustletSession *session
+)
+{
+    bool ret = false;
+
+    mutex.lock();
+    // Keep the load, tombstones included, below 3/4.
+    if ((count + deleted + 1) * 4 > capacity * 3) {
+        resize((count + 1) * 2 > capacity ? capacity * 2 : capacity);
+    }
+
+    bool found;
+    size_t index = probe(session->sessionId, &found);
+    if (found) {
+        LOG_E("Session %d already in session table", session->sessionId);
+    } else {
+        if (slots[index] == SLOT_DELETED) {
+            deleted--;
+        }
+        slots[index] = session;
+        count++;
+        indexAdd(session);
+        ret = true;
+    }
+    mutex.unlock();
+
+    return ret;
+}
+
+
+//------------------------------------------------------------------------------
+bool TrustletSessionTable::remove(
+    TrustletSession *session
+)
+{
+    bool ret = false;
+
+    mutex.lock();
+    bool found;
+    size_t index = probe(session->sessionId, &found);
+    if (found && (slots[index] == session)) {
+        // A free successor means no probe sequence runs through this slot.
+        if (slots[(index + 1) & (capacity - 1)] == NULL) {
+            slots[index] = NULL;
+        } else {
+            slots[index] = SLOT_DELETED;
+            deleted++;
+        }
+        count--;
+        indexRemove(session);
+        ret = true;
+    }
+    mutex.unlock();
+
+    return ret;
+}
+
+
+//------------------------------------------------------------------------------
+TrustletSession *TrustletSessionTable::find(
+    uint32_t sessionId
+)
+{
+    TrustletSession *ret = NULL;
+
+    mutex.lock();
+    bool found;
+    size_t index = probe(sessionId, &found);
+    if (found) {
+        ret = slots[index];
+    }
+    mutex.unlock();
+
+    return ret;
+}
+
+
+//------------------------------------------------------------------------------
+void TrustletSessionTable::setDeviceConnection(
+    TrustletSession *session,
+    Connection      *deviceConnection
+)
+{
+    mutex.lock();
+    indexRemove(session);
+    session->deviceConnection = deviceConnection;
+    indexAdd(session);
+    mutex.unlock();
+}
+
+
+//------------------------------------------------------------------------------
+size_t TrustletSessionTable::getSessions(
+    Connection              *deviceConnection,
+    trustletSessionList_t   &sessions
+)
+{
+    size_t ret = 0;
+
+    mutex.lock();
+    connectionIndex_t::iterator it = connectionIndex.find(deviceConnection);
+    if (it != connectionIndex.end()) {
+        sessions.insert(sessions.end(), it->second.begin(), it->second.end());
+        ret = it->second.size();
+    }
+    mutex.unlock();
+
+    return ret;
+}
+
+
+//------------------------------------------------------------------------------
+size_t TrustletSessionTable::getSessions(
+    trustletSessionList_t   &sessions
+)
+{
+    size_t ret = 0;
+
+    mutex.lock();
+    for (size_t i = 0; i < capacity; i++) {
+        TrustletSession *session = slots[i];
+        if ((session != NULL) && (session != SLOT_DELETED)) {
+            sessions.push_back(session);
+            ret++;
+        }
+    }
+    mutex.unlock();
+
+    return ret;
+}
+
+
+//------------------------------------------------------------------------------
+size_t TrustletSessionTable::size(
+    void
+)
+{
+    mutex.lock();
+    size_t ret = count;
+    mutex.unlock();
+    return ret;
+}
+
+/** @} */
@@ -0,0 +1,163 @@
+/** @addtogroup MCD_MCDIMPL_DAEMON_DEV
+ * @{
+ * @file
+ *
+ * Copyright (c) 2013 TRUSTONIC LIMITED
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the TRUSTONIC LIMITED nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef TRUSTLETSESSIONTABLE_H_
+#define TRUSTLETSESSIONTABLE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <map>
+
+#include "TrustletSession.h"
+#include "CMutex.h"
+
+
+/** Table of the open Trustlet sessions of a device.
+ *
+ * Sessions are kept in an open addressing hash table keyed by the session ID
+ * assigned by <t-base, so a notification coming from the secure world is
+ * matched to its session in constant time. A secondary index keeps the
+ * sessions owned by each client device connection in the order they were
+ * opened.
+ *
+ * All methods take the internal lock, lookups only hold it for the probe
+ * sequence so the IRQ thread can use find() concurrently with the socket
+ * server threads.
+ */
+class TrustletSessionTable
+{
+
+public:
+
+    TrustletSessionTable(void);
+
+    ~TrustletSessionTable(void);
+
+    /** Adds a session to the table.
+     *
+     * @param session Session to add, indexed by its sessionId and
+     *                deviceConnection.
+     * @return false if a session with the same ID is already in the table.
+     */
+    bool add(
+        TrustletSession *session
+    );
+
+    /** Removes a session from the table. The session object is not freed.
+     *
+     * @param session Session to remove.
+     * @return false if the session is not in the table.
+     */
+    bool remove(
+        TrustletSession *session
+    );
+
+    /** Looks up a session by the ID assigned by <t-base.
+     *
+     * @param sessionId Session ID.
+     * @return the session or NULL if not found.
+     */
+    TrustletSession *find(
+        uint32_t sessionId
+    );
+
+    /** Changes the device connection owning a session and updates the
+     * connection index accordingly.
+     *
+     * @param session Session in the table.
+     * @param deviceConnection New owner, may be NULL.
+     */
+    void setDeviceConnection(
+        TrustletSession *session,
+        Connection      *deviceConnection
+    );
+
+    /** Returns a snapshot of the sessions owned by a device connection, in
+     * the order they were opened.
+     *
+     * @param deviceConnection Owner of the sessions.
+     * @param sessions List receiving the sessions.
+     * @return number of sessions found.
+     */
+    size_t getSessions(
+        Connection              *deviceConnection,
+        trustletSessionList_t   &sessions
+    );
+
+    /** Returns a snapshot of all the sessions in the table.
+     *
+     * @param sessions List receiving the sessions.
+     * @return number of sessions found.
+     */
+    size_t getSessions(
+        trustletSessionList_t   &sessions
+    );
+
+    /** Returns the number of sessions in the table. */
+    size_t size(
+        void
+    );
+
+private:
+
+    typedef std::map<Connection *, trustletSessionList_t> connectionIndex_t;
+
+    TrustletSession     **slots; /**< Open addressing table, linear probing */
+    size_t              capacity; /**< Number of slots, power of two */
+    size_t              count; /**< Number of sessions in the table */
+    size_t              deleted; /**< Number of tombstone slots */
+    connectionIndex_t   connectionIndex; /**< Sessions by device connection */
+    CMutex              mutex;
+
+    size_t probe(
+        uint32_t sessionId,
+        bool     *found
+    );
+
+    void resize(
+        size_t newCapacity
+    );
+
+    void indexAdd(
+        TrustletSession *session
+    );
+
+    void indexRemove(
+        TrustletSession *session
+    );
+
+};
+
+#endif /* TRUSTLETSESSIONTABLE_H_ */
+
+/** @} */
@@ -58,6 +58,7 @@
 #include "TAExitHandler.h"
 #include "NotificationQueue.h"
 #include "TrustletSession.h"
+#include "TrustletSessionTable.h"
 #include "mcVersionInfo.h"
 
 
@@ -91,8 +92,13 @@ protected:
     mcFlags_t           *mcFlags; /**< Pointer to the MC flags within the MCI buffer */
     mcpMessage_t        *mcpMessage; /**< Pointer to the MCP message structure within the MCI buffer */
     CSemaphore          mcpSessionNotification; /**< Semaphore to synchronize incoming notifications for the MCP session */
+    volatile uint32_t   mcpTraceId; /**< Trace ID of the MCP command waiting for its answer, 0 if none */
 
-    trustletSessionList_t trustletSessions; /**< Available Trustlet Sessions */
+    /* Available Trustlet Sessions. Sessions are only added or removed with
+     * mutex_mcp held. Paths that use a session without mutex_mcp (notify,
+     * IRQ handler) hold mutex_sessions across lookup and use instead. */
+    TrustletSessionTable trustletSessions;
+    CMutex              mutex_sessions; // Taken around removing and deleting a TrustletSession
     mcVersionInfo_t     *mcVersionInfo; /**< MobiCore version info. */
     bool                mcFault; /**< Signal RTM fault */
     bool                mciReused; /**< Signal restart of Daemon. */
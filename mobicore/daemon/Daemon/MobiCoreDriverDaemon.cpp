@@ -40,6 +40,8 @@
 #include <signal.h>
 #include <fcntl.h>
 #include <stdio.h>
+#include <string.h>
+#include <ctype.h>
 
 #include "mcVersion.h"
 #include "mcVersionHelper.h"
@@ -52,6 +54,7 @@
 #include "MobiCoreDriverDaemon.h"
 #include "PrivateRegistry.h"
 #include "MobiCoreDevice.h"
+#include "McTrace.h"
 #include "NetlinkServer.h"
 #include "FSD.h"
 
@@ -74,13 +77,16 @@ bool 					Th_sync=false;
 MobiCoreDriverDaemon::MobiCoreDriverDaemon(
     bool enableScheduler,
     bool loadDriver,
-    std::vector<std::string> drivers)
+    std::vector<std::string> drivers,
+    std::vector<mcUuid_t> pinnedUuids)
 {
     mobiCoreDevice = NULL;
+    servicePins = NULL;
 
     this->enableScheduler = enableScheduler;
     this->loadDriver = loadDriver;
     this->drivers = drivers;
+    this->pinnedUuids = pinnedUuids;
 
     for (int i = 0; i < MAX_SERVERS; i++) {
         servers[i] = NULL;
@@ -99,6 +105,7 @@ MobiCoreDriverDaemon::~MobiCoreDriverDaemon(
         mobiCoreDevice->closeSession(res->conn, res->sessionId);
         mobiCoreDevice->unregisterWsmL2(res->pTciWsm);
     }
+    delete servicePins;
     delete mobiCoreDevice;
     for (int i = 0; i < MAX_SERVERS; i++) {
         delete servers[i];
@@ -143,6 +150,11 @@ void MobiCoreDriverDaemon::run(
     // start device (scheduler)
     mobiCoreDevice->start();
 
+    servicePins = new ServiceWsmPins(mobiCoreDevice);
+    for (unsigned int i = 0; i < pinnedUuids.size(); i++) {
+        servicePins->pinUuid(&pinnedUuids[i]);
+    }
+
     // Load device driver if requested
     if (loadDriver) {
         for (unsigned int i = 0; i < drivers.size(); i++)
@@ -474,26 +486,65 @@ void MobiCoreDriverDaemon::processOpenSession(Connection *connection, bool isGpU
     MobiCoreDevice  *device = (MobiCoreDevice *) (connection->connectionData);
     CHECK_DEVICE(device, connection);
 
-    // Get service blob from registry
+    // Get service blob from registry. This may take a while, so it is done
+    // before the MCP is locked.
+    mutex_registry.lock();
     regObject_t *regObj = mcRegistryGetServiceBlob(&cmdOpenSession.uuid, isGpUuid);
+    mutex_registry.unlock();
     if (NULL == regObj) {
         writeResult(connection, MC_DRV_ERR_TRUSTLET_NOT_FOUND);
         return;
     }
     if (regObj->len == 0) {
-        free(regObj);
+        mcRegistryReleaseServiceBlob(regObj);
         writeResult(connection, MC_DRV_ERR_TRUSTLET_NOT_FOUND);
         return;
     }
+
+    mcDrvRspOpenSession_t rspOpenSession;
+    mcResult_t ret = openSessionWithBlob(
+                         device,
+                         connection,
+                         regObj,
+                         cmdOpenSession.handle,
+                         cmdOpenSession.len,
+                         cmdOpenSession.tci,
+                         &rspOpenSession.payload);
+
+    // Drop our reference to the Trustlet data, it stays cached
+    mcRegistryReleaseServiceBlob(regObj);
+
+    if (ret != MC_DRV_OK) {
+        LOG_E("Service could not be loaded.");
+        writeResult(connection, ret);
+    } else {
+        rspOpenSession.header.responseId = ret;
+        connection->writeData(
+            &rspOpenSession,
+            sizeof(rspOpenSession));
+    }
+}
+
+//------------------------------------------------------------------------------
+mcResult_t MobiCoreDriverDaemon::openSessionWithBlob(
+    MobiCoreDevice                  *device,
+    Connection                      *connection,
+    regObject_t                     *regObj,
+    uint32_t                        tciHandle,
+    uint32_t                        tciLen,
+    uint32_t                        tciOffset,
+    mcDrvRspOpenSessionPayload_ptr  pRspOpenSessionPayload
+)
+{
     LOG_I(" Sharing Service loaded at %p with Secure World", (addr_t)(regObj->value));
 
-    CWsm_ptr pWsm = device->registerWsmL2((addr_t)(regObj->value), regObj->len, 0);
+    device->mutex_mcp.lock();
+
+    CWsm_ptr pWsm = servicePins->registerService(regObj);
     if (pWsm == NULL) {
-        // Free memory occupied by Trustlet data
-        free(regObj);
+        device->mutex_mcp.unlock();
         LOG_E("allocating WSM for Trustlet failed");
-        writeResult(connection, MC_DRV_ERR_DAEMON_KMOD_ERROR);
-        return;
+        return MC_DRV_ERR_DAEMON_KMOD_ERROR;
     }
     // Initialize information data of open session command
     loadDataOpenSession_t loadDataOpenSession;
@@ -502,38 +553,26 @@ void MobiCoreDriverDaemon::processOpenSession(Connection *connection, bool isGpU
     loadDataOpenSession.len = regObj->len;
     loadDataOpenSession.tlHeader = (mclfHeader_ptr) (regObj->value + regObj->tlStartOffset);
 
-    mcDrvRspOpenSession_t rspOpenSession;
     mcResult_t ret = device->openSession(
                          connection,
                          &loadDataOpenSession,
-                         cmdOpenSession.handle,
-                         cmdOpenSession.len,
-                         cmdOpenSession.tci,
-                         &rspOpenSession.payload);
+                         tciHandle,
+                         tciLen,
+                         tciOffset,
+                         pRspOpenSessionPayload);
 
-    // Unregister physical memory from kernel module.
+    // Unregister physical memory from kernel module, unless it is pinned.
     LOG_I(" Service buffer was copied to Secure world and processed. Stop sharing of buffer.");
 
     // This will also destroy the WSM object.
-    if (!device->unregisterWsmL2(pWsm)) {
+    if (!servicePins->unregisterService(pWsm)) {
         // TODO-2012-07-02-haenellu: Can this ever happen? And if so, we should assert(), also TL might still be running.
-        free(regObj);
-        writeResult(connection, MC_DRV_ERR_DAEMON_KMOD_ERROR);
-        return;
+        device->mutex_mcp.unlock();
+        return MC_DRV_ERR_DAEMON_KMOD_ERROR;
     }
 
-    // Free memory occupied by Trustlet data
-    free(regObj);
-
-    if (ret != MC_DRV_OK) {
-        LOG_E("Service could not be loaded.");
-        writeResult(connection, ret);
-    } else {
-        rspOpenSession.header.responseId = ret;
-        connection->writeData(
-            &rspOpenSession,
-            sizeof(rspOpenSession));
-    }
+    device->mutex_mcp.unlock();
+    return ret;
 }
 
 //------------------------------------------------------------------------------
@@ -561,8 +600,11 @@ mcResult_t MobiCoreDriverDaemon::processLoadCheck(mcSpid_t spid, void *blob, uin
     }
     LOG_I(" Sharing Service loaded at %p with Secure World", (addr_t)(regObj->value));
 
+    device->mutex_mcp.lock();
+
     CWsm_ptr pWsm = device->registerWsmL2((addr_t)(regObj->value), regObj->len, 0);
     if (pWsm == NULL) {
+        device->mutex_mcp.unlock();
         // Free memory occupied by Trustlet data
         free(regObj);
         LOG_E("allocating WSM for Trustlet failed");
@@ -585,11 +627,13 @@ mcResult_t MobiCoreDriverDaemon::processLoadCheck(mcSpid_t spid, void *blob, uin
 
     // This will also destroy the WSM object.
     if (!device->unregisterWsmL2(pWsm)) {
+        device->mutex_mcp.unlock();
         // Free memory occupied by Trustlet data
         free(regObj);
         LOG_E("deallocating WSM for Trustlet failed");
         return MC_DRV_ERR_DAEMON_KMOD_ERROR;
     }
+    device->mutex_mcp.unlock();
 
     // Free memory occupied by Trustlet data
     free(regObj);
@@ -636,7 +680,9 @@ void MobiCoreDriverDaemon::processOpenTrustlet(Connection *connection)
     }
 
     // Get service blob from registry
+    mutex_registry.lock();
     regObject_t *regObj = mcRegistryMemGetServiceBlob(cmdOpenTrustlet.spid, (uint8_t *)payload, len);
+    mutex_registry.unlock();
 
     // Free the payload object no matter what
     free(payload);
@@ -650,42 +696,17 @@ void MobiCoreDriverDaemon::processOpenTrustlet(Connection *connection)
         writeResult(connection, MC_DRV_ERR_TRUSTLET_NOT_FOUND);
         return;
     }
-    LOG_I(" Sharing Service loaded at %p with Secure World", (addr_t)(regObj->value));
-
-    CWsm_ptr pWsm = device->registerWsmL2((addr_t)(regObj->value), regObj->len, 0);
-    if (pWsm == NULL) {
-        free(regObj);
-        LOG_E("allocating WSM for Trustlet failed");
-        writeResult(connection, MC_DRV_ERR_DAEMON_KMOD_ERROR);
-        return;
-    }
-    // Initialize information data of open session command
-    loadDataOpenSession_t loadDataOpenSession;
-    loadDataOpenSession.baseAddr = pWsm->physAddr;
-    loadDataOpenSession.offs = ((uintptr_t) regObj->value) & 0xFFF;
-    loadDataOpenSession.len = regObj->len;
-    loadDataOpenSession.tlHeader = (mclfHeader_ptr) (regObj->value + regObj->tlStartOffset);
 
     mcDrvRspOpenSession_t rspOpenSession;
-    mcResult_t ret = device->openSession(
+    mcResult_t ret = openSessionWithBlob(
+                         device,
                          connection,
-                         &loadDataOpenSession,
+                         regObj,
                          cmdOpenTrustlet.handle,
                          cmdOpenTrustlet.len,
                          cmdOpenTrustlet.tci,
                          &rspOpenSession.payload);
 
-    // Unregister physical memory from kernel module.
-    LOG_I(" Service buffer was copied to Secure world and processed. Stop sharing of buffer.");
-
-    // This will also destroy the WSM object.
-    if (!device->unregisterWsmL2(pWsm)) {
-        free(regObj);
-        // TODO-2012-07-02-haenellu: Can this ever happen? And if so, we should assert(), also TL might still be running.
-        writeResult(connection, MC_DRV_ERR_DAEMON_KMOD_ERROR);
-        return;
-    }
-
     // Free memory occupied by Trustlet data
     free(regObj);
 
@@ -871,6 +892,112 @@ void MobiCoreDriverDaemon::processUnmapBulkBuf(Connection *connection)
 }
 
 
+//------------------------------------------------------------------------------
+void MobiCoreDriverDaemon::processMapBulkBufList(Connection *connection)
+{
+    MC_DRV_CMD_MAP_BULK_BUF_LIST_struct cmd;
+
+    RECV_PAYLOAD_FROM_CLIENT(connection, &cmd);
+
+    // Device required
+    MobiCoreDevice *device = (MobiCoreDevice *) (connection->connectionData);
+    CHECK_DEVICE(device, connection);
+
+    if (cmd.count == 0 || cmd.count > MC_DRV_BULK_BUF_LIST_MAX) {
+        LOG_E("Invalid number of bulk buffers %u", cmd.count);
+        writeResult(connection, MC_DRV_ERR_INVALID_PARAMETER);
+        return;
+    }
+
+    mcDrvRspMapBulkMemList_t rsp;
+    mcResult_t mcResult = MC_DRV_OK;
+    uint32_t mapped;
+
+    for (mapped = 0; mapped < cmd.count; mapped++) {
+        mcDrvMapBulkBufEntry_t *entry = &cmd.entries[mapped];
+
+        if (!device->lockWsmL2(entry->handle)) {
+            LOG_E("Couldn't lock the buffer!");
+            mcResult = MC_DRV_ERR_DAEMON_WSM_HANDLE_NOT_FOUND;
+            break;
+        }
+
+        uint64_t pAddrL2 = device->findWsmL2(entry->handle, connection->socketDescriptor);
+        if (pAddrL2 == 0) {
+            LOG_E("Failed to resolve WSM with handle %u", entry->handle);
+            device->unlockWsmL2(entry->handle);
+            mcResult = MC_DRV_ERR_DAEMON_WSM_HANDLE_NOT_FOUND;
+            break;
+        }
+
+        // Map bulk memory to secure world
+        uint32_t secureVirtualAdr = (uint32_t)NULL;
+        mcResult = device->mapBulk(connection, cmd.sessionId, entry->handle, pAddrL2,
+                                   entry->offsetPayload, entry->lenBulkMem, &secureVirtualAdr);
+        if (mcResult != MC_DRV_OK) {
+            device->unlockWsmL2(entry->handle);
+            break;
+        }
+        rsp.payload.secureVirtualAdr[mapped] = secureVirtualAdr;
+    }
+
+    if (mcResult != MC_DRV_OK) {
+        // All or nothing, the client has no way to tell what was mapped
+        while (mapped-- > 0) {
+            mcDrvMapBulkBufEntry_t *entry = &cmd.entries[mapped];
+            device->unmapBulk(connection, cmd.sessionId, entry->handle,
+                              rsp.payload.secureVirtualAdr[mapped], entry->lenBulkMem);
+            device->unlockWsmL2(entry->handle);
+        }
+        writeResult(connection, mcResult);
+        return;
+    }
+
+    rsp.header.responseId = MC_DRV_OK;
+    rsp.payload.sessionId = cmd.sessionId;
+    connection->writeData(&rsp, sizeof(mcDrvRspMapBulkMemList_t));
+}
+
+
+//------------------------------------------------------------------------------
+void MobiCoreDriverDaemon::processUnmapBulkBufList(Connection *connection)
+{
+    MC_DRV_CMD_UNMAP_BULK_BUF_LIST_struct cmd;
+
+    RECV_PAYLOAD_FROM_CLIENT(connection, &cmd);
+
+    // Device required
+    MobiCoreDevice *device = (MobiCoreDevice *) (connection->connectionData);
+    CHECK_DEVICE(device, connection);
+
+    if (cmd.count == 0 || cmd.count > MC_DRV_BULK_BUF_LIST_MAX) {
+        LOG_E("Invalid number of bulk buffers %u", cmd.count);
+        writeResult(connection, MC_DRV_ERR_INVALID_PARAMETER);
+        return;
+    }
+
+    // Unmap everything, report the first failure
+    mcResult_t ret = MC_DRV_OK;
+    for (uint32_t i = 0; i < cmd.count; i++) {
+        mcDrvUnmapBulkBufEntry_t *entry = &cmd.entries[i];
+
+        uint32_t mcResult = device->unmapBulk(connection, cmd.sessionId, entry->handle,
+                                              entry->secureVirtualAdr, entry->lenBulkMem);
+        if (mcResult != MC_DRV_OK) {
+            LOG_V("MCP UNMAP returned code %d", mcResult);
+            if (ret == MC_DRV_OK) {
+                ret = mcResult;
+            }
+            continue;
+        }
+
+        device->unlockWsmL2(entry->handle);
+    }
+
+    writeResult(connection, ret);
+}
+
+
 //------------------------------------------------------------------------------
 void MobiCoreDriverDaemon::processGetVersion(
     Connection  *connection
@@ -955,9 +1082,18 @@ mcDrvResponseHeader_t rspRegistry = { responseId :
     default:
         break;
     }
-    connection->writeData(&rspRegistry, sizeof(rspRegistry));
-    if (rspRegistry.responseId != MC_DRV_ERR_INVALID_OPERATION)
-        connection->writeData(buf, len);
+    if (rspRegistry.responseId == MC_DRV_ERR_INVALID_OPERATION) {
+        connection->writeData(&rspRegistry, sizeof(rspRegistry));
+        return;
+    }
+
+    // Response header and data go out in one message
+    struct iovec iov[2];
+    iov[0].iov_base = &rspRegistry;
+    iov[0].iov_len = sizeof(rspRegistry);
+    iov[1].iov_base = buf;
+    iov[1].iov_len = len;
+    connection->writeMessage(iov, 2);
 }
 
 //------------------------------------------------------------------------------
@@ -1103,6 +1239,44 @@ mcDrvResponseHeader_t rspRegistry = { responseId :
     connection->writeData(&rspRegistry, sizeof(rspRegistry));
 }
 
+//------------------------------------------------------------------------------
+bool MobiCoreDriverDaemon::isConcurrentCommand(
+    Connection *connection
+)
+{
+    mcDrvCommandHeader_t mcDrvCommandHeader;
+
+    // Only look at the header, handleConnection() will read it again
+    size_t rlen = connection->peekData(&mcDrvCommandHeader, sizeof(mcDrvCommandHeader));
+    if ((int32_t)rlen != (int32_t)sizeof(mcDrvCommandHeader)) {
+        return false;
+    }
+
+    // Traced commands are dispatched like untraced ones
+    switch (mcDrvCommandHeader.commandId & ~MC_DRV_CMD_FLAG_TRACE) {
+        // These never write the MCP buffer. STORE_TA_BLOB does an MCP load
+        // check, so it stays with the serialised commands.
+    case MC_DRV_CMD_NOTIFY:
+    case MC_DRV_CMD_GET_VERSION:
+    case MC_DRV_REG_STORE_AUTH_TOKEN:
+    case MC_DRV_REG_WRITE_ROOT_CONT:
+    case MC_DRV_REG_WRITE_SP_CONT:
+    case MC_DRV_REG_WRITE_TL_CONT:
+    case MC_DRV_REG_WRITE_SO_DATA:
+    case MC_DRV_REG_READ_AUTH_TOKEN:
+    case MC_DRV_REG_READ_ROOT_CONT:
+    case MC_DRV_REG_READ_SP_CONT:
+    case MC_DRV_REG_READ_TL_CONT:
+    case MC_DRV_REG_DELETE_AUTH_TOKEN:
+    case MC_DRV_REG_DELETE_ROOT_CONT:
+    case MC_DRV_REG_DELETE_SP_CONT:
+    case MC_DRV_REG_DELETE_TL_CONT:
+        return true;
+    default:
+        return false;
+    }
+}
+
 //------------------------------------------------------------------------------
 bool MobiCoreDriverDaemon::handleConnection(
     Connection *connection
@@ -1110,9 +1284,6 @@ bool MobiCoreDriverDaemon::handleConnection(
 {
     bool ret = false;
 
-    // This is the big lock around everything the Daemon does, including socket and MCI access
-    static CMutex mutex;
-
     /* In case of RTM fault do not try to signal anything to MobiCore
      * just answer NO to all incoming connections! */
     if (mobiCoreDevice->getMcFault()) {
@@ -1120,8 +1291,12 @@ bool MobiCoreDriverDaemon::handleConnection(
         return false;
     }
 
-    mutex.lock();
-    mobiCoreDevice->mutex_mcp.lock();
+    // There is no daemon wide lock. A connection is only ever processed by
+    // one thread at a time, so its own state needs no protection. Commands
+    // driving the MCP are serialised on mutex_mcp, registry I/O on
+    // mutex_registry. Notifications and version queries take neither, a
+    // slow session open does not hold up anybody's notify.
+    CMutex &mutex_mcp = mobiCoreDevice->mutex_mcp;
 
     LOG_I("handleConnection()==== %p", connection);
     do {
@@ -1143,6 +1318,23 @@ bool MobiCoreDriverDaemon::handleConnection(
             LOG_E("Timeout.");
             break;
         }
+
+        // Traced commands carry the trace ID of the client request
+        uint32_t traceId = 0;
+        if (mcDrvCommandHeader.commandId & MC_DRV_CMD_FLAG_TRACE) {
+            mcDrvTraceHeader_t traceHeader;
+            rlen = connection->readData(&traceHeader, sizeof(traceHeader));
+            if (rlen != sizeof(traceHeader)) {
+                LOG_E("Reading trace header failed.");
+                break;
+            }
+            traceId = traceHeader.traceId;
+            mcDrvCommandHeader.commandId = (mcDrvCmd_t)
+                (mcDrvCommandHeader.commandId & ~MC_DRV_CMD_FLAG_TRACE);
+        }
+        mcTraceSetCurrentId(traceId);
+        mcTraceRecord(MC_TRACE_DAEMON_DEQUEUE, MC_TRACE_BEGIN,
+                      traceId, mcDrvCommandHeader.commandId);
         ret = true;
 
         switch (mcDrvCommandHeader.commandId) {
@@ -1152,9 +1344,12 @@ bool MobiCoreDriverDaemon::handleConnection(
             break;
             //-----------------------------------------
         case MC_DRV_CMD_CLOSE_DEVICE:
+            mutex_mcp.lock();
             processCloseDevice(connection);
+            mutex_mcp.unlock();
             break;
             //-----------------------------------------
+            // Open commands lock the MCP themselves once the blob is loaded
         case MC_DRV_CMD_OPEN_SESSION:
             processOpenSession(connection, false);
             break;
@@ -1168,11 +1363,15 @@ bool MobiCoreDriverDaemon::handleConnection(
             break;
             //-----------------------------------------
         case MC_DRV_CMD_CLOSE_SESSION:
+            mutex_mcp.lock();
             processCloseSession(connection);
+            mutex_mcp.unlock();
             break;
             //-----------------------------------------
         case MC_DRV_CMD_NQ_CONNECT:
+            mutex_mcp.lock();
             processNqConnect(connection);
+            mutex_mcp.unlock();
             break;
             //-----------------------------------------
         case MC_DRV_CMD_NOTIFY:
@@ -1180,11 +1379,28 @@ bool MobiCoreDriverDaemon::handleConnection(
             break;
             //-----------------------------------------
         case MC_DRV_CMD_MAP_BULK_BUF:
+            mutex_mcp.lock();
             processMapBulkBuf(connection);
+            mutex_mcp.unlock();
             break;
             //-----------------------------------------
         case MC_DRV_CMD_UNMAP_BULK_BUF:
+            mutex_mcp.lock();
             processUnmapBulkBuf(connection);
+            mutex_mcp.unlock();
+            break;
+            //-----------------------------------------
+            // All buffers of a list go through one MCP lock
+        case MC_DRV_CMD_MAP_BULK_BUF_LIST:
+            mutex_mcp.lock();
+            processMapBulkBufList(connection);
+            mutex_mcp.unlock();
+            break;
+            //-----------------------------------------
+        case MC_DRV_CMD_UNMAP_BULK_BUF_LIST:
+            mutex_mcp.lock();
+            processUnmapBulkBufList(connection);
+            mutex_mcp.unlock();
             break;
             //-----------------------------------------
         case MC_DRV_CMD_GET_VERSION:
@@ -1192,7 +1408,9 @@ bool MobiCoreDriverDaemon::handleConnection(
             break;
             //-----------------------------------------
         case MC_DRV_CMD_GET_MOBICORE_VERSION:
+            mutex_mcp.lock();
             processGetMobiCoreVersion(connection);
+            mutex_mcp.unlock();
             break;
             //-----------------------------------------
             /* Registry functionality */
@@ -1203,7 +1421,9 @@ bool MobiCoreDriverDaemon::handleConnection(
         case MC_DRV_REG_WRITE_TL_CONT:
         case MC_DRV_REG_WRITE_SO_DATA:
         case MC_DRV_REG_STORE_TA_BLOB:
+            mutex_registry.lock();
             processRegistryWriteData(mcDrvCommandHeader.commandId, connection);
+            mutex_registry.unlock();
             break;
             //-----------------------------------------
             // Read Registry Data
@@ -1211,7 +1431,9 @@ bool MobiCoreDriverDaemon::handleConnection(
         case MC_DRV_REG_READ_ROOT_CONT:
         case MC_DRV_REG_READ_SP_CONT:
         case MC_DRV_REG_READ_TL_CONT:
+            mutex_registry.lock();
             processRegistryReadData(mcDrvCommandHeader.commandId, connection);
+            mutex_registry.unlock();
             break;
             //-----------------------------------------
             // Delete registry data
@@ -1219,7 +1441,9 @@ bool MobiCoreDriverDaemon::handleConnection(
         case MC_DRV_REG_DELETE_ROOT_CONT:
         case MC_DRV_REG_DELETE_SP_CONT:
         case MC_DRV_REG_DELETE_TL_CONT:
+            mutex_registry.lock();
             processRegistryDeleteData(mcDrvCommandHeader.commandId, connection);
+            mutex_registry.unlock();
             break;
             //-----------------------------------------
         default:
@@ -1229,9 +1453,15 @@ bool MobiCoreDriverDaemon::handleConnection(
             ret = false;
             break;
         }
+
+        mcTraceRecord(MC_TRACE_DAEMON_DEQUEUE, MC_TRACE_END,
+                      traceId, mcDrvCommandHeader.commandId);
+        mcTraceSetCurrentId(0);
+        // The daemon does not exit, export a TLC's requests once it is done
+        if (mcDrvCommandHeader.commandId == MC_DRV_CMD_CLOSE_DEVICE) {
+            mcTraceFlush();
+        }
     } while (0);
-    mobiCoreDevice->mutex_mcp.unlock();
-    mutex.unlock();
     LOG_I("handleConnection()<-------");
 
     return ret;
@@ -1259,6 +1489,30 @@ void printUsage(
     fprintf(stderr, "-b\t\tfork to background\n");
     fprintf(stderr, "-s\t\tdisable daemon scheduler(default enabled)\n");
     fprintf(stderr, "-r DRIVER\t<t-base driver to load at start-up\n");
+    fprintf(stderr, "-P UUID\t\tkeep the trustlet blob registered across session opens\n");
+}
+
+//------------------------------------------------------------------------------
+/**
+ * Parse a UUID given as 32 hex digits
+ */
+static bool parseUuid(
+    const char *str,
+    mcUuid_t *uuid
+)
+{
+    if (strlen(str) != 2 * sizeof(uuid->value)) {
+        return false;
+    }
+    for (size_t i = 0; i < sizeof(uuid->value); i++) {
+        unsigned int byte;
+        if ((!isxdigit(str[2 * i])) || (!isxdigit(str[2 * i + 1]))
+                || (sscanf(&str[2 * i], "%2x", &byte) != 1)) {
+            return false;
+        }
+        uuid->value[i] = (uint8_t)byte;
+    }
+    return true;
 }
 
 //------------------------------------------------------------------------------
@@ -1294,6 +1548,9 @@ int main(int argc, char *args[])
     // Autoload driver at start-up
     int driverLoadFlag = 0;
     std::vector<std::string> drivers;
+    // Trustlets kept registered across session opens
+    std::vector<mcUuid_t> pinnedUuids;
+    mcUuid_t uuid;
     // By default don't fork
     bool forkDaemon = false;
 
@@ -1301,7 +1558,7 @@ int main(int argc, char *args[])
     pthread_mutex_init(&syncMutex, NULL);
     pthread_cond_init (&syncCondition, NULL);
 
-    while ((c = getopt(argc, args, "r:sbhp:")) != -1) {
+    while ((c = getopt(argc, args, "r:sbhp:P:")) != -1) {
         switch (c) {
         case 'h': /* Help */
             errFlag++;
@@ -1316,6 +1573,14 @@ int main(int argc, char *args[])
             driverLoadFlag = 1;
             drivers.push_back(optarg);
             break;
+        case 'P': /* Keep trustlet blob registered */
+            if (!parseUuid(optarg, &uuid)) {
+                fprintf(stderr, "Invalid UUID: %s\n", optarg);
+                errFlag++;
+                break;
+            }
+            pinnedUuids.push_back(uuid);
+            break;
         case ':':       /* -r operand */
             fprintf(stderr, "Option -%c requires an operand\n", optopt);
             errFlag++;
@@ -1374,7 +1639,9 @@ int main(int argc, char *args[])
         schedulerFlag,
         /* Auto Driver loading */
         driverLoadFlag,
-        drivers);
+        drivers,
+        /* Pinned trustlets */
+        pinnedUuids);
 
     // Start the driver
     mobiCoreDriverDaemon->run();
@@ -42,6 +42,9 @@
 #include "Server/public/Server.h"
 
 #include "MobiCoreDevice.h"
+#include "ServiceWsmPins.h"
+#include "PrivateRegistry.h"
+#include "CMutex.h"
 #include <string>
 #include <list>
 
@@ -81,13 +84,15 @@ public:
      * @param enableScheduler Enable NQ IRQ scheduler
      * @param loadDriver Load driver at daemon startup
      * @param driverPath Startup driver path
+     * @param pinnedUuids Services whose blob registration is kept across opens
      */
     MobiCoreDriverDaemon(
         bool enableScheduler,
 
         /**< <t-base driver loading at start-up */
         bool loadDriver,
-        std::vector<std::string> drivers
+        std::vector<std::string> drivers,
+        std::vector<mcUuid_t> pinnedUuids
     );
 
     virtual ~MobiCoreDriverDaemon(
@@ -102,6 +107,10 @@ public:
         Connection *connection
     );
 
+    bool isConcurrentCommand(
+        Connection *connection
+    );
+
     void run(
         void
     );
@@ -113,10 +122,16 @@ private:
     /**< Flag to load drivers at startup */
     bool loadDriver;
     std::vector<std::string> drivers;
+    /**< Services whose blob registration is kept across opens */
+    std::vector<mcUuid_t> pinnedUuids;
+    /**< Pinned service blob registrations, protected by mutex_mcp */
+    ServiceWsmPins *servicePins;
     /**< List of resources for the loaded drivers */
     driverResourcesList_t driverResources;
     /**< List of servers processing connections */
     Server *servers[MAX_SERVERS];
+    /**< Serialises registry I/O, taken before mutex_mcp if both are needed */
+    CMutex mutex_registry;
 
     bool checkPermission(Connection *connection);
 
@@ -157,6 +172,29 @@ private:
      */
     void processOpenSession(Connection *connection, bool isGpUuid);
 
+    /**
+     * Register a service blob with the kernel module and open a session on it.
+     * Takes the MCP lock for the duration of the open.
+     *
+     * @param device Device to open the session on
+     * @param connection Connection owning the session
+     * @param regObj Service blob loaded from the registry
+     * @param tciHandle Handle of the TCI buffer
+     * @param tciLen Length of the TCI buffer
+     * @param tciOffset Offset of the TCI in its buffer
+     * @param pRspOpenSessionPayload Response payload to fill
+     * @return MC_DRV_OK or error code
+     */
+    mcResult_t openSessionWithBlob(
+        MobiCoreDevice *device,
+        Connection *connection,
+        regObject_t *regObj,
+        uint32_t tciHandle,
+        uint32_t tciLen,
+        uint32_t tciOffset,
+        mcDrvRspOpenSessionPayload_ptr pRspOpenSessionPayload
+    );
+
     /**
      * Check Load TA command
      *
@@ -217,6 +255,20 @@ private:
      */
     void processUnmapBulkBuf(Connection *connection);
 
+    /**
+     * Map a list of bulk bufs with one command
+     *
+     * @param connection Connection object
+     */
+    void processMapBulkBufList(Connection *connection);
+
+    /**
+     * Unmap a list of bulk bufs with one command
+     *
+     * @param connection Connection object
+     */
+    void processUnmapBulkBufList(Connection *connection);
+
     /**
      * Get Version command
      *
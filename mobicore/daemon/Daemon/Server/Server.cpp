@@ -40,6 +40,7 @@
 #include <unistd.h>
 #include <string.h>
 #include <errno.h>
+#include <fcntl.h>
 
 //#define LOG_VERBOSE
 #include "log.h"
@@ -48,6 +49,36 @@ extern pthread_mutex_t         syncMutex;
 extern pthread_cond_t          syncCondition;
 extern bool Th_sync;
 
+/** Events a client socket is armed with. One shot, so a connection is only
+ * ever owned by one thread until it is armed again. */
+#define CLIENT_EVENTS   (EPOLLIN | EPOLLRDHUP | EPOLLET | EPOLLONESHOT)
+
+/** Set by detachConnection() on the thread processing the connection */
+static __thread bool connectionDetached;
+
+//------------------------------------------------------------------------------
+ServerWorker::ServerWorker(
+    Server *server,
+    bool serial
+) : server(server), serial(serial)
+{
+}
+
+
+//------------------------------------------------------------------------------
+void ServerWorker::run(
+)
+{
+    for (;;) {
+        Connection *connection = server->waitWork(serial);
+        if (connection == NULL) {
+            break;
+        }
+        server->processConnection(connection);
+    }
+}
+
+
 //------------------------------------------------------------------------------
 Server::Server(
     ConnectionHandler *connectionHandler,
@@ -56,6 +87,10 @@ Server::Server(
 {
     this->connectionHandler = connectionHandler;
     this->serverSock = -1;
+    this->epollFd = -1;
+    for (int i = 0; i <= SERVER_WORKER_THREADS; i++) {
+        workers[i] = NULL;
+    }
 }
 
 
@@ -64,13 +99,13 @@ void Server::run(
     void
 )
 {
-    do {
-        pthread_mutex_lock(&syncMutex);
+    pthread_mutex_lock(&syncMutex);
 
+    do {
         LOG_I("Server: start listening on socket %s", socketAddr.c_str());
 
         // Open a socket (a UNIX domain stream socket)
-        serverSock = socket(AF_UNIX, SOCK_STREAM, 0);
+        serverSock = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
         if (serverSock < 0) {
             LOG_ERRNO("Can't open stream socket, because socket");
             break;
@@ -94,121 +129,282 @@ void Server::run(
             break;
         }
 
-        LOG_I("\n********* successfully initialized Daemon *********\n");
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (epollFd < 0) {
+            LOG_ERRNO("epoll_create1");
+            break;
+        }
 
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN | EPOLLET;
+        event.data.fd = serverSock;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, serverSock, &event) < 0) {
+            LOG_ERRNO("epoll_ctl");
+            break;
+        }
 
+        startWorkers();
 
-        for (;;) {
-            fd_set fdReadSockets;
-
-            // Clear FD for select()
-            FD_ZERO(&fdReadSockets);
-
-            // Select server socket descriptor
-            FD_SET(serverSock, &fdReadSockets);
-            int maxSocketDescriptor = serverSock;
-
-            // Select socket descriptor of all connections
-            for (connectionIterator_t iterator = peerConnections.begin();
-                    iterator != peerConnections.end();
-                    ++iterator) {
-                Connection *connection = (*iterator);
-                int peerSocket = connection->socketDescriptor;
-                FD_SET(peerSocket, &fdReadSockets);
-                if (peerSocket > maxSocketDescriptor) {
-                    maxSocketDescriptor = peerSocket;
-                }
-            }
+        LOG_I("\n********* successfully initialized Daemon *********\n");
+
+        pthread_cond_signal(&syncCondition);
+        Th_sync=true;
+        pthread_mutex_unlock(&syncMutex);
 
-            pthread_cond_signal(&syncCondition);
-            Th_sync=true;
-            pthread_mutex_unlock(&syncMutex);
+        for (;;) {
+            struct epoll_event events[SERVER_MAX_EVENTS];
 
-            // Wait for activities, select() returns the number of sockets
+            // Wait for activities, epoll_wait() returns the number of sockets
             // which require processing
             LOG_V(" Server: waiting on sockets");
-            int numSockets = select(
-                                 maxSocketDescriptor + 1,
-                                 &fdReadSockets,
-                                 NULL, NULL, NULL);
-
-            // Check if select failed
-            if (numSockets < 0) {
-                LOG_ERRNO("select");
+            int numEvents = epoll_wait(epollFd, events, SERVER_MAX_EVENTS, -1);
+
+            if (numEvents < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                LOG_ERRNO("epoll_wait");
                 break;
             }
 
-            // actually, this should not happen.
-            if (0 == numSockets) {
-                LOG_W(" Server: select() returned 0, spurious event?.");
-                continue;
-            }
+            LOG_V(" Server: events on %d socket(s).", numEvents);
+
+            for (int i = 0; i < numEvents; i++) {
+                int fd = events[i].data.fd;
 
-            LOG_V(" Server: events on %d socket(s).", numSockets);
+                // Check if a new client connected to the server socket
+                if (fd == serverSock) {
+                    acceptConnections();
+                    continue;
+                }
 
-            // Check if a new client connected to the server socket
-            if (FD_ISSET(serverSock, &fdReadSockets)) {
-                do {
-                    LOG_V(" Server: new connection attempt.");
-                    numSockets--;
+                Connection *connection = lookupConnection(fd);
+                if (connection == NULL) {
+                    LOG_V(" Server: event on unknown fd %d", fd);
+                    continue;
+                }
 
-                    struct sockaddr_un clientAddr;
-                    socklen_t clientSockLen = sizeof(clientAddr);
-                    int clientSock = accept(
-                                         serverSock,
-                                         (struct sockaddr *) &clientAddr,
-                                         &clientSockLen);
+                // Hang ups are handled like data: reading the command header
+                // fails and the connection gets dropped.
+                queueWork(connection,
+                          !connectionHandler->isConcurrentCommand(connection));
+            }
+        }
+
+        stopWorkers();
+        LOG_ERRNO("Exiting Server, because");
+        return;
+
+    } while (false);
 
-                    if (clientSock <= 0) {
-                        LOG_ERRNO("accept");
-                        break;
-                    }
+    pthread_mutex_unlock(&syncMutex);
+    LOG_ERRNO("Exiting Server, because");
+}
 
-                    Connection *connection = new Connection(clientSock, &clientAddr);
-                    peerConnections.push_back(connection);
-                    LOG_I(" Server: new socket connection established and start listening.");
-                } while (false);
 
+//------------------------------------------------------------------------------
+void Server::acceptConnections(
+    void
+)
+{
+    // The server socket is edge triggered, so accept until the backlog is
+    // empty
+    for (;;) {
+        LOG_V(" Server: new connection attempt.");
+
+        struct sockaddr_un clientAddr;
+        socklen_t clientSockLen = sizeof(clientAddr);
+        int clientSock = accept4(
+                             serverSock,
+                             (struct sockaddr *) &clientAddr,
+                             &clientSockLen,
+                             SOCK_CLOEXEC);
+
+        if (clientSock < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
                 // we can ignore any errors from accepting a new connection.
                 // If this fail, the client has to deal with it, we are done
                 // and nothing has changed.
+                LOG_ERRNO("accept");
             }
+            break;
+        }
 
-            // Handle traffic on existing client connections
-            connectionIterator_t iterator = peerConnections.begin();
-            while ( (iterator != peerConnections.end())
-                    && (numSockets > 0) ) {
-                Connection *connection = (*iterator);
-                int peerSocket = connection->socketDescriptor;
+        Connection *connection = new Connection(clientSock, &clientAddr);
 
-                if (!FD_ISSET(peerSocket, &fdReadSockets)) {
-                    ++iterator;
-                    continue;
-                }
+        connectionTableMutex.lock();
+        if ((size_t)clientSock >= connectionTable.size()) {
+            connectionTable.resize(clientSock + 1, NULL);
+        }
+        connectionTable[clientSock] = connection;
+        connectionTableMutex.unlock();
 
-                numSockets--;
+        if (!armConnection(connection, EPOLL_CTL_ADD)) {
+            removeConnection(connection);
+            delete connection;
+            continue;
+        }
+        LOG_I(" Server: new socket connection established and start listening.");
+    }
+}
 
-                // the connection will be terminated if command processing
-                // fails
-                if (!connectionHandler->handleConnection(connection)) {
-                    LOG_I(" Server: dropping connection.");
 
-                    //Inform the driver
-                    connectionHandler->dropConnection(connection);
+//------------------------------------------------------------------------------
+Connection *Server::lookupConnection(
+    int fd
+)
+{
+    Connection *connection = NULL;
 
-                    // Remove connection from list
-                    delete connection;
-                    iterator = peerConnections.erase(iterator);
-                    continue;
-                }
+    connectionTableMutex.lock();
+    if (fd >= 0 && (size_t)fd < connectionTable.size()) {
+        connection = connectionTable[fd];
+    }
+    connectionTableMutex.unlock();
 
-                ++iterator;
-            }
-        }
+    return connection;
+}
 
-    } while (false);
 
-    LOG_ERRNO("Exiting Server, because");
+//------------------------------------------------------------------------------
+void Server::removeConnection(
+    Connection *connection
+)
+{
+    int fd = connection->socketDescriptor;
+
+    connectionTableMutex.lock();
+    if (fd >= 0 && (size_t)fd < connectionTable.size()
+            && connectionTable[fd] == connection) {
+        connectionTable[fd] = NULL;
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, NULL);
+    }
+    connectionTableMutex.unlock();
+}
+
+
+//------------------------------------------------------------------------------
+bool Server::armConnection(
+    Connection *connection,
+    int op
+)
+{
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = CLIENT_EVENTS;
+    event.data.fd = connection->socketDescriptor;
+
+    if (epoll_ctl(epollFd, op, connection->socketDescriptor, &event) < 0) {
+        LOG_ERRNO("epoll_ctl");
+        return false;
+    }
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+void Server::processConnection(
+    Connection *connection
+)
+{
+    connectionDetached = false;
+
+    // the connection will be terminated if command processing fails
+    if (!connectionHandler->handleConnection(connection)) {
+        LOG_I(" Server: dropping connection.");
+
+        removeConnection(connection);
+
+        //Inform the driver
+        connectionHandler->dropConnection(connection);
+
+        delete connection;
+        return;
+    }
+
+    // A connection detached while processing (NQ_CONNECT) belongs to its
+    // session now and may already be gone, don't touch it.
+    if (connectionDetached) {
+        return;
+    }
+
+    // The next command may have been received along with this one, the
+    // socket will not signal it again
+    if (connection->hasBufferedData()) {
+        queueWork(connection, !connectionHandler->isConcurrentCommand(connection));
+        return;
+    }
+
+    if (!armConnection(connection, EPOLL_CTL_MOD)) {
+        removeConnection(connection);
+        connectionHandler->dropConnection(connection);
+        delete connection;
+    }
+}
+
+
+//------------------------------------------------------------------------------
+void Server::queueWork(
+    Connection *connection,
+    bool serial
+)
+{
+    workQueueMutex.lock();
+    workQueue[serial].push(connection);
+    workQueueMutex.unlock();
+    workAvailable[serial].signal();
+}
+
+
+//------------------------------------------------------------------------------
+Connection *Server::waitWork(
+    bool serial
+)
+{
+    workAvailable[serial].wait();
+
+    workQueueMutex.lock();
+    Connection *connection = workQueue[serial].front();
+    workQueue[serial].pop();
+    workQueueMutex.unlock();
+
+    return connection;
+}
+
+
+//------------------------------------------------------------------------------
+void Server::startWorkers(
+    void
+)
+{
+    for (int i = 0; i < SERVER_WORKER_THREADS; i++) {
+        workers[i] = new ServerWorker(this, false);
+        workers[i]->start("McDaemon.Worker");
+    }
+    workers[SERVER_WORKER_THREADS] = new ServerWorker(this, true);
+    workers[SERVER_WORKER_THREADS]->start("McDaemon.Serial");
+}
+
+
+//------------------------------------------------------------------------------
+void Server::stopWorkers(
+    void
+)
+{
+    // A NULL entry tells one worker to exit
+    for (int i = 0; i <= SERVER_WORKER_THREADS; i++) {
+        if (workers[i] != NULL) {
+            queueWork(NULL, i == SERVER_WORKER_THREADS);
+        }
+    }
+    for (int i = 0; i <= SERVER_WORKER_THREADS; i++) {
+        if (workers[i] != NULL) {
+            workers[i]->join();
+            delete workers[i];
+            workers[i] = NULL;
+        }
+    }
 }
 
 
@@ -219,16 +415,17 @@ void Server::detachConnection(
 {
     LOG_V(" Stopping to listen on notification socket.");
 
-    for (connectionIterator_t iterator = peerConnections.begin();
-            iterator != peerConnections.end();
-            ++iterator) {
-        Connection *tmpConnection = (*iterator);
-        if (tmpConnection == connection) {
-            peerConnections.erase(iterator);
-            LOG_I(" Stopped listening on notification socket.");
-            break;
-        }
+    int fd = connection->socketDescriptor;
+
+    connectionTableMutex.lock();
+    if (fd >= 0 && (size_t)fd < connectionTable.size()
+            && connectionTable[fd] == connection) {
+        connectionTable[fd] = NULL;
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, NULL);
+        connectionDetached = true;
+        LOG_I(" Stopped listening on notification socket.");
     }
+    connectionTableMutex.unlock();
 }
 
 
@@ -237,6 +434,8 @@ Server::~Server(
     void
 )
 {
+    stopWorkers();
+
     // Shut down the server socket
     if(serverSock != -1) {
         close(serverSock);
@@ -244,11 +443,14 @@ Server::~Server(
     }
 
     // Destroy all client connections
-    connectionIterator_t iterator = peerConnections.begin();
-    while (iterator != peerConnections.end()) {
-        Connection *tmpConnection = (*iterator);
-        delete tmpConnection;
-        iterator = peerConnections.erase(iterator);
+    for (size_t fd = 0; fd < connectionTable.size(); fd++) {
+        delete connectionTable[fd];
+        connectionTable[fd] = NULL;
+    }
+
+    if (epollFd != -1) {
+        close(epollFd);
+        epollFd = -1;
     }
 }
 
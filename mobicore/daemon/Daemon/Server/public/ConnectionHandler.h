@@ -66,6 +66,22 @@ public:
     virtual void dropConnection(
         Connection *connection
     ) = 0;
+
+    /**
+     * Check if the pending command may be processed concurrently.
+     * Commands driving the MCP are processed in order by a single serial
+     * worker, anything else can be handed to the worker pool. The connection
+     * data is not consumed.
+     *
+     * @param [in] connection Reference to the connection which has data to process.
+     * @return true if the command can be processed by a worker thread.
+     */
+    virtual bool isConcurrentCommand(
+        Connection *connection
+    ) {
+        (void) connection;
+        return false;
+    };
 };
 
 #endif /* CONNECTIONHANDLER_H_ */
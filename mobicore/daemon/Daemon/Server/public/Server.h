@@ -6,7 +6,11 @@
  *
  * Handles incoming socket connections from clients using the MobiCore driver.
  *
- * Iterative socket server using UNIX domain stream protocol.
+ * Event driven socket server using UNIX domain stream protocol. Client
+ * sockets are watched with epoll and looked up in a table indexed by fd.
+ * Commands which the connection handler reports as concurrent are handed to
+ * a small pool of worker threads, everything else is processed in order by a
+ * single serial worker. The server thread itself only accepts and dispatches.
  *
  *
  * Copyright (c) 2013 TRUSTONIC LIMITED
@@ -44,16 +48,51 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <sys/epoll.h>
 #include <string>
 #include <cstdio>
 #include <vector>
+#include <queue>
 #include "CThread.h"
+#include "CMutex.h"
+#include "CSemaphore.h"
 #include "ConnectionHandler.h"
 
 /** Number of incoming connections that can be queued.
  * Additional clients will generate the error ECONNREFUSED. */
 #define LISTEN_QUEUE_LEN    (16)
 
+/** Number of threads processing concurrent commands. One more thread
+ * processes the serialised ones. */
+#define SERVER_WORKER_THREADS   (2)
+
+/** Number of epoll events fetched per wakeup. */
+#define SERVER_MAX_EVENTS   (32)
+
+class Server;
+
+/**
+ * Worker thread of the socket server.
+ * Pulls connections queued by the server thread and processes their pending
+ * command.
+ */
+class ServerWorker: public CThread
+{
+
+public:
+    ServerWorker(
+        Server *server,
+        bool serial
+    );
+
+    virtual void run(
+    );
+
+private:
+    Server *server;
+    bool serial; /**< Worker of the serial queue */
+};
+
 
 class Server: public CThread
 {
@@ -97,13 +136,70 @@ public:
         Connection *connection
     );
 
+    /**
+     * Wait for a connection queued for the worker threads.
+     *
+     * @param serial Wait on the serial queue instead of the concurrent one.
+     * @return The connection to process or NULL if the worker shall exit.
+     */
+    Connection *waitWork(
+        bool serial
+    );
+
+    /**
+     * Process the pending command of a connection.
+     * The connection is dropped if the handler fails, otherwise it is armed
+     * again for the next command unless it has been detached meanwhile.
+     *
+     * @param connection The connection with pending data.
+     */
+    void processConnection(
+        Connection *connection
+    );
+
 protected:
     int serverSock;
     string socketAddr;
     ConnectionHandler   *connectionHandler; /**< Connection handler registered to the server */
 
 private:
-    connectionList_t    peerConnections; /**< Connections to devices */
+    int epollFd; /**< epoll instance watching the server and client sockets */
+    std::vector<Connection *> connectionTable; /**< Connections to devices, indexed by fd */
+    CMutex connectionTableMutex; /**< Protects connectionTable */
+    std::queue<Connection *> workQueue[2]; /**< Connections waiting for a worker, concurrent and serial */
+    CMutex workQueueMutex; /**< Protects workQueue */
+    CSemaphore workAvailable[2]; /**< Counts the entries in workQueue */
+    ServerWorker *workers[SERVER_WORKER_THREADS + 1]; /**< Concurrent workers followed by the serial one */
+
+    void acceptConnections(
+        void
+    );
+
+    Connection *lookupConnection(
+        int fd
+    );
+
+    void removeConnection(
+        Connection *connection
+    );
+
+    bool armConnection(
+        Connection *connection,
+        int op
+    );
+
+    void queueWork(
+        Connection *connection,
+        bool serial
+    );
+
+    void startWorkers(
+        void
+    );
+
+    void stopWorkers(
+        void
+    );
 
 };
 
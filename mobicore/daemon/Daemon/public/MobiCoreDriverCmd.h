@@ -57,6 +57,8 @@ typedef enum {
     MC_DRV_CMD_GET_MOBICORE_VERSION = 11,
     MC_DRV_CMD_OPEN_TRUSTLET        = 12,
     MC_DRV_CMD_OPEN_TRUSTED_APP     = 13,
+    MC_DRV_CMD_MAP_BULK_BUF_LIST    = 14, /**< Since daemon version 0.3 */
+    MC_DRV_CMD_UNMAP_BULK_BUF_LIST  = 15, /**< Since daemon version 0.3 */
 
     // Registry Commands
 
@@ -87,6 +89,14 @@ typedef struct {
     mcDrvCmd_t  commandId;
 } mcDrvCommandHeader_t;
 
+/** Set in commandId if a mcDrvTraceHeader_t follows the command header.
+ * Since daemon version 0.5 */
+#define MC_DRV_CMD_FLAG_TRACE   (1U << 31)
+
+typedef struct {
+    uint32_t  traceId; /**< Request trace ID, see McTrace.h */
+} mcDrvTraceHeader_t;
+
 typedef struct {
     /* <t-base Daemon uses Client API return codes also in commands between Daemon and Client Library. */
     uint32_t  responseId;
@@ -220,6 +230,52 @@ typedef struct {
 } mcDrvRspUnmapBulkMem_t;
 
 
+//--------------------------------------------------------------
+#define MC_DRV_BULK_BUF_LIST_MAX    4 /**< Buffers per list command, one per GP parameter */
+
+typedef struct {
+    uint32_t  handle;
+    uintptr_t offsetPayload;
+    uint32_t  lenBulkMem;
+} mcDrvMapBulkBufEntry_t;
+
+struct MC_DRV_CMD_MAP_BULK_BUF_LIST_struct {
+    uint32_t  commandId;
+    uint32_t  sessionId;
+    uint32_t  count;
+    mcDrvMapBulkBufEntry_t entries[MC_DRV_BULK_BUF_LIST_MAX];
+};
+
+typedef struct {
+    uint32_t  sessionId;
+    uint32_t  secureVirtualAdr[MC_DRV_BULK_BUF_LIST_MAX];
+} mcDrvRspMapBulkMemListPayload_t, *mcDrvRspMapBulkMemListPayload_ptr;
+
+typedef struct {
+    mcDrvResponseHeader_t            header;
+    mcDrvRspMapBulkMemListPayload_t  payload;
+} mcDrvRspMapBulkMemList_t;
+
+
+//--------------------------------------------------------------
+typedef struct {
+    uint32_t  handle;
+    uintptr_t secureVirtualAdr;
+    uint32_t  lenBulkMem;
+} mcDrvUnmapBulkBufEntry_t;
+
+struct MC_DRV_CMD_UNMAP_BULK_BUF_LIST_struct {
+    uint32_t  commandId;
+    uint32_t  sessionId;
+    uint32_t  count;
+    mcDrvUnmapBulkBufEntry_t entries[MC_DRV_BULK_BUF_LIST_MAX];
+};
+
+typedef struct {
+    mcDrvResponseHeader_t          header;
+} mcDrvRspUnmapBulkMemList_t;
+
+
 //--------------------------------------------------------------
 struct MC_DRV_CMD_NQ_CONNECT_struct {
     uint32_t  commandId;
@@ -270,6 +326,8 @@ typedef union {
     MC_DRV_CMD_NOTIFY_struct            mcDrvCmdNotify;
     MC_DRV_CMD_MAP_BULK_BUF_struct      mcDrvCmdMapBulkMem;
     MC_DRV_CMD_UNMAP_BULK_BUF_struct    mcDrvCmdUnmapBulkMem;
+    MC_DRV_CMD_MAP_BULK_BUF_LIST_struct     mcDrvCmdMapBulkMemList;
+    MC_DRV_CMD_UNMAP_BULK_BUF_LIST_struct   mcDrvCmdUnmapBulkMemList;
     MC_DRV_CMD_GET_VERSION_struct       mcDrvCmdGetVersion;
     MC_DRV_CMD_GET_MOBICORE_VERSION_struct  mcDrvCmdGetMobiCoreVersion;
 } mcDrvCommand_t, *mcDrvCommand_ptr;
@@ -283,6 +341,8 @@ typedef union {
     mcDrvRspNqConnect_t          mcDrvRspNqConnect;
     mcDrvRspMapBulkMem_t         mcDrvRspMapBulkMem;
     mcDrvRspUnmapBulkMem_t       mcDrvRspUnmapBulkMem;
+    mcDrvRspMapBulkMemList_t     mcDrvRspMapBulkMemList;
+    mcDrvRspUnmapBulkMemList_t   mcDrvRspUnmapBulkMemList;
     mcDrvRspGetVersion_t         mcDrvRspGetVersion;
     mcDrvRspGetMobiCoreVersion_t mcDrvRspGetMobiCoreVersion;
 } mcDrvResponse_t, *mcDrvResponse_ptr;
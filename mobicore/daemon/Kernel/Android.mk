@@ -8,6 +8,11 @@
 
 include $(LOCAL_PATH)/Kernel/Platforms/Generic/Android.mk
 
+# Replace the kernel module with the simulator, see README.android
+ifeq ($(MC_KMOD_SIMULATOR),true)
+  include $(LOCAL_PATH)/Kernel/Platforms/Simulator/Android.mk
+endif
+
 # Include platform specific sub-makefiles
 ifdef $(PLATFORM)
   include $(LOCAL_PATH)/Kernel/Platforms/$(PLATFORM)/Android.mk
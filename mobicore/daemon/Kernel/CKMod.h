@@ -68,11 +68,11 @@ public:
         void
     );
 
-    mcResult_t open(
+    virtual mcResult_t open(
         const char *deviceName
     );
 
-    void close(
+    virtual void close(
         void
     );
 
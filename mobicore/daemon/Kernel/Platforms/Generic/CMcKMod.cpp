@@ -53,6 +53,14 @@
 //------------------------------------------------------------------------------
 MC_CHECK_VERSION(MCDRVMODULEAPI, 1, 1);
 
+//------------------------------------------------------------------------------
+__attribute__ ((weak)) CMcKMod_ptr getMcKModInstance(
+    void
+)
+{
+    return new CMcKMod();
+}
+
 //------------------------------------------------------------------------------
 mcResult_t CMcKMod::mapWsm(
     uint32_t    len,
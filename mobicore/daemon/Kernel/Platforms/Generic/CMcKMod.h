@@ -45,6 +45,9 @@
 
 /**
  * As this is also used by the ClientLib, we do not use exceptions.
+ *
+ * The methods are virtual so that a platform can replace the kernel module
+ * backend, see getMcKModInstance().
  */
 class CMcKMod : public CKMod
 {
@@ -61,10 +64,10 @@ public:
     * @return MC_DRV_ERR_KMOD_NOT_OPEN
     * @return MC_DRV_ERR_KERNEL_MODULE or'ed with errno<<16
     */
-    mcResult_t mapWsm(uint32_t  len,
-                      uint32_t    *pHandle,
-                      addr_t      *pVirtAddr,
-                      uint64_t      *pPhysAddr);
+    virtual mcResult_t mapWsm(uint32_t  len,
+                              uint32_t    *pHandle,
+                              addr_t      *pVirtAddr,
+                              uint64_t      *pPhysAddr);
     /**
     * Map data.
     *
@@ -78,7 +81,7 @@ public:
     * @return MC_DRV_ERR_KMOD_NOT_OPEN
     * @return MC_DRV_ERR_KERNEL_MODULE or'ed with errno<<16
     */
-    mcResult_t mapMCI(
+    virtual mcResult_t mapMCI(
         uint32_t    len,
         uint32_t    *pHandle,
         addr_t      *pVirtAddr,
@@ -88,55 +91,62 @@ public:
     /**
     * Map persistent WSM which will not be freed up once the calling process dies.
     */
-    mcResult_t mapPersistent(
+    virtual mcResult_t mapPersistent(
         uint32_t    len,
         uint32_t    *pHandle,
         addr_t      *pVirtAddr,
         addr_t      *pPhysAddr);
 
-    int read(addr_t buffer, uint32_t len);
+    virtual int read(addr_t buffer, uint32_t len);
 
-    bool waitSSIQ(uint32_t *pCnt);
+    virtual bool waitSSIQ(uint32_t *pCnt);
 
-    int fcInit(uint32_t    nqLength,
-               uint32_t    mcpOffset,
-               uint32_t    mcpLength);
+    virtual int fcInit(uint32_t    nqLength,
+                       uint32_t    mcpOffset,
+                       uint32_t    mcpLength);
 
-    int fcInfo(
+    virtual int fcInfo(
         uint32_t    extInfoId,
         uint32_t    *pState,
         uint32_t    *pExtInfo);
 
-    int fcYield(void);
+    virtual int fcYield(void);
 
-    int fcNSIQ(void);
+    virtual int fcNSIQ(void);
 
-    mcResult_t free(uint32_t handle, addr_t buffer, uint32_t len);
+    virtual mcResult_t free(uint32_t handle, addr_t buffer, uint32_t len);
 
-    mcResult_t registerWsmL2(
+    virtual mcResult_t registerWsmL2(
         addr_t      buffer,
         uint32_t    len,
         uint32_t    pid,
         uint32_t    *pHandle,
         uint64_t      *pPhysWsmL2);
 
-    mcResult_t unregisterWsmL2(uint32_t handle);
+    virtual mcResult_t unregisterWsmL2(uint32_t handle);
 
-    mcResult_t lockWsmL2(uint32_t handle);
+    virtual mcResult_t lockWsmL2(uint32_t handle);
 
-    mcResult_t unlockWsmL2(uint32_t handle);
+    virtual mcResult_t unlockWsmL2(uint32_t handle);
 
-    mcResult_t cleanupWsmL2(void);
+    virtual mcResult_t cleanupWsmL2(void);
 
-    uint64_t findWsmL2(uint32_t handle, int fd);
+    virtual uint64_t findWsmL2(uint32_t handle, int fd);
 
-    mcResult_t findContiguousWsm(uint32_t handle, int fd, uint64_t *phys, uint32_t *len);
+    virtual mcResult_t findContiguousWsm(uint32_t handle, int fd, uint64_t *phys, uint32_t *len);
 
-    mcResult_t setupLog(void);
+    virtual mcResult_t setupLog(void);
 
-    bool checkVersion(void);
+    virtual bool checkVersion(void);
 };
 
 typedef CMcKMod  *CMcKMod_ptr;
 
+/**
+ * Creates the kernel module backend. The default returns a CMcKMod talking
+ * to the MobiCore kernel module, it is weak so that a platform can link in
+ * another backend.
+ */
+CMcKMod_ptr getMcKModInstance(void);
+
 #endif // CMCKMOD_H_
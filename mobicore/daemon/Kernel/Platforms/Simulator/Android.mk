@@ -0,0 +1,18 @@
+# =============================================================================
+#
+# Simulated kernel module and secure world for host-side testing
+#
+# =============================================================================
+
+# This is not a separate module.
+# All paths are relative to APP_PROJECT_PATH!
+KERNEL_SIM_PATH := Kernel/Platforms/Simulator
+
+# Add new source files here
+LOCAL_SRC_FILES += $(KERNEL_SIM_PATH)/CMcKModSim.cpp \
+	$(KERNEL_SIM_PATH)/SimSecureWorld.cpp
+
+# Header files for components including this module
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/$(KERNEL_SIM_PATH) \
+	$(LOCAL_PATH)/ClientLib/public/GP \
+	$(COMP_PATH_MobiCore)/inc/McLib
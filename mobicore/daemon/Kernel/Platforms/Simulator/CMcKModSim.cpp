@@ -0,0 +1,755 @@
+/** @addtogroup MCD_MCDIMPL_DAEMON_KERNEL
+ * @{
+ * @file
+ *
+ * Simulated <t-base Driver Kernel Module.
+ *
+ *
+ * Copyright (c) 2013 TRUSTONIC LIMITED
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the TRUSTONIC LIMITED nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <stdint.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sched.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/prctl.h>
+
+#include "McTypes.h"
+#include "mcVersionHelper.h"
+#include "Mci/mci.h"
+
+#include "CMcKModSim.h"
+#include "SimSecureWorld.h"
+
+#include "log.h"
+
+//------------------------------------------------------------------------------
+CMcKMod_ptr getMcKModInstance(
+    void
+)
+{
+    return new CMcKModSim();
+}
+
+
+//------------------------------------------------------------------------------
+std::string CMcKModSim::getPath(
+    const char  *name
+)
+{
+    const char *dir = getenv(SIM_ENV_DIR);
+    if (dir == NULL || dir[0] == '\0') {
+        dir = SIM_DEFAULT_DIR;
+    }
+    return std::string(dir) + "/" + name;
+}
+
+
+//------------------------------------------------------------------------------
+static std::string getWsmPath(
+    uint32_t    handle
+)
+{
+    char name[32];
+    snprintf(name, sizeof(name), SIM_WSM_FILE, handle);
+    return CMcKModSim::getPath(name);
+}
+
+
+//------------------------------------------------------------------------------
+CMcKModSim::CMcKModSim(
+    void
+)
+{
+    kernel = NULL;
+    owner = 0;
+    ssiqCount = 0;
+    mci = NULL;
+    mciLen = 0;
+    swd = NULL;
+
+    const char *latency = getenv(SIM_ENV_KMOD_LATENCY);
+    l2LatencyUs = (latency != NULL) ? (uint32_t)strtoul(latency, NULL, 0) : 0;
+}
+
+
+//------------------------------------------------------------------------------
+CMcKModSim::~CMcKModSim(
+    void
+)
+{
+    if (isOpen()) {
+        close();
+    }
+}
+
+
+//------------------------------------------------------------------------------
+mcResult_t CMcKModSim::open(
+    const char *deviceName
+)
+{
+    if (isOpen()) {
+        LOG_W("already open");
+        return MC_DRV_ERR_DEVICE_ALREADY_OPEN;
+    }
+
+    std::string path = getPath(SIM_KERNEL_FILE);
+    LOG_I(" Opening simulated kernel module at %s for %s.", path.c_str(), deviceName);
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0660);
+    if (fd == -1) {
+        LOG_ERRNO("open");
+        return MAKE_MC_DRV_KMOD_WITH_ERRNO(errno);
+    }
+
+    // The first opener sizes the file, flock() serializes with the others
+    int err = 0;
+    struct stat st;
+    flock(fd, LOCK_EX);
+    if (fstat(fd, &st) != 0) {
+        err = errno;
+    } else if ((size_t)st.st_size < sizeof(simKernel_t)
+               && ftruncate(fd, sizeof(simKernel_t)) != 0) {
+        err = errno;
+    }
+    flock(fd, LOCK_UN);
+    if (err != 0) {
+        LOG_E("sizing %s failed: %s", path.c_str(), strerror(err));
+        ::close(fd);
+        return MAKE_MC_DRV_KMOD_WITH_ERRNO(err);
+    }
+
+    void *addr = ::mmap(0, sizeof(simKernel_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        LOG_ERRNO("mmap");
+        ::close(fd);
+        return MAKE_MC_DRV_KMOD_WITH_ERRNO(errno);
+    }
+
+    fdKMod = fd;
+    kernel = (simKernel_t *)addr;
+
+    lockKernel();
+    if (kernel->magic != SIM_KERNEL_MAGIC) {
+        memset(kernel, 0, sizeof(*kernel));
+        kernel->magic = SIM_KERNEL_MAGIC;
+        kernel->nextHandle = 1;
+        kernel->nextOwner = 1;
+    }
+    owner = kernel->nextOwner++;
+    reapWsm();
+    unlockKernel();
+
+#ifdef PR_SET_PTRACER
+    // The simulated SWd reaches L2 registered buffers of this process with
+    // process_vm_readv(), like the kernel module reaches their pages.
+    prctl(PR_SET_PTRACER, PR_SET_PTRACER_ANY, 0, 0, 0);
+#endif
+
+    return MC_DRV_OK;
+}
+
+
+//------------------------------------------------------------------------------
+void CMcKModSim::close(
+    void
+)
+{
+    if (!isOpen()) {
+        LOG_W(" Kernel module device not open");
+        return;
+    }
+
+    delete swd;
+    swd = NULL;
+
+    if (mci != NULL) {
+        ::munmap(mci, mciLen);
+        mci = NULL;
+    }
+
+    // Like closing the device node, drop everything this instance created
+    lockKernel();
+    for (uint32_t i = 0; i < SIM_WSM_MAX; i++) {
+        if (kernel->wsm[i].handle != 0 && kernel->wsm[i].owner == owner) {
+            releaseWsm(&kernel->wsm[i]);
+        }
+    }
+    unlockKernel();
+
+    ::munmap(kernel, sizeof(simKernel_t));
+    kernel = NULL;
+    CKMod::close();
+}
+
+
+//------------------------------------------------------------------------------
+void CMcKModSim::lockKernel(void)
+{
+    flock(fdKMod, LOCK_EX);
+}
+
+
+//------------------------------------------------------------------------------
+void CMcKModSim::unlockKernel(void)
+{
+    flock(fdKMod, LOCK_UN);
+}
+
+
+//------------------------------------------------------------------------------
+simWsm_t *CMcKModSim::lookupWsm(uint32_t handle, uint32_t type)
+{
+    if (handle == 0) {
+        return NULL;
+    }
+    for (uint32_t i = 0; i < SIM_WSM_MAX; i++) {
+        if (kernel->wsm[i].handle == handle) {
+            return (type == WSM_INVALID || kernel->wsm[i].type == type) ? &kernel->wsm[i] : NULL;
+        }
+    }
+    return NULL;
+}
+
+
+//------------------------------------------------------------------------------
+simWsm_t *CMcKModSim::allocWsm(uint32_t type, uint32_t len)
+{
+    for (uint32_t i = 0; i < SIM_WSM_MAX; i++) {
+        simWsm_t *wsm = &kernel->wsm[i];
+        if (wsm->handle == 0) {
+            memset(wsm, 0, sizeof(*wsm));
+            wsm->handle = kernel->nextHandle++;
+            if (kernel->nextHandle == 0) {
+                kernel->nextHandle = 1;
+            }
+            wsm->type = type;
+            wsm->owner = owner;
+            wsm->ownerPid = getpid();
+            wsm->pid = wsm->ownerPid;
+            wsm->len = len;
+            return wsm;
+        }
+    }
+    LOG_E("simulated WSM table full");
+    return NULL;
+}
+
+
+//------------------------------------------------------------------------------
+void CMcKModSim::releaseWsm(simWsm_t *wsm)
+{
+    if (wsm->type == WSM_CONTIGUOUS) {
+        unlink(getWsmPath(wsm->handle).c_str());
+    }
+    memset(wsm, 0, sizeof(*wsm));
+}
+
+
+//------------------------------------------------------------------------------
+void CMcKModSim::reapWsm(void)
+{
+    // Processes that died without closing leave their WSM behind
+    for (uint32_t i = 0; i < SIM_WSM_MAX; i++) {
+        simWsm_t *wsm = &kernel->wsm[i];
+        if (wsm->handle != 0 && kill(wsm->ownerPid, 0) != 0 && errno == ESRCH) {
+            LOG_I(" Dropping WSM %u of gone process %d", wsm->handle, wsm->ownerPid);
+            releaseWsm(wsm);
+        }
+    }
+}
+
+
+//------------------------------------------------------------------------------
+mcResult_t CMcKModSim::mapWsm(
+    uint32_t    len,
+    uint32_t    *pHandle,
+    addr_t      *pVirtAddr,
+    uint64_t    *pPhysAddr)
+{
+    LOG_V(" mapWsm(): len=%d", len);
+
+    if (!isOpen()) {
+        LOG_E("no connection to kmod");
+        return MC_DRV_ERR_KMOD_NOT_OPEN;
+    }
+
+    lockKernel();
+    simWsm_t *wsm = allocWsm(WSM_CONTIGUOUS, len);
+    uint32_t handle = (wsm != NULL) ? wsm->handle : 0;
+    unlockKernel();
+    if (wsm == NULL) {
+        return MAKE_MC_DRV_KMOD_WITH_ERRNO(ENOMEM);
+    }
+
+    int err = 0;
+    addr_t virtAddr = MAP_FAILED;
+    int fd = ::open(getWsmPath(handle).c_str(), O_RDWR | O_CREAT | O_TRUNC, 0660);
+    if (fd == -1) {
+        err = errno;
+    } else {
+        if (ftruncate(fd, len) != 0) {
+            err = errno;
+        } else {
+            virtAddr = ::mmap(0, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (virtAddr == MAP_FAILED) {
+                err = errno;
+            }
+        }
+        ::close(fd);
+    }
+
+    if (err != 0) {
+        LOG_E("backing WSM %u failed: %s", handle, strerror(err));
+        lockKernel();
+        wsm = lookupWsm(handle, WSM_CONTIGUOUS);
+        if (wsm != NULL) {
+            releaseWsm(wsm);
+        }
+        unlockKernel();
+        return MAKE_MC_DRV_KMOD_WITH_ERRNO(err);
+    }
+
+    LOG_V(" mapped to %p, handle=%d", virtAddr, handle);
+
+    if (pVirtAddr != NULL) {
+        *pVirtAddr = virtAddr;
+    }
+
+    if (pHandle != NULL) {
+        *pHandle = handle;
+    }
+
+    if (pPhysAddr != NULL) {
+        *pPhysAddr = SIM_PHYS(handle, 0);
+    }
+
+    return MC_DRV_OK;
+}
+
+
+//------------------------------------------------------------------------------
+mcResult_t CMcKModSim::mapMCI(
+    uint32_t    len,
+    uint32_t    *pHandle,
+    addr_t      *pVirtAddr,
+    uint64_t    *pPhysAddr,
+    bool        *pReuse)
+{
+    LOG_I("Mapping simulated MCI: len=%d", len);
+
+    if (!isOpen()) {
+        LOG_E("no connection to kmod");
+        return MC_DRV_ERR_KMOD_NOT_OPEN;
+    }
+
+    if (mci != NULL) {
+        LOG_E("MCI already mapped");
+        return MAKE_MC_DRV_KMOD_WITH_ERRNO(EEXIST);
+    }
+
+    // Only the SWd threads of this process look at the MCI
+    addr_t virtAddr = ::mmap(0, len, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (virtAddr == MAP_FAILED) {
+        LOG_ERRNO("mmap");
+        return MAKE_MC_DRV_KMOD_WITH_ERRNO(errno);
+    }
+    mci = virtAddr;
+    mciLen = len;
+
+    lockKernel();
+    uint32_t handle = kernel->nextHandle++;
+    unlockKernel();
+
+    // The SWd does not survive the daemon, so there is nothing to reuse
+    *pReuse = false;
+
+    if (pVirtAddr != NULL) {
+        *pVirtAddr = virtAddr;
+    }
+
+    if (pHandle != NULL) {
+        *pHandle = handle;
+    }
+
+    if (pPhysAddr != NULL) {
+        *pPhysAddr = SIM_PHYS(handle, 0);
+    }
+
+    return MC_DRV_OK;
+}
+
+
+//------------------------------------------------------------------------------
+int CMcKModSim::read(addr_t buffer, uint32_t len)
+{
+    if (swd == NULL || len < sizeof(uint32_t)) {
+        LOG_E("no simulated SWd to wait for");
+        errno = EINVAL;
+        return -1;
+    }
+
+    ssiqCount = swd->waitSsiq(ssiqCount);
+    memcpy(buffer, &ssiqCount, sizeof(ssiqCount));
+    return sizeof(ssiqCount);
+}
+
+
+//------------------------------------------------------------------------------
+int CMcKModSim::fcInit(uint32_t nqLength, uint32_t mcpOffset, uint32_t mcpLength)
+{
+    if (!isOpen()) {
+        return MC_DRV_ERR_KMOD_NOT_OPEN;
+    }
+
+    if (mci == NULL || swd != NULL
+            || nqLength > mcpOffset || mcpOffset + mcpLength > mciLen
+            || mcpLength < sizeof(mcpBuffer_t)) {
+        LOG_E("bad simulated MCI setup");
+        return -1;
+    }
+
+    swd = new SimSecureWorld(this, mci, nqLength, mcpOffset, mcpLength);
+    if (!swd->start()) {
+        delete swd;
+        swd = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+
+//------------------------------------------------------------------------------
+int CMcKModSim::fcInfo(uint32_t extInfoId, uint32_t *pState, uint32_t *pExtInfo)
+{
+    uint32_t state = MC_STATUS_NOT_INITIALIZED;
+    uint32_t extInfo = 0;
+
+    if (!isOpen()) {
+        LOG_E("no connection to kmod");
+        return MC_DRV_ERR_KMOD_NOT_OPEN;
+    }
+
+    if (swd != NULL) {
+        swd->info(extInfoId, &state, &extInfo);
+    }
+
+    if (pState != NULL) {
+        *pState = state;
+    }
+
+    if (pExtInfo != NULL) {
+        *pExtInfo = extInfo;
+    }
+
+    return 0;
+}
+
+
+//------------------------------------------------------------------------------
+int CMcKModSim::fcYield(void)
+{
+    if (swd == NULL) {
+        LOG_E("no simulated SWd");
+        return -1;
+    }
+
+    // The SWd runs on threads of its own, just hand over the CPU
+    sched_yield();
+    return 0;
+}
+
+
+//------------------------------------------------------------------------------
+int CMcKModSim::fcNSIQ(void)
+{
+    if (swd == NULL) {
+        LOG_E("no simulated SWd");
+        return -1;
+    }
+
+    swd->nsiq();
+    return 0;
+}
+
+
+//------------------------------------------------------------------------------
+mcResult_t CMcKModSim::free(uint32_t handle, addr_t buffer, uint32_t len)
+{
+    LOG_V("free(): handle=%d", handle);
+
+    if (!isOpen()) {
+        LOG_E("no connection to kmod");
+        return MC_DRV_ERR_KMOD_NOT_OPEN;
+    }
+
+    // Even if unmap fails we still go on with our request
+    if (::munmap(buffer, len)) {
+        LOG_I("buffer = %p, len = %d", buffer, len);
+        LOG_ERRNO("mmap failed");
+    }
+
+    lockKernel();
+    simWsm_t *wsm = lookupWsm(handle, WSM_CONTIGUOUS);
+    if (wsm == NULL || wsm->owner != owner) {
+        unlockKernel();
+        LOG_E("no WSM with handle %u", handle);
+        return MAKE_MC_DRV_KMOD_WITH_ERRNO(EINVAL);
+    }
+    releaseWsm(wsm);
+    unlockKernel();
+
+    return MC_DRV_OK;
+}
+
+
+//------------------------------------------------------------------------------
+mcResult_t CMcKModSim::registerWsmL2(
+    addr_t      buffer,
+    uint32_t    len,
+    uint32_t    pid,
+    uint32_t    *pHandle,
+    uint64_t    *pPhysWsmL2)
+{
+    LOG_I(" Registering virtual buffer at %p, len=%d as simulated World Shared Memory", buffer, len);
+
+    if (!isOpen()) {
+        LOG_E("no connection to kmod");
+        return MC_DRV_ERR_KMOD_NOT_OPEN;
+    }
+
+    // Pinning the pages does not hold the kernel lock
+    if (l2LatencyUs > 0) {
+        usleep(l2LatencyUs);
+    }
+
+    lockKernel();
+    simWsm_t *wsm = allocWsm(WSM_L2, len);
+    if (wsm == NULL) {
+        unlockKernel();
+        return MAKE_MC_DRV_KMOD_WITH_ERRNO(ENOMEM);
+    }
+    if (pid != 0) {
+        wsm->pid = pid;
+    }
+    wsm->addr = (uintptr_t)buffer;
+    uint32_t handle = wsm->handle;
+    unlockKernel();
+
+    LOG_I(" Registered, handle=%d", handle);
+
+    if (pHandle != NULL) {
+        *pHandle = handle;
+    }
+
+    if (pPhysWsmL2 != NULL) {
+        *pPhysWsmL2 = SIM_PHYS(handle, 0);
+    }
+
+    return MC_DRV_OK;
+}
+
+
+//------------------------------------------------------------------------------
+mcResult_t CMcKModSim::unregisterWsmL2(uint32_t handle)
+{
+    LOG_I(" Unregistering simulated World Shared Memory with handle %d", handle);
+
+    if (!isOpen()) {
+        LOG_E("no connection to kmod");
+        return MC_DRV_ERR_KMOD_NOT_OPEN;
+    }
+
+    if (l2LatencyUs > 0) {
+        usleep(l2LatencyUs);
+    }
+
+    lockKernel();
+    simWsm_t *wsm = lookupWsm(handle, WSM_L2);
+    if (wsm == NULL) {
+        unlockKernel();
+        LOG_E("no L2 WSM with handle %u", handle);
+        return MAKE_MC_DRV_KMOD_WITH_ERRNO(EINVAL);
+    }
+    releaseWsm(wsm);
+    unlockKernel();
+
+    return MC_DRV_OK;
+}
+
+
+//------------------------------------------------------------------------------
+mcResult_t CMcKModSim::lockWsmL2(uint32_t handle)
+{
+    if (!isOpen()) {
+        LOG_E("no connection to kmod");
+        return MC_DRV_ERR_KMOD_NOT_OPEN;
+    }
+
+    lockKernel();
+    simWsm_t *wsm = lookupWsm(handle, WSM_INVALID);
+    if (wsm != NULL) {
+        wsm->locks++;
+    }
+    unlockKernel();
+
+    if (wsm == NULL) {
+        LOG_E("no WSM with handle %u", handle);
+        return MAKE_MC_DRV_KMOD_WITH_ERRNO(EINVAL);
+    }
+    return MC_DRV_OK;
+}
+
+
+//------------------------------------------------------------------------------
+mcResult_t CMcKModSim::unlockWsmL2(uint32_t handle)
+{
+    if (!isOpen()) {
+        LOG_E("no connection to kmod");
+        return MC_DRV_ERR_KMOD_NOT_OPEN;
+    }
+
+    lockKernel();
+    simWsm_t *wsm = lookupWsm(handle, WSM_INVALID);
+    if (wsm != NULL && wsm->locks > 0) {
+        wsm->locks--;
+    }
+    unlockKernel();
+
+    // Failure here is not really important
+    if (wsm == NULL) {
+        LOG_I("no WSM with handle %u", handle);
+        return MAKE_MC_DRV_KMOD_WITH_ERRNO(EINVAL);
+    }
+    return MC_DRV_OK;
+}
+
+
+//------------------------------------------------------------------------------
+mcResult_t CMcKModSim::cleanupWsmL2(void)
+{
+    LOG_I(" Cleaning up the orphaned bulk buffers");
+
+    if (!isOpen()) {
+        LOG_E("no connection to kmod");
+        return MC_DRV_ERR_KMOD_NOT_OPEN;
+    }
+
+    lockKernel();
+    reapWsm();
+    unlockKernel();
+    return MC_DRV_OK;
+}
+
+
+//------------------------------------------------------------------------------
+uint64_t CMcKModSim::findWsmL2(uint32_t handle, int fd)
+{
+    if (!isOpen()) {
+        LOG_E("no connection to kmod");
+        return 0;
+    }
+
+    lockKernel();
+    simWsm_t *wsm = lookupWsm(handle, WSM_L2);
+    unlockKernel();
+
+    return (wsm != NULL) ? SIM_PHYS(handle, 0) : 0;
+}
+
+
+//------------------------------------------------------------------------------
+mcResult_t CMcKModSim::findContiguousWsm(uint32_t handle, int fd, uint64_t *phys, uint32_t *len)
+{
+    if (!isOpen()) {
+        LOG_E("no connection to kmod");
+        return MC_DRV_ERR_KMOD_NOT_OPEN;
+    }
+
+    lockKernel();
+    simWsm_t *wsm = lookupWsm(handle, WSM_CONTIGUOUS);
+    if (wsm != NULL) {
+        *phys = SIM_PHYS(handle, 0);
+        *len = wsm->len;
+    }
+    unlockKernel();
+
+    return (wsm != NULL) ? MC_DRV_OK : MAKE_MC_DRV_KMOD_WITH_ERRNO(EINVAL);
+}
+
+
+//------------------------------------------------------------------------------
+mcResult_t CMcKModSim::setupLog(void)
+{
+    // The simulated SWd logs through the daemon
+    return MC_DRV_OK;
+}
+
+
+//------------------------------------------------------------------------------
+bool CMcKModSim::checkVersion(void)
+{
+    if (!isOpen()) {
+        LOG_E("no connection to kmod");
+        return false;
+    }
+
+    LOG_I("Using the simulated kernel module, there is no MobiCore device");
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+bool CMcKModSim::findWsm(
+    uint32_t    handle,
+    simWsm_t    *wsm
+)
+{
+    lockKernel();
+    simWsm_t *entry = lookupWsm(handle, WSM_INVALID);
+    if (entry != NULL) {
+        *wsm = *entry;
+    }
+    unlockKernel();
+    return (entry != NULL);
+}
+
+/** @} */
@@ -0,0 +1,221 @@
+/** @addtogroup MCD_MCDIMPL_DAEMON_KERNEL
+ * @{
+ * @file
+ *
+ * Simulated <t-base Driver Kernel Module.
+ *
+ *
+ * Copyright (c) 2013 TRUSTONIC LIMITED
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the TRUSTONIC LIMITED nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef CMCKMODSIM_H_
+#define CMCKMODSIM_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <string>
+
+#include "McTypes.h"
+#include "CMcKMod.h"
+
+#define SIM_ENV_DIR         "MC_SIM_DIR"    /**< Directory of the simulated kernel state */
+#define SIM_DEFAULT_DIR     "/dev/shm"
+#define SIM_KERNEL_FILE     "mcsim.kmod"    /**< WSM table shared by all processes */
+#define SIM_WSM_FILE        "mcsim.wsm.%u"  /**< Backing file of a contiguous WSM */
+#define SIM_WSM_MAX         1024            /**< WSM the simulated kernel keeps track of */
+#define SIM_KERNEL_MAGIC    0x4D43534D      /**< "MCSM" */
+#define SIM_ENV_KMOD_LATENCY "MC_SIM_KMOD_LATENCY_US" /**< Time the kernel module takes to pin and register or to unregister an L2 buffer */
+
+/** Simulated physical addresses carry the WSM handle in the upper word. */
+#define SIM_PHYS(handle, offset)    (((uint64_t)(handle) << 32) | (uint32_t)(offset))
+#define SIM_PHYS_HANDLE(phys)       ((uint32_t)((phys) >> 32))
+#define SIM_PHYS_OFFSET(phys)       ((uint32_t)(phys))
+
+/**
+ * A WSM known to the simulated kernel module.
+ */
+typedef struct {
+    uint32_t    handle;     /**< WSM handle, 0 for an unused entry. */
+    uint32_t    type;       /**< WSM_CONTIGUOUS or WSM_L2. */
+    uint32_t    owner;      /**< Kernel module instance that created the WSM. */
+    pid_t       ownerPid;   /**< Process of the owner. */
+    pid_t       pid;        /**< Process the memory of an L2 WSM lives in. */
+    uint64_t    addr;       /**< Address of an L2 WSM in pid. */
+    uint32_t    len;        /**< Length of the WSM. */
+    uint32_t    locks;      /**< Number of lockWsmL2() calls not undone. */
+} simWsm_t;
+
+/**
+ * State of the simulated kernel module shared by all processes.
+ */
+typedef struct {
+    uint32_t    magic;      /**< SIM_KERNEL_MAGIC once initialized. */
+    uint32_t    nextHandle; /**< Next WSM handle to hand out. */
+    uint32_t    nextOwner;  /**< Next kernel module instance ID. */
+    simWsm_t    wsm[SIM_WSM_MAX];
+} simKernel_t;
+
+class SimSecureWorld;
+
+/**
+ * Kernel module backend that runs without a MobiCore device.
+ *
+ * The WSM table lives in a file in the MC_SIM_DIR directory that all
+ * processes using the simulator map, contiguous WSM are backed by files of
+ * their own, so a client library and the daemon can share them like kernel
+ * memory. L2
+ * registrations keep the address of the buffer in the registering process.
+ *
+ * The instance that calls fcInit() starts a SimSecureWorld on the MCI
+ * buffer from mapMCI(), the fastcalls and S-SIQs of that instance go to it.
+ */
+class CMcKModSim : public CMcKMod
+{
+
+public:
+
+    CMcKModSim(
+        void
+    );
+
+    virtual ~CMcKModSim(
+        void
+    );
+
+    mcResult_t open(
+        const char *deviceName
+    );
+
+    void close(
+        void
+    );
+
+    mcResult_t mapWsm(
+        uint32_t    len,
+        uint32_t    *pHandle,
+        addr_t      *pVirtAddr,
+        uint64_t    *pPhysAddr);
+
+    mcResult_t mapMCI(
+        uint32_t    len,
+        uint32_t    *pHandle,
+        addr_t      *pVirtAddr,
+        uint64_t    *pPhysAddr,
+        bool        *pReuse);
+
+    /** Blocks until the simulated SWd raises an S-SIQ and returns the S-SIQ
+     * counter, like reading the device node.
+     */
+    int read(addr_t buffer, uint32_t len);
+
+    int fcInit(
+        uint32_t    nqLength,
+        uint32_t    mcpOffset,
+        uint32_t    mcpLength);
+
+    int fcInfo(
+        uint32_t    extInfoId,
+        uint32_t    *pState,
+        uint32_t    *pExtInfo);
+
+    int fcYield(void);
+
+    int fcNSIQ(void);
+
+    mcResult_t free(uint32_t handle, addr_t buffer, uint32_t len);
+
+    mcResult_t registerWsmL2(
+        addr_t      buffer,
+        uint32_t    len,
+        uint32_t    pid,
+        uint32_t    *pHandle,
+        uint64_t    *pPhysWsmL2);
+
+    mcResult_t unregisterWsmL2(uint32_t handle);
+
+    mcResult_t lockWsmL2(uint32_t handle);
+
+    mcResult_t unlockWsmL2(uint32_t handle);
+
+    mcResult_t cleanupWsmL2(void);
+
+    uint64_t findWsmL2(uint32_t handle, int fd);
+
+    mcResult_t findContiguousWsm(uint32_t handle, int fd, uint64_t *phys, uint32_t *len);
+
+    mcResult_t setupLog(void);
+
+    bool checkVersion(void);
+
+    /** Looks up a WSM for the simulated SWd.
+     *
+     * @param handle WSM handle.
+     * @param[out] wsm Copy of the table entry.
+     * @return false if there is no WSM with this handle.
+     */
+    bool findWsm(
+        uint32_t    handle,
+        simWsm_t    *wsm
+    );
+
+    /** Returns the path of a file of the simulated kernel.
+     *
+     * @param name File name.
+     */
+    static std::string getPath(
+        const char  *name
+    );
+
+private:
+
+    simKernel_t         *kernel; /**< Shared WSM table. */
+    uint32_t            owner; /**< Identifies the WSM of this instance. */
+    uint32_t            ssiqCount; /**< S-SIQs seen by read(). */
+    addr_t              mci;
+    uint32_t            mciLen;
+    SimSecureWorld      *swd;
+    uint32_t            l2LatencyUs; /**< Time an L2 registration or unregistration takes. */
+
+    void lockKernel(void);
+
+    void unlockKernel(void);
+
+    simWsm_t *lookupWsm(uint32_t handle, uint32_t type);
+
+    simWsm_t *allocWsm(uint32_t type, uint32_t len);
+
+    void releaseWsm(simWsm_t *wsm);
+
+    void reapWsm(void);
+
+};
+
+#endif // CMCKMODSIM_H_
+
+/** @} */
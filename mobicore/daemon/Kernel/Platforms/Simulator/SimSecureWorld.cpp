@@ -0,0 +1,948 @@
+/** @addtogroup MCD_MCDIMPL_DAEMON_KERNEL
+ * @{
+ * @file
+ *
+ * Secure world of the simulated <t-base Driver Kernel Module.
+ *
+ *
+ * Copyright (c) 2013 TRUSTONIC LIMITED
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the TRUSTONIC LIMITED nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <stdint.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+
+#include "McTypes.h"
+#include "mcVersionHelper.h"
+#include "mcSo.h"
+#include "mcLoadFormat.h"
+#include "mcContainer.h"
+#include "tee_client_api.h"
+#include "MobiCoreDriverApi.h"
+#include "GpTci.h"
+
+#include "CMcKModSim.h"
+#include "SimSecureWorld.h"
+
+#include "log.h"
+
+#define _TEEC_GET_PARAM_TYPE(t, i) (((t) >> (4*i)) & 0xF)
+
+//------------------------------------------------------------------------------
+static uint32_t getLatency(
+    const char  *name
+)
+{
+    const char *value = getenv(name);
+    return (value != NULL) ? (uint32_t)strtoul(value, NULL, 0) : 0;
+}
+
+
+//------------------------------------------------------------------------------
+SimSecureWorld::SimSecureWorld(
+    CMcKModSim  *kmod,
+    addr_t      mci,
+    uint32_t    nqLength,
+    uint32_t    mcpOffset,
+    uint32_t    mcpLength
+)
+{
+    this->kmod = kmod;
+    nqIn = (notificationQueue_t *)mci;
+    nqOut = (notificationQueue_t *)((uint8_t *)mci + nqLength / 2);
+    mcp = (mcpBuffer_t *)((uint8_t *)mci + mcpOffset);
+    status = MC_STATUS_NOT_INITIALIZED;
+    taLatencyUs = getLatency(SIM_ENV_TA_LATENCY);
+    mcpLatencyUs = getLatency(SIM_ENV_MCP_LATENCY);
+
+    pthread_mutex_init(&mutex, NULL);
+    pthread_cond_init(&cond, NULL);
+    threadStarted = false;
+    stopping = false;
+    nsiqCount = 0;
+    ssiqCount = 0;
+    busy = 0;
+    nextSessionId = 1;
+}
+
+
+//------------------------------------------------------------------------------
+SimSecureWorld::~SimSecureWorld(
+    void
+)
+{
+    if (threadStarted) {
+        pthread_mutex_lock(&mutex);
+        stopping = true;
+        pthread_cond_broadcast(&cond);
+        pthread_mutex_unlock(&mutex);
+        pthread_join(thread, NULL);
+    }
+
+    while (!sessions.empty()) {
+        closeSession(sessions.begin()->first);
+    }
+
+    pthread_cond_destroy(&cond);
+    pthread_mutex_destroy(&mutex);
+}
+
+
+//------------------------------------------------------------------------------
+bool SimSecureWorld::start(
+    void
+)
+{
+    LOG_I(" Starting simulated SWd, TA latency %uus, MCP latency %uus",
+          taLatencyUs, mcpLatencyUs);
+    if (pthread_create(&thread, NULL, run, this) != 0) {
+        LOG_ERRNO("pthread_create");
+        return false;
+    }
+    threadStarted = true;
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+void SimSecureWorld::nsiq(
+    void
+)
+{
+    pthread_mutex_lock(&mutex);
+    nsiqCount++;
+    pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&mutex);
+}
+
+
+//------------------------------------------------------------------------------
+uint32_t SimSecureWorld::waitSsiq(
+    uint32_t seen
+)
+{
+    pthread_mutex_lock(&mutex);
+    while (ssiqCount == seen && !stopping) {
+        pthread_cond_wait(&cond, &mutex);
+    }
+    uint32_t count = ssiqCount;
+    pthread_mutex_unlock(&mutex);
+    return count;
+}
+
+
+//------------------------------------------------------------------------------
+void SimSecureWorld::info(
+    uint32_t    extInfoId,
+    uint32_t    *pState,
+    uint32_t    *pExtInfo
+)
+{
+    pthread_mutex_lock(&mutex);
+    *pState = status;
+    switch (extInfoId) {
+    case MC_EXT_INFO_ID_MCI_VERSION:
+        *pExtInfo = MC_MAKE_VERSION(MCI_VERSION_MAJOR, MCI_VERSION_MINOR);
+        break;
+    case MC_EXT_INFO_ID_MC_CONFIGURED:
+        *pExtInfo = (status == MC_STATUS_INITIALIZED) ? 1 : 0;
+        break;
+    case MC_EXT_INFO_ID_MC_SCHED_STATUS:
+        *pExtInfo = (busy > 0) ? MC_FLAG_SCHEDULE_NON_IDLE : MC_FLAG_SCHEDULE_IDLE;
+        break;
+    case MC_EXT_INFO_ID_MC_STATUS:
+        *pExtInfo = status;
+        break;
+    default:
+        // There are no faults or halts to report
+        *pExtInfo = 0;
+        break;
+    }
+    pthread_mutex_unlock(&mutex);
+}
+
+
+//------------------------------------------------------------------------------
+void *SimSecureWorld::run(void *arg)
+{
+    SimSecureWorld *swd = (SimSecureWorld *)arg;
+    uint32_t seen = 0;
+
+    pthread_mutex_lock(&swd->mutex);
+    for (;;) {
+        while (swd->nsiqCount == seen && !swd->stopping) {
+            pthread_cond_wait(&swd->cond, &swd->mutex);
+        }
+        if (swd->stopping) {
+            break;
+        }
+        seen = swd->nsiqCount;
+        // The first N-SIQ after fcInit() completes the initialization
+        swd->status = MC_STATUS_INITIALIZED;
+        pthread_mutex_unlock(&swd->mutex);
+
+        swd->handleNotifications();
+
+        pthread_mutex_lock(&swd->mutex);
+    }
+    pthread_mutex_unlock(&swd->mutex);
+    return NULL;
+}
+
+
+//------------------------------------------------------------------------------
+void SimSecureWorld::handleNotifications(
+    void
+)
+{
+    // The daemon sets up the queues after the first N-SIQ
+    uint32_t queueSize = __atomic_load_n(&nqIn->hdr.queueSize, __ATOMIC_ACQUIRE);
+    if (queueSize == 0) {
+        return;
+    }
+
+    for (;;) {
+        uint32_t readCnt = nqIn->hdr.readCnt;
+        uint32_t writeCnt = __atomic_load_n(&nqIn->hdr.writeCnt, __ATOMIC_ACQUIRE);
+        if (readCnt == writeCnt) {
+            break;
+        }
+        notification_t notification = nqIn->notification[readCnt & (queueSize - 1)];
+        __atomic_store_n(&nqIn->hdr.readCnt, readCnt + 1, __ATOMIC_RELEASE);
+
+        if (notification.sessionId == SID_MCP) {
+            handleMcp();
+            continue;
+        }
+
+        pthread_mutex_lock(&mutex);
+        simSessionMap_t::iterator it = sessions.find(notification.sessionId);
+        if (it != sessions.end()) {
+            it->second->pending++;
+            pthread_cond_signal(&it->second->cond);
+        }
+        pthread_mutex_unlock(&mutex);
+
+        if (it == sessions.end()) {
+            LOG_W(" Notification for unknown session %u", notification.sessionId);
+            raiseNotification(notification.sessionId, ERR_INVALID_SID);
+        }
+    }
+}
+
+
+//------------------------------------------------------------------------------
+void SimSecureWorld::handleMcp(
+    void
+)
+{
+    mcpMessage_t *msg = &mcp->mcpMessage;
+    uint32_t cmdId = msg->cmdHeader.cmdId;
+    mcpResult_t result = MC_MCP_RET_OK;
+
+    setBusy(true);
+    if (mcpLatencyUs > 0) {
+        usleep(mcpLatencyUs);
+    }
+
+    switch (cmdId) {
+    case MC_MCP_CMD_GET_MOBICORE_VERSION: {
+        mcVersionInfo_t *versionInfo = &msg->rspGetMobiCoreVersion.versionInfo;
+        memset(versionInfo, 0, sizeof(*versionInfo));
+        strncpy(versionInfo->productId, "t-base-SIMULATOR",
+                sizeof(versionInfo->productId) - 1);
+        versionInfo->versionMci = MC_MAKE_VERSION(MCI_VERSION_MAJOR, MCI_VERSION_MINOR);
+        versionInfo->versionSo = MC_MAKE_VERSION(SO_VERSION_MAJOR, SO_VERSION_MINOR);
+        versionInfo->versionMclf = MC_MAKE_VERSION(MCLF_VERSION_MAJOR, MCLF_VERSION_MINOR);
+        versionInfo->versionContainer = MC_MAKE_VERSION(CONTAINER_VERSION_MAJOR, CONTAINER_VERSION_MINOR);
+        break;
+    }
+    case MC_MCP_CMD_OPEN_SESSION: {
+        uint32_t sessionId = 0;
+        result = openSession(&msg->cmdOpen, &sessionId);
+        msg->rspOpen.sessionId = sessionId;
+        break;
+    }
+    case MC_MCP_CMD_CLOSE_SESSION:
+        result = closeSession(msg->cmdClose.sessionId);
+        break;
+    case MC_MCP_CMD_MAP: {
+        uint32_t secureVirtualAdr = 0;
+        result = map(&msg->cmdMap, &secureVirtualAdr);
+        msg->rspMap.secureVirtualAdr = secureVirtualAdr;
+        break;
+    }
+    case MC_MCP_CMD_UNMAP:
+        result = unmap(&msg->cmdUnmap);
+        break;
+    case MC_MCP_CMD_CHECK_LOAD_TA:
+    case MC_MCP_CMD_LOAD_TOKEN:
+    case MC_MCP_CMD_SUSPEND:
+    case MC_MCP_CMD_RESUME:
+    case MC_MCP_CMD_CLOSE_MCP:
+        // Nothing to load, verify or power down
+        break;
+    default:
+        LOG_E(" Unknown MCP command %#x", cmdId);
+        result = MC_MCP_RET_ERR_UNKNOWN_COMMAND;
+        break;
+    }
+
+    msg->rspHeader.result = result;
+    msg->rspHeader.rspId = cmdId | FLAG_RESPONSE;
+    setBusy(false);
+    raiseNotification(SID_MCP, 0);
+}
+
+
+//------------------------------------------------------------------------------
+mcpResult_t SimSecureWorld::openSession(
+    mcpCmdOpen_t    *cmd,
+    uint32_t        *sessionId
+)
+{
+    simSession_t *session = new simSession_t;
+    memset(&session->tci, 0, sizeof(session->tci));
+    pthread_cond_init(&session->cond, NULL);
+    session->pending = 0;
+    session->closing = false;
+    session->nextSlot = 0;
+    session->swd = this;
+
+    if ((cmd->wsmTypeTci & WSM_TYPE_MASK) != WSM_INVALID
+            && !mapBuffer(cmd->wsmTypeTci & WSM_TYPE_MASK, cmd->adrTciBuffer,
+                          cmd->ofsTciBuffer, cmd->lenTciBuffer, &session->tci)) {
+        LOG_E(" Cannot map TCI of new session");
+        pthread_cond_destroy(&session->cond);
+        delete session;
+        return MC_MCP_RET_ERR_INVALID_WSM;
+    }
+
+    pthread_mutex_lock(&mutex);
+    session->id = nextSessionId++;
+    sessions[session->id] = session;
+    pthread_mutex_unlock(&mutex);
+
+    if (pthread_create(&session->thread, NULL, runSession, session) != 0) {
+        LOG_ERRNO("pthread_create");
+        pthread_mutex_lock(&mutex);
+        sessions.erase(session->id);
+        pthread_mutex_unlock(&mutex);
+        unmapBuffer(&session->tci);
+        pthread_cond_destroy(&session->cond);
+        delete session;
+        return MC_MCP_RET_ERR_OUT_OF_RESOURCES;
+    }
+
+    LOG_V(" Opened simulated session %u", session->id);
+    *sessionId = session->id;
+    return MC_MCP_RET_OK;
+}
+
+
+//------------------------------------------------------------------------------
+mcpResult_t SimSecureWorld::closeSession(
+    uint32_t    sessionId
+)
+{
+    pthread_mutex_lock(&mutex);
+    simSessionMap_t::iterator it = sessions.find(sessionId);
+    if (it == sessions.end()) {
+        pthread_mutex_unlock(&mutex);
+        return MC_MCP_RET_ERR_INVALID_SESSION;
+    }
+    simSession_t *session = it->second;
+    sessions.erase(it);
+    session->closing = true;
+    pthread_cond_signal(&session->cond);
+    pthread_mutex_unlock(&mutex);
+
+    pthread_join(session->thread, NULL);
+
+    for (simMappingMap_t::iterator m = session->mappings.begin();
+            m != session->mappings.end(); m++) {
+        unmapBuffer(&m->second.buf);
+    }
+    unmapBuffer(&session->tci);
+    pthread_cond_destroy(&session->cond);
+    delete session;
+
+    LOG_V(" Closed simulated session %u", sessionId);
+    return MC_MCP_RET_OK;
+}
+
+
+//------------------------------------------------------------------------------
+mcpResult_t SimSecureWorld::map(
+    mcpCmdMap_t *cmd,
+    uint32_t    *secureVirtualAdr
+)
+{
+    if (cmd->lenBuffer == 0 || cmd->lenBuffer > MCP_MAP_MAX
+            || cmd->ofsBuffer >= SIM_SVA_SLOT_SIZE - MCP_MAP_MAX) {
+        return MC_MCP_RET_ERR_INVALID_MAPPING_LENGTH;
+    }
+
+    pthread_mutex_lock(&mutex);
+    simSessionMap_t::iterator it = sessions.find(cmd->sessionId);
+    simSession_t *session = (it != sessions.end()) ? it->second : NULL;
+    pthread_mutex_unlock(&mutex);
+    if (session == NULL) {
+        return MC_MCP_RET_ERR_INVALID_SESSION;
+    }
+
+    simMapping_t mapping;
+    if (!mapBuffer(cmd->wsmType & WSM_TYPE_MASK, cmd->adrBuffer, cmd->ofsBuffer,
+                   cmd->lenBuffer, &mapping.buf)) {
+        return MC_MCP_RET_ERR_INVALID_WSM;
+    }
+    mapping.offset = cmd->ofsBuffer;
+
+    // Only the SWd thread changes mappings, the TA thread reads them
+    pthread_mutex_lock(&mutex);
+    uint32_t slot = session->nextSlot;
+    for (uint32_t i = 0; i < SIM_SVA_SLOTS; i++, slot = (slot + 1) % SIM_SVA_SLOTS) {
+        if (session->mappings.find(slot) == session->mappings.end()) {
+            break;
+        }
+    }
+    bool found = (session->mappings.find(slot) == session->mappings.end());
+    if (found) {
+        session->mappings[slot] = mapping;
+        session->nextSlot = (slot + 1) % SIM_SVA_SLOTS;
+    }
+    pthread_mutex_unlock(&mutex);
+
+    if (!found) {
+        unmapBuffer(&mapping.buf);
+        return MC_MCP_RET_ERR_OUT_OF_RESOURCES;
+    }
+
+    *secureVirtualAdr = SIM_SVA_BASE + slot * SIM_SVA_SLOT_SIZE + cmd->ofsBuffer;
+    return MC_MCP_RET_OK;
+}
+
+
+//------------------------------------------------------------------------------
+mcpResult_t SimSecureWorld::unmap(
+    mcpCmdUnmap_t   *cmd
+)
+{
+    uint32_t slot = (cmd->secureVirtualAdr - SIM_SVA_BASE) / SIM_SVA_SLOT_SIZE;
+    simMapping_t mapping;
+    mcpResult_t result = MC_MCP_RET_OK;
+
+    pthread_mutex_lock(&mutex);
+    simSessionMap_t::iterator it = sessions.find(cmd->sessionId);
+    if (it == sessions.end()) {
+        result = MC_MCP_RET_ERR_INVALID_SESSION;
+    } else {
+        simMappingMap_t::iterator m = it->second->mappings.find(slot);
+        if (cmd->secureVirtualAdr < SIM_SVA_BASE || m == it->second->mappings.end()) {
+            result = MC_MCP_RET_ERR_INVALID_PARAM;
+        } else {
+            mapping = m->second;
+            it->second->mappings.erase(m);
+        }
+    }
+    pthread_mutex_unlock(&mutex);
+
+    if (result == MC_MCP_RET_OK) {
+        unmapBuffer(&mapping.buf);
+    }
+    return result;
+}
+
+
+//------------------------------------------------------------------------------
+void *SimSecureWorld::runSession(void *arg)
+{
+    simSession_t *session = (simSession_t *)arg;
+    SimSecureWorld *swd = session->swd;
+
+    for (;;) {
+        pthread_mutex_lock(&swd->mutex);
+        while (session->pending == 0 && !session->closing) {
+            pthread_cond_wait(&session->cond, &swd->mutex);
+        }
+        if (session->closing) {
+            pthread_mutex_unlock(&swd->mutex);
+            break;
+        }
+        session->pending--;
+        pthread_mutex_unlock(&swd->mutex);
+
+        swd->setBusy(true);
+        if (swd->taLatencyUs > 0) {
+            usleep(swd->taLatencyUs);
+        }
+        swd->runEchoTa(session);
+        swd->setBusy(false);
+
+        // The TA consumed what came meanwhile, only the answer is pending
+        pthread_mutex_lock(&swd->mutex);
+        session->pending = 0;
+        pthread_mutex_unlock(&swd->mutex);
+        swd->raiseNotification(session->id, 0);
+    }
+    return NULL;
+}
+
+
+//------------------------------------------------------------------------------
+void SimSecureWorld::runEchoTa(
+    simSession_t    *session
+)
+{
+    char header[sizeof(((_TEEC_TCI *)0)->header)];
+
+    if (session->tci.len >= sizeof(_TEEC_TCI)
+            && readBuffer(&session->tci, 0, header, sizeof(header))
+            && memcmp(header, "TCIGP000", sizeof(header)) == 0) {
+        runGpEchoTa(session);
+        return;
+    }
+
+    uint32_t words[2];
+    if (readBuffer(&session->tci, 0, words, sizeof(words))) {
+        words[0] |= SIM_RSP_ID_MASK;
+        words[1] = 0;
+        writeBuffer(&session->tci, 0, words, sizeof(words));
+    }
+}
+
+
+//------------------------------------------------------------------------------
+void SimSecureWorld::runGpEchoTa(
+    simSession_t    *session
+)
+{
+    _TEEC_TCI tci;
+    if (!readBuffer(&session->tci, 0, &tci, sizeof(tci))) {
+        return;
+    }
+
+    _TEEC_OperationInternal *op = &tci.operation;
+    int valueIn = -1;
+    int memrefIn = -1;
+    simBuffer_t in;
+
+    if (op->commandId == SIM_GP_CMD_SLEEP) {
+        for (int i = 0; i < 4; i++) {
+            if (_TEEC_GET_PARAM_TYPE(op->paramTypes, i) == TEEC_VALUE_INPUT) {
+                op->isCancelled = gpSleep(session, op->params[i].value.a) || op->isCancelled;
+                break;
+            }
+        }
+    }
+    if (op->isCancelled) {
+        tci.returnOrigin = TEEC_ORIGIN_TRUSTED_APP;
+        tci.returnStatus = TEEC_ERROR_CANCEL;
+        writeBuffer(&session->tci, 0, &tci, sizeof(tci));
+        return;
+    }
+
+    if (op->commandId == SIM_GP_CMD_COUNT_NONZERO) {
+        uint32_t nonZero = 0;
+        for (int i = 0; i < 4; i++) {
+            switch (_TEEC_GET_PARAM_TYPE(op->paramTypes, i)) {
+            case TEEC_MEMREF_TEMP_INPUT:
+            case TEEC_MEMREF_TEMP_OUTPUT:
+            case TEEC_MEMREF_TEMP_INOUT:
+                if (memrefIn < 0) {
+                    memrefIn = i;
+                    nonZero = countNonZero(session,
+                            (uint32_t)(uintptr_t)op->params[i].memref.mapInfo.sVirtualAddr);
+                }
+                break;
+            case TEEC_VALUE_OUTPUT:
+                if (valueIn < 0) {
+                    valueIn = i;
+                }
+                break;
+            default:
+                break;
+            }
+        }
+        if (valueIn >= 0) {
+            op->params[valueIn].value.a = nonZero;
+            op->params[valueIn].value.b = 0;
+        }
+        tci.returnOrigin = TEEC_ORIGIN_TRUSTED_APP;
+        tci.returnStatus = (memrefIn >= 0 && valueIn >= 0) ? TEEC_SUCCESS : TEEC_ERROR_BAD_PARAMETERS;
+        writeBuffer(&session->tci, 0, &tci, sizeof(tci));
+        return;
+    }
+
+    for (int i = 0; i < 4; i++) {
+        uint32_t paramType = _TEEC_GET_PARAM_TYPE(op->paramTypes, i);
+        _TEEC_ParameterInternal *param = &op->params[i];
+
+        switch (paramType) {
+        case TEEC_VALUE_INPUT:
+            if (valueIn < 0) {
+                valueIn = i;
+            }
+            break;
+        case TEEC_VALUE_OUTPUT:
+            if (valueIn >= 0) {
+                param->value = op->params[valueIn].value;
+            }
+            break;
+        case TEEC_MEMREF_TEMP_INPUT:
+        case TEEC_MEMREF_PARTIAL_INPUT:
+            if (memrefIn < 0 && findMapping(session,
+                                            (uint32_t)(uintptr_t)param->memref.mapInfo.sVirtualAddr,
+                                            param->memref.mapInfo.sVirtualLen, &in)) {
+                memrefIn = i;
+            }
+            break;
+        case TEEC_MEMREF_TEMP_OUTPUT:
+        case TEEC_MEMREF_PARTIAL_OUTPUT: {
+            simBuffer_t out;
+            uint32_t len = 0;
+            if (memrefIn >= 0 && findMapping(session,
+                                             (uint32_t)(uintptr_t)param->memref.mapInfo.sVirtualAddr,
+                                             param->memref.mapInfo.sVirtualLen, &out)) {
+                len = (in.len < out.len) ? in.len : out.len;
+                uint8_t *data = new uint8_t[len];
+                if (!readBuffer(&in, 0, data, len) || !writeBuffer(&out, 0, data, len)) {
+                    len = 0;
+                }
+                delete[] data;
+            }
+            param->memref.outputSize = len;
+            break;
+        }
+        case TEEC_MEMREF_TEMP_INOUT:
+        case TEEC_MEMREF_PARTIAL_INOUT:
+        case TEEC_MEMREF_WHOLE:
+            param->memref.outputSize = param->memref.mapInfo.sVirtualLen;
+            break;
+        default:
+            // TEEC_NONE and TEEC_VALUE_INOUT stay as they are
+            break;
+        }
+    }
+
+    tci.returnOrigin = TEEC_ORIGIN_TRUSTED_APP;
+    tci.returnStatus = TEEC_SUCCESS;
+    writeBuffer(&session->tci, 0, &tci, sizeof(tci));
+}
+
+
+//------------------------------------------------------------------------------
+bool SimSecureWorld::gpSleep(
+    simSession_t    *session,
+    uint32_t        us
+)
+{
+    const uint32_t offset = offsetof(_TEEC_TCI, operation) + offsetof(_TEEC_OperationInternal, isCancelled);
+    bool cancelled = false;
+    bool closing = false;
+
+    // Look at the TCI every millisecond, as a TA polling for cancellation
+    while (us > 0 && !cancelled && !closing) {
+        uint32_t step = (us < 1000) ? us : 1000;
+        usleep(step);
+        us -= step;
+        readBuffer(&session->tci, offset, &cancelled, sizeof(cancelled));
+        pthread_mutex_lock(&mutex);
+        closing = session->closing;
+        pthread_mutex_unlock(&mutex);
+    }
+    return cancelled;
+}
+
+
+//------------------------------------------------------------------------------
+bool SimSecureWorld::findMapping(
+    simSession_t    *session,
+    uint32_t        sva,
+    uint32_t        len,
+    simBuffer_t     *buf
+)
+{
+    if (sva < SIM_SVA_BASE) {
+        return false;
+    }
+    uint32_t slot = (sva - SIM_SVA_BASE) / SIM_SVA_SLOT_SIZE;
+    uint32_t offset = (sva - SIM_SVA_BASE) % SIM_SVA_SLOT_SIZE;
+
+    bool found = false;
+    pthread_mutex_lock(&mutex);
+    simMappingMap_t::iterator m = session->mappings.find(slot);
+    if (m != session->mappings.end() && offset >= m->second.offset) {
+        uint32_t rel = offset - m->second.offset;
+        const simBuffer_t *mapped = &m->second.buf;
+        if (rel <= mapped->len && len <= mapped->len - rel) {
+            // A view into the mapping, it is released with the mapping
+            *buf = *mapped;
+            buf->local = (mapped->local != NULL) ? mapped->local + rel : NULL;
+            buf->addr = mapped->addr + rel;
+            buf->len = len;
+            buf->mapping = NULL;
+            buf->mappingLen = 0;
+            found = true;
+        }
+    }
+    pthread_mutex_unlock(&mutex);
+    return found;
+}
+
+
+//------------------------------------------------------------------------------
+uint32_t SimSecureWorld::countNonZero(
+    simSession_t    *session,
+    uint32_t        sva
+)
+{
+    if (sva < SIM_SVA_BASE) {
+        return 0;
+    }
+    uint32_t slot = (sva - SIM_SVA_BASE) / SIM_SVA_SLOT_SIZE;
+
+    simBuffer_t buf;
+    bool found = false;
+    pthread_mutex_lock(&mutex);
+    simMappingMap_t::iterator m = session->mappings.find(slot);
+    if (m != session->mappings.end()) {
+        // A view of the whole mapping, it is released with the mapping
+        buf = m->second.buf;
+        buf.mapping = NULL;
+        buf.mappingLen = 0;
+        found = true;
+    }
+    pthread_mutex_unlock(&mutex);
+
+    uint32_t nonZero = 0;
+    uint8_t data[4096];
+    for (uint32_t offset = 0; found && offset < buf.len; offset += sizeof(data)) {
+        uint32_t len = (buf.len - offset < sizeof(data)) ? buf.len - offset : sizeof(data);
+        if (!readBuffer(&buf, offset, data, len)) {
+            break;
+        }
+        for (uint32_t i = 0; i < len; i++) {
+            nonZero += (data[i] != 0);
+        }
+    }
+    return nonZero;
+}
+
+
+//------------------------------------------------------------------------------
+void SimSecureWorld::raiseNotification(
+    uint32_t    sessionId,
+    int32_t     payload
+)
+{
+    notification_t notification = { sessionId, payload };
+
+    // Producers of the SWd are serialized, the daemon is the only consumer
+    pthread_mutex_lock(&mutex);
+    uint32_t queueSize = nqOut->hdr.queueSize;
+    for (;;) {
+        uint32_t writeCnt = nqOut->hdr.writeCnt;
+        uint32_t readCnt = __atomic_load_n(&nqOut->hdr.readCnt, __ATOMIC_ACQUIRE);
+        if (queueSize == 0 || stopping) {
+            break;
+        }
+        if ((writeCnt - readCnt) < queueSize) {
+            nqOut->notification[writeCnt & (queueSize - 1)] = notification;
+            __atomic_store_n(&nqOut->hdr.writeCnt, writeCnt + 1, __ATOMIC_RELEASE);
+            break;
+        }
+        // Queue full, give the daemon time to drain it like the real SWd would
+        ssiqCount++;
+        pthread_cond_broadcast(&cond);
+        pthread_mutex_unlock(&mutex);
+        usleep(100);
+        pthread_mutex_lock(&mutex);
+    }
+    ssiqCount++;
+    pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&mutex);
+}
+
+
+//------------------------------------------------------------------------------
+void SimSecureWorld::setBusy(
+    bool    more
+)
+{
+    pthread_mutex_lock(&mutex);
+    if (more) {
+        busy++;
+    } else if (busy > 0) {
+        busy--;
+    }
+    __atomic_store_n(&mcp->mcFlags.schedule,
+                     (busy > 0) ? MC_FLAG_SCHEDULE_NON_IDLE : MC_FLAG_SCHEDULE_IDLE,
+                     __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&mutex);
+}
+
+
+//------------------------------------------------------------------------------
+bool SimSecureWorld::mapBuffer(
+    uint32_t    wsmType,
+    uint64_t    phys,
+    uint32_t    offset,
+    uint32_t    len,
+    simBuffer_t *buf
+)
+{
+    simWsm_t wsm;
+    uint32_t handle = SIM_PHYS_HANDLE(phys);
+
+    memset(buf, 0, sizeof(*buf));
+    if (!kmod->findWsm(handle, &wsm) || wsm.type != wsmType) {
+        LOG_E(" No simulated WSM for %#llx", (unsigned long long)phys);
+        return false;
+    }
+
+    if (wsmType == WSM_L2) {
+        // Like an L2 table, the WSM starts at the page of the registered
+        // buffer and the offset is the one of the payload in that page
+        uint64_t page = wsm.addr & ~(uint64_t)0xFFF;
+        uint64_t end = wsm.addr + wsm.len;
+        if (page + offset < wsm.addr || page + offset > end || len > end - (page + offset)) {
+            LOG_E(" Range %u+%u outside of WSM %u", offset, len, handle);
+            return false;
+        }
+        if (wsm.pid == getpid()) {
+            buf->local = (uint8_t *)(uintptr_t)(page + offset);
+        } else {
+            buf->pid = wsm.pid;
+            buf->addr = page + offset;
+        }
+        buf->len = len;
+        return true;
+    }
+
+    // Contiguous WSM carry their offset in the physical address
+    uint64_t start = (uint64_t)SIM_PHYS_OFFSET(phys) + offset;
+    if (start > wsm.len || len > wsm.len - start) {
+        LOG_E(" Range %llu+%u outside of WSM %u", (unsigned long long)start, len, handle);
+        return false;
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), SIM_WSM_FILE, handle);
+    int fd = ::open(CMcKModSim::getPath(name).c_str(), O_RDWR);
+    if (fd == -1) {
+        LOG_ERRNO("open");
+        return false;
+    }
+    void *addr = ::mmap(0, wsm.len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        LOG_ERRNO("mmap");
+        return false;
+    }
+
+    buf->local = (uint8_t *)addr + start;
+    buf->len = len;
+    buf->mapping = addr;
+    buf->mappingLen = wsm.len;
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+void SimSecureWorld::unmapBuffer(
+    simBuffer_t *buf
+)
+{
+    if (buf->mapping != NULL) {
+        ::munmap(buf->mapping, buf->mappingLen);
+    }
+    memset(buf, 0, sizeof(*buf));
+}
+
+
+//------------------------------------------------------------------------------
+bool SimSecureWorld::readBuffer(
+    const simBuffer_t   *buf,
+    uint32_t            offset,
+    void                *data,
+    uint32_t            len
+)
+{
+    if (offset > buf->len || len > buf->len - offset) {
+        return false;
+    }
+    if (buf->local != NULL) {
+        memcpy(data, buf->local + offset, len);
+        return true;
+    }
+
+    struct iovec local = { data, len };
+    struct iovec remote = { (void *)(uintptr_t)(buf->addr + offset), len };
+    if (process_vm_readv(buf->pid, &local, 1, &remote, 1, 0) != (ssize_t)len) {
+        LOG_ERRNO("process_vm_readv");
+        return false;
+    }
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+bool SimSecureWorld::writeBuffer(
+    const simBuffer_t   *buf,
+    uint32_t            offset,
+    const void          *data,
+    uint32_t            len
+)
+{
+    if (offset > buf->len || len > buf->len - offset) {
+        return false;
+    }
+    if (buf->local != NULL) {
+        memcpy(buf->local + offset, data, len);
+        return true;
+    }
+
+    struct iovec local = { (void *)data, len };
+    struct iovec remote = { (void *)(uintptr_t)(buf->addr + offset), len };
+    if (process_vm_writev(buf->pid, &local, 1, &remote, 1, 0) != (ssize_t)len) {
+        LOG_ERRNO("process_vm_writev");
+        return false;
+    }
+    return true;
+}
+
+/** @} */
@@ -0,0 +1,236 @@
+/** @addtogroup MCD_MCDIMPL_DAEMON_KERNEL
+ * @{
+ * @file
+ *
+ * Simulated <t-base secure world.
+ *
+ *
+ * Copyright (c) 2013 TRUSTONIC LIMITED
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the TRUSTONIC LIMITED nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SIMSECUREWORLD_H_
+#define SIMSECUREWORLD_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <map>
+
+#include "McTypes.h"
+#include "Mci/mci.h"
+
+#define SIM_ENV_TA_LATENCY      "MC_SIM_TA_LATENCY_US"  /**< Time an echo TA takes per notification */
+#define SIM_ENV_MCP_LATENCY     "MC_SIM_MCP_LATENCY_US" /**< Time the SWd takes per MCP command */
+#define SIM_SVA_BASE            0x10000000  /**< Secure virtual address of the first mapping */
+#define SIM_SVA_SLOT_SIZE       0x200000    /**< Secure virtual address space per mapping */
+#define SIM_SVA_SLOTS           1024        /**< Mappings per session */
+#define SIM_RSP_ID_MASK         (1U << 31)  /**< Response ID flag of TCI messages */
+#define SIM_GP_CMD_COUNT_NONZERO 0x73696d01 /**< GP command, see SimSecureWorld */
+#define SIM_GP_CMD_SLEEP        0x73696d02  /**< GP command, see SimSecureWorld */
+
+class CMcKModSim;
+
+/**
+ * WSM as accessed by the simulated SWd, either mapped into the daemon or
+ * in another process.
+ */
+typedef struct {
+    uint8_t     *local;     /**< Memory in this process, NULL if remote. */
+    pid_t       pid;        /**< Process of remote memory. */
+    uint64_t    addr;       /**< Address of remote memory in pid. */
+    uint32_t    len;        /**< Accessible length. */
+    void        *mapping;   /**< Mapping to release, NULL if none. */
+    size_t      mappingLen;
+} simBuffer_t;
+
+/**
+ * Secure world played by threads of the daemon.
+ *
+ * The SWd thread takes notifications from the NWd notification queue of
+ * the MCI buffer. It runs MCP commands itself and passes session
+ * notifications to a thread per session, which plays an echo TA:
+ *  - For a GP TCI, outputs get the first input of the same kind, INOUT
+ *    memory references stay as they are, and the TA returns TEEC_SUCCESS.
+ *    Command SIM_GP_CMD_COUNT_NONZERO instead returns in the first value
+ *    output the number of non-zero bytes of the whole mapping the first
+ *    memory reference lies in, so tests see what the NWd left in it.
+ *    Command SIM_GP_CMD_SLEEP first sleeps for the a of the first value
+ *    input in microseconds. A cancelled operation returns TEEC_ERROR_CANCEL,
+ *    notifications which arrive while the TA runs, i.e. cancellations, are
+ *    not answered.
+ *  - For any other TCI, the first word is answered with the response ID
+ *    flag set and the second word, the return code, is cleared.
+ *
+ * Every answer goes to the SWd notification queue and raises an S-SIQ.
+ * The latency of TAs and MCP commands comes from the SIM_ENV_ environment
+ * variables, in microseconds.
+ */
+class SimSecureWorld
+{
+
+public:
+
+    /** Creates the SWd on the MCI buffer, see CMcKMod::fcInit(). */
+    SimSecureWorld(
+        CMcKModSim  *kmod,
+        addr_t      mci,
+        uint32_t    nqLength,
+        uint32_t    mcpOffset,
+        uint32_t    mcpLength
+    );
+
+    /** Closes all sessions and stops the SWd thread. */
+    ~SimSecureWorld(
+        void
+    );
+
+    /** Starts the SWd thread.
+     *
+     * @return false if the thread could not be created.
+     */
+    bool start(
+        void
+    );
+
+    /** Lets the SWd look at its notification queue. */
+    void nsiq(
+        void
+    );
+
+    /** Waits for an S-SIQ.
+     *
+     * @param seen S-SIQ counter the caller has seen last.
+     * @return Current S-SIQ counter.
+     */
+    uint32_t waitSsiq(
+        uint32_t seen
+    );
+
+    /** Answers an info fastcall.
+     *
+     * @param extInfoId MC_EXT_INFO_ID_ value.
+     * @param[out] pState MC_STATUS_ value.
+     * @param[out] pExtInfo Requested info.
+     */
+    void info(
+        uint32_t    extInfoId,
+        uint32_t    *pState,
+        uint32_t    *pExtInfo
+    );
+
+private:
+
+    typedef struct {
+        simBuffer_t buf; /**< Starts at the mapped payload */
+        uint32_t    offset; /**< Offset of the payload within the SVA slot */
+    } simMapping_t;
+
+    typedef std::map<uint32_t, simMapping_t> simMappingMap_t; /**< By SVA slot */
+
+    typedef struct {
+        uint32_t        id;
+        simBuffer_t     tci; /**< len 0 without TCI */
+        pthread_t       thread;
+        pthread_cond_t  cond; /**< Signals pending notifications and closing */
+        uint32_t        pending; /**< Notifications for the TA */
+        bool            closing;
+        simMappingMap_t mappings;
+        uint32_t        nextSlot;
+        SimSecureWorld  *swd;
+    } simSession_t;
+
+    typedef std::map<uint32_t, simSession_t *> simSessionMap_t;
+
+    CMcKModSim              *kmod;
+    notificationQueue_t     *nqIn; /**< NWd to SWd */
+    notificationQueue_t     *nqOut; /**< SWd to NWd */
+    mcpBuffer_t             *mcp;
+    uint32_t                status; /**< MC_STATUS_ value */
+    uint32_t                taLatencyUs;
+    uint32_t                mcpLatencyUs;
+
+    pthread_mutex_t         mutex; /**< Guards everything below */
+    pthread_cond_t          cond; /**< Signals N-SIQs and S-SIQs */
+    pthread_t               thread;
+    bool                    threadStarted;
+    bool                    stopping;
+    uint32_t                nsiqCount;
+    uint32_t                ssiqCount;
+    uint32_t                busy; /**< MCP commands and TA calls in progress */
+    simSessionMap_t         sessions;
+    uint32_t                nextSessionId;
+
+    static void *run(void *arg);
+
+    static void *runSession(void *arg);
+
+    void handleNotifications(void);
+
+    void handleMcp(void);
+
+    mcpResult_t openSession(mcpCmdOpen_t *cmd, uint32_t *sessionId);
+
+    mcpResult_t closeSession(uint32_t sessionId);
+
+    mcpResult_t map(mcpCmdMap_t *cmd, uint32_t *secureVirtualAdr);
+
+    mcpResult_t unmap(mcpCmdUnmap_t *cmd);
+
+    void runEchoTa(simSession_t *session);
+
+    void runGpEchoTa(simSession_t *session);
+
+    bool gpSleep(simSession_t *session, uint32_t us);
+
+    bool findMapping(simSession_t *session, uint32_t sva, uint32_t len,
+                     simBuffer_t *buf);
+
+    uint32_t countNonZero(simSession_t *session, uint32_t sva);
+
+    void raiseNotification(uint32_t sessionId, int32_t payload);
+
+    void setBusy(bool more);
+
+    bool mapBuffer(uint32_t wsmType, uint64_t phys, uint32_t offset,
+                   uint32_t len, simBuffer_t *buf);
+
+    void unmapBuffer(simBuffer_t *buf);
+
+    static bool readBuffer(const simBuffer_t *buf, uint32_t offset,
+                           void *data, uint32_t len);
+
+    static bool writeBuffer(const simBuffer_t *buf, uint32_t offset,
+                            const void *data, uint32_t len);
+
+};
+
+#endif // SIMSECUREWORLD_H_
+
+/** @} */
@@ -44,12 +44,15 @@
 #include <assert.h>
 #include <string.h>
 #include <string>
+#include <list>
+#include <vector>
 #include <cstring>
 #include <cstddef>
 #include <sys/mman.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <libgen.h>
+#include <pthread.h>
 
 #include "mcLoadFormat.h"
 #include "mcSpid.h"
@@ -66,6 +69,8 @@
 #define MAX_TL_SIZE       (1 * 1024 * 1024)
 /** Maximum size of a shared object container in bytes. */
 #define MAX_SO_CONT_SIZE  (512)
+/** Maximum size of unreferenced service blobs kept in the cache. */
+#define MAX_BLOB_CACHE_SIZE (4 * 1024 * 1024)
 
 // Asserts expression at compile-time (to be used within a function body).
 #define ASSERT_STATIC(e) do { enum { assert_static__ = 1 / (e) }; } while (0)
@@ -73,6 +78,8 @@
 #define MC_REGISTRY_CONTAINER_PATH "/data/app/mcRegistry"
 #define MC_REGISTRY_DEFAULT_PATH "/system/app/mcRegistry"
 #define MC_REGISTRY_FALLBACK_PATH "/data/app/mcRegistry"
+#define ENV_MC_REGISTRY_PATH "MC_REGISTRY_PATH"
+#define ENV_MC_REGISTRY_FALLBACK_PATH "MC_REGISTRY_FALLBACK_PATH"
 #define AUTH_TOKEN_FILE_NAME "00000000.authtokcont"
 #define ENV_MC_AUTH_TOKEN_PATH "MC_AUTH_TOKEN_PATH"
 #define ROOT_FILE_NAME "00000000.rootcont"
@@ -118,11 +125,19 @@ static bool doesDirExist(const char *path)
 //------------------------------------------------------------------------------
 static string getRegistryPath()
 {
+    const char *path;
     string registryPath;
 
-    // use the default registry path.
-    registryPath = MC_REGISTRY_CONTAINER_PATH;
-    LOG_I("  Using default registry path %s", registryPath.c_str());
+    // First, attempt to use regular registry environment variable.
+    path = getenv(ENV_MC_REGISTRY_PATH);
+    if (doesDirExist(path)) {
+        LOG_I("  Using MC_REGISTRY_PATH %s", path);
+        registryPath = path;
+    } else {
+        // use the default registry path.
+        registryPath = MC_REGISTRY_CONTAINER_PATH;
+        LOG_I("  Using default registry path %s", registryPath.c_str());
+    }
 
     assert(registryPath.length() != 0);
 
@@ -132,10 +147,18 @@ static string getRegistryPath()
 //------------------------------------------------------------------------------
 string getTlRegistryPath()
 {
+    const char *path;
     string registryPath;
 
     // First, attempt to use regular registry environment variable.
-    if (doesDirExist(MC_REGISTRY_DEFAULT_PATH)) {
+    path = getenv(ENV_MC_REGISTRY_PATH);
+    if (doesDirExist(path)) {
+        registryPath = path;
+        LOG_I(" Using MC_REGISTRY_PATH %s", registryPath.c_str());
+    } else if (doesDirExist(getenv(ENV_MC_REGISTRY_FALLBACK_PATH))) {
+        registryPath = getenv(ENV_MC_REGISTRY_FALLBACK_PATH);
+        LOG_I(" Using MC_REGISTRY_FALLBACK_PATH %s", registryPath.c_str());
+    } else if (doesDirExist(MC_REGISTRY_DEFAULT_PATH)) {
         registryPath = MC_REGISTRY_DEFAULT_PATH;
         LOG_I(" Using MC_REGISTRY_PATH %s", registryPath.c_str());
     } else if (doesDirExist(MC_REGISTRY_FALLBACK_PATH)) {
@@ -229,6 +252,241 @@ static string getTASpidFilePath(const mcUuid_t *uuid)
     return getTlRegistryPath() + "/" + byteArrayToString(uuid, sizeof(*uuid)) + GP_TA_SPID_FILE_EXT;
 }
 
+//------------------------------------------------------------------------------
+// Service blob cache
+//
+// Building a registry object for a service means reading the service blob
+// and, for SP trustlets, the root, SP and trustlet containers. The result is
+// kept and handed out again as long as none of the files it was built from
+// changed, identified by inode, size and modification time.
+// Registry objects are reference counted, an entry invalidated while still
+// in use is only freed when released by its last user.
+
+typedef struct {
+    dev_t       dev;
+    ino_t       ino;
+    off_t       size;
+    time_t      mtime;
+    long        mtimeNsec;
+} fileStamp_t;
+
+typedef struct {
+    string              path;   /**< Service blob file. */
+    mcSpid_t            spid;
+    vector<string>      files;  /**< Files the registry object was built from. */
+    vector<fileStamp_t> stamps;
+    regObject_t         *regobj;
+    uint32_t            refs;
+    bool                stale;  /**< Invalidated, freed on last release. */
+} blobCacheEntry_t;
+
+// Most recently used entries first
+static list<blobCacheEntry_t *> blobCache;
+static size_t blobCacheSize;
+static regCacheStats_t blobCacheStats;
+static pthread_mutex_t blobCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+
+//------------------------------------------------------------------------------
+static bool getFileStamp(const string &path, fileStamp_t *stamp)
+{
+    struct stat sb;
+
+    memset(stamp, 0, sizeof(*stamp));
+    if (stat(path.c_str(), &sb) != 0) {
+        return false;
+    }
+    stamp->dev = sb.st_dev;
+    stamp->ino = sb.st_ino;
+    stamp->size = sb.st_size;
+    stamp->mtime = sb.st_mtim.tv_sec;
+    stamp->mtimeNsec = sb.st_mtim.tv_nsec;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+static bool isBlobCacheEntryValid(blobCacheEntry_t *entry)
+{
+    for (size_t i = 0; i < entry->files.size(); i++) {
+        fileStamp_t stamp;
+        getFileStamp(entry->files[i], &stamp);
+        if (memcmp(&stamp, &entry->stamps[i], sizeof(stamp)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Drops an entry from the cache, blobCacheMutex must be held.
+static void dropBlobCacheEntry(list<blobCacheEntry_t *>::iterator it)
+{
+    blobCacheEntry_t *entry = *it;
+
+    if (!entry->stale) {
+        entry->stale = true;
+        blobCacheSize -= entry->regobj->len;
+        blobCacheStats.entries--;
+        blobCacheStats.bytesCached = blobCacheSize;
+    }
+    if (entry->refs == 0) {
+        blobCache.erase(it);
+        free(entry->regobj);
+        delete entry;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Evicts least recently used unreferenced entries, blobCacheMutex must be held.
+static void trimBlobCache(void)
+{
+    list<blobCacheEntry_t *>::iterator it = blobCache.end();
+    while ((blobCacheSize > MAX_BLOB_CACHE_SIZE) && (it != blobCache.begin())) {
+        --it;
+        blobCacheEntry_t *entry = *it;
+        if ((entry->refs == 0) && !entry->stale) {
+            LOG_I(" Evicting %s from service blob cache", entry->path.c_str());
+            dropBlobCacheEntry(it++);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+static void invalidateBlobCache(void)
+{
+    pthread_mutex_lock(&blobCacheMutex);
+    list<blobCacheEntry_t *>::iterator it = blobCache.begin();
+    while (it != blobCache.end()) {
+        dropBlobCacheEntry(it++);
+    }
+    pthread_mutex_unlock(&blobCacheMutex);
+}
+
+//------------------------------------------------------------------------------
+static regObject_t *lookupBlobCache(const string &path, mcSpid_t spid)
+{
+    regObject_t *regobj = NULL;
+
+    pthread_mutex_lock(&blobCacheMutex);
+    for (list<blobCacheEntry_t *>::iterator it = blobCache.begin();
+            it != blobCache.end(); ++it) {
+        blobCacheEntry_t *entry = *it;
+        if (entry->stale || (entry->spid != spid) || (entry->path != path)) {
+            continue;
+        }
+        if (!isBlobCacheEntryValid(entry)) {
+            LOG_I(" %s changed, invalidating cached service blob", path.c_str());
+            blobCacheStats.invalidations++;
+            dropBlobCacheEntry(it);
+            break;
+        }
+        entry->refs++;
+        regobj = entry->regobj;
+        blobCache.splice(blobCache.begin(), blobCache, it);
+        blobCacheStats.hits++;
+        blobCacheStats.bytesSaved += regobj->len;
+        LOG_I(" Service blob cache hit, %u hits %u misses, %llu bytes saved",
+              blobCacheStats.hits, blobCacheStats.misses,
+              (unsigned long long)blobCacheStats.bytesSaved);
+        break;
+    }
+    if (regobj == NULL) {
+        blobCacheStats.misses++;
+    }
+    pthread_mutex_unlock(&blobCacheMutex);
+
+    return regobj;
+}
+
+//------------------------------------------------------------------------------
+// Adds a freshly built registry object to the cache, with one reference held
+// by the caller.
+static void insertBlobCache(const string &path, mcSpid_t spid, regObject_t *regobj)
+{
+    blobCacheEntry_t *entry = new blobCacheEntry_t;
+    entry->path = path;
+    entry->spid = spid;
+    entry->regobj = regobj;
+    entry->refs = 1;
+    entry->stale = false;
+
+    entry->files.push_back(path);
+    mclfHeaderV2_t *pHeader = (mclfHeaderV2_t *)(regobj->value + regobj->tlStartOffset);
+    if (pHeader->serviceType == SERVICE_TYPE_SP_TRUSTLET) {
+        entry->files.push_back(getRootContFilePath());
+        entry->files.push_back(getSpContFilePath(spid));
+        entry->files.push_back(getTlContFilePath(&pHeader->uuid, spid));
+    }
+    entry->stamps.resize(entry->files.size());
+    for (size_t i = 0; i < entry->files.size(); i++) {
+        getFileStamp(entry->files[i], &entry->stamps[i]);
+    }
+
+    pthread_mutex_lock(&blobCacheMutex);
+    blobCache.push_front(entry);
+    blobCacheSize += regobj->len;
+    blobCacheStats.entries++;
+    trimBlobCache();
+    blobCacheStats.bytesCached = blobCacheSize;
+    pthread_mutex_unlock(&blobCacheMutex);
+}
+
+//------------------------------------------------------------------------------
+void mcRegistryReleaseServiceBlob(regObject_t *regobj)
+{
+    if (regobj == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&blobCacheMutex);
+    for (list<blobCacheEntry_t *>::iterator it = blobCache.begin();
+            it != blobCache.end(); ++it) {
+        blobCacheEntry_t *entry = *it;
+        if (entry->regobj != regobj) {
+            continue;
+        }
+        entry->refs--;
+        if (entry->stale) {
+            dropBlobCacheEntry(it);
+        } else {
+            trimBlobCache();
+        }
+        pthread_mutex_unlock(&blobCacheMutex);
+        return;
+    }
+    pthread_mutex_unlock(&blobCacheMutex);
+
+    // Not a cached object
+    free(regobj);
+}
+
+//------------------------------------------------------------------------------
+regObject_t *mcRegistryRetainServiceBlob(regObject_t *regobj)
+{
+    regObject_t *ret = NULL;
+
+    pthread_mutex_lock(&blobCacheMutex);
+    for (list<blobCacheEntry_t *>::iterator it = blobCache.begin();
+            it != blobCache.end(); ++it) {
+        blobCacheEntry_t *entry = *it;
+        if ((entry->regobj == regobj) && !entry->stale) {
+            entry->refs++;
+            ret = regobj;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&blobCacheMutex);
+
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+void mcRegistryGetServiceBlobCacheStats(regCacheStats_t *stats)
+{
+    pthread_mutex_lock(&blobCacheMutex);
+    *stats = blobCacheStats;
+    pthread_mutex_unlock(&blobCacheMutex);
+}
+
 //------------------------------------------------------------------------------
 mcResult_t mcRegistryStoreAuthToken(void *so, uint32_t size)
 {
@@ -302,6 +560,7 @@ mcResult_t mcRegistryDeleteAuthToken(void)
 //------------------------------------------------------------------------------
 mcResult_t mcRegistryStoreRoot(void *so, uint32_t size)
 {
+    invalidateBlobCache();
     if (so == NULL || size > 3 * MAX_SO_CONT_SIZE) {
         LOG_E("mcRegistry store So.Root failed: %d", MC_DRV_ERR_INVALID_PARAMETER);
         return MC_DRV_ERR_INVALID_PARAMETER;
@@ -357,6 +616,7 @@ mcResult_t mcRegistryReadRoot(void *so, uint32_t *size)
 //------------------------------------------------------------------------------
 mcResult_t mcRegistryStoreSp(mcSpid_t spid, void *so, uint32_t size)
 {
+    invalidateBlobCache();
     if ((spid == 0) || (so == NULL) || size > 3 * MAX_SO_CONT_SIZE) {
         LOG_E("mcRegistry store So.Sp(SpId) failed: %d", MC_DRV_ERR_INVALID_PARAMETER);
         return MC_DRV_ERR_INVALID_PARAMETER;
@@ -411,6 +671,7 @@ mcResult_t mcRegistryReadSp(mcSpid_t spid, void *so, uint32_t *size)
 //------------------------------------------------------------------------------
 mcResult_t mcRegistryStoreTrustletCon(const mcUuid_t *uuid, const mcSpid_t spid, void *so, uint32_t size)
 {
+    invalidateBlobCache();
     if ((uuid == NULL) || (so == NULL) || size > 3 * MAX_SO_CONT_SIZE) {
         LOG_E("mcRegistry store So.TrustletCont(uuid) failed: %d", MC_DRV_ERR_INVALID_PARAMETER);
         return MC_DRV_ERR_INVALID_PARAMETER;
@@ -443,6 +704,7 @@ static uint32_t getAsUint32BE(
 
 mcResult_t mcRegistryStoreTABlob(mcSpid_t spid, void *blob, uint32_t size)
 {
+    invalidateBlobCache();
 
     LOG_I("mcRegistryStoreTABlob started");
 
@@ -885,6 +1147,7 @@ static void deleteSPTA(const mcUuid_t *uuid, const mcSpid_t spid, bool checkUuid
 //------------------------------------------------------------------------------
 mcResult_t mcRegistryCleanupTrustlet(const mcUuid_t *uuid, const mcSpid_t spid)
 {
+    invalidateBlobCache();
     DIR            *dp;
     struct dirent  *de;
     int             e;
@@ -940,6 +1203,7 @@ mcResult_t mcRegistryCleanupTrustlet(const mcUuid_t *uuid, const mcSpid_t spid)
 //------------------------------------------------------------------------------
 mcResult_t mcRegistryCleanupSp(mcSpid_t spid)
 {
+    invalidateBlobCache();
     DIR *dp;
     struct dirent  *de;
     mcResult_t ret;
@@ -1004,6 +1268,7 @@ mcResult_t mcRegistryCleanupSp(mcSpid_t spid)
 //------------------------------------------------------------------------------
 mcResult_t mcRegistryCleanupRoot(void)
 {
+    invalidateBlobCache();
     mcResult_t ret;
     mcSoRootCont_t data;
     uint32_t i, len;
@@ -1256,7 +1521,14 @@ regObject_t *mcRegistryGetServiceBlob(const mcUuid_t *uuid, bool isGpUuid)
         }
     }
 
-    return mcRegistryFileGetServiceBlob(tlBinFilePath.c_str(), spid);
+    regObject_t *regobj = lookupBlobCache(tlBinFilePath, spid);
+    if (regobj == NULL) {
+        regobj = mcRegistryFileGetServiceBlob(tlBinFilePath.c_str(), spid);
+        if ((regobj != NULL) && (regobj->len != 0)) {
+            insertBlobCache(tlBinFilePath, spid, regobj);
+        }
+    }
+    return regobj;
 }
 
 //------------------------------------------------------------------------------
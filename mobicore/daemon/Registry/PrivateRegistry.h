@@ -56,6 +56,18 @@ extern "C" {
         uint8_t value[];
     } regObject_t;
 
+    /**
+     * Service blob cache statistics.
+     */
+    typedef struct {
+        uint32_t hits;          /**< Registry objects served from the cache. */
+        uint32_t misses;        /**< Registry objects read from the registry. */
+        uint32_t invalidations; /**< Entries dropped because a file changed. */
+        uint32_t entries;       /**< Entries currently cached. */
+        uint64_t bytesCached;   /**< Size of the cached registry objects. */
+        uint64_t bytesSaved;    /**< Bytes not read again thanks to hits. */
+    } regCacheStats_t;
+
 //-----------------------------------------------------------------
 
     /** Stores an authentication token in registry.
@@ -176,13 +188,33 @@ extern "C" {
     regObject_t *mcRegistryMemGetServiceBlob(mcSpid_t spid, void *trustlet, uint32_t tlSize);
 
     /** Returns a registry object for a given service.
+     * Registry objects are cached and shared between callers as long as the
+     * files they were built from do not change, they must not be modified.
      * @param uuid service UUID
      * @return Registry object.
-     * @note It is the responsibility of the caller to free the registry object
-     * allocated by this function.
+     * @note It is the responsibility of the caller to release the registry
+     * object with mcRegistryReleaseServiceBlob().
      */
     regObject_t *mcRegistryGetServiceBlob(const mcUuid_t  *uuid, bool isGpUuid);
 
+    /** Releases a registry object returned by mcRegistryGetServiceBlob().
+     * @param regobj Registry object, may be NULL.
+     */
+    void mcRegistryReleaseServiceBlob(regObject_t *regobj);
+
+    /** Takes another reference on a registry object returned by
+     * mcRegistryGetServiceBlob(), to be released with
+     * mcRegistryReleaseServiceBlob().
+     * @param regobj Registry object.
+     * @return regobj, NULL if the object is not or no longer cached.
+     */
+    regObject_t *mcRegistryRetainServiceBlob(regObject_t *regobj);
+
+    /** Returns the statistics of the service blob cache.
+     * @param[out] stats Cache statistics.
+     */
+    void mcRegistryGetServiceBlobCacheStats(regCacheStats_t *stats);
+
     /** Returns a registry object for a given service.
      * @param uuid service GP UUID as mc uuid
      * @return Registry object.
@@ -0,0 +1,250 @@
+# =============================================================================
+#
+# MobiCore daemon host tests
+#
+# =============================================================================
+
+# Each module is a gtest binary run on the build host.
+
+TESTS_PATH := tests
+
+MC_TEST_INCLUDES := $(GLOBAL_INCLUDES) \
+	$(LOCAL_PATH)/Common \
+	$(LOCAL_PATH)/ClientLib/public \
+	$(LOCAL_PATH)/../common/LogWrapper
+
+MC_TEST_CFLAGS := -include buildTag.h \
+	-DTBASE_API_LEVEL=3 \
+	-DLOG_ANDROID
+
+# Socket server
+# =============================================================================
+include $(CLEAR_VARS)
+LOCAL_MODULE := mcdaemon_server_tests
+LOCAL_MODULE_TAGS := tests
+LOCAL_CFLAGS += $(MC_TEST_CFLAGS) -DLOG_TAG=\"McDaemon\"
+LOCAL_C_INCLUDES += $(MC_TEST_INCLUDES) \
+	$(LOCAL_PATH)/Daemon/Server/public
+LOCAL_SHARED_LIBRARIES += liblog
+LOCAL_SRC_FILES := \
+	Daemon/Server/Server.cpp \
+	Common/CMutex.cpp \
+	Common/CSemaphore.cpp \
+	Common/CThread.cpp \
+	Common/Connection.cpp \
+	Common/McTrace.cpp \
+	$(TESTS_PATH)/Server_test.cpp
+include $(BUILD_HOST_NATIVE_TEST)
+
+# Connection read-ahead
+# =============================================================================
+include $(CLEAR_VARS)
+LOCAL_MODULE := mcdaemon_connection_tests
+LOCAL_MODULE_TAGS := tests
+LOCAL_CFLAGS += $(MC_TEST_CFLAGS) -DLOG_TAG=\"McDaemon\"
+LOCAL_C_INCLUDES += $(MC_TEST_INCLUDES)
+LOCAL_SHARED_LIBRARIES += liblog
+LOCAL_SRC_FILES := \
+	Common/Connection.cpp \
+	$(TESTS_PATH)/Connection_test.cpp
+include $(BUILD_HOST_NATIVE_TEST)
+
+# Request tracing
+# =============================================================================
+include $(CLEAR_VARS)
+LOCAL_MODULE := mcdaemon_trace_tests
+LOCAL_MODULE_TAGS := tests
+LOCAL_CFLAGS += $(MC_TEST_CFLAGS) -DLOG_TAG=\"McDaemon\"
+LOCAL_C_INCLUDES += $(MC_TEST_INCLUDES)
+LOCAL_SHARED_LIBRARIES += liblog
+LOCAL_SRC_FILES := \
+	Common/McTrace.cpp \
+	$(TESTS_PATH)/McTrace_test.cpp
+include $(BUILD_HOST_NATIVE_TEST)
+
+# Notification queues
+# =============================================================================
+include $(CLEAR_VARS)
+LOCAL_MODULE := mcdaemon_nq_tests
+LOCAL_MODULE_TAGS := tests
+LOCAL_CFLAGS += $(MC_TEST_CFLAGS) -DLOG_TAG=\"McDaemon\"
+LOCAL_C_INCLUDES += $(MC_TEST_INCLUDES) \
+	$(LOCAL_PATH)/Daemon/Device
+LOCAL_SHARED_LIBRARIES += liblog
+LOCAL_SRC_FILES := \
+	Daemon/Device/NotificationQueue.cpp \
+	Common/CMutex.cpp \
+	$(TESTS_PATH)/NotificationQueue_test.cpp
+include $(BUILD_HOST_NATIVE_TEST)
+
+# Trustlet session table
+# =============================================================================
+include $(CLEAR_VARS)
+LOCAL_MODULE := mcdaemon_session_table_tests
+LOCAL_MODULE_TAGS := tests
+LOCAL_CFLAGS += $(MC_TEST_CFLAGS) -DLOG_TAG=\"McDaemon\"
+LOCAL_C_INCLUDES += $(MC_TEST_INCLUDES) \
+	$(LOCAL_PATH)/Daemon/Device
+LOCAL_SHARED_LIBRARIES += liblog
+LOCAL_SRC_FILES := \
+	Daemon/Device/TrustletSessionTable.cpp \
+	Daemon/Device/TrustletSession.cpp \
+	Common/CMutex.cpp \
+	Common/McTrace.cpp \
+	$(TESTS_PATH)/TrustletSessionTable_test.cpp
+include $(BUILD_HOST_NATIVE_TEST)
+
+# Private registry
+# =============================================================================
+include $(CLEAR_VARS)
+LOCAL_MODULE := mcdaemon_registry_tests
+LOCAL_MODULE_TAGS := tests
+LOCAL_CFLAGS += $(MC_TEST_CFLAGS) -DLOG_TAG=\"McDaemon\"
+LOCAL_C_INCLUDES += $(MC_TEST_INCLUDES) \
+	$(LOCAL_PATH)/ClientLib/public/GP \
+	$(LOCAL_PATH)/Registry/Public \
+	$(LOCAL_PATH)/Registry
+LOCAL_SHARED_LIBRARIES += liblog
+LOCAL_SRC_FILES := \
+	Registry/PrivateRegistry.cpp \
+	$(TESTS_PATH)/PrivateRegistry_test.cpp
+include $(BUILD_HOST_NATIVE_TEST)
+
+# Service WSM pins
+# =============================================================================
+include $(CLEAR_VARS)
+LOCAL_MODULE := mcdaemon_wsm_pins_tests
+LOCAL_MODULE_TAGS := tests
+LOCAL_CFLAGS += $(MC_TEST_CFLAGS) -DLOG_TAG=\"McDaemon\"
+LOCAL_C_INCLUDES += $(MC_TEST_INCLUDES) \
+	$(LOCAL_PATH)/ClientLib/public/GP \
+	$(LOCAL_PATH)/Registry/Public \
+	$(LOCAL_PATH)/Registry \
+	$(LOCAL_PATH)/Kernel
+LOCAL_SHARED_LIBRARIES += liblog
+include $(LOCAL_PATH)/Daemon/Device/Android.mk
+LOCAL_SRC_FILES += \
+	Common/CMutex.cpp \
+	Common/CSemaphore.cpp \
+	Common/CThread.cpp \
+	Common/Connection.cpp \
+	Common/McTrace.cpp \
+	Registry/PrivateRegistry.cpp \
+	Kernel/CKMod.cpp \
+	$(TESTS_PATH)/ServiceWsmPins_test.cpp
+include $(LOCAL_PATH)/Kernel/Platforms/Generic/Android.mk
+include $(BUILD_HOST_NATIVE_TEST)
+
+# SWd scheduler
+# =============================================================================
+include $(CLEAR_VARS)
+LOCAL_MODULE := mcdaemon_scheduler_tests
+LOCAL_MODULE_TAGS := tests
+LOCAL_CFLAGS += $(MC_TEST_CFLAGS) -DLOG_TAG=\"McDaemon\"
+LOCAL_C_INCLUDES += $(MC_TEST_INCLUDES) \
+	$(LOCAL_PATH)/ClientLib/public/GP \
+	$(LOCAL_PATH)/Registry/Public \
+	$(LOCAL_PATH)/Registry \
+	$(LOCAL_PATH)/Kernel
+LOCAL_SHARED_LIBRARIES += liblog
+include $(LOCAL_PATH)/Daemon/Device/Android.mk
+LOCAL_SRC_FILES += \
+	Common/CMutex.cpp \
+	Common/CSemaphore.cpp \
+	Common/CThread.cpp \
+	Common/Connection.cpp \
+	Common/McTrace.cpp \
+	Registry/PrivateRegistry.cpp \
+	Kernel/CKMod.cpp \
+	$(TESTS_PATH)/Scheduler_test.cpp
+include $(LOCAL_PATH)/Kernel/Platforms/Generic/Android.mk
+include $(BUILD_HOST_NATIVE_TEST)
+
+# Client contiguous WSM
+# =============================================================================
+include $(CLEAR_VARS)
+LOCAL_MODULE := mcclient_wsm_tests
+LOCAL_MODULE_TAGS := tests
+LOCAL_CFLAGS += $(MC_TEST_CFLAGS) -DLOG_TAG=\"McClient\"
+LOCAL_C_INCLUDES += $(MC_TEST_INCLUDES) \
+	$(LOCAL_PATH)/ClientLib \
+	$(LOCAL_PATH)/Kernel
+LOCAL_SHARED_LIBRARIES += liblog
+LOCAL_SRC_FILES := \
+	ClientLib/Device.cpp \
+	ClientLib/Session.cpp \
+	Common/CMutex.cpp \
+	Common/Connection.cpp \
+	Kernel/CKMod.cpp \
+	$(TESTS_PATH)/ClientWsm_test.cpp
+include $(LOCAL_PATH)/Kernel/Platforms/Generic/Android.mk
+include $(BUILD_HOST_NATIVE_TEST)
+
+# Simulated device, see README.android
+# =============================================================================
+# Host builds of the client library and the daemon on the simulated kernel
+# module and secure world, driven by mcdaemon_bench.
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := libMcClient_sim
+LOCAL_MODULE_TAGS := tests
+LOCAL_CFLAGS += $(MC_TEST_CFLAGS) -DLOG_TAG=\"McClient\"
+LOCAL_C_INCLUDES += $(MC_TEST_INCLUDES) \
+	$(LOCAL_PATH)/ClientLib/public/GP \
+	$(COMP_PATH_MobiCore)/inc/McLib
+LOCAL_SHARED_LIBRARIES += liblog
+LOCAL_SRC_FILES := \
+	ClientLib/Device.cpp \
+	ClientLib/ClientLib.cpp \
+	ClientLib/Session.cpp \
+	Common/CMutex.cpp \
+	Common/Connection.cpp \
+	Common/McTrace.cpp \
+	ClientLib/GP/tee_client_api.cpp \
+	Kernel/CKMod.cpp
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/Kernel
+include $(LOCAL_PATH)/Kernel/Platforms/Generic/Android.mk
+include $(LOCAL_PATH)/Kernel/Platforms/Simulator/Android.mk
+LOCAL_EXPORT_C_INCLUDE_DIRS := $(LOCAL_PATH)/ClientLib/public
+include $(BUILD_HOST_SHARED_LIBRARY)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := mcDriverDaemon_sim
+LOCAL_MODULE_TAGS := tests
+LOCAL_CFLAGS += $(MC_TEST_CFLAGS) -DLOG_TAG=\"McDaemon\" -Wno-date-time
+LOCAL_C_INCLUDES += $(MC_TEST_INCLUDES) \
+	$(LOCAL_PATH)/Registry/Public \
+	$(LOCAL_PATH)/Registry
+LOCAL_SHARED_LIBRARIES += libMcClient_sim liblog
+include $(LOCAL_PATH)/Daemon/Android.mk
+LOCAL_SRC_FILES += \
+	Common/CMutex.cpp \
+	Common/Connection.cpp \
+	Common/NetlinkConnection.cpp \
+	Common/CSemaphore.cpp \
+	Common/CThread.cpp \
+	Common/McTrace.cpp \
+	Registry/PrivateRegistry.cpp \
+	Kernel/CKMod.cpp
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/Kernel
+include $(LOCAL_PATH)/Kernel/Platforms/Generic/Android.mk
+include $(LOCAL_PATH)/Kernel/Platforms/Simulator/Android.mk
+include $(BUILD_HOST_EXECUTABLE)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := mcdaemon_bench
+LOCAL_MODULE_TAGS := tests
+LOCAL_CFLAGS += $(MC_TEST_CFLAGS) -DLOG_TAG=\"McBench\"
+LOCAL_C_INCLUDES += $(MC_TEST_INCLUDES) \
+	$(LOCAL_PATH)/Daemon/public \
+	$(LOCAL_PATH)/Registry/Public \
+	$(LOCAL_PATH)/ClientLib/public/GP \
+	$(LOCAL_PATH)/Kernel/Platforms/Simulator \
+	$(COMP_PATH_MobiCore)/inc/McLib
+LOCAL_SHARED_LIBRARIES += libMcClient_sim liblog
+LOCAL_LDLIBS += -ldl
+LOCAL_SRC_FILES := \
+	Registry/Registry.cpp \
+	$(TESTS_PATH)/McDaemonBench.cpp
+LOCAL_REQUIRED_MODULES := mcDriverDaemon_sim
+include $(BUILD_HOST_EXECUTABLE)
@@ -0,0 +1,298 @@
+/**
+ * @file
+ *
+ * Host tests for the contiguous WSM suballocator of the client library.
+ * 
+ * A kernel module double hands out heap memory and counts mappings. AllocFreeCost
+ * prints mcMallocWsm()/mcFreeWsm() throughput per size with the kernel module's
+ * map cost simulated.
+ *
+ * Copyright (c) 2013 TRUSTONIC LIMITED
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the TRUSTONIC LIMITED nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Device.h"
+#include "mcVersionHelper.h"
+
+static double nowSec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+//------------------------------------------------------------------------------
+/** Kernel module handing out heap memory as contiguous WSM. mapUs and freeUs
+ * stand in for the ioctl and mmap of the real one. */
+class HeapKMod: public CMcKMod
+{
+public:
+    int maps;
+    int frees;
+    int live;
+    useconds_t mapUs;
+    useconds_t freeUs;
+
+    HeapKMod() : maps(0), frees(0), live(0), mapUs(0), freeUs(0), nextHandle(1) {}
+
+    virtual mcResult_t mapWsm(uint32_t len, uint32_t *pHandle, addr_t *pVirtAddr,
+                              uint64_t *pPhysAddr)
+    {
+        void *mem;
+        if (posix_memalign(&mem, WSM_PAGE_SIZE, len) != 0) {
+            return MC_DRV_ERR_NO_FREE_MEMORY;
+        }
+        // Fresh pages from the kernel are zeroed, stale ones show up in the tests
+        memset(mem, 0xa5, len);
+        if (mapUs) {
+            usleep(mapUs);
+        }
+        maps++;
+        live++;
+        *pHandle = nextHandle++;
+        *pVirtAddr = mem;
+        *pPhysAddr = (uint64_t) *pHandle << 24;
+        return MC_DRV_OK;
+    }
+
+    virtual mcResult_t free(uint32_t handle, addr_t buffer, uint32_t len)
+    {
+        (void) handle;
+        (void) len;
+        if (freeUs) {
+            usleep(freeUs);
+        }
+        ::free(buffer);
+        frees++;
+        live--;
+        return MC_DRV_OK;
+    }
+
+private:
+    uint32_t nextHandle;
+};
+
+//------------------------------------------------------------------------------
+class ClientWsm: public testing::Test
+{
+protected:
+    Device *device;
+    HeapKMod *kmod;
+
+    virtual void SetUp()
+    {
+        device = new Device(MC_DEVICE_ID_DEFAULT, new Connection());
+        delete device->pMcKMod;
+        kmod = new HeapKMod();
+        device->pMcKMod = kmod;
+        // Carving needs a daemon which applies TCI offsets into contiguous WSM
+        device->daemonVersion = MC_MAKE_VERSION(0, 4);
+    }
+
+    virtual void TearDown()
+    {
+        delete device;
+    }
+
+    CWsm_ptr alloc(uint32_t len)
+    {
+        CWsm_ptr wsm = NULL;
+        EXPECT_EQ(MC_DRV_OK, device->allocateContiguousWsm(len, &wsm));
+        return wsm;
+    }
+
+    /** Throughput of allocating and freeing len bytes with live others allocated */
+    double allocFreeRate(uint32_t len, int live, int rounds)
+    {
+        std::vector<CWsm_ptr> held;
+        for (int i = 0; i < live; i++) {
+            held.push_back(alloc(len));
+        }
+        double start = nowSec();
+        for (int i = 0; i < rounds; i++) {
+            CWsm_ptr wsm = alloc(len);
+            ((uint8_t *) wsm->virtAddr)[0] = 1;
+            device->freeContiguousWsm(wsm);
+        }
+        double rate = rounds / (nowSec() - start);
+        for (size_t i = 0; i < held.size(); i++) {
+            device->freeContiguousWsm(held[i]);
+        }
+        return rate;
+    }
+};
+
+/* Allocations up to WSM_SUBALLOC_MAX_PAGES pages are pages of one chunk */
+TEST_F(ClientWsm, SmallAllocationsShareAChunk)
+{
+    std::vector<CWsm_ptr> wsms;
+    for (int i = 0; i < WSM_CHUNK_PAGES; i++) {
+        wsms.push_back(alloc(1024));
+    }
+    EXPECT_EQ(1, kmod->maps);
+
+    uint8_t *base = (uint8_t *) wsms[0]->virtAddr;
+    for (int i = 0; i < WSM_CHUNK_PAGES; i++) {
+        CWsm_ptr wsm = wsms[i];
+        EXPECT_EQ(base + i * WSM_PAGE_SIZE, wsm->virtAddr);
+        EXPECT_EQ((uint32_t) i * WSM_PAGE_SIZE, wsm->offset);
+        EXPECT_EQ(wsms[0]->handle, wsm->handle);
+        EXPECT_EQ(wsms[0]->physAddr + wsm->offset, wsm->physAddr);
+        EXPECT_EQ(wsm, device->findContiguousWsm(wsm->virtAddr));
+    }
+    // The interval lookup must not resolve addresses inside an allocation
+    EXPECT_TRUE(device->findContiguousWsm(base + 16) == NULL);
+
+    for (int i = 0; i < WSM_CHUNK_PAGES; i++) {
+        EXPECT_EQ(MC_DRV_OK, device->freeContiguousWsm(wsms[i]));
+    }
+    EXPECT_EQ(0, kmod->frees);
+}
+
+/* Reused pages are handed out zeroed, like fresh ones from the kernel module */
+TEST_F(ClientWsm, CarvedMemoryIsZeroed)
+{
+    CWsm_ptr wsm = alloc(2 * WSM_PAGE_SIZE);
+    uint8_t *mem = (uint8_t *) wsm->virtAddr;
+    for (uint32_t i = 0; i < wsm->len; i++) {
+        ASSERT_EQ(0, mem[i]);
+    }
+    memset(mem, 0x5a, wsm->len);
+    device->freeContiguousWsm(wsm);
+
+    wsm = alloc(2 * WSM_PAGE_SIZE);
+    ASSERT_EQ(mem, wsm->virtAddr);
+    for (uint32_t i = 0; i < wsm->len; i++) {
+        ASSERT_EQ(0, mem[i]);
+    }
+    device->freeContiguousWsm(wsm);
+}
+
+/* Multi-page allocations go first fit, a full chunk makes room for another */
+TEST_F(ClientWsm, FullChunksGetCompany)
+{
+    std::vector<CWsm_ptr> wsms;
+    for (int i = 0; i < WSM_CHUNK_PAGES / WSM_SUBALLOC_MAX_PAGES; i++) {
+        wsms.push_back(alloc(WSM_SUBALLOC_MAX_PAGES * WSM_PAGE_SIZE));
+    }
+    EXPECT_EQ(1, kmod->maps);
+
+    // A hole of one page does not fit two
+    device->freeContiguousWsm(wsms[1]);
+    wsms[1] = alloc(WSM_PAGE_SIZE);
+    CWsm_ptr two = alloc(2 * WSM_PAGE_SIZE);
+    EXPECT_EQ(WSM_SUBALLOC_MAX_PAGES * WSM_PAGE_SIZE + WSM_PAGE_SIZE, two->offset);
+    CWsm_ptr more = alloc(2 * WSM_PAGE_SIZE);
+    EXPECT_EQ(2, kmod->maps);
+    EXPECT_EQ(0u, more->offset);
+    EXPECT_NE(two->handle, more->handle);
+
+    wsms.push_back(two);
+    wsms.push_back(more);
+    for (size_t i = 0; i < wsms.size(); i++) {
+        EXPECT_EQ(MC_DRV_OK, device->freeContiguousWsm(wsms[i]));
+    }
+}
+
+/* Emptied chunks are unmapped, except WSM_IDLE_CHUNKS_MAX kept for reuse */
+TEST_F(ClientWsm, IdleChunksAreUnmapped)
+{
+    std::vector<CWsm_ptr> wsms;
+    for (int i = 0; i < 3 * WSM_CHUNK_PAGES; i++) {
+        wsms.push_back(alloc(WSM_PAGE_SIZE));
+    }
+    EXPECT_EQ(3, kmod->maps);
+
+    for (size_t i = 0; i < wsms.size(); i++) {
+        device->freeContiguousWsm(wsms[i]);
+    }
+    EXPECT_EQ(3 - WSM_IDLE_CHUNKS_MAX, kmod->frees);
+    EXPECT_EQ(WSM_IDLE_CHUNKS_MAX, kmod->live);
+
+    // The idle chunk serves the next allocation without the kernel module
+    CWsm_ptr wsm = alloc(WSM_PAGE_SIZE);
+    EXPECT_EQ(3, kmod->maps);
+    device->freeContiguousWsm(wsm);
+}
+
+/* Larger allocations, and all of them for daemons without TCI offsets,
+ * keep their own kernel mapping */
+TEST_F(ClientWsm, OthersAreMappedDirectly)
+{
+    CWsm_ptr large = alloc((WSM_SUBALLOC_MAX_PAGES + 1) * WSM_PAGE_SIZE);
+    EXPECT_EQ(1, kmod->maps);
+    EXPECT_EQ(0u, large->offset);
+    EXPECT_EQ(MC_DRV_OK, device->freeContiguousWsm(large));
+    EXPECT_EQ(1, kmod->frees);
+
+    device->daemonVersion = MC_MAKE_VERSION(0, 3);
+    CWsm_ptr small = alloc(1024);
+    EXPECT_EQ(2, kmod->maps);
+    EXPECT_EQ(MC_DRV_OK, device->freeContiguousWsm(small));
+    EXPECT_EQ(2, kmod->frees);
+}
+
+/* The kernel module cannot see carved TCIs, so the client refuses to free them */
+TEST_F(ClientWsm, BusyTciIsNotFreed)
+{
+    CWsm_ptr tci = alloc(1024);
+    Session *session = device->createNewSession(1, new Connection());
+    session->tciWsm = tci;
+
+    EXPECT_EQ(MAKE_MC_DRV_KMOD_WITH_ERRNO(EBUSY), device->freeContiguousWsm(tci));
+    EXPECT_EQ(tci, device->findContiguousWsm(tci->virtAddr));
+
+    device->removeSession(1);
+    EXPECT_EQ(MC_DRV_OK, device->freeContiguousWsm(tci));
+}
+
+TEST_F(ClientWsm, AllocFreeCost)
+{
+    const int rounds = 500;
+    const uint32_t sizes[] = {1024, 4096, 16384, 32768};
+    const int live[] = {0, 8, 2, 2};
+
+    kmod->mapUs = 20;
+    kmod->freeUs = 10;
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        double carved = allocFreeRate(sizes[i], live[i], rounds);
+        device->daemonVersion = MC_MAKE_VERSION(0, 3);
+        double mapped = allocFreeRate(sizes[i], live[i], rounds);
+        device->daemonVersion = MC_MAKE_VERSION(0, 4);
+        printf("%5u bytes, %d live: %9.0f alloc+free/s mapped, %9.0f carved\n",
+               sizes[i], live[i], mapped, carved);
+    }
+}
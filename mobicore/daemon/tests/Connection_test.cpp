@@ -0,0 +1,119 @@
+/**
+ * @file
+ *
+ * Host tests for the socket connection read-ahead.
+ * 
+ * Notification sets wait for session sockets with epoll, so bytes received
+ * into rxBuffer ahead of a read must not hide pending notifications.
+ *
+ * Copyright (c) 2013 TRUSTONIC LIMITED
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the TRUSTONIC LIMITED nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <gtest/gtest.h>
+
+#include "Connection.h"
+
+//------------------------------------------------------------------------------
+class ConnectionReadAhead: public testing::Test
+{
+protected:
+    Connection *connection;
+    int peer;
+
+    virtual void SetUp()
+    {
+        int fds[2];
+        ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+        struct sockaddr_un remote;
+        memset(&remote, 0, sizeof(remote));
+        remote.sun_family = AF_UNIX;
+        connection = new Connection(fds[0], &remote);
+        peer = fds[1];
+    }
+
+    virtual void TearDown()
+    {
+        delete connection;
+        close(peer);
+    }
+
+    void sendMessages(uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; i++) {
+            ASSERT_EQ((ssize_t)sizeof(i), write(peer, &i, sizeof(i)));
+        }
+    }
+
+    bool socketReadable(void)
+    {
+        struct pollfd pfd;
+        pfd.fd = connection->socketDescriptor;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        return poll(&pfd, 1, 0) == 1 && (pfd.revents & POLLIN);
+    }
+};
+
+/* By default one read takes every pending message off the socket */
+TEST_F(ConnectionReadAhead, BuffersPendingMessages)
+{
+    sendMessages(4);
+
+    uint32_t message = ~0u;
+    ASSERT_EQ(sizeof(message), connection->readData(&message, sizeof(message), 1000));
+    EXPECT_EQ(0u, message);
+    EXPECT_TRUE(connection->hasBufferedData());
+    EXPECT_FALSE(socketReadable());
+
+    for (uint32_t i = 1; i < 4; i++) {
+        ASSERT_EQ(sizeof(message), connection->readData(&message, sizeof(message), 0));
+        EXPECT_EQ(i, message);
+    }
+    EXPECT_FALSE(connection->hasBufferedData());
+}
+
+/* Without read-ahead the socket keeps reporting what has not been read */
+TEST_F(ConnectionReadAhead, DisabledLeavesMessagesInTheSocket)
+{
+    connection->readAhead = false;
+    sendMessages(4);
+
+    uint32_t message = ~0u;
+    for (uint32_t i = 0; i < 4; i++) {
+        EXPECT_TRUE(socketReadable());
+        ASSERT_EQ(sizeof(message), connection->readData(&message, sizeof(message), 1000));
+        EXPECT_EQ(i, message);
+        EXPECT_FALSE(connection->hasBufferedData());
+    }
+    EXPECT_FALSE(socketReadable());
+}
@@ -0,0 +1,1439 @@
+/**
+ * @file
+ *
+ * Benchmark driver for the daemon on the simulated secure world.
+ * 
+ * Runs TLC workloads through libMcClient against an mcDriverDaemon built
+ * with MC_KMOD_SIMULATOR=true and reports latency percentiles per request
+ * type, see run_sim_bench.sh. Exits non-zero if any request fails.
+ *
+ * Copyright (c) 2013 TRUSTONIC LIMITED
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the TRUSTONIC LIMITED nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <dlfcn.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <vector>
+
+#include "MobiCoreDriverApi.h"
+#include "tee_client_api.h"
+#include "MobiCoreRegistry.h"
+#include "mcContainer.h"
+#include "mcLoadFormat.h"
+#include "mcVersionHelper.h"
+#include "SimSecureWorld.h"
+
+#define BENCH_TCI_LEN       4096
+#define BENCH_RSP_FLAG      0x80000000u /**< Set by the simulated TA in the first TCI word */
+#define BENCH_NOTIFY_WAIT   5000        /**< Timeout for a single notification in ms */
+
+static const mcUuid_t benchTaUuid = {
+    {0x6d, 0x63, 0x62, 0x65, 0x6e, 0x63, 0x68, 0, 0, 0, 0, 0, 0, 0, 0, 1}
+};
+
+/** The echo TA once more, loaded as a GP TA, and its UUID in registry byte order */
+static const TEEC_UUID benchGpTaUuid = {
+    0x6d636265, 0x6e63, 0x6800, {0, 0, 0, 0, 0, 0, 0, 2}
+};
+static const mcUuid_t benchGpTaRegistryUuid = {
+    {0x6d, 0x63, 0x62, 0x65, 0x6e, 0x63, 0x68, 0, 0, 0, 0, 0, 0, 0, 0, 2}
+};
+
+static volatile bool benchFailed;
+
+//------------------------------------------------------------------------------
+static uint64_t nowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+
+//------------------------------------------------------------------------------
+/* Each daemon request leaves libMcClient with a single send() or sendmsg().
+ * These definitions take precedence over the C library's, so counting them
+ * gives the round trips an operation costs. */
+static volatile uint32_t daemonRequests;
+
+extern "C" ssize_t send(int fd, const void *buf, size_t len, int flags)
+{
+    static ssize_t (*next)(int, const void *, size_t, int);
+    if (next == NULL) {
+        next = (ssize_t (*)(int, const void *, size_t, int)) dlsym(RTLD_NEXT, "send");
+    }
+    __sync_fetch_and_add(&daemonRequests, 1);
+    return next(fd, buf, len, flags);
+}
+
+extern "C" ssize_t sendmsg(int fd, const struct msghdr *msg, int flags)
+{
+    static ssize_t (*next)(int, const struct msghdr *, int);
+    if (next == NULL) {
+        next = (ssize_t (*)(int, const struct msghdr *, int)) dlsym(RTLD_NEXT, "sendmsg");
+    }
+    __sync_fetch_and_add(&daemonRequests, 1);
+    return next(fd, msg, flags);
+}
+
+
+//------------------------------------------------------------------------------
+static void fail(const char *what, uint32_t result)
+{
+    fprintf(stderr, "mcbench: %s failed: 0x%x\n", what, result);
+    benchFailed = true;
+}
+
+
+//------------------------------------------------------------------------------
+static void report(const char *name, std::vector<uint64_t> &ns)
+{
+    if (ns.empty()) {
+        printf("%-20s no samples\n", name);
+        return;
+    }
+    std::sort(ns.begin(), ns.end());
+    printf("%-20s n=%6zu p50=%8.1fus p90=%8.1fus p99=%8.1fus\n", name, ns.size(),
+           ns[ns.size() / 2] / 1e3, ns[ns.size() * 9 / 10] / 1e3,
+           ns[ns.size() * 99 / 100] / 1e3);
+}
+
+
+//------------------------------------------------------------------------------
+/** Store an MCLF header for the echo TA in the registry, the simulator never
+ * looks past it */
+static bool installBenchTa(const mcUuid_t *uuid, bool gp)
+{
+    const char *registry = getenv("MC_REGISTRY_PATH");
+    if (registry == NULL) {
+        fprintf(stderr, "mcbench: MC_REGISTRY_PATH is not set\n");
+        return false;
+    }
+
+    char path[256];
+    int len = snprintf(path, sizeof(path), "%s/", registry);
+    for (size_t i = 0; i < sizeof(uuid->value); i++) {
+        len += snprintf(path + len, sizeof(path) - len, "%02x", uuid->value[i]);
+    }
+    snprintf(path + len, sizeof(path) - len, gp ? ".tabin" : ".tlbin");
+
+    static uint8_t blob[4096];
+    memset(blob, 0, sizeof(blob));
+    mclfHeaderV24_t *header = (mclfHeaderV24_t *) blob;
+    header->mclfHeaderV2.mclfHeaderV2.intro.magic = MC_SERVICE_HEADER_MAGIC_BE;
+    header->mclfHeaderV2.mclfHeaderV2.intro.version = MC_MAKE_VERSION(2, 4);
+    header->mclfHeaderV2.mclfHeaderV2.serviceType = SERVICE_TYPE_SYSTEM_TRUSTLET;
+    header->mclfHeaderV2.mclfHeaderV2.numInstances = 64;
+    memcpy(&header->mclfHeaderV2.mclfHeaderV2.uuid, uuid, sizeof(*uuid));
+    header->gp_level = gp ? 1 : 0;
+
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "mcbench: cannot write %s\n", path);
+        return false;
+    }
+    bool ok = fwrite(blob, sizeof(blob), 1, file) == 1;
+    return fclose(file) == 0 && ok;
+}
+
+
+//------------------------------------------------------------------------------
+struct BenchSession {
+    mcSessionHandle_t handle;
+    uint8_t *tci;
+};
+
+static bool openBenchSession(BenchSession *session)
+{
+    mcResult_t result = mcMallocWsm(MC_DEVICE_ID_DEFAULT, 0, BENCH_TCI_LEN,
+                                    &session->tci, 0);
+    if (result != MC_DRV_OK) {
+        fail("mcMallocWsm", result);
+        return false;
+    }
+    memset(&session->handle, 0, sizeof(session->handle));
+    session->handle.deviceId = MC_DEVICE_ID_DEFAULT;
+    result = mcOpenSession(&session->handle, &benchTaUuid, session->tci, BENCH_TCI_LEN);
+    if (result != MC_DRV_OK) {
+        fail("mcOpenSession", result);
+        mcFreeWsm(MC_DEVICE_ID_DEFAULT, session->tci);
+        return false;
+    }
+    return true;
+}
+
+static void closeBenchSession(BenchSession *session)
+{
+    mcResult_t result = mcCloseSession(&session->handle);
+    if (result != MC_DRV_OK) {
+        fail("mcCloseSession", result);
+    }
+    mcFreeWsm(MC_DEVICE_ID_DEFAULT, session->tci);
+}
+
+
+//------------------------------------------------------------------------------
+/** One TCI round trip: notify the echo TA and wait for its answer */
+static bool notifyRoundTrip(BenchSession *session, uint32_t seq)
+{
+    uint32_t *tci = (uint32_t *) session->tci;
+    tci[0] = seq & ~BENCH_RSP_FLAG;
+    tci[1] = 0xdead;
+
+    mcResult_t result = mcNotify(&session->handle);
+    if (result == MC_DRV_OK) {
+        result = mcWaitNotification(&session->handle, BENCH_NOTIFY_WAIT);
+    }
+    if (result != MC_DRV_OK) {
+        fail("notify", result);
+        return false;
+    }
+    if (tci[0] != (seq | BENCH_RSP_FLAG) || tci[1] != 0) {
+        fail("notify response", tci[0]);
+        return false;
+    }
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+/** One registry read, served by the daemon without involving the MCP */
+static bool registryRoundTrip(void)
+{
+    mcSoAuthTokenCont_t token;
+    uint32_t size = sizeof(token);
+
+    mcResult_t result = mcRegistryReadAuthToken(&token, &size);
+    if (result != MC_DRV_OK || size != sizeof(token)) {
+        fail("mcRegistryReadAuthToken", result);
+        return false;
+    }
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+/** Opens a session to the GP echo TA. The TEEC context opens the device
+ * itself, so the benchmark's own device handle is closed meanwhile. */
+static bool openGpBenchSession(TEEC_Context *context, TEEC_Session *session)
+{
+    uint32_t returnOrigin;
+
+    mcCloseDevice(MC_DEVICE_ID_DEFAULT);
+    TEEC_Result result = TEEC_InitializeContext(NULL, context);
+    if (result != TEEC_SUCCESS) {
+        fail("TEEC_InitializeContext", result);
+    } else {
+        result = TEEC_OpenSession(context, session, &benchGpTaUuid, TEEC_LOGIN_PUBLIC,
+                                  NULL, NULL, &returnOrigin);
+        if (result == TEEC_SUCCESS) {
+            return true;
+        }
+        fail("TEEC_OpenSession", result);
+        TEEC_FinalizeContext(context);
+    }
+    mcOpenDevice(MC_DEVICE_ID_DEFAULT);
+    return false;
+}
+
+/** Closes the GP session and reopens the device for the next benchmark */
+static void closeGpBenchSession(TEEC_Context *context, TEEC_Session *session)
+{
+    TEEC_CloseSession(session);
+    TEEC_FinalizeContext(context);
+    mcResult_t result = mcOpenDevice(MC_DEVICE_ID_DEFAULT);
+    if (result != MC_DRV_OK) {
+        fail("mcOpenDevice", result);
+    }
+}
+
+
+//------------------------------------------------------------------------------
+#define BENCH_MAP_LEN   (64 * 1024)
+
+/** One TEEC_InvokeCommand to the GP echo TA with a value and a small buffer,
+ * which travel in the session's arena slot */
+static bool gpEchoRoundTrip(TEEC_Session *session, uint32_t seq)
+{
+    TEEC_Operation operation;
+    uint32_t returnOrigin;
+    char in[32], out[32];
+
+    snprintf(in, sizeof(in), "echo %u", seq);
+    memset(out, 0, sizeof(out));
+    memset(&operation, 0, sizeof(operation));
+    operation.paramTypes = TEEC_PARAM_TYPES(TEEC_VALUE_INPUT, TEEC_VALUE_OUTPUT,
+                                            TEEC_MEMREF_TEMP_INPUT, TEEC_MEMREF_TEMP_OUTPUT);
+    operation.params[0].value.a = seq;
+    operation.params[0].value.b = ~seq;
+    operation.params[2].tmpref.buffer = in;
+    operation.params[2].tmpref.size = strlen(in) + 1;
+    operation.params[3].tmpref.buffer = out;
+    operation.params[3].tmpref.size = sizeof(out);
+
+    TEEC_Result result = TEEC_InvokeCommand(session, 1, &operation, &returnOrigin);
+    if (result != TEEC_SUCCESS) {
+        fail("TEEC_InvokeCommand", result);
+        return false;
+    }
+    if (operation.params[1].value.a != seq || operation.params[1].value.b != ~seq
+            || operation.params[3].tmpref.size != strlen(in) + 1 || strcmp(in, out) != 0) {
+        fail("TEEC_InvokeCommand response", operation.params[1].value.a);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * The basic round trips through libMcClient, the daemon and the simulated
+ * secure world, one at a time: open and close of a session, a TCI
+ * notification, map and unmap of a 64 KiB buffer and a GP command. Each
+ * checks the echo TA's answer, so a short run makes a smoke test, e.g.
+ * run_sim_bench.sh -n 20 roundtrips.
+ */
+static void benchRoundTrips(int iterations)
+{
+    std::vector<uint64_t> openNs, notifyNs, mapNs, invokeNs;
+    BenchSession session;
+
+    for (int i = 0; i < iterations && !benchFailed; i++) {
+        uint64_t start = nowNs();
+        if (!openBenchSession(&session)) {
+            break;
+        }
+        closeBenchSession(&session);
+        openNs.push_back(nowNs() - start);
+    }
+    report("open+close", openNs);
+
+    void *buf;
+    if (posix_memalign(&buf, 4096, BENCH_MAP_LEN) != 0) {
+        fail("posix_memalign", 0);
+        return;
+    }
+    memset(buf, 0, BENCH_MAP_LEN);
+    if (!benchFailed && openBenchSession(&session)) {
+        for (int i = 0; i < iterations && !benchFailed; i++) {
+            uint64_t start = nowNs();
+            if (!notifyRoundTrip(&session, i)) {
+                break;
+            }
+            notifyNs.push_back(nowNs() - start);
+        }
+        for (int i = 0; i < iterations && !benchFailed; i++) {
+            mcBulkMap_t map;
+            uint64_t start = nowNs();
+            mcResult_t result = mcMap(&session.handle, buf, BENCH_MAP_LEN, &map);
+            if (result == MC_DRV_OK) {
+                result = mcUnmap(&session.handle, buf, &map);
+            }
+            if (result != MC_DRV_OK) {
+                fail("mcMap/mcUnmap", result);
+                break;
+            }
+            mapNs.push_back(nowNs() - start);
+        }
+        closeBenchSession(&session);
+    }
+    free(buf);
+    report("notify", notifyNs);
+    report("map+unmap 64K", mapNs);
+
+    TEEC_Context context;
+    TEEC_Session gpSession;
+    if (benchFailed || !openGpBenchSession(&context, &gpSession)) {
+        return;
+    }
+    for (int i = 0; i < iterations && !benchFailed; i++) {
+        uint64_t start = nowNs();
+        if (!gpEchoRoundTrip(&gpSession, i)) {
+            break;
+        }
+        invokeNs.push_back(nowNs() - start);
+    }
+    closeGpBenchSession(&context, &gpSession);
+    report("GP invoke", invokeNs);
+}
+
+
+//------------------------------------------------------------------------------
+enum ContentionRole {
+    ROLE_NOTIFY,
+    ROLE_REGISTRY,
+    ROLE_OPEN,
+};
+
+struct ContentionWorker {
+    pthread_t thread;
+    ContentionRole role;
+    int iterations;
+    volatile bool *stop;
+    std::vector<uint64_t> ns;
+};
+
+static void *runContentionWorker(void *arg)
+{
+    ContentionWorker *worker = (ContentionWorker *) arg;
+    BenchSession session;
+
+    if (worker->role == ROLE_NOTIFY && !openBenchSession(&session)) {
+        return NULL;
+    }
+    for (int i = 0; !benchFailed; i++) {
+        if (worker->role == ROLE_OPEN ? *worker->stop : i == worker->iterations) {
+            break;
+        }
+        uint64_t start = nowNs();
+        bool ok;
+        switch (worker->role) {
+        case ROLE_NOTIFY:
+            ok = notifyRoundTrip(&session, i);
+            break;
+        case ROLE_REGISTRY:
+            ok = registryRoundTrip();
+            break;
+        default:
+            ok = openBenchSession(&session);
+            if (ok) {
+                closeBenchSession(&session);
+            }
+            break;
+        }
+        if (!ok) {
+            break;
+        }
+        worker->ns.push_back(nowNs() - start);
+    }
+    if (worker->role == ROLE_NOTIFY) {
+        closeBenchSession(&session);
+    }
+    return NULL;
+}
+
+static void runContention(ContentionRole role, int clients, int iterations,
+                          int openers, const char *name)
+{
+    volatile bool stop = false;
+    std::vector<ContentionWorker> workers(clients + openers);
+
+    for (int i = 0; i < clients + openers; i++) {
+        workers[i].role = i < clients ? role : ROLE_OPEN;
+        workers[i].iterations = iterations;
+        workers[i].stop = &stop;
+        pthread_create(&workers[i].thread, NULL, runContentionWorker, &workers[i]);
+    }
+
+    std::vector<uint64_t> clientNs, openNs;
+    for (int i = 0; i < clients + openers; i++) {
+        if (i == clients) {
+            stop = true;
+        }
+        pthread_join(workers[i].thread, NULL);
+        std::vector<uint64_t> &all = i < clients ? clientNs : openNs;
+        all.insert(all.end(), workers[i].ns.begin(), workers[i].ns.end());
+    }
+
+    report(name, clientNs);
+    if (openers > 0) {
+        report("  open+close", openNs);
+    }
+}
+
+/**
+ * Registry reads and notify round trips of several clients, first alone and
+ * then while other threads keep opening and closing sessions. Set
+ * MC_SIM_MCP_LATENCY_US for the daemon to make MCP commands slow.
+ *
+ * Registry reads only take the registry lock in the daemon and must not wait
+ * for the MCP. Notifications share the secure world with the MCP commands,
+ * so their round trip does include the MCP latency, as on a device.
+ */
+static void benchContention(int iterations)
+{
+    const int clients = 8, openers = 2;
+
+    mcSoAuthTokenCont_t token;
+    memset(&token, 0x5a, sizeof(token));
+    mcResult_t result = mcRegistryStoreAuthToken(&token, sizeof(token));
+    if (result != MC_DRV_OK) {
+        fail("mcRegistryStoreAuthToken", result);
+        return;
+    }
+
+    runContention(ROLE_REGISTRY, clients, iterations, 0, "registry read");
+    runContention(ROLE_REGISTRY, clients, iterations, openers, "registry during open");
+    runContention(ROLE_NOTIFY, clients, iterations, 0, "notify");
+    runContention(ROLE_NOTIFY, clients, iterations, openers, "notify during open");
+
+    mcRegistryDeleteAuthToken();
+}
+
+
+//------------------------------------------------------------------------------
+struct MapWorker {
+    pthread_t thread;
+    int iterations;
+    std::vector<uint64_t> ns;
+};
+
+static void *runMapWorker(void *arg)
+{
+    MapWorker *worker = (MapWorker *) arg;
+    BenchSession session;
+    void *buf;
+
+    if (posix_memalign(&buf, 4096, BENCH_MAP_LEN) != 0) {
+        fail("posix_memalign", 0);
+        return NULL;
+    }
+    memset(buf, 0, BENCH_MAP_LEN);
+    if (!openBenchSession(&session)) {
+        free(buf);
+        return NULL;
+    }
+    for (int i = 0; i < worker->iterations && !benchFailed; i++) {
+        mcBulkMap_t map;
+        uint64_t start = nowNs();
+        mcResult_t result = mcMap(&session.handle, buf, BENCH_MAP_LEN, &map);
+        if (result != MC_DRV_OK) {
+            fail("mcMap", result);
+            break;
+        }
+        result = mcUnmap(&session.handle, buf, &map);
+        if (result != MC_DRV_OK) {
+            fail("mcUnmap", result);
+            break;
+        }
+        worker->ns.push_back(nowNs() - start);
+    }
+    closeBenchSession(&session);
+    free(buf);
+    return NULL;
+}
+
+/**
+ * Map and unmap of a 64 KiB buffer by 1, 4 and 8 threads of one process,
+ * each on its own session. Set MC_SIM_KMOD_LATENCY_US to give L2
+ * registrations the cost of pinning pages, which the client library does
+ * without holding a lock over all of its sessions.
+ */
+static void benchMaps(int iterations)
+{
+    const int threadCounts[] = {1, 4, 8};
+
+    for (size_t k = 0; k < sizeof(threadCounts) / sizeof(threadCounts[0]); k++) {
+        int threads = threadCounts[k];
+        std::vector<MapWorker> workers(threads);
+        uint64_t start = nowNs();
+
+        for (int i = 0; i < threads; i++) {
+            workers[i].iterations = iterations;
+            pthread_create(&workers[i].thread, NULL, runMapWorker, &workers[i]);
+        }
+        std::vector<uint64_t> ns;
+        for (int i = 0; i < threads; i++) {
+            pthread_join(workers[i].thread, NULL);
+            ns.insert(ns.end(), workers[i].ns.begin(), workers[i].ns.end());
+        }
+        double elapsed = (nowNs() - start) / 1e9;
+
+        char name[32];
+        snprintf(name, sizeof(name), "map+unmap x%d", threads);
+        report(name, ns);
+        printf("%-20s %.0f map+unmap/s\n", "", ns.size() / elapsed);
+    }
+}
+
+
+//------------------------------------------------------------------------------
+/** Error handling of notification sets, fails the benchmark on a mismatch */
+static void checkNotificationSetApi(void)
+{
+    int32_t setFd;
+    BenchSession session;
+    mcSessionHandle_t fired[4];
+    mcResult_t results[4];
+    uint32_t count = 4;
+
+    mcResult_t result = mcOpenNotificationSet(&setFd);
+    if (result != MC_DRV_OK) {
+        fail("mcOpenNotificationSet", result);
+        return;
+    }
+    if (!openBenchSession(&session)) {
+        mcCloseNotificationSet(setFd);
+        return;
+    }
+
+    if ((result = mcAddToNotificationSet(setFd, &session.handle)) != MC_DRV_OK) {
+        fail("mcAddToNotificationSet", result);
+    }
+    if ((result = mcAddToNotificationSet(setFd, &session.handle)) != MC_DRV_ERR_INVALID_PARAMETER) {
+        fail("mcAddToNotificationSet of a member", result);
+    }
+    if ((result = mcWaitNotificationSet(setFd, fired, results, &count, MC_NO_TIMEOUT))
+            != MC_DRV_ERR_TIMEOUT) {
+        fail("mcWaitNotificationSet without notification", result);
+    }
+    if ((result = mcRemoveFromNotificationSet(setFd, &session.handle)) != MC_DRV_OK) {
+        fail("mcRemoveFromNotificationSet", result);
+    }
+    if ((result = mcRemoveFromNotificationSet(setFd, &session.handle))
+            != MC_DRV_ERR_INVALID_PARAMETER) {
+        fail("mcRemoveFromNotificationSet of a non member", result);
+    }
+
+    // A closed session leaves the set, its notifications are not reported
+    if ((result = mcAddToNotificationSet(setFd, &session.handle)) != MC_DRV_OK) {
+        fail("mcAddToNotificationSet", result);
+    }
+    ((uint32_t *) session.tci)[0] = 1;
+    mcNotify(&session.handle);
+    closeBenchSession(&session);
+    count = 4;
+    result = mcWaitNotificationSet(setFd, fired, results, &count, 100);
+    if (result != MC_DRV_ERR_TIMEOUT
+            && (result != MC_DRV_OK || count != 0)) {
+        fail("mcWaitNotificationSet after close", result);
+    }
+
+    mcCloseNotificationSet(setFd);
+}
+
+struct NotifyWorker {
+    pthread_t thread;
+    int iterations;
+    std::vector<uint64_t> ns;
+};
+
+static void *runNotifyWorker(void *arg)
+{
+    NotifyWorker *worker = (NotifyWorker *) arg;
+    BenchSession session;
+
+    if (!openBenchSession(&session)) {
+        return NULL;
+    }
+    for (int i = 0; i < worker->iterations && !benchFailed; i++) {
+        uint64_t start = nowNs();
+        if (!notifyRoundTrip(&session, i)) {
+            break;
+        }
+        worker->ns.push_back(nowNs() - start);
+    }
+    closeBenchSession(&session);
+    return NULL;
+}
+
+/** Every session waits in a thread of its own */
+static void runPerSessionWaits(int sessions, int iterations, std::vector<uint64_t> &ns)
+{
+    std::vector<NotifyWorker> workers(sessions);
+
+    for (int i = 0; i < sessions; i++) {
+        workers[i].iterations = iterations;
+        pthread_create(&workers[i].thread, NULL, runNotifyWorker, &workers[i]);
+    }
+    for (int i = 0; i < sessions; i++) {
+        pthread_join(workers[i].thread, NULL);
+        ns.insert(ns.end(), workers[i].ns.begin(), workers[i].ns.end());
+    }
+}
+
+static bool notifyEcho(BenchSession *session, uint32_t seq)
+{
+    uint32_t *tci = (uint32_t *) session->tci;
+    tci[0] = seq & ~BENCH_RSP_FLAG;
+    tci[1] = 0xdead;
+
+    mcResult_t result = mcNotify(&session->handle);
+    if (result != MC_DRV_OK) {
+        fail("mcNotify", result);
+        return false;
+    }
+    return true;
+}
+
+/** One thread keeps every session busy and waits for all of them on a set */
+static void runSetWaits(int sessions, int iterations, std::vector<uint64_t> &ns)
+{
+    std::vector<BenchSession> session(sessions);
+    std::vector<uint64_t> sent(sessions);
+    std::vector<int> done(sessions);
+    int32_t setFd;
+    int opened = 0;
+
+    mcResult_t result = mcOpenNotificationSet(&setFd);
+    if (result != MC_DRV_OK) {
+        fail("mcOpenNotificationSet", result);
+        return;
+    }
+    for (; opened < sessions; opened++) {
+        if (!openBenchSession(&session[opened])) {
+            break;
+        }
+        result = mcAddToNotificationSet(setFd, &session[opened].handle);
+        if (result != MC_DRV_OK) {
+            fail("mcAddToNotificationSet", result);
+            opened++;
+            break;
+        }
+    }
+
+    int pending = 0;
+    for (int i = 0; i < opened && !benchFailed; i++) {
+        sent[i] = nowNs();
+        pending += notifyEcho(&session[i], 0) ? 1 : 0;
+    }
+    while (pending > 0 && !benchFailed) {
+        mcSessionHandle_t fired[MC_NOTIFICATION_SET_MAX_EVENTS];
+        mcResult_t results[MC_NOTIFICATION_SET_MAX_EVENTS];
+        uint32_t count = MC_NOTIFICATION_SET_MAX_EVENTS;
+
+        result = mcWaitNotificationSet(setFd, fired, results, &count, BENCH_NOTIFY_WAIT);
+        if (result != MC_DRV_OK) {
+            fail("mcWaitNotificationSet", result);
+            break;
+        }
+        uint64_t now = nowNs();
+        for (uint32_t k = 0; k < count; k++) {
+            int i = 0;
+            while (i < opened && session[i].handle.sessionId != fired[k].sessionId) {
+                i++;
+            }
+            uint32_t *tci = (uint32_t *) session[i].tci;
+            if (i == opened || results[k] != MC_DRV_OK) {
+                fail("notification set result", results[k]);
+                continue;
+            }
+            if (tci[0] != ((uint32_t) done[i] | BENCH_RSP_FLAG) || tci[1] != 0) {
+                fail("notify response", tci[0]);
+                continue;
+            }
+            ns.push_back(now - sent[i]);
+            pending--;
+            if (++done[i] < iterations) {
+                sent[i] = nowNs();
+                pending += notifyEcho(&session[i], done[i]) ? 1 : 0;
+            }
+        }
+    }
+
+    for (int i = 0; i < opened; i++) {
+        closeBenchSession(&session[i]);
+    }
+    mcCloseNotificationSet(setFd);
+}
+
+/**
+ * Notify round trips of 4 and 12 sessions, waited for by a thread per
+ * session and by a single thread on a notification set. The daemon drops
+ * notifications beyond the 16 entries of the notification queue, so all
+ * sessions together stay below that.
+ */
+static void benchNotifySet(int iterations)
+{
+    const int sessionCounts[] = {4, 12};
+
+    checkNotificationSetApi();
+
+    for (size_t k = 0; k < sizeof(sessionCounts) / sizeof(sessionCounts[0]); k++) {
+        for (int set = 0; set < 2 && !benchFailed; set++) {
+            std::vector<uint64_t> ns;
+            uint64_t start = nowNs();
+            if (set) {
+                runSetWaits(sessionCounts[k], iterations, ns);
+            } else {
+                runPerSessionWaits(sessionCounts[k], iterations, ns);
+            }
+            double elapsed = (nowNs() - start) / 1e9;
+
+            char name[32];
+            snprintf(name, sizeof(name), "%d %s", sessionCounts[k],
+                     set ? "on a set" : "per thread");
+            report(name, ns);
+            printf("%-20s %.0f round trips/s\n", "", ns.size() / elapsed);
+        }
+    }
+}
+
+
+//------------------------------------------------------------------------------
+/** Above TEEC_ARENA_MEMREF_MAX_SIZE, so TEEC maps the buffers rather than
+ * copying them into the session's arena slot */
+#define BENCH_MEMREF_LEN    (2 * TEEC_ARENA_MEMREF_MAX_SIZE)
+#define BENCH_MAX_MEMREFS   4
+
+/**
+ * Daemon requests and latency of mapping N buffers around a notification,
+ * one mcMap()/mcUnmap() per buffer against mcMapList()/mcUnmapList().
+ */
+static void runMapRoundTrips(BenchSession *session, uint8_t **bufs, int memrefs,
+                             bool list, int iterations)
+{
+    std::vector<uint64_t> ns;
+    uint32_t requests = daemonRequests;
+
+    for (int i = 0; i < iterations && !benchFailed; i++) {
+        mcBulkMap_t maps[BENCH_MAX_MEMREFS];
+        mcBulkBuf_t bulkBufs[BENCH_MAX_MEMREFS];
+        mcResult_t result = MC_DRV_OK;
+        uint64_t start = nowNs();
+
+        for (int j = 0; j < memrefs; j++) {
+            bulkBufs[j].buf = bufs[j];
+            bulkBufs[j].len = BENCH_MEMREF_LEN;
+            bulkBufs[j].mapInfo = &maps[j];
+        }
+        if (list) {
+            result = mcMapList(&session->handle, bulkBufs, memrefs);
+        } else {
+            for (int j = 0; j < memrefs && result == MC_DRV_OK; j++) {
+                result = mcMap(&session->handle, bufs[j], BENCH_MEMREF_LEN, &maps[j]);
+            }
+        }
+        if (result != MC_DRV_OK) {
+            fail(list ? "mcMapList" : "mcMap", result);
+            break;
+        }
+        if (!notifyRoundTrip(session, i)) {
+            break;
+        }
+        if (list) {
+            result = mcUnmapList(&session->handle, bulkBufs, memrefs);
+        } else {
+            for (int j = 0; j < memrefs && result == MC_DRV_OK; j++) {
+                result = mcUnmap(&session->handle, bufs[j], &maps[j]);
+            }
+        }
+        if (result != MC_DRV_OK) {
+            fail(list ? "mcUnmapList" : "mcUnmap", result);
+            break;
+        }
+        ns.push_back(nowNs() - start);
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), "%d %s", memrefs, list ? "as a list" : "one by one");
+    report(name, ns);
+    if (!ns.empty()) {
+        printf("%-20s %.1f daemon requests each\n", "",
+               (double)(daemonRequests - requests) / ns.size());
+    }
+}
+
+/** TEEC_InvokeCommand with N temporary memory references to the GP echo TA */
+static void runInvokeRoundTrips(TEEC_Session *session, uint8_t **bufs, int memrefs,
+                                int iterations)
+{
+    std::vector<uint64_t> ns;
+    uint32_t requests = daemonRequests;
+
+    for (int i = 0; i < iterations && !benchFailed; i++) {
+        TEEC_Operation operation;
+        uint32_t paramTypes[BENCH_MAX_MEMREFS] = {TEEC_NONE, TEEC_NONE, TEEC_NONE, TEEC_NONE};
+        uint32_t returnOrigin;
+
+        memset(&operation, 0, sizeof(operation));
+        for (int j = 0; j < memrefs; j++) {
+            paramTypes[j] = TEEC_MEMREF_TEMP_INOUT;
+            operation.params[j].tmpref.buffer = bufs[j];
+            operation.params[j].tmpref.size = BENCH_MEMREF_LEN;
+        }
+        operation.paramTypes = TEEC_PARAM_TYPES(paramTypes[0], paramTypes[1],
+                                                paramTypes[2], paramTypes[3]);
+
+        uint64_t start = nowNs();
+        TEEC_Result result = TEEC_InvokeCommand(session, 1, &operation, &returnOrigin);
+        if (result != TEEC_SUCCESS) {
+            fail("TEEC_InvokeCommand", result);
+            break;
+        }
+        ns.push_back(nowNs() - start);
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), "%d TEEC memrefs", memrefs);
+    report(name, ns);
+    if (!ns.empty()) {
+        printf("%-20s %.1f daemon requests each\n", "",
+               (double)(daemonRequests - requests) / ns.size());
+    }
+}
+
+/**
+ * Round trips of operations with 1, 2 and 4 memory references. Buffers are
+ * mapped one by one and as a list by the same daemon, then passed to a GP
+ * TA as temporary memory references.
+ */
+static void benchMemrefs(int iterations)
+{
+    const int memrefCounts[] = {1, 2, 4};
+    uint8_t *bufs[BENCH_MAX_MEMREFS];
+    BenchSession session;
+
+    for (int j = 0; j < BENCH_MAX_MEMREFS; j++) {
+        if (posix_memalign((void **) &bufs[j], 4096, BENCH_MEMREF_LEN) != 0) {
+            fail("posix_memalign", 0);
+            return;
+        }
+        memset(bufs[j], j, BENCH_MEMREF_LEN);
+    }
+
+    if (openBenchSession(&session)) {
+        for (size_t k = 0; k < sizeof(memrefCounts) / sizeof(memrefCounts[0]); k++) {
+            runMapRoundTrips(&session, bufs, memrefCounts[k], false, iterations);
+            runMapRoundTrips(&session, bufs, memrefCounts[k], true, iterations);
+        }
+        closeBenchSession(&session);
+    }
+
+    TEEC_Context context;
+    TEEC_Session gpSession;
+    if (openGpBenchSession(&context, &gpSession)) {
+        for (size_t k = 0; k < sizeof(memrefCounts) / sizeof(memrefCounts[0]); k++) {
+            runInvokeRoundTrips(&gpSession, bufs, memrefCounts[k], iterations);
+        }
+        closeGpBenchSession(&context, &gpSession);
+    }
+
+    for (int j = 0; j < BENCH_MAX_MEMREFS; j++) {
+        free(bufs[j]);
+    }
+}
+
+
+//------------------------------------------------------------------------------
+#define BENCH_SECRET_LEN    1024
+
+/**
+ * Asks the echo TA for the non-zero bytes of the mapping behind a temporary
+ * memory reference, for a small one the session's arena slot. The reference
+ * holds len bytes of 0xa5, or a single zero byte for len 0.
+ */
+static bool countArenaSlot(TEEC_Session *session, size_t len, uint32_t *nonZero)
+{
+    TEEC_Operation operation;
+    uint32_t returnOrigin;
+    uint8_t data[BENCH_SECRET_LEN];
+
+    memset(data, len > 0 ? 0xa5 : 0, sizeof(data));
+    memset(&operation, 0, sizeof(operation));
+    operation.paramTypes = TEEC_PARAM_TYPES(TEEC_MEMREF_TEMP_INPUT, TEEC_VALUE_OUTPUT,
+                                            TEEC_NONE, TEEC_NONE);
+    operation.params[0].tmpref.buffer = data;
+    operation.params[0].tmpref.size = len > 0 ? len : 1;
+
+    TEEC_Result result = TEEC_InvokeCommand(session, SIM_GP_CMD_COUNT_NONZERO, &operation,
+                                            &returnOrigin);
+    if (result != TEEC_SUCCESS) {
+        fail("TEEC_InvokeCommand count", result);
+        return false;
+    }
+    *nonZero = operation.params[1].value.a;
+    return true;
+}
+
+/** Echoes len bytes through the GP echo TA and checks them */
+static bool arenaEchoRoundTrip(TEEC_Session *session, uint8_t *in, uint8_t *out, size_t len)
+{
+    TEEC_Operation operation;
+    uint32_t returnOrigin;
+
+    memset(out, 0, len);
+    memset(&operation, 0, sizeof(operation));
+    operation.paramTypes = TEEC_PARAM_TYPES(TEEC_MEMREF_TEMP_INPUT, TEEC_MEMREF_TEMP_OUTPUT,
+                                            TEEC_NONE, TEEC_NONE);
+    operation.params[0].tmpref.buffer = in;
+    operation.params[0].tmpref.size = len;
+    operation.params[1].tmpref.buffer = out;
+    operation.params[1].tmpref.size = len;
+
+    TEEC_Result result = TEEC_InvokeCommand(session, 1, &operation, &returnOrigin);
+    if (result != TEEC_SUCCESS) {
+        fail("TEEC_InvokeCommand", result);
+        return false;
+    }
+    if (operation.params[1].tmpref.size != len || memcmp(in, out, len) != 0) {
+        fail("TEEC_InvokeCommand response", operation.params[1].tmpref.size);
+        return false;
+    }
+    return true;
+}
+
+/** Latency of echoing len bytes, with the arena statistics per invoke */
+static void runArenaRoundTrips(TEEC_Context *context, TEEC_Session *session, size_t len,
+                               int iterations)
+{
+    std::vector<uint64_t> ns;
+    std::vector<uint8_t> in(len), out(len);
+    TEEC_ArenaStats_IMP before, after;
+
+    for (size_t i = 0; i < len; i++) {
+        in[i] = (uint8_t) (i * 7 + 1);
+    }
+    TEEC_GetArenaStats(context, &before);
+    for (int i = 0; i < iterations && !benchFailed; i++) {
+        uint64_t start = nowNs();
+        if (!arenaEchoRoundTrip(session, &in[0], &out[0], len)) {
+            break;
+        }
+        ns.push_back(nowNs() - start);
+    }
+    TEEC_GetArenaStats(context, &after);
+
+    char name[32];
+    snprintf(name, sizeof(name), "echo %zu bytes", len);
+    report(name, ns);
+    if (!ns.empty()) {
+        printf("%-20s %.1f memrefs copied (%.0f bytes), %.1f mapped each\n", "",
+               (double)(after.copiedMemrefs - before.copiedMemrefs) / ns.size(),
+               (double)(after.copiedBytes - before.copiedBytes) / ns.size(),
+               (double)(after.mappedMemrefs - before.mappedMemrefs) / ns.size());
+    }
+}
+
+/**
+ * The arena of temporary memory references of a TEEC context. Checks that
+ * sessions opened one after the other reuse the slots, that a slot reaches
+ * the next session wiped, and that sessions beyond TEEC_ARENA_SLOT_NUMBER
+ * map their memory references instead. Then times echoes small enough for
+ * the arena against ones which are mapped.
+ */
+static void benchArena(int iterations)
+{
+    const int reopens = 2 * TEEC_ARENA_SLOT_NUMBER;
+    TEEC_Context context;
+    TEEC_Session sessions[TEEC_ARENA_SLOT_NUMBER + 1];
+    TEEC_ArenaStats_IMP before, after;
+    uint32_t returnOrigin, nonZero;
+
+    if (!openGpBenchSession(&context, &sessions[0])) {
+        return;
+    }
+    TEEC_CloseSession(&sessions[0]);
+    if (TEEC_GetArenaStats(&context, &before) != TEEC_SUCCESS) {
+        fail("TEEC_GetArenaStats", 0);
+    }
+
+    // Each session leaves a secret in its slot, the next one must not see it
+    for (int i = 0; i < reopens && !benchFailed; i++) {
+        TEEC_Result result = TEEC_OpenSession(&context, &sessions[0], &benchGpTaUuid,
+                                              TEEC_LOGIN_PUBLIC, NULL, NULL, &returnOrigin);
+        if (result != TEEC_SUCCESS) {
+            fail("TEEC_OpenSession", result);
+            break;
+        }
+        if (countArenaSlot(&sessions[0], 0, &nonZero) && nonZero != 0) {
+            fail("arena slot wipe, non-zero bytes", nonZero);
+        }
+        if (countArenaSlot(&sessions[0], BENCH_SECRET_LEN, &nonZero)
+                && nonZero != BENCH_SECRET_LEN) {
+            fail("arena slot staging, non-zero bytes", nonZero);
+        }
+        TEEC_CloseSession(&sessions[0]);
+    }
+    TEEC_GetArenaStats(&context, &after);
+    if (after.sessionsWithSlot - before.sessionsWithSlot != (uint32_t) reopens
+            || after.sessionsWithoutSlot != before.sessionsWithoutSlot) {
+        fail("arena slot reuse, sessions without slot",
+             after.sessionsWithoutSlot - before.sessionsWithoutSlot);
+    }
+
+    // One session more than there are slots, its memory references are mapped
+    int opened = 0;
+    while (opened < TEEC_ARENA_SLOT_NUMBER + 1 && !benchFailed) {
+        TEEC_Result result = TEEC_OpenSession(&context, &sessions[opened], &benchGpTaUuid,
+                                              TEEC_LOGIN_PUBLIC, NULL, NULL, &returnOrigin);
+        if (result != TEEC_SUCCESS) {
+            fail("TEEC_OpenSession", result);
+            break;
+        }
+        opened++;
+    }
+    if (!benchFailed) {
+        TEEC_GetArenaStats(&context, &before);
+        if (before.sessionsWithoutSlot - after.sessionsWithoutSlot != 1) {
+            fail("arena exhaustion, sessions without slot",
+                 before.sessionsWithoutSlot - after.sessionsWithoutSlot);
+        }
+        gpEchoRoundTrip(&sessions[TEEC_ARENA_SLOT_NUMBER], 0);
+        TEEC_GetArenaStats(&context, &after);
+        if (after.mappedMemrefs - before.mappedMemrefs != 2) {
+            fail("arena exhaustion, mapped memrefs", after.mappedMemrefs - before.mappedMemrefs);
+        }
+    }
+    while (opened > 1) {
+        TEEC_CloseSession(&sessions[--opened]);
+    }
+
+    if (opened == 1) {
+        runArenaRoundTrips(&context, &sessions[0], 256, iterations);
+        runArenaRoundTrips(&context, &sessions[0], TEEC_ARENA_MEMREF_MAX_SIZE, iterations);
+        runArenaRoundTrips(&context, &sessions[0], 2 * TEEC_ARENA_MEMREF_MAX_SIZE, iterations);
+        closeGpBenchSession(&context, &sessions[0]);
+    } else {
+        TEEC_FinalizeContext(&context);
+        mcOpenDevice(MC_DEVICE_ID_DEFAULT);
+    }
+}
+
+
+//------------------------------------------------------------------------------
+#define BENCH_ASYNC_SESSIONS    4
+#define BENCH_ASYNC_SLEEP_US    2000        /**< TA time of a timed command */
+#define BENCH_ASYNC_LONG_US     2000000     /**< TA time of a command to be cancelled */
+
+/** What a completion callback saw, and what it does with the context */
+struct BenchAsyncResult {
+    volatile bool   done;
+    TEEC_Result     result;
+    TEEC_Session    *closeSession;      /**< Closed by the callback if set */
+    TEEC_Context    *finalizeContext;   /**< Finalized by the callback if set */
+};
+
+static void benchAsyncCallback(TEEC_Operation *operation, TEEC_Result result,
+                               uint32_t returnOrigin, void *userData)
+{
+    BenchAsyncResult *async = (BenchAsyncResult *) userData;
+
+    (void) operation;
+    (void) returnOrigin;
+    async->result = result;
+    if (async->closeSession != NULL) {
+        TEEC_CloseSession(async->closeSession);
+    }
+    if (async->finalizeContext != NULL) {
+        TEEC_FinalizeContext(async->finalizeContext);
+    }
+    __sync_synchronize();
+    async->done = true;
+}
+
+/** Waits up to timeoutMs for a flag set by another thread */
+static bool waitFlag(volatile bool *flag, int timeoutMs)
+{
+    for (int i = 0; i < timeoutMs && !*flag; i++) {
+        usleep(1000);
+    }
+    return *flag;
+}
+
+/** Starts SIM_GP_CMD_SLEEP on the GP echo TA */
+static bool startAsyncSleep(TEEC_Session *session, TEEC_Operation *operation, uint32_t us,
+                            BenchAsyncResult *async)
+{
+    uint32_t returnOrigin;
+
+    memset(operation, 0, sizeof(*operation));
+    operation->paramTypes = TEEC_PARAM_TYPES(TEEC_VALUE_INPUT, TEEC_VALUE_OUTPUT,
+                                             TEEC_NONE, TEEC_NONE);
+    operation->params[0].value.a = us;
+    operation->params[0].value.b = ~us;
+    TEEC_Result result = TEEC_InvokeCommandAsync(session, SIM_GP_CMD_SLEEP, operation,
+                                                 async != NULL ? benchAsyncCallback : NULL,
+                                                 async, &returnOrigin);
+    if (result != TEEC_SUCCESS) {
+        fail("TEEC_InvokeCommandAsync", result);
+        return false;
+    }
+    return true;
+}
+
+/** Counts completions signalled on the completion fd within timeoutMs */
+static uint64_t readCompletions(int fd, uint64_t expected, int timeoutMs)
+{
+    uint64_t completions = 0;
+    uint64_t deadline = nowNs() + (uint64_t) timeoutMs * 1000000;
+
+    while (completions < expected && nowNs() < deadline) {
+        struct pollfd pfd = {fd, POLLIN, 0};
+        eventfd_t value;
+        if (poll(&pfd, 1, (int) ((deadline - nowNs()) / 1000000) + 1) == 1
+                && eventfd_read(fd, &value) == 0) {
+            completions += value;
+        }
+    }
+    return completions;
+}
+
+/** TEEC_CloseSession on a session with a pending operation, from a thread */
+struct BenchAsyncClose {
+    TEEC_Session    *session;
+    volatile bool   done;
+};
+
+static void *asyncCloseThread(void *arg)
+{
+    BenchAsyncClose *close = (BenchAsyncClose *) arg;
+
+    TEEC_CloseSession(close->session);
+    close->done = true;
+    return NULL;
+}
+
+/**
+ * Asynchronous GP commands and the completion fd. Times a timed command on
+ * BENCH_ASYNC_SESSIONS sessions issued one after the other against all of
+ * them in flight at once, reaped through TEEC_GetCompletionFd and
+ * TEEC_GetOperationResult. Then checks cancellation of a pending command, that
+ * TEEC_FinalizeContext fails pending commands and wakes a TEEC_CloseSession
+ * waiting for them, and that a callback may finalize its own context.
+ */
+static void benchAsync(int iterations)
+{
+    TEEC_Context context;
+    TEEC_Session sessions[BENCH_ASYNC_SESSIONS];
+    TEEC_Operation operations[BENCH_ASYNC_SESSIONS];
+    std::vector<uint64_t> syncNs, asyncNs;
+    uint32_t returnOrigin;
+    int completionFd = -1;
+    int opened = 0;
+
+    if (!openGpBenchSession(&context, &sessions[0])) {
+        return;
+    }
+    for (opened = 1; opened < BENCH_ASYNC_SESSIONS; opened++) {
+        TEEC_Result result = TEEC_OpenSession(&context, &sessions[opened], &benchGpTaUuid,
+                                              TEEC_LOGIN_PUBLIC, NULL, NULL, &returnOrigin);
+        if (result != TEEC_SUCCESS) {
+            fail("TEEC_OpenSession", result);
+            break;
+        }
+    }
+    TEEC_Result result = TEEC_GetCompletionFd(&context, &completionFd);
+    if (result != TEEC_SUCCESS) {
+        fail("TEEC_GetCompletionFd", result);
+    }
+
+    for (int i = 0; i < iterations && !benchFailed; i++) {
+        uint64_t start = nowNs();
+        for (int s = 0; s < BENCH_ASYNC_SESSIONS; s++) {
+            memset(&operations[s], 0, sizeof(operations[s]));
+            operations[s].paramTypes = TEEC_PARAM_TYPES(TEEC_VALUE_INPUT, TEEC_NONE,
+                                                        TEEC_NONE, TEEC_NONE);
+            operations[s].params[0].value.a = BENCH_ASYNC_SLEEP_US;
+            result = TEEC_InvokeCommand(&sessions[s], SIM_GP_CMD_SLEEP, &operations[s],
+                                        &returnOrigin);
+            if (result != TEEC_SUCCESS) {
+                fail("TEEC_InvokeCommand sleep", result);
+                break;
+            }
+        }
+        syncNs.push_back(nowNs() - start);
+
+        start = nowNs();
+        for (int s = 0; s < BENCH_ASYNC_SESSIONS && !benchFailed; s++) {
+            startAsyncSleep(&sessions[s], &operations[s], BENCH_ASYNC_SLEEP_US, NULL);
+        }
+        if (benchFailed) {
+            break;
+        }
+        uint64_t completions = readCompletions(completionFd, BENCH_ASYNC_SESSIONS,
+                                               BENCH_NOTIFY_WAIT);
+        asyncNs.push_back(nowNs() - start);
+        if (completions != BENCH_ASYNC_SESSIONS) {
+            fail("completion fd, completions", (uint32_t) completions);
+        }
+        for (int s = 0; s < BENCH_ASYNC_SESSIONS; s++) {
+            result = TEEC_GetOperationResult(&operations[s], &returnOrigin);
+            if (result != TEEC_SUCCESS || operations[s].params[1].value.a != BENCH_ASYNC_SLEEP_US
+                    || operations[s].params[1].value.b != ~(uint32_t) BENCH_ASYNC_SLEEP_US) {
+                fail("TEEC_GetOperationResult", result);
+            }
+        }
+    }
+    report("sleep x4 sync", syncNs);
+    report("sleep x4 async", asyncNs);
+
+    // A pending command reports busy until it is cancelled
+    if (!benchFailed && startAsyncSleep(&sessions[0], &operations[0], BENCH_ASYNC_LONG_US, NULL)) {
+        uint64_t start = nowNs();
+        result = TEEC_GetOperationResult(&operations[0], &returnOrigin);
+        if (result != TEEC_ERROR_BUSY) {
+            fail("TEEC_GetOperationResult pending", result);
+        }
+        TEEC_RequestCancellation(&operations[0]);
+        if (readCompletions(completionFd, 1, BENCH_NOTIFY_WAIT) != 1) {
+            fail("completion fd, cancelled completions", 0);
+        }
+        result = TEEC_GetOperationResult(&operations[0], &returnOrigin);
+        if (result != TEEC_ERROR_CANCEL || returnOrigin != TEEC_ORIGIN_TRUSTED_APP) {
+            fail("TEEC_RequestCancellation, result", result);
+        }
+        if (nowNs() - start >= BENCH_ASYNC_LONG_US * 1000ull) {
+            fail("TEEC_RequestCancellation, ms", (uint32_t) ((nowNs() - start) / 1000000));
+        }
+    }
+
+    // Finalizing fails the pending command and wakes the thread closing its
+    // session. The simulated secure world runs one TA at a time, so the other
+    // sessions are closed before.
+    BenchAsyncResult pending = {false, TEEC_SUCCESS, NULL, NULL};
+    BenchAsyncClose close = {&sessions[1], false};
+    pthread_t closer;
+    bool closing = false;
+    while (opened > 2) {
+        TEEC_CloseSession(&sessions[--opened]);
+    }
+    TEEC_CloseSession(&sessions[0]);
+    if (opened == 2 && !benchFailed
+            && startAsyncSleep(&sessions[1], &operations[1], BENCH_ASYNC_LONG_US, &pending)) {
+        closing = pthread_create(&closer, NULL, asyncCloseThread, &close) == 0;
+        usleep(10000);
+    }
+    if (opened == 2 && !closing) {
+        TEEC_CloseSession(&sessions[1]);
+    }
+    TEEC_FinalizeContext(&context);
+    if (closing) {
+        if (!waitFlag(&pending.done, BENCH_NOTIFY_WAIT) || pending.result != TEEC_ERROR_CANCEL) {
+            fail("TEEC_FinalizeContext, pending result", pending.result);
+        }
+        if (!waitFlag(&close.done, BENCH_NOTIFY_WAIT)) {
+            // Leave it hanging, the run has failed anyway
+            fail("TEEC_FinalizeContext, TEEC_CloseSession waiting", 0);
+        } else {
+            pthread_join(closer, NULL);
+        }
+    }
+    mcOpenDevice(MC_DEVICE_ID_DEFAULT);
+
+    // A callback finalizes its own context, with a command of another session pending
+    BenchAsyncResult first = {false, TEEC_SUCCESS, &sessions[0], &context};
+    BenchAsyncResult second = {false, TEEC_SUCCESS, NULL, NULL};
+    if (!benchFailed && openGpBenchSession(&context, &sessions[0])) {
+        result = TEEC_OpenSession(&context, &sessions[1], &benchGpTaUuid, TEEC_LOGIN_PUBLIC,
+                                  NULL, NULL, &returnOrigin);
+        if (result != TEEC_SUCCESS) {
+            fail("TEEC_OpenSession", result);
+            closeGpBenchSession(&context, &sessions[0]);
+            return;
+        }
+        if (!startAsyncSleep(&sessions[1], &operations[1], BENCH_ASYNC_LONG_US, &second)
+                || !startAsyncSleep(&sessions[0], &operations[0], BENCH_ASYNC_SLEEP_US, &first)) {
+            TEEC_CloseSession(&sessions[1]);
+            closeGpBenchSession(&context, &sessions[0]);
+            return;
+        }
+        if (!waitFlag(&first.done, BENCH_NOTIFY_WAIT) || first.result != TEEC_SUCCESS) {
+            fail("callback finalizing its context", first.result);
+            return;
+        }
+        if (!second.done || second.result != TEEC_ERROR_CANCEL) {
+            fail("callback finalizing its context, pending result", second.result);
+        }
+        // The context is gone, the session only has its state left
+        TEEC_CloseSession(&sessions[1]);
+        mcOpenDevice(MC_DEVICE_ID_DEFAULT);
+    }
+}
+
+
+//------------------------------------------------------------------------------
+static const struct {
+    const char *name;
+    void (*run)(int iterations);
+    int iterations;
+} benchmarks[] = {
+    {"roundtrips", benchRoundTrips, 500},
+    {"contention", benchContention, 200},
+    {"maps", benchMaps, 500},
+    {"notifyset", benchNotifySet, 200},
+    {"memrefs", benchMemrefs, 500},
+    {"arena", benchArena, 500},
+    {"async", benchAsync, 100},
+};
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: mcbench [-n iterations] [benchmark...]\nbenchmarks:");
+    for (size_t i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++) {
+        fprintf(stderr, " %s", benchmarks[i].name);
+    }
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char *argv[])
+{
+    int iterations = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        if (opt != 'n' || (iterations = atoi(optarg)) <= 0) {
+            usage();
+            return 2;
+        }
+    }
+
+    for (int arg = optind; arg < argc; arg++) {
+        size_t i = 0;
+        while (i < sizeof(benchmarks) / sizeof(benchmarks[0])
+                && strcmp(argv[arg], benchmarks[i].name) != 0) {
+            i++;
+        }
+        if (i == sizeof(benchmarks) / sizeof(benchmarks[0])) {
+            usage();
+            return 2;
+        }
+    }
+
+    if (!installBenchTa(&benchTaUuid, false) || !installBenchTa(&benchGpTaRegistryUuid, true)) {
+        return 1;
+    }
+    mcResult_t result = mcOpenDevice(MC_DEVICE_ID_DEFAULT);
+    if (result != MC_DRV_OK) {
+        fail("mcOpenDevice", result);
+        return 1;
+    }
+
+    for (size_t i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]) && !benchFailed; i++) {
+        bool selected = optind == argc;
+        for (int arg = optind; arg < argc; arg++) {
+            selected |= strcmp(argv[arg], benchmarks[i].name) == 0;
+        }
+        if (!selected) {
+            continue;
+        }
+        printf("== %s\n", benchmarks[i].name);
+        benchmarks[i].run(iterations > 0 ? iterations : benchmarks[i].iterations);
+    }
+
+    mcCloseDevice(MC_DEVICE_ID_DEFAULT);
+    return benchFailed ? 1 : 0;
+}
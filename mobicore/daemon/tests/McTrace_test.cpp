@@ -0,0 +1,260 @@
+/**
+ * @file
+ *
+ * Host tests for request tracing.
+ * 
+ * Tracing is switched on for the whole test binary through MC_TRACE_FILE. The
+ * tests read back what mcTraceFlush() appended to the file. RecordCost prints
+ * what recording and exporting an event costs.
+ *
+ * Copyright (c) 2013 TRUSTONIC LIMITED
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the TRUSTONIC LIMITED nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "McTrace.h"
+
+static std::string traceFile;
+
+static double nowUs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+//------------------------------------------------------------------------------
+class McTrace: public testing::Test
+{
+protected:
+    static void SetUpTestCase()
+    {
+        char path[] = "/tmp/mctrace.XXXXXX";
+        int fd = mkstemp(path);
+        ASSERT_GE(fd, 0);
+        close(fd);
+        traceFile = path;
+        // Read once, by the first trace call of the process
+        setenv(ENV_MC_TRACE_FILE, path, 1);
+        ASSERT_TRUE(mcTraceEnabled());
+    }
+
+    static void TearDownTestCase()
+    {
+        unlink(traceFile.c_str());
+    }
+
+    /** Flushes and returns the exported events of one request */
+    static std::vector<std::string> eventsOf(uint32_t traceId)
+    {
+        char key[32];
+        snprintf(key, sizeof(key), "\"traceId\":\"0x%08x\"", traceId);
+
+        mcTraceFlush();
+        std::ifstream file(traceFile.c_str());
+        std::vector<std::string> events;
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.find(key) != std::string::npos) {
+                events.push_back(line);
+            }
+        }
+        return events;
+    }
+
+    static std::string field(const std::string &event, const char *name)
+    {
+        std::string key = std::string("\"") + name + "\":";
+        size_t start = event.find(key);
+        if (start == std::string::npos) {
+            return "";
+        }
+        start += key.size();
+        size_t end = event.find_first_of(",}", start);
+        return event.substr(start, end - start);
+    }
+};
+
+/* IDs of different clients do not collide in a shared file */
+TEST_F(McTrace, NewIdsCarryThePid)
+{
+    uint32_t first = mcTraceNewId();
+    uint32_t second = mcTraceNewId();
+
+    EXPECT_NE(0u, first);
+    EXPECT_NE(first, second);
+    EXPECT_EQ((uint32_t) getpid() & 0xFFFF, first >> 16);
+    EXPECT_EQ((uint32_t) getpid() & 0xFFFF, second >> 16);
+}
+
+static void *readCurrentId(void *arg)
+{
+    *(uint32_t *) arg = mcTraceCurrentId();
+    return NULL;
+}
+
+TEST_F(McTrace, CurrentIdIsPerThread)
+{
+    uint32_t id = mcTraceNewId();
+    uint32_t other = 1;
+    pthread_t thread;
+
+    mcTraceSetCurrentId(id);
+    ASSERT_EQ(0, pthread_create(&thread, NULL, readCurrentId, &other));
+    pthread_join(thread, NULL);
+    EXPECT_EQ(id, mcTraceCurrentId());
+    EXPECT_EQ(0u, other);
+    mcTraceSetCurrentId(0);
+}
+
+/* Events come out as Chrome trace events in the order recorded */
+TEST_F(McTrace, FlushWritesChromeEvents)
+{
+    uint32_t id = mcTraceNewId();
+
+    mcTraceRecord(MC_TRACE_DAEMON_DEQUEUE, MC_TRACE_BEGIN, id, 7);
+    mcTraceRecord(MC_TRACE_SIQ, MC_TRACE_INSTANT, id, 0);
+    mcTraceRecord(MC_TRACE_DAEMON_DEQUEUE, MC_TRACE_END, id, 7);
+
+    std::vector<std::string> events = eventsOf(id);
+    ASSERT_EQ(3u, events.size());
+    EXPECT_EQ("\"daemon dequeue\"", field(events[0], "name"));
+    EXPECT_EQ("\"B\"", field(events[0], "ph"));
+    EXPECT_EQ("7", field(events[0], "arg"));
+    EXPECT_EQ("\"siq received\"", field(events[1], "name"));
+    EXPECT_EQ("\"t\"", field(events[1], "s"));
+    EXPECT_EQ("\"E\"", field(events[2], "ph"));
+    EXPECT_LE(strtod(field(events[0], "ts").c_str(), NULL),
+              strtod(field(events[2], "ts").c_str(), NULL));
+    char pid[16];
+    snprintf(pid, sizeof(pid), "%d", getpid());
+    EXPECT_EQ(pid, field(events[0], "pid"));
+
+    std::ifstream file(traceFile.c_str());
+    std::string first;
+    std::getline(file, first);
+    EXPECT_EQ("[", first);
+}
+
+/* Each flush leaves a closed array, a killed process leaves a valid file */
+TEST_F(McTrace, EveryFlushClosesTheArray)
+{
+    uint32_t id = mcTraceNewId();
+
+    for (int flush = 0; flush < 3; flush++) {
+        mcTraceRecord(MC_TRACE_CLIENT_SEND, MC_TRACE_INSTANT, id, flush);
+        mcTraceRecord(MC_TRACE_CLIENT_WAKE, MC_TRACE_INSTANT, id, flush);
+        ASSERT_EQ(2u * (flush + 1), eventsOf(id).size());
+
+        std::ifstream file(traceFile.c_str());
+        std::vector<std::string> lines;
+        std::string line;
+        while (std::getline(file, line)) {
+            lines.push_back(line);
+        }
+        ASSERT_LE(3u, lines.size());
+        EXPECT_EQ("[", lines.front());
+        EXPECT_EQ("]", lines.back());
+        // Events are separated by commas, the last one is not followed by one
+        for (size_t i = 1; i + 1 < lines.size(); i++) {
+            ASSERT_EQ('{', lines[i][0]) << lines[i];
+            EXPECT_EQ(i + 2 < lines.size() ? "}}," : "}}",
+                      lines[i].substr(lines[i].rfind('}') - 1)) << lines[i];
+        }
+    }
+}
+
+static void *recordEvents(void *arg)
+{
+    uint32_t id = *(uint32_t *) arg;
+    for (int i = 0; i < 100; i++) {
+        mcTraceRecord(MC_TRACE_CLIENT_SEND, MC_TRACE_INSTANT, id, i);
+    }
+    return NULL;
+}
+
+/* Terminated threads hand their ring on, their events are exported with
+ * their own thread ID */
+TEST_F(McTrace, RingsOutliveTheirThreads)
+{
+    uint32_t id = mcTraceNewId();
+
+    for (int round = 0; round < 2; round++) {
+        pthread_t threads[4];
+        for (int i = 0; i < 4; i++) {
+            ASSERT_EQ(0, pthread_create(&threads[i], NULL, recordEvents, &id));
+        }
+        for (int i = 0; i < 4; i++) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+
+    std::vector<std::string> events = eventsOf(id);
+    EXPECT_EQ(800u, events.size());
+    std::set<std::string> tids;
+    for (size_t i = 0; i < events.size(); i++) {
+        tids.insert(field(events[i], "tid"));
+    }
+    EXPECT_EQ(8u, tids.size());
+}
+
+TEST_F(McTrace, RecordCost)
+{
+    const int events = 1000000, exported = 4000;
+    uint32_t id = mcTraceNewId();
+
+    // Overruns the ring on purpose, recording never waits for the exporter
+    mcTraceFlush();
+    double start = nowUs();
+    for (int i = 0; i < events; i++) {
+        mcTraceRecord(MC_TRACE_CLIENT_SEND, MC_TRACE_INSTANT, id, i);
+    }
+    double recorded = nowUs();
+    printf("record: %6.1f ns/event\n", (recorded - start) * 1e3 / events);
+
+    // Less than a ring, so the background exporter may have taken some
+    mcTraceFlush();
+    for (int i = 0; i < exported; i++) {
+        mcTraceRecord(MC_TRACE_CLIENT_SEND, MC_TRACE_INSTANT, id, i);
+    }
+    start = nowUs();
+    mcTraceFlush();
+    printf("export: %6.2f us/event at most\n", (nowUs() - start) / exported);
+}
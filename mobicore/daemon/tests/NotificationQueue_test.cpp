@@ -0,0 +1,322 @@
+/**
+ * @file
+ *
+ * Host stress test for the notification queues.
+ * 
+ * A thread plays the secure world on the other end of each ring: it
+ * produces into the incoming queue and consumes the outgoing one, with the
+ * same counter protocol as the MCI. Every element carries a sequence number
+ * that is checked on the far side.
+ *
+ * Copyright (c) 2013 TRUSTONIC LIMITED
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the TRUSTONIC LIMITED nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "NotificationQueue.h"
+
+#define TEST_QUEUE_SIZE     16
+#define TEST_PRODUCERS      4
+
+/** Queue header followed by its elements, as laid out in the MCI buffer */
+struct TestQueue {
+    notificationQueueHeader_t hdr;
+    notification_t notification[TEST_QUEUE_SIZE];
+};
+
+static double nowSec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+//------------------------------------------------------------------------------
+class NotificationQueueStress: public testing::Test
+{
+protected:
+    TestQueue queueIn;
+    TestQueue queueOut;
+    NotificationQueue *nq;
+    uint32_t total;
+
+    /** Elements with a bad sequence number, counted by the secure world side */
+    volatile uint32_t swdErrors;
+
+    virtual void SetUp()
+    {
+        memset(&queueIn, 0, sizeof(queueIn));
+        memset(&queueOut, 0, sizeof(queueOut));
+        nq = NULL;
+        swdErrors = 0;
+    }
+
+    virtual void TearDown()
+    {
+        delete nq;
+    }
+
+    /** Start both rings at the given counter value */
+    void createQueue(uint32_t counter)
+    {
+        queueIn.hdr.writeCnt = queueIn.hdr.readCnt = counter;
+        queueOut.hdr.writeCnt = queueOut.hdr.readCnt = counter;
+        nq = new NotificationQueue((notificationQueue_t *) &queueIn,
+                                   (notificationQueue_t *) &queueOut,
+                                   TEST_QUEUE_SIZE);
+    }
+
+    /** Secure world producing total elements into the incoming queue */
+    static void *swdProducer(void *arg)
+    {
+        NotificationQueueStress *test = (NotificationQueueStress *) arg;
+        TestQueue *q = &test->queueIn;
+
+        for (uint32_t seq = 0; seq < test->total;) {
+            uint32_t writeCnt = q->hdr.writeCnt;
+            uint32_t readCnt = __atomic_load_n(&q->hdr.readCnt, __ATOMIC_ACQUIRE);
+            if (writeCnt - readCnt >= TEST_QUEUE_SIZE) {
+                sched_yield();
+                continue;
+            }
+            notification_t *slot = &q->notification[writeCnt & (TEST_QUEUE_SIZE - 1)];
+            slot->sessionId = seq;
+            slot->payload = ~(int32_t) seq;
+            __atomic_store_n(&q->hdr.writeCnt, writeCnt + 1, __ATOMIC_RELEASE);
+            seq++;
+        }
+        return NULL;
+    }
+
+    /** Secure world consuming the outgoing queue, sessionId is the producer
+     * and payload its sequence number */
+    static void *swdConsumer(void *arg)
+    {
+        NotificationQueueStress *test = (NotificationQueueStress *) arg;
+        TestQueue *q = &test->queueOut;
+        std::vector<uint32_t> expected(TEST_PRODUCERS, 0);
+
+        for (uint32_t received = 0; received < test->total * TEST_PRODUCERS;) {
+            uint32_t readCnt = q->hdr.readCnt;
+            uint32_t writeCnt = __atomic_load_n(&q->hdr.writeCnt, __ATOMIC_ACQUIRE);
+            if (readCnt == writeCnt) {
+                sched_yield();
+                continue;
+            }
+            notification_t n = q->notification[readCnt & (TEST_QUEUE_SIZE - 1)];
+            __atomic_store_n(&q->hdr.readCnt, readCnt + 1, __ATOMIC_RELEASE);
+            received++;
+
+            if (n.sessionId >= TEST_PRODUCERS
+                    || (uint32_t) n.payload != expected[n.sessionId]) {
+                test->swdErrors++;
+                continue;
+            }
+            expected[n.sessionId]++;
+        }
+        return NULL;
+    }
+
+    struct Producer {
+        NotificationQueueStress *test;
+        uint32_t id;
+    };
+
+    static void *nwdProducer(void *arg)
+    {
+        Producer *producer = (Producer *) arg;
+        notification_t n;
+        n.sessionId = producer->id;
+
+        for (uint32_t seq = 0; seq < producer->test->total;) {
+            n.payload = (int32_t) seq;
+            if (producer->test->nq->putNotification(&n)) {
+                seq++;
+            } else {
+                sched_yield();
+            }
+        }
+        return NULL;
+    }
+
+    /** Drain the incoming queue, batch is the largest batch to ask for */
+    void consume(uint32_t batch, const char *name)
+    {
+        pthread_t swd;
+        notification_t buf[TEST_QUEUE_SIZE];
+        uint32_t received = 0, errors = 0;
+
+        double start = nowSec();
+        ASSERT_EQ(0, pthread_create(&swd, NULL, swdProducer, this));
+        while (received < total) {
+            uint32_t count = batch == 1 ? nq->getNotification(buf)
+                             : nq->getNotifications(buf, batch);
+            if (count == 0) {
+                sched_yield();
+            }
+            for (uint32_t i = 0; i < count; i++, received++) {
+                if (buf[i].sessionId != received
+                        || buf[i].payload != ~(int32_t) received) {
+                    errors++;
+                }
+            }
+        }
+        pthread_join(swd, NULL);
+        double elapsed = nowSec() - start;
+
+        EXPECT_EQ(0u, errors);
+        EXPECT_EQ(queueIn.hdr.writeCnt, queueIn.hdr.readCnt);
+        printf("%s: %u notifications, %.1f M/s\n", name, total, total / elapsed / 1e6);
+    }
+};
+
+TEST_F(NotificationQueueStress, SingleGetsSeeEveryElementInOrder)
+{
+    createQueue(0);
+    total = 1000000;
+    consume(1, "single get");
+}
+
+TEST_F(NotificationQueueStress, BatchGetsSeeEveryElementInOrder)
+{
+    createQueue(0);
+    total = 1000000;
+    consume(TEST_QUEUE_SIZE, "batch get");
+}
+
+/* Batches smaller than the queue leave elements behind for the next call */
+TEST_F(NotificationQueueStress, PartialBatchesSeeEveryElementInOrder)
+{
+    createQueue(0);
+    total = 200000;
+    consume(3, "batch of 3");
+}
+
+/* The counters are free running and wrap at 2^32 */
+TEST_F(NotificationQueueStress, CountersWrapAround)
+{
+    createQueue(0xFFFFFF00);
+    total = 100000;
+    consume(TEST_QUEUE_SIZE, "wrapping batch get");
+
+    total = 1000;
+    swdErrors = 0;
+    pthread_t swd;
+    Producer producer[TEST_PRODUCERS];
+    pthread_t producers[TEST_PRODUCERS];
+    ASSERT_EQ(0, pthread_create(&swd, NULL, swdConsumer, this));
+    for (uint32_t i = 0; i < TEST_PRODUCERS; i++) {
+        producer[i].test = this;
+        producer[i].id = i;
+        ASSERT_EQ(0, pthread_create(&producers[i], NULL, nwdProducer, &producer[i]));
+    }
+    for (uint32_t i = 0; i < TEST_PRODUCERS; i++) {
+        pthread_join(producers[i], NULL);
+    }
+    pthread_join(swd, NULL);
+    EXPECT_EQ(0u, swdErrors);
+}
+
+/* Producers on several daemon threads, each one's elements stay in order */
+TEST_F(NotificationQueueStress, ProducersKeepTheirOrder)
+{
+    createQueue(0);
+    total = 250000;
+
+    pthread_t swd;
+    Producer producer[TEST_PRODUCERS];
+    pthread_t producers[TEST_PRODUCERS];
+
+    double start = nowSec();
+    ASSERT_EQ(0, pthread_create(&swd, NULL, swdConsumer, this));
+    for (uint32_t i = 0; i < TEST_PRODUCERS; i++) {
+        producer[i].test = this;
+        producer[i].id = i;
+        ASSERT_EQ(0, pthread_create(&producers[i], NULL, nwdProducer, &producer[i]));
+    }
+    for (uint32_t i = 0; i < TEST_PRODUCERS; i++) {
+        pthread_join(producers[i], NULL);
+    }
+    pthread_join(swd, NULL);
+    double elapsed = nowSec() - start;
+
+    EXPECT_EQ(0u, swdErrors);
+    EXPECT_EQ(queueOut.hdr.writeCnt, queueOut.hdr.readCnt);
+    printf("%d producers: %u notifications, %.1f M/s\n", TEST_PRODUCERS,
+           total * TEST_PRODUCERS, total * TEST_PRODUCERS / elapsed / 1e6);
+}
+
+TEST_F(NotificationQueueStress, FullAndEmptyQueues)
+{
+    createQueue(0);
+    notification_t n = {1, 2};
+    notification_t buf[TEST_QUEUE_SIZE];
+
+    for (int i = 0; i < TEST_QUEUE_SIZE; i++) {
+        EXPECT_TRUE(nq->putNotification(&n));
+    }
+    EXPECT_FALSE(nq->putNotification(&n));
+
+    EXPECT_FALSE(nq->getNotification(buf));
+    EXPECT_EQ(0u, nq->getNotifications(buf, TEST_QUEUE_SIZE));
+}
+
+/* Consumer cost without a peer thread: fill the ring, then drain it with
+ * single and with batch gets */
+TEST_F(NotificationQueueStress, ConsumerCost)
+{
+    const uint32_t rounds = 100000;
+    const uint32_t batches[] = {1, TEST_QUEUE_SIZE};
+    notification_t buf[TEST_QUEUE_SIZE];
+
+    createQueue(0);
+    for (size_t b = 0; b < sizeof(batches) / sizeof(batches[0]); b++) {
+        double start = nowSec();
+        for (uint32_t round = 0; round < rounds; round++) {
+            queueIn.hdr.writeCnt += TEST_QUEUE_SIZE;
+            for (uint32_t drained = 0; drained < TEST_QUEUE_SIZE;) {
+                uint32_t count = batches[b] == 1 ? nq->getNotification(buf)
+                                 : nq->getNotifications(buf, batches[b]);
+                ASSERT_NE(0u, count);
+                drained += count;
+            }
+        }
+        double elapsed = nowSec() - start;
+
+        EXPECT_EQ(queueIn.hdr.writeCnt, queueIn.hdr.readCnt);
+        printf("fill/drain, batch of %u: %.0f M notifications/s\n", batches[b],
+               rounds * TEST_QUEUE_SIZE / elapsed / 1e6);
+    }
+}
@@ -0,0 +1,310 @@
+/**
+ * @file
+ *
+ * Host tests for the service blob cache of the private registry.
+ * 
+ * Builds a registry with a GP TA owned by a service provider in a scratch
+ * MC_REGISTRY_PATH and checks when registry objects are shared, rebuilt
+ * and evicted. OpenCost prints the cost of a cached against an uncached open.
+ *
+ * Copyright (c) 2013 TRUSTONIC LIMITED
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the TRUSTONIC LIMITED nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "PrivateRegistry.h"
+#include "mcLoadFormat.h"
+#include "mcVersionHelper.h"
+
+#define TEST_SPID   7
+
+static std::string registryDir;
+
+static double nowSec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* File names as the registry spells them: UUID bytes in memory order, SPID
+ * as reversed upper case hex */
+static std::string uuidString(const mcUuid_t *uuid)
+{
+    std::string hex;
+    for (size_t i = 0; i < sizeof(uuid->value); i++) {
+        char byte[3];
+        snprintf(byte, sizeof(byte), "%02x", uuid->value[i]);
+        hex += byte;
+    }
+    return hex;
+}
+
+static std::string spidString(mcSpid_t spid)
+{
+    char hex[9];
+    snprintf(hex, sizeof(hex), "%08X", spid);
+    std::string str(hex);
+    return std::string(str.rbegin(), str.rend());
+}
+
+static std::string tlContainerName(const mcUuid_t *uuid)
+{
+    return uuidString(uuid) + "." + spidString(TEST_SPID) + ".tlcont";
+}
+
+static void writeFile(const std::string &name, const void *data, size_t len)
+{
+    std::string path = registryDir + "/" + name;
+    FILE *file = fopen(path.c_str(), "wb");
+    ASSERT_TRUE(file != NULL) << path;
+    ASSERT_EQ(len, fwrite(data, 1, len, file));
+    fclose(file);
+}
+
+//------------------------------------------------------------------------------
+class RegistryBlobCache: public testing::Test
+{
+protected:
+    static void SetUpTestCase()
+    {
+        char dir[] = "/tmp/mcregistry.XXXXXX";
+        ASSERT_TRUE(mkdtemp(dir) != NULL);
+        registryDir = dir;
+        setenv("MC_REGISTRY_PATH", dir, 1);
+        setenv("MC_AUTH_TOKEN_PATH", dir, 1);
+    }
+
+    static void TearDownTestCase()
+    {
+        std::string cmd = "rm -rf " + registryDir;
+        if (system(cmd.c_str()) != 0) {
+            fprintf(stderr, "cannot remove %s\n", registryDir.c_str());
+        }
+    }
+
+    virtual void SetUp()
+    {
+        uint8_t container[sizeof(mcSoTltCont_2_1_t)];
+        memset(container, 0, sizeof(container));
+        writeFile("00000000.rootcont", container, sizeof(mcSoRootCont_t));
+        writeFile(spidString(TEST_SPID) + ".spcont", container, sizeof(mcSoSpCont_t));
+        nextUuid = 1;
+    }
+
+    uint8_t nextUuid;
+
+    /** Installs a GP TA of the given size with its TL container, the first
+     * payload byte after the header is set to generation */
+    mcUuid_t installTa(size_t size, uint8_t generation)
+    {
+        mcUuid_t uuid;
+        memset(&uuid, 0, sizeof(uuid));
+        uuid.value[0] = 0x7a;
+        uuid.value[15] = nextUuid++;
+        rewriteTa(&uuid, size, generation);
+        writeTlContainer(&uuid);
+
+        mcSpid_t spid = TEST_SPID;
+        writeFile(uuidString(&uuid) + ".spid", &spid, sizeof(spid));
+        return uuid;
+    }
+
+    void rewriteTa(const mcUuid_t *uuid, size_t size, uint8_t generation)
+    {
+        std::vector<uint8_t> blob(size, 0);
+        mclfHeaderV2_t *header = (mclfHeaderV2_t *) &blob[0];
+        header->intro.magic = MC_SERVICE_HEADER_MAGIC_BE;
+        header->intro.version = MC_MAKE_VERSION(2, 4);
+        header->serviceType = SERVICE_TYPE_SP_TRUSTLET;
+        memcpy(&header->uuid, uuid, sizeof(*uuid));
+        blob[sizeof(mclfHeaderV24_t)] = generation;
+        writeFile(uuidString(uuid) + ".tabin", &blob[0], blob.size());
+    }
+
+    void writeTlContainer(const mcUuid_t *uuid)
+    {
+        uint8_t container[sizeof(mcSoTltCont_2_1_t)];
+        memset(container, 0, sizeof(container));
+        writeFile(tlContainerName(uuid), container, sizeof(container));
+    }
+
+    /** Generation byte of the TA inside a registry object */
+    static uint8_t generation(regObject_t *regobj)
+    {
+        return regobj->value[regobj->tlStartOffset + sizeof(mclfHeaderV24_t)];
+    }
+
+    static regCacheStats_t stats(void)
+    {
+        regCacheStats_t s;
+        mcRegistryGetServiceBlobCacheStats(&s);
+        return s;
+    }
+};
+
+TEST_F(RegistryBlobCache, RepeatOpenSharesTheObject)
+{
+    mcUuid_t uuid = installTa(65536, 1);
+    regCacheStats_t before = stats();
+
+    regObject_t *first = mcRegistryGetServiceBlob(&uuid, true);
+    ASSERT_TRUE(first != NULL);
+    regObject_t *second = mcRegistryGetServiceBlob(&uuid, true);
+    EXPECT_EQ(first, second);
+
+    regCacheStats_t after = stats();
+    EXPECT_EQ(before.misses + 1, after.misses);
+    EXPECT_EQ(before.hits + 1, after.hits);
+    EXPECT_EQ(before.bytesSaved + second->len, after.bytesSaved);
+
+    mcRegistryReleaseServiceBlob(second);
+    mcRegistryReleaseServiceBlob(first);
+}
+
+/* A changed container rebuilds the object, the old one stays usable until
+ * its user releases it */
+TEST_F(RegistryBlobCache, ChangedContainerRebuilds)
+{
+    mcUuid_t uuid = installTa(65536, 1);
+    regObject_t *old = mcRegistryGetServiceBlob(&uuid, true);
+    ASSERT_TRUE(old != NULL);
+    regCacheStats_t before = stats();
+
+    // Replace the file, so the inode changes even within the mtime granularity
+    ASSERT_EQ(0, unlink((registryDir + "/" + tlContainerName(&uuid)).c_str()));
+    writeTlContainer(&uuid);
+
+    regObject_t *fresh = mcRegistryGetServiceBlob(&uuid, true);
+    ASSERT_TRUE(fresh != NULL);
+    EXPECT_NE(old, fresh);
+    EXPECT_EQ(before.invalidations + 1, stats().invalidations);
+    EXPECT_EQ(1, generation(old));
+
+    mcRegistryReleaseServiceBlob(old);
+    mcRegistryReleaseServiceBlob(fresh);
+}
+
+TEST_F(RegistryBlobCache, ChangedBlobRebuilds)
+{
+    mcUuid_t uuid = installTa(65536, 1);
+    regObject_t *old = mcRegistryGetServiceBlob(&uuid, true);
+    ASSERT_TRUE(old != NULL);
+    mcRegistryReleaseServiceBlob(old);
+
+    // Same size, only the content and the stamp differ
+    ASSERT_EQ(0, unlink((registryDir + "/" + uuidString(&uuid) + ".tabin").c_str()));
+    rewriteTa(&uuid, 65536, 2);
+
+    regObject_t *fresh = mcRegistryGetServiceBlob(&uuid, true);
+    ASSERT_TRUE(fresh != NULL);
+    EXPECT_EQ(2, generation(fresh));
+    mcRegistryReleaseServiceBlob(fresh);
+}
+
+/* Writes through the registry API drop the cache, whatever the stamps say */
+TEST_F(RegistryBlobCache, RegistryStoreRebuilds)
+{
+    mcUuid_t uuid = installTa(65536, 1);
+    regObject_t *regobj = mcRegistryGetServiceBlob(&uuid, true);
+    ASSERT_TRUE(regobj != NULL);
+    mcRegistryReleaseServiceBlob(regobj);
+
+    uint8_t container[sizeof(mcSoTltCont_2_1_t)];
+    memset(container, 0, sizeof(container));
+    ASSERT_EQ(MC_DRV_OK, mcRegistryStoreTrustletCon(&uuid, TEST_SPID, container,
+                                                    sizeof(container)));
+
+    regCacheStats_t before = stats();
+    regobj = mcRegistryGetServiceBlob(&uuid, true);
+    ASSERT_TRUE(regobj != NULL);
+    EXPECT_EQ(before.misses + 1, stats().misses);
+    mcRegistryReleaseServiceBlob(regobj);
+}
+
+/* Released objects are evicted beyond 4 MiB, objects in use never are */
+TEST_F(RegistryBlobCache, EvictsReleasedObjectsOnly)
+{
+    const size_t taSize = 1024 * 1024;
+    std::vector<regObject_t *> held;
+
+    for (int i = 0; i < 6; i++) {
+        mcUuid_t uuid = installTa(taSize, i);
+        regObject_t *regobj = mcRegistryGetServiceBlob(&uuid, true);
+        ASSERT_TRUE(regobj != NULL);
+        held.push_back(regobj);
+    }
+    EXPECT_GE(stats().bytesCached, 6 * taSize);
+    for (size_t i = 0; i < held.size(); i++) {
+        EXPECT_EQ(i, generation(held[i]));
+    }
+
+    for (size_t i = 0; i < held.size(); i++) {
+        mcRegistryReleaseServiceBlob(held[i]);
+    }
+    EXPECT_LE(stats().bytesCached, 4u * 1024 * 1024);
+}
+
+/* Cost of an open, cached and with the blob touched before every open */
+TEST_F(RegistryBlobCache, OpenCost)
+{
+    const size_t sizes[] = {64 * 1024, 1024 * 1024};
+    const int opens = 200;
+
+    for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        mcUuid_t uuid = installTa(sizes[k], 0);
+        std::string path = registryDir + "/" + uuidString(&uuid) + ".tabin";
+        double elapsed[2];
+
+        for (int cached = 0; cached < 2; cached++) {
+            double start = nowSec();
+            for (int i = 0; i < opens; i++) {
+                if (!cached) {
+                    struct timespec times[2] = {{0, UTIME_OMIT}, {i, 0}};
+                    ASSERT_EQ(0, utimensat(AT_FDCWD, path.c_str(), times, 0));
+                }
+                regObject_t *regobj = mcRegistryGetServiceBlob(&uuid, true);
+                ASSERT_TRUE(regobj != NULL);
+                mcRegistryReleaseServiceBlob(regobj);
+            }
+            elapsed[cached] = nowSec() - start;
+        }
+        printf("%7zu byte TA: uncached %6.1f us, cached %6.1f us per open\n", sizes[k],
+               elapsed[0] / opens * 1e6, elapsed[1] / opens * 1e6);
+    }
+}
@@ -0,0 +1,301 @@
+/**
+ * @file
+ *
+ * Host tests for the adaptive SWd scheduler.
+ * 
+ * The AdaptiveScheduler tests feed it scripted yield times. ScheduleCost runs
+ * TrustZoneDevice::schedule() against a kernel module whose fcYield() plays a
+ * busy, a sparse and an idle SWd and prints what the scheduler thread costs in
+ * each phase.
+ *
+ * Copyright (c) 2013 TRUSTONIC LIMITED
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the TRUSTONIC LIMITED nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <gtest/gtest.h>
+
+#include "TrustZoneDevice.h"
+#include "AdaptiveScheduler.h"
+
+#define PHASE_US            500000  /**< Length of a ScheduleCost phase */
+#define SWD_WORK_US         100     /**< SWd work per yield while busy */
+#define SMC_US              2       /**< Round trip of a fast call */
+#define SPARSE_EVENT_US     3000    /**< Un-signalled SWd work while sparse */
+
+static uint64_t nowUs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void spinUs(uint64_t us)
+{
+    uint64_t end = nowUs() + us;
+    while (nowUs() < end);
+}
+
+//------------------------------------------------------------------------------
+/** Runs a slice of yields of the given length, returns the timeslice the
+ * scheduler picked for the next one */
+static uint32_t runSlice(AdaptiveScheduler &scheduler, uint64_t yieldUs)
+{
+    schedulerStats_t stats;
+
+    while (!scheduler.nsiqDue()) {
+        scheduler.yielded(yieldUs);
+    }
+    scheduler.nsiqSent();
+    scheduler.closeInterval(0, 0, &stats);
+    return stats.timeslice;
+}
+
+TEST(AdaptiveScheduler, BusySlicesGrow)
+{
+    AdaptiveScheduler scheduler(NULL, 0);
+
+    EXPECT_EQ(2u * SCHED_TIMESLICE, runSlice(scheduler, SWD_WORK_US));
+    EXPECT_EQ(4u * SCHED_TIMESLICE, runSlice(scheduler, SWD_WORK_US));
+    EXPECT_EQ((uint32_t) SCHED_MAX_TIMESLICE, runSlice(scheduler, SWD_WORK_US));
+    EXPECT_EQ((uint32_t) SCHED_MAX_TIMESLICE, runSlice(scheduler, SWD_WORK_US));
+    EXPECT_EQ(0u, scheduler.getBackoff());
+}
+
+TEST(AdaptiveScheduler, EmptySlicesBackOff)
+{
+    AdaptiveScheduler scheduler(NULL, 0);
+
+    EXPECT_EQ((uint32_t) SCHED_TIMESLICE / 2, runSlice(scheduler, SMC_US));
+    EXPECT_EQ((uint32_t) SCHED_MIN_BACKOFF_US, scheduler.getBackoff());
+    // One pause per yield
+    scheduler.backedOff(SCHED_MIN_BACKOFF_US);
+    EXPECT_EQ(0u, scheduler.getBackoff());
+    scheduler.yielded(SMC_US);
+    EXPECT_EQ((uint32_t) SCHED_MIN_BACKOFF_US, scheduler.getBackoff());
+
+    EXPECT_EQ((uint32_t) SCHED_MIN_TIMESLICE, runSlice(scheduler, SMC_US));
+    EXPECT_EQ(2u * SCHED_MIN_BACKOFF_US, scheduler.getBackoff());
+    for (int i = 0; i < 8; i++) {
+        runSlice(scheduler, SMC_US);
+    }
+    EXPECT_EQ((uint32_t) SCHED_MAX_BACKOFF_US, scheduler.getBackoff());
+}
+
+TEST(AdaptiveScheduler, WorkEndsTheBackoff)
+{
+    AdaptiveScheduler scheduler(NULL, 0);
+
+    runSlice(scheduler, SMC_US);
+    ASSERT_NE(0u, scheduler.getBackoff());
+    scheduler.yielded(SWD_WORK_US);
+    EXPECT_EQ(0u, scheduler.getBackoff());
+
+    runSlice(scheduler, SMC_US);
+    runSlice(scheduler, SMC_US);
+    ASSERT_NE(0u, scheduler.getBackoff());
+    scheduler.idleWaited(1000);
+    EXPECT_EQ(0u, scheduler.getBackoff());
+}
+
+TEST(AdaptiveScheduler, IntervalStats)
+{
+    AdaptiveScheduler scheduler(NULL, 1000);
+    schedulerStats_t stats;
+
+    scheduler.idleWaited(300);
+    scheduler.yielded(SWD_WORK_US);
+    scheduler.yielded(SMC_US);
+    scheduler.backedOff(40);
+    EXPECT_FALSE(scheduler.intervalElapsed(1000 + SCHED_STATS_INTERVAL_US - 1));
+    EXPECT_TRUE(scheduler.intervalElapsed(1000 + SCHED_STATS_INTERVAL_US));
+
+    scheduler.closeInterval(1000 + SCHED_STATS_INTERVAL_US, 700, &stats);
+    EXPECT_EQ(2u, stats.yields);
+    EXPECT_EQ(1u, stats.busyYields);
+    EXPECT_EQ(1u, stats.idleWaits);
+    EXPECT_EQ(1u, stats.backoffs);
+    EXPECT_EQ((uint64_t) SWD_WORK_US + SMC_US, stats.swdUs);
+    EXPECT_EQ(300u, stats.idleUs);
+    EXPECT_EQ(40u, stats.backoffUs);
+    EXPECT_EQ(700u, stats.cpuUs);
+    EXPECT_EQ((uint64_t) SCHED_STATS_INTERVAL_US, stats.intervalUs);
+
+    scheduler.closeInterval(2000 + SCHED_STATS_INTERVAL_US, 750, &stats);
+    EXPECT_EQ(0u, stats.yields);
+    EXPECT_EQ(50u, stats.cpuUs);
+}
+
+//------------------------------------------------------------------------------
+enum swdPhase_t {
+    SWD_BUSY,       /**< Every yield finds work */
+    SWD_SPARSE,     /**< Not IDLE, but yields come back at once */
+    SWD_IDLE,       /**< The SWd sets itself IDLE on the next yield */
+    SWD_GONE        /**< Fast calls fail, which ends schedule() */
+};
+
+/** Kernel module playing a SWd. In the sparse phase the test makes a piece
+ * of work show up without a SIQ, the next yield picks it up. */
+class ScriptedKMod: public CMcKMod
+{
+public:
+    volatile swdPhase_t phase;
+    volatile uint32_t yields;
+    volatile uint32_t nsiqs;
+    volatile uint64_t eventAtUs;
+    volatile uint64_t eventLatencyUs;
+    volatile uint32_t events;
+
+    explicit ScriptedKMod(mcFlags_t *flags) : phase(SWD_IDLE), yields(0),
+        nsiqs(0), eventAtUs(0), eventLatencyUs(0), events(0), flags(flags) {}
+
+    virtual int fcYield(void)
+    {
+        if (phase == SWD_GONE) {
+            return -1;
+        }
+        yields++;
+        spinUs(SMC_US);
+        if (eventAtUs != 0) {
+            eventLatencyUs += nowUs() - eventAtUs;
+            events++;
+            eventAtUs = 0;
+        }
+        if (phase == SWD_BUSY) {
+            usleep(SWD_WORK_US);
+        } else if (phase == SWD_IDLE) {
+            flags->schedule = MC_FLAG_SCHEDULE_IDLE;
+        }
+        return 0;
+    }
+
+    virtual int fcNSIQ(void)
+    {
+        if (phase == SWD_GONE) {
+            return -1;
+        }
+        nsiqs++;
+        spinUs(SMC_US);
+        return 0;
+    }
+
+private:
+    mcFlags_t *flags;
+};
+
+class SchedulingDevice: public TrustZoneDevice
+{
+public:
+    mcFlags_t flags;
+
+    SchedulingDevice()
+    {
+        memset(&flags, 0, sizeof(flags));
+        flags.schedule = MC_FLAG_SCHEDULE_IDLE;
+        mcFlags = &flags;
+        schedulerEnabled = true;
+        kmod = new ScriptedKMod(&flags);
+        pMcKMod = kmod;
+    }
+
+    /** Puts the SWd in a phase, leaving IDLE comes with an S-SIQ */
+    void enter(swdPhase_t phase)
+    {
+        kmod->phase = phase;
+        if (phase != SWD_IDLE) {
+            flags.schedule = MC_FLAG_SCHEDULE_NON_IDLE;
+            schedSync.signal();
+        }
+    }
+
+    ScriptedKMod *kmod;
+};
+
+static void *scheduleThread(void *arg)
+{
+    ((SchedulingDevice *) arg)->schedule();
+    return NULL;
+}
+
+TEST(Scheduler, ScheduleCost)
+{
+    static const struct {
+        const char *name;
+        swdPhase_t phase;
+    } phases[] = {
+        {"busy", SWD_BUSY},
+        {"sparse", SWD_SPARSE},
+        {"idle", SWD_IDLE},
+    };
+    SchedulingDevice device;
+    ScriptedKMod *kmod = device.kmod;
+    pthread_t thread;
+    clockid_t cpuClock;
+
+    ASSERT_EQ(0, pthread_create(&thread, NULL, scheduleThread, &device));
+    ASSERT_EQ(0, pthread_getcpuclockid(thread, &cpuClock));
+
+    for (size_t i = 0; i < sizeof(phases) / sizeof(phases[0]); i++) {
+        struct timespec cpuStart, cpuEnd;
+        uint32_t yields = kmod->yields;
+        uint32_t nsiqs = kmod->nsiqs;
+
+        kmod->eventAtUs = 0;
+        kmod->eventLatencyUs = 0;
+        kmod->events = 0;
+        clock_gettime(cpuClock, &cpuStart);
+        device.enter(phases[i].phase);
+        uint64_t end = nowUs() + PHASE_US;
+        while (nowUs() < end) {
+            usleep(SPARSE_EVENT_US);
+            if ((phases[i].phase == SWD_SPARSE) && (kmod->eventAtUs == 0)) {
+                kmod->eventAtUs = nowUs();
+            }
+        }
+        clock_gettime(cpuClock, &cpuEnd);
+        double cpuMs = (cpuEnd.tv_sec - cpuStart.tv_sec) * 1e3
+                       + (cpuEnd.tv_nsec - cpuStart.tv_nsec) / 1e6;
+
+        printf("%-6s %4.0fms: %7u yields, %6u N-SIQs, %6.1fms CPU",
+               phases[i].name, PHASE_US / 1e3, kmod->yields - yields,
+               kmod->nsiqs - nsiqs, cpuMs);
+        if (kmod->events > 0) {
+            printf(", un-signalled work waits %uus",
+                   (uint32_t) (kmod->eventLatencyUs / kmod->events));
+        }
+        printf("\n");
+    }
+
+    // A failing fast call ends the loop
+    device.enter(SWD_GONE);
+    ASSERT_EQ(0, pthread_join(thread, NULL));
+}
@@ -0,0 +1,236 @@
+/**
+ * @file
+ *
+ * Host tests for the daemon socket server.
+ * 
+ * An echo handler sits behind Server and load clients drive it over local
+ * sockets. The load test prints throughput and latency percentiles for 10,
+ * 100 and 1000 concurrent clients.
+ *
+ * Copyright (c) 2013 TRUSTONIC LIMITED
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the TRUSTONIC LIMITED nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Server.h"
+
+/* Normally provided by MobiCoreDriverDaemon.cpp */
+pthread_mutex_t         syncMutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t          syncCondition = PTHREAD_COND_INITIALIZER;
+bool Th_sync = false;
+
+/** Odd commands are handed to the worker pool, even ones to the serial worker */
+#define IS_CONCURRENT(cmd)  ((cmd) & 1)
+
+//------------------------------------------------------------------------------
+class EchoHandler: public ConnectionHandler
+{
+public:
+    virtual bool handleConnection(Connection *connection)
+    {
+        uint32_t cmd;
+        if (connection->readData(&cmd, sizeof(cmd)) != sizeof(cmd)) {
+            return false;
+        }
+        cmd++;
+        return connection->writeData(&cmd, sizeof(cmd)) == sizeof(cmd);
+    }
+
+    virtual void dropConnection(Connection *connection)
+    {
+        (void) connection;
+    }
+
+    virtual bool isConcurrentCommand(Connection *connection)
+    {
+        uint32_t cmd;
+        if (connection->peekData(&cmd, sizeof(cmd)) != sizeof(cmd)) {
+            return false;
+        }
+        return IS_CONCURRENT(cmd);
+    }
+};
+
+static char serverAddr[32];
+
+//------------------------------------------------------------------------------
+/** One server per process, Server::run() never returns */
+class ServerEnvironment: public testing::Environment
+{
+public:
+    virtual void SetUp()
+    {
+        snprintf(serverAddr, sizeof(serverAddr), "#mcservertest.%d", getpid());
+        server = new Server(&handler, serverAddr);
+
+        pthread_mutex_lock(&syncMutex);
+        server->start("McDaemon.Server");
+        while (!Th_sync) {
+            pthread_cond_wait(&syncCondition, &syncMutex);
+        }
+        pthread_mutex_unlock(&syncMutex);
+    }
+
+private:
+    EchoHandler handler;
+    Server *server;
+};
+
+static testing::Environment *const serverEnv =
+    testing::AddGlobalTestEnvironment(new ServerEnvironment);
+
+//------------------------------------------------------------------------------
+static uint64_t nowUs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+struct LoadClient {
+    pthread_t thread;
+    uint32_t requests;
+    Connection *connection;
+    std::vector<uint64_t> latencyUs;
+    uint32_t errors;
+};
+
+static void *runLoadClient(void *arg)
+{
+    LoadClient *client = (LoadClient *) arg;
+
+    for (uint32_t i = 0; i < client->requests; i++) {
+        uint32_t cmd = i, reply = 0;
+        uint64_t start = nowUs();
+        if (client->connection->writeData(&cmd, sizeof(cmd)) != sizeof(cmd)
+                || client->connection->readData(&reply, sizeof(reply)) != sizeof(reply)
+                || reply != cmd + 1) {
+            client->errors++;
+            break;
+        }
+        client->latencyUs.push_back(nowUs() - start);
+    }
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+class ServerLoad: public testing::TestWithParam<int>
+{
+};
+
+/* All clients stay connected for the whole run. With 1000 clients the
+ * server side descriptors go past FD_SETSIZE, which select() could not
+ * watch. */
+TEST_P(ServerLoad, EchoesEveryRequest)
+{
+    const int numClients = GetParam();
+    const uint32_t requests = numClients >= 1000 ? 50 : 200;
+    std::vector<LoadClient> clients(numClients);
+
+    for (int i = 0; i < numClients; i++) {
+        clients[i].requests = requests;
+        clients[i].errors = 0;
+        clients[i].connection = new Connection();
+        ASSERT_TRUE(clients[i].connection->connect(serverAddr)) << "client " << i;
+        clients[i].latencyUs.reserve(requests);
+    }
+
+    uint64_t start = nowUs();
+    for (int i = 0; i < numClients; i++) {
+        ASSERT_EQ(0, pthread_create(&clients[i].thread, NULL, runLoadClient, &clients[i]));
+    }
+    std::vector<uint64_t> latencyUs;
+    uint32_t errors = 0;
+    for (int i = 0; i < numClients; i++) {
+        pthread_join(clients[i].thread, NULL);
+        errors += clients[i].errors;
+        latencyUs.insert(latencyUs.end(), clients[i].latencyUs.begin(),
+                         clients[i].latencyUs.end());
+        delete clients[i].connection;
+    }
+    uint64_t elapsedUs = nowUs() - start;
+
+    EXPECT_EQ(0u, errors);
+    ASSERT_EQ((size_t) numClients * requests, latencyUs.size());
+
+    std::sort(latencyUs.begin(), latencyUs.end());
+    printf("clients %4d: %7.0f ops/s p50 %6llu us p99 %6llu us\n", numClients,
+           latencyUs.size() * 1e6 / (elapsedUs ? elapsedUs : 1),
+           (unsigned long long) latencyUs[latencyUs.size() / 2],
+           (unsigned long long) latencyUs[latencyUs.size() * 99 / 100]);
+}
+
+INSTANTIATE_TEST_CASE_P(Clients, ServerLoad, testing::Values(10, 100, 1000));
+
+/* Concurrent and serial commands interleaved on one connection are answered
+ * in order, including several commands written in one go. */
+TEST(Server, AnswersPipelinedCommandsInOrder)
+{
+    Connection connection;
+    ASSERT_TRUE(connection.connect(serverAddr));
+
+    uint32_t cmds[16];
+    for (uint32_t i = 0; i < 16; i++) {
+        cmds[i] = 100 + i;
+    }
+    ASSERT_EQ(sizeof(cmds), connection.writeData(cmds, sizeof(cmds)));
+
+    for (uint32_t i = 0; i < 16; i++) {
+        uint32_t reply = 0;
+        ASSERT_EQ(sizeof(reply), connection.readData(&reply, sizeof(reply), 5000));
+        EXPECT_EQ(cmds[i] + 1, reply);
+    }
+}
+
+/* A client hanging up mid command must not take the server down */
+TEST(Server, SurvivesClientsHangingUp)
+{
+    for (int i = 0; i < 50; i++) {
+        Connection *connection = new Connection();
+        ASSERT_TRUE(connection->connect(serverAddr));
+        uint16_t partial = i;
+        connection->writeData(&partial, sizeof(partial));
+        delete connection;
+    }
+
+    Connection connection;
+    ASSERT_TRUE(connection.connect(serverAddr));
+    uint32_t cmd = 7, reply = 0;
+    ASSERT_EQ(sizeof(cmd), connection.writeData(&cmd, sizeof(cmd)));
+    ASSERT_EQ(sizeof(reply), connection.readData(&reply, sizeof(reply), 5000));
+    EXPECT_EQ(8u, reply);
+}
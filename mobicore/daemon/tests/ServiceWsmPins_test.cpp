@@ -0,0 +1,316 @@
+/**
+ * @file
+ *
+ * Host tests for the WSM pins of the daemon's service blobs.
+ * 
+ * Runs ServiceWsmPins on a TrustZoneDevice whose kernel module only counts
+ * L2 registrations, with system TAs in a scratch MC_REGISTRY_PATH. OpenCost
+ * prints the cost of an open of a pinned against an unpinned TA.
+ *
+ * Copyright (c) 2013 TRUSTONIC LIMITED
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the TRUSTONIC LIMITED nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "TrustZoneDevice.h"
+#include "ServiceWsmPins.h"
+#include "PrivateRegistry.h"
+#include "mcLoadFormat.h"
+
+#define TA_SIZE     65536
+
+static std::string registryDir;
+
+static double nowSec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+//------------------------------------------------------------------------------
+/** Kernel module that counts L2 registrations, each one costs about what the
+ * ioctl and the page pinning cost on a device */
+class CountingKMod: public CMcKMod
+{
+public:
+    int registrations;
+    int unregistrations;
+    int live;
+
+    CountingKMod() : registrations(0), unregistrations(0), live(0), nextHandle(1) {}
+
+    virtual mcResult_t registerWsmL2(addr_t buffer, uint32_t len, uint32_t pid,
+                                     uint32_t *pHandle, uint64_t *pPhysWsmL2)
+    {
+        (void) buffer;
+        (void) len;
+        (void) pid;
+        usleep(50);
+        registrations++;
+        live++;
+        *pHandle = nextHandle++;
+        *pPhysWsmL2 = 0x1000;
+        return MC_DRV_OK;
+    }
+
+    virtual mcResult_t unregisterWsmL2(uint32_t handle)
+    {
+        (void) handle;
+        usleep(20);
+        unregistrations++;
+        live--;
+        return MC_DRV_OK;
+    }
+
+private:
+    uint32_t nextHandle;
+};
+
+class TestDevice: public TrustZoneDevice
+{
+public:
+    explicit TestDevice(CountingKMod *kmod)
+    {
+        pMcKMod = kmod;
+    }
+};
+
+//------------------------------------------------------------------------------
+class WsmPins: public testing::Test
+{
+protected:
+    static void SetUpTestCase()
+    {
+        char dir[] = "/tmp/mcregistry.XXXXXX";
+        ASSERT_TRUE(mkdtemp(dir) != NULL);
+        registryDir = dir;
+        setenv("MC_REGISTRY_PATH", dir, 1);
+        setenv("MC_AUTH_TOKEN_PATH", dir, 1);
+    }
+
+    static void TearDownTestCase()
+    {
+        std::string cmd = "rm -rf " + registryDir;
+        if (system(cmd.c_str()) != 0) {
+            fprintf(stderr, "cannot remove %s\n", registryDir.c_str());
+        }
+    }
+
+    virtual void SetUp()
+    {
+        kmod = new CountingKMod();
+        device = new TestDevice(kmod);
+        pins = new ServiceWsmPins(device);
+    }
+
+    virtual void TearDown()
+    {
+        delete pins;
+        delete device;
+    }
+
+    CountingKMod *kmod;
+    TestDevice *device;
+    ServiceWsmPins *pins;
+
+    /** Installs a system TA, the first payload byte after the header is set
+     * to generation */
+    static void installTa(const mcUuid_t *uuid, uint8_t generation)
+    {
+        std::string name;
+        for (size_t i = 0; i < sizeof(uuid->value); i++) {
+            char byte[3];
+            snprintf(byte, sizeof(byte), "%02x", uuid->value[i]);
+            name += byte;
+        }
+        std::string path = registryDir + "/" + name + ".tabin";
+
+        std::vector<uint8_t> blob(TA_SIZE, 0);
+        mclfHeaderV2_t *header = (mclfHeaderV2_t *) &blob[0];
+        header->intro.magic = MC_SERVICE_HEADER_MAGIC_BE;
+        header->serviceType = SERVICE_TYPE_SYSTEM_TRUSTLET;
+        memcpy(&header->uuid, uuid, sizeof(*uuid));
+        blob[sizeof(mclfHeaderV2_t)] = generation;
+
+        // Replace the file, so the inode changes even within the mtime granularity
+        unlink(path.c_str());
+        FILE *file = fopen(path.c_str(), "wb");
+        ASSERT_TRUE(file != NULL) << path;
+        ASSERT_EQ(blob.size(), fwrite(&blob[0], 1, blob.size(), file));
+        fclose(file);
+    }
+
+    static mcUuid_t makeUuid(uint8_t id)
+    {
+        mcUuid_t uuid;
+        memset(&uuid, 0, sizeof(uuid));
+        uuid.value[0] = 0x5e;
+        uuid.value[15] = id;
+        return uuid;
+    }
+
+    /** Opens and closes the TA like an open session does, returns the time
+     * per open in us */
+    double openClose(const mcUuid_t *uuid, int opens)
+    {
+        double start = nowSec();
+        for (int i = 0; i < opens; i++) {
+            regObject_t *regObj = mcRegistryGetServiceBlob(uuid, true);
+            EXPECT_TRUE(regObj != NULL);
+            if (regObj == NULL) {
+                break;
+            }
+            CWsm_ptr pWsm = pins->registerService(regObj);
+            EXPECT_TRUE(pWsm != NULL);
+            if (pWsm != NULL) {
+                EXPECT_TRUE(pins->unregisterService(pWsm));
+            }
+            mcRegistryReleaseServiceBlob(regObj);
+        }
+        return (nowSec() - start) / opens * 1e6;
+    }
+};
+
+TEST_F(WsmPins, UnpinnedTaRegistersEveryOpen)
+{
+    mcUuid_t uuid = makeUuid(1);
+    installTa(&uuid, 0);
+
+    openClose(&uuid, 100);
+    EXPECT_EQ(100, kmod->registrations);
+    EXPECT_EQ(0, kmod->live);
+
+    wsmPinStats_t stats;
+    pins->getStats(&stats);
+    EXPECT_EQ(0u, stats.pinnedBlobs);
+    EXPECT_EQ(0u, stats.registrationsAvoided);
+}
+
+TEST_F(WsmPins, PinnedTaRegistersOnce)
+{
+    mcUuid_t uuid = makeUuid(2);
+    installTa(&uuid, 0);
+    pins->pinUuid(&uuid);
+    pins->pinUuid(&uuid);
+
+    openClose(&uuid, 100);
+    EXPECT_EQ(1, kmod->registrations);
+    EXPECT_EQ(1, kmod->live);
+
+    wsmPinStats_t stats;
+    pins->getStats(&stats);
+    EXPECT_EQ(1u, stats.pinnedBlobs);
+    EXPECT_EQ((uint64_t) TA_SIZE, stats.pinnedBytes);
+    EXPECT_EQ(1u, stats.registrations);
+    EXPECT_EQ(99u, stats.registrationsAvoided);
+}
+
+/* A new blob in the registry replaces the pin, the old WSM is unregistered */
+TEST_F(WsmPins, ChangedBlobRepins)
+{
+    mcUuid_t uuid = makeUuid(3);
+    installTa(&uuid, 0);
+    pins->pinUuid(&uuid);
+    openClose(&uuid, 10);
+    ASSERT_EQ(1, kmod->registrations);
+
+    installTa(&uuid, 1);
+    openClose(&uuid, 10);
+    EXPECT_EQ(2, kmod->registrations);
+    EXPECT_EQ(1, kmod->unregistrations);
+    EXPECT_EQ(1, kmod->live);
+
+    wsmPinStats_t stats;
+    pins->getStats(&stats);
+    EXPECT_EQ(1u, stats.pinnedBlobs);
+    EXPECT_EQ((uint64_t) TA_SIZE, stats.pinnedBytes);
+}
+
+TEST_F(WsmPins, DestructionUnpinsAll)
+{
+    for (uint8_t id = 4; id < 8; id++) {
+        mcUuid_t uuid = makeUuid(id);
+        installTa(&uuid, 0);
+        pins->pinUuid(&uuid);
+        openClose(&uuid, 2);
+    }
+    EXPECT_EQ(4, kmod->live);
+
+    delete pins;
+    pins = NULL;
+    EXPECT_EQ(0, kmod->live);
+    EXPECT_EQ(4, kmod->unregistrations);
+}
+
+/* A session still holding the pinned WSM keeps it, closing it is a no-op */
+TEST_F(WsmPins, OverlappingOpensShareThePin)
+{
+    mcUuid_t uuid = makeUuid(8);
+    installTa(&uuid, 0);
+    pins->pinUuid(&uuid);
+
+    regObject_t *first = mcRegistryGetServiceBlob(&uuid, true);
+    ASSERT_TRUE(first != NULL);
+    regObject_t *second = mcRegistryGetServiceBlob(&uuid, true);
+    ASSERT_TRUE(second != NULL);
+    CWsm_ptr firstWsm = pins->registerService(first);
+    CWsm_ptr secondWsm = pins->registerService(second);
+    EXPECT_EQ(firstWsm, secondWsm);
+    EXPECT_EQ(1, kmod->registrations);
+
+    EXPECT_TRUE(pins->unregisterService(firstWsm));
+    EXPECT_TRUE(pins->unregisterService(secondWsm));
+    EXPECT_EQ(1, kmod->live);
+    mcRegistryReleaseServiceBlob(second);
+    mcRegistryReleaseServiceBlob(first);
+}
+
+TEST_F(WsmPins, OpenCost)
+{
+    const int opens = 1000;
+    mcUuid_t cold = makeUuid(9);
+    mcUuid_t hot = makeUuid(10);
+    installTa(&cold, 0);
+    installTa(&hot, 0);
+    pins->pinUuid(&hot);
+
+    double unpinned = openClose(&cold, opens);
+    double pinned = openClose(&hot, opens);
+    EXPECT_EQ(opens + 1, kmod->registrations);
+    printf("%d byte TA: unpinned %6.1f us, pinned %6.1f us per open\n", TA_SIZE,
+           unpinned, pinned);
+}
@@ -0,0 +1,239 @@
+/**
+ * @file
+ *
+ * Host tests for the trustlet session table.
+ * 
+ * A random sequence of adds, removes, owner changes and lookups is run
+ * against the table and against a std::map reference, the connection index
+ * is checked against a per connection list kept in opening order.
+ *
+ * Copyright (c) 2013 TRUSTONIC LIMITED
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the TRUSTONIC LIMITED nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <map>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "TrustletSessionTable.h"
+
+#define FUZZ_CONNECTIONS    4
+
+typedef std::map<uint32_t, TrustletSession *> referenceTable_t;
+
+static double nowSec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Only compared, never dereferenced */
+static Connection *const fuzzConnections[FUZZ_CONNECTIONS] = {
+    (Connection *) 0x10, (Connection *) 0x20, (Connection *) 0x30, NULL
+};
+
+//------------------------------------------------------------------------------
+class TrustletSessionTableFuzz: public testing::Test
+{
+protected:
+    TrustletSessionTable table;
+    referenceTable_t reference;
+    /** Sessions of each connection in the order they were added to it */
+    trustletSessionList_t owned[FUZZ_CONNECTIONS];
+
+    virtual void TearDown()
+    {
+        for (referenceTable_t::iterator it = reference.begin(); it != reference.end(); ++it) {
+            table.remove(it->second);
+            delete it->second;
+        }
+    }
+
+    static int connectionIndex(Connection *connection)
+    {
+        for (int i = 0; i < FUZZ_CONNECTIONS; i++) {
+            if (fuzzConnections[i] == connection) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    void checkIndex()
+    {
+        size_t indexed = 0;
+        for (int c = 0; c < FUZZ_CONNECTIONS; c++) {
+            trustletSessionList_t sessions;
+            indexed += table.getSessions(fuzzConnections[c], sessions);
+            ASSERT_TRUE(sessions == owned[c]) << "connection " << c;
+        }
+        trustletSessionList_t all;
+        EXPECT_EQ(reference.size(), table.getSessions(all));
+        EXPECT_EQ(reference.size(), table.size());
+        EXPECT_EQ(reference.size(), indexed);
+    }
+
+    void run(uint32_t seed, uint32_t operations, uint32_t idRange)
+    {
+        srand(seed);
+        for (uint32_t i = 0; i < operations; i++) {
+            uint32_t id = rand() % idRange;
+            referenceTable_t::iterator it = reference.find(id);
+            TrustletSession *session = it == reference.end() ? NULL : it->second;
+
+            switch (rand() % 4) {
+            case 0:
+                if (session == NULL) {
+                    int c = rand() % FUZZ_CONNECTIONS;
+                    session = new TrustletSession(fuzzConnections[c], id);
+                    ASSERT_TRUE(table.add(session)) << "add " << id;
+                    reference[id] = session;
+                    owned[c].push_back(session);
+                } else {
+                    // Duplicate IDs are refused
+                    TrustletSession duplicate(NULL, id);
+                    ASSERT_FALSE(table.add(&duplicate)) << "add duplicate " << id;
+                }
+                break;
+            case 1:
+                if (session != NULL) {
+                    ASSERT_TRUE(table.remove(session)) << "remove " << id;
+                    owned[connectionIndex(session->deviceConnection)].remove(session);
+                    reference.erase(it);
+                    delete session;
+                } else {
+                    TrustletSession missing(NULL, id);
+                    ASSERT_FALSE(table.remove(&missing)) << "remove missing " << id;
+                }
+                break;
+            case 2:
+                if (session != NULL) {
+                    int c = rand() % FUZZ_CONNECTIONS;
+                    owned[connectionIndex(session->deviceConnection)].remove(session);
+                    table.setDeviceConnection(session, fuzzConnections[c]);
+                    ASSERT_EQ(fuzzConnections[c], session->deviceConnection);
+                    owned[c].push_back(session);
+                }
+                break;
+            default:
+                ASSERT_EQ(session, table.find(id)) << "find " << id;
+                break;
+            }
+
+            if (i % 10000 == 0) {
+                checkIndex();
+            }
+        }
+        checkIndex();
+    }
+};
+
+/* Few IDs, the table stays small and sees many tombstones */
+TEST_F(TrustletSessionTableFuzz, DenseIds)
+{
+    run(1, 500000, 64);
+}
+
+/* Enough IDs for the table to grow and shrink */
+TEST_F(TrustletSessionTableFuzz, SparseIds)
+{
+    run(2, 1000000, 3000);
+}
+
+/* Session IDs are assigned by <t-base and may use all 32 bits */
+TEST_F(TrustletSessionTableFuzz, WideIds)
+{
+    srand(3);
+    for (int i = 0; i < 2000; i++) {
+        uint32_t id = ((uint32_t) rand() << 16) ^ (uint32_t) rand();
+        if (reference.count(id) == 0) {
+            TrustletSession *session = new TrustletSession(fuzzConnections[0], id);
+            ASSERT_TRUE(table.add(session));
+            reference[id] = session;
+            owned[0].push_back(session);
+        }
+    }
+    for (referenceTable_t::iterator it = reference.begin(); it != reference.end(); ++it) {
+        ASSERT_EQ(it->second, table.find(it->first));
+    }
+    checkIndex();
+}
+
+//------------------------------------------------------------------------------
+/* Notification lookup by session ID, against the list walk the table
+ * replaced */
+TEST(TrustletSessionTable, LookupCost)
+{
+    const uint32_t sizes[] = {10, 100, 1000};
+    const uint32_t lookups = 1000000;
+
+    for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        TrustletSessionTable table;
+        trustletSessionList_t list;
+
+        for (uint32_t id = 1; id <= sizes[k]; id++) {
+            TrustletSession *session =
+                new TrustletSession((Connection *)(uintptr_t)(0x100 + id % 8), id);
+            ASSERT_TRUE(table.add(session));
+            list.push_back(session);
+        }
+
+        uintptr_t sum = 0;
+        double start = nowSec();
+        for (uint32_t i = 0; i < lookups; i++) {
+            uint32_t id = (i * 7919u) % sizes[k] + 1;
+            for (trustletSessionIterator_t it = list.begin(); it != list.end(); ++it) {
+                if ((*it)->sessionId == id) {
+                    sum += (uintptr_t) *it;
+                    break;
+                }
+            }
+        }
+        double listTime = nowSec() - start;
+
+        start = nowSec();
+        for (uint32_t i = 0; i < lookups; i++) {
+            sum -= (uintptr_t) table.find((i * 7919u) % sizes[k] + 1);
+        }
+        double tableTime = nowSec() - start;
+
+        EXPECT_EQ(0u, sum);
+        printf("%4u sessions: list %6.1f ns, table %6.1f ns per lookup\n", sizes[k],
+               listTime / lookups * 1e9, tableTime / lookups * 1e9);
+
+        for (trustletSessionIterator_t it = list.begin(); it != list.end(); ++it) {
+            table.remove(*it);
+            delete *it;
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#!/bin/bash
+#
+# Run mcdaemon_bench against mcDriverDaemon_sim in a scratch simulator
+# directory. Arguments are passed on to mcdaemon_bench, the exit status is
+# the one of the benchmark. The daemon gets the environment of the caller,
+# e.g. MC_SIM_MCP_LATENCY_US or MC_SIM_TA_LATENCY_US.
+#
+#   $ make mcdaemon_bench
+#   $ MC_SIM_MCP_LATENCY_US=2000 hardware/.../mobicore/daemon/tests/run_sim_bench.sh contention
+#   $ hardware/.../mobicore/daemon/tests/run_sim_bench.sh -n 20
+#
+# The last line runs every benchmark briefly as a check, e.g. in CI.
+# MC_BENCH_BIN overrides the directory holding both binaries.
+
+BIN_DIR=${MC_BENCH_BIN:-${ANDROID_HOST_OUT:-out/host/linux-x86}/bin}
+DAEMON=$BIN_DIR/mcDriverDaemon_sim
+BENCH=$BIN_DIR/mcdaemon_bench
+
+for bin in $DAEMON $BENCH; do
+	if [ ! -x $bin ]; then
+		echo "Error: $bin not found, build mcdaemon_bench first" >&2
+		exit 1
+	fi
+done
+
+export MC_SIM_DIR=$(mktemp -d /tmp/mcsim.XXXXXX)
+export MC_REGISTRY_PATH=$MC_SIM_DIR/registry
+export MC_AUTH_TOKEN_PATH=$MC_REGISTRY_PATH
+mkdir -p $MC_REGISTRY_PATH
+
+$DAEMON > $MC_SIM_DIR/daemon.log 2>&1 &
+DAEMON_PID=$!
+trap 'kill -9 $DAEMON_PID 2>/dev/null; wait $DAEMON_PID 2>/dev/null; rm -rf $MC_SIM_DIR' EXIT
+
+# The daemon listens on the abstract socket @mcdaemon once it is up
+for i in $(seq 50); do
+	grep -q '@mcdaemon$' /proc/net/unix && break
+	if ! kill -0 $DAEMON_PID 2>/dev/null; then
+		echo "Error: daemon exited, log follows" >&2
+		cat $MC_SIM_DIR/daemon.log >&2
+		exit 1
+	fi
+	sleep 0.1
+done
+
+$BENCH "$@"
+RESULT=$?
+if [ $RESULT -ne 0 ]; then
+	echo "Error: benchmark failed, daemon log follows" >&2
+	tail -50 $MC_SIM_DIR/daemon.log >&2
+fi
+exit $RESULT